@@ -0,0 +1,147 @@
+/**
+ * AsyncTCP for the host build, over non-blocking POSIX sockets.
+ *
+ * One "async_tcp" thread polls every socket and runs the callbacks, as the
+ * AsyncTCP task does on the ESP32. Calls from other threads take the same
+ * lock the callbacks run under (lwIP's core lock, in effect), so a
+ * callback never races the loop() task.
+ *
+ * Flow control follows lwIP: space() is what is left of a TCP_SND_BUF
+ * sized send buffer, onAck() reports bytes the kernel took, and data
+ * delivered to a callback that called ackLater() counts against a
+ * TCP_WND sized receive window until ack() gives it back.
+ */
+
+#pragma once
+
+#include <functional>
+#include <mutex>
+#include <string>
+
+#include "Arduino.h"
+
+#define ASYNC_WRITE_FLAG_COPY 0x01   // Always the case here: add() copies
+
+#ifndef HOST_TCP_SND_BUF
+#define HOST_TCP_SND_BUF 5744
+#endif
+#ifndef HOST_TCP_WND
+#define HOST_TCP_WND 5744
+#endif
+
+class AsyncClient;
+
+typedef std::function<void(void*, AsyncClient*)> AcConnectHandler;
+typedef std::function<void(void*, AsyncClient*, size_t len, uint32_t time)> AcAckHandler;
+typedef std::function<void(void*, AsyncClient*, int8_t error)> AcErrorHandler;
+typedef std::function<void(void*, AsyncClient*, void* data, size_t len)> AcDataHandler;
+typedef std::function<void(void*, AsyncClient*, uint32_t time)> AcTimeoutHandler;
+
+// Held by the async_tcp thread while it runs callbacks
+std::recursive_mutex& asyncTcpLock();
+
+class AsyncClient {
+public:
+    AsyncClient();
+    ~AsyncClient();
+
+    bool connect(IPAddress ip, uint16_t port);
+    bool connect(const char* host, uint16_t port);
+    void close(bool now = false);
+    void abort() { close(true); }
+
+    bool connecting();
+    bool connected();
+    bool disconnected();
+    bool freeable() { return disconnected(); }
+
+    size_t space();
+    size_t add(const char* data, size_t size, uint8_t apiflags = ASYNC_WRITE_FLAG_COPY);
+    bool send();
+    size_t write(const char* data, size_t size);
+    size_t write(const char* data) { return write(data, strlen(data)); }
+    bool canSend() { return space() > 0; }
+
+    void ackLater() { _ackLater = true; }
+    size_t ack(size_t len);
+
+    void setRxTimeout(uint32_t seconds) { _rxTimeout = seconds; }
+    void setNoDelay(bool) {}
+
+    IPAddress remoteIP();
+    uint16_t remotePort() { return _remotePort; }
+
+    void onConnect(AcConnectHandler cb, void* arg = nullptr);
+    void onDisconnect(AcConnectHandler cb, void* arg = nullptr);
+    void onAck(AcAckHandler cb, void* arg = nullptr);
+    void onError(AcErrorHandler cb, void* arg = nullptr);
+    void onData(AcDataHandler cb, void* arg = nullptr);
+    void onTimeout(AcTimeoutHandler cb, void* arg = nullptr);
+    void onPoll(AcConnectHandler cb, void* arg = nullptr);
+
+private:
+    friend class AsyncServer;
+    friend struct AsyncTcpLoop;
+
+    enum Phase { IDLE, CONNECTING, CONNECTED };
+
+    explicit AsyncClient(int fd);
+    void attach(int fd, Phase phase);
+    void drop(bool notify);
+    void fail(int8_t error);
+
+    // From the async_tcp thread
+    bool wantsRead() const;
+    bool wantsWrite() const;
+    void handleReadable();
+    void handleWritable();
+    void handlePoll(uint32_t now);
+
+    uint64_t _serial;      // Tells a deleted client from a new one at its address
+    int _fd;
+    Phase _phase;
+    bool _closing;         // close() once _tx is out
+    std::string _tx;       // Added, not yet taken by the kernel
+    size_t _rxUnacked;     // Delivered with ackLater(), not yet ack()ed
+    bool _ackLater;
+    uint32_t _rxTimeout;
+    uint32_t _lastRx;
+    uint32_t _remoteAddr;
+    uint16_t _remotePort;
+
+    AcConnectHandler _connectCb, _disconnectCb, _pollCb;
+    AcAckHandler _ackCb;
+    AcErrorHandler _errorCb;
+    AcDataHandler _dataCb;
+    AcTimeoutHandler _timeoutCb;
+    void *_connectArg, *_disconnectArg, *_pollArg, *_ackArg, *_errorArg, *_dataArg, *_timeoutArg;
+};
+
+typedef std::function<void(void*, AsyncClient*)> AcClientHandler;
+
+class AsyncServer {
+public:
+    explicit AsyncServer(uint16_t port);
+    AsyncServer(IPAddress addr, uint16_t port);
+    ~AsyncServer();
+
+    void onClient(AcClientHandler cb, void* arg) {
+        _clientCb = cb;
+        _clientArg = arg;
+    }
+    void begin();
+    void end();
+    void setNoDelay(bool) {}
+    uint8_t status() { return _fd >= 0; }
+
+private:
+    friend struct AsyncTcpLoop;
+
+    void handleAccept();
+
+    uint32_t _addr;
+    uint16_t _port;
+    int _fd;
+    AcClientHandler _clientCb;
+    void* _clientArg;
+};
@@ -0,0 +1,43 @@
+/**
+ * mDNS for the host build: nothing is announced and queries find no one,
+ * so discovery falls through to the registry probe and the saved URL.
+ */
+
+#pragma once
+
+#include "Arduino.h"
+
+class HostMDNS {
+public:
+    bool begin(const char* hostName) {
+        (void)hostName;
+        return true;
+    }
+    void end() {}
+    bool addService(const char* service, const char* proto, uint16_t port) {
+        (void)service, (void)proto, (void)port;
+        return true;
+    }
+    bool addServiceTxt(const char* service, const char* proto, const char* key, const char* value) {
+        (void)service, (void)proto, (void)key, (void)value;
+        return true;
+    }
+    int queryService(const char* service, const char* proto) {
+        (void)service, (void)proto;
+        return 0;
+    }
+    String hostname(int i) const {
+        (void)i;
+        return String();
+    }
+    IPAddress IP(int i) const {
+        (void)i;
+        return IPAddress();
+    }
+    uint16_t port(int i) const {
+        (void)i;
+        return 0;
+    }
+};
+
+extern HostMDNS MDNS;
@@ -0,0 +1,56 @@
+/**
+ * HTTPClient for the host build: blocking HTTP/1.1 over a plain socket,
+ * one request per connection, as the firmware uses it for peer agents.
+ * https:// has no TLS to run on and fails to connect.
+ */
+
+#pragma once
+
+#include <string>
+
+#include "Arduino.h"
+#include "WiFi.h"
+
+#define HTTPC_ERROR_CONNECTION_REFUSED (-1)
+#define HTTPC_ERROR_SEND_HEADER_FAILED (-2)
+#define HTTPC_ERROR_SEND_PAYLOAD_FAILED (-3)
+#define HTTPC_ERROR_NOT_CONNECTED (-4)
+#define HTTPC_ERROR_CONNECTION_LOST (-5)
+#define HTTPC_ERROR_NO_HTTP_SERVER (-7)
+#define HTTPC_ERROR_READ_TIMEOUT (-11)
+
+#define HTTP_CODE_OK 200
+
+class HTTPClient {
+public:
+    HTTPClient() : _port(80), _timeout(5000), _secure(false) {}
+
+    bool begin(const String& url);
+    bool begin(WiFiClient& client, const String& url) {
+        (void)client;
+        return begin(url);
+    }
+    void end();
+
+    void setTimeout(uint16_t timeout) { _timeout = timeout; }
+    void addHeader(const String& name, const String& value);
+
+    int GET();
+    int POST(const String& payload) { return POST((const uint8_t*)payload.c_str(), payload.length()); }
+    int POST(const uint8_t* payload, size_t size);
+    int sendRequest(const char* method, const uint8_t* payload, size_t size);
+
+    String getString() const { return String(_body); }
+    int getSize() const { return (int)_body.size(); }
+
+    static String errorToString(int error);
+
+private:
+    std::string _host;
+    uint16_t _port;
+    std::string _path;
+    std::string _headers;
+    uint16_t _timeout;
+    bool _secure;
+    std::string _body;
+};
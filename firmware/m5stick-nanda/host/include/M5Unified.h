@@ -0,0 +1,98 @@
+/**
+ * M5Unified for the host build: a StickC Plus2 with nobody holding it.
+ *
+ * The display is an off-screen 135x240 RGB565 sprite (rotated like the
+ * panel), so screens and screenshots work without a window. The IMU reads
+ * gravity on Z with a slow wobble and some noise, the battery sits at
+ * 3.9 V, the buttons are never pressed and the speaker is silent.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+
+#include "Arduino.h"
+
+namespace m5 {
+
+struct imu_3d_t {
+    float x, y, z;
+};
+
+struct imu_data_t {
+    uint32_t usec;
+    imu_3d_t accel;
+    imu_3d_t gyro;
+    imu_3d_t mag;
+};
+
+// Without ARDUINO, LovyanGFX has no String overloads; these are the ones the firmware uses
+class HostDisplay : public LGFX_Sprite {
+public:
+    void begin();
+
+    using LGFX_Sprite::drawString;
+    using LGFX_Sprite::print;
+    using LGFX_Sprite::println;
+    using LGFX_Sprite::textWidth;
+    size_t print(const String& s) { return print(s.c_str()); }
+    size_t println(const String& s) { return println(s.c_str()); }
+    int32_t textWidth(const String& s) { return textWidth(s.c_str()); }
+    size_t drawString(const String& s, int32_t x, int32_t y) { return drawString(s.c_str(), x, y); }
+};
+
+class HostImu {
+public:
+    bool update();
+    bool getImuData(imu_data_t* data) const;
+    bool getTemp(float* t) const;
+
+private:
+    imu_data_t _data = {};
+};
+
+class HostPower {
+public:
+    int16_t getBatteryVoltage() const { return 3900; }
+    int32_t getBatteryLevel() const { return 80; }
+    bool isCharging() const { return false; }
+};
+
+class HostButton {
+public:
+    bool isPressed() const { return false; }
+    bool wasPressed() const { return false; }
+    bool wasReleased() const { return false; }
+};
+
+class HostSpeaker {
+public:
+    bool tone(float frequency, uint32_t durationMs) {
+        (void)frequency, (void)durationMs;
+        return true;
+    }
+    void setVolume(uint8_t volume) { (void)volume; }
+};
+
+struct config_t {
+    bool serial_baudrate = true;
+};
+
+class M5Unified {
+public:
+    config_t config() const { return config_t(); }
+    void begin(const config_t& cfg = config_t());
+    void update() {}
+
+    HostDisplay Display;
+    HostImu Imu;
+    HostPower Power;
+    HostButton BtnA;
+    HostButton BtnB;
+    HostButton BtnPWR;
+    HostSpeaker Speaker;
+};
+
+}  // namespace m5
+
+extern m5::M5Unified M5;
@@ -0,0 +1,42 @@
+/**
+ * Preferences for the host build, kept in memory for the run.
+ *
+ * A key nobody has written reads from the environment first:
+ * NANDA_PREF_registry=http://127.0.0.1:3000 gives the firmware a saved
+ * registry URL without a flash to save it in.
+ */
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "Arduino.h"
+
+class Preferences {
+public:
+    bool begin(const char* name, bool readOnly = false) {
+        (void)name, (void)readOnly;
+        return true;
+    }
+    void end() {}
+    bool clear() {
+        _values.clear();
+        return true;
+    }
+    bool remove(const char* key) { return _values.erase(key) > 0; }
+    bool isKey(const char* key) const;
+
+    String getString(const char* key, const String& defaultValue = String()) const;
+    size_t putString(const char* key, const String& value);
+    int32_t getInt(const char* key, int32_t defaultValue = 0) const;
+    size_t putInt(const char* key, int32_t value);
+    bool getBool(const char* key, bool defaultValue = false) const;
+    size_t putBool(const char* key, bool value);
+
+private:
+    const std::string* find(const char* key) const;
+
+    std::map<std::string, std::string> _values;
+    mutable std::string _fromEnv;
+};
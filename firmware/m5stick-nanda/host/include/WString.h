@@ -0,0 +1,145 @@
+/**
+ * Arduino's String for the host build, over std::string.
+ *
+ * Only what the firmware and its libraries use; behaviour follows the
+ * ESP32 core (indexOf() returns -1, substring() clamps, toInt() stops at
+ * the first non-digit).
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+class String {
+public:
+    String() {}
+    String(const char* s) : _s(s ? s : "") {}
+    String(const char* s, size_t len) : _s(s ? s : "", s ? len : 0) {}
+    String(const std::string& s) : _s(s) {}
+    explicit String(char c) : _s(1, c) {}
+    explicit String(int value, unsigned char base = 10);
+    explicit String(unsigned int value, unsigned char base = 10);
+    explicit String(long value, unsigned char base = 10);
+    explicit String(unsigned long value, unsigned char base = 10);
+    explicit String(long long value, unsigned char base = 10);
+    explicit String(unsigned long long value, unsigned char base = 10);
+    explicit String(float value, unsigned int decimals = 2);
+    explicit String(double value, unsigned int decimals = 2);
+
+    String& operator=(const char* s) {
+        _s = s ? s : "";
+        return *this;
+    }
+
+    const char* c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); }
+    bool isEmpty() const { return _s.empty(); }
+    bool reserve(unsigned int size) {
+        _s.reserve(size);
+        return true;
+    }
+
+    bool concat(const String& s) {
+        _s += s._s;
+        return true;
+    }
+    bool concat(const char* s) {
+        if (!s) return false;
+        _s += s;
+        return true;
+    }
+    bool concat(const char* s, unsigned int len) {
+        if (!s) return false;
+        _s.append(s, len);
+        return true;
+    }
+    bool concat(char c) {
+        _s += c;
+        return true;
+    }
+    template <typename T>
+    bool concat(T value) {
+        return concat(String(value));
+    }
+
+    template <typename T>
+    String& operator+=(const T& value) {
+        concat(value);
+        return *this;
+    }
+
+    char charAt(unsigned int index) const { return index < _s.size() ? _s[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char& operator[](unsigned int index) { return _s[index]; }
+
+    bool equals(const String& s) const { return _s == s._s; }
+    bool equals(const char* s) const { return _s == (s ? s : ""); }
+    bool equalsIgnoreCase(const String& s) const;
+    bool startsWith(const String& prefix) const { return _s.compare(0, prefix._s.size(), prefix._s) == 0; }
+    bool endsWith(const String& suffix) const;
+    int compareTo(const String& s) const { return _s.compare(s._s); }
+
+    int indexOf(char c, unsigned int from = 0) const { return found(_s.find(c, from)); }
+    int indexOf(const String& s, unsigned int from = 0) const { return found(_s.find(s._s, from)); }
+    int lastIndexOf(char c) const { return found(_s.rfind(c)); }
+    int lastIndexOf(const String& s) const { return found(_s.rfind(s._s)); }
+
+    String substring(unsigned int from) const { return substring(from, _s.size()); }
+    String substring(unsigned int from, unsigned int to) const;
+
+    void replace(const String& find, const String& with);
+    void replace(char find, char with);
+    void remove(unsigned int index) { remove(index, _s.size()); }
+    void remove(unsigned int index, unsigned int count);
+    void toLowerCase();
+    void toUpperCase();
+    void trim();
+
+    long toInt() const;
+    float toFloat() const;
+    double toDouble() const;
+
+    const std::string& str() const { return _s; }
+
+private:
+    static int found(size_t pos) { return pos == std::string::npos ? -1 : (int)pos; }
+
+    std::string _s;
+};
+
+inline bool operator==(const String& a, const String& b) { return a.equals(b); }
+inline bool operator==(const String& a, const char* b) { return a.equals(b); }
+inline bool operator==(const char* a, const String& b) { return b.equals(a); }
+inline bool operator!=(const String& a, const String& b) { return !a.equals(b); }
+inline bool operator!=(const String& a, const char* b) { return !a.equals(b); }
+inline bool operator!=(const char* a, const String& b) { return !b.equals(a); }
+inline bool operator<(const String& a, const String& b) { return a.compareTo(b) < 0; }
+
+inline String operator+(const String& a, const String& b) {
+    String s(a);
+    s.concat(b);
+    return s;
+}
+inline String operator+(const String& a, const char* b) {
+    String s(a);
+    s.concat(b);
+    return s;
+}
+inline String operator+(const char* a, const String& b) {
+    String s(a);
+    s.concat(b);
+    return s;
+}
+inline String operator+(const String& a, char c) {
+    String s(a);
+    s.concat(c);
+    return s;
+}
+template <typename T>
+inline String operator+(const String& a, T value) {
+    String s(a);
+    s.concat(String(value));
+    return s;
+}
@@ -0,0 +1,97 @@
+/**
+ * Links2004's WebSocketsClient for the host build (ws:// only).
+ *
+ * Like the library, everything happens inside loop(): connecting,
+ * reading, answering pings, the heartbeat and reconnecting. The socket is
+ * non-blocking, so a connect or a slow peer never holds loop() up; frames
+ * the socket cannot take yet wait and go out on the next loop().
+ *
+ * With headerToPayload the frame header is written into the
+ * WEBSOCKETS_MAX_HEADER_SIZE bytes in front of the payload, which is where
+ * the firmware leaves room for it.
+ */
+
+#pragma once
+
+#include <functional>
+#include <string>
+
+#include "Arduino.h"
+
+#define WEBSOCKETS_MAX_HEADER_SIZE (14)
+
+typedef enum {
+    WStype_ERROR,
+    WStype_DISCONNECTED,
+    WStype_CONNECTED,
+    WStype_TEXT,
+    WStype_BIN,
+    WStype_FRAGMENT_TEXT_START,
+    WStype_FRAGMENT_BIN_START,
+    WStype_FRAGMENT,
+    WStype_FRAGMENT_FIN,
+    WStype_PING,
+    WStype_PONG,
+} WStype_t;
+
+class WebSocketsClient {
+public:
+    typedef std::function<void(WStype_t type, uint8_t* payload, size_t length)> WebSocketClientEvent;
+
+    WebSocketsClient();
+    ~WebSocketsClient();
+
+    void begin(const char* host, uint16_t port, const char* url = "/", const char* protocol = "arduino");
+    void begin(const String& host, uint16_t port, const String& url = "/", const String& protocol = "arduino") {
+        begin(host.c_str(), port, url.c_str(), protocol.c_str());
+    }
+    void loop();
+    void disconnect();
+    bool isConnected() const { return _phase == OPEN; }
+
+    void onEvent(WebSocketClientEvent cbEvent) { _event = cbEvent; }
+    void setReconnectInterval(unsigned long time) { _reconnectInterval = time; }
+    void enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount);
+    void disableHeartbeat() { _pingInterval = 0; }
+
+    bool sendTXT(uint8_t* payload, size_t length = 0, bool headerToPayload = false);
+    bool sendTXT(const char* payload) { return sendTXT((uint8_t*)payload, strlen(payload)); }
+    bool sendTXT(const String& payload) { return sendTXT((uint8_t*)payload.c_str(), payload.length()); }
+    bool sendBIN(uint8_t* payload, size_t length, bool headerToPayload = false);
+    bool sendPing(uint8_t* payload = nullptr, size_t length = 0);
+
+private:
+    enum Phase { IDLE, CONNECTING, HANDSHAKE, OPEN };
+
+    void startConnect();
+    void drop(bool notify);
+    bool sendFrame(uint8_t opcode, const uint8_t* payload, size_t length);
+    void flush();
+    bool readHandshake();
+    bool readFrame();
+    void heartbeat(uint32_t now);
+    void emit(WStype_t type, uint8_t* payload, size_t length);
+
+    std::string _host;
+    uint16_t _port;
+    std::string _url;
+    std::string _protocol;
+    std::string _key;
+
+    int _fd;
+    Phase _phase;
+    std::string _tx;
+    std::string _rx;
+    std::string _message;   // Fragments of a message not yet complete
+    uint8_t _messageOpcode;
+
+    WebSocketClientEvent _event;
+    unsigned long _reconnectInterval;
+    uint32_t _lastAttempt;
+    uint32_t _pingInterval;
+    uint32_t _pongTimeout;
+    uint8_t _disconnectCount;
+    uint32_t _lastPing;
+    bool _pongPending;
+    uint8_t _missedPongs;
+};
@@ -0,0 +1,75 @@
+/**
+ * WiFi for the host build: already connected, on the loopback interface.
+ *
+ * The station's address and the gateway are both 127.0.0.1, so the
+ * registry auto-detection probes this machine. The MAC, and so the device
+ * id, is fixed; NANDA_HOST_MAC (six hex bytes, "a1:b2:c3:d4:e5:f6") picks
+ * another one for a second instance.
+ */
+
+#pragma once
+
+#include <functional>
+
+#include "Arduino.h"
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } wifi_mode_t;
+typedef enum { WL_IDLE_STATUS = 0, WL_NO_SSID_AVAIL = 1, WL_CONNECTED = 3, WL_CONNECT_FAILED = 4,
+               WL_DISCONNECTED = 6 } wl_status_t;
+
+typedef enum {
+    ARDUINO_EVENT_WIFI_STA_CONNECTED = 4,
+    ARDUINO_EVENT_WIFI_STA_DISCONNECTED = 5,
+    ARDUINO_EVENT_WIFI_STA_GOT_IP = 7,
+    ARDUINO_EVENT_WIFI_STA_LOST_IP = 8,
+} arduino_event_id_t;
+
+typedef arduino_event_id_t WiFiEvent_t;
+typedef struct {
+    uint32_t unused;
+} WiFiEventInfo_t;
+typedef std::function<void(WiFiEvent_t event, WiFiEventInfo_t info)> WiFiEventFuncCb;
+
+class HostWiFi {
+public:
+    bool mode(wifi_mode_t m) {
+        _mode = m;
+        return true;
+    }
+    wl_status_t begin(const char* ssid, const char* passphrase = nullptr);
+    wl_status_t status() const { return _status; }
+    bool disconnect() {
+        _status = WL_DISCONNECTED;
+        return true;
+    }
+
+    IPAddress localIP() const { return IPAddress(127, 0, 0, 1); }
+    IPAddress gatewayIP() const { return IPAddress(127, 0, 0, 1); }
+    uint8_t* macAddress(uint8_t* mac) const;
+    String macAddress() const;
+    String SSID() const { return _ssid; }
+    int8_t RSSI() const { return -50; }
+
+    int16_t scanNetworks();
+    String SSID(uint8_t i) const;
+    int32_t RSSI(uint8_t i) const;
+    int32_t channel(uint8_t i) const;
+
+    // Nothing changes the address here, so callbacks never run
+    int onEvent(WiFiEventFuncCb cb, WiFiEvent_t event) {
+        (void)cb, (void)event;
+        return 0;
+    }
+
+private:
+    wifi_mode_t _mode = WIFI_OFF;
+    wl_status_t _status = WL_DISCONNECTED;
+    String _ssid;
+};
+
+extern HostWiFi WiFi;
+
+class WiFiClient {
+public:
+    virtual ~WiFiClient() {}
+};
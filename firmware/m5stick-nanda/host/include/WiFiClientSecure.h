@@ -0,0 +1,32 @@
+/**
+ * WiFiClientSecure for the host build. There is no TLS here: HTTPClient
+ * fails https:// URLs with HTTPC_ERROR_CONNECTION_REFUSED, and connect()
+ * fails, as the device does when it cannot reach the server.
+ */
+
+#pragma once
+
+#include "WiFi.h"
+
+class WiFiClientSecure : public WiFiClient {
+public:
+    void setInsecure() {}
+    void setCACert(const char* cert) { (void)cert; }
+    void setHandshakeTimeout(unsigned long seconds) { (void)seconds; }
+
+    int connect(const char* host, uint16_t port, int32_t timeout) {
+        (void)host, (void)port, (void)timeout;
+        return 0;
+    }
+    int available() { return 0; }
+    int read(uint8_t* buf, size_t size) {
+        (void)buf, (void)size;
+        return -1;
+    }
+    size_t write(const uint8_t* buf, size_t size) {
+        (void)buf, (void)size;
+        return 0;
+    }
+    uint8_t connected() { return 0; }
+    void stop() {}
+};
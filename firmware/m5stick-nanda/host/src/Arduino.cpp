@@ -0,0 +1,278 @@
+#include <Arduino.h>
+
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <random>
+#include <thread>
+
+// ============================================================================
+// String
+// ============================================================================
+
+static std::string formatInteger(unsigned long long value, bool negative, unsigned char base) {
+    if (base < 2 || base > 36) base = 10;
+    char digits[66];
+    int n = 0;
+    do {
+        int d = value % base;
+        digits[n++] = d < 10 ? '0' + d : 'a' + d - 10;
+        value /= base;
+    } while (value);
+    std::string s;
+    if (negative) s += '-';
+    while (n) s += digits[--n];
+    return s;
+}
+
+static unsigned long long magnitude(long long value) {
+    return value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+}
+
+// Negative values only print with a sign in base 10, as on the ESP32
+String::String(int value, unsigned char base)
+    : _s(base == 10 ? formatInteger(magnitude(value), value < 0, 10) : formatInteger((unsigned int)value, false, base)) {}
+String::String(unsigned int value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long value, unsigned char base)
+    : _s(base == 10 ? formatInteger(magnitude(value), value < 0, 10) : formatInteger((unsigned long)value, false, base)) {}
+String::String(unsigned long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+String::String(long long value, unsigned char base)
+    : _s(base == 10 ? formatInteger(magnitude(value), value < 0, 10)
+                    : formatInteger((unsigned long long)value, false, base)) {}
+String::String(unsigned long long value, unsigned char base) : _s(formatInteger(value, false, base)) {}
+
+String::String(float value, unsigned int decimals) : String((double)value, decimals) {}
+
+String::String(double value, unsigned int decimals) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+    _s = buf;
+}
+
+bool String::equalsIgnoreCase(const String& s) const {
+    return _s.size() == s._s.size() && strncasecmp(_s.c_str(), s._s.c_str(), _s.size()) == 0;
+}
+
+bool String::endsWith(const String& suffix) const {
+    return _s.size() >= suffix._s.size() && _s.compare(_s.size() - suffix._s.size(), suffix._s.size(), suffix._s) == 0;
+}
+
+String String::substring(unsigned int from, unsigned int to) const {
+    if (from > to) std::swap(from, to);
+    if (from >= _s.size()) return String();
+    if (to > _s.size()) to = _s.size();
+    return String(_s.substr(from, to - from));
+}
+
+void String::replace(const String& find, const String& with) {
+    if (find._s.empty()) return;
+    size_t pos = 0;
+    while ((pos = _s.find(find._s, pos)) != std::string::npos) {
+        _s.replace(pos, find._s.size(), with._s);
+        pos += with._s.size();
+    }
+}
+
+void String::replace(char find, char with) {
+    for (char& c : _s) {
+        if (c == find) c = with;
+    }
+}
+
+void String::remove(unsigned int index, unsigned int count) {
+    if (index >= _s.size()) return;
+    _s.erase(index, count);
+}
+
+void String::toLowerCase() {
+    for (char& c : _s) c = tolower((unsigned char)c);
+}
+
+void String::toUpperCase() {
+    for (char& c : _s) c = toupper((unsigned char)c);
+}
+
+void String::trim() {
+    size_t begin = 0;
+    size_t end = _s.size();
+    while (begin < end && isspace((unsigned char)_s[begin])) begin++;
+    while (end > begin && isspace((unsigned char)_s[end - 1])) end--;
+    _s = _s.substr(begin, end - begin);
+}
+
+long String::toInt() const {
+    return atol(_s.c_str());
+}
+
+float String::toFloat() const {
+    return (float)atof(_s.c_str());
+}
+
+double String::toDouble() const {
+    return atof(_s.c_str());
+}
+
+// ============================================================================
+// Print, Serial, IPAddress
+// ============================================================================
+
+size_t Print::printf(const char* format, ...) {
+    char small[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(small, sizeof(small), format, args);
+    va_end(args);
+    if (len < 0) return 0;
+    if ((size_t)len < sizeof(small)) return write((const uint8_t*)small, len);
+
+    std::string large(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), len);
+}
+
+HardwareSerial Serial;
+
+size_t HardwareSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t* data, size_t len) {
+    // Tasks print too; one fwrite() keeps their lines whole
+    size_t n = fwrite(data, 1, len, stdout);
+    fflush(stdout);
+    return n;
+}
+
+bool IPAddress::fromString(const char* s) {
+    unsigned int a, b, c, d;
+    char tail;
+    if (!s || sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4) return false;
+    if (a > 255 || b > 255 || c > 255 || d > 255) return false;
+    _addr[0] = a;
+    _addr[1] = b;
+    _addr[2] = c;
+    _addr[3] = d;
+    return true;
+}
+
+String IPAddress::toString() const {
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u", _addr[0], _addr[1], _addr[2], _addr[3]);
+    return String(buf);
+}
+
+// ============================================================================
+// Clock and misc
+// ============================================================================
+
+// Global constructors start threads that read the clock, so it starts on first use
+static std::chrono::steady_clock::duration sinceStart() {
+    static const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    return std::chrono::steady_clock::now() - start;
+}
+
+uint32_t millis() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(sinceStart()).count();
+}
+
+uint32_t micros() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(sinceStart()).count();
+}
+
+void delay(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield() {
+    std::this_thread::yield();
+}
+
+uint32_t esp_random() {
+    static std::mutex lock;
+    static std::mt19937 generator(std::random_device{}());
+    std::lock_guard<std::mutex> guard(lock);
+    return generator();
+}
+
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+// ============================================================================
+// FreeRTOS
+// ============================================================================
+
+struct HostTask {
+    std::mutex lock;
+    std::condition_variable wake;
+    uint32_t notifications = 0;
+};
+
+static thread_local HostTask* currentTask = nullptr;
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char* name, uint32_t stackBytes, void* arg,
+                                   UBaseType_t priority, TaskHandle_t* handle, BaseType_t core) {
+    (void)name, (void)stackBytes, (void)priority, (void)core;
+    HostTask* task = new HostTask();
+    if (handle) *handle = task;
+    std::thread([fn, arg, task]() {
+        currentTask = task;
+        fn(arg);
+    }).detach();
+    return pdPASS;
+}
+
+TickType_t xTaskGetTickCount() {
+    return millis();
+}
+
+void vTaskDelay(TickType_t ticks) {
+    delay(ticks);
+}
+
+void vTaskDelayUntil(TickType_t* previousWake, TickType_t period) {
+    *previousWake += period;
+    int32_t wait = (int32_t)(*previousWake - xTaskGetTickCount());
+    if (wait > 0) delay(wait);
+}
+
+void xTaskNotifyGive(TaskHandle_t task) {
+    if (!task) return;
+    std::lock_guard<std::mutex> guard(task->lock);
+    task->notifications++;
+    task->wake.notify_one();
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout) {
+    HostTask* task = currentTask;
+    if (!task) {
+        delay(timeout);
+        return 0;
+    }
+    std::unique_lock<std::mutex> guard(task->lock);
+    if (timeout == portMAX_DELAY) {
+        task->wake.wait(guard, [task]() { return task->notifications > 0; });
+    } else {
+        task->wake.wait_for(guard, std::chrono::milliseconds(timeout), [task]() { return task->notifications > 0; });
+    }
+    uint32_t count = task->notifications;
+    if (count) task->notifications = clearOnExit ? 0 : count - 1;
+    return count;
+}
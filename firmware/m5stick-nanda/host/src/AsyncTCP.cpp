@@ -0,0 +1,478 @@
+#include <AsyncTCP.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <thread>
+#include <vector>
+
+#define LWIP_TCP_MSS 1436    // lwIP's, so callbacks see device-sized pieces
+#define POLL_INTERVAL_MS 10  // onPoll() and timeouts; lwIP's is 500 ms
+
+// lwIP error codes the callbacks get
+#define ERR_CONN (-11)
+#define ERR_RST (-14)
+
+static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+}
+
+// Through a copy: a callback may replace itself, or delete the client holding it
+template <typename Callback, typename... Args>
+static void invoke(const Callback& callback, Args... args) {
+    Callback copy = callback;
+    copy(args...);
+}
+
+std::recursive_mutex& asyncTcpLock() {
+    static std::recursive_mutex lock;
+    return lock;
+}
+
+// The async_tcp thread and the sockets it polls
+struct AsyncTcpLoop {
+    std::vector<AsyncClient*> clients;
+    std::vector<AsyncServer*> servers;
+    uint64_t nextSerial = 1;
+    int wakeFds[2];
+
+    static AsyncTcpLoop& get() {
+        static AsyncTcpLoop* loop = start();
+        return *loop;
+    }
+
+    static AsyncTcpLoop* start() {
+        AsyncTcpLoop* loop = new AsyncTcpLoop();
+        if (pipe(loop->wakeFds) == 0) {
+            fcntl(loop->wakeFds[0], F_SETFL, O_NONBLOCK);
+            fcntl(loop->wakeFds[1], F_SETFL, O_NONBLOCK);
+        }
+        std::thread([loop]() { loop->run(); }).detach();
+        return loop;
+    }
+
+    // Another thread queued data or reopened a window
+    void wake() {
+        char c = 0;
+        if (write(wakeFds[1], &c, 1) < 0) {}
+    }
+
+    bool alive(AsyncClient* client, uint64_t serial) {
+        for (AsyncClient* c : clients) {
+            if (c == client) return c->_serial == serial;
+        }
+        return false;
+    }
+
+    void run() {
+        std::vector<pollfd> fds;
+        std::vector<AsyncClient*> polled;
+        std::vector<uint64_t> serials;
+        uint32_t lastPoll = millis();
+
+        for (;;) {
+            fds.clear();
+            polled.clear();
+            serials.clear();
+            {
+                std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+                fds.push_back({wakeFds[0], POLLIN, 0});
+                for (AsyncServer* server : servers) {
+                    fds.push_back({server->_fd, POLLIN, 0});
+                }
+                for (AsyncClient* client : clients) {
+                    if (client->_fd < 0) continue;
+                    short events = (client->wantsRead() ? POLLIN : 0) | (client->wantsWrite() ? POLLOUT : 0);
+                    fds.push_back({client->_fd, events, 0});
+                    polled.push_back(client);
+                    serials.push_back(client->_serial);
+                }
+            }
+
+            poll(fds.data(), fds.size(), POLL_INTERVAL_MS);
+
+            std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+            char drain[64];
+            while (read(wakeFds[0], drain, sizeof(drain)) > 0) {}
+
+            size_t serverCount = fds.size() - 1 - polled.size();
+            for (size_t i = 0; i < serverCount; i++) {
+                if (!(fds[1 + i].revents & POLLIN)) continue;
+                for (AsyncServer* server : servers) {
+                    if (server->_fd == fds[1 + i].fd) server->handleAccept();
+                }
+            }
+            for (size_t i = 0; i < polled.size(); i++) {
+                short revents = fds[1 + serverCount + i].revents;
+                AsyncClient* client = polled[i];
+                if (!revents || !alive(client, serials[i]) || client->_fd != fds[1 + serverCount + i].fd) continue;
+                if (revents & (POLLOUT | POLLERR | POLLHUP)) client->handleWritable();
+                if (revents & (POLLIN | POLLERR | POLLHUP) && alive(client, serials[i]) && client->_fd >= 0) {
+                    client->handleReadable();
+                }
+            }
+
+            uint32_t now = millis();
+            if (now - lastPoll >= POLL_INTERVAL_MS) {
+                lastPoll = now;
+                for (size_t i = 0; i < polled.size(); i++) {
+                    if (alive(polled[i], serials[i])) polled[i]->handlePoll(now);
+                }
+            }
+        }
+    }
+};
+
+// ============================================================================
+// AsyncClient
+// ============================================================================
+
+AsyncClient::AsyncClient() : AsyncClient(-1) {}
+
+AsyncClient::AsyncClient(int fd)
+    : _fd(-1), _phase(IDLE), _closing(false), _rxUnacked(0), _ackLater(false), _rxTimeout(0), _lastRx(0),
+      _remoteAddr(0), _remotePort(0), _connectArg(nullptr), _disconnectArg(nullptr), _pollArg(nullptr),
+      _ackArg(nullptr), _errorArg(nullptr), _dataArg(nullptr), _timeoutArg(nullptr) {
+    AsyncTcpLoop& loop = AsyncTcpLoop::get();
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    _serial = loop.nextSerial++;
+    loop.clients.push_back(this);
+    if (fd >= 0) attach(fd, CONNECTED);
+}
+
+AsyncClient::~AsyncClient() {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_fd >= 0) ::close(_fd);
+    std::vector<AsyncClient*>& clients = AsyncTcpLoop::get().clients;
+    for (size_t i = 0; i < clients.size(); i++) {
+        if (clients[i] == this) {
+            clients.erase(clients.begin() + i);
+            break;
+        }
+    }
+}
+
+void AsyncClient::attach(int fd, Phase phase) {
+    setNonBlocking(fd);
+    _fd = fd;
+    _phase = phase;
+    _closing = false;
+    _tx.clear();
+    _rxUnacked = 0;
+    _lastRx = millis();
+
+    sockaddr_in peer = {};
+    socklen_t len = sizeof(peer);
+    if (phase == CONNECTED && getpeername(fd, (sockaddr*)&peer, &len) == 0) {
+        _remoteAddr = peer.sin_addr.s_addr;
+        _remotePort = ntohs(peer.sin_port);
+    }
+    AsyncTcpLoop::get().wake();
+}
+
+bool AsyncClient::connect(IPAddress ip, uint16_t port) {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_phase != IDLE) return false;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return false;
+    setNonBlocking(fd);
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl((uint32_t)ip[0] << 24 | (uint32_t)ip[1] << 16 | (uint32_t)ip[2] << 8 | ip[3]);
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return false;
+    }
+    attach(fd, CONNECTING);
+    _remoteAddr = addr.sin_addr.s_addr;
+    _remotePort = port;
+    return true;
+}
+
+bool AsyncClient::connect(const char* host, uint16_t port) {
+    IPAddress ip;
+    if (ip.fromString(host)) return connect(ip, port);
+
+    // The ESP32 resolves asynchronously; here the lookup blocks the caller
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host, nullptr, &hints, &found) != 0 || !found) return false;
+    uint32_t addr = ntohl(((sockaddr_in*)found->ai_addr)->sin_addr.s_addr);
+    freeaddrinfo(found);
+    return connect(IPAddress(addr >> 24, addr >> 16, addr >> 8, addr), port);
+}
+
+void AsyncClient::close(bool now) {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_phase == IDLE) return;
+    if (now || _phase != CONNECTED) {
+        drop(true);
+    } else {
+        // The async_tcp thread closes once the data is out, so a callback
+        // that closes never sees its objects deleted under it
+        _closing = true;
+        AsyncTcpLoop::get().wake();
+    }
+}
+
+void AsyncClient::drop(bool notify) {
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    _phase = IDLE;
+    _closing = false;
+    _tx.clear();
+    _rxUnacked = 0;
+    // May delete this
+    if (notify && _disconnectCb) invoke(_disconnectCb, _disconnectArg, this);
+}
+
+void AsyncClient::fail(int8_t error) {
+    AsyncTcpLoop& loop = AsyncTcpLoop::get();
+    uint64_t serial = _serial;
+    if (_errorCb) invoke(_errorCb, _errorArg, this, error);
+    if (loop.alive(this, serial)) drop(true);
+}
+
+bool AsyncClient::connecting() {
+    return _phase == CONNECTING;
+}
+
+bool AsyncClient::connected() {
+    return _phase == CONNECTED;
+}
+
+bool AsyncClient::disconnected() {
+    return _phase == IDLE;
+}
+
+size_t AsyncClient::space() {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_phase != CONNECTED || _closing || _tx.size() >= HOST_TCP_SND_BUF) return 0;
+    return HOST_TCP_SND_BUF - _tx.size();
+}
+
+size_t AsyncClient::add(const char* data, size_t size, uint8_t apiflags) {
+    (void)apiflags;
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    size_t room = space();
+    if (size > room) size = room;
+    _tx.append(data, size);
+    return size;
+}
+
+bool AsyncClient::send() {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_phase != CONNECTED) return false;
+    AsyncTcpLoop::get().wake();
+    return true;
+}
+
+size_t AsyncClient::write(const char* data, size_t size) {
+    size_t n = add(data, size);
+    if (n) send();
+    return n;
+}
+
+size_t AsyncClient::ack(size_t len) {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (len > _rxUnacked) len = _rxUnacked;
+    _rxUnacked -= len;
+    if (len) AsyncTcpLoop::get().wake();
+    return len;
+}
+
+IPAddress AsyncClient::remoteIP() {
+    uint32_t addr = ntohl(_remoteAddr);
+    return IPAddress(addr >> 24, addr >> 16, addr >> 8, addr);
+}
+
+void AsyncClient::onConnect(AcConnectHandler cb, void* arg) {
+    _connectCb = cb;
+    _connectArg = arg;
+}
+
+void AsyncClient::onDisconnect(AcConnectHandler cb, void* arg) {
+    _disconnectCb = cb;
+    _disconnectArg = arg;
+}
+
+void AsyncClient::onAck(AcAckHandler cb, void* arg) {
+    _ackCb = cb;
+    _ackArg = arg;
+}
+
+void AsyncClient::onError(AcErrorHandler cb, void* arg) {
+    _errorCb = cb;
+    _errorArg = arg;
+}
+
+void AsyncClient::onData(AcDataHandler cb, void* arg) {
+    _dataCb = cb;
+    _dataArg = arg;
+}
+
+void AsyncClient::onTimeout(AcTimeoutHandler cb, void* arg) {
+    _timeoutCb = cb;
+    _timeoutArg = arg;
+}
+
+void AsyncClient::onPoll(AcConnectHandler cb, void* arg) {
+    _pollCb = cb;
+    _pollArg = arg;
+}
+
+bool AsyncClient::wantsRead() const {
+    return _phase == CONNECTED && _rxUnacked < HOST_TCP_WND;
+}
+
+bool AsyncClient::wantsWrite() const {
+    return _phase == CONNECTING || (_phase == CONNECTED && (!_tx.empty() || _closing));
+}
+
+void AsyncClient::handleWritable() {
+    if (_phase == CONNECTING) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error) {
+            fail(ERR_RST);
+            return;
+        }
+        _phase = CONNECTED;
+        _lastRx = millis();
+        if (_connectCb) invoke(_connectCb, _connectArg, this);
+        return;
+    }
+    if (_phase != CONNECTED) return;
+
+    if (!_tx.empty()) {
+        ssize_t n = ::send(_fd, _tx.data(), _tx.size(), MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) drop(true);
+            return;
+        }
+        _tx.erase(0, n);
+        AsyncTcpLoop& loop = AsyncTcpLoop::get();
+        uint64_t serial = _serial;
+        if (n > 0 && _ackCb) invoke(_ackCb, _ackArg, this, n, 0);
+        if (!loop.alive(this, serial)) return;
+    }
+    if (_closing && _tx.empty()) drop(true);
+}
+
+void AsyncClient::handleReadable() {
+    if (_phase != CONNECTED) return;
+    size_t room = HOST_TCP_WND - _rxUnacked;
+    if (room > LWIP_TCP_MSS) room = LWIP_TCP_MSS;
+    if (room == 0) return;
+
+    uint8_t buf[LWIP_TCP_MSS];
+    ssize_t n = recv(_fd, buf, room, 0);
+    if (n == 0) {
+        drop(true);
+        return;
+    }
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) fail(ERR_CONN);
+        return;
+    }
+
+    _lastRx = millis();
+    _ackLater = false;
+    AsyncTcpLoop& loop = AsyncTcpLoop::get();
+    uint64_t serial = _serial;
+    if (_dataCb) invoke(_dataCb, _dataArg, this, buf, n);
+    if (loop.alive(this, serial) && _ackLater && _phase == CONNECTED) _rxUnacked += n;
+}
+
+void AsyncClient::handlePoll(uint32_t now) {
+    if (_phase != CONNECTED) return;
+    if (_rxTimeout && now - _lastRx >= _rxTimeout * 1000) {
+        AsyncTcpLoop& loop = AsyncTcpLoop::get();
+        uint64_t serial = _serial;
+        if (_timeoutCb) invoke(_timeoutCb, _timeoutArg, this, now - _lastRx);
+        if (!loop.alive(this, serial)) return;
+        _lastRx = now;
+    }
+    if (_pollCb) invoke(_pollCb, _pollArg, this);
+}
+
+// ============================================================================
+// AsyncServer
+// ============================================================================
+
+// Loopback only: the host build is for this machine, not the LAN
+AsyncServer::AsyncServer(uint16_t port) : AsyncServer(IPAddress(127, 0, 0, 1), port) {}
+
+AsyncServer::AsyncServer(IPAddress addr, uint16_t port)
+    : _addr((uint32_t)addr[0] << 24 | (uint32_t)addr[1] << 16 | (uint32_t)addr[2] << 8 | addr[3]),
+      _port(port), _fd(-1), _clientArg(nullptr) {}
+
+AsyncServer::~AsyncServer() {
+    end();
+}
+
+void AsyncServer::begin() {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_fd >= 0) return;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_port);
+    addr.sin_addr.s_addr = htonl(_addr);
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0) {
+        fprintf(stderr, "AsyncServer: cannot listen on port %u: %s\n", _port, strerror(errno));
+        ::close(fd);
+        return;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    _fd = fd;
+
+    AsyncTcpLoop& loop = AsyncTcpLoop::get();
+    loop.servers.push_back(this);
+    loop.wake();
+}
+
+void AsyncServer::end() {
+    std::lock_guard<std::recursive_mutex> guard(asyncTcpLock());
+    if (_fd < 0) return;
+    ::close(_fd);
+    _fd = -1;
+    std::vector<AsyncServer*>& servers = AsyncTcpLoop::get().servers;
+    for (size_t i = 0; i < servers.size(); i++) {
+        if (servers[i] == this) {
+            servers.erase(servers.begin() + i);
+            break;
+        }
+    }
+}
+
+void AsyncServer::handleAccept() {
+    int fd;
+    while ((fd = accept(_fd, nullptr, nullptr)) >= 0) {
+        AsyncClient* client = new AsyncClient(fd);
+        if (_clientCb) {
+            _clientCb(_clientArg, client);
+        } else {
+            delete client;
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#include <ESPmDNS.h>
+#include <M5Unified.h>
+#include <Preferences.h>
+#include <WiFi.h>
+
+#include <math.h>
+
+HostWiFi WiFi;
+HostMDNS MDNS;
+m5::M5Unified M5;
+
+// ============================================================================
+// WiFi
+// ============================================================================
+
+static const char* const SCAN_SSIDS[] = {"nanda-lab", "nanda-guest", "printer-direct"};
+static const int32_t SCAN_RSSI[] = {-42, -61, -78};
+static const int32_t SCAN_CHANNELS[] = {6, 11, 1};
+static const uint8_t SCAN_COUNT = sizeof(SCAN_SSIDS) / sizeof(SCAN_SSIDS[0]);
+
+wl_status_t HostWiFi::begin(const char* ssid, const char* passphrase) {
+    (void)passphrase;
+    _ssid = ssid ? ssid : "";
+    _status = WL_CONNECTED;
+    return _status;
+}
+
+uint8_t* HostWiFi::macAddress(uint8_t* mac) const {
+    static const uint8_t DEFAULT_MAC[6] = {0x02, 0x4e, 0x41, 0x4e, 0x44, 0x41};  // Locally administered
+    memcpy(mac, DEFAULT_MAC, 6);
+    const char* env = getenv("NANDA_HOST_MAC");
+    unsigned b[6];
+    if (env && sscanf(env, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) == 6) {
+        for (int i = 0; i < 6; i++) mac[i] = b[i];
+    }
+    return mac;
+}
+
+String HostWiFi::macAddress() const {
+    uint8_t mac[6];
+    macAddress(mac);
+    char buf[18];
+    snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X", mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+    return String(buf);
+}
+
+int16_t HostWiFi::scanNetworks() {
+    return SCAN_COUNT;
+}
+
+String HostWiFi::SSID(uint8_t i) const {
+    return i < SCAN_COUNT ? String(SCAN_SSIDS[i]) : String();
+}
+
+int32_t HostWiFi::RSSI(uint8_t i) const {
+    return i < SCAN_COUNT ? SCAN_RSSI[i] : 0;
+}
+
+int32_t HostWiFi::channel(uint8_t i) const {
+    return i < SCAN_COUNT ? SCAN_CHANNELS[i] : 0;
+}
+
+// ============================================================================
+// Preferences
+// ============================================================================
+
+const std::string* Preferences::find(const char* key) const {
+    auto it = _values.find(key);
+    if (it != _values.end()) return &it->second;
+    std::string name = std::string("NANDA_PREF_") + key;
+    const char* env = getenv(name.c_str());
+    if (!env) return nullptr;
+    _fromEnv = env;
+    return &_fromEnv;
+}
+
+bool Preferences::isKey(const char* key) const {
+    return find(key) != nullptr;
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) const {
+    const std::string* value = find(key);
+    return value ? String(*value) : defaultValue;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    _values[key] = value.str();
+    return value.length();
+}
+
+int32_t Preferences::getInt(const char* key, int32_t defaultValue) const {
+    const std::string* value = find(key);
+    return value ? (int32_t)strtol(value->c_str(), nullptr, 10) : defaultValue;
+}
+
+size_t Preferences::putInt(const char* key, int32_t value) {
+    _values[key] = std::to_string(value);
+    return sizeof(value);
+}
+
+bool Preferences::getBool(const char* key, bool defaultValue) const {
+    const std::string* value = find(key);
+    return value ? (*value == "1" || *value == "true") : defaultValue;
+}
+
+size_t Preferences::putBool(const char* key, bool value) {
+    _values[key] = value ? "1" : "0";
+    return 1;
+}
+
+// ============================================================================
+// M5
+// ============================================================================
+
+namespace m5 {
+
+void HostDisplay::begin() {
+    setColorDepth(16);
+    createSprite(135, 240);
+}
+
+bool HostImu::update() {
+    // Resting face up: 1 g on Z, a slow sway and sensor noise
+    float t = micros() / 1e6f;
+    auto noise = [] { return ((int32_t)(esp_random() % 2001) - 1000) / 1e5f; };
+    _data.usec = micros();
+    _data.accel = {0.02f * sinf(t * 0.7f) + noise(), 0.02f * cosf(t * 0.5f) + noise(), 1.0f + noise()};
+    _data.gyro = {0.5f * cosf(t * 0.7f) + noise() * 100, -0.4f * sinf(t * 0.5f) + noise() * 100, noise() * 100};
+    _data.mag = {20.0f, 0.0f, -40.0f};
+    return true;
+}
+
+bool HostImu::getImuData(imu_data_t* data) const {
+    *data = _data;
+    return true;
+}
+
+bool HostImu::getTemp(float* t) const {
+    *t = 31.5f;
+    return true;
+}
+
+void M5Unified::begin(const config_t& cfg) {
+    (void)cfg;
+    Display.begin();
+}
+
+}  // namespace m5
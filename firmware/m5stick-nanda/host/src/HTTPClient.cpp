@@ -0,0 +1,161 @@
+#include <HTTPClient.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <fcntl.h>
+
+// Waits up to timeoutMs for fd to be ready; false on timeout
+static bool waitFor(int fd, short events, uint32_t timeoutMs) {
+    pollfd p = {fd, events, 0};
+    return poll(&p, 1, timeoutMs) > 0;
+}
+
+static int connectTo(const std::string& host, uint16_t port, uint32_t timeoutMs) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.c_str(), nullptr, &hints, &found) != 0 || !found) return -1;
+    sockaddr_in addr = *(sockaddr_in*)found->ai_addr;
+    freeaddrinfo(found);
+    addr.sin_port = htons(port);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        close(fd);
+        return -1;
+    }
+    int error = 0;
+    socklen_t len = sizeof(error);
+    if (!waitFor(fd, POLLOUT, timeoutMs) || getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static bool sendAll(int fd, const char* data, size_t len, uint32_t timeoutMs) {
+    while (len > 0) {
+        if (!waitFor(fd, POLLOUT, timeoutMs)) return false;
+        ssize_t n = send(fd, data, len, MSG_NOSIGNAL);
+        if (n <= 0) return false;
+        data += n;
+        len -= n;
+    }
+    return true;
+}
+
+// The body of a chunked response, or "" if it is malformed
+static std::string dechunk(const std::string& in) {
+    std::string out;
+    size_t pos = 0;
+    for (;;) {
+        size_t lineEnd = in.find("\r\n", pos);
+        if (lineEnd == std::string::npos) return out;
+        size_t size = strtoul(in.c_str() + pos, nullptr, 16);
+        if (size == 0 || lineEnd + 2 + size > in.size()) return out;
+        out.append(in, lineEnd + 2, size);
+        pos = lineEnd + 2 + size + 2;
+    }
+}
+
+bool HTTPClient::begin(const String& url) {
+    std::string u = url.str();
+    _secure = u.compare(0, 8, "https://") == 0;
+    size_t scheme = u.find("://");
+    size_t hostStart = scheme == std::string::npos ? 0 : scheme + 3;
+    size_t pathStart = u.find('/', hostStart);
+    std::string authority = u.substr(hostStart, pathStart == std::string::npos ? std::string::npos : pathStart - hostStart);
+    _path = pathStart == std::string::npos ? "/" : u.substr(pathStart);
+
+    size_t colon = authority.find(':');
+    _host = authority.substr(0, colon);
+    _port = colon == std::string::npos ? (_secure ? 443 : 80) : atoi(authority.c_str() + colon + 1);
+    _headers.clear();
+    _body.clear();
+    return !_host.empty();
+}
+
+void HTTPClient::end() {
+    _headers.clear();
+}
+
+void HTTPClient::addHeader(const String& name, const String& value) {
+    _headers += name.str() + ": " + value.str() + "\r\n";
+}
+
+int HTTPClient::GET() {
+    return sendRequest("GET", nullptr, 0);
+}
+
+int HTTPClient::POST(const uint8_t* payload, size_t size) {
+    return sendRequest("POST", payload, size);
+}
+
+int HTTPClient::sendRequest(const char* method, const uint8_t* payload, size_t size) {
+    _body.clear();
+    if (_secure) return HTTPC_ERROR_CONNECTION_REFUSED;  // No TLS on the host
+
+    int fd = connectTo(_host, _port, _timeout);
+    if (fd < 0) return HTTPC_ERROR_CONNECTION_REFUSED;
+
+    std::string request = std::string(method) + " " + _path + " HTTP/1.1\r\nHost: " + _host + ":" +
+                          std::to_string(_port) + "\r\nUser-Agent: ESP32HTTPClient\r\nConnection: close\r\n" +
+                          _headers;
+    if (payload || strcmp(method, "POST") == 0) request += "Content-Length: " + std::to_string(size) + "\r\n";
+    request += "\r\n";
+    if (!sendAll(fd, request.data(), request.size(), _timeout)) {
+        close(fd);
+        return HTTPC_ERROR_SEND_HEADER_FAILED;
+    }
+    if (size && !sendAll(fd, (const char*)payload, size, _timeout)) {
+        close(fd);
+        return HTTPC_ERROR_SEND_PAYLOAD_FAILED;
+    }
+
+    // Connection: close, so the response ends when the server hangs up
+    std::string response;
+    char buf[2048];
+    for (;;) {
+        if (!waitFor(fd, POLLIN, _timeout)) {
+            close(fd);
+            return HTTPC_ERROR_READ_TIMEOUT;
+        }
+        ssize_t n = recv(fd, buf, sizeof(buf), 0);
+        if (n <= 0) break;
+        response.append(buf, n);
+    }
+    close(fd);
+
+    size_t headEnd = response.find("\r\n\r\n");
+    if (response.compare(0, 5, "HTTP/") != 0 || headEnd == std::string::npos) return HTTPC_ERROR_NO_HTTP_SERVER;
+    size_t space = response.find(' ');
+    int code = atoi(response.c_str() + space + 1);
+
+    std::string head = response.substr(0, headEnd);
+    for (char& c : head) c = tolower((unsigned char)c);
+    _body = response.substr(headEnd + 4);
+    if (head.find("\r\ntransfer-encoding: chunked") != std::string::npos) _body = dechunk(_body);
+    return code;
+}
+
+String HTTPClient::errorToString(int error) {
+    switch (error) {
+        case HTTPC_ERROR_CONNECTION_REFUSED: return "connection refused";
+        case HTTPC_ERROR_SEND_HEADER_FAILED: return "send header failed";
+        case HTTPC_ERROR_SEND_PAYLOAD_FAILED: return "send payload failed";
+        case HTTPC_ERROR_NOT_CONNECTED: return "not connected";
+        case HTTPC_ERROR_CONNECTION_LOST: return "connection lost";
+        case HTTPC_ERROR_NO_HTTP_SERVER: return "no HTTP server";
+        case HTTPC_ERROR_READ_TIMEOUT: return "read Timeout";
+        default: return String();
+    }
+}
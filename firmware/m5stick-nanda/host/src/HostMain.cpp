@@ -0,0 +1,8 @@
+// The Arduino core's main loop, as a process
+void setup();
+void loop();
+
+int main() {
+    setup();
+    for (;;) loop();
+}
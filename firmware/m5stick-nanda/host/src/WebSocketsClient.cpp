@@ -0,0 +1,330 @@
+#include <WebSocketsClient.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <WebSocketFrame.h>
+
+#define WS_FIN 0x80
+#define WS_MASK 0x80
+#define WS_OP_CONTINUATION 0x0
+#define WS_OP_TEXT 0x1
+#define WS_OP_BINARY 0x2
+#define WS_OP_CLOSE 0x8
+#define WS_OP_PING 0x9
+#define WS_OP_PONG 0xA
+#define WS_MAX_HANDSHAKE 4096
+#define WS_MAX_MESSAGE 65536
+
+WebSocketsClient::WebSocketsClient()
+    : _port(80), _fd(-1), _phase(IDLE), _messageOpcode(0), _reconnectInterval(500), _lastAttempt(0),
+      _pingInterval(0), _pongTimeout(0), _disconnectCount(0), _lastPing(0), _pongPending(false), _missedPongs(0) {}
+
+WebSocketsClient::~WebSocketsClient() {
+    drop(false);
+}
+
+void WebSocketsClient::begin(const char* host, uint16_t port, const char* url, const char* protocol) {
+    _host = host;
+    _port = port;
+    _url = url;
+    _protocol = protocol ? protocol : "";
+    _lastAttempt = millis() - _reconnectInterval;  // First attempt on the next loop()
+}
+
+void WebSocketsClient::enableHeartbeat(uint32_t pingInterval, uint32_t pongTimeout, uint8_t disconnectTimeoutCount) {
+    _pingInterval = pingInterval;
+    _pongTimeout = pongTimeout;
+    _disconnectCount = disconnectTimeoutCount;
+}
+
+void WebSocketsClient::disconnect() {
+    if (_phase == OPEN) {
+        sendFrame(WS_OP_CLOSE, nullptr, 0);
+        flush();
+    }
+    drop(true);
+    _host.clear();  // No reconnecting after an explicit disconnect
+}
+
+void WebSocketsClient::emit(WStype_t type, uint8_t* payload, size_t length) {
+    if (_event) _event(type, payload, length);
+}
+
+void WebSocketsClient::drop(bool notify) {
+    bool wasOpen = _phase == OPEN;
+    if (_fd >= 0) ::close(_fd);
+    _fd = -1;
+    _phase = IDLE;
+    _tx.clear();
+    _rx.clear();
+    _message.clear();
+    _lastAttempt = millis();
+    if (notify && wasOpen) emit(WStype_DISCONNECTED, nullptr, 0);
+}
+
+void WebSocketsClient::startConnect() {
+    _lastAttempt = millis();
+
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(_host.c_str(), nullptr, &hints, &found) != 0 || !found) return;
+    sockaddr_in addr = *(sockaddr_in*)found->ai_addr;
+    freeaddrinfo(found);
+    addr.sin_port = htons(_port);
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    if (::connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS) {
+        ::close(fd);
+        return;
+    }
+    _fd = fd;
+    _phase = CONNECTING;
+}
+
+void WebSocketsClient::loop() {
+    uint32_t now = millis();
+    if (_phase == IDLE) {
+        if (!_host.empty() && now - _lastAttempt >= _reconnectInterval) startConnect();
+        return;
+    }
+
+    if (_phase == CONNECTING) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        getsockopt(_fd, SOL_SOCKET, SO_ERROR, &error, &len);
+        if (error) {
+            drop(false);
+            return;
+        }
+        sockaddr_in peer;
+        len = sizeof(peer);
+        if (getpeername(_fd, (sockaddr*)&peer, &len) < 0) {
+            if (now - _lastAttempt > 5000) drop(false);  // Connect timed out
+            return;
+        }
+
+        uint8_t nonce[16];
+        for (uint8_t& b : nonce) b = esp_random();
+        char key[25];
+        base64Encode(nonce, sizeof(nonce), key);
+        _key = key;
+        _tx = "GET " + _url + " HTTP/1.1\r\nHost: " + _host + ":" + std::to_string(_port) +
+              "\r\nConnection: Upgrade\r\nUpgrade: websocket\r\nSec-WebSocket-Version: 13\r\nSec-WebSocket-Key: " +
+              _key + "\r\n";
+        if (!_protocol.empty()) _tx += "Sec-WebSocket-Protocol: " + _protocol + "\r\n";
+        _tx += "User-Agent: arduino-WebSocket-Client\r\n\r\n";
+        _phase = HANDSHAKE;
+    }
+
+    flush();
+    if (_fd < 0) return;
+
+    char buf[2048];
+    for (;;) {
+        ssize_t n = recv(_fd, buf, sizeof(buf), 0);
+        if (n > 0) {
+            _rx.append(buf, n);
+            continue;
+        }
+        if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+            drop(true);
+            return;
+        }
+        break;
+    }
+
+    if (_phase == HANDSHAKE && !readHandshake()) return;
+    while (_phase == OPEN && readFrame()) {}
+    if (_phase == OPEN) heartbeat(now);
+}
+
+bool WebSocketsClient::readHandshake() {
+    size_t end = _rx.find("\r\n\r\n");
+    if (end == std::string::npos) {
+        if (_rx.size() > WS_MAX_HANDSHAKE) drop(false);
+        return false;
+    }
+    std::string head = _rx.substr(0, end);
+    _rx.erase(0, end + 4);
+
+    // Header names are case-insensitive, the accept value is not
+    std::string lower = head;
+    for (char& c : lower) c = tolower((unsigned char)c);
+    bool upgraded = head.compare(0, 12, "HTTP/1.1 101") == 0;
+    size_t field = lower.find("\r\nsec-websocket-accept:");
+    bool accepted = false;
+    if (field != std::string::npos) {
+        size_t value = head.find_first_not_of(' ', field + 23);
+        size_t valueEnd = head.find("\r\n", value);
+        char expected[WEBSOCKET_ACCEPT_SIZE];
+        accepted = webSocketAccept(_key.c_str(), expected) && head.compare(value, valueEnd - value, expected) == 0;
+    }
+    if (!upgraded || !accepted) {
+        drop(false);
+        return false;
+    }
+
+    _phase = OPEN;
+    _lastPing = millis();
+    _pongPending = false;
+    _missedPongs = 0;
+    emit(WStype_CONNECTED, (uint8_t*)_url.c_str(), _url.size());
+    return true;
+}
+
+bool WebSocketsClient::readFrame() {
+    const uint8_t* p = (const uint8_t*)_rx.data();
+    if (_rx.size() < 2) return false;
+    bool final = p[0] & WS_FIN;
+    uint8_t opcode = p[0] & 0x0F;
+    bool masked = p[1] & WS_MASK;
+    uint64_t len = p[1] & 0x7F;
+    size_t header = 2;
+    if (len == 126) {
+        if (_rx.size() < 4) return false;
+        len = (uint64_t)p[2] << 8 | p[3];
+        header = 4;
+    } else if (len == 127) {
+        if (_rx.size() < 10) return false;
+        len = 0;
+        for (int i = 0; i < 8; i++) len = len << 8 | p[2 + i];
+        header = 10;
+    }
+    if (len > WS_MAX_MESSAGE) {
+        drop(true);
+        return false;
+    }
+    uint8_t mask[4] = {0, 0, 0, 0};
+    if (masked) {
+        if (_rx.size() < header + 4) return false;
+        memcpy(mask, p + header, 4);
+        header += 4;
+    }
+    if (_rx.size() < header + len) return false;
+
+    std::string payload = _rx.substr(header, len);
+    for (size_t i = 0; i < len; i++) payload[i] ^= mask[i & 3];
+    _rx.erase(0, header + len);
+
+    switch (opcode) {
+        case WS_OP_TEXT:
+        case WS_OP_BINARY:
+        case WS_OP_CONTINUATION: {
+            if (opcode != WS_OP_CONTINUATION) {
+                _message.clear();
+                _messageOpcode = opcode;
+            }
+            _message += payload;
+            if (!final) break;
+            std::string message;
+            message.swap(_message);
+            // As the library does, text arrives terminated
+            size_t length = message.size();
+            message += '\0';
+            emit(_messageOpcode == WS_OP_TEXT ? WStype_TEXT : WStype_BIN, (uint8_t*)&message[0], length);
+            break;
+        }
+        case WS_OP_PING:
+            sendFrame(WS_OP_PONG, (const uint8_t*)payload.data(), len);
+            flush();
+            emit(WStype_PING, (uint8_t*)&payload[0], len);
+            break;
+        case WS_OP_PONG:
+            _pongPending = false;
+            _missedPongs = 0;
+            emit(WStype_PONG, (uint8_t*)&payload[0], len);
+            break;
+        case WS_OP_CLOSE:
+            sendFrame(WS_OP_CLOSE, (const uint8_t*)payload.data(), len < 2 ? len : 2);
+            flush();
+            drop(true);
+            return false;
+        default:
+            break;
+    }
+    return true;
+}
+
+void WebSocketsClient::heartbeat(uint32_t now) {
+    if (!_pingInterval) return;
+    if (_pongPending && now - _lastPing >= _pongTimeout) {
+        _pongPending = false;
+        if (++_missedPongs >= _disconnectCount && _disconnectCount) {
+            drop(true);
+            return;
+        }
+    }
+    if (now - _lastPing >= _pingInterval) {
+        sendPing();
+        _lastPing = now;
+        _pongPending = true;
+    }
+}
+
+bool WebSocketsClient::sendFrame(uint8_t opcode, const uint8_t* payload, size_t length) {
+    if (_phase != OPEN) return false;
+    uint8_t header[WEBSOCKETS_MAX_HEADER_SIZE];
+    size_t n = 0;
+    header[n++] = WS_FIN | opcode;
+    if (length < 126) {
+        header[n++] = WS_MASK | length;
+    } else if (length <= 0xFFFF) {
+        header[n++] = WS_MASK | 126;
+        header[n++] = length >> 8;
+        header[n++] = length;
+    } else {
+        header[n++] = WS_MASK | 127;
+        for (int i = 7; i >= 0; i--) header[n++] = (uint64_t)length >> (i * 8);
+    }
+    uint8_t mask[4];
+    uint32_t key = esp_random();
+    memcpy(mask, &key, 4);
+    memcpy(header + n, mask, 4);
+    n += 4;
+
+    _tx.append((const char*)header, n);
+    size_t start = _tx.size();
+    _tx.append((const char*)payload, length);
+    for (size_t i = 0; i < length; i++) _tx[start + i] ^= mask[i & 3];
+    flush();
+    return true;
+}
+
+bool WebSocketsClient::sendTXT(uint8_t* payload, size_t length, bool headerToPayload) {
+    if (length == 0) length = strlen((const char*)(headerToPayload ? payload + WEBSOCKETS_MAX_HEADER_SIZE : payload));
+    return sendFrame(WS_OP_TEXT, headerToPayload ? payload + WEBSOCKETS_MAX_HEADER_SIZE : payload, length);
+}
+
+bool WebSocketsClient::sendBIN(uint8_t* payload, size_t length, bool headerToPayload) {
+    return sendFrame(WS_OP_BINARY, headerToPayload ? payload + WEBSOCKETS_MAX_HEADER_SIZE : payload, length);
+}
+
+bool WebSocketsClient::sendPing(uint8_t* payload, size_t length) {
+    return sendFrame(WS_OP_PING, payload, length);
+}
+
+void WebSocketsClient::flush() {
+    while (!_tx.empty() && _fd >= 0) {
+        ssize_t n = ::send(_fd, _tx.data(), _tx.size(), MSG_NOSIGNAL);
+        if (n > 0) {
+            _tx.erase(0, n);
+        } else {
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;  // The rest on the next loop()
+            drop(true);
+            return;
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#include "AgentCard.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static uint32_t fnv1a(uint32_t h, const char* s, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t fnv1a(uint32_t h, const char* s) {
+    // The trailing NUL separates fields, so "ab"+"c" differs from "a"+"bc"
+    return s ? fnv1a(h, s, strlen(s) + 1) : fnv1a(h, "", 1);
+}
+
+AgentCard::AgentCard(ArduinoJson::Allocator* allocator) : _allocator(allocator), _active(0), _inputs(0), _revision(0) {
+    for (int i = 0; i < 2; i++) {
+        _buf[i][0] = '\0';
+        _len[i] = 0;
+        _etag[i][0] = '\0';
+    }
+}
+
+uint32_t AgentCard::fingerprint(const AgentCardInfo& info) {
+    uint32_t h = 2166136261u;
+    h = fnv1a(h, info.name);
+    h = fnv1a(h, info.handle);
+    h = fnv1a(h, info.deviceId);
+    h = fnv1a(h, info.description);
+    h = fnv1a(h, info.url);
+    h = fnv1a(h, info.version);
+    for (size_t i = 0; i < info.skillCount; i++) {
+        h = fnv1a(h, info.skills[i].id);
+        h = fnv1a(h, info.skills[i].name);
+        h = fnv1a(h, info.skills[i].description);
+    }
+    return h;
+}
+
+bool AgentCard::update(const AgentCardInfo& info) {
+    uint32_t inputs = fingerprint(info);
+    if (valid() && inputs == _inputs) return false;
+
+    JsonDocument doc(_allocator);
+    doc["name"] = info.name;
+    doc["handle"] = info.handle;
+    doc["deviceId"] = info.deviceId;
+    doc["description"] = info.description;
+    doc["url"] = info.url;
+    doc["version"] = info.version;
+
+    JsonArray inputModes = doc["defaultInputModes"].to<JsonArray>();
+    inputModes.add("application/json");
+
+    JsonArray outputModes = doc["defaultOutputModes"].to<JsonArray>();
+    outputModes.add("application/json");
+
+    JsonObject caps = doc["capabilities"].to<JsonObject>();
+    caps["streaming"] = false;
+    caps["pushNotifications"] = false;
+
+    JsonArray skills = doc["skills"].to<JsonArray>();
+    for (size_t i = 0; i < info.skillCount; i++) {
+        JsonObject skill = skills.add<JsonObject>();
+        skill["id"] = info.skills[i].id;
+        skill["name"] = info.skills[i].name;
+        skill["description"] = info.skills[i].description;
+    }
+
+    uint8_t next = _active ^ 1;
+    size_t len = serializeJson(doc, _buf[next], AGENT_CARD_MAX);
+    if (len == 0 || len >= AGENT_CARD_MAX - 1) {
+        return false;   // Does not fit; keep serving the previous card
+    }
+    _len[next] = len;
+    snprintf(_etag[next], AGENT_CARD_ETAG_MAX, "\"%08x\"", (unsigned)fnv1a(2166136261u, _buf[next], len));
+
+    _active = next;
+    _inputs = inputs;
+    _revision++;
+    return true;
+}
+
+bool AgentCard::notModified(const char* ifNoneMatch) const {
+    if (!ifNoneMatch || !valid()) return false;
+
+    const char* etag = _etag[_active];
+    size_t etagLen = strlen(etag);
+    const char* p = ifNoneMatch;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '*') return true;
+        // If-None-Match uses weak comparison: W/"x" matches "x"
+        if (p[0] == 'W' && p[1] == '/') p += 2;
+        size_t n = strcspn(p, ", \t");
+        if (n == etagLen && strncmp(p, etag, n) == 0) return true;
+        p += n;
+    }
+    return false;
+}
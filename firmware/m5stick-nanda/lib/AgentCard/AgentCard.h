@@ -0,0 +1,65 @@
+/**
+ * Agent card, serialized once and served from a static buffer.
+ *
+ * The card only depends on the device identity and its network address,
+ * so it is rebuilt when those change (update() compares a fingerprint of
+ * its inputs and returns early otherwise) rather than on every request.
+ * Each build gets a strong ETag so pollers can revalidate with
+ * If-None-Match and receive 304 Not Modified.
+ *
+ * Two buffers are used: a rebuild writes the inactive one and then flips,
+ * so a response still streaming the previous card from another task is
+ * not torn by a single rebuild.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <SkillTable.h>
+
+#ifndef AGENT_CARD_MAX
+#define AGENT_CARD_MAX 1536
+#endif
+#define AGENT_CARD_ETAG_MAX 12   // "xxxxxxxx" plus NUL
+
+struct AgentCardInfo {
+    const char* name;
+    const char* handle;
+    const char* deviceId;
+    const char* description;
+    const char* url;
+    const char* version;
+    const SkillDef* skills;        // The same table the JSON-RPC dispatcher uses
+    size_t skillCount;
+};
+
+class AgentCard {
+public:
+    explicit AgentCard(ArduinoJson::Allocator* allocator = ArduinoJson::detail::DefaultAllocator::instance());
+
+    // Rebuild if any input changed; returns true when the card was rebuilt
+    bool update(const AgentCardInfo& info);
+
+    bool valid() const { return _len[_active] > 0; }
+    const char* json() const { return _buf[_active]; }
+    size_t length() const { return _len[_active]; }
+    const char* etag() const { return _etag[_active]; }
+    uint32_t revision() const { return _revision; }
+
+    // True when an If-None-Match header value matches the current ETag
+    bool notModified(const char* ifNoneMatch) const;
+
+private:
+    static uint32_t fingerprint(const AgentCardInfo& info);
+
+    ArduinoJson::Allocator* _allocator;   // Only used while rebuilding
+    char _buf[2][AGENT_CARD_MAX];
+    size_t _len[2];
+    char _etag[2][AGENT_CARD_ETAG_MAX];
+    volatile uint8_t _active;
+    uint32_t _inputs;
+    uint32_t _revision;
+};
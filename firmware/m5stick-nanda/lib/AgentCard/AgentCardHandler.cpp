@@ -0,0 +1,20 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "AgentCardHandler.h"
+
+void AgentCardHandler::handleRequest(HttpRequest& request) {
+    if (!_card.valid()) {
+        request.send(503);
+        return;
+    }
+
+    const char* match = request.header("If-None-Match");
+    HttpResponse& response = match && _card.notModified(match)
+                                 ? request.beginResponse(304)
+                                 : request.beginResponse(200, "application/json", _card.json(), _card.length());
+    response.addHeader("ETag", _card.etag());
+    response.addHeader("Cache-Control", "no-cache");
+    request.send(response);
+}
+
+#endif  // ARDUINO || NANDA_HOST
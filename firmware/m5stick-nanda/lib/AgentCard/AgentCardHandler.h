@@ -0,0 +1,26 @@
+/**
+ * Answers requests for an AgentCard on an HttpServer (ESP32 only).
+ *
+ * The response is sent straight from the card's buffer, and a request
+ * whose If-None-Match matches the current ETag gets an empty 304.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <HttpServer.h>
+#include "AgentCard.h"
+
+class AgentCardHandler {
+public:
+    explicit AgentCardHandler(const AgentCard& card) : _card(card) {}
+
+    // Reads If-None-Match, which the HttpHandler has to keep
+    void handleRequest(HttpRequest& request);
+
+private:
+    const AgentCard& _card;
+};
+
+#endif  // ARDUINO || NANDA_HOST
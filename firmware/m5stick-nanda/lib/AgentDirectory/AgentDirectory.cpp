@@ -0,0 +1,348 @@
+#include "AgentDirectory.h"
+
+#include <string.h>
+#include <algorithm>
+
+static_assert(AGENT_DIR_ARENA_BYTES <= 65535, "arena offsets are 16-bit");
+static_assert(AGENT_DIR_STRINGS <= 32767, "string ids are int16_t");
+static_assert((AGENT_DIR_BUCKETS & (AGENT_DIR_BUCKETS - 1)) == 0, "bucket count must be a power of two");
+
+AgentDirectory::AgentDirectory() {
+    clear();
+}
+
+void AgentDirectory::clear() {
+    for (int i = 0; i < AGENT_DIR_CAPACITY; i++) {
+        _entries[i].handle = NONE;
+        _entries[i].lruPrev = NONE;
+        _entries[i].lruNext = (i + 1 < AGENT_DIR_CAPACITY) ? i + 1 : NONE;
+    }
+    _freeEntry = 0;
+    _count = 0;
+    _lruHead = NONE;
+    _lruTail = NONE;
+
+    for (int i = 0; i < AGENT_DIR_STRINGS; i++) {
+        _strings[i].refs = 0;
+        _strings[i].next = (i + 1 < AGENT_DIR_STRINGS) ? i + 1 : NONE;
+    }
+    for (int i = 0; i < AGENT_DIR_BUCKETS; i++) {
+        _buckets[i] = NONE;
+    }
+    _freeString = 0;
+    _stringCount = 0;
+    _arenaUsed = 0;
+    _arenaLive = 0;
+
+    _pass = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+// ---------------------------------------------------------------------------
+// Discovery passes
+// ---------------------------------------------------------------------------
+
+void AgentDirectory::beginPass() {
+    _pass++;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+AgentDirectory::Change AgentDirectory::upsert(const char* handle, const char* url,
+                                              const char* name, bool healthy) {
+    if (!url) url = "";
+    if (!name) name = "";
+    size_t len = handle ? strlen(handle) : 0;
+    if (len == 0 || len > AGENT_DIR_STRING_MAX ||
+        strlen(url) > AGENT_DIR_STRING_MAX || strlen(name) > AGENT_DIR_STRING_MAX) {
+        return reject();
+    }
+
+    int16_t id = lookup(handle, len);
+    if (id != NONE && _strings[id].owner != NONE) {
+        int16_t slot = _strings[id].owner;
+        Entry& e = _entries[slot];
+        // Off the LRU list while its strings change, so it cannot evict itself
+        lruUnlink(slot);
+        bool urlChanged = false;
+        bool nameChanged = false;
+        if (!replace(e.url, url, urlChanged) || !replace(e.name, name, nameChanged)) {
+            removeEntry(slot);
+            return reject();
+        }
+        bool changed = urlChanged || nameChanged || e.healthy != healthy;
+        e.healthy = healthy;
+        e.pass = _pass;
+        lruPushFront(slot);
+        if (changed) _stats.changed++;
+        return changed ? CHANGED : UNCHANGED;
+    }
+
+    int16_t slot = allocEntry();
+    if (slot == NONE) return reject();
+    Entry& e = _entries[slot];
+    e.handle = intern(handle, len);
+    e.url = NONE;
+    e.name = NONE;
+    bool changed;
+    if (e.handle == NONE || !replace(e.url, url, changed) || !replace(e.name, name, changed)) {
+        if (e.url != NONE) release(e.url);
+        if (e.handle != NONE) release(e.handle);
+        e.handle = NONE;
+        e.lruNext = _freeEntry;
+        _freeEntry = slot;
+        return reject();
+    }
+    _strings[e.handle].owner = slot;
+    e.healthy = healthy;
+    e.pass = _pass;
+
+    _order[_count++] = slot;
+    lruPushFront(slot);
+    _stats.added++;
+    return ADDED;
+}
+
+AgentDirectory::Change AgentDirectory::reject() {
+    _stats.rejected++;
+    return REJECTED;
+}
+
+const AgentDirectory::PassStats& AgentDirectory::endPass(bool complete) {
+    if (!complete) return _stats;
+    for (int pos = (int)_count - 1; pos >= 0; pos--) {
+        int16_t slot = _order[pos];
+        if (_entries[slot].pass != _pass) {
+            removeEntry(slot);
+            _stats.removed++;
+        }
+    }
+    return _stats;
+}
+
+// ---------------------------------------------------------------------------
+// Lookup and access
+// ---------------------------------------------------------------------------
+
+int AgentDirectory::find(const char* handle) const {
+    if (!handle) return -1;
+    int16_t id = lookup(handle, strlen(handle));
+    if (id == NONE || _strings[id].owner == NONE) return -1;
+    return positionOf(_strings[id].owner);
+}
+
+void AgentDirectory::touch(int position) {
+    int16_t slot = slotAt(position);
+    if (slot == NONE) return;
+    lruUnlink(slot);
+    lruPushFront(slot);
+}
+
+const char* AgentDirectory::handle(int position) const {
+    int16_t slot = slotAt(position);
+    return slot == NONE ? "" : str(_entries[slot].handle);
+}
+
+const char* AgentDirectory::url(int position) const {
+    int16_t slot = slotAt(position);
+    return slot == NONE ? "" : str(_entries[slot].url);
+}
+
+const char* AgentDirectory::name(int position) const {
+    int16_t slot = slotAt(position);
+    return slot == NONE ? "" : str(_entries[slot].name);
+}
+
+bool AgentDirectory::healthy(int position) const {
+    int16_t slot = slotAt(position);
+    return slot != NONE && _entries[slot].healthy;
+}
+
+int16_t AgentDirectory::slotAt(int position) const {
+    if (position < 0 || position >= (int)_count) return NONE;
+    return _order[position];
+}
+
+int AgentDirectory::positionOf(int16_t slot) const {
+    for (int pos = 0; pos < (int)_count; pos++) {
+        if (_order[pos] == slot) return pos;
+    }
+    return -1;
+}
+
+// ---------------------------------------------------------------------------
+// Entries and LRU
+// ---------------------------------------------------------------------------
+
+int16_t AgentDirectory::allocEntry() {
+    if (_freeEntry == NONE && !evictOne()) return NONE;
+    int16_t slot = _freeEntry;
+    _freeEntry = _entries[slot].lruNext;
+    return slot;
+}
+
+bool AgentDirectory::evictOne() {
+    if (_lruTail == NONE) return false;
+    removeEntry(_lruTail);
+    _stats.evicted++;
+    return true;
+}
+
+void AgentDirectory::removeEntry(int16_t slot) {
+    Entry& e = _entries[slot];
+    lruUnlink(slot);
+
+    int pos = positionOf(slot);
+    if (pos >= 0) {
+        memmove(&_order[pos], &_order[pos + 1], (_count - pos - 1) * sizeof(_order[0]));
+        _count--;
+    }
+
+    _strings[e.handle].owner = NONE;
+    release(e.handle);
+    release(e.url);
+    release(e.name);
+    e.handle = NONE;
+    e.lruNext = _freeEntry;
+    _freeEntry = slot;
+}
+
+void AgentDirectory::lruUnlink(int16_t slot) {
+    Entry& e = _entries[slot];
+    if (e.lruPrev != NONE) _entries[e.lruPrev].lruNext = e.lruNext;
+    else if (_lruHead == slot) _lruHead = e.lruNext;
+    if (e.lruNext != NONE) _entries[e.lruNext].lruPrev = e.lruPrev;
+    else if (_lruTail == slot) _lruTail = e.lruPrev;
+    e.lruPrev = NONE;
+    e.lruNext = NONE;
+}
+
+void AgentDirectory::lruPushFront(int16_t slot) {
+    Entry& e = _entries[slot];
+    e.lruPrev = NONE;
+    e.lruNext = _lruHead;
+    if (_lruHead != NONE) _entries[_lruHead].lruPrev = slot;
+    _lruHead = slot;
+    if (_lruTail == NONE) _lruTail = slot;
+}
+
+// ---------------------------------------------------------------------------
+// String interning
+// ---------------------------------------------------------------------------
+
+uint32_t AgentDirectory::hashOf(const char* s, size_t len) {
+    uint32_t h = 2166136261u;   // FNV-1a
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (uint8_t)s[i]) * 16777619u;
+    }
+    return h;
+}
+
+int16_t AgentDirectory::lookup(const char* s, size_t len) const {
+    if (len > AGENT_DIR_STRING_MAX) return NONE;
+    int16_t id = _buckets[hashOf(s, len) & (AGENT_DIR_BUCKETS - 1)];
+    while (id != NONE) {
+        const StringRec& rec = _strings[id];
+        if (rec.len == len && memcmp(str(id), s, len) == 0) return id;
+        id = rec.next;
+    }
+    return NONE;
+}
+
+bool AgentDirectory::replace(int16_t& field, const char* s, bool& changed) {
+    size_t len = strlen(s);
+    changed = false;
+    if (field != NONE && _strings[field].len == len && memcmp(str(field), s, len) == 0) {
+        return true;
+    }
+    // reserve() has compacted and evicted all it can when this fails
+    int16_t id = intern(s, len);
+    if (id == NONE) return false;
+    if (field != NONE) release(field);
+    field = id;
+    changed = true;
+    return true;
+}
+
+int16_t AgentDirectory::intern(const char* s, size_t len) {
+    int16_t id = lookup(s, len);
+    if (id != NONE) {
+        _strings[id].refs++;
+        return id;
+    }
+
+    if (_freeString == NONE || !reserve(len + 1)) return NONE;
+
+    id = _freeString;
+    StringRec& rec = _strings[id];
+    _freeString = rec.next;
+
+    rec.offset = _arenaUsed;
+    rec.len = (uint8_t)len;
+    rec.refs = 1;
+    rec.owner = NONE;
+    memcpy(_arena + _arenaUsed, s, len);
+    _arena[_arenaUsed + len] = '\0';
+    _arenaUsed += len + 1;
+    _arenaLive += len + 1;
+
+    uint16_t bucket = hashOf(s, len) & (AGENT_DIR_BUCKETS - 1);
+    rec.next = _buckets[bucket];
+    _buckets[bucket] = id;
+    _stringCount++;
+    return id;
+}
+
+void AgentDirectory::release(int16_t id) {
+    if (id == NONE) return;
+    StringRec& rec = _strings[id];
+    if (--rec.refs > 0) return;
+
+    uint16_t bucket = hashOf(str(id), rec.len) & (AGENT_DIR_BUCKETS - 1);
+    for (int16_t* link = &_buckets[bucket]; *link != NONE; link = &_strings[*link].next) {
+        if (*link == id) {
+            *link = rec.next;
+            break;
+        }
+    }
+
+    _arenaLive -= rec.len + 1;
+    if (rec.offset + rec.len + 1 == _arenaUsed) {
+        _arenaUsed = rec.offset;   // Last string in the arena, reclaim right away
+    }
+    rec.next = _freeString;
+    _freeString = id;
+    _stringCount--;
+}
+
+bool AgentDirectory::reserve(size_t bytes) {
+    while (_arenaUsed + bytes > AGENT_DIR_ARENA_BYTES) {
+        if (_arenaLive + bytes <= AGENT_DIR_ARENA_BYTES) {
+            compact();
+        } else if (!evictOne()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void AgentDirectory::compact() {
+    int16_t live[AGENT_DIR_STRINGS];
+    size_t n = 0;
+    for (int16_t id = 0; id < AGENT_DIR_STRINGS; id++) {
+        if (_strings[id].refs > 0) live[n++] = id;
+    }
+    std::sort(live, live + n, [this](int16_t a, int16_t b) {
+        return _strings[a].offset < _strings[b].offset;
+    });
+
+    uint16_t at = 0;
+    for (size_t i = 0; i < n; i++) {
+        StringRec& rec = _strings[live[i]];
+        if (rec.offset != at) {
+            memmove(_arena + at, _arena + rec.offset, rec.len + 1);
+            rec.offset = at;
+        }
+        at += rec.len + 1;
+    }
+    _arenaUsed = at;
+}
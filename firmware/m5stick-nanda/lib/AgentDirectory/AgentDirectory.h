@@ -0,0 +1,143 @@
+/**
+ * Bounded directory of agents discovered through the registry.
+ *
+ * Everything lives in fixed-size storage sized at compile time:
+ * - entries:  one slot per agent, kept in discovery order for the UI
+ * - strings:  interned in a compact arena, so a handle or name that is
+ *             repeated (name == handle is common) is stored once
+ * - LRU list: when slots or arena run out, the least recently seen or
+ *             used agent is evicted instead of new agents being dropped
+ *
+ * Discovery passes update the directory incrementally:
+ *
+ *   dir.beginPass();
+ *   for each agent in the response: dir.upsert(handle, url, name, healthy);
+ *   dir.endPass(complete);   // removes agents the registry no longer lists
+ *
+ * String pointers returned by the accessors stay valid until the next
+ * mutating call.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef AGENT_DIR_CAPACITY
+#define AGENT_DIR_CAPACITY 256
+#endif
+#ifndef AGENT_DIR_ARENA_BYTES
+#define AGENT_DIR_ARENA_BYTES 12288   // ~48 bytes per agent at capacity
+#endif
+#define AGENT_DIR_STRINGS (AGENT_DIR_CAPACITY * 3 + 2)   // Room to swap one string
+#define AGENT_DIR_BUCKETS 256   // Power of two
+#define AGENT_DIR_STRING_MAX 255
+
+class AgentDirectory {
+public:
+    enum Change {
+        UNCHANGED = 0,
+        ADDED,
+        CHANGED,
+        REJECTED    // Empty handle, a string longer than AGENT_DIR_STRING_MAX, or
+                    // no room for its strings (a listed agent is then dropped,
+                    // not left with its old url and name)
+    };
+
+    struct PassStats {
+        uint16_t added;
+        uint16_t changed;
+        uint16_t removed;
+        uint16_t evicted;
+        uint16_t rejected;
+    };
+
+    AgentDirectory();
+
+    void clear();
+
+    void beginPass();
+    Change upsert(const char* handle, const char* url, const char* name, bool healthy);
+    // Drop agents not seen since beginPass(); skipped for a partial pass
+    const PassStats& endPass(bool complete);
+    const PassStats& lastPass() const { return _stats; }
+
+    // Lookup by handle, returns the display position or -1
+    int find(const char* handle) const;
+    // Mark an agent as used (e.g. selected in the UI) so it is evicted last
+    void touch(int position);
+
+    size_t size() const { return _count; }
+    // Every slot taken: a new agent would evict one
+    bool full() const { return _count == AGENT_DIR_CAPACITY; }
+    const char* handle(int position) const;
+    const char* url(int position) const;
+    const char* name(int position) const;
+    bool healthy(int position) const;
+
+    // Memory accounting
+    size_t arenaUsed() const { return _arenaUsed; }
+    size_t arenaLive() const { return _arenaLive; }
+    size_t stringCount() const { return _stringCount; }
+    static size_t footprint() { return sizeof(AgentDirectory); }
+
+private:
+    static const int16_t NONE = -1;
+
+    struct StringRec {
+        uint16_t offset;    // Into _arena, NUL-terminated
+        uint16_t refs;      // 0 = free record
+        int16_t next;       // Bucket chain, or free list
+        int16_t owner;      // Entry whose handle this is, or NONE
+        uint8_t len;
+    };
+
+    struct Entry {
+        int16_t handle;     // String ids
+        int16_t url;
+        int16_t name;
+        int16_t lruPrev;
+        int16_t lruNext;    // Also links the free list
+        uint16_t pass;      // Last pass that listed this agent
+        bool healthy;
+    };
+
+    static uint32_t hashOf(const char* s, size_t len);
+
+    int16_t lookup(const char* s, size_t len) const;
+    int16_t intern(const char* s, size_t len);
+    void release(int16_t id);
+    bool reserve(size_t bytes);
+    void compact();
+    bool evictOne();
+
+    int16_t allocEntry();
+    void removeEntry(int16_t slot);
+    void lruUnlink(int16_t slot);
+    void lruPushFront(int16_t slot);
+    // False when s could not be stored; changed says whether field moved
+    bool replace(int16_t& field, const char* s, bool& changed);
+    Change reject();
+    int positionOf(int16_t slot) const;
+    int16_t slotAt(int position) const;
+    const char* str(int16_t id) const { return _arena + _strings[id].offset; }
+
+    Entry _entries[AGENT_DIR_CAPACITY];
+    int16_t _order[AGENT_DIR_CAPACITY];   // Display order -> entry slot
+    uint16_t _count;
+    int16_t _freeEntry;
+    int16_t _lruHead;                     // Most recently used
+    int16_t _lruTail;                     // Eviction candidate
+
+    StringRec _strings[AGENT_DIR_STRINGS];
+    int16_t _buckets[AGENT_DIR_BUCKETS];
+    int16_t _freeString;
+    uint16_t _stringCount;
+
+    char _arena[AGENT_DIR_ARENA_BYTES];
+    uint16_t _arenaUsed;                  // Bump pointer
+    uint16_t _arenaLive;                  // Bytes still referenced
+
+    uint16_t _pass;
+    PassStats _stats;
+};
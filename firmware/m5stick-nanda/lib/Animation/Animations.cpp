@@ -0,0 +1,329 @@
+#include "Animations.h"
+
+#include <string.h>
+
+const uint16_t AMIN_ARPEGGIO[] = {220, 262, 330, 440, 330, 262, 220};
+const int ARPEGGIO_LEN = 7;
+
+static const char* BRAND = "SuprPosition";
+static const uint16_t FLY_COLORS[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_WHITE};
+
+// Bursts and voxels of whichever animation is playing
+static ParticleSystem particles;
+
+// Solid fills go straight into the frame buffer when there is one
+static void fill(LovyanGFX& gfx, Timeline& timeline, int x, int y, int w, int h, uint16_t color) {
+    const PixelSurface& surface = timeline.surface();
+    if (surface.pixels) {
+        fillSurface(surface, x, y, w, h, color);
+    } else {
+        gfx.fillRect(x, y, w, h, color);
+    }
+}
+
+static void fillScreen(LovyanGFX& gfx, Timeline& timeline, uint16_t color) {
+    fill(gfx, timeline, 0, 0, gfx.width(), gfx.height(), color);
+}
+
+// Still squares scattered over an area, drawn at once
+static void drawVoxels(LovyanGFX& gfx, Timeline& timeline, int count, int x0, int x1, int y0, int y1,
+                       int minSize, int maxSize) {
+    particles.clear();
+    for (int i = 0; i < count; i++) {
+        int x = timeline.random(x0, x1);
+        int y = timeline.random(y0, y1);
+        int size = timeline.random(minSize, maxSize);
+        uint16_t color = (timeline.random(0, 2) == 0) ? TFT_CYAN : TFT_MAGENTA;
+        particles.spawn(x, y, 0, 0, size, color, 0, 0);
+    }
+    particles.draw(gfx, timeline.surface(), 0);
+}
+
+// ============================================================================
+// Startup
+// ============================================================================
+
+#define STARTUP_WAVES 3
+#define STARTUP_WAVE_MS 100
+#define STARTUP_PARTICLE_MS 400    // Life of a burst particle, fading out
+#define STARTUP_PARTICLE_SPEED 90  // Max px/s along each axis
+#define STARTUP_WIPE_AT (STARTUP_WAVES * STARTUP_WAVE_MS)
+#define STARTUP_WIPE_COLUMN 4
+#define STARTUP_WIPE_MS 8
+#define STARTUP_FLY_AT (STARTUP_WIPE_AT + (240 / STARTUP_WIPE_COLUMN) * STARTUP_WIPE_MS)
+#define STARTUP_FLY_FROM -120
+#define STARTUP_FLY_TO 60
+#define STARTUP_FLY_STEP 8
+#define STARTUP_FLY_MS 25
+#define STARTUP_FLY_STEPS ((STARTUP_FLY_TO - STARTUP_FLY_FROM) / STARTUP_FLY_STEP + 1)
+#define STARTUP_LOGO_AT (STARTUP_FLY_AT + STARTUP_FLY_STEPS * STARTUP_FLY_MS)
+#define STARTUP_TAGLINE_AT (STARTUP_LOGO_AT + 300)
+#define STARTUP_HOLD_MS 1000
+
+// Wild color particle explosion: each wave adds 50 particles...
+static void startupBurst(LovyanGFX& gfx, Timeline& timeline, int wave) {
+    (void)gfx;
+    static const uint16_t wildColors[] = {
+        TFT_RED, TFT_ORANGE, TFT_YELLOW, TFT_GREEN,
+        TFT_CYAN, TFT_BLUE, TFT_MAGENTA, TFT_WHITE
+    };
+    if (wave == 0) particles.clear();
+    for (int i = 0; i < 50; i++) {
+        int x = timeline.random(0, 240);
+        int y = timeline.random(0, 135);
+        int size = timeline.random(3, 12);
+        int vx = timeline.random(-STARTUP_PARTICLE_SPEED, STARTUP_PARTICLE_SPEED + 1);
+        int vy = timeline.random(-STARTUP_PARTICLE_SPEED, STARTUP_PARTICLE_SPEED + 1);
+        particles.spawn(x, y, vx, vy, size, wildColors[timeline.random(0, 8)], timeline.now(), STARTUP_PARTICLE_MS);
+    }
+}
+
+// ...that drift and fade on black, redrawn every frame
+static void startupExplosion(LovyanGFX& gfx, Timeline& timeline, uint32_t ms) {
+    (void)ms;
+    fillScreen(gfx, timeline, TFT_BLACK);
+    particles.draw(gfx, timeline.surface(), timeline.now());
+}
+
+// Clear with scanline wipe
+static void startupWipe(LovyanGFX& gfx, Timeline& timeline, int step) {
+    fill(gfx, timeline, step * STARTUP_WIPE_COLUMN, 0, STARTUP_WIPE_COLUMN, 135, TFT_BLACK);
+}
+
+// SuprPosition fly-in from left with trail effect
+static void startupFly(LovyanGFX& gfx, Timeline& timeline, int step) {
+    int frame = STARTUP_FLY_FROM + step * STARTUP_FLY_STEP;
+    gfx.setTextSize(2);
+
+    // Draw trailing ghost
+    if (frame > -100) {
+        gfx.setTextColor(TFT_BLUE);
+        gfx.setCursor(frame - 20, 55);
+        gfx.print(BRAND);
+    }
+
+    // Draw main text
+    gfx.setTextColor(FLY_COLORS[(frame / STARTUP_FLY_STEP % 4 + 4) % 4]);
+    gfx.setCursor(frame, 55);
+    gfx.print(BRAND);
+
+    // Clear trail
+    if (frame > -100) {
+        fill(gfx, timeline, frame - 40, 50, 20, 30, TFT_BLACK);
+    }
+}
+
+// Final position with glow
+static void startupLogo(LovyanGFX& gfx, Timeline& timeline, int step) {
+    (void)step;
+    fillScreen(gfx, timeline, TFT_BLACK);
+
+    // Draw voxel border
+    drawVoxels(gfx, timeline, 30, 0, 240, 0, 135, 2, 6);
+
+    // Glow effect
+    gfx.setTextColor(TFT_BLUE);
+    gfx.setTextSize(2);
+    gfx.setCursor(32, 56);
+    gfx.print(BRAND);
+    gfx.setCursor(28, 54);
+    gfx.print(BRAND);
+
+    // Main text
+    gfx.setTextColor(TFT_WHITE);
+    gfx.setCursor(30, 55);
+    gfx.print(BRAND);
+}
+
+static void startupTagline(LovyanGFX& gfx, Timeline& timeline, int step) {
+    (void)timeline;
+    (void)step;
+    gfx.setTextColor(TFT_GREEN);
+    gfx.setTextSize(1);
+    gfx.setCursor(70, 90);
+    gfx.print("NANDA IoT");
+}
+
+void buildStartupAnimation(Timeline& timeline) {
+    timeline.clear();
+
+    timeline.track(0, STARTUP_WAVE_MS, STARTUP_WAVES, startupBurst);
+    timeline.effect(0, STARTUP_WIPE_AT, startupExplosion);
+    for (int wave = 0; wave < STARTUP_WAVES && wave < ARPEGGIO_LEN; wave++) {
+        timeline.cue(wave * STARTUP_WAVE_MS, AMIN_ARPEGGIO[wave], 80);
+    }
+
+    int columns = 240 / STARTUP_WIPE_COLUMN;
+    timeline.track(STARTUP_WIPE_AT, STARTUP_WIPE_MS, columns, startupWipe);
+    for (int step = 0; step < columns; step++) {
+        int x = step * STARTUP_WIPE_COLUMN;
+        if (x % 20 == 0 && x / 20 < ARPEGGIO_LEN) {
+            timeline.cue(STARTUP_WIPE_AT + step * STARTUP_WIPE_MS, AMIN_ARPEGGIO[x / 20], 60);
+        }
+    }
+
+    // Arpeggio during fly-in
+    timeline.track(STARTUP_FLY_AT, STARTUP_FLY_MS, STARTUP_FLY_STEPS, startupFly);
+    for (int step = 0; step < STARTUP_FLY_STEPS; step++) {
+        int frame = STARTUP_FLY_FROM + step * STARTUP_FLY_STEP;
+        int noteIdx = (frame - STARTUP_FLY_FROM) / 30;
+        if (noteIdx < ARPEGGIO_LEN && frame % 30 == 0) {
+            timeline.cue(STARTUP_FLY_AT + step * STARTUP_FLY_MS, AMIN_ARPEGGIO[noteIdx], 70);
+        }
+    }
+
+    // Final chord - A minor (A, C, E played together as sequence)
+    timeline.track(STARTUP_LOGO_AT, 0, 1, startupLogo);
+    timeline.cue(STARTUP_LOGO_AT, 220, 100);
+    timeline.cue(STARTUP_LOGO_AT + 50, 262, 100);
+    timeline.cue(STARTUP_LOGO_AT + 100, 330, 150);
+
+    timeline.track(STARTUP_TAGLINE_AT, 0, 1, startupTagline);
+    timeline.hold(STARTUP_TAGLINE_AT + STARTUP_HOLD_MS);
+}
+
+// ============================================================================
+// Incoming message
+// ============================================================================
+
+#define MESSAGE_WAVES 2
+#define MESSAGE_WAVE_MS 50
+#define MESSAGE_PARTICLE_MS 250
+#define MESSAGE_PARTICLE_SPEED 120
+#define MESSAGE_WIPE_AT (MESSAGE_WAVES * MESSAGE_WAVE_MS)
+#define MESSAGE_WIPE_COLUMN 8
+#define MESSAGE_WIPE_MS 3
+#define MESSAGE_FLY_AT (MESSAGE_WIPE_AT + (240 / MESSAGE_WIPE_COLUMN) * MESSAGE_WIPE_MS)
+#define MESSAGE_FLY_FROM -100
+#define MESSAGE_FLY_TO 55
+#define MESSAGE_FLY_STEP 15
+#define MESSAGE_FLY_MS 15
+#define MESSAGE_FLY_STEPS ((MESSAGE_FLY_TO - MESSAGE_FLY_FROM) / MESSAGE_FLY_STEP + 1)
+#define MESSAGE_FLASH_AT (MESSAGE_FLY_AT + MESSAGE_FLY_STEPS * MESSAGE_FLY_MS)
+#define MESSAGE_SHOW_AT (MESSAGE_FLASH_AT + 30)
+#define MESSAGE_LINE_CHARS 10
+
+// Wild color particle burst...
+static void messageBurst(LovyanGFX& gfx, Timeline& timeline, int wave) {
+    (void)gfx;
+    static const uint16_t wildColors[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_GREEN, TFT_WHITE};
+    if (wave == 0) particles.clear();
+    for (int i = 0; i < 30; i++) {
+        int x = timeline.random(0, 240);
+        int y = timeline.random(0, 135);
+        int size = timeline.random(2, 8);
+        int vx = timeline.random(-MESSAGE_PARTICLE_SPEED, MESSAGE_PARTICLE_SPEED + 1);
+        int vy = timeline.random(-MESSAGE_PARTICLE_SPEED, MESSAGE_PARTICLE_SPEED + 1);
+        particles.spawn(x, y, vx, vy, size, wildColors[timeline.random(0, 5)], timeline.now(), MESSAGE_PARTICLE_MS);
+    }
+}
+
+// ...streaking over the current screen until the wipe clears it
+static void messageStreaks(LovyanGFX& gfx, Timeline& timeline, uint32_t ms) {
+    (void)ms;
+    particles.draw(gfx, timeline.surface(), timeline.now());
+}
+
+// Quick scanline wipe
+static void messageWipe(LovyanGFX& gfx, Timeline& timeline, int step) {
+    fill(gfx, timeline, step * MESSAGE_WIPE_COLUMN, 0, MESSAGE_WIPE_COLUMN, 135, TFT_BLACK);
+}
+
+// SuprPosition fly-in (quick version)
+static void messageFly(LovyanGFX& gfx, Timeline& timeline, int step) {
+    int frame = MESSAGE_FLY_FROM + step * MESSAGE_FLY_STEP;
+    gfx.setTextSize(2);
+
+    // Trail
+    if (frame > -80) {
+        gfx.setTextColor(TFT_BLUE);
+        gfx.setCursor(frame - 15, 55);
+        gfx.print(BRAND);
+    }
+    // Main
+    gfx.setTextColor(FLY_COLORS[(frame / MESSAGE_FLY_STEP % 4 + 4) % 4]);
+    gfx.setCursor(frame, 55);
+    gfx.print(BRAND);
+    // Clear trail
+    if (frame > -80) {
+        fill(gfx, timeline, frame - 30, 50, 15, 30, TFT_BLACK);
+    }
+}
+
+static void messageFlash(LovyanGFX& gfx, Timeline& timeline, int step) {
+    (void)step;
+    fillScreen(gfx, timeline, TFT_WHITE);
+}
+
+static void messageShow(LovyanGFX& gfx, Timeline& timeline, int step) {
+    (void)step;
+    fillScreen(gfx, timeline, TFT_BLACK);
+
+    // Draw cyber border
+    gfx.drawRect(0, 0, 240, 135, TFT_CYAN);
+    gfx.drawRect(2, 2, 236, 131, TFT_MAGENTA);
+
+    // Header
+    gfx.setTextColor(TFT_BLACK);
+    fill(gfx, timeline, 5, 5, 230, 18, TFT_CYAN);
+    gfx.setTextSize(1);
+    gfx.setCursor(60, 10);
+    gfx.print(">> INCOMING MSG <<");
+
+    // Message, word-wrapped for the small screen, with a glow
+    gfx.setTextSize(2);
+    const char* remaining = timeline.text();
+    int y = 40;
+    while (*remaining && y < 200) {
+        char line[MESSAGE_LINE_CHARS + 1];
+        size_t lineLen = strnlen(remaining, MESSAGE_LINE_CHARS);
+        memcpy(line, remaining, lineLen);
+        line[lineLen] = '\0';
+        // Glow effect - draw shadow first
+        gfx.setTextColor(TFT_BLUE);
+        gfx.setCursor(11, y + 1);
+        gfx.print(line);
+        // Main text
+        gfx.setTextColor(TFT_WHITE);
+        gfx.setCursor(10, y);
+        gfx.print(line);
+        remaining += lineLen;
+        y += 22;
+    }
+
+    // Add some voxel decorations
+    drawVoxels(gfx, timeline, 15, 5, 130, y + 10, 230, 2, 5);
+}
+
+void buildMessageAnimation(Timeline& timeline, const char* text) {
+    timeline.clear();
+    timeline.setText(text);
+
+    // A minor arpeggio intro
+    timeline.cue(0, AMIN_ARPEGGIO[0], 40);
+    timeline.track(0, MESSAGE_WAVE_MS, MESSAGE_WAVES, messageBurst);
+    timeline.effect(0, MESSAGE_WIPE_AT, messageStreaks);
+    for (int wave = 0; wave < MESSAGE_WAVES && wave < ARPEGGIO_LEN; wave++) {
+        timeline.cue(wave * MESSAGE_WAVE_MS, AMIN_ARPEGGIO[wave], 40);
+    }
+
+    timeline.track(MESSAGE_WIPE_AT, MESSAGE_WIPE_MS, 240 / MESSAGE_WIPE_COLUMN, messageWipe);
+
+    // Arpeggio notes
+    timeline.track(MESSAGE_FLY_AT, MESSAGE_FLY_MS, MESSAGE_FLY_STEPS, messageFly);
+    for (int step = 0; step < MESSAGE_FLY_STEPS; step++) {
+        int frame = MESSAGE_FLY_FROM + step * MESSAGE_FLY_STEP;
+        int noteIdx = (frame - MESSAGE_FLY_FROM) / 25;
+        if (noteIdx < ARPEGGIO_LEN && frame % 25 == 0) {
+            timeline.cue(MESSAGE_FLY_AT + step * MESSAGE_FLY_MS, AMIN_ARPEGGIO[noteIdx], 50);
+        }
+    }
+
+    // Final flash, then the message and a confirmation sound
+    timeline.track(MESSAGE_FLASH_AT, 0, 1, messageFlash);
+    timeline.cue(MESSAGE_FLASH_AT, 440, 60);
+    timeline.track(MESSAGE_SHOW_AT, 0, 1, messageShow);
+    timeline.cue(MESSAGE_SHOW_AT, 330, 50);
+    timeline.cue(MESSAGE_SHOW_AT, 1200, 50);
+    timeline.cue(MESSAGE_SHOW_AT + 60, 1800, 50);
+}
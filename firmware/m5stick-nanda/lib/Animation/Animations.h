@@ -0,0 +1,23 @@
+/**
+ * The firmware's animations, as timelines.
+ *
+ * Both start from the picture already on screen: the startup splash
+ * clears it, the message animation bursts over it. Neither blocks; load
+ * one into a Timeline, start() it and advance() it from loop().
+ */
+
+#pragma once
+
+#include "Timeline.h"
+
+// A minor diatonic arpeggio (A3, C4, E4, A4, E4, C4, A3)
+extern const uint16_t AMIN_ARPEGGIO[];
+extern const int ARPEGGIO_LEN;
+
+// Particle explosion, scanline wipe, "SuprPosition" fly-in, then the
+// logo with the tagline held for a second (about 2.7 s)
+void buildStartupAnimation(Timeline& timeline);
+
+// Particle burst, quick wipe and fly-in, a flash, then `text` word-wrapped
+// in a cyber frame (about 0.45 s); the text stays until the next redraw
+void buildMessageAnimation(Timeline& timeline, const char* text);
@@ -0,0 +1,151 @@
+#include "Timeline.h"
+
+#include <string.h>
+
+void Timeline::clear() {
+    _trackCount = 0;
+    _effectCount = 0;
+    _cueCount = 0;
+    _length = 0;
+    _running = false;
+    _text[0] = '\0';
+}
+
+bool Timeline::track(uint32_t at, uint32_t interval, uint16_t steps, TrackStep draw) {
+    if (_trackCount >= TIMELINE_MAX_TRACKS || steps == 0) return false;
+    _tracks[_trackCount++] = {at, interval, steps, 0, draw};
+    hold(at + (uint32_t)(steps - 1) * interval);
+    return true;
+}
+
+bool Timeline::effect(uint32_t at, uint32_t duration, EffectFrame draw) {
+    if (_effectCount >= TIMELINE_MAX_EFFECTS) return false;
+    _effects[_effectCount++] = {at, duration, false, draw};
+    hold(at + duration);
+    return true;
+}
+
+bool Timeline::cue(uint32_t at, uint16_t frequency, uint16_t durationMs) {
+    if (_cueCount >= TIMELINE_MAX_CUES) return false;
+    // Insertion keeps them in time order; equal times play in the order added
+    int i = _cueCount++;
+    while (i > 0 && _cues[i - 1].at > at) {
+        _cues[i] = _cues[i - 1];
+        i--;
+    }
+    _cues[i] = {at, frequency, durationMs};
+    hold(at);
+    return true;
+}
+
+void Timeline::hold(uint32_t at) {
+    if (at > _length) _length = at;
+}
+
+void Timeline::setText(const char* text) {
+    strncpy(_text, text ? text : "", sizeof(_text) - 1);
+    _text[sizeof(_text) - 1] = '\0';
+}
+
+void Timeline::start(uint32_t now, uint32_t seed) {
+    for (int i = 0; i < _trackCount; i++) {
+        _tracks[i].done = 0;
+    }
+    for (int i = 0; i < _effectCount; i++) {
+        _effects[i].done = false;
+    }
+    _nextCue = 0;
+    _rng = seed ? seed : 1;
+    _start = now;
+    _lastFrame = now - _frameMs;   // The first frame is due at once
+    _frames = 0;
+    _running = true;
+}
+
+int Timeline::random(int low, int high) {
+    if (high <= low) return low;
+    // xorshift32: only needs to look random, and to repeat for a seed
+    _rng ^= _rng << 13;
+    _rng ^= _rng >> 17;
+    _rng ^= _rng << 5;
+    return low + (int)(_rng % (uint32_t)(high - low));
+}
+
+bool Timeline::advance(LovyanGFX& gfx, uint32_t now) {
+    if (!_running || now - _lastFrame < _frameMs) return false;
+    _lastFrame = now;
+    uint32_t elapsed = now - _start;
+    uint32_t effectsDrawn = 0;   // One frame per effect per advance()
+    bool drew = false;
+
+    for (;;) {
+        // The earliest step still to draw
+        int next = -1;
+        uint32_t when = UINT32_MAX;
+        for (int i = 0; i < _trackCount; i++) {
+            const Track& t = _tracks[i];
+            if (t.done >= t.steps) continue;
+            uint32_t at = t.at + (uint32_t)t.done * t.interval;
+            if (at < when) {
+                when = at;
+                next = i;
+            }
+        }
+        bool stepDue = next >= 0 && when <= elapsed;
+
+        // The earliest effect frame: now, or its last one if that has passed
+        int effect = -1;
+        uint32_t effectWhen = UINT32_MAX;
+        bool effectLast = false;
+        for (int i = 0; i < _effectCount; i++) {
+            const Effect& e = _effects[i];
+            if (e.done || (effectsDrawn & (1u << i)) || e.at > elapsed) continue;
+            uint32_t end = e.at + e.duration;
+            uint32_t at = elapsed >= end ? end : elapsed;
+            if (at < effectWhen) {
+                effectWhen = at;
+                effect = i;
+                effectLast = at == end;
+            }
+        }
+
+        // Cues due no later than the next drawing go first
+        if (_nextCue < _cueCount && _cues[_nextCue].at <= elapsed && _cues[_nextCue].at <= when &&
+            _cues[_nextCue].at <= effectWhen) {
+            const Cue& c = _cues[_nextCue++];
+            if (_player) _player(c.frequency, c.durationMs);
+            continue;
+        }
+
+        // An effect's last frame comes before steps at the same time, so a
+        // wipe starting as a burst ends draws over it; other frames come after
+        if (effect >= 0 && (!stepDue || effectWhen < when || (effectWhen == when && effectLast))) {
+            Effect& e = _effects[effect];
+            _now = effectWhen;
+            e.draw(gfx, *this, effectWhen - e.at);
+            e.done = effectLast;
+            effectsDrawn |= 1u << effect;
+            drew = true;
+            continue;
+        }
+        if (!stepDue) break;
+
+        Track& t = _tracks[next];
+        _now = when;
+        t.draw(gfx, *this, t.done++);
+        drew = true;
+    }
+
+    if (drew) _frames++;
+    bool finished = _nextCue >= _cueCount && elapsed >= _length;
+    for (int i = 0; i < _trackCount; i++) {
+        finished = finished && _tracks[i].done >= _tracks[i].steps;
+    }
+    for (int i = 0; i < _effectCount; i++) {
+        finished = finished && _effects[i].done;
+    }
+    if (finished) {
+        _running = false;
+    }
+    return drew;
+}
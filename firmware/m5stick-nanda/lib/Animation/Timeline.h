@@ -0,0 +1,123 @@
+/**
+ * Keyframed animation, advanced from loop() instead of delay() chains.
+ *
+ * A timeline is a set of tracks and audio cues on one millisecond clock.
+ * A track is a run of steps at a fixed interval (a particle burst, one
+ * column of a scanline wipe, one position of a fly-in); each step draws
+ * on top of what is already in the back buffer. An effect is drawn on
+ * every frame of its span with the time into it (moving particles), and
+ * once more at its end. A cue plays a tone.
+ *
+ * advance() is called every pass of loop(). At most once per frame
+ * interval it runs, in time order, every step and cue that has come due
+ * since the last frame and reports whether anything was drawn, so the
+ * caller presents one frame. A late frame catches up by running the
+ * missed steps, which keeps the sound in time with the picture and makes
+ * the final image independent of the frame rate.
+ *
+ * The random numbers come from a seeded generator, so the same seed
+ * draws the same animation on the device and on the host.
+ *
+ * Threading: build, start and advance from one task (loop()).
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdint.h>
+
+#include <Particles.h>
+
+#define TIMELINE_MAX_TRACKS 12
+#define TIMELINE_MAX_EFFECTS 4
+#define TIMELINE_MAX_CUES 32
+#define TIMELINE_TEXT_MAX 96      // Text shown by the message animation
+#ifndef ANIMATION_FRAME_MS
+#define ANIMATION_FRAME_MS 20     // 50 fps; a full-panel push takes about 13 ms
+#endif
+
+class Timeline;
+
+typedef void (*TrackStep)(LovyanGFX& gfx, Timeline& timeline, int step);
+typedef void (*EffectFrame)(LovyanGFX& gfx, Timeline& timeline, uint32_t ms);
+typedef void (*CuePlayer)(uint16_t frequency, uint16_t durationMs);
+
+class Timeline {
+public:
+    explicit Timeline(uint32_t frameMs = ANIMATION_FRAME_MS)
+        : _frameMs(frameMs), _player(nullptr), _surface{nullptr, 0, 0}, _trackCount(0), _effectCount(0),
+          _cueCount(0), _length(0), _running(false), _start(0), _lastFrame(0), _now(0), _nextCue(0),
+          _rng(1), _frames(0) {
+        _text[0] = '\0';
+    }
+
+    // Building: replaces whatever was playing
+    void clear();
+    // `steps` calls of draw(), the first at `at` ms, then every `interval` ms
+    bool track(uint32_t at, uint32_t interval, uint16_t steps, TrackStep draw);
+    // draw() on every frame from `at` to `at + duration` ms, ending with ms == duration
+    bool effect(uint32_t at, uint32_t duration, EffectFrame draw);
+    bool cue(uint32_t at, uint16_t frequency, uint16_t durationMs);
+    // Keep running (showing the last frame) until `at` ms
+    void hold(uint32_t at);
+    void setText(const char* text);
+
+    void onCue(CuePlayer player) { _player = player; }
+    // Pixels behind the target passed to advance(), for particle effects
+    void setSurface(const PixelSurface& surface) { _surface = surface; }
+    void start(uint32_t now, uint32_t seed);
+    void stop() { _running = false; }
+
+    // Run what is due by `now`; true if a frame was drawn and should be shown
+    bool advance(LovyanGFX& gfx, uint32_t now);
+
+    bool running() const { return _running; }
+    uint32_t length() const { return _length; }
+    uint32_t frames() const { return _frames; }
+
+    // For track steps and effects
+    int random(int low, int high);
+    const char* text() const { return _text; }
+    const PixelSurface& surface() const { return _surface; }
+    // Time since start() of the step or effect frame being drawn
+    uint32_t now() const { return _now; }
+
+private:
+    struct Track {
+        uint32_t at;
+        uint32_t interval;
+        uint16_t steps;
+        uint16_t done;       // Steps drawn so far
+        TrackStep draw;
+    };
+    struct Effect {
+        uint32_t at;
+        uint32_t duration;
+        bool done;
+        EffectFrame draw;
+    };
+    struct Cue {
+        uint32_t at;
+        uint16_t frequency;
+        uint16_t durationMs;
+    };
+
+    uint32_t _frameMs;
+    CuePlayer _player;
+    PixelSurface _surface;
+    Track _tracks[TIMELINE_MAX_TRACKS];
+    int _trackCount;
+    Effect _effects[TIMELINE_MAX_EFFECTS];
+    int _effectCount;
+    Cue _cues[TIMELINE_MAX_CUES];     // Sorted by time
+    int _cueCount;
+    uint32_t _length;
+    bool _running;
+    uint32_t _start;
+    uint32_t _lastFrame;
+    uint32_t _now;
+    int _nextCue;
+    uint32_t _rng;
+    uint32_t _frames;
+    char _text[TIMELINE_TEXT_MAX];
+};
@@ -0,0 +1,50 @@
+#include "BodyAssembler.h"
+
+#include <new>
+#include <stdlib.h>
+#include <string.h>
+
+BodyAssembler* BodyAssembler::create(size_t total, size_t maxSize) {
+    if (total > maxSize) return nullptr;
+    void* block = malloc(sizeof(BodyAssembler) + total + 1);
+    if (!block) return nullptr;
+    char* buffer = (char*)block + sizeof(BodyAssembler);
+    return new (block) BodyAssembler(buffer, total + 1);
+}
+
+BodyAssembler::BodyAssembler(char* buffer, size_t capacity)
+    : _buf(buffer), _capacity(capacity) {
+    reset();
+}
+
+void BodyAssembler::reset() {
+    _total = 0;
+    _received = 0;
+    _complete = false;
+    _failed = false;
+    if (_capacity) _buf[0] = '\0';
+}
+
+BodyAssembler::Result BodyAssembler::feed(const uint8_t* data, size_t len, size_t index, size_t total) {
+    if (index == 0) {
+        reset();
+        _total = total;
+    }
+    if (_failed || _complete) return INVALID;
+    if (total + 1 > _capacity) {
+        _failed = true;
+        return TOO_LARGE;
+    }
+    if (index != _received || total != _total || len > total - index) {
+        _failed = true;
+        return INVALID;
+    }
+
+    memcpy(_buf + _received, data, len);
+    _received += len;
+    if (_received < _total) return PENDING;
+
+    _buf[_received] = '\0';
+    _complete = true;
+    return COMPLETE;
+}
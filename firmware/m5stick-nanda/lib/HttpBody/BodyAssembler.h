@@ -0,0 +1,53 @@
+/**
+ * Reassembles a request body delivered in segments.
+ *
+ * HttpServer calls the body handler once per TCP segment with
+ * (data, len, index, total). The assembler copies each segment once into
+ * a buffer sized for the announced total (bounded by the caller's limit),
+ * checks that segments arrive contiguously, and reports COMPLETE exactly
+ * when index + len == total, with the body NUL-terminated for parsing.
+ *
+ * create() allocates header and buffer as one malloc() block so it can
+ * live in HttpRequest::tempObject, which the server free()s.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef BODY_MAX_SIZE
+#define BODY_MAX_SIZE 4096
+#endif
+
+class BodyAssembler {
+public:
+    enum Result {
+        PENDING = 0,   // More segments to come
+        COMPLETE,      // Whole body received
+        TOO_LARGE,     // Announced total exceeds the limit
+        INVALID        // Gap, overlap or overrun between segments
+    };
+
+    // Heap block holding the assembler and a total-byte buffer, or nullptr
+    // when total exceeds maxSize or memory is short. Release with free().
+    static BodyAssembler* create(size_t total, size_t maxSize = BODY_MAX_SIZE);
+
+    // Assembler over caller-owned storage (capacity includes the NUL)
+    BodyAssembler(char* buffer, size_t capacity);
+
+    Result feed(const uint8_t* data, size_t len, size_t index, size_t total);
+    void reset();
+
+    const char* data() const { return _buf; }
+    size_t length() const { return _received; }
+    bool complete() const { return _complete; }
+
+private:
+    char* _buf;
+    size_t _capacity;
+    size_t _total;
+    size_t _received;
+    bool _complete;
+    bool _failed;
+};
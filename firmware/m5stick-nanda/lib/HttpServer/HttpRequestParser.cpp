@@ -0,0 +1,386 @@
+#include "HttpRequestParser.h"
+
+#include <string.h>
+#include <strings.h>
+
+static const struct {
+    const char* name;
+    uint8_t len;
+    uint8_t bit;
+} METHODS[] = {
+    {"GET", 3, HTTP_METHOD_GET}, {"POST", 4, HTTP_METHOD_POST}, {"DELETE", 6, HTTP_METHOD_DELETE},
+    {"PUT", 3, HTTP_METHOD_PUT}, {"PATCH", 5, HTTP_METHOD_PATCH}, {"HEAD", 4, HTTP_METHOD_HEAD},
+    {"OPTIONS", 7, HTTP_METHOD_OPTIONS}
+};
+
+uint8_t httpMethod(const char* name, size_t len) {
+    for (size_t i = 0; i < sizeof(METHODS) / sizeof(METHODS[0]); i++) {
+        if (METHODS[i].len == len && memcmp(METHODS[i].name, name, len) == 0) return METHODS[i].bit;
+    }
+    return 0;
+}
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    c |= 0x20;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// RFC 9110 tchar
+static bool isTokenChar(uint8_t c) {
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')) return true;
+    return c && strchr("!#$%&'*+-.^_`|~", c) != nullptr;
+}
+
+// The next character of a query component, with %XX and '+' decoded. A
+// malformed escape is taken as it is, as browsers do.
+static char nextDecoded(const char* s, size_t len, size_t& i) {
+    char c = s[i++];
+    if (c == '+') return ' ';
+    if (c == '%' && len - i >= 2) {
+        int hi = hexValue(s[i]);
+        int lo = hexValue(s[i + 1]);
+        if (hi >= 0 && lo >= 0) {
+            i += 2;
+            return (char)(hi << 4 | lo);
+        }
+    }
+    return c;
+}
+
+// Whether the raw component s[0, len) decodes to name
+static bool decodesTo(const char* s, size_t len, const char* name) {
+    size_t i = 0;
+    while (i < len) {
+        if (*name == '\0' || nextDecoded(s, len, i) != *name++) return false;
+    }
+    return *name == '\0';
+}
+
+HttpRequestParser::HttpRequestParser(char* arena, size_t size, const char* const* keep)
+    : _arena(arena), _size(size > 0xFFFF ? 0xFFFF : size), _keep(keep) {
+    reset();
+}
+
+void HttpRequestParser::reset() {
+    _len = 0;
+    _state = METHOD;
+    _error = 0;
+    _headBytes = 0;
+    _tokenLen = 0;
+    _method = 0;
+    _minor = 0;
+    _queryStart = -1;
+    _path = {0, 0};
+    _query = {0, 0};
+    _nameStart = 0;
+    _valueStart = 0;
+    _known = OTHER;
+    _keeping = false;
+    _contentLength = 0;
+    _hasLength = false;
+    _expectContinue = false;
+    _connection = 0;
+    _headerCount = 0;
+    if (_size) _arena[0] = '\0';
+}
+
+HttpRequestParser::Result HttpRequestParser::fail(int status) {
+    _error = status;
+    _state = FAILED;
+    return ERROR;
+}
+
+bool HttpRequestParser::push(char c) {
+    if (_len >= _size) return false;
+    _arena[_len++] = c;
+    return true;
+}
+
+HttpRequestParser::Result HttpRequestParser::feed(const uint8_t* data, size_t len, size_t& used) {
+    used = 0;
+    if (_state == COMPLETE) return HEAD;
+    if (_state == FAILED) return ERROR;
+
+    Result r = NEED_MORE;
+    size_t i = 0;
+    while (r == NEED_MORE && i < len) {
+        uint8_t c = data[i++];
+        switch (_state) {
+            case METHOD:
+                if (c == ' ') {
+                    _method = _tokenLen ? httpMethod(_token, _tokenLen) : 0;
+                    if (!_method) {
+                        r = fail(_tokenLen ? 501 : 400);
+                    } else {
+                        _state = TARGET;
+                    }
+                } else if ((c == '\r' || c == '\n') && _tokenLen == 0) {
+                    // Blank lines before a request line are allowed
+                } else if (c >= 'A' && c <= 'Z') {
+                    if (_tokenLen == sizeof(_token) - 1) {
+                        r = fail(501);
+                    } else {
+                        _token[_tokenLen++] = (char)c;
+                    }
+                } else {
+                    r = fail(400);
+                }
+                break;
+
+            case TARGET:
+                if (c == ' ') {
+                    r = endTarget();
+                } else if (c < 0x21 || c == 0x7F || (_len == 0 && c != '/')) {
+                    r = fail(400);
+                } else {
+                    if (c == '?' && _queryStart < 0) _queryStart = (int32_t)_len;
+                    if (!push((char)c)) r = fail(414);
+                }
+                break;
+
+            case VERSION:
+                if (c == '\n') {
+                    r = endVersion();
+                } else if (c != '\r') {
+                    if (_tokenLen == sizeof(_token) - 1) {
+                        r = fail(400);
+                    } else {
+                        _token[_tokenLen++] = (char)c;
+                    }
+                }
+                break;
+
+            case HEADER_START:
+                if (c == '\n') {
+                    _state = COMPLETE;
+                    r = HEAD;
+                } else if (c == ' ' || c == '\t') {
+                    r = fail(400);   // Folded header lines are obsolete
+                } else if (c != '\r') {
+                    _nameStart = (uint16_t)_len;
+                    _state = HEADER_NAME;
+                    i--;
+                }
+                break;
+
+            case HEADER_NAME:
+                if (c == ':') {
+                    r = endName();
+                } else if (!isTokenChar(c)) {
+                    r = fail(400);
+                } else if (!push((char)c)) {
+                    r = fail(431);
+                }
+                break;
+
+            case HEADER_SPACE:
+                if (c != ' ' && c != '\t') {
+                    _state = HEADER_VALUE;
+                    i--;
+                }
+                break;
+
+            case HEADER_VALUE: {
+                // The rest of the line in one copy
+                const uint8_t* start = data + i - 1;
+                const uint8_t* nl = (const uint8_t*)memchr(start, '\n', len - (i - 1));
+                size_t n = (nl ? nl : data + len) - start;
+                if (_len + n > _size) {
+                    r = fail(431);
+                    break;
+                }
+                memcpy(_arena + _len, start, n);
+                _len += n;
+                i = start - data + n;
+                if (nl) {
+                    i++;
+                    r = endValue();
+                }
+                break;
+            }
+
+            case HEADER_SKIP: {
+                const uint8_t* nl = (const uint8_t*)memchr(data + i - 1, '\n', len - (i - 1));
+                if (nl) {
+                    i = nl - data + 1;
+                    _state = HEADER_START;
+                } else {
+                    i = len;
+                }
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+
+    used = i;
+    _headBytes += i;
+    if (r != ERROR && _headBytes > HTTP_HEAD_LIMIT) r = fail(_state <= TARGET ? 414 : 431);
+    return r;
+}
+
+HttpRequestParser::Result HttpRequestParser::endTarget() {
+    if (_len == 0) return fail(400);
+    size_t end = _len;
+    if (!push('\0')) return fail(414);
+
+    size_t pathEnd = end;
+    if (_queryStart >= 0) {
+        pathEnd = (size_t)_queryStart;
+        _arena[pathEnd] = '\0';
+        _query = {(uint16_t)(pathEnd + 1), (uint16_t)(end - pathEnd - 1)};
+    } else {
+        _query = {(uint16_t)end, 0};   // The terminator: ""
+    }
+
+    // Decoding only shrinks the path, so it is done in place
+    size_t n = 0;
+    for (size_t i = 0; i < pathEnd; i++) {
+        char c = _arena[i];
+        if (c == '%') {
+            if (pathEnd - i < 3) return fail(400);
+            int hi = hexValue(_arena[i + 1]);
+            int lo = hexValue(_arena[i + 2]);
+            if (hi < 0 || lo < 0 || (hi | lo) == 0) return fail(400);   // %00 would cut the path short
+            c = (char)(hi << 4 | lo);
+            i += 2;
+        }
+        _arena[n++] = c;
+    }
+    _arena[n] = '\0';
+    _path = {0, (uint16_t)n};
+
+    _tokenLen = 0;
+    _state = VERSION;
+    return NEED_MORE;
+}
+
+HttpRequestParser::Result HttpRequestParser::endVersion() {
+    if (_tokenLen == 8 && memcmp(_token, "HTTP/1.", 7) == 0 && _token[7] >= '0' && _token[7] <= '9') {
+        // A later 1.x is answered as 1.1
+        _minor = _token[7] == '0' ? 0 : 1;
+        _state = HEADER_START;
+        return NEED_MORE;
+    }
+    if (_tokenLen >= 5 && memcmp(_token, "HTTP/", 5) == 0) return fail(505);
+    return fail(400);
+}
+
+HttpRequestParser::Result HttpRequestParser::endName() {
+    if (_len == _nameStart) return fail(400);
+    if (!push('\0')) return fail(431);
+    const char* name = _arena + _nameStart;
+
+    if (strcasecmp(name, "Content-Length") == 0) {
+        _known = CONTENT_LENGTH;
+    } else if (strcasecmp(name, "Transfer-Encoding") == 0) {
+        _known = TRANSFER_ENCODING;
+    } else if (strcasecmp(name, "Expect") == 0) {
+        _known = EXPECT;
+    } else if (strcasecmp(name, "Connection") == 0) {
+        _known = CONNECTION;
+    } else {
+        _known = OTHER;
+    }
+
+    _keeping = _keep == nullptr;
+    for (const char* const* k = _keep; k && *k && !_keeping; k++) {
+        _keeping = strcasecmp(*k, name) == 0;
+    }
+
+    if (!_keeping && _known == OTHER) {
+        _len = _nameStart;
+        _state = HEADER_SKIP;
+    } else {
+        _valueStart = (uint16_t)_len;
+        _state = HEADER_SPACE;
+    }
+    return NEED_MORE;
+}
+
+HttpRequestParser::Result HttpRequestParser::endValue() {
+    while (_len > _valueStart) {
+        char c = _arena[_len - 1];
+        if (c != '\r' && c != ' ' && c != '\t') break;
+        _len--;
+    }
+    size_t valueLen = _len - _valueStart;
+    if (!push('\0')) return fail(431);
+    const char* value = _arena + _valueStart;
+
+    switch (_known) {
+        case CONTENT_LENGTH: {
+            if (valueLen == 0) return fail(400);
+            size_t n = 0;
+            for (size_t i = 0; i < valueLen; i++) {
+                if (value[i] < '0' || value[i] > '9' || n > 0xFFFFFFFu) return fail(400);
+                n = n * 10 + (value[i] - '0');
+            }
+            if (_hasLength && n != _contentLength) return fail(400);
+            _contentLength = n;
+            _hasLength = true;
+            break;
+        }
+        case TRANSFER_ENCODING:
+            return fail(501);   // Bodies come with a Content-Length
+        case EXPECT:
+            _expectContinue = strcasecmp(value, "100-continue") == 0;
+            break;
+        case CONNECTION:
+            for (const char* p = value; *p;) {
+                while (*p == ' ' || *p == '\t' || *p == ',') p++;
+                size_t n = strcspn(p, ", \t");
+                if (n == 5 && strncasecmp(p, "close", 5) == 0) _connection |= HTTP_CONNECTION_CLOSE;
+                if (n == 10 && strncasecmp(p, "keep-alive", 10) == 0) _connection |= HTTP_CONNECTION_KEEP_ALIVE;
+                if (n == 7 && strncasecmp(p, "upgrade", 7) == 0) _connection |= HTTP_CONNECTION_UPGRADE;
+                p += n;
+            }
+            break;
+        default:
+            break;
+    }
+
+    if (_keeping) {
+        if (_headerCount == HTTP_HEADERS_MAX) return fail(431);
+        Header& h = _headers[_headerCount++];
+        h.name = {_nameStart, (uint16_t)(_valueStart - 1 - _nameStart)};
+        h.value = {_valueStart, (uint16_t)valueLen};
+    } else {
+        _len = _nameStart;
+    }
+    _state = HEADER_START;
+    return NEED_MORE;
+}
+
+const char* HttpRequestParser::header(const char* name) const {
+    for (size_t i = 0; i < _headerCount; i++) {
+        if (strcasecmp(headerName(i), name) == 0) return headerValue(i);
+    }
+    return nullptr;
+}
+
+bool HttpRequestParser::param(const char* name, char* buf, size_t size) const {
+    const char* p = query();
+    while (*p) {
+        size_t len = strcspn(p, "&");
+        const char* eq = (const char*)memchr(p, '=', len);
+        size_t nameLen = eq ? (size_t)(eq - p) : len;
+        if (decodesTo(p, nameLen, name)) {
+            if (size) {
+                const char* value = eq ? eq + 1 : p + len;
+                size_t valueLen = p + len - value;
+                size_t i = 0, n = 0;
+                while (i < valueLen && n + 1 < size) buf[n++] = nextDecoded(value, valueLen, i);
+                buf[n] = '\0';
+            }
+            return true;
+        }
+        p += len;
+        if (*p) p++;
+    }
+    return false;
+}
@@ -0,0 +1,166 @@
+/**
+ * Incremental HTTP/1.1 request parser over a fixed arena.
+ *
+ * Bytes are fed as they arrive, split anywhere. The request target and
+ * the headers worth keeping are copied once into the caller's arena and
+ * NUL-terminated there; the parser only records offset/length views into
+ * it, so a request allocates nothing however it is segmented. Headers
+ * outside the keep list are skipped as they stream past, which is where
+ * most of a browser's request goes (User-Agent, Accept-*, cookies).
+ *
+ * The hop-by-hop headers the server needs (Content-Length,
+ * Transfer-Encoding, Expect, Connection) are read whether kept or not.
+ * feed() stops after the blank line that ends the head and says how much
+ * it used: the body and anything pipelined behind it are the caller's.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef HTTP_HEADERS_MAX
+#define HTTP_HEADERS_MAX 12     // Kept headers per request
+#endif
+#ifndef HTTP_HEAD_LIMIT
+#define HTTP_HEAD_LIMIT 8192    // Request line and every header, kept or not
+#endif
+
+// Same bits as RouteMethod
+enum HttpMethod : uint8_t {
+    HTTP_METHOD_GET = 0x01,
+    HTTP_METHOD_POST = 0x02,
+    HTTP_METHOD_DELETE = 0x04,
+    HTTP_METHOD_PUT = 0x08,
+    HTTP_METHOD_PATCH = 0x10,
+    HTTP_METHOD_HEAD = 0x20,
+    HTTP_METHOD_OPTIONS = 0x40
+};
+
+// Tokens of the Connection header
+enum HttpConnectionToken : uint8_t {
+    HTTP_CONNECTION_CLOSE = 0x01,
+    HTTP_CONNECTION_KEEP_ALIVE = 0x02,
+    HTTP_CONNECTION_UPGRADE = 0x04
+};
+
+// "GET" -> HTTP_METHOD_GET; 0 for anything else (names are case-sensitive)
+uint8_t httpMethod(const char* name, size_t len);
+
+struct HttpView {
+    uint16_t offset;   // Into the arena
+    uint16_t length;
+};
+
+class HttpRequestParser {
+public:
+    enum Result {
+        NEED_MORE = 0,
+        HEAD,       // Request line and headers complete
+        ERROR       // See error() for the status to answer with
+    };
+
+    // keep: header names to store, nullptr-terminated and compared
+    // ignoring case; nullptr stores every header
+    HttpRequestParser(char* arena, size_t size, const char* const* keep = nullptr);
+
+    void keep(const char* const* names) { _keep = names; }
+    void reset();
+
+    // Consume up to len bytes, stopping at the end of the head
+    Result feed(const uint8_t* data, size_t len, size_t& used);
+
+    // 400, 414 (target too long), 431 (headers too large), 501 (method
+    // or Transfer-Encoding not supported) or 505 (not HTTP/1.x)
+    int error() const { return _error; }
+
+    uint8_t method() const { return _method; }
+    bool http11() const { return _minor == 1; }
+    // Percent-decoded, without the query string
+    const char* path() const { return _arena + _path.offset; }
+    size_t pathLength() const { return _path.length; }
+    // As sent, after the '?'; "" when there is none
+    const char* query() const { return _arena + _query.offset; }
+
+    size_t contentLength() const { return _contentLength; }
+    bool expectContinue() const { return _expectContinue; }
+    uint8_t connection() const { return _connection; }   // HttpConnectionToken bits
+
+    size_t headerCount() const { return _headerCount; }
+    const char* headerName(size_t i) const { return _arena + _headers[i].name.offset; }
+    const char* headerValue(size_t i) const { return _arena + _headers[i].value.offset; }
+    // A kept header's value, trimmed; nullptr when absent or not kept
+    const char* header(const char* name) const;
+
+    // A query parameter's value, decoded into buf (truncated to size - 1);
+    // false when the query does not have it
+    bool param(const char* name, char* buf, size_t size) const;
+
+    // Arena bytes this request takes; the rest is free until reset()
+    size_t used() const { return _len; }
+
+private:
+    enum State : uint8_t {
+        METHOD,
+        TARGET,
+        VERSION,
+        HEADER_START,
+        HEADER_NAME,
+        HEADER_SPACE,
+        HEADER_VALUE,
+        HEADER_SKIP,
+        COMPLETE,
+        FAILED
+    };
+
+    // What a header means to the parser
+    enum Known : uint8_t {
+        OTHER = 0,
+        CONTENT_LENGTH,
+        TRANSFER_ENCODING,
+        EXPECT,
+        CONNECTION
+    };
+
+    struct Header {
+        HttpView name;
+        HttpView value;
+    };
+
+    Result fail(int status);
+    bool push(char c);
+    Result endTarget();
+    Result endVersion();
+    Result endName();
+    Result endValue();
+
+    char* _arena;
+    size_t _size;
+    size_t _len;
+    const char* const* _keep;
+
+    State _state;
+    int _error;
+    size_t _headBytes;
+
+    char _token[9];        // Method or version, as they come in
+    uint8_t _tokenLen;
+    uint8_t _method;
+    uint8_t _minor;
+    int32_t _queryStart;   // Arena offset of '?' in the target, -1 if none
+    HttpView _path;
+    HttpView _query;
+
+    uint16_t _nameStart;   // Arena offset of the header being read
+    uint16_t _valueStart;
+    Known _known;
+    bool _keeping;
+
+    size_t _contentLength;
+    bool _hasLength;
+    bool _expectContinue;
+    uint8_t _connection;
+
+    Header _headers[HTTP_HEADERS_MAX];
+    uint8_t _headerCount;
+};
@@ -0,0 +1,594 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "HttpServer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+#include "WebSocketChannel.h"
+
+// Room addHeader() leaves for Content-Length or Transfer-Encoding,
+// Connection, Keep-Alive and the blank line
+#define HEAD_RESERVE 96
+// A chunk is its size in hex and CRLF, the data, and CRLF
+#define CHUNK_PREFIX 6
+
+static const char* reasonPhrase(int code) {
+    switch (code) {
+        case 100: return "Continue";
+        case 101: return "Switching Protocols";
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 304: return "Not Modified";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 408: return "Request Timeout";
+        case 413: return "Payload Too Large";
+        case 414: return "URI Too Long";
+        case 426: return "Upgrade Required";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        case 505: return "HTTP Version Not Supported";
+        default: return "";
+    }
+}
+
+// Whether a comma-separated header value lists token
+static bool listsToken(const char* value, const char* token) {
+    size_t len = strlen(token);
+    for (const char* p = value; p && *p;) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        size_t n = strcspn(p, ", \t");
+        if (n == len && strncasecmp(p, token, len) == 0) return true;
+        p += n;
+    }
+    return false;
+}
+
+// ============================================================================
+// HttpResponse
+// ============================================================================
+
+void HttpResponse::begin(int code, const char* contentType) {
+    _code = code;
+    _headLen = 0;
+    _body = EMPTY;
+    _data = nullptr;
+    _length = 0;
+    _filler = nullptr;
+
+    _headLen = snprintf(_head, sizeof(_head), "HTTP/1.1 %d %s\r\n", code, reasonPhrase(code));
+    if (contentType) addHeader("Content-Type", contentType);
+}
+
+bool HttpResponse::append(const char* s, size_t len) {
+    if (_headLen + len > sizeof(_head)) return false;
+    memcpy(_head + _headLen, s, len);
+    _headLen += len;
+    return true;
+}
+
+bool HttpResponse::addHeader(const char* name, const char* value) {
+    size_t nameLen = strlen(name);
+    size_t valueLen = strlen(value);
+    if (_headLen + nameLen + valueLen + 4 > sizeof(_head) - HEAD_RESERVE) return false;
+    append(name, nameLen);
+    append(": ", 2);
+    append(value, valueLen);
+    append("\r\n", 2);
+    return true;
+}
+
+// A HEAD response announces the length a GET would have had
+void HttpResponse::end(bool http11, bool keepAlive, unsigned remaining) {
+    char line[48];
+    if (_body == CHUNKED) {
+        if (http11) append("Transfer-Encoding: chunked\r\n", 28);
+    } else if (_code >= 200 && _code != 204 && _code != 304) {
+        append(line, snprintf(line, sizeof(line), "Content-Length: %u\r\n", (unsigned)_length));
+    }
+    if (!keepAlive) {
+        append("Connection: close\r\n", 19);
+    } else {
+        if (!http11) append("Connection: keep-alive\r\n", 24);   // 1.1 is persistent unless told otherwise
+        append(line, snprintf(line, sizeof(line), "Keep-Alive: timeout=%u, max=%u\r\n",
+                              HTTP_KEEP_ALIVE_TIMEOUT / 1000, remaining));
+    }
+    append("\r\n", 2);
+}
+
+// ============================================================================
+// HttpRequest
+// ============================================================================
+
+HttpRequest::HttpRequest()
+    : tempObject(nullptr), _server(nullptr), _client(nullptr), _state(FREE), _keepAlive(false), _idle(false),
+      _requests(0), _start(0), _bodyIndex(0), _unread(0), _unacked(0), _parser(_arena, sizeof(_arena)), _sent(0),
+      _chunk(nullptr), _chunkStart(0), _chunkEnd(0), _lastChunk(false), _pipelineLen(0) {
+    _response._body = HttpResponse::EMPTY;
+    _response._data = nullptr;
+}
+
+void HttpRequest::attach(HttpServer* server, AsyncClient* client) {
+    _server = server;
+    _client = client;
+    _state = HEAD;
+    _keepAlive = true;
+    _idle = false;
+    _requests = 0;
+    _start = millis();
+    _bodyIndex = 0;
+    _unread = 0;
+    _unacked = 0;
+    _pipelineLen = 0;
+    _parser.keep(server->_keep);
+    _parser.reset();
+    tempObject = nullptr;
+
+    client->onData([](void* arg, AsyncClient*, void* data, size_t len) {
+        ((HttpRequest*)arg)->onData((const uint8_t*)data, len);
+    }, this);
+    client->onAck([](void* arg, AsyncClient*, size_t len, uint32_t) {
+        ((HttpRequest*)arg)->onAck(len);
+    }, this);
+    client->onPoll([](void* arg, AsyncClient*) {
+        ((HttpRequest*)arg)->onPoll();
+    }, this);
+    // Nothing acknowledged for AsyncTCP's ack timeout: the client is gone
+    client->onTimeout([](void*, AsyncClient* client, uint32_t) { client->close(); });
+    client->onDisconnect([](void* arg, AsyncClient* client) {
+        ((HttpRequest*)arg)->release();
+        delete client;
+    }, this);
+}
+
+// Done with the request's buffers and callbacks; the connection stays
+void HttpRequest::finish() {
+    if (_onEnd) {
+        std::function<void()> callback = _onEnd;
+        _onEnd = nullptr;
+        callback();
+    }
+    char* temp = (char*)tempObject;
+    if (temp && (temp < _arena || temp >= _arena + sizeof(_arena))) free(temp);
+    tempObject = nullptr;
+    if (_response._body == HttpResponse::OWNED) free((void*)_response._data);
+    _response._body = HttpResponse::EMPTY;
+    _response._data = nullptr;
+    _response._filler = nullptr;
+    free(_chunk);
+    _chunk = nullptr;
+}
+
+// The response is with TCP: on to the next request on the connection
+void HttpRequest::next() {
+    finish();
+    _requests++;
+    _state = HEAD;
+    _keepAlive = true;
+    _idle = true;
+    _start = millis();
+    _bodyIndex = 0;
+    _unread = 0;
+    _parser.reset();
+}
+
+// Back to the pool. The connection is closed or no longer ours.
+void HttpRequest::release() {
+    finish();
+    _pipelineLen = 0;
+    _client = nullptr;
+    _idle = false;
+    _state = FREE;
+}
+
+uint8_t* HttpRequest::scratch(size_t& size) {
+    size_t used = (_parser.used() + 7) & ~(size_t)7;
+    size = used < sizeof(_arena) ? sizeof(_arena) - used : 0;
+    return (uint8_t*)_arena + used;
+}
+
+void HttpRequest::onData(const uint8_t* data, size_t len) {
+    if (_state == HEAD || _state == BODY) {
+        serve(data, len);
+    } else if (_keepAlive) {
+        stash(data, len);   // Pipelined behind the response going out
+    } else {
+        discard(len);
+    }
+}
+
+// Requests in turn, for as long as each is answered at once
+void HttpRequest::serve(const uint8_t* data, size_t len) {
+    while (len > 0 && (_state == HEAD || _state == BODY)) {
+        size_t used = take(data, len);
+        data += used;
+        len -= used;
+        if (_state == SENT && _keepAlive) next();
+    }
+    if (len > 0 && _state >= RESPONDING) {
+        if (_keepAlive) {
+            stash(data, len);
+        } else {
+            discard(len);
+        }
+    }
+    if (_idle && _server->idleConnections() > HTTP_MAX_IDLE) _server->closeIdle(this);
+}
+
+// Bytes of this request; returns how many it took
+size_t HttpRequest::take(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    if (_state == HEAD) {
+        if (_idle) {
+            _idle = false;
+            _start = millis();
+        }
+        HttpRequestParser::Result result = _parser.feed(data, len, i);
+        if (result == HttpRequestParser::ERROR) {
+            fail(_parser.error());
+            return len;
+        }
+        if (result == HttpRequestParser::NEED_MORE) return i;
+
+        _unread = _parser.contentLength();
+        if (upgrade() || responded()) return i;
+        if (_unread == 0) {
+            dispatch();
+            return i;
+        }
+        if (!_server->_handler.acceptBody(*this, _parser.contentLength())) {
+            if (!responded()) send(413);
+            return i;
+        }
+        if (_parser.expectContinue() && http11()) {
+            static const char CONTINUE[] = "HTTP/1.1 100 Continue\r\n\r\n";
+            _unacked += _client->add(CONTINUE, sizeof(CONTINUE) - 1);
+            _client->send();
+        }
+        _state = BODY;
+    }
+
+    if (_state == BODY && i < len) {
+        size_t total = _parser.contentLength();
+        size_t n = len - i;
+        if (n > total - _bodyIndex) n = total - _bodyIndex;   // Anything after is the next request
+        _server->_handler.handleBody(*this, data + i, n, _bodyIndex, total);
+        _bodyIndex += n;
+        _unread -= n;
+        i += n;
+        if (_state == BODY && _bodyIndex == total) dispatch();
+    }
+    return i;
+}
+
+// Held until the response is out. More than fits, and the connection
+// closes after it; the client sends what went unanswered again.
+void HttpRequest::stash(const uint8_t* data, size_t len) {
+    if (_pipelineLen + len > sizeof(_pipeline)) {
+        _keepAlive = false;
+        _pipelineLen = 0;
+        return;
+    }
+    memmove(_pipeline + _pipelineLen, data, len);
+    _pipelineLen += len;
+}
+
+// Of a body the response came before: counted, so the close can wait for the rest
+void HttpRequest::discard(size_t len) {
+    _unread -= len < _unread ? len : _unread;
+}
+
+void HttpRequest::resume() {
+    size_t len = _pipelineLen;
+    _pipelineLen = 0;
+    serve(_pipeline, len);
+}
+
+void HttpRequest::dispatch() {
+    _state = HANDLING;
+    _server->_handler.handleRequest(*this);
+    if (_state == HANDLING) send(500);
+}
+
+// The stream cannot be read past this request: answer it and close
+void HttpRequest::fail(int code) {
+    _keepAlive = false;
+    if (responded() || !_client) return;
+    send(code);
+}
+
+// Hands a WebSocket upgrade to its channel; false when the path has none
+bool HttpRequest::upgrade() {
+    WebSocketChannel* channel = nullptr;
+    for (size_t i = 0; i < _server->_channelCount; i++) {
+        if (strcmp(_server->_channels[i]->path(), path()) == 0) channel = _server->_channels[i];
+    }
+    if (!channel) return false;
+
+    _state = HANDLING;
+    const char* version = header("Sec-WebSocket-Version");
+    const char* key = header("Sec-WebSocket-Key");
+    char accept[WEBSOCKET_ACCEPT_SIZE];
+    if (method() != HTTP_METHOD_GET) {
+        send(405);
+    } else if (!listsToken(header("Upgrade"), "websocket") || !(_parser.connection() & HTTP_CONNECTION_UPGRADE)) {
+        HttpResponse& response = beginResponse(426);
+        response.addHeader("Upgrade", "websocket");
+        send(response);
+    } else if (!version || strcmp(version, "13") != 0) {
+        HttpResponse& response = beginResponse(426);
+        response.addHeader("Sec-WebSocket-Version", "13");
+        send(response);
+    } else if (!key || !webSocketAccept(key, accept)) {
+        send(400);
+    } else {
+        _response.begin(101, nullptr);
+        _response.addHeader("Upgrade", "websocket");
+        _response.addHeader("Connection", "Upgrade");
+        _response.addHeader("Sec-WebSocket-Accept", accept);
+        _response.append("\r\n", 2);
+        if (!channel->attach(_client, *this, _response._head, _response._headLen)) {
+            send(503);
+            return true;
+        }
+        // The channel has the connection and its callbacks now
+        _client = nullptr;
+        release();
+    }
+    return true;
+}
+
+HttpResponse& HttpRequest::beginResponse(int code, const char* contentType, const char* body, size_t len) {
+    if (_response._body == HttpResponse::OWNED) free((void*)_response._data);
+    if (!contentType && len) contentType = "text/plain";
+    _response.begin(code, contentType);
+    if (body) {
+        _response._body = HttpResponse::STATIC;
+        _response._data = (const uint8_t*)body;
+        _response._length = len;
+    }
+    return _response;
+}
+
+HttpResponse& HttpRequest::beginFlashResponse(int code, const char* contentType, const uint8_t* body, size_t len) {
+    HttpResponse& response = beginResponse(code, contentType, (const char*)body, len);
+    if (body) response._body = HttpResponse::FLASH;
+    return response;
+}
+
+HttpResponse& HttpRequest::beginJson(int code, JsonVariantConst doc) {
+    size_t len = measureJson(doc);
+    char* body = (char*)malloc(len + 1);
+    if (!body) return beginResponse(503);
+    serializeJson(doc, body, len + 1);
+    HttpResponse& response = beginResponse(code, "application/json", body, len);
+    response._body = HttpResponse::OWNED;
+    return response;
+}
+
+HttpResponse& HttpRequest::beginChunkedResponse(const char* contentType, HttpFiller filler) {
+    free(_chunk);
+    _chunk = (uint8_t*)malloc(CHUNK_PREFIX + HTTP_CHUNK_SIZE + 2);
+    if (!_chunk) return beginResponse(503);
+    HttpResponse& response = beginResponse(200, contentType);
+    response._body = HttpResponse::CHUNKED;
+    response._filler = filler;
+    _chunkStart = _chunkEnd = 0;
+    _lastChunk = false;
+    return response;
+}
+
+void HttpRequest::send(HttpResponse& response) {
+    if (responded() || !_client) return;
+    // Only a request read to its end leaves the stream at the next one
+    uint8_t connection = _parser.connection();
+    bool wanted = http11() ? !(connection & HTTP_CONNECTION_CLOSE) : (connection & HTTP_CONNECTION_KEEP_ALIVE);
+    _keepAlive = _keepAlive && wanted && _state == HANDLING && _requests + 1 < HTTP_KEEP_ALIVE_REQUESTS &&
+                 !(response._body == HttpResponse::CHUNKED && !http11());
+    _state = RESPONDING;
+    response.end(http11(), _keepAlive, HTTP_KEEP_ALIVE_REQUESTS - 1 - _requests);
+    _sent = 0;
+    pump();
+}
+
+void HttpRequest::send(int code, const char* contentType, const char* body) {
+    send(beginResponse(code, contentType, body, body ? strlen(body) : 0));
+}
+
+// As much of the response as TCP has room for
+void HttpRequest::pump() {
+    bool added = false;
+    bool headOnly = method() == HTTP_METHOD_HEAD;
+    while (_state == RESPONDING) {
+        const uint8_t* data;
+        size_t len;
+        size_t head = _response._headLen;
+        if (_sent < head) {
+            data = (const uint8_t*)_response._head + _sent;
+            len = head - _sent;
+        } else if (headOnly || _response._body == HttpResponse::EMPTY) {
+            _state = SENT;
+            break;
+        } else if (_response._body != HttpResponse::CHUNKED) {
+            if (_sent == head + _response._length) {
+                _state = SENT;
+                break;
+            }
+            data = _response._data + (_sent - head);
+            len = head + _response._length - _sent;
+        } else {
+            if (_chunkStart == _chunkEnd) {
+                if (_lastChunk) {
+                    _state = SENT;
+                    break;
+                }
+                size_t n = _response._filler(_chunk + CHUNK_PREFIX, HTTP_CHUNK_SIZE);
+                if (!http11()) {
+                    // No chunked coding before 1.1: the body ends when the connection does
+                    _lastChunk = n == 0;
+                    _chunkStart = CHUNK_PREFIX;
+                    _chunkEnd = CHUNK_PREFIX + n;
+                } else if (n == 0) {
+                    memcpy(_chunk, "0\r\n\r\n", 5);
+                    _chunkStart = 0;
+                    _chunkEnd = 5;
+                    _lastChunk = true;
+                } else {
+                    char size[CHUNK_PREFIX + 1];
+                    size_t sizeLen = snprintf(size, sizeof(size), "%x\r\n", (unsigned)n);
+                    _chunkStart = CHUNK_PREFIX - sizeLen;
+                    memcpy(_chunk + _chunkStart, size, sizeLen);
+                    memcpy(_chunk + CHUNK_PREFIX + n, "\r\n", 2);
+                    _chunkEnd = CHUNK_PREFIX + n + 2;
+                }
+                continue;
+            }
+            data = _chunk + _chunkStart;
+            len = _chunkEnd - _chunkStart;
+        }
+
+        // Without ASYNC_WRITE_FLAG_COPY lwIP points its segments at the data
+        bool inPlace = _sent >= head && _response._body == HttpResponse::FLASH;
+        size_t n = _client->add((const char*)data, len, inPlace ? 0 : ASYNC_WRITE_FLAG_COPY);
+        if (n == 0) break;
+        added = true;
+        _unacked += n;
+        if (_sent < head || _response._body != HttpResponse::CHUNKED) {
+            _sent += n;
+        } else {
+            _chunkStart += n;
+        }
+        if (n < len) break;
+    }
+    if (added) _client->send();
+}
+
+void HttpRequest::onAck(size_t len) {
+    _unacked -= len < _unacked ? len : _unacked;
+    if (_state == RESPONDING) pump();
+    settle();
+}
+
+void HttpRequest::onPoll() {
+    uint32_t waited = millis() - _start;
+    if (_idle) {
+        if (waited > HTTP_KEEP_ALIVE_TIMEOUT) _client->close();   // Releases this request
+        return;
+    }
+    if (_state == DRAINING) {
+        if (_unread == 0 || waited > HTTP_REQUEST_TIMEOUT) _client->close();
+        return;
+    }
+    if ((_state == HEAD || _state == BODY) && waited > HTTP_REQUEST_TIMEOUT) {
+        fail(408);
+        return;
+    }
+    if (_state == RESPONDING) pump();
+    settle();
+}
+
+// A response that is out: the next request, or the close once it is
+// acknowledged. Closing with body bytes still on the way would have TCP
+// reset the connection, so the rest of the body is read first.
+void HttpRequest::settle() {
+    if (_state != SENT) return;
+    if (_keepAlive) {
+        next();
+        resume();
+    } else if (_unacked == 0 && _unread > 0) {
+        _state = DRAINING;
+        _start = millis();
+    } else if (_unacked == 0) {
+        _client->close();   // Releases this request
+    }
+}
+
+// ============================================================================
+// HttpServer
+// ============================================================================
+
+HttpServer::HttpServer(uint16_t port, HttpHandler& handler)
+    : _server(port), _handler(handler), _keep{}, _channels{}, _channelCount(0) {}
+
+bool HttpServer::addWebSocket(WebSocketChannel& channel) {
+    if (_channelCount == HTTP_MAX_WEBSOCKETS) return false;
+    _channels[_channelCount++] = &channel;
+    return true;
+}
+
+void HttpServer::begin() {
+    // The server's own headers, then the handler's
+    size_t n = 0;
+    if (_channelCount) {
+        _keep[n++] = "Upgrade";
+        _keep[n++] = "Sec-WebSocket-Key";
+        _keep[n++] = "Sec-WebSocket-Version";
+    }
+    for (const char* const* h = _handler.headers(); h && *h && n < HTTP_KEEP_MAX - 1; h++) {
+        _keep[n++] = *h;
+    }
+    _keep[n] = nullptr;
+
+    _server.onClient([](void* arg, AsyncClient* client) {
+        ((HttpServer*)arg)->onClient(client);
+    }, this);
+    _server.begin();
+}
+
+size_t HttpServer::connections() const {
+    size_t n = 0;
+    for (const HttpRequest& request : _pool) {
+        if (request._state != HttpRequest::FREE) n++;
+    }
+    return n;
+}
+
+size_t HttpServer::idleConnections() const {
+    size_t n = 0;
+    for (const HttpRequest& request : _pool) {
+        if (request._idle) n++;
+    }
+    return n;
+}
+
+// Closes the connection that has waited longest for its next request;
+// false when none is waiting with its last response acknowledged
+bool HttpServer::closeIdle(const HttpRequest* except) {
+    HttpRequest* oldest = nullptr;
+    uint32_t now = millis();
+    for (HttpRequest& request : _pool) {
+        if (&request == except || !request._idle || request._unacked) continue;
+        if (!oldest || now - request._start > now - oldest->_start) oldest = &request;
+    }
+    if (!oldest) return false;
+    // Not from its own callbacks, so it goes at once, and releases its request
+    oldest->_client->close(true);
+    return true;
+}
+
+void HttpServer::onClient(AsyncClient* client) {
+    // With every connection in use, one waiting for a request makes room
+    for (int pass = 0; pass < 2; pass++) {
+        for (HttpRequest& request : _pool) {
+            if (request._state == HttpRequest::FREE) {
+                request.attach(this, client);
+                return;
+            }
+        }
+        if (!closeIdle(nullptr)) break;
+    }
+    static const char BUSY[] =
+        "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\nRetry-After: 1\r\nConnection: close\r\n\r\n";
+    // Closed from its ack: closing deletes it, and AsyncTCP is not done with it yet
+    client->onDisconnect([](void*, AsyncClient* client) { delete client; });
+    client->onAck([](void*, AsyncClient* client, size_t, uint32_t) { client->close(); });
+    client->onPoll([](void*, AsyncClient* client) { client->close(); });
+    client->write(BUSY, sizeof(BUSY) - 1);
+}
+
+#endif  // ARDUINO || NANDA_HOST
@@ -0,0 +1,254 @@
+/**
+ * HTTP/1.1 server on AsyncTCP (ESP32 only).
+ *
+ * Connections are served from a fixed pool sized at compile time, each
+ * with its own HttpRequestParser arena, so taking a request allocates
+ * nothing; a connection that finds the pool full gets a canned 503. The
+ * head is parsed as segments arrive, body segments go to the handler as
+ * they come in (data, len, index, total), and handleRequest() runs once
+ * the body is complete.
+ *
+ * Responses are written from where they already are: a static body as it
+ * is (one in flash without even a copy into TCP's buffers), a JSON
+ * document serialized once into a block sized by measureJson(), a
+ * chunked body filled a segment at a time as TCP has room. Everything
+ * runs on the async_tcp task; nothing here is called from loop() except
+ * through a WebSocketChannel.
+ *
+ * Connections are persistent (HTTP/1.1, or 1.0 with keep-alive): once a
+ * response is handed to TCP the next request on the connection is parsed,
+ * including any pipelined behind it. Those that arrive while a response is
+ * still going out wait in a small per-connection buffer. A connection
+ * serves at most HTTP_KEEP_ALIVE_REQUESTS requests and waits
+ * HTTP_KEEP_ALIVE_TIMEOUT for the next one; at most HTTP_MAX_IDLE wait at
+ * once, and the longest waiting gives way to a new connection. Requests
+ * the stream cannot be read past (parse errors, a body left unread) are
+ * answered with Connection: close. The rest of a body left unread is read
+ * and dropped before the close, for up to HTTP_REQUEST_TIMEOUT, so a
+ * client still sending it gets its answer rather than a reset.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <ArduinoJson.h>
+#include <AsyncTCP.h>
+#include <functional>
+
+#include "HttpRequestParser.h"
+
+#ifndef HTTP_MAX_CONNECTIONS
+#define HTTP_MAX_CONNECTIONS 8
+#endif
+#ifndef HTTP_REQUEST_ARENA
+#define HTTP_REQUEST_ARENA 1024     // Target and kept headers, then scratch()
+#endif
+#ifndef HTTP_RESPONSE_HEAD
+#define HTTP_RESPONSE_HEAD 320      // Status line and headers
+#endif
+#ifndef HTTP_CHUNK_SIZE
+#define HTTP_CHUNK_SIZE 1436        // One TCP_MSS per chunk
+#endif
+#ifndef HTTP_REQUEST_TIMEOUT
+#define HTTP_REQUEST_TIMEOUT 5000   // ms to receive a whole request
+#endif
+#ifndef HTTP_KEEP_ALIVE_TIMEOUT
+#define HTTP_KEEP_ALIVE_TIMEOUT 5000   // ms an open connection waits for its next request
+#endif
+#ifndef HTTP_KEEP_ALIVE_REQUESTS
+#define HTTP_KEEP_ALIVE_REQUESTS 100   // Per connection
+#endif
+#ifndef HTTP_MAX_IDLE
+#define HTTP_MAX_IDLE 6                // Connections held open between requests
+#endif
+#ifndef HTTP_PIPELINE_BUFFER
+#define HTTP_PIPELINE_BUFFER 512       // Bytes received while a response is going out
+#endif
+#define HTTP_MAX_WEBSOCKETS 2
+#define HTTP_KEEP_MAX 16
+
+class HttpRequest;
+class HttpServer;
+class WebSocketChannel;
+
+// Fills up to len bytes at buf and returns how many; 0 ends the body
+typedef std::function<size_t(uint8_t* buf, size_t len)> HttpFiller;
+
+class HttpHandler {
+public:
+    virtual ~HttpHandler() {}
+
+    // Headers handleRequest() reads, nullptr-terminated; the rest are skipped
+    virtual const char* const* headers() const { return nullptr; }
+    // Once the body is in, unless handleBody() already answered. Must
+    // start a response; a request left without one is answered 500.
+    virtual void handleRequest(HttpRequest& request) = 0;
+    // Once the head of a request with a body is in, before 100 Continue or
+    // any of the body: false refuses the body, answered 413 unless the
+    // handler answered it
+    virtual bool acceptBody(HttpRequest& request, size_t total) {
+        (void)request;
+        (void)total;
+        return true;
+    }
+    // Once per segment of a body with a Content-Length
+    virtual void handleBody(HttpRequest& request, const uint8_t* data, size_t len, size_t index, size_t total) {
+        (void)request;
+        (void)data;
+        (void)len;
+        (void)index;
+        (void)total;
+    }
+};
+
+class HttpResponse {
+public:
+    // False when the head has no room left for it
+    bool addHeader(const char* name, const char* value);
+
+private:
+    friend class HttpRequest;
+
+    enum Body : uint8_t {
+        EMPTY,
+        STATIC,    // The caller's, outlives the response
+        FLASH,     // Constant: TCP sends it in place, without a copy
+        OWNED,     // malloc()ed here, freed when sent
+        CHUNKED
+    };
+
+    void begin(int code, const char* contentType);
+    bool append(const char* s, size_t len);
+    void end(bool http11, bool keepAlive, unsigned remaining);
+
+    int _code;
+    char _head[HTTP_RESPONSE_HEAD];
+    size_t _headLen;
+    Body _body;
+    const uint8_t* _data;
+    size_t _length;
+    HttpFiller _filler;
+};
+
+class HttpRequest {
+public:
+    HttpRequest();
+
+    uint8_t method() const { return _parser.method(); }
+    bool http11() const { return _parser.http11(); }
+    const char* path() const { return _parser.path(); }
+    size_t pathLength() const { return _parser.pathLength(); }
+    const char* query() const { return _parser.query(); }
+    const char* header(const char* name) const { return _parser.header(name); }
+    bool param(const char* name, char* buf, size_t size) const { return _parser.param(name, buf, size); }
+    size_t contentLength() const { return _parser.contentLength(); }
+
+    // The arena past the parsed head, free for the rest of the request
+    // (e.g. a small body); aligned for any object
+    uint8_t* scratch(size_t& size);
+
+    // The handler's state across body segments. free()d with the request,
+    // unless it points into scratch().
+    void* tempObject;
+
+    // A body the caller keeps alive until the response is sent
+    HttpResponse& beginResponse(int code, const char* contentType = nullptr, const char* body = nullptr,
+                                size_t len = 0);
+    // A body that never changes (flash): held by reference until acknowledged
+    HttpResponse& beginFlashResponse(int code, const char* contentType, const uint8_t* body, size_t len);
+    // Serialized once into a block of its exact size; 503 if there is none
+    HttpResponse& beginJson(int code, JsonVariantConst doc);
+    // Written as the filler produces it, chunked (HTTP/1.1) or until close
+    HttpResponse& beginChunkedResponse(const char* contentType, HttpFiller filler);
+    void send(HttpResponse& response);
+    void send(int code, const char* contentType = nullptr, const char* body = nullptr);
+    bool responded() const { return _state >= RESPONDING; }
+
+    // Called once, when the response is out or the client is gone
+    void onEnd(std::function<void()> callback) { _onEnd = callback; }
+
+private:
+    friend class HttpServer;
+
+    enum State : uint8_t {
+        FREE,
+        HEAD,
+        BODY,
+        HANDLING,
+        RESPONDING,
+        SENT,       // All handed to TCP: on to the next request, or closed once acknowledged
+        DRAINING    // Acknowledged; closed once the unread body is in
+    };
+
+    void attach(HttpServer* server, AsyncClient* client);
+    void finish();
+    void next();
+    void release();
+    void onData(const uint8_t* data, size_t len);
+    void serve(const uint8_t* data, size_t len);
+    size_t take(const uint8_t* data, size_t len);
+    void stash(const uint8_t* data, size_t len);
+    void discard(size_t len);
+    void resume();
+    void onAck(size_t len);
+    void onPoll();
+    void settle();
+    void dispatch();
+    void fail(int code);
+    bool upgrade();
+    void pump();
+
+    HttpServer* _server;
+    AsyncClient* _client;
+    State _state;
+    bool _keepAlive;         // Until something rules it out
+    bool _idle;              // Between requests on an open connection
+    uint16_t _requests;      // Served on this connection
+    uint32_t _start;         // Of the request, or of the wait for it
+    size_t _bodyIndex;
+    size_t _unread;          // Of the declared body
+    size_t _unacked;
+
+    char _arena[HTTP_REQUEST_ARENA];
+    HttpRequestParser _parser;
+
+    HttpResponse _response;
+    size_t _sent;            // Of the head, then of the body or the chunk
+    uint8_t* _chunk;         // CHUNKED: malloc()ed with the response
+    size_t _chunkStart;
+    size_t _chunkEnd;
+    bool _lastChunk;
+    std::function<void()> _onEnd;
+
+    uint8_t _pipeline[HTTP_PIPELINE_BUFFER];
+    size_t _pipelineLen;
+};
+
+class HttpServer {
+public:
+    HttpServer(uint16_t port, HttpHandler& handler);
+
+    // Before begin(); at most HTTP_MAX_WEBSOCKETS
+    bool addWebSocket(WebSocketChannel& channel);
+    void begin();
+
+    // Connections in use, and those of them waiting for a request, for diagnostics
+    size_t connections() const;
+    size_t idleConnections() const;
+
+private:
+    friend class HttpRequest;
+
+    void onClient(AsyncClient* client);
+    bool closeIdle(const HttpRequest* except);
+
+    AsyncServer _server;
+    HttpHandler& _handler;
+    const char* _keep[HTTP_KEEP_MAX];
+    WebSocketChannel* _channels[HTTP_MAX_WEBSOCKETS];
+    size_t _channelCount;
+    HttpRequest _pool[HTTP_MAX_CONNECTIONS];
+};
+
+#endif  // ARDUINO || NANDA_HOST
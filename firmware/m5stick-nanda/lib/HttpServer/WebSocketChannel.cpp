@@ -0,0 +1,242 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "WebSocketChannel.h"
+
+#include <string.h>
+
+WebSocketChannel::WebSocketChannel(const char* path)
+    : _path(path), _handler(nullptr), _mux(portMUX_INITIALIZER_UNLOCKED), _nextId(1) {
+    for (Client& c : _clients) {
+        c.channel = this;
+        c.tcp = nullptr;
+        c.id = 0;
+        c.writer = NONE;
+        c.orphaned = false;
+        c.closing = false;
+        c.closeSent = false;
+        c.pongPending = false;
+    }
+}
+
+size_t WebSocketChannel::count() {
+    size_t n = 0;
+    portENTER_CRITICAL(&_mux);
+    for (const Client& c : _clients) {
+        if (c.tcp && c.id) n++;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return n;
+}
+
+// loop()'s token for a connected client
+WebSocketChannel::Client* WebSocketChannel::claim(uint32_t id) {
+    Client* found = nullptr;
+    portENTER_CRITICAL(&_mux);
+    for (Client& c : _clients) {
+        if (id && c.id == id && c.tcp && c.writer == NONE) {
+            c.writer = LOOP;
+            found = &c;
+            break;
+        }
+    }
+    portEXIT_CRITICAL(&_mux);
+    return found;
+}
+
+// async_tcp's token; false while loop() has it
+bool WebSocketChannel::claim(Client& c, bool& closing) {
+    bool claimed = false;
+    portENTER_CRITICAL(&_mux);
+    if (c.tcp && c.writer == NONE) {
+        c.writer = TCP;
+        closing = c.closing;
+        claimed = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return claimed;
+}
+
+void WebSocketChannel::release(Client& c) {
+    AsyncClient* orphan = nullptr;
+    portENTER_CRITICAL(&_mux);
+    c.writer = NONE;
+    if (c.orphaned) {
+        orphan = c.tcp;
+        c.tcp = nullptr;
+        c.orphaned = false;
+    }
+    portEXIT_CRITICAL(&_mux);
+    delete orphan;
+}
+
+bool WebSocketChannel::availableForWrite(uint32_t id, size_t len) {
+    Client* c = claim(id);
+    if (!c) return false;
+    bool room = !c->closing && c->tcp->space() >= len + WEBSOCKET_HEADER_MAX;
+    release(*c);
+    return room;
+}
+
+bool WebSocketChannel::binary(uint32_t id, const uint8_t* data, size_t len) {
+    Client* c = claim(id);
+    if (!c) return false;
+    uint8_t header[WEBSOCKET_HEADER_MAX];
+    size_t headerLen = webSocketHeader(WS_BINARY, len, header);
+    bool sent = false;
+    if (!c->closing && c->tcp->space() >= headerLen + len) {
+        sent = c->tcp->add((const char*)header, headerLen) == headerLen &&
+               c->tcp->add((const char*)data, len) == len;
+        c->tcp->send();
+        if (!sent) {
+            // lwIP ran out of segments mid-frame: the stream cannot go on
+            portENTER_CRITICAL(&_mux);
+            c->closing = c->closeSent = true;
+            portEXIT_CRITICAL(&_mux);
+        }
+    }
+    release(*c);
+    return sent;
+}
+
+void WebSocketChannel::close(uint32_t id, uint16_t code, const char* reason) {
+    for (Client& c : _clients) {
+        if (c.id == id && id) queueClose(c, code, (const uint8_t*)reason, reason ? strlen(reason) : 0);
+    }
+}
+
+// The frame is filled in before closing is set and never touched after,
+// so async_tcp reads it without the lock
+void WebSocketChannel::queueClose(Client& c, uint16_t code, const uint8_t* reason, size_t reasonLen) {
+    if (reasonLen > WEBSOCKET_CONTROL_MAX - 2) reasonLen = WEBSOCKET_CONTROL_MAX - 2;
+    portENTER_CRITICAL(&_mux);
+    if (c.tcp && !c.closing) {
+        c.closeLen = 0;
+        if (code) {
+            c.closeFrame[0] = code >> 8;
+            c.closeFrame[1] = code & 0xFF;
+            memcpy(c.closeFrame + 2, reason, reasonLen);
+            c.closeLen = 2 + reasonLen;
+        }
+        c.closing = true;
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+bool WebSocketChannel::attach(AsyncClient* tcp, HttpRequest& request, const char* head, size_t headLen) {
+    Client* c = nullptr;
+    uint32_t id = 0;
+    portENTER_CRITICAL(&_mux);
+    for (Client& slot : _clients) {
+        if (slot.tcp) continue;
+        c = &slot;
+        id = _nextId++;
+        if (_nextId == 0) _nextId = 1;
+        c->tcp = tcp;
+        c->id = id;
+        c->writer = TCP;   // Until the head is out and the handler has run
+        c->orphaned = false;
+        c->closing = false;
+        c->closeSent = false;
+        c->pongPending = false;
+        break;
+    }
+    portEXIT_CRITICAL(&_mux);
+    if (!c) return false;
+
+    c->reader.reset();
+    tcp->add(head, headLen);
+    tcp->send();
+
+    tcp->onData([](void* arg, AsyncClient*, void* data, size_t len) {
+        onData(*(Client*)arg, (const uint8_t*)data, len);
+    }, c);
+    tcp->onAck([](void* arg, AsyncClient*, size_t, uint32_t) {
+        flush(*(Client*)arg, true);
+    }, c);
+    tcp->onPoll([](void* arg, AsyncClient*) {
+        flush(*(Client*)arg, true);
+    }, c);
+    tcp->onTimeout([](void*, AsyncClient* tcp, uint32_t) { tcp->close(); });
+    tcp->onDisconnect([](void* arg, AsyncClient*) {
+        onDisconnect(*(Client*)arg);
+    }, c);
+
+    if (_handler) _handler(*this, id, WS_EVENT_CONNECT, &request);
+    release(*c);
+    flush(*c, false);
+    return true;
+}
+
+void WebSocketChannel::onData(Client& c, const uint8_t* data, size_t len) {
+    while (len > 0) {
+        size_t used;
+        WebSocketReader::Result result = c.reader.feed(data, len, used);
+        data += used;
+        len -= used;
+        if (result == WebSocketReader::ERROR) {
+            c.channel->queueClose(c, 1002, nullptr, 0);
+            break;
+        }
+        if (result != WebSocketReader::CONTROL) continue;
+
+        if (c.reader.opcode() == WS_PING) {
+            memcpy(c.pong, c.reader.payload(), c.reader.length());
+            c.pongLen = c.reader.length();
+            c.pongPending = true;
+        } else if (c.reader.opcode() == WS_CLOSE) {
+            // Echo the status code, then close
+            const uint8_t* payload = c.reader.payload();
+            uint16_t code = c.reader.length() >= 2 ? payload[0] << 8 | payload[1] : 0;
+            c.channel->queueClose(c, code, nullptr, 0);
+        }
+    }
+    flush(c, false);
+}
+
+// Pending control frames, then the TCP close once the close frame is out.
+// Closing deletes the client, which AsyncTCP still uses after a data
+// callback returns, so only ack and poll close.
+void WebSocketChannel::flush(Client& c, bool mayClose) {
+    WebSocketChannel* channel = c.channel;
+    bool closing;
+    if (!channel->claim(c, closing)) return;   // The next ack or poll tries again
+
+    AsyncClient* tcp = c.tcp;
+    uint8_t header[WEBSOCKET_HEADER_MAX];
+    if (c.pongPending && !closing && tcp->space() >= 2u + c.pongLen) {
+        tcp->add((const char*)header, webSocketHeader(WS_PONG, c.pongLen, header));
+        tcp->add((const char*)c.pong, c.pongLen);
+        tcp->send();
+        c.pongPending = false;
+    }
+    if (closing && !c.closeSent && tcp->space() >= 2u + c.closeLen) {
+        tcp->add((const char*)header, webSocketHeader(WS_CLOSE, c.closeLen, header));
+        tcp->add((const char*)c.closeFrame, c.closeLen);
+        tcp->send();
+        c.closeSent = true;
+    }
+    bool done = c.closeSent;
+    channel->release(c);
+    // May run onDisconnect() before it returns
+    if (done && mayClose) tcp->close();
+}
+
+void WebSocketChannel::onDisconnect(Client& c) {
+    WebSocketChannel* channel = c.channel;
+    AsyncClient* tcp = nullptr;
+    portENTER_CRITICAL(&channel->_mux);
+    uint32_t id = c.id;
+    c.id = 0;
+    if (c.writer == LOOP) {
+        c.orphaned = true;
+    } else {
+        tcp = c.tcp;
+        c.tcp = nullptr;
+    }
+    portEXIT_CRITICAL(&channel->_mux);
+
+    if (id && channel->_handler) channel->_handler(*channel, id, WS_EVENT_DISCONNECT, nullptr);
+    delete tcp;
+}
+
+#endif  // ARDUINO || NANDA_HOST
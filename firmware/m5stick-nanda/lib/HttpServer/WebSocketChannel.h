@@ -0,0 +1,102 @@
+/**
+ * Server-sent WebSocket messages on one path of an HttpServer (ESP32 only).
+ *
+ * The server upgrades a GET to the channel's path and hands the channel
+ * the connection. Clients are numbered; the event handler hears of each
+ * one coming (with its request, for the query) and going, on the
+ * async_tcp task. Messages are sent from loop() with binary(), whole or
+ * not at all, once availableForWrite() says TCP has room for them.
+ *
+ * Two tasks write to a client, loop() its messages and async_tcp the
+ * control frames (pong, close), so each client has a writer token taken
+ * under a spinlock. async_tcp never waits for it: a control frame that
+ * finds loop() writing is left pending and goes out on the next ack or
+ * poll. A client that disconnects while loop() holds the token is left
+ * to loop() to delete. Incoming data frames are read past.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <AsyncTCP.h>
+
+#include "WebSocketFrame.h"
+
+#ifndef WEBSOCKET_MAX_CLIENTS
+#define WEBSOCKET_MAX_CLIENTS 4
+#endif
+
+class HttpRequest;
+class WebSocketChannel;
+
+enum WebSocketEvent : uint8_t {
+    WS_EVENT_CONNECT,
+    WS_EVENT_DISCONNECT
+};
+
+// request is set for WS_EVENT_CONNECT only
+typedef void (*WebSocketEventHandler)(WebSocketChannel& channel, uint32_t client, WebSocketEvent event,
+                                      HttpRequest* request);
+
+class WebSocketChannel {
+public:
+    explicit WebSocketChannel(const char* path);
+
+    void onEvent(WebSocketEventHandler handler) { _handler = handler; }
+    const char* path() const { return _path; }
+    size_t count();
+
+    // Whether a message of len bytes would go out now
+    bool availableForWrite(uint32_t client, size_t len);
+    // The whole message, or false and nothing
+    bool binary(uint32_t client, const uint8_t* data, size_t len);
+    // Sends a close frame, then closes the connection
+    void close(uint32_t client, uint16_t code = 1000, const char* reason = nullptr);
+
+private:
+    friend class HttpRequest;
+
+    enum Writer : uint8_t {
+        NONE,
+        LOOP,
+        TCP
+    };
+
+    struct Client {
+        WebSocketChannel* channel;
+        AsyncClient* tcp;         // nullptr when the slot is free
+        uint32_t id;              // 0 once disconnected
+        Writer writer;
+        bool orphaned;            // Gone while loop() wrote: loop() deletes tcp
+        bool closing;             // Close frame queued: nothing else goes out
+        bool closeSent;           // Then the connection is closed
+        bool pongPending;
+        uint8_t closeLen;
+        uint8_t pongLen;
+        uint8_t closeFrame[WEBSOCKET_CONTROL_MAX];
+        uint8_t pong[WEBSOCKET_CONTROL_MAX];
+        WebSocketReader reader;
+    };
+
+    // From the server, with the 101 response head; false when full
+    bool attach(AsyncClient* tcp, HttpRequest& request, const char* head, size_t headLen);
+
+    Client* claim(uint32_t id);
+    bool claim(Client& c, bool& closing);
+    void release(Client& c);
+    void queueClose(Client& c, uint16_t code, const uint8_t* reason, size_t reasonLen);
+
+    // On async_tcp
+    static void onData(Client& c, const uint8_t* data, size_t len);
+    static void onDisconnect(Client& c);
+    static void flush(Client& c, bool mayClose);
+
+    const char* _path;
+    WebSocketEventHandler _handler;
+    portMUX_TYPE _mux;
+    uint32_t _nextId;
+    Client _clients[WEBSOCKET_MAX_CLIENTS];
+};
+
+#endif  // ARDUINO || NANDA_HOST
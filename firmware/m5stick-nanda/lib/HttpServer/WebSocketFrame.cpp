@@ -0,0 +1,214 @@
+#include "WebSocketFrame.h"
+
+#include <string.h>
+
+#define WS_FIN 0x80
+#define WS_RSV 0x70
+#define WS_MASKED 0x80
+
+static const char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+static uint32_t rotl(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+static void sha1Block(uint32_t h[5], const uint8_t* p) {
+    uint32_t w[80];
+    for (int i = 0; i < 16; i++) {
+        w[i] = (uint32_t)p[i * 4] << 24 | (uint32_t)p[i * 4 + 1] << 16 | (uint32_t)p[i * 4 + 2] << 8 | p[i * 4 + 3];
+    }
+    for (int i = 16; i < 80; i++) w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = rotl(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rotl(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void sha1(const uint8_t* data, size_t len, uint8_t digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) sha1Block(h, data + i);
+
+    // The rest, 0x80, zeros, then the bit length: one or two more blocks
+    uint8_t tail[128] = {};
+    size_t rest = len - i;
+    memcpy(tail, data + i, rest);
+    tail[rest] = 0x80;
+    size_t tailLen = rest + 9 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t)len * 8;
+    for (int k = 0; k < 8; k++) tail[tailLen - 1 - k] = (uint8_t)(bits >> (k * 8));
+    sha1Block(h, tail);
+    if (tailLen == 128) sha1Block(h, tail + 64);
+
+    for (int k = 0; k < 5; k++) {
+        digest[k * 4] = h[k] >> 24;
+        digest[k * 4 + 1] = h[k] >> 16;
+        digest[k * 4 + 2] = h[k] >> 8;
+        digest[k * 4 + 3] = h[k];
+    }
+}
+
+size_t base64Encode(const uint8_t* data, size_t len, char* out) {
+    static const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t n = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t)data[i] << 16;
+        if (i + 1 < len) v |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < len) v |= data[i + 2];
+        out[n++] = ALPHABET[(v >> 18) & 63];
+        out[n++] = ALPHABET[(v >> 12) & 63];
+        out[n++] = i + 1 < len ? ALPHABET[(v >> 6) & 63] : '=';
+        out[n++] = i + 2 < len ? ALPHABET[v & 63] : '=';
+    }
+    out[n] = '\0';
+    return n;
+}
+
+bool webSocketAccept(const char* key, char out[WEBSOCKET_ACCEPT_SIZE]) {
+    size_t keyLen = strlen(key);
+    if (keyLen > WEBSOCKET_KEY_MAX) return false;
+    uint8_t input[WEBSOCKET_KEY_MAX + sizeof(WEBSOCKET_GUID)];
+    memcpy(input, key, keyLen);
+    memcpy(input + keyLen, WEBSOCKET_GUID, sizeof(WEBSOCKET_GUID) - 1);
+    uint8_t digest[20];
+    sha1(input, keyLen + sizeof(WEBSOCKET_GUID) - 1, digest);
+    base64Encode(digest, sizeof(digest), out);
+    return true;
+}
+
+size_t webSocketHeader(uint8_t opcode, size_t len, uint8_t out[WEBSOCKET_HEADER_MAX]) {
+    out[0] = WS_FIN | opcode;
+    if (len < 126) {
+        out[1] = (uint8_t)len;
+        return 2;
+    }
+    if (len <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = (uint8_t)(len >> 8);
+        out[3] = (uint8_t)len;
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; i++) out[2 + i] = (uint8_t)((uint64_t)len >> ((7 - i) * 8));
+    return 10;
+}
+
+// ============================================================================
+// WebSocketReader
+// ============================================================================
+
+WebSocketReader::WebSocketReader() {
+    reset();
+}
+
+void WebSocketReader::reset() {
+    _state = HEADER;
+    _headerLen = 0;
+    _headerNeed = 2;
+    _opcode = 0;
+    _remaining = 0;
+    _maskIndex = 0;
+    _controlLen = 0;
+}
+
+// Everything a frame can get wrong is in its first two bytes
+bool WebSocketReader::validStart() const {
+    uint8_t b0 = _header[0];
+    uint8_t b1 = _header[1];
+    uint8_t opcode = b0 & 0x0F;
+    if ((b0 & WS_RSV) || !(b1 & WS_MASKED)) return false;   // No extensions; clients must mask
+    if ((opcode > WS_BINARY && opcode < WS_CLOSE) || opcode > WS_PONG) return false;
+    // Control frames are whole and short, so never use the extended lengths
+    if ((opcode & 0x08) && (!(b0 & WS_FIN) || (b1 & 0x7F) > WEBSOCKET_CONTROL_MAX)) return false;
+    return true;
+}
+
+void WebSocketReader::startPayload() {
+    _opcode = _header[0] & 0x0F;
+    uint8_t lenField = _header[1] & 0x7F;
+    size_t maskAt = 2;
+    if (lenField == 126) {
+        _remaining = (uint64_t)_header[2] << 8 | _header[3];
+        maskAt = 4;
+    } else if (lenField == 127) {
+        _remaining = 0;
+        for (int i = 0; i < 8; i++) _remaining = _remaining << 8 | _header[2 + i];
+        maskAt = 10;
+    } else {
+        _remaining = lenField;
+    }
+    memcpy(_mask, _header + maskAt, 4);
+    _maskIndex = 0;
+    _controlLen = 0;
+    _state = PAYLOAD;
+}
+
+WebSocketReader::Result WebSocketReader::feed(const uint8_t* data, size_t len, size_t& used) {
+    used = 0;
+    if (_state == FAILED) return ERROR;
+
+    size_t i = 0;
+    while (i < len) {
+        if (_state == HEADER) {
+            _header[_headerLen++] = data[i++];
+            if (_headerLen == 2) {
+                if (!validStart()) {
+                    _state = FAILED;
+                    used = i;
+                    return ERROR;
+                }
+                uint8_t lenField = _header[1] & 0x7F;
+                _headerNeed = 2 + (lenField == 126 ? 2 : lenField == 127 ? 8 : 0) + 4;
+            }
+            if (_headerLen < _headerNeed) continue;
+            startPayload();
+        } else {
+            size_t n = len - i;
+            if (n > _remaining) n = (size_t)_remaining;
+            if (_opcode & 0x08) {
+                for (size_t k = 0; k < n; k++) {
+                    _control[_controlLen++] = data[i + k] ^ _mask[_maskIndex++ & 3];
+                }
+            }
+            i += n;
+            _remaining -= n;
+        }
+
+        if (_state == PAYLOAD && _remaining == 0) {
+            _state = HEADER;
+            _headerLen = 0;
+            _headerNeed = 2;
+            if (_opcode & 0x08) {
+                used = i;
+                return CONTROL;
+            }
+        }
+    }
+    used = i;
+    return NEED_MORE;
+}
@@ -0,0 +1,83 @@
+/**
+ * RFC 6455 framing for the server end of a WebSocket.
+ *
+ * webSocketAccept() answers the opening handshake. The server's frames
+ * are unmasked, so one is just webSocketHeader() followed by the caller's
+ * payload, sent from where it is. WebSocketReader takes the client's
+ * masked frames in whatever pieces TCP delivers them; the server only
+ * sends, so data frames are read past and just the control frames
+ * (close, ping) come out, unmasked, one at a time.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WEBSOCKET_ACCEPT_SIZE 29   // base64 of a SHA-1, NUL-terminated
+#define WEBSOCKET_KEY_MAX 64       // Clients send 24 characters
+#define WEBSOCKET_HEADER_MAX 10    // Of an unmasked frame
+#define WEBSOCKET_CONTROL_MAX 125
+
+enum WebSocketOpcode : uint8_t {
+    WS_CONTINUATION = 0x0,
+    WS_TEXT = 0x1,
+    WS_BINARY = 0x2,
+    WS_CLOSE = 0x8,
+    WS_PING = 0x9,
+    WS_PONG = 0xA
+};
+
+// base64 of len bytes into out, which needs 4 * ((len + 2) / 3) + 1 bytes;
+// returns the length written, without the NUL
+size_t base64Encode(const uint8_t* data, size_t len, char* out);
+
+// Sec-WebSocket-Accept for a client's Sec-WebSocket-Key; false when the
+// key is longer than WEBSOCKET_KEY_MAX
+bool webSocketAccept(const char* key, char out[WEBSOCKET_ACCEPT_SIZE]);
+
+// Header of a final, unmasked frame carrying len bytes; returns its size
+size_t webSocketHeader(uint8_t opcode, size_t len, uint8_t out[WEBSOCKET_HEADER_MAX]);
+
+class WebSocketReader {
+public:
+    enum Result {
+        NEED_MORE = 0,
+        CONTROL,    // A whole control frame; see opcode() and payload()
+        ERROR       // Not a valid client frame: close with 1002
+    };
+
+    WebSocketReader();
+
+    void reset();
+
+    // Consume up to len bytes, stopping after each control frame
+    Result feed(const uint8_t* data, size_t len, size_t& used);
+
+    uint8_t opcode() const { return _opcode; }
+    const uint8_t* payload() const { return _control; }
+    size_t length() const { return _controlLen; }
+
+private:
+    enum State : uint8_t {
+        HEADER,
+        PAYLOAD,
+        FAILED
+    };
+
+    bool validStart() const;
+    void startPayload();
+
+    State _state;
+    uint8_t _header[14];
+    uint8_t _headerLen;
+    uint8_t _headerNeed;
+
+    uint8_t _opcode;
+    uint8_t _mask[4];
+    uint64_t _remaining;
+    uint8_t _maskIndex;
+
+    uint8_t _control[WEBSOCKET_CONTROL_MAX];
+    uint8_t _controlLen;
+};
@@ -0,0 +1,179 @@
+#include "JsonRpcDispatcher.h"
+
+#include <ctype.h>
+#include <string.h>
+
+// "sensors read", "Sensors Read" and "sensors/read" all name sensors/read
+static bool matchesCommand(const char* text, const char* id) {
+    while (*text == ' ') text++;
+    for (; *id; id++, text++) {
+        char c = (char)tolower((unsigned char)*text);
+        if (*id == '/' || *id == '_') {
+            if (c != ' ' && c != '/' && c != '_') return false;
+        } else if (c != *id) {
+            return false;
+        }
+    }
+    while (*text == ' ') text++;
+    return *text == '\0';
+}
+
+static bool isNotification(JsonVariantConst request) {
+    return request.is<JsonObjectConst>() && request["id"].isUnbound();
+}
+
+const SkillDef* JsonRpcDispatcher::find(const char* id) const {
+    if (!id) return nullptr;
+    for (size_t i = 0; i < _count; i++) {
+        if (strcmp(_skills[i].id, id) == 0) return &_skills[i];
+    }
+    return nullptr;
+}
+
+const SkillDef* JsonRpcDispatcher::findInMessage(JsonVariantConst message, JsonVariantConst& params) const {
+    for (JsonVariantConst part : message["parts"].as<JsonArrayConst>()) {
+        if (part["skill"].is<const char*>()) {
+            params = part["parameters"];
+            return find(part["skill"]);
+        }
+        if (part["data"]["skill"].is<const char*>()) {
+            params = part["data"]["parameters"];
+            return find(part["data"]["skill"]);
+        }
+        const char* text = part["text"];
+        if (text) {
+            for (size_t i = 0; i < _count; i++) {
+                if (matchesCommand(text, _skills[i].id)) {
+                    params = JsonVariantConst();
+                    return &_skills[i];
+                }
+            }
+        }
+    }
+    return nullptr;
+}
+
+// Skill a request would run, without running it
+const SkillDef* JsonRpcDispatcher::target(JsonVariantConst request) const {
+    const char* method = request["method"];
+    if (!method) return nullptr;
+    if (strcmp(method, "message/send") == 0 || strcmp(method, "tasks/send") == 0) {
+        JsonVariantConst params;
+        return findInMessage(request["params"]["message"], params);
+    }
+    return find(method);
+}
+
+void JsonRpcDispatcher::error(JsonObject response, int code, const char* message) {
+    response.remove("result");
+    JsonObject err = response["error"].to<JsonObject>();
+    err["code"] = code;
+    err["message"] = message;
+}
+
+void JsonRpcDispatcher::handleOne(JsonVariantConst request, JsonObject response) const {
+    response["jsonrpc"] = "2.0";
+    JsonVariantConst id = request["id"];
+    if (id.is<const char*>() || id.is<long>()) {
+        response["id"] = id;
+    } else {
+        response["id"] = nullptr;
+    }
+
+    const char* method = request["method"];
+    if (!request.is<JsonObjectConst>() || request["jsonrpc"] != "2.0" || !method) {
+        error(response, RPC_INVALID_REQUEST, "Invalid Request");
+        return;
+    }
+
+    JsonVariantConst params = request["params"];
+    if (strcmp(method, "message/send") == 0 || strcmp(method, "tasks/send") == 0) {
+        JsonVariantConst skillParams;
+        const SkillDef* skill = findInMessage(params["message"], skillParams);
+        if (!skill || !skill->handler) {
+            error(response, RPC_METHOD_NOT_FOUND, "Unknown skill");
+            return;
+        }
+
+        JsonObject result = response["result"].to<JsonObject>();
+        result["kind"] = "message";
+        result["role"] = "agent";
+        JsonObject part = result["parts"].to<JsonArray>().add<JsonObject>();
+        part["kind"] = "data";
+        if (!skill->handler(skillParams, part["data"].to<JsonObject>())) {
+            error(response, RPC_INVALID_PARAMS, "Invalid params");
+        }
+        return;
+    }
+
+    const SkillDef* skill = find(method);
+    if (!skill || !skill->handler) {
+        error(response, RPC_METHOD_NOT_FOUND, "Method not found");
+        return;
+    }
+    if (!skill->handler(params, response["result"].to<JsonObject>())) {
+        error(response, RPC_INVALID_PARAMS, "Invalid params");
+    }
+}
+
+// Notifications still run, but their result is discarded
+void JsonRpcDispatcher::notify(JsonVariantConst request) const {
+    JsonDocument scratch(_allocator);
+    handleOne(request, scratch.to<JsonObject>());
+}
+
+bool JsonRpcDispatcher::dispatch(const char* body, size_t len, JsonDocument& response) const {
+    JsonDocument request(_allocator);
+    if (deserializeJson(request, body, len)) {
+        JsonObject out = response.to<JsonObject>();
+        out["jsonrpc"] = "2.0";
+        out["id"] = nullptr;
+        error(out, RPC_PARSE_ERROR, "Parse error");
+        return true;
+    }
+    return dispatch(request.as<JsonVariantConst>(), response);
+}
+
+bool JsonRpcDispatcher::dispatch(JsonVariantConst request, JsonDocument& response) const {
+    if (!request.is<JsonArrayConst>()) {
+        if (isNotification(request)) {
+            notify(request);
+            return false;
+        }
+        handleOne(request, response.to<JsonObject>());
+        return true;
+    }
+
+    JsonArrayConst batch = request.as<JsonArrayConst>();
+    if (batch.size() == 0 || batch.size() > JSON_RPC_MAX_BATCH) {
+        JsonObject out = response.to<JsonObject>();
+        out["jsonrpc"] = "2.0";
+        out["id"] = nullptr;
+        error(out, RPC_INVALID_REQUEST, batch.size() ? "Batch too large" : "Invalid Request");
+        return true;
+    }
+
+    JsonArray replies = response.to<JsonArray>();
+    for (JsonVariantConst item : batch) {
+        if (isNotification(item)) {
+            notify(item);
+        } else {
+            handleOne(item, replies.add<JsonObject>());
+        }
+    }
+    return replies.size() > 0;
+}
+
+bool JsonRpcDispatcher::slow(const char* body, size_t len) const {
+    JsonDocument request(_allocator);
+    if (deserializeJson(request, body, len)) return false;
+    if (!request.is<JsonArrayConst>()) {
+        const SkillDef* skill = target(request.as<JsonVariantConst>());
+        return skill && skill->slow;
+    }
+    for (JsonVariantConst item : request.as<JsonArrayConst>()) {
+        const SkillDef* skill = target(item);
+        if (skill && skill->slow) return true;
+    }
+    return false;
+}
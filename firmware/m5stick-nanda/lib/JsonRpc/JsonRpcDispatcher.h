@@ -0,0 +1,59 @@
+/**
+ * JSON-RPC 2.0 dispatcher over a SkillDef table.
+ *
+ * Accepted methods:
+ * - "message/send" / "tasks/send": A2A message; the skill is taken from the
+ *   first part naming one ({"skill": id, "parameters": {...}}, a data part
+ *   {"data": {"skill": id, ...}}, or a text part such as "sensors read").
+ *   The result is an agent message with a data part.
+ * - any skill id (e.g. "battery/status"): the result is the skill output.
+ *
+ * Batches (a JSON array of requests) are answered with an array in the same
+ * order; notifications (requests without "id") get no response entry.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+#include "SkillTable.h"
+
+enum JsonRpcError {
+    RPC_PARSE_ERROR      = -32700,
+    RPC_INVALID_REQUEST  = -32600,
+    RPC_METHOD_NOT_FOUND = -32601,
+    RPC_INVALID_PARAMS   = -32602
+};
+
+#define JSON_RPC_MAX_BATCH 16
+
+class JsonRpcDispatcher {
+public:
+    JsonRpcDispatcher(const SkillDef* skills, size_t count,
+                      ArduinoJson::Allocator* allocator = ArduinoJson::detail::DefaultAllocator::instance())
+        : _skills(skills), _count(count), _allocator(allocator) {}
+
+    const SkillDef* find(const char* id) const;
+    const SkillDef* skills() const { return _skills; }
+    size_t count() const { return _count; }
+
+    // Parse and dispatch a request body. Returns false when nothing should
+    // be sent back (only notifications).
+    bool dispatch(const char* body, size_t len, JsonDocument& response) const;
+    bool dispatch(JsonVariantConst request, JsonDocument& response) const;
+
+    // Whether a request body (or any request of a batch) runs a slow skill
+    bool slow(const char* body, size_t len) const;
+
+private:
+    void handleOne(JsonVariantConst request, JsonObject response) const;
+    void notify(JsonVariantConst request) const;
+    const SkillDef* findInMessage(JsonVariantConst message, JsonVariantConst& params) const;
+    const SkillDef* target(JsonVariantConst request) const;
+    static void error(JsonObject response, int code, const char* message);
+
+    const SkillDef* _skills;
+    size_t _count;
+    ArduinoJson::Allocator* _allocator;   // Request and notification scratch documents
+};
@@ -0,0 +1,25 @@
+/**
+ * Compile-time skill registry entry.
+ *
+ * One table of SkillDef drives the JSON-RPC dispatcher, the tunnel and the
+ * agent card, so a skill is declared once. Handlers write their result
+ * straight into the response document.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+// Return false when params are invalid (reported as JSON-RPC -32602)
+typedef bool (*SkillHandler)(JsonVariantConst params, JsonObject result);
+
+struct SkillDef {
+    const char* id;            // e.g. "sensors/read", also a JSON-RPC method name
+    const char* name;
+    const char* description;
+    SkillHandler handler;
+    bool slow = false;         // Blocks for long (radio scan); the tunnel runs it off the callback
+};
+
+#define SKILL_COUNT(table) (sizeof(table) / sizeof((table)[0]))
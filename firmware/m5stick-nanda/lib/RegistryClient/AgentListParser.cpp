@@ -0,0 +1,256 @@
+#include "AgentListParser.h"
+
+#include <string.h>
+
+static const char* const WANTED_KEYS[] = {"handle", "url", "name", "healthy"};
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+AgentListParser::AgentListParser(AgentHandler handler, ArduinoJson::Allocator* allocator)
+    : _handler(handler), _allocator(allocator), _filter(allocator) {
+    for (const char* key : WANTED_KEYS) {
+        _filter[key] = true;
+    }
+    reset();
+}
+
+void AgentListParser::reset() {
+    _depth = 0;
+    _agentsDepth = 0;
+    _inString = false;
+    _escape = false;
+    _keyLen = 0;
+    _key[0] = '\0';
+    _inElement = false;
+    _finished = false;
+    _stopped = false;
+    _agents = 0;
+    _skipped = 0;
+}
+
+bool AgentListParser::feed(const uint8_t* data, size_t len) {
+    for (size_t i = 0; i < len && !_finished && !_stopped; i++) {
+        char c = (char)data[i];
+        if (_inElement) {
+            scanElement(c);
+        } else {
+            scanOuter(c);
+        }
+    }
+    return !_finished && !_stopped;
+}
+
+void AgentListParser::scanOuter(char c) {
+    if (_inString) {
+        if (_escape) {
+            _escape = false;
+        } else if (c == '\\') {
+            _escape = true;
+        } else if (c == '"') {
+            _inString = false;
+            _key[_keyLen < AGENT_KEY_MAX ? _keyLen : AGENT_KEY_MAX - 1] = '\0';
+        } else if (_keyLen < AGENT_KEY_MAX - 1) {
+            _key[_keyLen++] = c;
+        }
+        return;
+    }
+
+    switch (c) {
+        case '"':
+            _inString = true;
+            _keyLen = 0;
+            break;
+
+        case '{':
+            if (_agentsDepth > 0 && _depth == _agentsDepth) {
+                // New element of the agents array
+                _inElement = true;
+                _elemState = EXPECT_KEY;
+                _first = true;
+                _overflow = false;
+                _objLen = 0;
+                append('{');
+                return;
+            }
+            _depth++;
+            break;
+
+        case '[':
+            if (_agentsDepth == 0 &&
+                (_depth == 0 || (_depth == 1 && strcmp(_key, "agents") == 0))) {
+                _agentsDepth = _depth + 1;  // Bare array or {"agents": [...]}
+            }
+            _depth++;
+            break;
+
+        case '}':
+        case ']':
+            if (_depth > 0) _depth--;
+            if (_agentsDepth > 0 && _depth < _agentsDepth) {
+                _finished = true;
+            }
+            break;
+
+        case ',':
+            _keyLen = 0;
+            _key[0] = '\0';
+            break;
+
+        default:
+            break;
+    }
+}
+
+void AgentListParser::append(char c) {
+    if (_objLen < AGENT_OBJECT_MAX - 1) {
+        _obj[_objLen++] = c;
+    } else {
+        _overflow = true;
+    }
+}
+
+void AgentListParser::append(const char* s) {
+    while (*s) append(*s++);
+}
+
+void AgentListParser::scanElement(char c) {
+    switch (_elemState) {
+        case EXPECT_KEY:
+            if (c == '"') {
+                _elemState = IN_KEY;
+                _keyLen = 0;
+                _escape = false;
+            } else if (c == '}') {
+                append('}');
+                emitElement();
+            }
+            break;
+
+        case IN_KEY:
+            if (_escape) {
+                _escape = false;
+            } else if (c == '\\') {
+                _escape = true;
+            } else if (c == '"') {
+                _key[_keyLen < AGENT_KEY_MAX ? _keyLen : AGENT_KEY_MAX - 1] = '\0';
+                _elemState = EXPECT_COLON;
+                break;
+            }
+            if (_keyLen < AGENT_KEY_MAX - 1) {
+                _key[_keyLen++] = c;
+            } else {
+                _keyLen = AGENT_KEY_MAX;  // Too long to be one we want
+            }
+            break;
+
+        case EXPECT_COLON:
+            if (c == ':') {
+                _wanted = false;
+                if (_keyLen < AGENT_KEY_MAX) {
+                    for (const char* key : WANTED_KEYS) {
+                        if (strcmp(_key, key) == 0) _wanted = true;
+                    }
+                }
+                if (_wanted) {
+                    if (!_first) append(',');
+                    _first = false;
+                    append('"');
+                    append(_key);
+                    append("\":");
+                }
+                _elemState = EXPECT_VALUE;
+            }
+            break;
+
+        case EXPECT_VALUE:
+            if (isSpace(c)) break;
+            if (c == '"') {
+                if (_wanted) append('"');
+                _escape = false;
+                _elemState = VALUE_STRING;
+            } else if (c == '{' || c == '[') {
+                if (_wanted) append("null");
+                _skipDepth = 1;
+                _inString = false;
+                _escape = false;
+                _elemState = SKIP_NESTED;
+            } else {
+                if (_wanted) append(c);
+                _elemState = VALUE_SCALAR;
+            }
+            break;
+
+        case VALUE_STRING:
+            if (_wanted) append(c);
+            if (_escape) {
+                _escape = false;
+            } else if (c == '\\') {
+                _escape = true;
+            } else if (c == '"') {
+                _elemState = AFTER_VALUE;
+            }
+            break;
+
+        case VALUE_SCALAR:
+            if (c == ',' || c == '}' || isSpace(c)) {
+                _elemState = AFTER_VALUE;
+                scanElement(c);
+            } else if (_wanted) {
+                append(c);
+            }
+            break;
+
+        case SKIP_NESTED:
+            if (_inString) {
+                if (_escape) {
+                    _escape = false;
+                } else if (c == '\\') {
+                    _escape = true;
+                } else if (c == '"') {
+                    _inString = false;
+                }
+            } else if (c == '"') {
+                _inString = true;
+            } else if (c == '{' || c == '[') {
+                _skipDepth++;
+            } else if ((c == '}' || c == ']') && --_skipDepth == 0) {
+                _elemState = AFTER_VALUE;
+            }
+            break;
+
+        case AFTER_VALUE:
+            if (c == ',') {
+                _elemState = EXPECT_KEY;
+            } else if (c == '}') {
+                append('}');
+                emitElement();
+            }
+            break;
+    }
+}
+
+void AgentListParser::emitElement() {
+    _inElement = false;
+    _keyLen = 0;
+    _key[0] = '\0';
+
+    if (_overflow) {
+        _skipped++;
+        return;
+    }
+
+    JsonDocument doc(_allocator);
+    DeserializationError error = deserializeJson(doc, (const char*)_obj, _objLen,
+                                                 DeserializationOption::Filter(_filter));
+    if (error) {
+        _skipped++;
+        return;
+    }
+
+    _agents++;
+    if (!_handler(doc.as<JsonObjectConst>())) {
+        _stopped = true;
+    }
+}
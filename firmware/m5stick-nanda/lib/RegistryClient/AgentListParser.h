@@ -0,0 +1,87 @@
+/**
+ * Streaming parser for the registry's GET /agents response.
+ *
+ * Body bytes are fed straight from the HTTP stream as they arrive. A small
+ * scanner walks the JSON, finds the "agents" array and copies only the
+ * handle/url/name/healthy members of each element into a fixed buffer;
+ * nested values and every other member are skipped without being stored.
+ * Each compact element is then deserialized with a DeserializationOption
+ * Filter, so no more than one agent is ever materialized at a time.
+ *
+ * The handler may return false to stop the parse (which lets the registry
+ * client close the connection early).
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#define AGENT_OBJECT_MAX 320   // Compact element: four fields plus punctuation
+#define AGENT_KEY_MAX    16
+
+class AgentListParser {
+public:
+    // Return false to stop parsing
+    typedef std::function<bool(JsonObjectConst agent)> AgentHandler;
+
+    explicit AgentListParser(AgentHandler handler,
+                             ArduinoJson::Allocator* allocator = ArduinoJson::detail::DefaultAllocator::instance());
+
+    void reset();
+
+    // Returns false once parsing has finished, was stopped, or failed
+    bool feed(const uint8_t* data, size_t len);
+
+    bool finished() const { return _finished; }   // Closing ']' of the array seen
+    bool stopped() const { return _stopped; }     // Handler asked to stop
+    size_t agents() const { return _agents; }
+    size_t skipped() const { return _skipped; }   // Elements that did not fit
+
+private:
+    enum ElementState : uint8_t {
+        EXPECT_KEY,
+        IN_KEY,
+        EXPECT_COLON,
+        EXPECT_VALUE,
+        VALUE_STRING,
+        VALUE_SCALAR,
+        SKIP_NESTED,
+        AFTER_VALUE
+    };
+
+    void scanOuter(char c);
+    void scanElement(char c);
+    void append(char c);
+    void append(const char* s);
+    void emitElement();
+
+    AgentHandler _handler;
+    ArduinoJson::Allocator* _allocator;
+    JsonDocument _filter;
+
+    // Outer document
+    uint8_t _depth;
+    uint8_t _agentsDepth;    // Depth inside the agents array, 0 until found
+    bool _inString;
+    bool _escape;
+    char _key[AGENT_KEY_MAX];
+    uint8_t _keyLen;
+
+    // Current element
+    bool _inElement;
+    ElementState _elemState;
+    bool _wanted;
+    bool _first;
+    bool _overflow;
+    uint8_t _skipDepth;
+    char _obj[AGENT_OBJECT_MAX];
+    size_t _objLen;
+
+    bool _finished;
+    bool _stopped;
+    size_t _agents;
+    size_t _skipped;
+};
@@ -0,0 +1,123 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "AsyncTcpTransport.h"
+
+AsyncTcpTransport::AsyncTcpTransport(size_t rxSize)
+    : _state(IDLE), _mux(portMUX_INITIALIZER_UNLOCKED),
+      _rx((uint8_t*)malloc(rxSize)), _rxSize(_rx ? rxSize : 0),
+      _rxHead(0), _rxTail(0), _rxCount(0) {
+    _client.onConnect([](void* arg, AsyncClient*) {
+        ((AsyncTcpTransport*)arg)->_state = CONNECTED;
+    }, this);
+
+    _client.onError([](void* arg, AsyncClient*, int8_t) {
+        ((AsyncTcpTransport*)arg)->_state = FAILED;
+    }, this);
+
+    _client.onTimeout([](void* arg, AsyncClient*, uint32_t) {
+        ((AsyncTcpTransport*)arg)->_state = FAILED;
+    }, this);
+
+    _client.onDisconnect([](void* arg, AsyncClient*) {
+        AsyncTcpTransport* self = (AsyncTcpTransport*)arg;
+        if (self->_state == CONNECTED) {
+            self->_state = CLOSED;
+        } else if (self->_state == CONNECTING) {
+            self->_state = FAILED;
+        }
+    }, this);
+
+    _client.onData([](void* arg, AsyncClient* client, void* data, size_t len) {
+        // Hold the ack until loop() consumes the bytes
+        client->ackLater();
+        ((AsyncTcpTransport*)arg)->onData((const uint8_t*)data, len);
+    }, this);
+}
+
+AsyncTcpTransport::~AsyncTcpTransport() {
+    close();
+    free(_rx);
+}
+
+bool AsyncTcpTransport::connect(const char* host, uint16_t port) {
+    close();
+    _state = CONNECTING;
+
+    IPAddress ip;
+    bool started = ip.fromString(host) ? _client.connect(ip, port)
+                                       : _client.connect(host, port);  // async DNS
+    if (!started) {
+        _state = FAILED;
+    }
+    return started;
+}
+
+HttpTransport::State AsyncTcpTransport::state() {
+    return _state;
+}
+
+size_t AsyncTcpTransport::write(const uint8_t* data, size_t len) {
+    if (_state != CONNECTED) return 0;
+
+    size_t n = _client.space();
+    if (n == 0) return 0;
+    if (n > len) n = len;
+
+    n = _client.add((const char*)data, n);
+    if (n > 0) {
+        _client.send();
+    }
+    return n;
+}
+
+size_t AsyncTcpTransport::read(uint8_t* buf, size_t len) {
+    size_t n = 0;
+
+    portENTER_CRITICAL(&_mux);
+    while (n < len && _rxCount > 0) {
+        size_t run = _rxSize - _rxTail;
+        if (run > _rxCount) run = _rxCount;
+        if (run > len - n) run = len - n;
+        memcpy(buf + n, _rx + _rxTail, run);
+        _rxTail = (_rxTail + run) % _rxSize;
+        _rxCount -= run;
+        n += run;
+    }
+    portEXIT_CRITICAL(&_mux);
+
+    if (n > 0 && _client.connected()) {
+        _client.ack(n);  // Reopen the window for what we just drained
+    }
+    return n;
+}
+
+void AsyncTcpTransport::onData(const uint8_t* data, size_t len) {
+    portENTER_CRITICAL(&_mux);
+    size_t room = _rxSize - _rxCount;
+    if (len > room) {
+        len = room;  // Only small probe buffers get here
+    }
+    for (size_t i = 0; i < len;) {
+        size_t run = _rxSize - _rxHead;
+        if (run > len - i) run = len - i;
+        memcpy(_rx + _rxHead, data + i, run);
+        _rxHead = (_rxHead + run) % _rxSize;
+        i += run;
+    }
+    _rxCount += len;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void AsyncTcpTransport::close() {
+    if (_client.connected() || _client.connecting()) {
+        _client.close(true);
+    }
+
+    portENTER_CRITICAL(&_mux);
+    _rxHead = _rxTail = _rxCount = 0;
+    portEXIT_CRITICAL(&_mux);
+
+    _state = IDLE;
+}
+
+#endif  // ARDUINO || NANDA_HOST
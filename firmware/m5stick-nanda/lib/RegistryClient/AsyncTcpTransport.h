@@ -0,0 +1,47 @@
+/**
+ * HttpTransport backed by AsyncTCP (ESP32 only).
+ *
+ * AsyncTCP delivers data on its own task. Received bytes are parked in a
+ * ring buffer and only acknowledged to lwIP once loop() has read them, so
+ * with a window-sized buffer the sender can never overrun it. Smaller
+ * buffers (registry probes only need the status line) drop the excess.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <AsyncTCP.h>
+#include "HttpTransport.h"
+
+// Matches CONFIG_TCP_WND_DEFAULT: unacked bytes can never exceed the window
+#ifndef ASYNC_TRANSPORT_RX_SIZE
+#define ASYNC_TRANSPORT_RX_SIZE 5744
+#endif
+
+class AsyncTcpTransport : public HttpTransport {
+public:
+    explicit AsyncTcpTransport(size_t rxSize = ASYNC_TRANSPORT_RX_SIZE);
+    ~AsyncTcpTransport() override;
+
+    bool connect(const char* host, uint16_t port) override;
+    State state() override;
+    size_t write(const uint8_t* data, size_t len) override;
+    size_t read(uint8_t* buf, size_t len) override;
+    void close() override;
+
+private:
+    void onData(const uint8_t* data, size_t len);
+
+    AsyncClient _client;
+    volatile State _state;
+    portMUX_TYPE _mux;
+
+    uint8_t* _rx;     // Allocated once at construction
+    size_t _rxSize;
+    size_t _rxHead;   // Next write position (AsyncTCP task)
+    size_t _rxTail;   // Next read position (loop task)
+    size_t _rxCount;
+};
+
+#endif  // ARDUINO || NANDA_HOST
@@ -0,0 +1,166 @@
+#include "HttpResponseParser.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+HttpResponseParser::HttpResponseParser() {
+    reset();
+}
+
+void HttpResponseParser::reset(BodySink sink) {
+    _state = STATUS_LINE;
+    _sink = sink;
+    _status = 0;
+    _contentLength = -1;
+    _chunked = false;
+    _remaining = 0;
+    _lineLen = 0;
+}
+
+bool HttpResponseParser::lineComplete(uint8_t c) {
+    if (c == '\n') {
+        if (_lineLen > 0 && _line[_lineLen - 1] == '\r') _lineLen--;
+        _line[_lineLen] = '\0';
+        return true;
+    }
+    if (_lineLen < sizeof(_line) - 1) {
+        _line[_lineLen++] = (char)c;
+    }
+    return false;
+}
+
+HttpResponseParser::Result HttpResponseParser::deliver(const uint8_t* data, size_t len) {
+    if (len == 0 || !_sink) return NEED_MORE;
+    return _sink(data, len) ? NEED_MORE : STOPPED;
+}
+
+HttpResponseParser::Result HttpResponseParser::onLine() {
+    const char* line = _line;
+    _lineLen = 0;
+
+    switch (_state) {
+        case STATUS_LINE: {
+            if (strncmp(line, "HTTP/", 5) != 0) return ERROR;
+            const char* sp = strchr(line, ' ');
+            if (!sp) return ERROR;
+            _status = atoi(sp + 1);
+            if (_status < 100) return ERROR;
+            _state = HEADER_LINE;
+            return NEED_MORE;
+        }
+
+        case HEADER_LINE:
+            if (line[0] == '\0') {
+                if (_status < 200) {
+                    _state = STATUS_LINE;  // Interim 1xx, real status follows
+                } else if (_status == 204 || _status == 304) {
+                    _state = COMPLETE;
+                } else if (_chunked) {
+                    _state = CHUNK_SIZE;
+                } else if (_contentLength == 0) {
+                    _state = COMPLETE;
+                } else if (_contentLength > 0) {
+                    _remaining = (unsigned long)_contentLength;
+                    _state = BODY_LENGTH;
+                } else {
+                    _state = BODY_UNTIL_CLOSE;
+                }
+                return _state == COMPLETE ? DONE : NEED_MORE;
+            }
+            if (strncasecmp(line, "Content-Length:", 15) == 0) {
+                _contentLength = atol(line + 15);
+            } else if (strncasecmp(line, "Transfer-Encoding:", 18) == 0) {
+                _chunked = strstr(line + 18, "chunked") != nullptr;
+            }
+            return NEED_MORE;
+
+        case CHUNK_SIZE: {
+            if (!isxdigit((unsigned char)line[0])) return ERROR;
+            _remaining = strtoul(line, nullptr, 16);
+            _state = _remaining == 0 ? CHUNK_TRAILER : CHUNK_DATA;
+            return NEED_MORE;
+        }
+
+        case CHUNK_DATA_END:
+            if (line[0] != '\0') return ERROR;
+            _state = CHUNK_SIZE;
+            return NEED_MORE;
+
+        case CHUNK_TRAILER:
+            if (line[0] == '\0') {
+                _state = COMPLETE;
+                return DONE;
+            }
+            return NEED_MORE;
+
+        default:
+            return ERROR;
+    }
+}
+
+HttpResponseParser::Result HttpResponseParser::feed(const uint8_t* data, size_t len) {
+    size_t i = 0;
+
+    while (i < len) {
+        switch (_state) {
+            case STATUS_LINE:
+            case HEADER_LINE:
+            case CHUNK_SIZE:
+            case CHUNK_DATA_END:
+            case CHUNK_TRAILER:
+                if (lineComplete(data[i++])) {
+                    Result r = onLine();
+                    if (r == ERROR) {
+                        _state = FAILED;
+                        return ERROR;
+                    }
+                    if (r == DONE) return DONE;
+                }
+                break;
+
+            case BODY_LENGTH:
+            case CHUNK_DATA: {
+                size_t n = len - i;
+                if (n > _remaining) n = _remaining;
+                Result r = deliver(data + i, n);
+                i += n;
+                _remaining -= n;
+                if (r == STOPPED) return STOPPED;
+                if (_remaining == 0) {
+                    if (_state == BODY_LENGTH) {
+                        _state = COMPLETE;
+                        return DONE;
+                    }
+                    _state = CHUNK_DATA_END;
+                }
+                break;
+            }
+
+            case BODY_UNTIL_CLOSE: {
+                Result r = deliver(data + i, len - i);
+                i = len;
+                if (r == STOPPED) return STOPPED;
+                break;
+            }
+
+            case COMPLETE:
+                return DONE;
+
+            case FAILED:
+                return ERROR;
+        }
+    }
+
+    return _state == COMPLETE ? DONE : NEED_MORE;
+}
+
+HttpResponseParser::Result HttpResponseParser::finish() {
+    if (_state == BODY_UNTIL_CLOSE || _state == COMPLETE) {
+        _state = COMPLETE;
+        return DONE;
+    }
+    _state = FAILED;
+    return ERROR;
+}
@@ -0,0 +1,67 @@
+/**
+ * Incremental HTTP/1.1 response parser.
+ *
+ * Bytes are fed as they arrive from the transport; the body is handed to a
+ * sink piece by piece and never accumulated here. Handles Content-Length,
+ * chunked and close-delimited bodies.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+class HttpResponseParser {
+public:
+    enum Result {
+        NEED_MORE = 0,
+        DONE,       // Full response seen
+        STOPPED,    // Sink asked to stop reading early
+        ERROR       // Malformed response
+    };
+
+    // Return false to stop reading the body
+    typedef std::function<bool(const uint8_t* data, size_t len)> BodySink;
+
+    HttpResponseParser();
+
+    void reset(BodySink sink = nullptr);
+
+    // Consume up to len bytes
+    Result feed(const uint8_t* data, size_t len);
+
+    // Peer closed the connection
+    Result finish();
+
+    int status() const { return _status; }
+    long contentLength() const { return _contentLength; }
+
+private:
+    enum State {
+        STATUS_LINE,
+        HEADER_LINE,
+        BODY_LENGTH,
+        BODY_UNTIL_CLOSE,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        CHUNK_TRAILER,
+        COMPLETE,
+        FAILED
+    };
+
+    bool lineComplete(uint8_t c);
+    Result onLine();
+    Result deliver(const uint8_t* data, size_t len);
+
+    State _state;
+    BodySink _sink;
+    int _status;
+    long _contentLength;   // -1 when absent
+    bool _chunked;
+    unsigned long _remaining;
+
+    char _line[128];       // Longer header lines are truncated; we only need a few
+    size_t _lineLen;
+};
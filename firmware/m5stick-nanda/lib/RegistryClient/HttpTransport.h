@@ -0,0 +1,40 @@
+/**
+ * Non-blocking byte transport used by the registry client.
+ *
+ * Every call returns immediately. Progress is observed by polling state()
+ * from loop(); implementations buffer whatever arrives in between.
+ * - AsyncTcpTransport: AsyncTCP on the ESP32
+ * - TlsTransport:      WiFiClientSecure on a worker task, for https://
+ * - PosixTransport:    non-blocking sockets on the native host build
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class HttpTransport {
+public:
+    enum State {
+        IDLE = 0,
+        CONNECTING,
+        CONNECTED,
+        CLOSED,   // Peer closed; buffered bytes may still be read
+        FAILED    // Connect refused, reset or unreachable
+    };
+
+    virtual ~HttpTransport() {}
+
+    // Start connecting. Returns false if the attempt could not even start.
+    virtual bool connect(const char* host, uint16_t port) = 0;
+
+    virtual State state() = 0;
+
+    // Queue bytes for sending, returns how many were accepted (may be 0)
+    virtual size_t write(const uint8_t* data, size_t len) = 0;
+
+    // Copy out buffered bytes, returns 0 when nothing is waiting
+    virtual size_t read(uint8_t* buf, size_t len) = 0;
+
+    virtual void close() = 0;
+};
@@ -0,0 +1,107 @@
+#ifndef ARDUINO
+
+#include "PosixTransport.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+PosixTransport::PosixTransport() : _fd(-1), _state(IDLE) {}
+
+PosixTransport::~PosixTransport() {
+    close();
+}
+
+bool PosixTransport::connect(const char* host, uint16_t port) {
+    close();
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) {
+        // Name lookup blocks; host tests use literal addresses
+        addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_STREAM;
+        addrinfo* res = nullptr;
+        if (getaddrinfo(host, nullptr, &hints, &res) != 0 || !res) {
+            _state = FAILED;
+            return false;
+        }
+        addr.sin_addr = ((sockaddr_in*)res->ai_addr)->sin_addr;
+        freeaddrinfo(res);
+    }
+
+    _fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (_fd < 0) {
+        _state = FAILED;
+        return false;
+    }
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) | O_NONBLOCK);
+
+    int rc = ::connect(_fd, (sockaddr*)&addr, sizeof(addr));
+    if (rc == 0) {
+        _state = CONNECTED;
+    } else if (errno == EINPROGRESS) {
+        _state = CONNECTING;
+    } else {
+        _state = FAILED;
+    }
+    return true;
+}
+
+HttpTransport::State PosixTransport::state() {
+    if (_state != CONNECTING) return _state;
+
+    pollfd pfd = {_fd, POLLOUT, 0};
+    if (poll(&pfd, 1, 0) <= 0) return _state;
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    _state = (err == 0) ? CONNECTED : FAILED;
+    return _state;
+}
+
+size_t PosixTransport::write(const uint8_t* data, size_t len) {
+    if (_state != CONNECTED) return 0;
+
+    ssize_t n = send(_fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EWOULDBLOCK) _state = FAILED;
+        return 0;
+    }
+    return (size_t)n;
+}
+
+size_t PosixTransport::read(uint8_t* buf, size_t len) {
+    if (_fd < 0 || (_state != CONNECTED && _state != CLOSED)) return 0;
+
+    ssize_t n = recv(_fd, buf, len, MSG_DONTWAIT);
+    if (n > 0) return (size_t)n;
+    if (n == 0) {
+        _state = CLOSED;
+    } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        _state = FAILED;
+    }
+    return 0;
+}
+
+void PosixTransport::close() {
+    if (_fd >= 0) {
+        ::close(_fd);
+        _fd = -1;
+    }
+    _state = IDLE;
+}
+
+#endif  // !ARDUINO
@@ -0,0 +1,30 @@
+/**
+ * HttpTransport over non-blocking POSIX sockets (native host build only).
+ *
+ * Used by the host tests to run the registry state machines against real
+ * loopback servers.
+ */
+
+#pragma once
+
+#ifndef ARDUINO
+
+#include "HttpTransport.h"
+
+class PosixTransport : public HttpTransport {
+public:
+    PosixTransport();
+    ~PosixTransport() override;
+
+    bool connect(const char* host, uint16_t port) override;
+    State state() override;
+    size_t write(const uint8_t* data, size_t len) override;
+    size_t read(uint8_t* buf, size_t len) override;
+    void close() override;
+
+private:
+    int _fd;
+    State _state;
+};
+
+#endif  // !ARDUINO
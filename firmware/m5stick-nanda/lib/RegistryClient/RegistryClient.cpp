@@ -0,0 +1,229 @@
+#include "RegistryClient.h"
+
+#include <ArduinoJson.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static bool deadlinePassed(uint32_t now, uint32_t deadline) {
+    return (int32_t)(now - deadline) >= 0;
+}
+
+RegistryClient::RegistryClient(HttpTransport& transport, HttpTransport* secure)
+    : _transport(transport), _secure(secure), _port(0), _supported(false), _tls(false),
+      _queueHead(0), _queueCount(0), _stage(IDLE), _op(REG_REGISTER),
+      _deadline(0), _result(0), _txLen(0), _txSent(0) {
+    _host[0] = '\0';
+    _basePath[0] = '\0';
+    _handle[0] = '\0';
+    _selfUrl[0] = '\0';
+}
+
+bool RegistryClient::begin(const char* registryUrl) {
+    _host[0] = '\0';
+    _basePath[0] = '\0';
+    _port = 80;
+    _supported = false;
+    _tls = false;
+
+    const char* p = registryUrl;
+    if (strncmp(p, "http://", 7) == 0) {
+        p += 7;
+        _supported = true;
+    } else if (strncmp(p, "https://", 8) == 0) {
+        p += 8;
+        _port = 443;
+        _tls = _secure != nullptr;
+        _supported = _tls;
+    } else {
+        _supported = true;
+    }
+
+    size_t hostLen = strcspn(p, ":/");
+    if (hostLen == 0 || hostLen >= sizeof(_host)) {
+        _supported = false;
+        return false;
+    }
+    memcpy(_host, p, hostLen);
+    _host[hostLen] = '\0';
+
+    if (p[hostLen] == ':') {
+        _port = (uint16_t)atoi(p + hostLen + 1);
+    }
+
+    // A registry mounted under a path prefix, e.g. http://host:3000/nanda
+    const char* path = strchr(p + hostLen, '/');
+    size_t pathLen = path ? strcspn(path, "?#") : 0;
+    while (pathLen > 0 && path[pathLen - 1] == '/') pathLen--;
+    if (pathLen >= sizeof(_basePath)) {
+        _supported = false;
+        return false;
+    }
+    memcpy(_basePath, path, pathLen);
+    _basePath[pathLen] = '\0';
+    return _supported;
+}
+
+void RegistryClient::setIdentity(const char* handle, const char* selfUrl) {
+    snprintf(_handle, sizeof(_handle), "%s", handle);
+    snprintf(_selfUrl, sizeof(_selfUrl), "%s", selfUrl);
+}
+
+bool RegistryClient::enqueue(RegistryOp op) {
+    if (_stage != IDLE && _op == op) return true;
+    for (uint8_t i = 0; i < _queueCount; i++) {
+        if (_queue[(_queueHead + i) % REGISTRY_QUEUE_SIZE] == op) return true;
+    }
+    if (_queueCount >= REGISTRY_QUEUE_SIZE) return false;
+
+    _queue[(_queueHead + _queueCount) % REGISTRY_QUEUE_SIZE] = op;
+    _queueCount++;
+    return true;
+}
+
+size_t RegistryClient::buildRequest(RegistryOp op) {
+    char body[160];
+    size_t bodyLen = 0;
+    const char* method = "POST";
+    const char* path = "/agents";
+
+    if (op == REG_DISCOVER) {
+        method = "GET";
+    } else {
+        JsonDocument doc;
+        doc["handle"] = _handle;
+        if (op == REG_REGISTER) {
+            doc["url"] = _selfUrl;
+        } else {
+            path = "/heartbeat";
+            doc["status"] = "healthy";
+        }
+        bodyLen = serializeJson(doc, body, sizeof(body));
+    }
+
+    int n = snprintf(_tx, sizeof(_tx),
+                     "%s %s%s HTTP/1.1\r\n"
+                     "Host: %s:%u\r\n"
+                     "Connection: close\r\n",
+                     method, _basePath, path, _host, (unsigned)_port);
+    if (bodyLen > 0) {
+        n += snprintf(_tx + n, sizeof(_tx) - n,
+                      "Content-Type: application/json\r\n"
+                      "Content-Length: %u\r\n\r\n%.*s",
+                      (unsigned)bodyLen, (int)bodyLen, body);
+    } else {
+        n += snprintf(_tx + n, sizeof(_tx) - n, "\r\n");
+    }
+    return n < (int)sizeof(_tx) ? (size_t)n : sizeof(_tx) - 1;
+}
+
+void RegistryClient::start(RegistryOp op, uint32_t now) {
+    _op = op;
+    _result = 0;
+
+    if (_host[0] == '\0') {
+        finish(REG_ERR_NO_REGISTRY);
+        return;
+    }
+    if (!_supported) {
+        finish(REG_ERR_UNSUPPORTED);
+        return;
+    }
+
+    _txLen = buildRequest(op);
+    _txSent = 0;
+    _parser.reset([this](const uint8_t* data, size_t len) {
+        return _onBody ? _onBody(_op, data, len) : true;
+    });
+
+    if (!transport().connect(_host, _port)) {
+        finish(REG_ERR_CONNECT);
+        return;
+    }
+    _stage = CONNECTING;
+    _deadline = now + (_tls ? REGISTRY_TLS_CONNECT_TIMEOUT : REGISTRY_CONNECT_TIMEOUT);
+}
+
+void RegistryClient::finish(int status) {
+    transport().close();
+    _stage = IDLE;
+    if (_onComplete) {
+        _onComplete(_op, status);
+    }
+}
+
+void RegistryClient::poll(uint32_t now) {
+    switch (_stage) {
+        case IDLE:
+            if (_queueCount > 0) {
+                RegistryOp op = _queue[_queueHead];
+                _queueHead = (_queueHead + 1) % REGISTRY_QUEUE_SIZE;
+                _queueCount--;
+                start(op, now);
+            }
+            break;
+
+        case CONNECTING: {
+            HttpTransport::State st = transport().state();
+            if (st == HttpTransport::CONNECTED) {
+                _stage = SENDING;
+                _deadline = now + REGISTRY_IO_TIMEOUT;
+            } else if (st == HttpTransport::FAILED || st == HttpTransport::CLOSED) {
+                finish(REG_ERR_CONNECT);
+            } else if (deadlinePassed(now, _deadline)) {
+                finish(REG_ERR_TIMEOUT);
+            }
+            break;
+        }
+
+        case SENDING:
+            _txSent += transport().write((const uint8_t*)_tx + _txSent, _txLen - _txSent);
+            if (_txSent >= _txLen) {
+                _stage = RECEIVING;
+            } else if (transport().state() == HttpTransport::FAILED) {
+                finish(REG_ERR_CONNECT);
+            } else if (deadlinePassed(now, _deadline)) {
+                finish(REG_ERR_TIMEOUT);
+            }
+            break;
+
+        case RECEIVING: {
+            uint8_t buf[256];
+            size_t budget = REGISTRY_POLL_BUDGET;
+            HttpResponseParser::Result r = HttpResponseParser::NEED_MORE;
+
+            while (budget > 0 && r == HttpResponseParser::NEED_MORE) {
+                size_t n = transport().read(buf, budget < sizeof(buf) ? budget : sizeof(buf));
+                if (n == 0) break;
+                budget -= n;
+                r = _parser.feed(buf, n);
+            }
+
+            if (r == HttpResponseParser::NEED_MORE) {
+                HttpTransport::State st = transport().state();
+                if (st == HttpTransport::CLOSED) {
+                    r = _parser.finish();
+                } else if (st == HttpTransport::FAILED) {
+                    r = HttpResponseParser::ERROR;
+                } else if (deadlinePassed(now, _deadline)) {
+                    finish(REG_ERR_TIMEOUT);
+                    break;
+                }
+            }
+
+            if (r == HttpResponseParser::DONE || r == HttpResponseParser::STOPPED) {
+                _result = _parser.status();
+                _stage = PARSING;
+            } else if (r == HttpResponseParser::ERROR) {
+                _result = REG_ERR_PROTOCOL;
+                _stage = PARSING;
+            }
+            break;
+        }
+
+        case PARSING:
+            // Response fully consumed; hand the result over on its own tick
+            finish(_result);
+            break;
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * Non-blocking NANDA registry client.
+ *
+ * Register, heartbeat and discovery requests are queued and driven by an
+ * explicit per-request state machine:
+ *
+ *   IDLE -> CONNECTING -> SENDING -> RECEIVING -> PARSING -> IDLE
+ *
+ * poll() is called from loop() and only ever does a bounded amount of work
+ * before returning, so a slow or dead registry can no longer stall buttons,
+ * the tunnel or the display. Each stage has its own deadline.
+ *
+ * An https:// registry goes through a second, TLS transport when one is
+ * given; without one it is reported REG_ERR_UNSUPPORTED.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+
+#include "HttpResponseParser.h"
+#include "HttpTransport.h"
+
+#define REGISTRY_CONNECT_TIMEOUT 3000   // ms to establish TCP
+#define REGISTRY_TLS_CONNECT_TIMEOUT 10000   // ms for TCP and the TLS handshake
+#define REGISTRY_IO_TIMEOUT      5000   // ms for request + response
+#define REGISTRY_POLL_BUDGET     1024   // Max bytes read per poll()
+#define REGISTRY_QUEUE_SIZE      4
+
+enum RegistryOp {
+    REG_REGISTER = 0,
+    REG_HEARTBEAT,
+    REG_DISCOVER
+};
+
+// Negative status codes reported instead of an HTTP status
+enum RegistryError {
+    REG_ERR_CONNECT = -1,       // Refused, unreachable or DNS failure
+    REG_ERR_TIMEOUT = -2,
+    REG_ERR_PROTOCOL = -3,      // Malformed HTTP response
+    REG_ERR_UNSUPPORTED = -4,   // URL scheme we cannot speak (https without a TLS transport)
+    REG_ERR_NO_REGISTRY = -5
+};
+
+class RegistryClient {
+public:
+    enum Stage {
+        IDLE = 0,
+        CONNECTING,
+        SENDING,
+        RECEIVING,
+        PARSING
+    };
+
+    // Body bytes as they arrive. Return false to stop reading (not an error).
+    typedef std::function<bool(RegistryOp op, const uint8_t* data, size_t len)> BodyHandler;
+    // Called once per request with the HTTP status or a RegistryError
+    typedef std::function<void(RegistryOp op, int status)> CompleteHandler;
+
+    // secure carries https:// registries; nullptr leaves them unsupported
+    explicit RegistryClient(HttpTransport& transport, HttpTransport* secure = nullptr);
+
+    // Registry base URL, e.g. "http://192.168.1.10:3000" or "https://registry.example.com/nanda";
+    // requests go to /agents and /heartbeat under its path
+    bool begin(const char* registryUrl);
+    void setIdentity(const char* handle, const char* selfUrl);
+
+    void onBody(BodyHandler handler) { _onBody = handler; }
+    void onComplete(CompleteHandler handler) { _onComplete = handler; }
+
+    // Queue a request; duplicates of an already pending op are merged
+    bool enqueue(RegistryOp op);
+
+    // Advance the current request; never blocks
+    void poll(uint32_t now);
+
+    bool busy() const { return _stage != IDLE || _queueCount > 0; }
+    Stage stage() const { return _stage; }
+    const char* host() const { return _host; }
+    uint16_t port() const { return _port; }
+
+private:
+    void start(RegistryOp op, uint32_t now);
+    void finish(int status);
+    size_t buildRequest(RegistryOp op);
+    HttpTransport& transport() { return _tls ? *_secure : _transport; }
+
+    HttpTransport& _transport;
+    HttpTransport* _secure;
+    HttpResponseParser _parser;
+    BodyHandler _onBody;
+    CompleteHandler _onComplete;
+
+    char _host[64];
+    char _basePath[64];   // Without a trailing slash; empty at the root
+    uint16_t _port;
+    bool _supported;
+    bool _tls;
+    char _handle[48];
+    char _selfUrl[64];
+
+    RegistryOp _queue[REGISTRY_QUEUE_SIZE];
+    uint8_t _queueHead;
+    uint8_t _queueCount;
+
+    Stage _stage;
+    RegistryOp _op;
+    uint32_t _deadline;
+    int _result;
+
+    char _tx[384];
+    size_t _txLen;
+    size_t _txSent;
+};
@@ -0,0 +1,217 @@
+#include "RegistryProbe.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+RegistryProbe::RegistryProbe(HttpTransport** slots, uint8_t slotCount)
+    : _transports(slots),
+      _slotCount(slotCount > PROBE_MAX_SLOTS ? PROBE_MAX_SLOTS : slotCount),
+      _batch(_slotCount), _count(0), _next(0), _timeout(PROBE_TIMEOUT),
+      _running(false), _winner(-1) {
+    for (uint8_t i = 0; i < PROBE_MAX_SLOTS; i++) {
+        _slots[i].candidate = -1;
+    }
+}
+
+uint32_t RegistryProbe::parseIp(const char* ip) {
+    uint32_t out = 0;
+    for (int part = 0; part < 4; part++) {
+        if (*ip < '0' || *ip > '9') return 0;
+        unsigned long v = strtoul(ip, (char**)&ip, 10);
+        if (v > 255 || (part < 3 && *ip++ != '.')) return 0;
+        out = (out << 8) | v;
+    }
+    return out;
+}
+
+void RegistryProbe::formatIp(uint32_t ip, char* out, size_t len) {
+    snprintf(out, len, "%u.%u.%u.%u",
+             (unsigned)(ip >> 24), (unsigned)((ip >> 16) & 0xff),
+             (unsigned)((ip >> 8) & 0xff), (unsigned)(ip & 0xff));
+}
+
+void RegistryProbe::clear() {
+    cancelAll(0);
+    _count = 0;
+    _next = 0;
+    _running = false;
+    _winner = -1;
+}
+
+bool RegistryProbe::addCandidate(uint32_t ip, uint16_t port) {
+    if (ip == 0 || _count >= PROBE_MAX_CANDIDATES) return false;
+    for (size_t i = 0; i < _count; i++) {
+        if (_candidates[i].ip == ip && _candidates[i].port == port) return true;
+    }
+
+    Candidate& c = _candidates[_count++];
+    c.ip = ip;
+    c.port = port;
+    c.status = 0;
+    c.latencyMs = 0;
+    c.state = PENDING;
+    return true;
+}
+
+bool RegistryProbe::addCandidate(const char* ip, uint16_t port) {
+    return addCandidate(parseIp(ip), port);
+}
+
+bool RegistryProbe::addUrl(const char* url) {
+    if (strncmp(url, "http://", 7) == 0) url += 7;
+
+    char host[16];
+    size_t hostLen = strcspn(url, ":/");
+    if (hostLen == 0 || hostLen >= sizeof(host)) return false;
+    memcpy(host, url, hostLen);
+    host[hostLen] = '\0';
+
+    uint16_t port = url[hostLen] == ':' ? (uint16_t)atoi(url + hostLen + 1) : 80;
+    return addCandidate(host, port);
+}
+
+size_t RegistryProbe::addSubnetSweep(uint32_t subnet, uint16_t port, uint8_t first, uint8_t last) {
+    size_t added = 0;
+    uint32_t base = subnet & 0xffffff00;
+    for (unsigned host = first; host <= last; host++) {
+        if (addCandidate(base | host, port)) added++;
+    }
+    return added;
+}
+
+bool RegistryProbe::winnerUrl(char* out, size_t len) const {
+    if (_winner < 0) return false;
+    char ip[16];
+    formatIp(_candidates[_winner].ip, ip, sizeof(ip));
+    snprintf(out, len, "http://%s:%u", ip, (unsigned)_candidates[_winner].port);
+    return true;
+}
+
+void RegistryProbe::start(uint32_t now) {
+    _next = 0;
+    _winner = -1;
+    _running = _count > 0;
+    poll(now);
+}
+
+void RegistryProbe::launch(Slot& slot, HttpTransport& transport, uint32_t now) {
+    while (_next < _count) {
+        size_t idx = _next++;
+        Candidate& c = _candidates[idx];
+        if (c.state != PENDING) continue;
+
+        char ip[16];
+        formatIp(c.ip, ip, sizeof(ip));
+        if (!transport.connect(ip, c.port)) {
+            c.state = FAILED;
+            continue;
+        }
+        c.state = ACTIVE;
+        slot.candidate = (int16_t)idx;
+        slot.stage = 0;
+        slot.txSent = 0;
+        slot.startMs = now;
+        slot.parser.reset();
+        return;
+    }
+}
+
+void RegistryProbe::release(Slot& slot, HttpTransport& transport, CandidateState state, uint32_t now) {
+    Candidate& c = _candidates[slot.candidate];
+    c.state = state;
+    c.latencyMs = (uint16_t)(now - slot.startMs);
+    transport.close();
+    slot.candidate = -1;
+}
+
+void RegistryProbe::cancelAll(uint32_t now) {
+    for (uint8_t i = 0; i < _slotCount; i++) {
+        if (_slots[i].candidate >= 0) {
+            release(_slots[i], *_transports[i], CANCELLED, now);
+        }
+    }
+    for (size_t i = _next; i < _count; i++) {
+        if (_candidates[i].state == PENDING) _candidates[i].state = CANCELLED;
+    }
+    _next = _count;
+}
+
+bool RegistryProbe::poll(uint32_t now) {
+    if (!_running) return false;
+
+    int best = -1;
+    bool active = false;
+
+    for (uint8_t i = 0; i < _batch; i++) {
+        Slot& slot = _slots[i];
+        HttpTransport& transport = *_transports[i];
+
+        if (slot.candidate < 0) {
+            launch(slot, transport, now);
+            if (slot.candidate < 0) continue;
+        }
+        active = true;
+
+        HttpTransport::State st = transport.state();
+        if (st == HttpTransport::FAILED) {
+            release(slot, transport, FAILED, now);
+            continue;
+        }
+
+        if (slot.stage == 0 && st == HttpTransport::CONNECTED) {
+            slot.stage = 1;
+        }
+
+        if (slot.stage == 1) {
+            char ip[16];
+            char req[80];
+            Candidate& c = _candidates[slot.candidate];
+            formatIp(c.ip, ip, sizeof(ip));
+            int len = snprintf(req, sizeof(req),
+                               "GET /health HTTP/1.1\r\nHost: %s:%u\r\nConnection: close\r\n\r\n",
+                               ip, (unsigned)c.port);
+            slot.txSent += transport.write((const uint8_t*)req + slot.txSent, len - slot.txSent);
+            if (slot.txSent >= len) slot.stage = 2;
+        }
+
+        if (slot.stage == 2) {
+            // Only the status line matters; stop as soon as it has been parsed
+            uint8_t buf[64];
+            size_t n;
+            while (slot.parser.status() == 0 && (n = transport.read(buf, sizeof(buf))) > 0) {
+                if (slot.parser.feed(buf, n) == HttpResponseParser::ERROR) break;
+            }
+
+            int status = slot.parser.status();
+            if (status != 0) {
+                Candidate& c = _candidates[slot.candidate];
+                c.status = (int16_t)status;
+                int idx = slot.candidate;
+                release(slot, transport, ANSWERED, now);
+                if (status == 200 && (best < 0 || c.latencyMs < _candidates[best].latencyMs)) {
+                    best = idx;
+                }
+                continue;
+            }
+            if (transport.state() == HttpTransport::CLOSED) {
+                release(slot, transport, FAILED, now);
+                continue;
+            }
+        }
+
+        if ((uint32_t)(now - slot.startMs) >= _timeout) {
+            release(slot, transport, FAILED, now);
+        }
+    }
+
+    if (best >= 0) {
+        _winner = best;
+        _candidates[best].state = WON;
+        cancelAll(now);
+        _running = false;
+    } else if (!active && _next >= _count) {
+        _running = false;  // Everything answered or failed, nobody won
+    }
+    return _running;
+}
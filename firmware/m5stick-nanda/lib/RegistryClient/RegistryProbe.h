@@ -0,0 +1,96 @@
+/**
+ * Parallel registry probe.
+ *
+ * Opens GET /health against every candidate at once (up to the number of
+ * transport slots it was given), refilling slots as probes finish. The
+ * first candidate to answer 200 wins and every other probe is cancelled.
+ * Because all candidates race concurrently, the winner is the one with the
+ * lowest measured latency rather than the first one in the list.
+ *
+ * Candidates are IPv4 literals; a whole /24 can be swept as well.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "HttpResponseParser.h"
+#include "HttpTransport.h"
+
+#define PROBE_MAX_CANDIDATES 272   // 16 named + a full /24 sweep
+#define PROBE_MAX_SLOTS      16
+#define PROBE_TIMEOUT        1500  // ms per candidate
+
+class RegistryProbe {
+public:
+    enum CandidateState : uint8_t {
+        PENDING = 0,
+        ACTIVE,
+        ANSWERED,    // Responded, but not with 200
+        FAILED,      // Refused, reset or timed out
+        CANCELLED,   // Another candidate won first
+        WON
+    };
+
+    struct Candidate {
+        uint32_t ip;           // Host order: a.b.c.d is a << 24 | ... | d
+        uint16_t port;
+        int16_t status;        // HTTP status when answered
+        uint16_t latencyMs;    // Connect start to status line
+        CandidateState state;
+    };
+
+    // slots: transports the probe may use concurrently (the batch size)
+    RegistryProbe(HttpTransport** slots, uint8_t slotCount);
+
+    void clear();
+    bool addCandidate(uint32_t ip, uint16_t port);
+    bool addCandidate(const char* ip, uint16_t port);
+    bool addUrl(const char* url);
+    // Queue a.b.c.first .. a.b.c.last for the /24 containing subnet
+    size_t addSubnetSweep(uint32_t subnet, uint16_t port, uint8_t first = 1, uint8_t last = 254);
+
+    void setTimeout(uint16_t ms) { _timeout = ms; }
+    // Cap concurrent probes below the slot count (lwIP has few free PCBs)
+    void setBatchSize(uint8_t n) { _batch = (n == 0 || n > _slotCount) ? _slotCount : n; }
+
+    void start(uint32_t now);
+    // Advance all in-flight probes; returns true while the probe is running
+    bool poll(uint32_t now);
+
+    bool running() const { return _running; }
+    int winner() const { return _winner; }
+    bool winnerUrl(char* out, size_t len) const;
+
+    size_t count() const { return _count; }
+    const Candidate& candidate(size_t i) const { return _candidates[i]; }
+
+    static uint32_t parseIp(const char* ip);
+    static void formatIp(uint32_t ip, char* out, size_t len);
+
+private:
+    struct Slot {
+        int16_t candidate;     // -1 when free
+        uint8_t stage;         // 0 connecting, 1 sending, 2 receiving
+        uint8_t txSent;
+        uint32_t startMs;
+        HttpResponseParser parser;
+    };
+
+    void launch(Slot& slot, HttpTransport& transport, uint32_t now);
+    void release(Slot& slot, HttpTransport& transport, CandidateState state, uint32_t now);
+    void cancelAll(uint32_t now);
+
+    HttpTransport** _transports;
+    uint8_t _slotCount;
+    uint8_t _batch;
+    Slot _slots[PROBE_MAX_SLOTS];
+
+    Candidate _candidates[PROBE_MAX_CANDIDATES];
+    size_t _count;
+    size_t _next;            // Next PENDING candidate to launch
+    uint16_t _timeout;
+    bool _running;
+    int _winner;
+};
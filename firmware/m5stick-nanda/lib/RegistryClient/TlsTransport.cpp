@@ -0,0 +1,168 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "TlsTransport.h"
+
+TlsTransport::TlsTransport(size_t rxSize)
+    : _task(nullptr), _state(IDLE), _serial(0), _mux(portMUX_INITIALIZER_UNLOCKED), _port(0),
+      _rx((uint8_t*)malloc(rxSize)), _rxSize(_rx ? rxSize : 0),
+      _rxHead(0), _rxTail(0), _rxCount(0), _txLen(0) {
+    _host[0] = '\0';
+    _client.setInsecure();
+    _client.setHandshakeTimeout(TLS_CONNECT_TIMEOUT / 1000);
+}
+
+bool TlsTransport::connect(const char* host, uint16_t port) {
+    if (!_rx) return false;
+    // Started with the first connection, and kept: the registry is used for as long as WiFi is up
+    if (!_task && xTaskCreatePinnedToCore(task, "tls", 8192, this, 1, &_task, ARDUINO_RUNNING_CORE) != pdPASS) {
+        _task = nullptr;
+        return false;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    snprintf(_host, sizeof(_host), "%s", host);
+    _port = port;
+    _serial++;
+    _state = CONNECTING;
+    _rxHead = _rxTail = _rxCount = 0;
+    _txLen = 0;
+    portEXIT_CRITICAL(&_mux);
+
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+HttpTransport::State TlsTransport::state() {
+    return _state;
+}
+
+size_t TlsTransport::write(const uint8_t* data, size_t len) {
+    portENTER_CRITICAL(&_mux);
+    size_t n = 0;
+    if (_state == CONNECTED) {
+        n = sizeof(_tx) - _txLen;
+        if (n > len) n = len;
+        memcpy(_tx + _txLen, data, n);
+        _txLen += n;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return n;
+}
+
+size_t TlsTransport::read(uint8_t* buf, size_t len) {
+    size_t n = 0;
+
+    portENTER_CRITICAL(&_mux);
+    while (n < len && _rxCount > 0) {
+        size_t run = _rxSize - _rxTail;
+        if (run > _rxCount) run = _rxCount;
+        if (run > len - n) run = len - n;
+        memcpy(buf + n, _rx + _rxTail, run);
+        _rxTail = (_rxTail + run) % _rxSize;
+        _rxCount -= run;
+        n += run;
+    }
+    portEXIT_CRITICAL(&_mux);
+    return n;
+}
+
+void TlsTransport::close() {
+    portENTER_CRITICAL(&_mux);
+    _serial++;
+    _state = IDLE;
+    _rxHead = _rxTail = _rxCount = 0;
+    _txLen = 0;
+    portEXIT_CRITICAL(&_mux);
+}
+
+void TlsTransport::task(void* arg) {
+    ((TlsTransport*)arg)->run();
+}
+
+// The worker: one connection per notification, for as long as loop() wants it
+void TlsTransport::run() {
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        char host[sizeof(_host)];
+        uint16_t port;
+        portENTER_CRITICAL(&_mux);
+        uint32_t serial = _serial;
+        bool wanted = _state == CONNECTING;
+        memcpy(host, _host, sizeof(host));
+        port = _port;
+        portEXIT_CRITICAL(&_mux);
+        if (!wanted) continue;
+
+        bool connected = _client.connect(host, port, TLS_CONNECT_TIMEOUT);
+        settle(serial, connected ? CONNECTED : FAILED);
+        if (connected) {
+            while (_serial == serial) {
+                if (!pump(serial)) vTaskDelay(pdMS_TO_TICKS(TLS_POLL_MS));
+            }
+        }
+        _client.stop();
+    }
+}
+
+// Moves what it can each way; false when nothing moved. A connection
+// that is over is settled, and ends the worker's loop.
+bool TlsTransport::pump(uint32_t serial) {
+    uint8_t buf[256];
+    bool moved = false;
+
+    portENTER_CRITICAL(&_mux);
+    size_t n = _serial == serial ? _txLen : 0;
+    if (n > sizeof(buf)) n = sizeof(buf);
+    memcpy(buf, _tx, n);
+    portEXIT_CRITICAL(&_mux);
+    if (n > 0) {
+        size_t sent = _client.write(buf, n);
+        portENTER_CRITICAL(&_mux);
+        if (_serial == serial && sent > 0) {
+            memmove(_tx, _tx + sent, _txLen - sent);
+            _txLen -= sent;
+        }
+        portEXIT_CRITICAL(&_mux);
+        moved = sent > 0;
+    }
+
+    portENTER_CRITICAL(&_mux);
+    size_t room = _rxSize - _rxCount;
+    portEXIT_CRITICAL(&_mux);
+    int available = _client.available();
+    if (available > 0 && room > 0) {
+        if (room > sizeof(buf)) room = sizeof(buf);
+        int got = _client.read(buf, room);
+        portENTER_CRITICAL(&_mux);
+        for (int i = 0; _serial == serial && i < got;) {
+            size_t run = _rxSize - _rxHead;
+            if (run > (size_t)(got - i)) run = got - i;
+            memcpy(_rx + _rxHead, buf + i, run);
+            _rxHead = (_rxHead + run) % _rxSize;
+            _rxCount += run;
+            i += run;
+        }
+        portEXIT_CRITICAL(&_mux);
+        moved = moved || got > 0;
+    } else if (available <= 0 && !_client.connected()) {
+        // Closed with the request unsent is a failure; after it, the end of the response
+        portENTER_CRITICAL(&_mux);
+        State state = _txLen > 0 ? FAILED : CLOSED;
+        portEXIT_CRITICAL(&_mux);
+        settle(serial, state);
+        portENTER_CRITICAL(&_mux);
+        if (_serial == serial) _serial++;   // Nothing more to move: off to the next connection
+        portEXIT_CRITICAL(&_mux);
+    }
+    return moved;
+}
+
+// Unless loop() has moved on from this connection
+void TlsTransport::settle(uint32_t serial, State state) {
+    portENTER_CRITICAL(&_mux);
+    if (_serial == serial) _state = state;
+    portEXIT_CRITICAL(&_mux);
+}
+
+#endif  // ARDUINO || NANDA_HOST
@@ -0,0 +1,64 @@
+/**
+ * HttpTransport over TLS, for https:// registries (ESP32 only).
+ *
+ * WiFiClientSecure blocks, and its handshake alone takes a second or more,
+ * so the connection lives on a worker task of its own. loop() only touches
+ * two buffers: the request waiting to go out and a ring of received bytes,
+ * which the worker moves to and from the connection. Certificates are not
+ * checked, as with the public registry list.
+ *
+ * The worker serves one connection at a time. One opened while the last
+ * is still being dropped starts once it is; a connection loop() has
+ * closed is dropped at the worker's next pass.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <WiFiClientSecure.h>
+#include "HttpTransport.h"
+
+#ifndef TLS_TRANSPORT_RX_SIZE
+#define TLS_TRANSPORT_RX_SIZE 2048
+#endif
+#define TLS_TRANSPORT_TX_SIZE 384      // RegistryClient's largest request
+#define TLS_CONNECT_TIMEOUT 10000      // ms for TCP and the handshake
+#define TLS_POLL_MS 10                 // Worker's pause when nothing moved
+
+class TlsTransport : public HttpTransport {
+public:
+    explicit TlsTransport(size_t rxSize = TLS_TRANSPORT_RX_SIZE);
+
+    bool connect(const char* host, uint16_t port) override;
+    State state() override;
+    size_t write(const uint8_t* data, size_t len) override;
+    size_t read(uint8_t* buf, size_t len) override;
+    void close() override;
+
+private:
+    static void task(void* arg);
+    void run();
+    bool pump(uint32_t serial);
+    void settle(uint32_t serial, State state);
+
+    WiFiClientSecure _client;   // The worker's alone
+    TaskHandle_t _task;
+    volatile State _state;
+    volatile uint32_t _serial;  // Of the connection loop() wants; close() moves it on
+    portMUX_TYPE _mux;
+
+    char _host[64];
+    uint16_t _port;
+
+    uint8_t* _rx;     // Allocated once at construction
+    size_t _rxSize;
+    size_t _rxHead;   // Next write position (worker)
+    size_t _rxTail;   // Next read position (loop task)
+    size_t _rxCount;
+
+    uint8_t _tx[TLS_TRANSPORT_TX_SIZE];
+    size_t _txLen;
+};
+
+#endif  // ARDUINO || NANDA_HOST
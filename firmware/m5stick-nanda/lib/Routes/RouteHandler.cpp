@@ -0,0 +1,139 @@
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include "RouteHandler.h"
+
+#include <BodyAssembler.h>
+#include <new>
+
+const char* const* RouteHandler::headers() const {
+    static const char* const KEEP[] = {"If-None-Match", "Accept-Encoding", nullptr};
+    return KEEP;
+}
+
+void RouteHandler::handleRequest(HttpRequest& request) {
+    const RouteDef* route = find(request);
+    if (!route) {
+        request.send(404);
+        return;
+    }
+    if (!(route->methods & request.method())) {
+        request.send(405, "application/json", "{\"error\":\"Method not allowed\"}");
+        return;
+    }
+
+    switch (route->kind) {
+        case ROUTE_CARD:
+            _card.handleRequest(request);
+            break;
+        case ROUTE_RPC:
+            sendRpc(request);
+            break;
+        case ROUTE_SKILL:
+            sendSkill(request, *route);
+            break;
+        case ROUTE_RAW:
+            route->http(request);
+            break;
+        case ROUTE_PAGE:
+            sendPage(request, *route);
+            break;
+    }
+}
+
+// From the head, so a client waiting on 100 Continue never sends the body
+bool RouteHandler::acceptBody(HttpRequest& request, size_t total) {
+    const RouteDef* route = find(request);
+    if (!route || route->kind != ROUTE_RPC || !(route->methods & request.method())) return true;
+    if (total <= _maxBody) return true;
+    request.send(413, "application/json", "{\"error\":\"Request body too large\"}");
+    return false;
+}
+
+// Called once per TCP segment
+void RouteHandler::handleBody(HttpRequest& request, const uint8_t* data, size_t len, size_t index, size_t total) {
+    const RouteDef* route = find(request);
+    if (!route || route->kind != ROUTE_RPC || !(route->methods & request.method())) return;
+
+    if (index == 0) {
+        // Small bodies fit behind the parsed head; the server frees the rest
+        size_t room;
+        uint8_t* scratch = request.scratch(room);
+        if (room >= sizeof(BodyAssembler) + total + 1) {
+            request.tempObject = new (scratch) BodyAssembler((char*)scratch + sizeof(BodyAssembler),
+                                                             room - sizeof(BodyAssembler));
+        } else {
+            request.tempObject = BodyAssembler::create(total, _maxBody);
+        }
+        if (!request.tempObject) {
+            request.send(503, "application/json", "{\"error\":\"Out of memory\"}");
+            return;
+        }
+    }
+
+    BodyAssembler* body = (BodyAssembler*)request.tempObject;
+    if (!body) return;  // Already answered
+
+    BodyAssembler::Result result = body->feed(data, len, index, total);
+    if (result != BodyAssembler::PENDING && result != BodyAssembler::COMPLETE) {
+        request.send(400, "application/json", "{\"error\":\"Malformed request body\"}");
+    }
+}
+
+// Once the whole body is in
+void RouteHandler::sendRpc(HttpRequest& request) {
+    BodyAssembler* body = (BodyAssembler*)request.tempObject;
+    if (!body || !body->complete()) {
+        request.send(400, "application/json", "{\"error\":\"Empty request body\"}");
+        return;
+    }
+
+    JsonDocument reply;
+    if (!_rpc.dispatch(body->data(), body->length(), reply)) {
+        request.send(204);  // Notifications only
+        return;
+    }
+    request.send(request.beginJson(200, reply));
+}
+
+// Run the route's skill and send its result as the response
+void RouteHandler::sendSkill(HttpRequest& request, const RouteDef& route) {
+    const SkillDef* skill = _rpc.find(route.target);
+    if (!skill) {
+        request.send(404, "application/json", "{\"error\":\"Unknown skill\"}");
+        return;
+    }
+
+    auto query = [&request](const char* name, char* buf, size_t size) {
+        return request.param(name, buf, size);
+    };
+    JsonDocument params;
+    if (route.queryCount) routeParams(route, params.to<JsonObject>(), query);
+    JsonDocument doc;
+    if (!skill->handler(params.as<JsonVariantConst>(), doc.to<JsonObject>())) {
+        request.send(400, "application/json", "{\"error\":\"Invalid params\"}");
+        return;
+    }
+    HttpResponse& response = request.beginJson(200, doc);
+    response.addHeader("Cache-Control", routeCacheControl(route.cache));
+    request.send(response);
+}
+
+// Straight from flash. A page from web/ is 304 to a client that has it
+// and goes gzipped to one that takes gzip.
+void RouteHandler::sendPage(HttpRequest& request, const RouteDef& route) {
+    HttpResponse* response;
+    if (routeEtagMatches(request.header("If-None-Match"), route.etag)) {
+        response = &request.beginResponse(304);
+    } else if (route.gzip && routeAcceptsGzip(request.header("Accept-Encoding"))) {
+        response = &request.beginFlashResponse(200, route.target, route.gzip, route.gzipLen);
+        response->addHeader("Content-Encoding", "gzip");
+    } else {
+        response = &request.beginFlashResponse(200, route.target, (const uint8_t*)route.body, route.bodyLen);
+    }
+    if (route.gzip) response->addHeader("Vary", "Accept-Encoding");
+    if (route.etag) response->addHeader("ETag", route.etag);
+    response->addHeader("Cache-Control", routeCacheControl(route.cache));
+    request.send(*response);
+}
+
+#endif  // ARDUINO || NANDA_HOST
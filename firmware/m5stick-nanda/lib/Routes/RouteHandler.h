@@ -0,0 +1,50 @@
+/**
+ * HttpServer handler that serves a RouteTable (ESP32 only).
+ *
+ * Every request is one perfect-hash lookup of its path; a path in the
+ * table with a method it does not take is answered 405, one that is not
+ * in it 404. Of the request's headers only If-None-Match and
+ * Accept-Encoding are kept.
+ *
+ * JSON-RPC bodies arrive in segments and are put together by a
+ * BodyAssembler in the request's tempObject: in the request's scratch
+ * space when they fit there, in one block from the heap when they do
+ * not. One declared larger than maxBody is refused 413 from its head,
+ * before any of it is read.
+ */
+
+#pragma once
+
+#if defined(ARDUINO) || defined(NANDA_HOST)
+
+#include <HttpServer.h>
+#include <AgentCardHandler.h>
+#include <JsonRpcDispatcher.h>
+
+#include "RouteTable.h"
+
+class RouteHandler : public HttpHandler {
+public:
+    RouteHandler(const RouteTable& routes, const JsonRpcDispatcher& rpc, const AgentCard& card, size_t maxBody)
+        : _routes(routes), _rpc(rpc), _card(card), _maxBody(maxBody) {}
+
+    const char* const* headers() const override;
+    void handleRequest(HttpRequest& request) override;
+    bool acceptBody(HttpRequest& request, size_t total) override;
+    void handleBody(HttpRequest& request, const uint8_t* data, size_t len, size_t index, size_t total) override;
+
+private:
+    const RouteDef* find(const HttpRequest& request) const {
+        return _routes.find(request.path(), request.pathLength());
+    }
+    void sendRpc(HttpRequest& request);
+    void sendSkill(HttpRequest& request, const RouteDef& route);
+    void sendPage(HttpRequest& request, const RouteDef& route);
+
+    const RouteTable& _routes;
+    const JsonRpcDispatcher& _rpc;
+    AgentCardHandler _card;
+    size_t _maxBody;
+};
+
+#endif  // ARDUINO || NANDA_HOST
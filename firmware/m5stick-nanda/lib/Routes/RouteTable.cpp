@@ -0,0 +1,69 @@
+#include "RouteTable.h"
+
+#include <strings.h>
+
+uint8_t routeMethod(const char* name) {
+    static const struct {
+        const char* name;
+        uint8_t bit;
+    } METHODS[] = {
+        {"GET", ROUTE_GET}, {"POST", ROUTE_POST}, {"DELETE", ROUTE_DELETE}, {"PUT", ROUTE_PUT},
+        {"PATCH", ROUTE_PATCH}, {"HEAD", ROUTE_HEAD}, {"OPTIONS", ROUTE_OPTIONS}
+    };
+    if (!name) return 0;
+    for (size_t i = 0; i < sizeof(METHODS) / sizeof(METHODS[0]); i++) {
+        if (strcmp(name, METHODS[i].name) == 0) return METHODS[i].bit;
+    }
+    return 0;
+}
+
+const char* routeCacheControl(RouteCache cache) {
+    switch (cache) {
+        case ROUTE_REVALIDATE: return "no-cache";
+        case ROUTE_CACHEABLE: return ROUTE_MAX_AGE;
+        default: return "no-store";
+    }
+}
+
+// Past a leading W/, which weak comparison ignores
+static const char* opaqueTag(const char* tag) {
+    return tag[0] == 'W' && tag[1] == '/' ? tag + 2 : tag;
+}
+
+bool routeEtagMatches(const char* ifNoneMatch, const char* etag) {
+    if (!ifNoneMatch || !etag) return false;
+    etag = opaqueTag(etag);
+    size_t etagLen = strlen(etag);
+    const char* p = ifNoneMatch;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        if (*p == '*') return true;
+        p = opaqueTag(p);
+        size_t n = strcspn(p, ", \t");
+        if (n == etagLen && strncmp(p, etag, n) == 0) return true;
+        p += n;
+    }
+    return false;
+}
+
+bool routeAcceptsGzip(const char* acceptEncoding) {
+    if (!acceptEncoding) return false;
+    const char* p = acceptEncoding;
+    while (*p) {
+        while (*p == ' ' || *p == '\t' || *p == ',') p++;
+        size_t n = strcspn(p, ",; \t");
+        bool gzip = (n == 4 && strncasecmp(p, "gzip", 4) == 0) || (n == 6 && strncasecmp(p, "x-gzip", 6) == 0);
+        p += n;
+        // ;q=0, ;q=0.0 and so on refuse it
+        const char* end = p + strcspn(p, ",");
+        const char* q = p;
+        while (q < end && (*q == ' ' || *q == '\t' || *q == ';')) q++;
+        bool refused = false;
+        if (q + 2 <= end && (q[0] == 'q' || q[0] == 'Q') && q[1] == '=') {
+            refused = atof(q + 2) <= 0.0;
+        }
+        if (gzip) return !refused;
+        p = end;
+    }
+    return false;
+}
@@ -0,0 +1,316 @@
+/**
+ * Declarative route table shared by the HTTP server and the registry tunnel.
+ *
+ * Each RouteDef names a method set, an exact path, what answers it and how
+ * clients may cache the answer:
+ *
+ *   ROUTE_CARD    the cached agent card, 304 on If-None-Match
+ *   ROUTE_RPC     a JSON-RPC body for the dispatcher
+ *   ROUTE_SKILL   a GET running one skill, query values mapped to params
+ *   ROUTE_RAW     a non-JSON body from the firmware (screenshots)
+ *   ROUTE_PAGE    a static body compiled into flash (HTML pages); those
+ *                 built from web/ by scripts/web-assets.py also carry a
+ *                 gzipped copy and an ETag
+ *
+ * RouteMatcher turns a constexpr table into a perfect hash while the
+ * firmware compiles: paths are hashed into small buckets and each bucket
+ * gets the displacement that sends its paths to free slots. A lookup is
+ * one FNV-1a pass over the path, one mix and one string compare, however
+ * many routes there are. Declare the matcher constexpr and static_assert
+ * valid(), so a table that cannot be hashed (duplicate paths) fails the
+ * build rather than the request.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ROUTE_QUERY_VALUE_MAX 128   // Decoded ?text= and friends
+#define ROUTE_MAX_AGE "max-age=300"
+#define ROUTE_COUNT(table) (sizeof(table) / sizeof((table)[0]))
+
+class HttpRequest;
+
+// Same bits as HttpMethod
+enum RouteMethod : uint8_t {
+    ROUTE_GET = 0x01,
+    ROUTE_POST = 0x02,
+    ROUTE_DELETE = 0x04,
+    ROUTE_PUT = 0x08,
+    ROUTE_PATCH = 0x10,
+    ROUTE_HEAD = 0x20,
+    ROUTE_OPTIONS = 0x40
+};
+
+enum RouteKind : uint8_t {
+    ROUTE_CARD = 0,
+    ROUTE_RPC,
+    ROUTE_SKILL,
+    ROUTE_RAW,
+    ROUTE_PAGE
+};
+
+enum RouteCache : uint8_t {
+    ROUTE_NO_STORE = 0,   // Live readings and actions
+    ROUTE_REVALIDATE,     // Has an ETag; ask every time
+    ROUTE_CACHEABLE       // Fixed until the next flash; ROUTE_MAX_AGE
+};
+
+// ?query= of a skill route, passed to the skill as params[param]. Numbers
+// that are absent get fallback; absent text is left out.
+struct RouteQuery {
+    const char* query;
+    const char* param;
+    bool number;
+    int32_t fallback;
+};
+
+// Writes a raw body of up to room bytes at out, sets len and returns the
+// HTTP status; on anything but 200 the tunnel answers with a JSON error
+typedef int (*RouteFrameWriter)(uint8_t* out, size_t room, size_t& len);
+// Answers a raw route over HTTP, e.g. with a chunked response
+typedef void (*RouteHttpHandler)(HttpRequest& request);
+
+struct RouteDef {
+    const char* path;            // Exact; requests match without their query string
+    uint8_t methods;             // RouteMethod bits
+    RouteKind kind;
+    RouteCache cache;
+    const char* target;          // Skill id (SKILL), content type (RAW, PAGE)
+    const RouteQuery* query;     // SKILL
+    uint8_t queryCount;
+    const char* body;            // PAGE
+    size_t bodyLen;
+    const uint8_t* gzip;         // PAGE from web/: body gzipped, nullptr for others
+    size_t gzipLen;
+    const char* etag;            // PAGE from web/: weak, the same for both encodings
+    RouteFrameWriter write;      // RAW, tunnel
+    RouteHttpHandler http;       // RAW, HTTP
+    bool slow;                   // RAW: run on the tunnel worker, see TunnelScheduler
+};
+
+constexpr RouteDef routeCard(const char* path) {
+    return {path, ROUTE_GET, ROUTE_CARD, ROUTE_REVALIDATE, "application/json", nullptr, 0, nullptr, 0,
+            nullptr, 0, nullptr, nullptr, nullptr, false};
+}
+
+constexpr RouteDef routeRpc(const char* path) {
+    return {path, ROUTE_POST, ROUTE_RPC, ROUTE_NO_STORE, "application/json", nullptr, 0, nullptr, 0,
+            nullptr, 0, nullptr, nullptr, nullptr, false};
+}
+
+constexpr RouteDef routeSkill(const char* path, const char* skill) {
+    return {path, ROUTE_GET, ROUTE_SKILL, ROUTE_NO_STORE, skill, nullptr, 0, nullptr, 0, nullptr, 0, nullptr,
+            nullptr, nullptr, false};
+}
+
+template <size_t Q>
+constexpr RouteDef routeSkill(const char* path, const char* skill, const RouteQuery (&query)[Q]) {
+    return {path, ROUTE_GET, ROUTE_SKILL, ROUTE_NO_STORE, skill, query, (uint8_t)Q, nullptr, 0,
+            nullptr, 0, nullptr, nullptr, nullptr, false};
+}
+
+constexpr RouteDef routeRaw(const char* path, const char* contentType, RouteFrameWriter write,
+                            RouteHttpHandler http, bool slow) {
+    return {path, ROUTE_GET, ROUTE_RAW, ROUTE_NO_STORE, contentType, nullptr, 0, nullptr, 0, nullptr, 0, nullptr,
+            write, http, slow};
+}
+
+template <size_t L>
+constexpr RouteDef routePage(const char* path, const char* contentType, const char (&body)[L]) {
+    return {path, ROUTE_GET, ROUTE_PAGE, ROUTE_CACHEABLE, contentType, nullptr, 0, body, L - 1,
+            nullptr, 0, nullptr, nullptr, nullptr, false};
+}
+
+// A page from lib/WebAssets/WebAssets.h, e.g.
+//   routePage("/", "text/html", WEB_INDEX_HTML, WEB_INDEX_HTML_GZ, WEB_INDEX_HTML_ETAG)
+template <size_t L, size_t G>
+constexpr RouteDef routePage(const char* path, const char* contentType, const char (&body)[L],
+                             const uint8_t (&gzip)[G], const char* etag) {
+    return {path, ROUTE_GET, ROUTE_PAGE, ROUTE_CACHEABLE, contentType, nullptr, 0, body, L - 1,
+            gzip, G, etag, nullptr, nullptr, false};
+}
+
+// "GET" -> ROUTE_GET; 0 for anything else, including ""
+uint8_t routeMethod(const char* name);
+
+// Cache-Control value for a route's policy
+const char* routeCacheControl(RouteCache cache);
+
+// Whether an If-None-Match value names etag, by weak comparison ("*" does)
+bool routeEtagMatches(const char* ifNoneMatch, const char* etag);
+
+// Whether an Accept-Encoding value takes gzip (not when its q is 0)
+bool routeAcceptsGzip(const char* acceptEncoding);
+
+// Copy the route's query values into params. get(name, buf, size) writes a
+// request's value, decoded and NUL-terminated, and returns whether it has one.
+template <typename Get>
+void routeParams(const RouteDef& route, JsonObject params, Get get) {
+    char value[ROUTE_QUERY_VALUE_MAX];
+    for (uint8_t i = 0; i < route.queryCount; i++) {
+        const RouteQuery& q = route.query[i];
+        bool present = get(q.query, value, sizeof(value));
+        if (q.number) {
+            params[q.param] = present ? atoi(value) : q.fallback;
+        } else if (present) {
+            params[q.param] = value;
+        }
+    }
+}
+
+constexpr size_t routeLength(const char* s) {
+    size_t n = 0;
+    while (s[n]) n++;
+    return n;
+}
+
+// FNV-1a
+constexpr uint32_t routeHash(const char* s, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)s[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// The path hash displaced by d, mixed as in MurmurHash3's finalizer
+constexpr uint32_t routeSlotHash(uint32_t h, uint8_t d) {
+    h += d * 0x9E3779B9u;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Smallest power of two >= n
+constexpr size_t routePow2(size_t n) {
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+#define ROUTE_EMPTY 0xFF
+
+// The lookup side of a RouteMatcher, whatever its size
+class RouteTable {
+public:
+    constexpr bool valid() const { return _valid; }
+    constexpr size_t size() const { return _count; }
+    const RouteDef& operator[](size_t i) const { return _routes[i]; }
+
+    // The route for a path, compared up to len; nullptr if there is none
+    const RouteDef* find(const char* path, size_t len) const {
+        if (!_valid) return nullptr;
+        uint32_t h = routeHash(path, len);
+        uint8_t i = _slots[routeSlotHash(h, _displace[h & _bucketMask]) & _slotMask];
+        if (i == ROUTE_EMPTY) return nullptr;
+        const RouteDef& route = _routes[i];
+        return strncmp(route.path, path, len) == 0 && route.path[len] == '\0' ? &route : nullptr;
+    }
+    // Up to the query string
+    const RouteDef* find(const char* path) const { return find(path, strcspn(path, "?")); }
+
+protected:
+    constexpr RouteTable(const RouteDef* routes, size_t count, const uint8_t* displace, uint32_t bucketMask,
+                         const uint8_t* slots, uint32_t slotMask)
+        : _routes(routes), _count(count), _displace(displace), _bucketMask(bucketMask), _slots(slots),
+          _slotMask(slotMask), _valid(false) {}
+
+    const RouteDef* _routes;
+    size_t _count;
+    const uint8_t* _displace;   // Per bucket
+    uint32_t _bucketMask;
+    const uint8_t* _slots;      // Route index per slot, ROUTE_EMPTY if free
+    uint32_t _slotMask;
+    bool _valid;
+};
+
+template <size_t N>
+class RouteMatcher : public RouteTable {
+    static_assert(N > 0 && N < ROUTE_EMPTY, "a route table holds 1 to 254 routes");
+
+public:
+    static constexpr size_t SLOTS = routePow2(N);
+    static constexpr size_t BUCKETS = routePow2((N + 3) / 4);
+
+    constexpr explicit RouteMatcher(const RouteDef (&routes)[N])
+        : RouteTable(routes, N, _displaceTable, BUCKETS - 1, _slotTable, SLOTS - 1), _displaceTable{}, _slotTable{} {
+        _valid = build(routes);
+    }
+    // The base points into this object
+    RouteMatcher(const RouteMatcher&) = delete;
+    RouteMatcher& operator=(const RouteMatcher&) = delete;
+
+private:
+    constexpr bool build(const RouteDef (&routes)[N]) {
+        uint32_t hashes[N] = {};
+        for (size_t i = 0; i < N; i++) {
+            size_t len = routeLength(routes[i].path);
+            for (size_t j = 0; j < i; j++) {
+                if (routeLength(routes[j].path) == len && same(routes[i].path, routes[j].path, len)) return false;
+            }
+            hashes[i] = routeHash(routes[i].path, len);
+        }
+        for (size_t s = 0; s < SLOTS; s++) _slotTable[s] = ROUTE_EMPTY;
+
+        uint8_t sizes[BUCKETS] = {};
+        bool placed[BUCKETS] = {};
+        for (size_t i = 0; i < N; i++) sizes[hashes[i] & (BUCKETS - 1)]++;
+
+        // Fullest buckets first, while most slots are free
+        for (size_t step = 0; step < BUCKETS; step++) {
+            size_t b = BUCKETS;
+            for (size_t k = 0; k < BUCKETS; k++) {
+                if (!placed[k] && (b == BUCKETS || sizes[k] > sizes[b])) b = k;
+            }
+            placed[b] = true;
+            if (sizes[b] == 0) continue;
+            if (!place(hashes, b)) return false;
+        }
+        return true;
+    }
+
+    // Find a displacement that puts every path of bucket b in a free slot
+    constexpr bool place(const uint32_t (&hashes)[N], size_t b) {
+        for (unsigned d = 0; d < 256; d++) {
+            bool fits = true;
+            for (size_t i = 0; i < N && fits; i++) {
+                if ((hashes[i] & (BUCKETS - 1)) != b) continue;
+                size_t s = routeSlotHash(hashes[i], d) & (SLOTS - 1);
+                if (_slotTable[s] == ROUTE_EMPTY) {
+                    _slotTable[s] = (uint8_t)i;
+                } else {
+                    fits = false;
+                }
+            }
+            if (fits) {
+                _displaceTable[b] = (uint8_t)d;
+                return true;
+            }
+            for (size_t i = 0; i < N; i++) {
+                if ((hashes[i] & (BUCKETS - 1)) != b) continue;
+                size_t s = routeSlotHash(hashes[i], d) & (SLOTS - 1);
+                if (_slotTable[s] == i) _slotTable[s] = ROUTE_EMPTY;
+            }
+        }
+        return false;
+    }
+
+    static constexpr bool same(const char* a, const char* b, size_t len) {
+        for (size_t i = 0; i < len; i++) {
+            if (a[i] != b[i]) return false;
+        }
+        return true;
+    }
+
+    uint8_t _displaceTable[BUCKETS];
+    uint8_t _slotTable[SLOTS];
+};
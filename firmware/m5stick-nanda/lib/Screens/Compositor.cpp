@@ -0,0 +1,94 @@
+#include "Compositor.h"
+
+static int32_t area(const DirtyRect& r) {
+    return (int32_t)r.w * r.h;
+}
+
+static DirtyRect bounds(const DirtyRect& a, const DirtyRect& b) {
+    int16_t left = a.x < b.x ? a.x : b.x;
+    int16_t top = a.y < b.y ? a.y : b.y;
+    int16_t right = a.x + a.w > b.x + b.w ? a.x + a.w : b.x + b.w;
+    int16_t bottom = a.y + a.h > b.y + b.h ? a.y + a.h : b.y + b.h;
+    return {left, top, (int16_t)(right - left), (int16_t)(bottom - top)};
+}
+
+static bool touches(const Widget& widget, const DirtyRect& r) {
+    return widget.x < r.x + r.w && r.x < widget.x + widget.w && widget.y < r.y + r.h && r.y < widget.y + widget.h;
+}
+
+void Compositor::markDirty(int x, int y, int w, int h) {
+    LovyanGFX& canvas = _frame.canvas();
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > canvas.width()) w = canvas.width() - x;
+    if (y + h > canvas.height()) h = canvas.height() - y;
+    if (w <= 0 || h <= 0) return;
+
+    DirtyRect rect = {(int16_t)x, (int16_t)y, (int16_t)w, (int16_t)h};
+    if (_dirtyCount < COMPOSITOR_MAX_RECTS) {
+        _dirty[_dirtyCount++] = rect;
+    } else {
+        // Out of slots: grow the last one rather than lose the change
+        _dirty[_dirtyCount - 1] = bounds(_dirty[_dirtyCount - 1], rect);
+    }
+}
+
+void Compositor::mergeDirty() {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < _dirtyCount && !merged; i++) {
+            for (int j = i + 1; j < _dirtyCount; j++) {
+                DirtyRect joined = bounds(_dirty[i], _dirty[j]);
+                if (area(joined) <= area(_dirty[i]) + area(_dirty[j]) + COMPOSITOR_MERGE_SLACK) {
+                    _dirty[i] = joined;
+                    _dirty[j] = _dirty[--_dirtyCount];
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void Compositor::compose(int screen, const Widgets& widgets) {
+    LovyanGFX& canvas = _frame.canvas();
+    PixelSurface surface = _frame.surface();
+    int count = widgets.count();
+    _dirtyCount = 0;
+
+    if (screen != _screen) {
+        widgets.draw(canvas, _background, surface);
+        _frame.present();
+        _dirty[_dirtyCount++] = {0, 0, (int16_t)canvas.width(), (int16_t)canvas.height()};
+    } else {
+        int slots = count > _lastCount ? count : _lastCount;
+        for (int i = 0; i < slots; i++) {
+            bool had = i < _lastCount;
+            bool has = i < count;
+            if (had && has && _last[i] == widgets[i]) continue;
+            if (had) markDirty(_last[i].x, _last[i].y, _last[i].w, _last[i].h);
+            if (has) markDirty(widgets[i].x, widgets[i].y, widgets[i].w, widgets[i].h);
+        }
+        mergeDirty();
+
+        // Repaint each region from scratch, in declaration order, so
+        // overlapping widgets stack as they do in a full repaint
+        for (int r = 0; r < _dirtyCount; r++) {
+            const DirtyRect& rect = _dirty[r];
+            canvas.setClipRect(rect.x, rect.y, rect.w, rect.h);
+            canvas.fillRect(rect.x, rect.y, rect.w, rect.h, _background);
+            for (int i = 0; i < count; i++) {
+                if (touches(widgets[i], rect)) widgets[i].draw(canvas, surface);
+            }
+        }
+        canvas.clearClipRect();
+        _frame.present(_dirty, _dirtyCount);
+    }
+
+    for (int i = 0; i < count; i++) {
+        _last[i] = widgets[i];
+    }
+    _lastCount = count;
+    _screen = screen;
+}
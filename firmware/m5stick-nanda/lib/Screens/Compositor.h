@@ -0,0 +1,51 @@
+/**
+ * Pushes only the parts of a screen that changed.
+ *
+ * compose() keeps the widgets it drew last time. For the next frame of
+ * the same screen it compares the two lists slot by slot; a widget that
+ * differs marks both its old and its new rectangle dirty, and so does a
+ * widget that appeared or went away. Nearby rectangles are merged, each
+ * dirty region is cleared and every widget that touches it is redrawn
+ * clipped to it, and only those regions are pushed to the panel.
+ *
+ * A different screen, or a panel that something else has drawn on since
+ * (call invalidate()), gets a full repaint.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "FrameBuffer.h"
+#include "Widgets.h"
+
+#define COMPOSITOR_MAX_RECTS 8
+// Merge two rectangles when their bounding box wastes at most this many pixels
+#define COMPOSITOR_MERGE_SLACK 256
+
+class Compositor {
+public:
+    explicit Compositor(FrameBuffer& frame, uint16_t background = TFT_BLACK)
+        : _frame(frame), _background(background), _screen(-1), _lastCount(0), _dirtyCount(0) {}
+
+    // Show `widgets` as the next frame of `screen`
+    void compose(int screen, const Widgets& widgets);
+    // The panel no longer shows the last frame; repaint fully next time
+    void invalidate() { _screen = -1; }
+
+    // Regions pushed by the last compose()
+    int dirtyCount() const { return _dirtyCount; }
+    const DirtyRect& dirty(int index) const { return _dirty[index]; }
+
+private:
+    void markDirty(int x, int y, int w, int h);
+    void mergeDirty();
+
+    FrameBuffer& _frame;
+    uint16_t _background;
+    int _screen;
+    Widget _last[WIDGET_MAX];
+    int _lastCount;
+    DirtyRect _dirty[COMPOSITOR_MAX_RECTS];
+    int _dirtyCount;
+};
@@ -0,0 +1,46 @@
+#include "FrameBuffer.h"
+
+bool FrameBuffer::begin() {
+    int32_t width = _display->width();
+    int32_t height = _display->height();
+    if (buffered() && _sprite.width() == width && _sprite.height() == height) return true;
+
+    _sprite.deleteSprite();
+    _sprite.setColorDepth(16);
+    _sprite.setPsram(true);
+    if (!_sprite.createSprite(width, height)) {
+        _sprite.setPsram(false);
+        _sprite.createSprite(width, height);
+    }
+    return buffered();
+}
+
+PixelSurface FrameBuffer::surface() {
+    if (!buffered()) return {nullptr, 0, 0};
+    return {(uint16_t*)_sprite.getBuffer(), (int16_t)_sprite.width(), (int16_t)_sprite.height()};
+}
+
+void FrameBuffer::present() {
+    _lastFrameBytes = 0;
+    if (buffered()) {
+        _sprite.pushSprite(0, 0);
+        _lastFrameBytes = (uint32_t)_sprite.width() * _sprite.height() * 2;
+    }
+    _bytesPushed += _lastFrameBytes;
+    _frames++;
+}
+
+void FrameBuffer::present(const DirtyRect* rects, int count) {
+    _lastFrameBytes = 0;
+    if (buffered()) {
+        for (int i = 0; i < count; i++) {
+            const DirtyRect& r = rects[i];
+            _display->setClipRect(r.x, r.y, r.w, r.h);
+            _sprite.pushSprite(0, 0);
+            _lastFrameBytes += (uint32_t)r.w * r.h * 2;
+        }
+        _display->clearClipRect();
+    }
+    _bytesPushed += _lastFrameBytes;
+    _frames++;
+}
@@ -0,0 +1,61 @@
+/**
+ * Off-screen frame for the menu screens.
+ *
+ * A screen is drawn into a full-panel LGFX_Sprite and reaches the display
+ * in a single pushSprite() per frame: one window setup and one burst of
+ * pixels instead of a fillScreen() followed by dozens of small writes, so
+ * the panel never shows the black flash of a half-drawn screen.
+ *
+ * The sprite (240x135 RGB565, about 64 KB) comes from PSRAM when the board
+ * has it, otherwise from internal DMA-capable RAM. If neither has room,
+ * canvas() is the display itself and present() does nothing: screens are
+ * then drawn directly, as before.
+ *
+ * present() can also push just some rectangles of the frame, each as one
+ * clipped pushSprite(): a single setWindow() and only that region's
+ * pixels on the bus.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdint.h>
+
+#include "Particles.h"
+
+struct DirtyRect {
+    int16_t x, y, w, h;
+};
+
+class FrameBuffer {
+public:
+    explicit FrameBuffer(LovyanGFX* display)
+        : _display(display), _sprite(display), _frames(0), _lastFrameBytes(0), _bytesPushed(0) {}
+
+    // Allocate a frame the size of the display (call after setRotation())
+    bool begin();
+    void end() { _sprite.deleteSprite(); }
+
+    bool buffered() const { return _sprite.getBuffer() != nullptr; }
+    // Where to draw the next frame
+    LovyanGFX& canvas() { return buffered() ? (LovyanGFX&)_sprite : *_display; }
+    // Show the frame drawn on canvas()
+    void present();
+    // Show only these regions of it; the rest of the panel is left as it is
+    void present(const DirtyRect* rects, int count);
+
+    const LGFX_Sprite& sprite() const { return _sprite; }
+    // The frame's pixels for direct drawing; no pixels when not buffered
+    PixelSurface surface();
+    uint32_t frames() const { return _frames; }
+    // Pixel bytes sent to the panel by the last present(), and in total
+    uint32_t lastFrameBytes() const { return _lastFrameBytes; }
+    uint64_t bytesPushed() const { return _bytesPushed; }
+
+private:
+    LovyanGFX* _display;
+    LGFX_Sprite _sprite;
+    uint32_t _frames;
+    uint32_t _lastFrameBytes;
+    uint64_t _bytesPushed;
+};
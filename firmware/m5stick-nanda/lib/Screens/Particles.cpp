@@ -0,0 +1,82 @@
+#include "Particles.h"
+
+// Two pixels per store; may_alias because the buffer is declared uint16_t
+typedef uint32_t __attribute__((__may_alias__)) PixelPair;
+
+static inline uint16_t swap565(uint16_t color) {
+    return (uint16_t)((color << 8) | (color >> 8));
+}
+
+// Scale a native RGB565 colour by level/256, channel by channel
+static inline uint16_t fade565(uint16_t color, uint32_t level) {
+    uint32_t r = ((color >> 11) & 0x1F) * level >> 8;
+    uint32_t g = ((color >> 5) & 0x3F) * level >> 8;
+    uint32_t b = (color & 0x1F) * level >> 8;
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+// One row: a leading pixel to reach 4-byte alignment, pairs, a trailing pixel
+static inline void fillSpan(uint16_t* p, int len, uint16_t pixel, uint32_t pair) {
+    if (((uintptr_t)p & 2) && len > 0) {
+        *p++ = pixel;
+        len--;
+    }
+    PixelPair* q = (PixelPair*)p;
+    for (; len >= 2; len -= 2) {
+        *q++ = pair;
+    }
+    if (len) *(uint16_t*)q = pixel;
+}
+
+static inline void fillClipped(const PixelSurface& s, int x, int y, int w, int h, uint16_t pixel, uint32_t pair) {
+    if (x < 0) { w += x; x = 0; }
+    if (y < 0) { h += y; y = 0; }
+    if (x + w > s.width) w = s.width - x;
+    if (y + h > s.height) h = s.height - y;
+    if (w <= 0 || h <= 0) return;
+
+    uint16_t* row = s.pixels + (int32_t)y * s.width + x;
+    for (; h > 0; h--, row += s.width) {
+        fillSpan(row, w, pixel, pair);
+    }
+}
+
+void fillSurface(const PixelSurface& surface, int x, int y, int w, int h, uint16_t color) {
+    uint16_t pixel = swap565(color);
+    fillClipped(surface, x, y, w, h, pixel, pixel | (uint32_t)pixel << 16);
+}
+
+bool ParticleSystem::spawn(int x, int y, int vx, int vy, int size, uint16_t color, uint32_t born, uint16_t lifeMs) {
+    if (_count >= PARTICLE_MAX) return false;
+    int i = _count++;
+    _x[i] = x;
+    _y[i] = y;
+    _vx[i] = vx;
+    _vy[i] = vy;
+    _born[i] = born;
+    _life[i] = lifeMs;
+    _color[i] = color;
+    _size[i] = size;
+    return true;
+}
+
+void ParticleSystem::draw(LovyanGFX& gfx, const PixelSurface& surface, uint32_t now) const {
+    for (int i = 0; i < _count; i++) {
+        if (now < _born[i]) continue;
+        int32_t age = (int32_t)(now - _born[i]);
+        uint16_t color = _color[i];
+        if (_life[i]) {
+            if (age >= _life[i]) continue;
+            color = fade565(color, 256 - ((uint32_t)age << 8) / _life[i]);
+        }
+        int x = _x[i] + _vx[i] * age / 1000;
+        int y = _y[i] + _vy[i] * age / 1000;
+
+        if (surface.pixels) {
+            uint16_t pixel = swap565(color);
+            fillClipped(surface, x, y, _size[i], _size[i], pixel, pixel | (uint32_t)pixel << 16);
+        } else {
+            gfx.fillRect(x, y, _size[i], _size[i], color);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/**
+ * Particles drawn straight into a frame buffer.
+ *
+ * Drawing a few hundred 2-12 px squares through fillRect() costs far more
+ * in per-call overhead (startWrite, clipping, setWindow) than in pixels.
+ * Here every particle of a frame goes through one tight loop instead: the
+ * square is clipped once and each row is a span written with paired
+ * 32-bit stores into the sprite's RGB565 pixels. Without a pixel buffer
+ * (no room for the sprite) the same particles go through fillRect().
+ *
+ * Particles are kept as structure-of-arrays. Motion is analytic: where a
+ * particle is and how far it has faded is a function of its age, so a
+ * frame at time t looks the same whatever frames came before it.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdint.h>
+
+#define PARTICLE_MAX 192
+
+// Pixels of a 16-bit sprite, stored as the panel wants them (byte-swapped RGB565)
+struct PixelSurface {
+    uint16_t* pixels;    // nullptr: no buffer, draw through the LovyanGFX target
+    int16_t width;
+    int16_t height;
+};
+
+// The blit kernel: fill a clipped rectangle with a native RGB565 colour
+void fillSurface(const PixelSurface& surface, int x, int y, int w, int h, uint16_t color);
+
+class ParticleSystem {
+public:
+    ParticleSystem() : _count(0) {}
+
+    void clear() { _count = 0; }
+    // Velocity in px per second; a particle with lifeMs 0 never fades or dies
+    bool spawn(int x, int y, int vx, int vy, int size, uint16_t color, uint32_t born, uint16_t lifeMs);
+
+    // Draw every particle alive at `now` (same clock as `born`)
+    void draw(LovyanGFX& gfx, const PixelSurface& surface, uint32_t now) const;
+
+    int count() const { return _count; }
+
+private:
+    int16_t _x[PARTICLE_MAX];
+    int16_t _y[PARTICLE_MAX];
+    int16_t _vx[PARTICLE_MAX];
+    int16_t _vy[PARTICLE_MAX];
+    uint32_t _born[PARTICLE_MAX];
+    uint16_t _life[PARTICLE_MAX];
+    uint16_t _color[PARTICLE_MAX];
+    uint8_t _size[PARTICLE_MAX];
+    int _count;
+};
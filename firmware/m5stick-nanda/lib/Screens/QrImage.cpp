@@ -0,0 +1,78 @@
+#include "QrImage.h"
+
+#include <qrcode.h>
+#include <string.h>
+
+// Data codewords per version at ECC_LOW
+static const uint16_t DATA_CODEWORDS_LOW[QR_MAX_VERSION] = {19, 34, 55, 80, 108, 136, 156, 194, 232, 274};
+
+// Index 0 is the light (and margin) colour, 1 dark
+static const lgfx::rgb565_t QR_PALETTE[2] = {lgfx::rgb565_t(TFT_WHITE), lgfx::rgb565_t(TFT_BLACK)};
+
+int QrImage::versionFor(size_t length) {
+    for (int version = 1; version <= QR_MAX_VERSION; version++) {
+        // Byte mode: 4-bit mode, 8- or 16-bit count, then the bytes
+        size_t bits = 4 + (version < 10 ? 8 : 16) + length * 8;
+        if (bits <= (size_t)DATA_CODEWORDS_LOW[version - 1] * 8) return version;
+    }
+    return 0;
+}
+
+bool QrImage::render(const char* text) {
+    if (valid() && strcmp(text, _text) == 0) return true;
+
+    size_t length = strlen(text);
+    int version = versionFor(length);
+    if (version == 0) {
+        _version = 0;
+        _text[0] = '\0';
+        return false;
+    }
+
+    QRCode qrcode;
+    if (qrcode_initText(&qrcode, _modules, version, ECC_LOW, text) != 0) {
+        _version = 0;
+        _text[0] = '\0';
+        return false;
+    }
+    memcpy(_text, text, length + 1);
+    _version = version;
+    _size = qrcode.size;
+    _scale = (QR_IMAGE_MAX_PX - 2 * QR_QUIET_PX) / _size;
+    _width = _size * _scale + 2 * QR_QUIET_PX;
+    _encodes++;
+    renderBitmap();
+    return true;
+}
+
+bool QrImage::module(int x, int y) const {
+    if (x < 0 || y < 0 || x >= _size || y >= _size) return false;
+    // Same bit order as qrcode_getModule()
+    uint32_t offset = (uint32_t)y * _size + x;
+    return (_modules[offset >> 3] >> (7 - (offset & 7))) & 1;
+}
+
+void QrImage::renderBitmap() {
+    int stride = (_width + 7) / 8;
+    memset(_bitmap, 0, (size_t)stride * _width);
+
+    // Build one pixel row per module row, then repeat it `scale` times
+    for (int my = 0; my < _size; my++) {
+        uint8_t* row = _bitmap + (QR_QUIET_PX + my * _scale) * stride;
+        for (int mx = 0; mx < _size; mx++) {
+            if (!module(mx, my)) continue;
+            int px = QR_QUIET_PX + mx * _scale;
+            for (int i = 0; i < _scale; i++, px++) {
+                row[px >> 3] |= 0x80 >> (px & 7);
+            }
+        }
+        for (int i = 1; i < _scale; i++) {
+            memcpy(row + i * stride, row, stride);
+        }
+    }
+}
+
+void QrImage::draw(LovyanGFX& gfx, int x, int y) const {
+    if (!valid()) return;
+    gfx.pushImage(x, y, _width, _width, _bitmap, lgfx::color_depth_t::palette_1bit, QR_PALETTE);
+}
@@ -0,0 +1,62 @@
+/**
+ * A QR code, encoded once and kept as a ready-to-push bitmap.
+ *
+ * Encoding (Reed-Solomon plus trying all eight masks) and drawing each
+ * dark module with its own fillRect() cost far more than the screen
+ * needs: the chat URL only changes with the IP. render() encodes only
+ * when the text differs from the cached one. It keeps the module matrix
+ * and a 1-bit image of the code, quiet zone included, scaled up to fill
+ * QR_IMAGE_MAX_PX. draw() is then a single pushImage() with a
+ * white/black palette.
+ *
+ * The version (size) is the smallest whose byte-mode capacity at ECC_LOW
+ * holds the text, up to QR_MAX_VERSION; longer text is refused rather
+ * than overflowing the encoder's buffers.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define QR_MAX_VERSION 10      // 57x57 modules, 271 bytes
+#define QR_TEXT_MAX 272        // Capacity of QR_MAX_VERSION, plus the terminator
+#define QR_QUIET_PX 4          // White margin around the modules
+#define QR_IMAGE_MAX_PX 100    // Room on the QR screen, margin included
+#define QR_MODULES_BYTES ((((QR_MAX_VERSION * 4 + 17) * (QR_MAX_VERSION * 4 + 17)) + 7) / 8)
+#define QR_BITMAP_BYTES (((QR_IMAGE_MAX_PX + 7) / 8) * QR_IMAGE_MAX_PX)
+
+class QrImage {
+public:
+    QrImage() : _version(0), _size(0), _scale(0), _width(0), _encodes(0) { _text[0] = '\0'; }
+
+    // Smallest version holding `length` bytes, 0 if none up to QR_MAX_VERSION
+    static int versionFor(size_t length);
+
+    // Encode and render `text` unless it is the cached one; false if too long
+    bool render(const char* text);
+    // One pushImage() with the top-left corner of the margin at x, y
+    void draw(LovyanGFX& gfx, int x, int y) const;
+
+    bool valid() const { return _version != 0; }
+    const char* text() const { return _text; }
+    int version() const { return _version; }
+    int size() const { return _size; }         // Modules per side
+    int scale() const { return _scale; }       // Pixels per module
+    int width() const { return _width; }       // Pixels per side, margin included
+    bool module(int x, int y) const;
+    uint32_t encodes() const { return _encodes; }
+
+private:
+    void renderBitmap();
+
+    char _text[QR_TEXT_MAX];
+    uint8_t _modules[QR_MODULES_BYTES];
+    uint8_t _bitmap[QR_BITMAP_BYTES];   // 1 bit per pixel, MSB first, rows padded to bytes
+    uint8_t _version;
+    uint8_t _size;
+    uint8_t _scale;
+    uint8_t _width;
+    uint32_t _encodes;
+};
@@ -0,0 +1,263 @@
+#include "ScreenEncoder.h"
+
+#include <M5GFX.h>
+#include <lgfx/utility/lgfx_miniz.h>
+#include <string.h>
+
+#define QOI_OP_INDEX 0x00
+#define QOI_OP_DIFF 0x40
+#define QOI_OP_LUMA 0x80
+#define QOI_OP_RUN 0xc0
+#define QOI_OP_RGB 0xfe
+#define QOI_RUN_MAX 62
+
+// Worst case per QOI pixel (QOI_OP_RGB), so a row always fits one chunk
+static_assert(SCREEN_ENCODER_ROW_MAX * 4 + 1 <= SCREEN_ENCODER_CHUNK, "QOI row does not fit a chunk");
+
+static const uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+static const uint8_t QOI_END[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+
+static void putBE32(uint8_t* p, uint32_t v) {
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+static uint32_t rgbPixel(uint8_t r, uint8_t g, uint8_t b) {
+    return (uint32_t)r << 16 | (uint32_t)g << 8 | b;
+}
+
+const char* ScreenEncoder::contentType(ScreenFormat format) {
+    return format == SCREEN_QOI ? "image/qoi" : "image/png";
+}
+
+size_t ScreenEncoder::stateBytes(ScreenFormat format) {
+    return format == SCREEN_PNG ? sizeof(tdefl_compressor) : 0;
+}
+
+bool ScreenEncoder::begin(const PixelSurface& surface, ScreenFormat format) {
+    end();
+    if (!surface.pixels || surface.width <= 0 || surface.width > SCREEN_ENCODER_ROW_MAX || surface.height <= 0) {
+        return false;
+    }
+    if (format == SCREEN_PNG) {
+        _deflate = lgfx::heap_alloc_psram(sizeof(tdefl_compressor));
+        if (!_deflate) _deflate = lgfx::heap_alloc(sizeof(tdefl_compressor));
+        if (!_deflate) return false;
+        tdefl_init((tdefl_compressor*)_deflate, nullptr, nullptr, TDEFL_WRITE_ZLIB_HEADER | SCREEN_PNG_LEVEL);
+    }
+    _surface = surface;
+    _format = format;
+    _phase = HEADER;
+    _row = 0;
+    _lineLen = 0;
+    _lineAt = 0;
+    _pendingLen = 0;
+    _pendingAt = 0;
+    return true;
+}
+
+void ScreenEncoder::release() {
+    if (_deflate) {
+        lgfx::heap_free(_deflate);
+        _deflate = nullptr;
+    }
+}
+
+void ScreenEncoder::end() {
+    release();
+    _phase = DONE;
+    _pendingLen = 0;
+    _pendingAt = 0;
+}
+
+size_t ScreenEncoder::read(uint8_t* out, size_t max) {
+    size_t n = 0;
+    while (n < max) {
+        if (_pendingAt < _pendingLen) {
+            size_t take = _pendingLen - _pendingAt;
+            if (take > max - n) take = max - n;
+            memcpy(out + n, _pending + _pendingAt, take);
+            _pendingAt += take;
+            n += take;
+            continue;
+        }
+        if (!produce()) break;
+    }
+    return n;
+}
+
+// Refill _pending with the next piece of the file; false when there is none
+bool ScreenEncoder::produce() {
+    _pendingLen = 0;
+    _pendingAt = 0;
+    switch (_phase) {
+        case HEADER:
+            if (_format == SCREEN_PNG) pngHeader();
+            else qoiHeader();
+            _phase = ROWS;
+            return true;
+        case ROWS:
+            if (_format == SCREEN_PNG) pngRows();
+            else qoiRows();
+            return true;
+        case TRAILER:
+            if (_format == SCREEN_PNG) {
+                putChunk("IEND", 0);
+            } else {
+                memcpy(_pending, QOI_END, sizeof(QOI_END));
+                _pendingLen = sizeof(QOI_END);
+            }
+            release();
+            _phase = DONE;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Sprite pixels are byte-swapped RGB565; widen each channel to 8 bits the
+// way LovyanGFX does, so decoding back to RGB565 gives the same pixels
+void ScreenEncoder::rgbRow(int y, uint8_t* out) const {
+    const uint16_t* src = _surface.pixels + (int32_t)y * _surface.width;
+    for (int x = 0; x < _surface.width; x++) {
+        uint16_t c = (uint16_t)(src[x] << 8 | src[x] >> 8);
+        uint8_t r = (c >> 11) & 0x1F;
+        uint8_t g = (c >> 5) & 0x3F;
+        uint8_t b = c & 0x1F;
+        *out++ = (uint8_t)(r << 3 | r >> 2);
+        *out++ = (uint8_t)(g << 2 | g >> 4);
+        *out++ = (uint8_t)(b << 3 | b >> 2);
+    }
+}
+
+// Frame the dataLen bytes at _pending + 8 as a PNG chunk of `type`
+void ScreenEncoder::putChunk(const char* type, size_t dataLen) {
+    putBE32(_pending, (uint32_t)dataLen);
+    memcpy(_pending + 4, type, 4);
+    uint32_t crc = (uint32_t)lgfx_mz_crc32(MZ_CRC32_INIT, _pending + 4, dataLen + 4);
+    putBE32(_pending + 8 + dataLen, crc);
+    _pendingLen = 12 + dataLen;
+}
+
+void ScreenEncoder::pngHeader() {
+    // The signature goes ahead of the IHDR chunk, shifting it by 8 bytes
+    uint8_t* ihdr = _pending + 8;
+    putBE32(ihdr, _surface.width);
+    putBE32(ihdr + 4, _surface.height);
+    ihdr[8] = 8;    // Bits per channel
+    ihdr[9] = 2;    // RGB
+    ihdr[10] = 0;   // Deflate
+    ihdr[11] = 0;   // Adaptive filtering
+    ihdr[12] = 0;   // Not interlaced
+    putChunk("IHDR", 13);
+    memmove(_pending + 8, _pending, _pendingLen);
+    memcpy(_pending, PNG_SIGNATURE, 8);
+    _pendingLen += 8;
+}
+
+// Deflate rows until one IDAT chunk is full or the image is complete
+void ScreenEncoder::pngRows() {
+    tdefl_compressor* d = (tdefl_compressor*)_deflate;
+    uint8_t* data = _pending + 8;
+    size_t filled = 0;
+
+    while (filled < SCREEN_ENCODER_CHUNK) {
+        if (_lineAt >= _lineLen && _row < _surface.height) {
+            // Filter 1 (Sub): runs of one colour become zeros
+            uint8_t* rgb = _line + 1;
+            rgbRow(_row++, rgb);
+            for (int i = _surface.width * 3 - 1; i >= 3; i--) {
+                rgb[i] -= rgb[i - 3];
+            }
+            _line[0] = 1;
+            _lineLen = 1 + _surface.width * 3;
+            _lineAt = 0;
+        }
+        // Once the last row is in, keep finishing until deflate is done
+        tdefl_flush flush = _row >= _surface.height ? TDEFL_FINISH : TDEFL_NO_FLUSH;
+
+        // Output that does not fit stays in tdefl for the next call
+        size_t inLen = _lineLen - _lineAt;
+        size_t outLen = SCREEN_ENCODER_CHUNK - filled;
+        tdefl_status status = tdefl_compress(d, _line + _lineAt, &inLen, data + filled, &outLen, flush);
+        _lineAt += inLen;
+        filled += outLen;
+        if (status != TDEFL_STATUS_OKAY) {
+            // Done, or failed (which cannot happen with valid arguments): stop the file here
+            _phase = TRAILER;
+            break;
+        }
+    }
+    putChunk("IDAT", filled);
+}
+
+void ScreenEncoder::qoiHeader() {
+    memcpy(_pending, "qoif", 4);
+    putBE32(_pending + 4, _surface.width);
+    putBE32(_pending + 8, _surface.height);
+    _pending[12] = 3;   // RGB
+    _pending[13] = 0;   // sRGB with linear alpha
+    _pendingLen = 14;
+
+    memset(_index, 0, sizeof(_index));
+    _prev = rgbPixel(0, 0, 0);
+    _run = 0;
+}
+
+// One row of QOI ops; a run can carry over into the next row
+void ScreenEncoder::qoiRows() {
+    uint8_t* out = _pending;
+    size_t n = 0;
+    rgbRow(_row, _line);
+    const uint8_t* px = _line;
+    bool last = _row == _surface.height - 1;
+
+    for (int x = 0; x < _surface.width; x++, px += 3) {
+        uint32_t pixel = rgbPixel(px[0], px[1], px[2]);
+        if (pixel == _prev) {
+            if (++_run == QOI_RUN_MAX) {
+                out[n++] = QOI_OP_RUN | (_run - 1);
+                _run = 0;
+            }
+            continue;
+        }
+        if (_run) {
+            out[n++] = QOI_OP_RUN | (_run - 1);
+            _run = 0;
+        }
+
+        // Alpha is always 255: (r * 3 + g * 5 + b * 7 + 255 * 11) % 64
+        int slot = (px[0] * 3 + px[1] * 5 + px[2] * 7 + 255 * 11) % 64;
+        if (_index[slot] == (pixel | 0xFF000000u)) {
+            out[n++] = QOI_OP_INDEX | slot;
+        } else {
+            _index[slot] = pixel | 0xFF000000u;
+            int8_t dr = (int8_t)(px[0] - (uint8_t)(_prev >> 16));
+            int8_t dg = (int8_t)(px[1] - (uint8_t)(_prev >> 8));
+            int8_t db = (int8_t)(px[2] - (uint8_t)_prev);
+            int8_t drg = dr - dg;
+            int8_t dbg = db - dg;
+            if (dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1) {
+                out[n++] = QOI_OP_DIFF | (dr + 2) << 4 | (dg + 2) << 2 | (db + 2);
+            } else if (dg >= -32 && dg <= 31 && drg >= -8 && drg <= 7 && dbg >= -8 && dbg <= 7) {
+                out[n++] = QOI_OP_LUMA | (dg + 32);
+                out[n++] = (drg + 8) << 4 | (dbg + 8);
+            } else {
+                out[n++] = QOI_OP_RGB;
+                out[n++] = px[0];
+                out[n++] = px[1];
+                out[n++] = px[2];
+            }
+        }
+        _prev = pixel;
+    }
+
+    if (last && _run) {
+        out[n++] = QOI_OP_RUN | (_run - 1);
+        _run = 0;
+    }
+    _pendingLen = n;
+    if (++_row >= _surface.height) _phase = TRAILER;
+}
@@ -0,0 +1,85 @@
+/**
+ * The current frame as a PNG or QOI file, encoded as it is read.
+ *
+ * read() hands out the file a piece at a time, for a chunked HTTP
+ * response or a tunnel frame. Rows are taken from the frame buffer's
+ * pixels as the encoder reaches them, so there is never a second copy of
+ * the frame: the working set is one row and one output chunk (about
+ * 2 KB), plus for PNG the deflate state (SCREEN_PNG_STATE_BYTES, taken
+ * from PSRAM when there is some, only between begin() and the end of the
+ * file). A redraw during a slow transfer can therefore show up partway
+ * down the image.
+ *
+ * PNG goes through M5GFX's bundled miniz (tdefl), one IDAT chunk per
+ * SCREEN_ENCODER_CHUNK bytes of deflate output. QOI needs no dictionary
+ * and encodes several times faster at a somewhat larger size; it is
+ * written here rather than with lgfx_qoi's encoder, which pushes the
+ * whole file through a global writer and cannot stop between calls.
+ *
+ * Threading: one encode at a time per encoder; the caller serializes.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Particles.h"
+
+#define SCREEN_ENCODER_CHUNK 1024      // Deflate output per IDAT chunk
+#define SCREEN_ENCODER_ROW_MAX 240     // Widest frame, in pixels (the panel's long side)
+#define SCREEN_PNG_LEVEL 32            // Dictionary probes; frames are mostly flat colour
+
+enum ScreenFormat : uint8_t {
+    SCREEN_PNG = 0,
+    SCREEN_QOI
+};
+
+class ScreenEncoder {
+public:
+    ScreenEncoder() : _deflate(nullptr), _phase(DONE), _pendingLen(0), _pendingAt(0) {}
+    ~ScreenEncoder() { end(); }
+
+    // Start a file of the pixels in `surface`; false without pixels or memory
+    bool begin(const PixelSurface& surface, ScreenFormat format);
+    // Up to `max` more bytes of the file; 0 once it is complete
+    size_t read(uint8_t* out, size_t max);
+    // Stop early and release the deflate state
+    void end();
+
+    bool done() const { return _phase == DONE && _pendingAt >= _pendingLen; }
+    static const char* contentType(ScreenFormat format);
+    // Memory taken by begin() beyond the encoder itself
+    static size_t stateBytes(ScreenFormat format);
+
+private:
+    enum Phase : uint8_t { HEADER, ROWS, TRAILER, DONE };
+
+    bool produce();
+    void release();
+    void pngHeader();
+    void pngRows();
+    void qoiHeader();
+    void qoiRows();
+    void putChunk(const char* type, size_t dataLen);
+    void rgbRow(int y, uint8_t* out) const;
+
+    PixelSurface _surface;
+    ScreenFormat _format;
+    void* _deflate;                 // tdefl_compressor, PNG only
+    Phase _phase;
+    int _row;                       // Next row to encode
+
+    // Bytes ready for read(): an output chunk with room for its PNG framing
+    uint8_t _pending[8 + SCREEN_ENCODER_CHUNK + 4];
+    size_t _pendingLen;
+    size_t _pendingAt;
+    uint8_t _line[1 + SCREEN_ENCODER_ROW_MAX * 3];   // PNG filter byte + RGB, or QOI input row
+    size_t _lineLen;                // PNG: bytes of _line not yet deflated start at _lineAt
+    size_t _lineAt;
+
+    // QOI state
+    uint32_t _index[64];
+    uint32_t _prev;
+    uint8_t _run;
+};
@@ -0,0 +1,381 @@
+#include "Screens.h"
+
+#include <algorithm>
+
+#include "QrImage.h"
+
+#define SCREEN_QR_TOP 8      // The QR image's area runs from here to above the URL
+
+// xorshift32: the FX decorations only need to look random
+static uint32_t nextRandom(uint32_t& state) {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+static int randomIn(uint32_t& state, int low, int high) {
+    return low + (int)(nextRandom(state) % (uint32_t)(high - low));
+}
+
+void drawHeader(LovyanGFX& gfx, const char* title) {
+    gfx.fillScreen(TFT_BLACK);
+    gfx.setTextColor(TFT_CYAN);
+    gfx.setTextSize(2);
+    gfx.setCursor(5, 5);
+    gfx.println(title);
+
+    // Draw separator line
+    gfx.drawLine(0, 25, 240, 25, TFT_DARKGREY);
+}
+
+void drawNavHint(LovyanGFX& gfx) {
+    gfx.setTextColor(TFT_DARKGREY);
+    gfx.setTextSize(1);
+    gfx.setCursor(5, 125);
+    gfx.print("A:Select  B:Next");
+}
+
+void drawMenuItem(LovyanGFX& gfx, int y, const char* label, bool selected) {
+    if (selected) {
+        gfx.fillRect(0, y - 2, 240, 18, TFT_NAVY);
+        gfx.setTextColor(TFT_WHITE);
+    } else {
+        gfx.setTextColor(TFT_LIGHTGREY);
+    }
+    gfx.setTextSize(2);
+    gfx.setCursor(10, y);
+    gfx.print(label);
+}
+
+void layoutHeader(Widgets& ui, const char* title) {
+    ui.text(5, 5, TFT_CYAN, 2, "%s", title);
+    ui.fill(0, 25, 240, 1, TFT_DARKGREY);  // Separator line
+}
+
+void layoutNavHint(Widgets& ui) {
+    ui.text(5, 125, TFT_DARKGREY, 1, "A:Select  B:Next");
+}
+
+void layoutHomeScreen(Widgets& ui, const ScreenState& state) {
+    layoutHeader(ui, "NANDA");
+
+    // Device identity
+    ui.text(10, 32, TFT_MAGENTA, 1, "%s", state.handle);
+
+    // Network status
+    if (state.wifiConnected) {
+        int x = ui.text(10, 45, TFT_GREEN, 1, "WiFi ");
+        ui.text(x, 45, TFT_CYAN, 1, "%s", state.ip);
+
+        // mDNS hostname
+        if (state.mdnsStarted) {
+            ui.text(10, 58, TFT_DARKGREY, 1, "%s.local", state.hostname);
+        }
+    } else {
+        ui.text(10, 45, TFT_RED, 1, "WiFi: Connecting...");
+    }
+
+    // Registry status
+    if (state.registryConnected) {
+        int totalAgents = (state.agents ? (int)state.agents->size() : 0) + 1;  // +1 for ourselves
+        int x = ui.text(10, 75, TFT_GREEN, 1, "Registry ");
+        ui.text(x, 75, TFT_WHITE, 1, "%d%s", totalAgents, totalAgents == 1 ? " agent (you)" : " agents");
+    } else {
+        ui.text(10, 75, TFT_YELLOW, 1, "Registry: Offline");
+    }
+
+    // Tunnel status
+    if (state.tunnelConnected) {
+        int x = ui.text(10, 90, TFT_GREEN, 1, "Tunnel ");
+        ui.text(x, 90, TFT_WHITE, 1, "connected");
+    } else if (state.registryConnected) {
+        ui.text(10, 90, TFT_YELLOW, 1, "Tunnel: reconnecting...");
+    }
+
+    // Quick stats
+    int x = ui.text(10, 108, TFT_WHITE, 1, "%.1fC  %d%%  ", state.sensors.temperature, state.sensors.batteryPercent);
+    ui.text(x, 108, TFT_GREEN, 1, ":80");
+
+    layoutNavHint(ui);
+}
+
+void layoutSensorsScreen(Widgets& ui, const ScreenState& state) {
+    const SensorReadings& s = state.sensors;
+    layoutHeader(ui, "Sensors");
+
+    ui.text(10, 35, TFT_WHITE, 1, "Accel X: %+.2f g", s.accelX);
+    ui.text(10, 50, TFT_WHITE, 1, "Accel Y: %+.2f g", s.accelY);
+    ui.text(10, 65, TFT_WHITE, 1, "Accel Z: %+.2f g", s.accelZ);
+
+    ui.text(10, 85, TFT_CYAN, 1, "Gyro: %+.0f %+.0f %+.0f", s.gyroX, s.gyroY, s.gyroZ);
+
+    ui.text(10, 105, TFT_ORANGE, 1, "Temp: %.1f C", s.temperature);
+
+    layoutNavHint(ui);
+}
+
+// Immediate drawing of a widget screen
+static void drawLayout(LovyanGFX& gfx, void (*layout)(Widgets&, const ScreenState&), const ScreenState& state) {
+    Widgets ui;
+    layout(ui, state);
+    ui.draw(gfx);
+}
+
+void drawHomeScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawLayout(gfx, layoutHomeScreen, state);
+}
+
+void drawSensorsScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawLayout(gfx, layoutSensorsScreen, state);
+}
+
+void drawNetworkScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawHeader(gfx, "Network");
+
+    gfx.setTextSize(1);
+
+    if (state.wifiConnected) {
+        gfx.setTextColor(TFT_GREEN);
+        gfx.setCursor(10, 35);
+        gfx.println("Status: Connected");
+
+        gfx.setTextColor(TFT_WHITE);
+        gfx.setCursor(10, 50);
+        gfx.print("SSID: ");
+        gfx.println(state.ssid);
+
+        gfx.setCursor(10, 65);
+        gfx.print("IP: ");
+        gfx.println(state.ip);
+
+        gfx.setTextColor(TFT_CYAN);
+        gfx.setCursor(10, 80);
+        gfx.print("mDNS: ");
+        gfx.printf("%s.local\n", state.hostname);
+
+        gfx.setTextColor(TFT_YELLOW);
+        gfx.setCursor(10, 100);
+        gfx.printf("RSSI: %d dBm", state.rssi);
+    } else {
+        gfx.setTextColor(TFT_RED);
+        gfx.setCursor(10, 50);
+        gfx.println("Connecting...");
+    }
+
+    drawNavHint(gfx);
+}
+
+void layoutBatteryScreen(Widgets& ui, const ScreenState& state) {
+    const SensorReadings& s = state.sensors;
+    uint16_t levelColor = s.batteryPercent > 50 ? TFT_GREEN : s.batteryPercent > 20 ? TFT_YELLOW : TFT_RED;
+    layoutHeader(ui, "Battery");
+
+    // Battery percentage with color
+    ui.text(10, 40, levelColor, 2, "%d%%", s.batteryPercent);
+
+    // Voltage
+    ui.text(10, 70, TFT_WHITE, 1, "Voltage: %.2f V", s.batteryVoltage);
+
+    // Charging status
+    if (s.isCharging) {
+        ui.text(10, 90, TFT_CYAN, 1, "Charging...");
+    } else {
+        ui.text(10, 90, TFT_DARKGREY, 1, "Not charging");
+    }
+
+    // Battery bar
+    ui.bar(10, 105, 204, 14, s.batteryPercent, levelColor, TFT_WHITE);
+
+    layoutNavHint(ui);
+}
+
+void layoutDiscoveryScreen(Widgets& ui, const ScreenState& state) {
+    int totalAgents = state.agents ? (int)state.agents->size() : 0;
+
+    if (state.viewingSkills && state.selectedAgent >= 0 && state.selectedAgent < totalAgents) {
+        // Show skills for selected agent
+        layoutHeader(ui, "Skills");
+
+        ui.text(10, 32, TFT_CYAN, 1, "%s", state.agents->handle(state.selectedAgent));
+
+        if (state.skillCount == 0) {
+            ui.text(10, 55, TFT_YELLOW, 1, "No skills found");
+        } else {
+            int y = 48;
+            int startIdx = std::max(0, state.selectedSkill - 2);
+            int endIdx = std::min(state.skillCount, startIdx + 5);
+
+            for (int i = startIdx; i < endIdx; i++) {
+                bool selected = (i == state.selectedSkill);
+                ui.row(y - 2, 14, selected);
+                ui.text(10, y, selected ? TFT_WHITE : TFT_LIGHTGREY, 1, "%s%.20s", selected ? "> " : "  ",
+                        state.skillName ? state.skillName(i) : "");
+                y += 14;
+            }
+        }
+
+        // Show last result if any
+        if (state.lastSkillResult && state.lastSkillResult[0]) {
+            ui.text(10, 108, TFT_GREEN, 1, "%.30s", state.lastSkillResult);
+        }
+
+        ui.text(5, 125, TFT_YELLOW, 1, "A:Run B:Next PWR:Back");
+    } else {
+        // Show agent list
+        layoutHeader(ui, "Agents");
+
+        ui.text(10, 32, TFT_WHITE, 1, "%d%s", totalAgents, totalAgents == 1 ? " agent found" : " agents found");
+
+        if (totalAgents == 0) {
+            ui.text(10, 55, TFT_YELLOW, 1, "Press A to scan");
+        } else {
+            int y = 48;
+            int startIdx = std::max(0, state.selectedAgent - 2);
+            int endIdx = std::min(totalAgents, startIdx + 5);
+
+            for (int i = startIdx; i < endIdx; i++) {
+                bool selected = (i == state.selectedAgent);
+                bool healthy = state.agents->healthy(i);
+                ui.row(y - 2, 14, selected);
+                int x = ui.text(5, y, healthy ? TFT_GREEN : TFT_RED, 1, "%s%s", selected ? "> " : "  ",
+                                healthy ? "+ " : "- ");
+                ui.text(x, y, selected ? TFT_WHITE : TFT_LIGHTGREY, 1, "%.18s", state.agents->handle(i));
+                y += 14;
+            }
+        }
+
+        ui.text(5, 125, TFT_YELLOW, 1, "A:Select B:Next");
+    }
+}
+
+void drawBatteryScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawLayout(gfx, layoutBatteryScreen, state);
+}
+
+void drawDiscoveryScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawLayout(gfx, layoutDiscoveryScreen, state);
+}
+
+void drawIRScreen(LovyanGFX& gfx, const ScreenState& state) {
+    (void)state;
+    drawHeader(gfx, "IR Control");
+
+    gfx.setTextSize(1);
+    gfx.setTextColor(TFT_WHITE);
+
+    gfx.setCursor(10, 40);
+    gfx.println("IR Transmitter Ready");
+
+    gfx.setTextColor(TFT_YELLOW);
+    gfx.setCursor(10, 60);
+    gfx.println("Press A to send test");
+
+    gfx.setTextColor(TFT_DARKGREY);
+    gfx.setCursor(10, 85);
+    gfx.println("Use HTTP API for");
+    gfx.setCursor(10, 100);
+    gfx.println("custom IR commands");
+
+    drawNavHint(gfx);
+}
+
+void drawFXScreen(LovyanGFX& gfx, const ScreenState& state) {
+    drawHeader(gfx, "FX");
+
+    gfx.setTextColor(TFT_CYAN);
+    gfx.setTextSize(1);
+    gfx.setCursor(10, 40);
+    gfx.println("Visual Effects");
+
+    gfx.setTextColor(TFT_WHITE);
+    gfx.setCursor(10, 60);
+    gfx.println("Press A to play");
+    gfx.setCursor(10, 75);
+    gfx.println("startup animation");
+
+    // Draw some voxel decorations
+    uint32_t rng = state.seed ? state.seed : 1;
+    for (int i = 0; i < 20; i++) {
+        int x = randomIn(rng, 10, 230);
+        int y = randomIn(rng, 95, 125);
+        int size = randomIn(rng, 2, 5);
+        uint16_t color = (nextRandom(rng) & 1) ? TFT_CYAN : TFT_MAGENTA;
+        gfx.fillRect(x, y, size, size, color);
+    }
+
+    drawNavHint(gfx);
+}
+
+void drawQRScreen(LovyanGFX& gfx, const ScreenState& state) {
+    // Encoded and rendered again only when the URL changes
+    static QrImage qr;
+
+    gfx.fillScreen(TFT_BLACK);
+
+    // Build the chat URL
+    char chatUrl[64];
+    snprintf(chatUrl, sizeof(chatUrl), "http://%s/chat", state.ip);
+
+    // QR code centred above the URL, in one push
+    if (qr.render(chatUrl)) {
+        qr.draw(gfx, (240 - qr.width()) / 2, SCREEN_QR_TOP + (QR_IMAGE_MAX_PX - qr.width()) / 2);
+    }
+
+    // Show URL text
+    gfx.setTextColor(TFT_CYAN);
+    gfx.setTextSize(1);
+    gfx.setCursor(10, 115);
+    gfx.print("Scan to chat: ");
+    gfx.setTextColor(TFT_WHITE);
+    gfx.setCursor(10, 125);
+    gfx.print(chatUrl);
+}
+
+bool layoutScreen(Widgets& ui, MenuScreen screen, const ScreenState& state) {
+    switch (screen) {
+        case MENU_HOME:
+            layoutHomeScreen(ui, state);
+            return true;
+        case MENU_SENSORS:
+            layoutSensorsScreen(ui, state);
+            return true;
+        case MENU_DISCOVERY:
+            layoutDiscoveryScreen(ui, state);
+            return true;
+        case MENU_BATTERY:
+            layoutBatteryScreen(ui, state);
+            return true;
+        default:
+            return false;
+    }
+}
+
+void drawScreen(LovyanGFX& gfx, MenuScreen screen, const ScreenState& state) {
+    switch (screen) {
+        case MENU_SENSORS:
+            drawSensorsScreen(gfx, state);
+            break;
+        case MENU_NETWORK:
+            drawNetworkScreen(gfx, state);
+            break;
+        case MENU_DISCOVERY:
+            drawDiscoveryScreen(gfx, state);
+            break;
+        case MENU_BATTERY:
+            drawBatteryScreen(gfx, state);
+            break;
+        case MENU_IR:
+            drawIRScreen(gfx, state);
+            break;
+        case MENU_FX:
+            drawFXScreen(gfx, state);
+            break;
+        case MENU_QR:
+            drawQRScreen(gfx, state);
+            break;
+        default:
+            drawHomeScreen(gfx, state);
+            break;
+    }
+}
@@ -0,0 +1,95 @@
+/**
+ * Menu screens, drawn onto any LovyanGFX target.
+ *
+ * Every screen is a function of a ScreenState snapshot, so the same code
+ * draws into the device's frame buffer, straight onto the panel, or into
+ * a sprite on the host for benchmarks and screenshot diffs. Nothing here
+ * reads sensors or touches globals; the caller fills the state first.
+ *
+ * Screens paint the whole panel, background included.
+ *
+ * Home, Sensors, Battery and Discovery are also described as Widgets, so
+ * a Compositor can push only what changed between refreshes;
+ * layoutScreen() fills the list for those and returns false for the rest.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdint.h>
+
+#include <AgentDirectory.h>
+
+#include "Widgets.h"
+
+enum MenuScreen {
+    MENU_HOME = 0,
+    MENU_SENSORS,
+    MENU_NETWORK,
+    MENU_DISCOVERY,
+    MENU_BATTERY,
+    MENU_IR,
+    MENU_FX,
+    MENU_QR,
+    MENU_COUNT  // Keep last
+};
+
+struct SensorReadings {
+    float accelX, accelY, accelZ;
+    float gyroX, gyroY, gyroZ;
+    float temperature;
+    float batteryVoltage;
+    int batteryPercent;
+    bool isCharging;
+};
+
+struct ScreenState {
+    // Identity and connectivity
+    const char* handle;
+    const char* ip;
+    const char* hostname;        // Without ".local"
+    const char* ssid;
+    bool wifiConnected;
+    bool mdnsStarted;
+    bool registryConnected;
+    bool tunnelConnected;
+    int rssi;
+
+    SensorReadings sensors;
+
+    // Discovery
+    const AgentDirectory* agents;
+    int selectedAgent;           // -1 for none
+    bool viewingSkills;
+    int skillCount;
+    int selectedSkill;
+    const char* (*skillName)(int index);
+    const char* lastSkillResult;
+
+    uint32_t seed;               // Decorations on the FX screen
+};
+
+void drawScreen(LovyanGFX& gfx, MenuScreen screen, const ScreenState& state);
+
+void drawHomeScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawSensorsScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawNetworkScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawDiscoveryScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawBatteryScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawIRScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawFXScreen(LovyanGFX& gfx, const ScreenState& state);
+void drawQRScreen(LovyanGFX& gfx, const ScreenState& state);
+
+bool layoutScreen(Widgets& ui, MenuScreen screen, const ScreenState& state);
+
+void layoutHomeScreen(Widgets& ui, const ScreenState& state);
+void layoutSensorsScreen(Widgets& ui, const ScreenState& state);
+void layoutDiscoveryScreen(Widgets& ui, const ScreenState& state);
+void layoutBatteryScreen(Widgets& ui, const ScreenState& state);
+
+// Building blocks shared with the rest of the UI
+void drawHeader(LovyanGFX& gfx, const char* title);
+void drawNavHint(LovyanGFX& gfx);
+void drawMenuItem(LovyanGFX& gfx, int y, const char* label, bool selected);
+void layoutHeader(Widgets& ui, const char* title);
+void layoutNavHint(Widgets& ui);
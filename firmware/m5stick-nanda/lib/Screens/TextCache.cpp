@@ -0,0 +1,142 @@
+#include "TextCache.h"
+
+#include <string.h>
+
+static_assert((TEXT_CACHE_SLOTS & (TEXT_CACHE_SLOTS - 1)) == 0, "TEXT_CACHE_SLOTS must be a power of two");
+static_assert(TEXT_CACHE_GLYPH_MAX <= 32, "A mask row is one 32-bit word");
+
+static inline uint16_t swap565(uint16_t color) {
+    return (uint16_t)((color << 8) | (color >> 8));
+}
+
+static inline uint32_t slotFor(const lgfx::IFont* font, uint8_t size, uint8_t code) {
+    uint32_t h = (uint32_t)(uintptr_t)font ^ (uint32_t)code * 0x9E3779B1u ^ (uint32_t)size * 0x85EBCA6Bu;
+    return (h ^ h >> 15) & (TEXT_CACHE_SLOTS - 1);
+}
+
+void TextCache::clear() {
+    memset(_slots, 0, sizeof(_slots));
+    _glyphs = 0;
+    _rowsUsed = 0;
+}
+
+const TextCache::Glyph* TextCache::find(const lgfx::IFont* font, uint8_t size, uint8_t code) {
+    uint32_t i = slotFor(font, size, code);
+    while (_slots[i].font) {
+        const Glyph& g = _slots[i];
+        if (g.font == font && g.size == size && g.code == code) {
+            _hits++;
+            return &g;
+        }
+        i = (i + 1) & (TEXT_CACHE_SLOTS - 1);
+    }
+
+    // Not cached: make room if needed, then the free slot probing stopped at
+    const lgfx::BaseFont* base = (const lgfx::BaseFont*)font;
+    if (_glyphs >= TEXT_CACHE_SLOTS * 3 / 4 || _rowsUsed + base->height * size > TEXT_CACHE_ROWS) {
+        clear();
+        _flushes++;
+        i = slotFor(font, size, code);
+    }
+    _misses++;
+    return rasterize(&_slots[i], font, size, code);
+}
+
+// Print the glyph into the 1-bit scratch sprite and keep its set pixels
+const TextCache::Glyph* TextCache::rasterize(Glyph* slot, const lgfx::IFont* font, uint8_t size, uint8_t code) {
+    if (!_raster.getBuffer()) {
+        _raster.setColorDepth(1);
+        if (!_raster.createSprite(TEXT_CACHE_GLYPH_MAX, TEXT_CACHE_GLYPH_MAX)) return nullptr;
+    }
+    const lgfx::BaseFont* base = (const lgfx::BaseFont*)font;
+    int width = base->width * size;
+    int height = base->height * size;
+
+    _raster.fillScreen(0);
+    _raster.setFont(font);
+    _raster.setTextSize(size);
+    _raster.setTextColor(1);
+    _raster.drawChar(code, 0, 0);
+
+    uint32_t* rows = _rows + _rowsUsed;
+    for (int y = 0; y < height; y++) {
+        uint32_t bits = 0;
+        for (int x = 0; x < width; x++) {
+            if (_raster.readPixelValue(x, y)) bits |= (uint32_t)1 << x;
+        }
+        rows[y] = bits;
+    }
+
+    slot->font = font;
+    slot->row = _rowsUsed;
+    slot->code = code;
+    slot->size = size;
+    slot->width = width;
+    slot->height = height;
+    _rowsUsed += height;
+    _glyphs++;
+    return slot;
+}
+
+void TextCache::draw(LovyanGFX& gfx, const PixelSurface& surface, int x, int y, const char* text, uint8_t size,
+                     uint16_t color) {
+    const lgfx::IFont* font = gfx.getFont();
+    bool cacheable = surface.pixels && font && font->getType() == lgfx::IFont::font_type_t::ft_glcd &&
+                     gfx.getTextDatum() == textdatum_t::top_left && size > 0;
+
+    if (cacheable) {
+        const lgfx::BaseFont* base = (const lgfx::BaseFont*)font;
+        int cellW = base->width * size;
+        int cellH = base->height * size;
+        int length = 0;
+        for (const char* c = text; *c; c++, length++) {
+            if (*c < 0x20 || *c > 0x7E) cacheable = false;
+        }
+
+        int32_t clipX, clipY, clipW, clipH;
+        gfx.getClipRect(&clipX, &clipY, &clipW, &clipH);
+        cacheable = cacheable && cellW <= TEXT_CACHE_GLYPH_MAX && cellH <= TEXT_CACHE_GLYPH_MAX &&
+                    x >= clipX && y >= clipY && x + length * cellW <= clipX + clipW && y + cellH <= clipY + clipH &&
+                    clipX + clipW <= surface.width && clipY + clipH <= surface.height;
+    }
+
+    if (!cacheable) {
+        _fallbacks++;
+        gfx.setTextSize(size);
+        gfx.setTextColor(color);
+        gfx.setCursor(x, y);
+        gfx.print(text);
+        return;
+    }
+
+    uint16_t pixel = swap565(color);
+    for (const char* c = text; *c; c++) {
+        const Glyph* g = find(font, size, (uint8_t)*c);
+        if (!g) {
+            // No memory for the scratch sprite: print the rest
+            _fallbacks++;
+            gfx.setTextSize(size);
+            gfx.setTextColor(color);
+            gfx.setCursor(x, y);
+            gfx.print(c);
+            return;
+        }
+
+        const uint32_t* rows = _rows + g->row;
+        uint16_t* line = surface.pixels + (int32_t)y * surface.width + x;
+        for (int r = 0; r < g->height; r++, line += surface.width) {
+            // Each run of set bits is a horizontal span of the glyph
+            uint32_t bits = rows[r];
+            while (bits) {
+                int start = __builtin_ctz(bits);
+                uint32_t next = bits + (bits & (0u - bits));
+                int end = next ? __builtin_ctz(next) : 32;
+                for (int i = start; i < end; i++) {
+                    line[i] = pixel;
+                }
+                bits &= next;
+            }
+        }
+        x += g->width;
+    }
+}
@@ -0,0 +1,72 @@
+/**
+ * Pre-rasterized glyphs for the widget screens' text.
+ *
+ * Every refresh prints the same labels again, and print() walks the font
+ * data column by column and issues a fillRect() per run of set pixels.
+ * Here each glyph is rasterized once per font and text size into a bit
+ * mask (one 32-bit word per pixel row) kept in a fixed arena, and a run
+ * of text is drawn by writing the masks' set pixels straight into the
+ * frame buffer's RGB565 pixels. The masks hold no colour, so one entry
+ * serves the glyph in every colour. When the slots or the arena fill up,
+ * the cache is emptied and refilled from what is drawn next.
+ *
+ * Only what print() would draw the same way is taken this path: a fixed
+ * cell (GLCD) font, printable ASCII, the top-left text datum, and a run
+ * that lies wholly inside the clip rectangle (so print() would neither
+ * wrap nor shift it). Anything else, or a target without a pixel
+ * buffer, goes through print() as before.
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdint.h>
+
+#include "Particles.h"
+
+#define TEXT_CACHE_SLOTS 256        // Glyph slots (power of two); emptied at 3/4 full
+#define TEXT_CACHE_ROWS 1024        // Mask rows in the arena, 4 bytes each
+#define TEXT_CACHE_GLYPH_MAX 32     // Widest and tallest cached glyph, in pixels
+
+class TextCache {
+public:
+    TextCache() : _glyphs(0), _rowsUsed(0), _hits(0), _misses(0), _fallbacks(0), _flushes(0) { clear(); }
+
+    // Draw `text` at x, y as gfx.print() would, in `color` with no background.
+    // `surface` is gfx's own pixel buffer, or no pixels to always print().
+    void draw(LovyanGFX& gfx, const PixelSurface& surface, int x, int y, const char* text, uint8_t size,
+              uint16_t color);
+
+    // Forget every glyph (the counters are kept)
+    void clear();
+
+    uint32_t hits() const { return _hits; }             // Glyphs drawn from the cache
+    uint32_t misses() const { return _misses; }         // Glyphs rasterized into it
+    uint32_t fallbacks() const { return _fallbacks; }   // Runs left to print()
+    uint32_t flushes() const { return _flushes; }       // Times it filled up and was emptied
+    int glyphs() const { return _glyphs; }
+    int rowsUsed() const { return _rowsUsed; }
+
+private:
+    struct Glyph {
+        const lgfx::IFont* font;   // nullptr: free slot
+        uint16_t row;              // First mask row in _rows
+        uint8_t code;
+        uint8_t size;
+        uint8_t width;             // Advance, in pixels
+        uint8_t height;
+    };
+
+    const Glyph* find(const lgfx::IFont* font, uint8_t size, uint8_t code);
+    const Glyph* rasterize(Glyph* slot, const lgfx::IFont* font, uint8_t size, uint8_t code);
+
+    Glyph _slots[TEXT_CACHE_SLOTS];
+    uint32_t _rows[TEXT_CACHE_ROWS];    // Bit x of a row is pixel x of the glyph
+    int _glyphs;
+    int _rowsUsed;
+    LGFX_Sprite _raster;                // 1-bit scratch that glyphs are printed into
+    uint32_t _hits;
+    uint32_t _misses;
+    uint32_t _fallbacks;
+    uint32_t _flushes;
+};
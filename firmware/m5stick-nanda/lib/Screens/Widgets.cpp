@@ -0,0 +1,100 @@
+#include "Widgets.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Measures text only; never gets a buffer, so it costs no pixels
+static LGFX_Sprite textMetrics;
+static TextCache textCache;
+
+TextCache& widgetTextCache() {
+    return textCache;
+}
+
+bool Widget::operator==(const Widget& other) const {
+    return kind == other.kind && size == other.size && color == other.color && frame == other.frame &&
+           x == other.x && y == other.y && w == other.w && h == other.h && level == other.level &&
+           strcmp(text, other.text) == 0;
+}
+
+void Widget::draw(LovyanGFX& gfx, const PixelSurface& surface) const {
+    switch (kind) {
+        case FILL:
+            gfx.fillRect(x, y, w, h, color);
+            break;
+        case TEXT:
+            textCache.draw(gfx, surface, x, y, text, size, color);
+            break;
+        case BAR:
+            gfx.drawRect(x, y, w, h, frame);
+            gfx.fillRect(x + 2, y + 2, level * (w - 4) / 100, h - 4, color);
+            break;
+    }
+}
+
+Widget* Widgets::add(Widget::Kind kind, int x, int y, int w, int h, uint16_t color) {
+    if (_count >= WIDGET_MAX) return nullptr;
+    Widget* widget = &_items[_count++];
+    widget->kind = kind;
+    widget->size = 1;
+    widget->color = color;
+    widget->frame = 0;
+    widget->x = x;
+    widget->y = y;
+    widget->w = w;
+    widget->h = h;
+    widget->level = 0;
+    widget->text[0] = '\0';
+    return widget;
+}
+
+int Widgets::addText(int x, int y, int w, uint16_t color, uint8_t size, const char* fmt, va_list args) {
+    Widget* widget = add(Widget::TEXT, x, y, w, 0, color);
+    if (!widget) return x + w;
+    vsnprintf(widget->text, sizeof(widget->text), fmt, args);
+
+    textMetrics.setTextSize(size);
+    int width = textMetrics.textWidth(widget->text);
+    widget->size = size;
+    widget->w = width > w ? width : w;
+    widget->h = textMetrics.fontHeight();
+    return x + widget->w;
+}
+
+void Widgets::fill(int x, int y, int w, int h, uint16_t color) {
+    add(Widget::FILL, x, y, w, h, color);
+}
+
+int Widgets::text(int x, int y, uint16_t color, uint8_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int end = addText(x, y, 0, color, size, fmt, args);
+    va_end(args);
+    return end;
+}
+
+int Widgets::field(int x, int y, int w, uint16_t color, uint8_t size, const char* fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    int end = addText(x, y, w, color, size, fmt, args);
+    va_end(args);
+    return end;
+}
+
+void Widgets::bar(int x, int y, int w, int h, int percent, uint16_t color, uint16_t frame) {
+    Widget* widget = add(Widget::BAR, x, y, w, h, color);
+    if (!widget) return;
+    widget->frame = frame;
+    widget->level = percent < 0 ? 0 : percent > 100 ? 100 : percent;
+}
+
+void Widgets::row(int y, int h, bool selected) {
+    add(Widget::FILL, 0, y, 240, h, selected ? TFT_NAVY : TFT_BLACK);
+}
+
+void Widgets::draw(LovyanGFX& gfx, uint16_t background, const PixelSurface& surface) const {
+    gfx.fillScreen(background);
+    for (int i = 0; i < _count; i++) {
+        _items[i].draw(gfx, surface);
+    }
+}
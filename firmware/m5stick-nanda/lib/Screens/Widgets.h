@@ -0,0 +1,79 @@
+/**
+ * Retained-mode description of a screen.
+ *
+ * A screen declares its widgets (text, fixed-width value fields, filled
+ * rectangles, bars, list rows) in the same order every frame. The list
+ * is either drawn at once onto a target, or handed to a Compositor that
+ * compares it with the previous frame and repaints only the widgets
+ * whose content, colour or position changed.
+ *
+ * Widgets are plain values with their text copied in, so a frame can be
+ * kept and compared after the ScreenState it came from is gone.
+ *
+ * Given the target's pixels, text is drawn from a shared TextCache of
+ * pre-rasterized glyphs rather than through print().
+ */
+
+#pragma once
+
+#include <M5GFX.h>
+#include <stdarg.h>
+#include <stdint.h>
+
+#include "TextCache.h"
+
+#define WIDGET_MAX 32         // Widgets per screen
+#define WIDGET_TEXT_MAX 40    // Longer text is cut
+
+struct Widget {
+    enum Kind : uint8_t { FILL, TEXT, BAR };
+
+    Kind kind;
+    uint8_t size;      // Text size
+    uint16_t color;    // Text or fill colour
+    uint16_t frame;    // BAR: outline colour
+    int16_t x, y, w, h;
+    int16_t level;     // BAR: 0..100
+    char text[WIDGET_TEXT_MAX];
+
+    bool operator==(const Widget& other) const;
+    bool operator!=(const Widget& other) const { return !(*this == other); }
+
+    // `surface`: gfx's pixels, for cached text; none to print() it
+    void draw(LovyanGFX& gfx, const PixelSurface& surface = PixelSurface()) const;
+};
+
+// The glyph cache every widget's text is drawn through
+TextCache& widgetTextCache();
+
+class Widgets {
+public:
+    // Text is measured in the default font; nothing is drawn until draw()
+    Widgets() : _count(0) {}
+
+    void clear() { _count = 0; }
+
+    // Solid rectangle
+    void fill(int x, int y, int w, int h, uint16_t color);
+    // Text at its natural width; returns the x just past it, for the next span
+    int text(int x, int y, uint16_t color, uint8_t size, const char* fmt, ...);
+    // Text in a box of fixed width, so the rectangle stays put as the value changes
+    int field(int x, int y, int w, uint16_t color, uint8_t size, const char* fmt, ...);
+    // Outlined bar filled to `percent`
+    void bar(int x, int y, int w, int h, int percent, uint16_t color, uint16_t frame);
+    // Full-width list row background: highlighted when selected, else background
+    void row(int y, int h, bool selected);
+
+    int count() const { return _count; }
+    const Widget& operator[](int index) const { return _items[index]; }
+
+    // Paint the background and every widget onto `gfx`
+    void draw(LovyanGFX& gfx, uint16_t background = TFT_BLACK, const PixelSurface& surface = PixelSurface()) const;
+
+private:
+    Widget* add(Widget::Kind kind, int x, int y, int w, int h, uint16_t color);
+    int addText(int x, int y, int w, uint16_t color, uint8_t size, const char* fmt, va_list args);
+
+    Widget _items[WIDGET_MAX];
+    int _count;
+};
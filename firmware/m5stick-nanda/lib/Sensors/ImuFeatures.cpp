@@ -0,0 +1,268 @@
+#include "ImuFeatures.h"
+
+#include <math.h>
+#include <string.h>
+
+#define CHUNK 32
+#define RAD_TO_DEG_F 57.29578f
+
+// Hann's mean square: turns the windowed spectrum's power back into the signal's
+#define HANN_POWER (3.0f / 8.0f)
+
+AxisStats axisStats(const float* x, size_t n) {
+    AxisStats stats = {0, 0, 0};
+    if (n == 0) return stats;
+
+    // Two passes (mean first) keep the variance exact for a small spread around a large mean
+    float sum[4] = {0, 0, 0, 0};
+    float squares[4] = {0, 0, 0, 0};
+    size_t body = n & ~(size_t)3;
+    for (size_t i = 0; i < body; i += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            float v = x[i + lane];
+            sum[lane] += v;
+            squares[lane] += v * v;
+        }
+    }
+    for (size_t i = body; i < n; i++) {
+        sum[0] += x[i];
+        squares[0] += x[i] * x[i];
+    }
+    float mean = (sum[0] + sum[1] + sum[2] + sum[3]) / n;
+
+    float spread[4] = {0, 0, 0, 0};
+    for (size_t i = 0; i < body; i += 4) {
+        for (int lane = 0; lane < 4; lane++) {
+            float d = x[i + lane] - mean;
+            spread[lane] += d * d;
+        }
+    }
+    for (size_t i = body; i < n; i++) {
+        spread[0] += (x[i] - mean) * (x[i] - mean);
+    }
+
+    stats.mean = mean;
+    stats.variance = (spread[0] + spread[1] + spread[2] + spread[3]) / n;
+    stats.rms = sqrtf((squares[0] + squares[1] + squares[2] + squares[3]) / n);
+    return stats;
+}
+
+void vectorMagnitude(const float* x, const float* y, const float* z, float* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+    }
+}
+
+void fftQ15(int16_t* re, int16_t* im, size_t n, const int16_t* cosTable, const int16_t* sinTable) {
+    // Bit-reversed order first, then butterflies in place
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) {
+            int16_t t = re[i];
+            re[i] = re[j];
+            re[j] = t;
+            t = im[i];
+            im[i] = im[j];
+            im[j] = t;
+        }
+    }
+
+    for (size_t len = 2; len <= n; len <<= 1) {
+        size_t half = len >> 1;
+        size_t step = n / len;
+        for (size_t start = 0; start < n; start += len) {
+            int16_t* ar = re + start;
+            int16_t* ai = im + start;
+            int16_t* br = ar + half;
+            int16_t* bi = ai + half;
+            for (size_t k = 0; k < half; k++) {
+                // b * e^(-2 pi i k / len), then halve both outputs so nothing
+                // overflows; rounding keeps the stages from adding up a bias
+                int32_t wr = cosTable[k * step];
+                int32_t wi = sinTable[k * step];
+                int32_t tr = (wr * br[k] + wi * bi[k] + (1 << 14)) >> 15;
+                int32_t ti = (wr * bi[k] - wi * br[k] + (1 << 14)) >> 15;
+                int32_t xr = ar[k];
+                int32_t xi = ai[k];
+                ar[k] = (xr + tr + 1) >> 1;
+                ai[k] = (xi + ti + 1) >> 1;
+                br[k] = (xr - tr + 1) >> 1;
+                bi[k] = (xi - ti + 1) >> 1;
+            }
+        }
+    }
+}
+
+static int16_t toQ15(float value) {
+    float scaled = roundf(value);
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)scaled;
+}
+
+ImuFeatureExtractor::ImuFeatureExtractor() {
+    const float pi = 3.14159265f;
+    for (int i = 0; i < IMU_FEATURE_WINDOW; i++) {
+        _hann[i] = toQ15(32767.0f * 0.5f * (1.0f - cosf(2 * pi * i / IMU_FEATURE_WINDOW)));
+    }
+    for (int k = 0; k < IMU_FEATURE_WINDOW / 2; k++) {
+        _cos[k] = toQ15(32767.0f * cosf(2 * pi * k / IMU_FEATURE_WINDOW));
+        _sin[k] = toQ15(32767.0f * sinf(2 * pi * k / IMU_FEATURE_WINDOW));
+    }
+    begin(IMU_SAMPLE_HZ);
+}
+
+void ImuFeatureExtractor::begin(uint16_t sampleHz) {
+    _head = 0;
+    _count = 0;
+    _sampleHz = sampleHz ? sampleHz : 1;
+    _cursor = 0;
+    _following = false;
+    _dropped = 0;
+    _newestUsec = 0;
+    _lastMagnitude = 0;
+    _activity = 0;
+    _hasLast = false;
+    _taps = 0;
+    _lastTapUsec = 0;
+    _shaking = false;
+    _shakes = 0;
+}
+
+void ImuFeatureExtractor::update(const ImuRing& ring) {
+    if (!_following) {
+        uint32_t written = ring.written();
+        _cursor = written - (written < IMU_FEATURE_WINDOW ? written : IMU_FEATURE_WINDOW);
+        _following = true;
+    }
+    ImuSample chunk[CHUNK];
+    size_t n;
+    while ((n = ring.readFrom(_cursor, chunk, CHUNK, &_dropped)) > 0) {
+        addChunk(chunk, n);
+    }
+}
+
+void ImuFeatureExtractor::add(const ImuSample* samples, size_t count) {
+    while (count > 0) {
+        size_t n = count < CHUNK ? count : CHUNK;
+        addChunk(samples, n);
+        samples += n;
+        count -= n;
+    }
+}
+
+void ImuFeatureExtractor::addChunk(const ImuSample* samples, size_t count) {
+    // Transpose into structure-of-arrays, then run the kernels over the chunk
+    float axis[IMU_FEATURE_AXES][CHUNK];
+    float magnitude[CHUNK];
+    for (size_t i = 0; i < count; i++) {
+        axis[IMU_ACCEL_X][i] = samples[i].accelX;
+        axis[IMU_ACCEL_Y][i] = samples[i].accelY;
+        axis[IMU_ACCEL_Z][i] = samples[i].accelZ;
+        axis[IMU_GYRO_X][i] = samples[i].gyroX;
+        axis[IMU_GYRO_Y][i] = samples[i].gyroY;
+        axis[IMU_GYRO_Z][i] = samples[i].gyroZ;
+    }
+    vectorMagnitude(axis[IMU_ACCEL_X], axis[IMU_ACCEL_Y], axis[IMU_ACCEL_Z], magnitude, count);
+
+    // Tap: a sharp rise of |accel| out of stillness, then a pause
+    for (size_t i = 0; i < count; i++) {
+        float jerk = _hasLast ? magnitude[i] - _lastMagnitude : 0;
+        bool settled = _taps == 0 || samples[i].usec - _lastTapUsec >= IMU_TAP_REFRACTORY_MS * 1000UL;
+        if (jerk > IMU_TAP_JERK_G && _activity < IMU_TAP_JERK_G / 4 && settled) {
+            _taps++;
+            _lastTapUsec = samples[i].usec;
+        }
+        _activity += (fabsf(jerk) - _activity) * 0.125f;
+        _lastMagnitude = magnitude[i];
+        _hasLast = true;
+    }
+    _newestUsec = samples[count - 1].usec;
+
+    // Into the circular window, in at most two runs per array
+    size_t done = 0;
+    while (done < count) {
+        size_t run = IMU_FEATURE_WINDOW - _head;
+        if (run > count - done) run = count - done;
+        for (int a = 0; a < IMU_FEATURE_AXES; a++) {
+            memcpy(&_axis[a][_head], &axis[a][done], run * sizeof(float));
+        }
+        memcpy(&_magnitude[_head], &magnitude[done], run * sizeof(float));
+        _head = (_head + run) & (IMU_FEATURE_WINDOW - 1);
+        done += run;
+    }
+    _count += count;
+    if (_count > IMU_FEATURE_WINDOW) _count = IMU_FEATURE_WINDOW;
+}
+
+bool ImuFeatureExtractor::summarize(ImuFeatures& out) {
+    if (_count == 0) return false;
+    memset(&out, 0, sizeof(out));
+    out.usec = _newestUsec;
+    out.samples = _count;
+
+    // Until the window is full the samples sit at 0 .. _count - 1; order does not matter here
+    for (int a = 0; a < IMU_FEATURE_AXES; a++) {
+        AxisStats stats = axisStats(_axis[a], _count);
+        out.mean[a] = stats.mean;
+        out.variance[a] = stats.variance;
+        out.rms[a] = stats.rms;
+    }
+    AxisStats magnitude = axisStats(_magnitude, _count);
+    out.magnitudeMean = magnitude.mean;
+    out.magnitudeStd = sqrtf(magnitude.variance);
+
+    float ax = out.mean[IMU_ACCEL_X];
+    float ay = out.mean[IMU_ACCEL_Y];
+    float az = out.mean[IMU_ACCEL_Z];
+    out.pitch = atan2f(-ax, sqrtf(ay * ay + az * az)) * RAD_TO_DEG_F;
+    out.roll = atan2f(ay, az) * RAD_TO_DEG_F;
+
+    bool shaking = out.magnitudeStd > IMU_SHAKE_G;
+    if (shaking && !_shaking) _shakes++;
+    _shaking = shaking;
+    out.shaking = shaking;
+    out.shakes = _shakes;
+    out.taps = _taps;
+    out.lastTapUsec = _lastTapUsec;
+
+    out.bandHz = _sampleHz / 2.0f / IMU_FEATURE_BANDS;
+    if (_count == IMU_FEATURE_WINDOW) spectrum(out);
+    return true;
+}
+
+void ImuFeatureExtractor::spectrum(ImuFeatures& out) {
+    // |accel| around its mean, oldest first, Hann-windowed into Q15
+    float mean = out.magnitudeMean;
+    for (int i = 0; i < IMU_FEATURE_WINDOW; i++) {
+        float v = (_magnitude[(_head + i) & (IMU_FEATURE_WINDOW - 1)] - mean) * IMU_FFT_LSB;
+        if (v > 32767.0f) v = 32767.0f;
+        if (v < -32768.0f) v = -32768.0f;
+        _re[i] = ((int32_t)v * _hann[i]) >> 15;
+        _im[i] = 0;
+    }
+    fftQ15(_re, _im, IMU_FEATURE_WINDOW, _cos, _sin);
+
+    // A line of amplitude A shows as A/4 in its bin (half in each sideband, Hann's gain 1/2)
+    const float toG = 1.0f / IMU_FFT_LSB;
+    float power[IMU_FEATURE_BANDS] = {0};
+    float peak = 0;
+    int peakBin = 0;
+    for (int k = 1; k < IMU_FEATURE_WINDOW / 2; k++) {
+        float re = _re[k] * toG;
+        float im = _im[k] * toG;
+        float p = re * re + im * im;
+        if (p > peak) {
+            peak = p;
+            peakBin = k;
+        }
+        power[k * IMU_FEATURE_BANDS / (IMU_FEATURE_WINDOW / 2)] += p;
+    }
+    out.peakHz = peakBin * (float)_sampleHz / IMU_FEATURE_WINDOW;
+    out.peakG = 4 * sqrtf(peak);
+    for (int b = 0; b < IMU_FEATURE_BANDS; b++) {
+        out.bands[b] = sqrtf(2 * power[b] / HANN_POWER);
+    }
+}
@@ -0,0 +1,130 @@
+/**
+ * Features of the recent IMU samples, so clients need not pull them raw.
+ *
+ * An ImuFeatureExtractor follows the sampler's ring with its own cursor
+ * and keeps the last IMU_FEATURE_WINDOW samples as structure-of-arrays,
+ * one float array per axis plus the acceleration magnitude. New samples
+ * go through the tap detector as they arrive; summarize() runs the
+ * window kernels: mean, variance and RMS of every axis, a Q15 fixed-point
+ * FFT of the magnitude (the vibration spectrum), tilt from the mean
+ * gravity vector and shake from the spread of the magnitude.
+ *
+ * The kernels take plain arrays, keep four independent accumulators and
+ * have no branches in their inner loops, so the compiler can vectorize
+ * them where the target has SIMD. Nothing is allocated after
+ * construction.
+ *
+ * Threading: an extractor belongs to one task. Summaries are plain
+ * 32-bit words and are handed to other tasks through an ImuFeatureRing.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SensorSamples.h"
+
+#ifndef IMU_FEATURE_WINDOW
+#define IMU_FEATURE_WINDOW 128        // Samples (power of two), also the FFT size
+#endif
+#define IMU_FEATURE_AXES 6            // accel x, y, z, gyro x, y, z
+#define IMU_FEATURE_BANDS 4           // Equal slices of 0 .. half the sample rate
+#define IMU_FFT_LSB 8192              // Q15 FFT input per g: +-4 g of vibration
+#ifndef IMU_TAP_JERK_G
+#define IMU_TAP_JERK_G 0.8f           // Rise of |accel| from one sample to the next
+#endif
+#ifndef IMU_TAP_REFRACTORY_MS
+#define IMU_TAP_REFRACTORY_MS 200     // One tap per this long at most
+#endif
+#ifndef IMU_SHAKE_G
+#define IMU_SHAKE_G 0.35f             // Standard deviation of |accel| over the window
+#endif
+
+static_assert((IMU_FEATURE_WINDOW & (IMU_FEATURE_WINDOW - 1)) == 0 && IMU_FEATURE_WINDOW >= 8,
+              "IMU_FEATURE_WINDOW must be a power of two");
+static_assert(IMU_FEATURE_WINDOW <= IMU_RING_SAMPLES, "The window cannot be longer than the ring");
+
+enum ImuAxis { IMU_ACCEL_X, IMU_ACCEL_Y, IMU_ACCEL_Z, IMU_GYRO_X, IMU_GYRO_Y, IMU_GYRO_Z };
+
+struct ImuFeatures {
+    uint32_t usec;                    // Newest sample in the window
+    uint32_t samples;                 // In the window (fewer just after begin())
+    float mean[IMU_FEATURE_AXES];     // By ImuAxis: g and deg/s
+    float variance[IMU_FEATURE_AXES];
+    float rms[IMU_FEATURE_AXES];
+    float magnitudeMean;              // |accel|, g
+    float magnitudeStd;
+    float pitch;                      // Degrees, from the mean gravity vector
+    float roll;
+    float peakHz;                     // Strongest line of the |accel| spectrum (0: window not full)
+    float peakG;                      // Its amplitude
+    float bandHz;                     // Width of each band
+    float bands[IMU_FEATURE_BANDS];   // RMS g of |accel| per band, DC excluded
+    uint32_t shaking;                 // 0 or 1: magnitudeStd above IMU_SHAKE_G
+    uint32_t shakes;                  // Times shaking started
+    uint32_t taps;
+    uint32_t lastTapUsec;             // 0: none yet
+};
+
+typedef SampleRing<ImuFeatures, 4> ImuFeatureRing;
+
+struct AxisStats {
+    float mean;
+    float variance;                   // Population variance
+    float rms;
+};
+
+// Window kernels, exposed for tests and benchmarks
+AxisStats axisStats(const float* x, size_t n);
+void vectorMagnitude(const float* x, const float* y, const float* z, float* out, size_t n);
+// In-place forward FFT of n (power of two) Q15 values with a table of n/2
+// twiddles; every stage halves, so the result is the DFT divided by n
+void fftQ15(int16_t* re, int16_t* im, size_t n, const int16_t* cosTable, const int16_t* sinTable);
+
+class ImuFeatureExtractor {
+public:
+    ImuFeatureExtractor();
+
+    // Forget the window and counters; spectra are in Hz of `sampleHz`
+    void begin(uint16_t sampleHz);
+
+    // Take what the sampler pushed since the last call (on the first call,
+    // the last window's worth of history)
+    void update(const ImuRing& ring);
+    // Or feed samples directly, oldest first
+    void add(const ImuSample* samples, size_t count);
+
+    // Run the window kernels; false while there is no sample
+    bool summarize(ImuFeatures& out);
+
+    uint32_t dropped() const { return _dropped; }   // Lost to the ring while behind
+
+private:
+    void addChunk(const ImuSample* samples, size_t count);
+    void spectrum(ImuFeatures& out);
+
+    float _axis[IMU_FEATURE_AXES][IMU_FEATURE_WINDOW];   // Circular, oldest at _head once full
+    float _magnitude[IMU_FEATURE_WINDOW];
+    int16_t _re[IMU_FEATURE_WINDOW];
+    int16_t _im[IMU_FEATURE_WINDOW];
+    int16_t _hann[IMU_FEATURE_WINDOW];
+    int16_t _cos[IMU_FEATURE_WINDOW / 2];
+    int16_t _sin[IMU_FEATURE_WINDOW / 2];
+    size_t _head;
+    size_t _count;
+    uint16_t _sampleHz;
+    uint32_t _cursor;
+    bool _following;
+    uint32_t _dropped;
+    uint32_t _newestUsec;
+    // Tap detector
+    float _lastMagnitude;
+    float _activity;                  // Moving average of |jerk|: taps only out of stillness
+    bool _hasLast;
+    uint32_t _taps;
+    uint32_t _lastTapUsec;
+    // Shake detector
+    bool _shaking;
+    uint32_t _shakes;
+};
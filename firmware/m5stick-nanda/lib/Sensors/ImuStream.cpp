@@ -0,0 +1,119 @@
+#include "ImuStream.h"
+
+#include <math.h>
+
+static_assert(IMU_STREAM_MAX_LAG <= IMU_RING_SAMPLES, "A stream cannot lag more than the ring keeps");
+
+static void putLE16(uint8_t* p, uint16_t v) {
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+static void putLE32(uint8_t* p, uint32_t v) {
+    putLE16(p, v);
+    putLE16(p + 2, v >> 16);
+}
+
+static int16_t toFixed(float value, int lsb) {
+    float scaled = roundf(value * lsb);
+    if (scaled > 32767.0f) return 32767;
+    if (scaled < -32768.0f) return -32768;
+    return (int16_t)scaled;
+}
+
+void ImuStream::begin(const ImuRing& ring, uint16_t sampleHz, uint16_t rateHz, uint8_t batch) {
+    if (sampleHz == 0) sampleHz = 1;
+    if (rateHz < IMU_STREAM_RATE_MIN) rateHz = IMU_STREAM_RATE_MIN;
+    if (rateHz > sampleHz) rateHz = sampleHz;
+
+    // Every sample of a batch has to fit in the lag the stream may have
+    uint32_t step = (sampleHz + rateHz / 2) / rateHz;
+    uint32_t stepMax = sampleHz / IMU_STREAM_RATE_MIN;
+    if (stepMax > IMU_STREAM_MAX_LAG) stepMax = IMU_STREAM_MAX_LAG;
+    if (step > stepMax) step = stepMax;
+    if (step < 1) step = 1;
+
+    _ring = &ring;
+    _cursor = ring.written();
+    _step = step;
+    _skip = 0;
+    _rate = sampleHz / step;
+
+    uint32_t frameBatch = batch ? batch : (uint32_t)_rate * IMU_STREAM_FRAME_MS / 1000;
+    uint32_t batchMax = IMU_STREAM_MAX_LAG / step;
+    if (batchMax > IMU_STREAM_BATCH_MAX) batchMax = IMU_STREAM_BATCH_MAX;
+    if (frameBatch > batchMax) frameBatch = batchMax;
+    if (frameBatch < 1) frameBatch = 1;
+    _batch = frameBatch;
+
+    _pendingDrops = 0;
+    _frames = 0;
+    _samples = 0;
+    _dropped = 0;
+}
+
+size_t ImuStream::poll(uint8_t* out) {
+    if (!_ring) return 0;
+
+    uint32_t behind = _ring->written() - _cursor;
+    if (behind > IMU_STREAM_MAX_LAG) {
+        _pendingDrops += behind - IMU_STREAM_MAX_LAG;
+        _cursor += behind - IMU_STREAM_MAX_LAG;
+        behind = IMU_STREAM_MAX_LAG;
+    }
+    if (behind < _skip + 1 + (uint32_t)(_batch - 1) * _step) return 0;
+
+    uint8_t* p = out + IMU_STREAM_HEADER_BYTES;
+    int count = 0;
+    uint32_t first = 0;
+    uint32_t prev = 0;
+    uint32_t lost = 0;
+    ImuSample chunk[16];
+
+    while (count < _batch) {
+        // Exactly the samples the rest of the batch needs, so none is read twice or skipped
+        uint32_t need = _skip + 1 + (uint32_t)(_batch - count - 1) * _step;
+        size_t n = _ring->readFrom(_cursor, chunk, need < 16 ? need : 16, &lost);
+        if (n == 0) break;   // Lost some to the writer: send what there is
+
+        for (size_t i = 0; i < n; i++) {
+            if (_skip) {
+                _skip--;
+                continue;
+            }
+            _skip = _step - 1;
+
+            const ImuSample& s = chunk[i];
+            uint32_t dt = count ? (s.usec - prev) / IMU_STREAM_DT_US : 0;
+            if (count == 0) first = s.usec;
+            prev = s.usec;
+            putLE16(p, dt > 0xFFFF ? 0xFFFF : dt);
+            putLE16(p + 2, toFixed(s.accelX, IMU_STREAM_ACCEL_LSB));
+            putLE16(p + 4, toFixed(s.accelY, IMU_STREAM_ACCEL_LSB));
+            putLE16(p + 6, toFixed(s.accelZ, IMU_STREAM_ACCEL_LSB));
+            putLE16(p + 8, toFixed(s.gyroX, IMU_STREAM_GYRO_LSB));
+            putLE16(p + 10, toFixed(s.gyroY, IMU_STREAM_GYRO_LSB));
+            putLE16(p + 12, toFixed(s.gyroZ, IMU_STREAM_GYRO_LSB));
+            p += IMU_STREAM_SAMPLE_BYTES;
+            count++;
+        }
+    }
+    if (count == 0) {
+        _pendingDrops += lost;
+        return 0;
+    }
+
+    uint32_t drops = _pendingDrops + lost;
+    out[0] = IMU_STREAM_VERSION;
+    out[1] = count;
+    putLE16(out + 2, drops > 0xFFFF ? 0xFFFF : drops);
+    putLE32(out + 4, first);
+    putLE16(out + 8, _rate);
+    putLE16(out + 10, 0);
+
+    _dropped += drops;
+    _pendingDrops = 0;
+    _frames++;
+    _samples += count;
+    return p - out;
+}
@@ -0,0 +1,84 @@
+/**
+ * One client's stream of IMU samples, packed into binary frames.
+ *
+ * The stream follows the sampler's ring with its own cursor, keeps every
+ * n-th sample for the rate the client asked for, and packs a batch of
+ * them per frame: a 12-byte header, then 14 bytes per sample (16-bit
+ * time delta, accel and gyro as int16). All values little-endian.
+ *
+ *   0  u8   IMU_STREAM_VERSION
+ *   1  u8   samples in this frame
+ *   2  u16  samples dropped since the previous frame (saturates)
+ *   4  u32  time of the first sample, us (micros(), wraps)
+ *   8  u16  samples per second after decimation
+ *  10  u16  0 (reserved)
+ *  12  per sample:
+ *      u16  time since the previous sample, in 10 us (0 for the first)
+ *      i16  accel x, y, z   (IMU_STREAM_ACCEL_LSB per g)
+ *      i16  gyro x, y, z    (IMU_STREAM_GYRO_LSB per deg/s)
+ *
+ * Backpressure: poll() is only called while the client can take another
+ * frame, so samples wait in the ring for a client that is behind. One
+ * more than IMU_STREAM_MAX_LAG samples behind skips ahead to the newest
+ * IMU_STREAM_MAX_LAG: the oldest samples are dropped, never the newest,
+ * latency stays bounded, and the next frame says how many were lost.
+ *
+ * Threading: a stream belongs to one task; the ring may be written
+ * concurrently by the sampler.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "SensorSamples.h"
+
+#define IMU_STREAM_VERSION 1
+#define IMU_STREAM_BATCH_MAX 32
+#define IMU_STREAM_HEADER_BYTES 12
+#define IMU_STREAM_SAMPLE_BYTES 14
+#define IMU_STREAM_FRAME_MAX (IMU_STREAM_HEADER_BYTES + IMU_STREAM_BATCH_MAX * IMU_STREAM_SAMPLE_BYTES)
+#define IMU_STREAM_ACCEL_LSB 4096      // Per g: +-8 g
+#define IMU_STREAM_GYRO_LSB 16         // Per deg/s: +-2048 deg/s
+#define IMU_STREAM_DT_US 10            // Unit of the time deltas
+#define IMU_STREAM_RATE_MIN 2          // Lowest rate whose deltas fit 16 bits
+#ifndef IMU_STREAM_FRAME_MS
+#define IMU_STREAM_FRAME_MS 50         // Default batching: about one frame this often
+#endif
+#ifndef IMU_STREAM_MAX_LAG
+#define IMU_STREAM_MAX_LAG (IMU_RING_SAMPLES / 2)
+#endif
+
+class ImuStream {
+public:
+    ImuStream() : _ring(nullptr), _cursor(0), _step(1), _skip(0), _batch(1), _rate(0),
+                  _pendingDrops(0), _frames(0), _samples(0), _dropped(0) {}
+
+    // Send `rateHz` (clamped to what `sampleHz` allows) of the ring's
+    // samples, `batch` per frame; batch 0 picks about one frame per
+    // IMU_STREAM_FRAME_MS. Starts from the next sample pushed.
+    void begin(const ImuRing& ring, uint16_t sampleHz, uint16_t rateHz, uint8_t batch = 0);
+
+    // The next frame into `out` (IMU_STREAM_FRAME_MAX bytes) once a full
+    // batch is waiting; 0 if not yet
+    size_t poll(uint8_t* out);
+
+    uint16_t rate() const { return _rate; }
+    uint8_t batch() const { return _batch; }
+    uint32_t frames() const { return _frames; }
+    uint32_t samples() const { return _samples; }   // Sent
+    uint32_t dropped() const { return _dropped; }   // Lost while behind
+
+private:
+    const ImuRing* _ring;
+    uint32_t _cursor;
+    uint16_t _step;          // Keep one sample in _step
+    uint16_t _skip;          // Samples to pass over before the next kept one
+    uint8_t _batch;
+    uint16_t _rate;
+    uint32_t _pendingDrops;  // Not yet reported in a frame
+    uint32_t _frames;
+    uint32_t _samples;
+    uint32_t _dropped;
+};
@@ -0,0 +1,126 @@
+/**
+ * Lock-free ring of timestamped samples: one writer, any number of readers.
+ *
+ * The sampler task push()es every reading; the UI, HTTP handlers and
+ * streams read the newest one (latest()) or everything since their own
+ * cursor (readFrom()) without locks and without waiting for the writer.
+ * The writer never waits for readers either: a reader that falls more
+ * than N samples behind loses the overwritten ones, and is told how many.
+ *
+ * Each slot is a seqlock. Its sequence is odd while the writer is
+ * filling it and 2 * (index + 1) once sample `index` is complete; a
+ * reader copies the slot and accepts the copy only if the sequence was
+ * that even value both before and after. The sample is stored as 32-bit
+ * atomic words, so a torn copy is detected and discarded, never
+ * undefined behaviour.
+ *
+ * T must be trivially copyable and a multiple of 4 bytes; N a power of two.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+template <typename T, size_t N>
+class SampleRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "N must be a power of two");
+    static_assert(std::is_trivially_copyable<T>::value && sizeof(T) % 4 == 0, "T must be plain 32-bit words");
+
+public:
+    SampleRing() : _written(0) {
+        for (Slot& slot : _slots) {
+            slot.seq.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr size_t capacity() { return N; }
+
+    // Writer side: add the next sample, overwriting the oldest
+    void push(const T& sample) {
+        uint32_t index = _written.load(std::memory_order_relaxed);
+        Slot& slot = _slots[index & (N - 1)];
+        uint32_t words[WORDS];
+        memcpy(words, &sample, sizeof(T));
+
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            slot.words[i].store(words[i], std::memory_order_relaxed);
+        }
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+        _written.store(index + 1, std::memory_order_release);
+    }
+
+    // Samples pushed so far; the next one will have this index
+    uint32_t written() const { return _written.load(std::memory_order_acquire); }
+
+    // Copy sample `index` if it is still in the ring and was not being overwritten
+    bool read(uint32_t index, T& out) const {
+        const Slot& slot = _slots[index & (N - 1)];
+        uint32_t complete = 2 * index + 2;
+        if (slot.seq.load(std::memory_order_acquire) != complete) return false;
+
+        uint32_t words[WORDS];
+        for (size_t i = 0; i < WORDS; i++) {
+            words[i] = slot.words[i].load(std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.seq.load(std::memory_order_relaxed) != complete) return false;
+
+        memcpy(&out, words, sizeof(T));
+        return true;
+    }
+
+    // The newest sample; false before the first push()
+    bool latest(T& out) const {
+        // Fails only if the writer lapped the whole ring during the copy
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint32_t written = this->written();
+            if (written == 0) return false;
+            if (read(written - 1, out)) return true;
+        }
+        return false;
+    }
+
+    // Copy up to `max` samples from `cursor` on, oldest first, and move the
+    // cursor past them. Samples already overwritten are skipped; their
+    // number is added to *dropped. Start a reader at written() for only
+    // new samples, or at written() - capacity() for all that are kept.
+    size_t readFrom(uint32_t& cursor, T* out, size_t max, uint32_t* dropped = nullptr) const {
+        size_t count = 0;
+        uint32_t lost = 0;
+        uint32_t head = written();
+        if ((int32_t)(head - cursor) < 0) cursor = head;   // Cursor from the future: start over
+
+        while (count < max && cursor != head) {
+            if (head - cursor > N) {
+                lost += head - N - cursor;
+                cursor = head - N;
+            }
+            if (read(cursor, out[count])) {
+                count++;
+            } else {
+                // Being overwritten right now: it is gone either way
+                lost++;
+            }
+            cursor++;
+        }
+        if (dropped) *dropped += lost;
+        return count;
+    }
+
+private:
+    static constexpr size_t WORDS = sizeof(T) / 4;
+
+    struct Slot {
+        std::atomic<uint32_t> seq;
+        std::atomic<uint32_t> words[WORDS];
+    };
+
+    Slot _slots[N];
+    std::atomic<uint32_t> _written;
+};
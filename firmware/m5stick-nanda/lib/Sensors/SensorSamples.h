@@ -0,0 +1,40 @@
+/**
+ * What the sensor sampler task records.
+ *
+ * The IMU is read at a fixed rate into a ring of ImuSamples; temperature
+ * and battery change slowly and are read about once a second into a
+ * ring of StatusSamples. Readers only ever look at the rings.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "SampleRing.h"
+
+#ifndef IMU_SAMPLE_HZ
+#define IMU_SAMPLE_HZ 100         // IMU reads per second
+#endif
+#ifndef IMU_RING_SAMPLES
+#define IMU_RING_SAMPLES 256      // History kept (power of two): 2.5 s at 100 Hz
+#endif
+#ifndef STATUS_SAMPLE_MS
+#define STATUS_SAMPLE_MS 1000     // Temperature and battery
+#endif
+
+struct ImuSample {
+    uint32_t usec;                // When the IMU was read (micros(), wraps)
+    float accelX, accelY, accelZ; // g
+    float gyroX, gyroY, gyroZ;    // deg/s
+};
+
+struct StatusSample {
+    uint32_t ms;                  // When it was read (millis())
+    float temperature;            // IMU die temperature, C
+    float batteryVoltage;         // V
+    int32_t batteryPercent;
+    uint32_t isCharging;          // 0 or 1
+};
+
+typedef SampleRing<ImuSample, IMU_RING_SAMPLES> ImuRing;
+typedef SampleRing<StatusSample, 4> StatusRing;
@@ -0,0 +1,81 @@
+#include "ScratchAllocator.h"
+
+#include <string.h>
+
+// Every block starts with its size, and blocks stay pointer/double aligned
+static const size_t ALIGN = 8;
+static const size_t HEADER = ALIGN;
+static const size_t NO_BLOCK = (size_t)-1;
+
+static size_t roundUp(size_t n) {
+    return (n + ALIGN - 1) & ~(ALIGN - 1);
+}
+
+ScratchAllocator::ScratchAllocator(void* storage, size_t capacity, ArduinoJson::Allocator* parent)
+    : _storage((uint8_t*)storage), _capacity(capacity), _used(0), _last(NO_BLOCK), _peak(0), _fallbacks(0), _parent(parent) {
+    // Start on an aligned address
+    size_t skew = (ALIGN - ((uintptr_t)_storage & (ALIGN - 1))) & (ALIGN - 1);
+    _storage += skew;
+    _capacity = capacity > skew ? capacity - skew : 0;
+}
+
+void ScratchAllocator::reset() {
+    _used = 0;
+    _last = NO_BLOCK;
+}
+
+bool ScratchAllocator::owns(const void* ptr) const {
+    return ptr >= _storage && ptr < _storage + _capacity;
+}
+
+size_t ScratchAllocator::sizeOf(const void* ptr) const {
+    size_t size;
+    memcpy(&size, (const uint8_t*)ptr - HEADER, sizeof(size));
+    return size;
+}
+
+void* ScratchAllocator::allocate(size_t size) {
+    size_t need = HEADER + roundUp(size);
+    if (need > _capacity - _used) {
+        _fallbacks++;
+        return _parent->allocate(size);
+    }
+    uint8_t* block = _storage + _used;
+    memcpy(block, &size, sizeof(size));
+    _last = _used;
+    _used += need;
+    if (_used > _peak) _peak = _used;
+    return block + HEADER;
+}
+
+void ScratchAllocator::deallocate(void* ptr) {
+    if (!ptr) return;
+    if (!owns(ptr)) {
+        _parent->deallocate(ptr);
+        return;
+    }
+    // Only the newest block can be handed back; the rest waits for reset()
+    if (_last != NO_BLOCK && ptr == _storage + _last + HEADER) {
+        _used = _last;
+        _last = NO_BLOCK;
+    }
+}
+
+void* ScratchAllocator::reallocate(void* ptr, size_t size) {
+    if (!ptr) return allocate(size);
+    if (!owns(ptr)) return _parent->reallocate(ptr, size);
+
+    size_t old = sizeOf(ptr);
+    if (_last != NO_BLOCK && ptr == _storage + _last + HEADER &&
+        HEADER + roundUp(size) <= _capacity - _last) {
+        memcpy(_storage + _last, &size, sizeof(size));
+        _used = _last + HEADER + roundUp(size);
+        if (_used > _peak) _peak = _used;
+        return ptr;
+    }
+    if (size <= old) return ptr;
+
+    void* moved = allocate(size);
+    if (moved) memcpy(moved, ptr, old);
+    return moved;
+}
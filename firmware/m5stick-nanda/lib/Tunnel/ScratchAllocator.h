@@ -0,0 +1,48 @@
+/**
+ * Bump allocator for the JsonDocuments of one tunnel request.
+ *
+ * Every document a request needs (parameters, skill output, JSON-RPC
+ * scratch) is carved from caller-owned storage and thrown away at once
+ * with reset() when the response has been sent, so a request costs no
+ * heap allocations. Freeing or growing the most recent block is done in
+ * place, which covers ArduinoJson's string building and shrinkToFit().
+ *
+ * When the storage runs out, requests fall back to the parent allocator
+ * instead of failing; fallbacks() counts how often that happened.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+class ScratchAllocator : public ArduinoJson::Allocator {
+public:
+    ScratchAllocator(void* storage, size_t capacity,
+                     ArduinoJson::Allocator* parent = ArduinoJson::detail::DefaultAllocator::instance());
+
+    void* allocate(size_t size) override;
+    void deallocate(void* ptr) override;
+    void* reallocate(void* ptr, size_t size) override;
+
+    // Release everything; no document built on it may still be alive
+    void reset();
+
+    size_t used() const { return _used; }
+    size_t peak() const { return _peak; }
+    size_t capacity() const { return _capacity; }
+    size_t fallbacks() const { return _fallbacks; }
+
+private:
+    bool owns(const void* ptr) const;
+    size_t sizeOf(const void* ptr) const;
+
+    uint8_t* _storage;
+    size_t _capacity;
+    size_t _used;
+    size_t _last;        // Offset of the most recent block, for in-place resize
+    size_t _peak;
+    size_t _fallbacks;
+    ArduinoJson::Allocator* _parent;
+};
@@ -0,0 +1,583 @@
+#include "TunnelCodec.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+
+// ---------------------------------------------------------------------------
+// Frame writer
+// ---------------------------------------------------------------------------
+
+// Bounded output cursor over the caller's frame buffer
+struct FrameWriter {
+    uint8_t* out;
+    size_t capacity;
+    size_t len;
+    bool overflow;
+
+    void put(uint8_t c) {
+        if (len < capacity) out[len++] = c;
+        else overflow = true;
+    }
+    void put(const void* data, size_t n) {
+        if (n > capacity - len) {
+            overflow = true;
+            return;
+        }
+        memcpy(out + len, data, n);
+        len += n;
+    }
+    void put(const char* s) { put(s, strlen(s)); }
+    void putBE(uint32_t v, int bytes) {
+        while (bytes--) put((uint8_t)(v >> (8 * bytes)));
+    }
+};
+
+static const char HEX_DIGITS[] = "0123456789abcdef";
+
+// Extra bytes a JSON string escape adds for one character
+static size_t escapeCost(uint8_t c) {
+    if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t' || c == '\b' || c == '\f') return 1;
+    return c < 0x20 ? 5 : 0;
+}
+
+// Write the escaped form of c ending just before dst; returns the new end
+static uint8_t* escapeBackward(uint8_t* dst, uint8_t c) {
+    char e = 0;
+    switch (c) {
+        case '"':  e = '"'; break;
+        case '\\': e = '\\'; break;
+        case '\n': e = 'n'; break;
+        case '\r': e = 'r'; break;
+        case '\t': e = 't'; break;
+        case '\b': e = 'b'; break;
+        case '\f': e = 'f'; break;
+    }
+    if (e) {
+        *--dst = e;
+        *--dst = '\\';
+    } else if (c < 0x20) {
+        *--dst = HEX_DIGITS[c & 0x0f];
+        *--dst = HEX_DIGITS[c >> 4];
+        *--dst = '0';
+        *--dst = '0';
+        *--dst = 'u';
+        *--dst = '\\';
+    } else {
+        *--dst = c;
+    }
+    return dst;
+}
+
+static void putJsonString(FrameWriter& w, const char* s) {
+    w.put('"');
+    for (; *s; s++) {
+        uint8_t c = (uint8_t)*s;
+        if (escapeCost(c) == 0) {
+            w.put(c);
+            continue;
+        }
+        uint8_t tmp[6];
+        uint8_t* start = escapeBackward(tmp + sizeof(tmp), c);
+        w.put(start, tmp + sizeof(tmp) - start);
+    }
+    w.put('"');
+}
+
+static void putMsgPackString(FrameWriter& w, const char* s) {
+    size_t n = strlen(s);
+    if (n < 32) {
+        w.put((uint8_t)(0xa0 | n));
+    } else if (n < 0x100) {
+        w.put(0xd9);
+        w.put((uint8_t)n);
+    } else {
+        w.put(0xda);
+        w.putBE((uint32_t)n, 2);
+    }
+    w.put(s, n);
+}
+
+static void putMsgPackInt(FrameWriter& w, int v) {
+    if (v >= 0 && v < 0x80) {
+        w.put((uint8_t)v);
+    } else if (v >= 0 && v < 0x100) {
+        w.put(0xcc);
+        w.put((uint8_t)v);
+    } else if (v >= 0 && v < 0x10000) {
+        w.put(0xcd);
+        w.putBE((uint32_t)v, 2);
+    } else {
+        w.put(0xd2);
+        w.putBE((uint32_t)v, 4);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// In-place JSON envelope parser
+// ---------------------------------------------------------------------------
+
+struct Cursor {
+    uint8_t* p;
+    uint8_t* end;
+
+    bool more() const { return p < end; }
+};
+
+static void skipSpace(Cursor& c) {
+    while (c.more() && (*c.p == ' ' || *c.p == '\t' || *c.p == '\n' || *c.p == '\r')) c.p++;
+}
+
+static int hexValue(uint8_t c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool readHex4(Cursor& c, uint32_t& v) {
+    if (c.end - c.p < 4) return false;
+    v = 0;
+    for (int i = 0; i < 4; i++) {
+        int h = hexValue(*c.p++);
+        if (h < 0) return false;
+        v = (v << 4) | (uint32_t)h;
+    }
+    return true;
+}
+
+static uint8_t* putUtf8(uint8_t* dst, uint32_t cp) {
+    if (cp < 0x80) {
+        *dst++ = (uint8_t)cp;
+    } else if (cp < 0x800) {
+        *dst++ = (uint8_t)(0xc0 | (cp >> 6));
+        *dst++ = (uint8_t)(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        *dst++ = (uint8_t)(0xe0 | (cp >> 12));
+        *dst++ = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        *dst++ = (uint8_t)(0x80 | (cp & 0x3f));
+    } else {
+        *dst++ = (uint8_t)(0xf0 | (cp >> 18));
+        *dst++ = (uint8_t)(0x80 | ((cp >> 12) & 0x3f));
+        *dst++ = (uint8_t)(0x80 | ((cp >> 6) & 0x3f));
+        *dst++ = (uint8_t)(0x80 | (cp & 0x3f));
+    }
+    return dst;
+}
+
+// Unescape the string at c.p (on its opening quote) over itself. Escapes
+// never expand, so the NUL always fits where the closing quote was.
+static bool jsonString(Cursor& c, const char*& out, size_t& len) {
+    if (!c.more() || *c.p != '"') return false;
+    uint8_t* start = ++c.p;
+    uint8_t* dst = start;
+    while (c.more()) {
+        uint8_t ch = *c.p++;
+        if (ch == '"') {
+            *dst = '\0';
+            out = (const char*)start;
+            len = dst - start;
+            return true;
+        }
+        if (ch != '\\') {
+            *dst++ = ch;
+            continue;
+        }
+        if (!c.more()) return false;
+        ch = *c.p++;
+        switch (ch) {
+            case '"': case '\\': case '/': *dst++ = ch; break;
+            case 'b': *dst++ = '\b'; break;
+            case 'f': *dst++ = '\f'; break;
+            case 'n': *dst++ = '\n'; break;
+            case 'r': *dst++ = '\r'; break;
+            case 't': *dst++ = '\t'; break;
+            case 'u': {
+                uint32_t cp;
+                if (!readHex4(c, cp)) return false;
+                if (cp >= 0xd800 && cp < 0xdc00 && c.end - c.p >= 6 && c.p[0] == '\\' && c.p[1] == 'u') {
+                    Cursor low = {c.p + 2, c.end};
+                    uint32_t lo;
+                    if (readHex4(low, lo) && lo >= 0xdc00 && lo < 0xe000) {
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (lo - 0xdc00);
+                        c.p = low.p;
+                    }
+                }
+                dst = putUtf8(dst, cp);
+                break;
+            }
+            default:
+                return false;
+        }
+    }
+    return false;
+}
+
+// Step over any value; strings are unescaped on the way, which is harmless
+static bool jsonSkip(Cursor& c) {
+    const char* s;
+    size_t n;
+    int depth = 0;
+    do {
+        skipSpace(c);
+        if (!c.more()) return false;
+        uint8_t ch = *c.p;
+        if (ch == '"') {
+            if (!jsonString(c, s, n)) return false;
+        } else if (ch == '{' || ch == '[') {
+            depth++;
+            c.p++;
+        } else if (ch == '}' || ch == ']') {
+            if (--depth < 0) return false;
+            c.p++;
+        } else if (ch == ',' || ch == ':') {
+            if (depth == 0) return false;
+            c.p++;
+        } else {
+            // Number, true, false or null
+            uint8_t* start = c.p;
+            while (c.more() && memchr(",:}] \t\r\n", *c.p, 8) == nullptr) c.p++;
+            if (c.p == start) return false;
+        }
+    } while (depth > 0);
+    return true;
+}
+
+// Walk an object, calling field(key, cursor) with the cursor on each value.
+// field() consumes the value or returns false to have it skipped.
+template <typename Field>
+static bool jsonObject(Cursor& c, Field field) {
+    skipSpace(c);
+    if (!c.more() || *c.p != '{') return false;
+    c.p++;
+    skipSpace(c);
+    if (c.more() && *c.p == '}') {
+        c.p++;
+        return true;
+    }
+    while (true) {
+        const char* key;
+        size_t keyLen;
+        skipSpace(c);
+        if (!jsonString(c, key, keyLen)) return false;
+        skipSpace(c);
+        if (!c.more() || *c.p++ != ':') return false;
+        skipSpace(c);
+        if (!field(key, c) && !jsonSkip(c)) return false;
+        skipSpace(c);
+        if (!c.more()) return false;
+        uint8_t ch = *c.p++;
+        if (ch == '}') return true;
+        if (ch != ',') return false;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// In-place MessagePack envelope parser
+// ---------------------------------------------------------------------------
+
+static bool readBE(Cursor& c, int bytes, uint32_t& v) {
+    if (c.end - c.p < bytes) return false;
+    v = 0;
+    while (bytes--) v = (v << 8) | *c.p++;
+    return true;
+}
+
+// Length of a str (or, with bin, a bin) value at c.p; consumes the header
+static bool msgpackStringHeader(Cursor& c, bool bin, size_t& len) {
+    if (!c.more()) return false;
+    uint8_t t = *c.p;
+    uint32_t n;
+    if ((t & 0xe0) == 0xa0) {
+        c.p++;
+        n = t & 0x1f;
+    } else if (t == 0xd9 || (bin && t == 0xc4)) {
+        c.p++;
+        if (!readBE(c, 1, n)) return false;
+    } else if (t == 0xda || (bin && t == 0xc5)) {
+        c.p++;
+        if (!readBE(c, 2, n)) return false;
+    } else if (t == 0xdb || (bin && t == 0xc6)) {
+        c.p++;
+        if (!readBE(c, 4, n)) return false;
+    } else {
+        return false;
+    }
+    if (n > (size_t)(c.end - c.p)) return false;
+    len = n;
+    return true;
+}
+
+// Slide the string back over its (already read) header by one byte to
+// make room for a NUL
+static bool msgpackString(Cursor& c, bool bin, const char*& out, size_t& len) {
+    if (!msgpackStringHeader(c, bin, len)) return false;
+    uint8_t* str = c.p - 1;
+    memmove(str, c.p, len);
+    str[len] = '\0';
+    out = (const char*)str;
+    c.p += len;
+    return true;
+}
+
+static bool msgpackSkip(Cursor& c) {
+    uint32_t pending = 1;
+    while (pending > 0) {
+        if (!c.more()) return false;
+        uint8_t t = *c.p++;
+        uint32_t n = 0;
+        size_t skip = 0;
+        pending--;
+        if (t < 0x80 || t >= 0xe0 || t == 0xc0 || t == 0xc2 || t == 0xc3) {
+            // Fixints, nil, booleans
+        } else if ((t & 0xf0) == 0x80) {
+            pending += 2 * (t & 0x0f);
+        } else if ((t & 0xf0) == 0x90) {
+            pending += t & 0x0f;
+        } else if ((t & 0xe0) == 0xa0) {
+            skip = t & 0x1f;
+        } else {
+            switch (t) {
+                case 0xcc: case 0xd0: skip = 1; break;
+                case 0xcd: case 0xd1: skip = 2; break;
+                case 0xca: case 0xce: case 0xd2: skip = 4; break;
+                case 0xcb: case 0xcf: case 0xd3: skip = 8; break;
+                case 0xd4: skip = 2; break;
+                case 0xd5: skip = 3; break;
+                case 0xd6: skip = 5; break;
+                case 0xd7: skip = 9; break;
+                case 0xd8: skip = 17; break;
+                case 0xc4: case 0xd9: if (!readBE(c, 1, n)) return false; skip = n; break;
+                case 0xc5: case 0xda: if (!readBE(c, 2, n)) return false; skip = n; break;
+                case 0xc6: case 0xdb: if (!readBE(c, 4, n)) return false; skip = n; break;
+                case 0xc7: if (!readBE(c, 1, n)) return false; skip = n + 1; break;
+                case 0xc8: if (!readBE(c, 2, n)) return false; skip = n + 1; break;
+                case 0xc9: if (!readBE(c, 4, n)) return false; skip = (size_t)n + 1; break;
+                case 0xdc: if (!readBE(c, 2, n)) return false; pending += n; break;
+                case 0xdd: if (!readBE(c, 4, n)) return false; pending += n; break;
+                case 0xde: if (!readBE(c, 2, n)) return false; pending += 2 * n; break;
+                case 0xdf: if (!readBE(c, 4, n)) return false; pending += 2 * n; break;
+                default: return false;   // 0xc1 is never used
+            }
+        }
+        if (skip > (size_t)(c.end - c.p)) return false;
+        c.p += skip;
+    }
+    return true;
+}
+
+template <typename Field>
+static bool msgpackMap(Cursor& c, Field field) {
+    if (!c.more()) return false;
+    uint8_t t = *c.p++;
+    uint32_t count;
+    if ((t & 0xf0) == 0x80) {
+        count = t & 0x0f;
+    } else if (t == 0xde) {
+        if (!readBE(c, 2, count)) return false;
+    } else if (t == 0xdf) {
+        if (!readBE(c, 4, count)) return false;
+    } else {
+        return false;
+    }
+    while (count--) {
+        const char* key;
+        size_t keyLen;
+        if (c.more() && ((*c.p & 0xe0) == 0xa0 || *c.p == 0xd9 || *c.p == 0xda || *c.p == 0xdb)) {
+            if (!msgpackString(c, false, key, keyLen)) return false;
+            if (!field(key, c) && !msgpackSkip(c)) return false;
+        } else if (!msgpackSkip(c) || !msgpackSkip(c)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// TunnelCodec
+// ---------------------------------------------------------------------------
+
+TunnelEncoding TunnelCodec::negotiate(const char* encoding) {
+    _encoding = (encoding && strcmp(encoding, "msgpack") == 0) ? TUNNEL_MSGPACK : TUNNEL_JSON;
+    return _encoding;
+}
+
+bool TunnelCodec::parse(uint8_t* frame, size_t len, bool binary, TunnelMessage& msg) {
+    msg.type = "";
+    msg.id = "";
+    msg.method = "GET";
+    msg.path = "/";
+    msg.handle = "";
+    msg.encoding = "";
+    msg.ifNoneMatch = nullptr;
+    msg.body = "";
+    msg.bodyLen = 0;
+    if (!frame || len == 0) return false;
+
+    Cursor c = {frame, frame + len};
+
+    if (binary) {
+        auto header = [&msg](const char* key, Cursor& c) {
+            size_t n;
+            return strcasecmp(key, "If-None-Match") == 0 && msgpackString(c, false, msg.ifNoneMatch, n);
+        };
+        return msgpackMap(c, [&msg, &header](const char* key, Cursor& c) {
+            size_t n;
+            if (strcmp(key, "body") == 0) return msgpackString(c, true, msg.body, msg.bodyLen);
+            if (strcmp(key, "headers") == 0) return msgpackMap(c, header);
+            const char** field = nullptr;
+            if (strcmp(key, "type") == 0) field = &msg.type;
+            else if (strcmp(key, "id") == 0) field = &msg.id;
+            else if (strcmp(key, "method") == 0) field = &msg.method;
+            else if (strcmp(key, "path") == 0) field = &msg.path;
+            else if (strcmp(key, "handle") == 0) field = &msg.handle;
+            else if (strcmp(key, "encoding") == 0) field = &msg.encoding;
+            return field && msgpackString(c, false, *field, n);
+        });
+    }
+
+    auto header = [&msg](const char* key, Cursor& c) {
+        size_t n;
+        return strcasecmp(key, "If-None-Match") == 0 && c.more() && *c.p == '"' &&
+               jsonString(c, msg.ifNoneMatch, n);
+    };
+    return jsonObject(c, [&msg, &header](const char* key, Cursor& c) {
+        size_t n;
+        if (strcmp(key, "headers") == 0) return c.more() && *c.p == '{' && jsonObject(c, header);
+        if (!c.more() || *c.p != '"') return false;
+        if (strcmp(key, "body") == 0) return jsonString(c, msg.body, msg.bodyLen);
+        const char** field = nullptr;
+        if (strcmp(key, "type") == 0) field = &msg.type;
+        else if (strcmp(key, "id") == 0) field = &msg.id;
+        else if (strcmp(key, "method") == 0) field = &msg.method;
+        else if (strcmp(key, "path") == 0) field = &msg.path;
+        else if (strcmp(key, "handle") == 0) field = &msg.handle;
+        else if (strcmp(key, "encoding") == 0) field = &msg.encoding;
+        return field && jsonString(c, *field, n);
+    });
+}
+
+DeserializationError TunnelCodec::decode(const uint8_t* frame, size_t len, bool binary, JsonDocument& doc) {
+    if (binary) return deserializeMsgPack(doc, frame, len);
+    return deserializeJson(doc, (const char*)frame, len);
+}
+
+const char* TunnelCodec::body(JsonVariantConst message, size_t& len) {
+    JsonVariantConst body = message["body"];
+    if (body.is<MsgPackBinary>()) {
+        MsgPackBinary bin = body.as<MsgPackBinary>();
+        len = bin.size();
+        return (const char*)bin.data();
+    }
+    JsonString str = body.as<JsonString>();
+    len = str.size();
+    return str.c_str() ? str.c_str() : "";
+}
+
+char* TunnelCodec::beginResponse(const TunnelResponse& head, uint8_t* out, size_t capacity, size_t& room) {
+    const char* id = head.id ? head.id : "";
+    const char* contentType = head.contentType ? head.contentType : "application/json";
+    FrameWriter w = {out, capacity, 0, false};
+    // Header values are strings, as in HTTP
+    char retryAfter[12] = "";
+    if (head.retryAfter > 0) snprintf(retryAfter, sizeof(retryAfter), "%d", head.retryAfter);
+
+    if (_encoding == TUNNEL_MSGPACK) {
+        w.put(0x85);
+        w.put("\xa4" "type" "\xa8" "response", 14);
+        w.put("\xa2" "id", 3);
+        putMsgPackString(w, id);
+        w.put("\xa6" "status", 7);
+        putMsgPackInt(w, head.status);
+        w.put("\xa7" "headers", 8);
+        w.put((uint8_t)(0x81 + (head.etag ? 1 : 0) + (retryAfter[0] ? 1 : 0)));
+        w.put("\xac" "Content-Type", 13);
+        putMsgPackString(w, contentType);
+        if (head.etag) {
+            w.put("\xa4" "ETag", 5);
+            putMsgPackString(w, head.etag);
+        }
+        if (retryAfter[0]) {
+            w.put("\xab" "Retry-After", 12);
+            putMsgPackString(w, retryAfter);
+        }
+        w.put("\xa4" "body", 5);
+        // bin 16 header for now; endResponse() settles the final form
+        w.put("\xc5\x00\x00", 3);
+        if (w.overflow) return nullptr;
+        room = capacity - w.len;
+        if (room > 0xffff) room = 0xffff;
+    } else {
+        w.put("{\"type\":\"response\",\"id\":");
+        putJsonString(w, id);
+        char status[12];
+        snprintf(status, sizeof(status), "%d", head.status);
+        w.put(",\"status\":");
+        w.put(status);
+        w.put(",\"headers\":{\"Content-Type\":");
+        putJsonString(w, contentType);
+        if (head.etag) {
+            w.put(",\"ETag\":");
+            putJsonString(w, head.etag);
+        }
+        if (retryAfter[0]) {
+            w.put(",\"Retry-After\":");
+            putJsonString(w, retryAfter);
+        }
+        w.put("},\"body\":\"");
+        // The closing quote, brace and NUL must still fit
+        if (w.overflow || capacity - w.len < 3) return nullptr;
+        room = capacity - w.len - 3;
+    }
+
+    _frame = out;
+    _capacity = capacity;
+    _bodyAt = w.len;
+    return (char*)out + w.len;
+}
+
+size_t TunnelCodec::endResponse(size_t bodyLen) {
+    uint8_t* body = _frame + _bodyAt;
+
+    if (_encoding == TUNNEL_MSGPACK) {
+        if (bodyLen > 0xffff || bodyLen > _capacity - _bodyAt) return 0;
+        if (bodyLen < 0x100) {
+            // bin 8 is a byte shorter
+            memmove(body - 1, body, bodyLen);
+            body[-3] = 0xc4;
+            body[-2] = (uint8_t)bodyLen;
+            return _bodyAt - 1 + bodyLen;
+        }
+        body[-2] = (uint8_t)(bodyLen >> 8);
+        body[-1] = (uint8_t)bodyLen;
+        return _bodyAt + bodyLen;
+    }
+
+    // Escape in place, from the end so nothing is overwritten before it is read
+    size_t extra = 0;
+    for (size_t i = 0; i < bodyLen; i++) extra += escapeCost(body[i]);
+    size_t len = _bodyAt + bodyLen + extra;
+    if (bodyLen > _capacity - _bodyAt || len + 3 > _capacity) return 0;
+    if (extra) {
+        uint8_t* dst = body + bodyLen + extra;
+        for (size_t i = bodyLen; i-- > 0;) dst = escapeBackward(dst, body[i]);
+    }
+    _frame[len++] = '"';
+    _frame[len++] = '}';
+    _frame[len] = '\0';
+    return len;
+}
+
+size_t TunnelCodec::encodeResponse(const TunnelResponse& response, uint8_t* out, size_t capacity) {
+    size_t room;
+    char* body = beginResponse(response, out, capacity, room);
+    if (!body || response.bodyLen > room) return 0;
+    if (response.bodyLen) memcpy(body, response.body, response.bodyLen);
+    return endResponse(response.bodyLen);
+}
+
+size_t TunnelCodec::encodeMessage(JsonVariantConst message, uint8_t* out, size_t capacity) const {
+    size_t len = (_encoding == TUNNEL_MSGPACK) ? serializeMsgPack(message, out, capacity)
+                                                : serializeJson(message, (char*)out, capacity);
+    return (len == 0 || len >= capacity) ? 0 : len;
+}
@@ -0,0 +1,104 @@
+/**
+ * Envelope encoding for the registry WebSocket tunnel.
+ *
+ * Two framings are supported:
+ * - JSON (text opcode): {"type":"response","id":..,"status":..,
+ *   "headers":{..},"body":"<escaped JSON>"}, what every registry speaks
+ * - MessagePack (binary opcode): the same envelope as a MessagePack map,
+ *   with "body" carried as a bin field holding the raw body bytes, so the
+ *   handler's JSON is neither escaped nor re-parsed by the relay
+ *
+ * The device asks for MessagePack by connecting with TUNNEL_ENCODING_QUERY
+ * appended to the tunnel URL. Registries that understand it answer the
+ * "connected" message with "encoding":"msgpack"; anything else (including
+ * older registries that ignore the query) keeps the tunnel on JSON.
+ * Incoming frames are decoded by opcode, whichever encoding is in use.
+ *
+ * Nothing here allocates:
+ * - parse() reads an incoming frame in place, unescaping and
+ *   NUL-terminating the envelope strings where they lie in the frame
+ * - responses are written straight into a caller-owned frame buffer, and
+ *   beginResponse()/endResponse() let the body be serialized in place
+ *   between the envelope head and tail
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef TUNNEL_FRAME_MAX
+#define TUNNEL_FRAME_MAX 4096
+#endif
+#define TUNNEL_ENCODING_QUERY "&encoding=msgpack"
+
+enum TunnelEncoding : uint8_t {
+    TUNNEL_JSON = 0,
+    TUNNEL_MSGPACK
+};
+
+// Views into a parsed frame; missing fields are "" (or the noted default)
+struct TunnelMessage {
+    const char* type;
+    const char* id;
+    const char* method;        // "GET"
+    const char* path;          // "/", query string included
+    const char* handle;        // "connected" messages
+    const char* encoding;      // "connected" messages
+    const char* ifNoneMatch;   // headers["If-None-Match"], nullptr if absent
+    const char* body;          // String or bin field
+    size_t bodyLen;
+};
+
+struct TunnelResponse {
+    const char* id;
+    int status;
+    const char* contentType;   // nullptr for application/json
+    const char* etag;          // Optional
+    const char* body;          // Raw bytes, need not be NUL-terminated
+    size_t bodyLen;
+    int retryAfter;            // Retry-After seconds, 0 for none
+};
+
+class TunnelCodec {
+public:
+    explicit TunnelCodec(TunnelEncoding encoding = TUNNEL_JSON)
+        : _encoding(encoding), _frame(nullptr), _capacity(0), _bodyAt(0) {}
+
+    // Back to JSON, e.g. when the tunnel drops
+    void reset() { _encoding = TUNNEL_JSON; }
+    // Apply the registry's "connected" message; returns the encoding in use
+    TunnelEncoding negotiate(const char* encoding);
+    TunnelEncoding negotiate(JsonVariantConst connected) { return negotiate(connected["encoding"].as<const char*>()); }
+    TunnelEncoding encoding() const { return _encoding; }
+    bool binary() const { return _encoding == TUNNEL_MSGPACK; }
+
+    // Parse a text (JSON) or binary (MessagePack) frame in place. The frame
+    // is modified and must outlive the views in msg.
+    static bool parse(uint8_t* frame, size_t len, bool binary, TunnelMessage& msg);
+
+    // Parse a frame into a document, for relays and tests
+    static DeserializationError decode(const uint8_t* frame, size_t len, bool binary, JsonDocument& doc);
+    // Body of a decoded document, from a bin or string field; "" if absent
+    static const char* body(JsonVariantConst message, size_t& len);
+
+    // Write the envelope of a response (its body fields are ignored) and
+    // return where the body goes, with room bytes available there; nullptr
+    // when even the envelope does not fit
+    char* beginResponse(const TunnelResponse& head, uint8_t* out, size_t capacity, size_t& room);
+    // Complete the frame after bodyLen bytes were written at the body
+    // pointer; returns the frame length, 0 when it does not fit
+    size_t endResponse(size_t bodyLen);
+
+    // Both steps, copying the body from response.body
+    size_t encodeResponse(const TunnelResponse& response, uint8_t* out, size_t capacity);
+    // Any other message (heartbeat, ...) in the negotiated encoding
+    size_t encodeMessage(JsonVariantConst message, uint8_t* out, size_t capacity) const;
+
+private:
+    TunnelEncoding _encoding;
+    uint8_t* _frame;      // Frame being built by beginResponse()
+    size_t _capacity;
+    size_t _bodyAt;
+};
@@ -0,0 +1,165 @@
+#include "TunnelRouter.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+static int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool TunnelRouter::queryParam(const char* path, const char* name, char* buf, size_t size) {
+    const char* p = strchr(path, '?');
+    if (!p || size == 0) return false;
+    size_t nameLen = strlen(name);
+    while (*p) {
+        p++;   // Past '?' or '&'
+        const char* end = p + strcspn(p, "&");
+        if ((size_t)(end - p) > nameLen && memcmp(p, name, nameLen) == 0 && p[nameLen] == '=') {
+            size_t n = 0;
+            for (p += nameLen + 1; p < end && n + 1 < size; p++) {
+                if (*p == '+') {
+                    buf[n++] = ' ';
+                } else if (*p == '%' && end - p >= 3 && hexValue(p[1]) >= 0 && hexValue(p[2]) >= 0) {
+                    buf[n++] = (char)(hexValue(p[1]) << 4 | hexValue(p[2]));
+                    p += 2;
+                } else {
+                    buf[n++] = *p;
+                }
+            }
+            buf[n] = '\0';
+            return true;
+        }
+        p = end;
+    }
+    return false;
+}
+
+bool TunnelRouter::slow(const TunnelMessage& msg) const {
+    const RouteDef* route = _routes.find(msg.path);
+    if (!route) return false;
+    switch (route->kind) {
+        case ROUTE_RAW: return route->slow;
+        case ROUTE_RPC: return _rpc.slow(msg.body, msg.bodyLen);
+        case ROUTE_SKILL: {
+            const SkillDef* skill = _rpc.find(route->target);
+            return skill && skill->slow;
+        }
+        default: return false;
+    }
+}
+
+size_t TunnelRouter::handle(const TunnelMessage& msg, TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    const RouteDef* route = _routes.find(msg.path);
+    if (!route) {
+        JsonDocument doc(_allocator);
+        doc["error"] = JsonString("Not found", true);
+        doc["path"] = JsonString(msg.path, true);
+        return sendJson(404, doc.as<JsonVariantConst>(), msg, codec, out, capacity);
+    }
+    // Relays that leave the method out get the route whatever it takes
+    uint8_t method = routeMethod(msg.method);
+    if (method && !(route->methods & method)) {
+        return sendError(405, "Method not allowed", msg, codec, out, capacity);
+    }
+
+    switch (route->kind) {
+        case ROUTE_CARD: {
+            if (!_card.valid()) return sendError(503, "Agent card not ready", msg, codec, out, capacity);
+            // Copied from the cached card straight into the frame
+            TunnelResponse resp = {msg.id, 200, nullptr, _card.etag(), _card.json(), _card.length(), 0};
+            if (_card.notModified(msg.ifNoneMatch)) {
+                resp.status = 304;
+                resp.bodyLen = 0;
+            }
+            size_t n = codec.encodeResponse(resp, out, capacity);
+            return n ? n : sendError(500, "Response too large", msg, codec, out, capacity);
+        }
+        case ROUTE_RPC: {
+            JsonDocument reply(_allocator);
+            if (!_rpc.dispatch(msg.body, msg.bodyLen, reply)) {
+                TunnelResponse resp = {msg.id, 204, nullptr, nullptr, "", 0, 0};   // Notifications only
+                return codec.encodeResponse(resp, out, capacity);
+            }
+            return sendJson(200, reply.as<JsonVariantConst>(), msg, codec, out, capacity);
+        }
+        case ROUTE_SKILL: {
+            if (!route->queryCount) return sendSkill(route->target, JsonVariantConst(), msg, codec, out, capacity);
+            JsonDocument params(_allocator);
+            routeParams(*route, params.to<JsonObject>(), [&msg](const char* name, char* buf, size_t size) {
+                return queryParam(msg.path, name, buf, size);
+            });
+            return sendSkill(route->target, params.as<JsonVariantConst>(), msg, codec, out, capacity);
+        }
+        case ROUTE_RAW:
+            return sendRaw(*route, msg, codec, out, capacity);
+        case ROUTE_PAGE:
+            return sendPage(*route, msg, codec, out, capacity);
+    }
+    return sendError(500, "Bad route", msg, codec, out, capacity);
+}
+
+size_t TunnelRouter::sendRaw(const RouteDef& route, const TunnelMessage& msg,
+                             TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    if (!codec.binary()) return sendError(406, "Binary body needs the MessagePack tunnel", msg, codec, out, capacity);
+
+    // Written straight into the frame, like JSON bodies
+    TunnelResponse head = {msg.id, 200, route.target, nullptr, nullptr, 0, 0};
+    size_t room;
+    uint8_t* at = (uint8_t*)codec.beginResponse(head, out, capacity, room);
+    if (!at) return 0;
+    size_t bodyLen = 0;
+    int status = route.write(at, room, bodyLen);
+    if (status == 200) {
+        size_t n = codec.endResponse(bodyLen);
+        if (n) return n;
+        status = 413;
+    }
+    return sendError(status, status == 413 ? "Too large for a tunnel frame" : "Not available",
+                     msg, codec, out, capacity);
+}
+
+size_t TunnelRouter::sendPage(const RouteDef& route, const TunnelMessage& msg,
+                              TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    // Text, so JSON frames can carry it escaped
+    TunnelResponse resp = {msg.id, 200, route.target, nullptr, route.body, route.bodyLen, 0};
+    size_t n = codec.encodeResponse(resp, out, capacity);
+    return n ? n : sendError(413, "Too large for a tunnel frame", msg, codec, out, capacity);
+}
+
+size_t TunnelRouter::sendSkill(const char* id, JsonVariantConst params, const TunnelMessage& msg,
+                               TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    const SkillDef* skill = _rpc.find(id);
+    if (!skill) return sendError(404, "Unknown skill", msg, codec, out, capacity);
+
+    JsonDocument doc(_allocator);
+    if (!skill->handler(params, doc.to<JsonObject>())) {
+        return sendError(400, "Invalid params", msg, codec, out, capacity);
+    }
+    return sendJson(200, doc.as<JsonVariantConst>(), msg, codec, out, capacity);
+}
+
+size_t TunnelRouter::sendJson(int status, JsonVariantConst body, const TunnelMessage& msg,
+                              TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    TunnelResponse head = {msg.id, status, nullptr, nullptr, nullptr, 0, 0};
+    size_t room;
+    char* at = codec.beginResponse(head, out, capacity, room);
+    if (at) {
+        // serializeJson() also writes a NUL, so n == room means it was cut short
+        size_t n = serializeJson(body, at, room);
+        if (n < room) {
+            size_t len = codec.endResponse(n);
+            if (len) return len;
+        }
+    }
+    return status == 500 ? 0 : sendError(500, "Response too large", msg, codec, out, capacity);
+}
+
+size_t TunnelRouter::sendError(int status, const char* message, const TunnelMessage& msg,
+                               TunnelCodec& codec, uint8_t* out, size_t capacity) const {
+    JsonDocument doc(_allocator);
+    doc["error"] = JsonString(message, true);
+    return sendJson(status, doc.as<JsonVariantConst>(), msg, codec, out, capacity);
+}
@@ -0,0 +1,59 @@
+/**
+ * Answers requests relayed through the registry tunnel.
+ *
+ * Requests are matched against the same RouteTable as the HTTP server
+ * (see RouteTable.h), so both transports serve the same paths with the
+ * same methods. The path is matched without its query string and query
+ * values are read where they lie. Response bodies are serialized straight
+ * into the frame through TunnelCodec::beginResponse(), and every
+ * JsonDocument a request needs comes from the router's allocator, so with
+ * a ScratchAllocator a relayed request does not touch the heap.
+ *
+ * Raw routes carry binary bodies, which JSON frames cannot hold; they need
+ * the MessagePack tunnel. Pages are text and go either way, but one that
+ * does not fit a frame is answered 413.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stddef.h>
+
+#include <AgentCard.h>
+#include <JsonRpcDispatcher.h>
+#include <RouteTable.h>
+#include <SkillTable.h>
+
+#include "TunnelCodec.h"
+
+class TunnelRouter {
+public:
+    TunnelRouter(const RouteTable& routes, const SkillDef* skills, size_t count, const AgentCard& card,
+                 ArduinoJson::Allocator* allocator = ArduinoJson::detail::DefaultAllocator::instance())
+        : _routes(routes), _rpc(skills, count, allocator), _card(card), _allocator(allocator) {}
+
+    // Write the response frame for msg; returns its length, 0 if none fits
+    size_t handle(const TunnelMessage& msg, TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+    // Whether handling msg runs a skill marked slow, see TunnelScheduler
+    bool slow(const TunnelMessage& msg) const;
+
+    // Value of a query parameter in path, URL-decoded into buf; false if absent
+    static bool queryParam(const char* path, const char* name, char* buf, size_t size);
+
+private:
+    size_t sendRaw(const RouteDef& route, const TunnelMessage& msg,
+                   TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+    size_t sendPage(const RouteDef& route, const TunnelMessage& msg,
+                    TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+    size_t sendSkill(const char* id, JsonVariantConst params, const TunnelMessage& msg,
+                     TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+    size_t sendJson(int status, JsonVariantConst body, const TunnelMessage& msg,
+                    TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+    size_t sendError(int status, const char* message, const TunnelMessage& msg,
+                     TunnelCodec& codec, uint8_t* out, size_t capacity) const;
+
+    const RouteTable& _routes;
+    JsonRpcDispatcher _rpc;
+    const AgentCard& _card;
+    ArduinoJson::Allocator* _allocator;   // Parameters and skill output
+};
@@ -0,0 +1,99 @@
+#include "TunnelScheduler.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Appends NUL-terminated copies to a job's storage
+struct JobWriter {
+    char* buf;
+    size_t size;
+    size_t len;
+    bool overflow;
+
+    const char* copy(const char* s, size_t n) {
+        if (overflow || n + 1 > size - len) {
+            overflow = true;
+            return "";
+        }
+        char* at = buf + len;
+        memcpy(at, s, n);
+        at[n] = '\0';
+        len += n + 1;
+        return at;
+    }
+    const char* copy(const char* s) { return copy(s, strlen(s)); }
+};
+
+bool TunnelScheduler::queued(const char* id) const {
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    for (uint32_t i = _head.load(std::memory_order_acquire); i != tail; i++) {
+        if (strcmp(_jobs[i % TUNNEL_QUEUE_DEPTH].msg.id, id) == 0) return true;
+    }
+    return false;
+}
+
+TunnelAdmission TunnelScheduler::enqueue(const TunnelMessage& msg, TunnelEncoding encoding) {
+    // A retry of a request still in the queue is answered once, when it runs
+    if (msg.id[0] && queued(msg.id)) return TUNNEL_QUEUED;
+
+    uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail - _head.load(std::memory_order_acquire) >= TUNNEL_QUEUE_DEPTH) {
+        _rejected++;
+        return TUNNEL_BUSY;
+    }
+
+    Job& job = _jobs[tail % TUNNEL_QUEUE_DEPTH];
+    JobWriter w = {job.data, sizeof(job.data), 0, false};
+    job.msg.type = "request";
+    job.msg.id = w.copy(msg.id);
+    job.msg.method = w.copy(msg.method);
+    job.msg.path = w.copy(msg.path);
+    job.msg.handle = "";
+    job.msg.encoding = "";
+    job.msg.ifNoneMatch = msg.ifNoneMatch ? w.copy(msg.ifNoneMatch) : nullptr;
+    job.msg.body = w.copy(msg.body, msg.bodyLen);
+    job.msg.bodyLen = msg.bodyLen;
+    job.encoding = encoding;
+    if (w.overflow) {
+        _rejected++;
+        return TUNNEL_TOO_LARGE;
+    }
+
+    _tail.store(tail + 1, std::memory_order_release);
+    return TUNNEL_QUEUED;
+}
+
+size_t TunnelScheduler::reject(TunnelAdmission reason, const TunnelMessage& msg, TunnelCodec& codec,
+                               uint8_t* out, size_t capacity) {
+    char body[48];
+    TunnelResponse resp = {msg.id, 413, nullptr, nullptr, body, 0, 0};
+    if (reason == TUNNEL_BUSY) {
+        resp.status = 503;
+        resp.retryAfter = TUNNEL_RETRY_AFTER;
+        resp.bodyLen = snprintf(body, sizeof(body), "{\"error\":\"Busy\",\"retryAfter\":%d}", TUNNEL_RETRY_AFTER);
+    } else {
+        resp.bodyLen = snprintf(body, sizeof(body), "{\"error\":\"Request too large\"}");
+    }
+    return codec.encodeResponse(resp, out, capacity);
+}
+
+bool TunnelScheduler::runNext() {
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    if (head == _tail.load(std::memory_order_acquire) || ready()) return false;
+
+    // The slot stays taken (and counted by pending()) until the job is done
+    const Job& job = _jobs[head % TUNNEL_QUEUE_DEPTH];
+    TunnelCodec codec(job.encoding);
+    size_t len = _router.handle(job.msg, codec, _frame, _capacity);
+    _readyBinary = job.encoding == TUNNEL_MSGPACK;
+    _readyFailed = len == 0;
+    if (_readyFailed) {
+        // Not even the router's error body fitted: a bare 500 under the job's id
+        TunnelResponse resp = {job.msg.id, 500, nullptr, nullptr, "", 0, 0};
+        len = codec.encodeResponse(resp, _frame, _capacity);
+    }
+
+    _head.store(head + 1, std::memory_order_release);
+    _readyLen.store(len, std::memory_order_release);
+    return true;
+}
@@ -0,0 +1,96 @@
+/**
+ * Runs slow tunnel requests off the WebSocket callback.
+ *
+ * Requests for skills marked slow (such as a WiFi scan) are
+ * copied into a bounded queue and answered by a worker task, while fast
+ * read-only skills keep being answered straight from the callback.
+ * Responses carry their request id, so they go out in whatever order they
+ * finish; a request whose id is already queued is not queued twice.
+ *
+ * Threading: enqueue(), ready() and release() belong to the task that owns
+ * the WebSocket, runNext() to a single worker task. Jobs are handed over
+ * through a ring of slots with atomic indexes, results through one frame
+ * buffer that the owner releases once it has been sent.
+ *
+ * Backpressure: a request that finds the queue full is answered at once
+ * with 503 and a Retry-After header, one too large for a slot with 413.
+ * A job whose response does not fit the frame buffer is answered 500,
+ * with an empty body if need be, so every queued request gets an answer
+ * (a frame of TUNNEL_FRAME_MAX always holds that).
+ */
+
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "TunnelCodec.h"
+#include "TunnelRouter.h"
+
+#ifndef TUNNEL_QUEUE_DEPTH
+#define TUNNEL_QUEUE_DEPTH 4      // Slow requests queued or running
+#endif
+#ifndef TUNNEL_JOB_BYTES
+#define TUNNEL_JOB_BYTES 1024     // Id, path, headers and body of one queued request
+#endif
+#ifndef TUNNEL_RETRY_AFTER
+#define TUNNEL_RETRY_AFTER 2      // Seconds, suggested when the queue is full
+#endif
+
+enum TunnelAdmission : uint8_t {
+    TUNNEL_QUEUED = 0,   // Answered later by runNext()
+    TUNNEL_BUSY,         // Queue full: answer 503 now
+    TUNNEL_TOO_LARGE     // Does not fit a slot: answer 413 now
+};
+
+class TunnelScheduler {
+public:
+    // Jobs run on router; their responses are written to frame
+    TunnelScheduler(const TunnelRouter& router, uint8_t* frame, size_t capacity)
+        : _router(router), _frame(frame), _capacity(capacity),
+          _head(0), _tail(0), _readyLen(0), _readyBinary(false), _readyFailed(false), _rejected(0) {}
+
+    // Copy msg into the queue, to be answered in the given encoding
+    TunnelAdmission enqueue(const TunnelMessage& msg, TunnelEncoding encoding);
+    // The 503 or 413 response for a request enqueue() turned away
+    static size_t reject(TunnelAdmission reason, const TunnelMessage& msg, TunnelCodec& codec,
+                         uint8_t* out, size_t capacity);
+
+    // Length of a finished response in the frame buffer, 0 if none. It must
+    // be sent (binary() tells the opcode) and then release()d before the
+    // worker can finish another job.
+    size_t ready() const { return _readyLen.load(std::memory_order_acquire); }
+    bool binary() const { return _readyBinary; }
+    // The ready response is a bare 500: not even the router's error fitted
+    bool failed() const { return _readyFailed; }
+    void release() { _readyLen.store(0, std::memory_order_release); }
+
+    // Jobs queued or running
+    size_t pending() const { return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire); }
+    uint32_t rejected() const { return _rejected; }
+
+    // Worker side: run the oldest job. False when there is none, or the
+    // previous response has not been released yet.
+    bool runNext();
+
+private:
+    struct Job {
+        TunnelMessage msg;          // Views into data
+        TunnelEncoding encoding;
+        char data[TUNNEL_JOB_BYTES];
+    };
+
+    bool queued(const char* id) const;
+
+    const TunnelRouter& _router;
+    uint8_t* _frame;
+    size_t _capacity;
+    Job _jobs[TUNNEL_QUEUE_DEPTH];
+    std::atomic<uint32_t> _head;        // Next job to run, advanced once it has finished
+    std::atomic<uint32_t> _tail;        // Next slot to fill
+    std::atomic<size_t> _readyLen;
+    bool _readyBinary;                  // Published by _readyLen
+    bool _readyFailed;                  // Likewise
+    uint32_t _rejected;
+};
@@ -0,0 +1,306 @@
+// Generated by scripts/web-assets.py from web/; do not edit.
+
+#pragma once
+
+#include <stdint.h>
+
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+
+// web/chat.html: 6961 bytes, 4729 minified, 2022 gzipped
+const char WEB_CHAT_HTML[] PROGMEM =
+    "<!DOCTYPE html><html><head><title>SuprPosition Chat</title><meta name=\"viewport\" content=\"width=d"
+    "evice-width, initial-scale=1, maximum-scale=1\"><style>*{box-sizing:border-box;margin:0;padding:0}bo"
+    "dy{font-family:-apple-system,system-ui,sans-serif;background:linear-gradient(135deg,#1a1a2e 0%,#1621"
+    "3e 100%);min-height:100vh;color:#fff}.header{background:rgba(0,212,255,0.1);padding:15px;text-align:"
+    "center;border-bottom:1px solid rgba(0,212,255,0.3)}.header h1{font-size:1.5em;background:linear-grad"
+    "ient(90deg,#00d4ff,#ff00ff);-webkit-background-clip:text;-webkit-text-fill-color:transparent}.header"
+    " .status{font-size:0.8em;color:#0f0;margin-top:5px}.chat-container{height:calc(100vh - 140px);overfl"
+    "ow-y:auto;padding:15px}.message{margin:10px 0;padding:12px 16px;border-radius:18px;max-width:85%;ani"
+    "mation:fadeIn 0.3s ease}@keyframes fadeIn{from{opacity:0;transform:translateY(10px)}to{opacity:1;tra"
+    "nsform:translateY(0)}}.message.user{background:linear-gradient(135deg,#00d4ff,#0099cc);margin-left:a"
+    "uto;border-bottom-right-radius:4px}.message.device{background:rgba(255,255,255,0.1);border-bottom-le"
+    "ft-radius:4px}.message.device::before{content:'\360\237\244\226 '}.input-container{position:fixed;bo"
+    "ttom:0;left:0;right:0;padding:10px;background:rgba(22,33,62,0.95);border-top:1px solid rgba(0,212,25"
+    "5,0.3);display:flex;gap:10px}#messageInput{flex:1;padding:12px 16px;border:none;border-radius:25px;b"
+    "ackground:rgba(255,255,255,0.1);color:#fff;font-size:16px;outline:none}#messageInput::placeholder{co"
+    "lor:rgba(255,255,255,0.5)}#sendBtn{width:50px;height:50px;border:none;border-radius:50%;background:l"
+    "inear-gradient(135deg,#00d4ff,#ff00ff);color:#fff;font-size:20px;cursor:pointer}.quick-actions{displ"
+    "ay:flex;gap:8px;padding:10px 15px;overflow-x:auto}.quick-btn{padding:8px 16px;border:1px solid rgba("
+    "0,212,255,0.5);border-radius:20px;background:transparent;color:#00d4ff;font-size:14px;white-space:no"
+    "wrap;cursor:pointer}.quick-btn:active{background:rgba(0,212,255,0.2)}</style></head><body><div class"
+    "=\"header\"><h1>SuprPosition</h1><div class=\"status\">\342\227\217 Connected to M5Stick</div></div>"
+    "<div class=\"quick-actions\"><button class=\"quick-btn\" onclick=\"send('read sensors')\">\360\237\223"
+    "\212 Sensors</button><button class=\"quick-btn\" onclick=\"send('battery status')\">\360\237\224\213"
+    " Battery</button><button class=\"quick-btn\" onclick=\"send('beep')\">\360\237\224\224 Beep</button>"
+    "<button class=\"quick-btn\" onclick=\"send('wifi scan')\">\360\237\223\266 WiFi</button></div><div c"
+    "lass=\"chat-container\" id=\"chat\"></div><div class=\"input-container\"><input type=\"text\" id=\"m"
+    "essageInput\" placeholder=\"Ask me anything...\" autocomplete=\"off\"><button id=\"sendBtn\" onclick"
+    "=\"sendMessage()\">\342\206\222</button></div><script>const chat = document.getElementById('chat');\n"
+    "const input = document.getElementById('messageInput');\n"
+    "function addMessage(text, isUser) {\n"
+    "const div = document.createElement('div');\n"
+    "div.className = 'message ' + (isUser ? 'user' : 'device');\n"
+    "div.textContent = text;\n"
+    "chat.appendChild(div);\n"
+    "chat.scrollTop = chat.scrollHeight;\n"
+    "}\n"
+    "async function send(text) {\n"
+    "if (!text.trim()) return;\n"
+    "addMessage(text, true);\n"
+    "input.value = '';\n"
+    "try {\n"
+    "const res = await fetch('/api/display?text=' + encodeURIComponent(text));\n"
+    "const data = await res.json();\n"
+    "let response = '';\n"
+    "const lower = text.toLowerCase();\n"
+    "if (lower.includes('sensor') || lower.includes('temp')) {\n"
+    "const s = await fetch('/api/sensors').then(r => r.json());\n"
+    "response = `Temperature: ${s.temperature.toFixed(1)}\302\260C\\nAccel: X=${s.accelerometer.x.toFixed"
+    "(2)}, Y=${s.accelerometer.y.toFixed(2)}, Z=${s.accelerometer.z.toFixed(2)}`;\n"
+    "} else if (lower.includes('battery') || lower.includes('power')) {\n"
+    "const b = await fetch('/api/battery').then(r => r.json());\n"
+    "response = `Battery: ${b.percent}% (${b.voltage.toFixed(2)}V)\\nCharging: ${b.isCharging ? 'Yes' : '"
+    "No'}`;\n"
+    "} else if (lower.includes('beep') || lower.includes('tone')) {\n"
+    "await fetch('/api/buzzer?freq=1000&duration=200');\n"
+    "response = '\360\237\224\224 Beep!';\n"
+    "} else if (lower.includes('wifi') || lower.includes('scan')) {\n"
+    "const w = await fetch('/api/wifi/scan').then(r => r.json());\n"
+    "response = `Found ${w.count} networks:\\n` + w.networks.slice(0,5).map(n => `\342\200\242 ${n.ssid} "
+    "(${n.rssi}dBm)`).join('\\n');\n"
+    "} else if (lower.includes('button')) {\n"
+    "const b = await fetch('/api/buttons').then(r => r.json());\n"
+    "response = `Buttons: A=${b.btnA?'pressed':'released'}, B=${b.btnB?'pressed':'released'}`;\n"
+    "} else {\n"
+    "response = `Displayed: \"${data.displayed}\"`;\n"
+    "}\n"
+    "addMessage(response, false);\n"
+    "} catch (e) {\n"
+    "addMessage('Error: ' + e.message, false);\n"
+    "}\n"
+    "}\n"
+    "function sendMessage() {\n"
+    "send(input.value);\n"
+    "}\n"
+    "input.addEventListener('keypress', e => {\n"
+    "if (e.key === 'Enter') sendMessage();\n"
+    "});\n"
+    "addMessage('Hello! I\\'m your M5Stick assistant. Ask me to read sensors, check battery, beep, or dis"
+    "play something!', false);</script></body></html>";
+const uint8_t WEB_CHAT_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x9d, 0x58, 0xdd, 0x72, 0xdb, 0xb8,
+    0x15, 0xbe, 0xf7, 0x53, 0xc0, 0xca, 0xba, 0x24, 0x5b, 0x91, 0x22, 0xe5, 0x28, 0x93, 0x90, 0x92,
+    0xd2, 0xd8, 0xeb, 0xcc, 0x7a, 0x66, 0x77, 0xbb, 0xd3, 0x64, 0xdb, 0xa6, 0xe3, 0x0b, 0x43, 0x24,
+    0x28, 0x61, 0x4d, 0x02, 0x5c, 0x00, 0xb4, 0xa4, 0x68, 0x39, 0xd3, 0xab, 0x5e, 0xb4, 0x17, 0x9d,
+    0x69, 0x77, 0xda, 0xcb, 0x9d, 0xe9, 0xf4, 0x01, 0x7a, 0xd5, 0x07, 0xe8, 0xa3, 0xe4, 0x09, 0xf6,
+    0x11, 0x7a, 0x40, 0x90, 0x12, 0x65, 0x2b, 0x4e, 0xb6, 0x93, 0x89, 0x4d, 0x00, 0x07, 0x07, 0xe7,
+    0x7c, 0xf8, 0xce, 0x0f, 0x3c, 0x3e, 0xfe, 0xf4, 0x57, 0xe7, 0xaf, 0xdf, 0x7c, 0x75, 0x81, 0x16,
+    0x2a, 0xcf, 0xa6, 0xe3, 0xe6, 0x27, 0xc1, 0xc9, 0x74, 0xac, 0xa8, 0xca, 0xc8, 0xf4, 0x55, 0x59,
+    0x88, 0xaf, 0xb8, 0xa4, 0x8a, 0x72, 0x86, 0xce, 0x17, 0x58, 0x8d, 0x07, 0x66, 0x61, 0x9c, 0x13,
+    0x85, 0x11, 0xc3, 0x39, 0x99, 0xf4, 0x6e, 0x29, 0x59, 0x16, 0x5c, 0xa8, 0x1e, 0x8a, 0x39, 0x53,
+    0x84, 0xa9, 0x49, 0x6f, 0x49, 0x13, 0xb5, 0x98, 0x24, 0xe4, 0x96, 0xc6, 0xc4, 0xad, 0x07, 0x7d,
+    0x44, 0x19, 0xa8, 0xc1, 0x99, 0x2b, 0x63, 0x9c, 0x91, 0x49, 0xd0, 0x47, 0x39, 0x5e, 0xd1, 0xbc,
+    0xcc, 0xdb, 0x89, 0xde, 0x74, 0x2c, 0xd5, 0x1a, 0x74, 0xff, 0x7c, 0x33, 0xe3, 0x2b, 0x57, 0xd2,
+    0xb7, 0x94, 0xcd, 0xc3, 0x19, 0x17, 0x09, 0x11, 0x2e, 0xcc, 0x44, 0x39, 0x16, 0x73, 0xca, 0x42,
+    0x3f, 0x2a, 0x70, 0x92, 0xe8, 0x35, 0xbf, 0x9a, 0xf1, 0x64, 0xbd, 0x49, 0xe1, 0x54, 0x37, 0xc5,
+    0x39, 0xcd, 0xd6, 0xa1, 0x8b, 0x8b, 0x22, 0x23, 0xae, 0x5c, 0x4b, 0x45, 0xf2, 0xbe, 0xf9, 0xe5,
+    0x96, 0xb4, 0x2f, 0x31, 0x93, 0xae, 0x24, 0x82, 0xa6, 0xd1, 0x0c, 0xc7, 0x37, 0x73, 0xc1, 0x4b,
+    0x96, 0x84, 0x19, 0x65, 0x04, 0x0b, 0x77, 0x2e, 0x70, 0x42, 0xc1, 0x6e, 0x3b, 0x38, 0x1d, 0x25,
+    0x64, 0xde, 0x7f, 0x14, 0xe0, 0x00, 0x0f, 0x09, 0xf2, 0x4f, 0xe0, 0xf3, 0xc9, 0x30, 0x38, 0x25,
+    0x28, 0xf0, 0xfd, 0x13, 0x27, 0xca, 0x29, 0x73, 0x17, 0x84, 0xce, 0x17, 0x2a, 0x84, 0x89, 0xdb,
+    0x45, 0x14, 0xf3, 0x8c, 0x8b, 0xf0, 0x51, 0x9a, 0xa6, 0x95, 0xa7, 0x71, 0x23, 0x62, 0xd3, 0x51,
+    0x2f, 0xe6, 0x33, 0x6c, 0xfb, 0xfd, 0x61, 0x30, 0xec, 0x0f, 0x47, 0xa3, 0xbe, 0xef, 0x05, 0xce,
+    0xd6, 0xf6, 0x60, 0x54, 0xac, 0x22, 0x45, 0x56, 0xca, 0xc5, 0x19, 0x9d, 0xb3, 0x30, 0x86, 0xf3,
+    0x89, 0x88, 0xb6, 0xee, 0x2a, 0xc5, 0xf3, 0x30, 0x28, 0x56, 0x48, 0xf2, 0x8c, 0x26, 0xe8, 0x9e,
+    0xaa, 0x53, 0xa7, 0x3d, 0x11, 0x2d, 0x02, 0x03, 0x01, 0x20, 0x46, 0xc2, 0xc0, 0x1b, 0x91, 0xfc,
+    0x21, 0x1f, 0x9f, 0xf9, 0xb5, 0x8b, 0xbe, 0x9f, 0x3c, 0x4e, 0xd3, 0x3e, 0x98, 0xee, 0xfb, 0x69,
+    0xea, 0x44, 0xee, 0x92, 0xcc, 0x6e, 0xa8, 0x72, 0x77, 0x3b, 0xdd, 0x38, 0xa3, 0x45, 0xa8, 0x4d,
+    0xdc, 0x2e, 0xd6, 0xf6, 0xa6, 0x34, 0xcb, 0x5c, 0xe3, 0xb8, 0x12, 0x00, 0x6b, 0x81, 0x05, 0xe8,
+    0xdd, 0x5a, 0xe3, 0x49, 0x85, 0x55, 0x29, 0x3b, 0x26, 0xf9, 0xde, 0x53, 0x30, 0xa9, 0x81, 0xca,
+    0x4f, 0xfd, 0xe6, 0x22, 0x5d, 0xc5, 0x8b, 0x10, 0x50, 0xa8, 0xbc, 0x18, 0x88, 0xe5, 0x6a, 0xee,
+    0x60, 0xb0, 0x55, 0x6c, 0x1a, 0x84, 0x81, 0x15, 0xb1, 0x5d, 0xc3, 0x8c, 0x5c, 0x14, 0x3c, 0xf6,
+    0x8b, 0x95, 0x13, 0xf1, 0x5b, 0x22, 0xd2, 0x8c, 0x2f, 0xdd, 0x75, 0x88, 0x4b, 0xc5, 0xf7, 0xd0,
+    0xac, 0xbc, 0x9c, 0x48, 0x89, 0xe7, 0x64, 0xd3, 0x10, 0x25, 0x80, 0x2d, 0x68, 0xc7, 0x96, 0x60,
+    0x08, 0xc3, 0xe0, 0x09, 0xc0, 0xde, 0x80, 0xac, 0x11, 0x29, 0x65, 0x18, 0x3c, 0x2d, 0x34, 0xb7,
+    0x56, 0x86, 0xa7, 0xe1, 0xd3, 0xd1, 0x49, 0x84, 0x19, 0xcd, 0xb1, 0xe6, 0x7c, 0x98, 0x82, 0x4f,
+    0x97, 0x0c, 0x01, 0xde, 0x12, 0x11, 0x2c, 0x49, 0xf5, 0xcb, 0x1b, 0xb2, 0x4e, 0x05, 0xf0, 0x5e,
+    0x22, 0xb3, 0xb6, 0x49, 0x05, 0xcf, 0x37, 0xbc, 0xc0, 0x31, 0x55, 0x6b, 0x20, 0x67, 0x8d, 0x49,
+    0xca, 0x45, 0x6e, 0xd0, 0xc9, 0xb0, 0x22, 0x6f, 0x6c, 0x6d, 0x8a, 0x53, 0x29, 0xbe, 0x95, 0x0b,
+    0x0e, 0xcb, 0xf9, 0x4e, 0xb5, 0x75, 0xc3, 0x2b, 0xe5, 0x3e, 0x9d, 0xde, 0xc7, 0xd6, 0xf6, 0x2a,
+    0x7d, 0xff, 0xd9, 0xb3, 0x38, 0x76, 0x5a, 0x78, 0x33, 0x92, 0x2a, 0x83, 0xd2, 0x1e, 0xa9, 0x5c,
+    0xa1, 0xd1, 0x6d, 0x9d, 0x7f, 0xdc, 0xc1, 0xcd, 0x33, 0xf1, 0x7a, 0x8f, 0xc1, 0x9a, 0x70, 0xed,
+    0xff, 0x9a, 0xc3, 0xfb, 0xfa, 0xf4, 0x39, 0x0f, 0xa8, 0x0b, 0xc3, 0x19, 0x01, 0x37, 0xc9, 0xa6,
+    0x49, 0x0e, 0xa1, 0xf5, 0xe3, 0x0f, 0xff, 0xfa, 0x3b, 0xb2, 0x2a, 0x8f, 0xb2, 0xa2, 0xec, 0xde,
+    0x7b, 0xd1, 0x24, 0x9a, 0x30, 0xa5, 0x2b, 0x92, 0x44, 0x4d, 0x0c, 0xf8, 0x51, 0xed, 0x88, 0x1f,
+    0xd5, 0x76, 0x77, 0xa2, 0x5f, 0x63, 0x1a, 0xdd, 0xb3, 0x75, 0xd8, 0x3f, 0x3d, 0xed, 0x3f, 0x19,
+    0x82, 0xa1, 0xcf, 0x46, 0x5b, 0x4b, 0x35, 0xd3, 0x1e, 0x8c, 0xa5, 0x28, 0xa1, 0xb2, 0xc8, 0xf0,
+    0x3a, 0x4c, 0x33, 0xb2, 0x8a, 0xe6, 0xb8, 0xa8, 0xb5, 0x57, 0x8f, 0x1a, 0x57, 0x2e, 0xb5, 0xa5,
+    0x1b, 0xbd, 0x06, 0x17, 0xf7, 0x3e, 0x3e, 0x85, 0x8c, 0x33, 0x72, 0x87, 0x5b, 0xc3, 0xd1, 0x21,
+    0x1b, 0xef, 0xe2, 0xb9, 0xcb, 0x22, 0x51, 0x27, 0x90, 0xb5, 0x66, 0x5e, 0x2a, 0x7d, 0xeb, 0xb5,
+    0xea, 0x7d, 0x6b, 0xc2, 0x10, 0xec, 0x8d, 0xc9, 0x82, 0x67, 0x3a, 0xe9, 0x18, 0x0d, 0x07, 0xb4,
+    0x8f, 0x9c, 0xea, 0x91, 0x24, 0x2c, 0x39, 0x53, 0x6c, 0x63, 0xf8, 0x3d, 0xd2, 0xb0, 0x35, 0x21,
+    0x56, 0x7f, 0xbf, 0xdf, 0xfa, 0x91, 0x7f, 0x12, 0xfd, 0x04, 0xfe, 0xb5, 0xa9, 0xe4, 0xa0, 0x3b,
+    0x43, 0x7d, 0x54, 0x5c, 0x0a, 0x09, 0x4b, 0x05, 0xa7, 0x3a, 0xd9, 0x55, 0xde, 0xb7, 0x25, 0x8d,
+    0x6f, 0x5c, 0x1c, 0xeb, 0x5b, 0x97, 0x9b, 0x7b, 0x77, 0xa0, 0x03, 0xb3, 0x7b, 0xdb, 0xa8, 0x4e,
+    0x9a, 0xdb, 0x1c, 0xb0, 0xaa, 0xd9, 0xdd, 0x6a, 0x99, 0x81, 0x87, 0xad, 0xf0, 0xd3, 0x3b, 0x37,
+    0xf3, 0xc0, 0xdd, 0xef, 0x48, 0xd2, 0x5e, 0xd9, 0x1d, 0x5a, 0x75, 0x72, 0xdc, 0x36, 0x87, 0xd5,
+    0x0e, 0x77, 0xef, 0x0a, 0x78, 0x1f, 0x2d, 0x17, 0x54, 0x41, 0xe5, 0x81, 0x00, 0xd7, 0xf7, 0xb5,
+    0x14, 0xb8, 0x78, 0x8f, 0xbf, 0x60, 0x69, 0xa8, 0x7d, 0xbe, 0x25, 0x0f, 0x16, 0x8b, 0xa1, 0x53,
+    0x8d, 0x07, 0xa6, 0x22, 0x8e, 0x07, 0xa6, 0x28, 0xeb, 0x72, 0x37, 0x1d, 0x27, 0xf4, 0x16, 0xc5,
+    0x19, 0x96, 0x72, 0xd2, 0x33, 0x39, 0x17, 0x2a, 0xe7, 0x22, 0xd8, 0xab, 0xd5, 0xb0, 0x21, 0xd8,
+    0x13, 0x34, 0x49, 0xb9, 0x37, 0x7d, 0xf7, 0x8f, 0xbf, 0xa0, 0x73, 0xce, 0x18, 0x89, 0x15, 0x49,
+    0x90, 0xe2, 0xe8, 0x8b, 0xd1, 0x2b, 0x05, 0x46, 0x8d, 0x07, 0x20, 0x3c, 0x6d, 0x7e, 0x76, 0xf6,
+    0xed, 0xdd, 0x10, 0x9c, 0x33, 0x2b, 0x21, 0x28, 0xd9, 0xfe, 0x2a, 0xf8, 0xd3, 0x43, 0x9c, 0x41,
+    0xb9, 0x88, 0x6f, 0xe0, 0x24, 0x60, 0x9b, 0x6d, 0x09, 0x30, 0x0c, 0xc1, 0x27, 0xb8, 0x2f, 0x2d,
+    0xa7, 0x37, 0xfd, 0xf1, 0x87, 0xbf, 0xfd, 0x09, 0xbd, 0x32, 0xe3, 0xf1, 0xc0, 0x68, 0xf9, 0x78,
+    0x6d, 0x33, 0xac, 0x00, 0xbf, 0x35, 0x32, 0x5e, 0x18, 0x7d, 0xdf, 0xff, 0x19, 0x9d, 0x99, 0xe9,
+    0xff, 0x43, 0x1f, 0x21, 0x45, 0xa3, 0xe5, 0x7b, 0x74, 0x06, 0x83, 0x9f, 0xae, 0x62, 0x49, 0x53,
+    0x8a, 0xa0, 0x73, 0x61, 0x8d, 0x77, 0xff, 0x41, 0xbf, 0xa5, 0x2f, 0xe9, 0x4e, 0xcf, 0x3d, 0x24,
+    0xf7, 0x8b, 0x5c, 0x0f, 0xd1, 0xc4, 0xcc, 0xf5, 0x0e, 0xc8, 0xde, 0xc9, 0x8c, 0x20, 0x52, 0xcf,
+    0x20, 0xb5, 0x2e, 0xa0, 0xdf, 0xd2, 0x55, 0xd8, 0xec, 0xef, 0x26, 0x84, 0x1e, 0xea, 0x24, 0x84,
+    0x49, 0xef, 0x85, 0xbc, 0x41, 0x39, 0x41, 0x98, 0xad, 0xd5, 0x02, 0x42, 0xc2, 0xf3, 0xbc, 0x1e,
+    0xd2, 0xe1, 0x12, 0xf3, 0x1c, 0x1a, 0x24, 0x05, 0x6a, 0x78, 0x9a, 0xee, 0x2e, 0x54, 0x6b, 0x6b,
+    0xf2, 0xc4, 0x1d, 0x57, 0xbf, 0x30, 0x67, 0xd8, 0xe0, 0xe6, 0xbb, 0x3f, 0xfe, 0xf5, 0xae, 0x83,
+    0x32, 0x16, 0xb4, 0x50, 0x53, 0x30, 0x55, 0x2a, 0xa4, 0xdd, 0x41, 0x13, 0x94, 0xf0, 0xb8, 0xcc,
+    0x21, 0x5c, 0xbc, 0x39, 0x51, 0x17, 0x19, 0xd1, 0x9f, 0x67, 0xeb, 0x4b, 0xc0, 0x4c, 0xaf, 0x5b,
+    0x4e, 0x74, 0x64, 0xa4, 0x8d, 0x4b, 0x0f, 0x88, 0x77, 0xbd, 0xd3, 0xdb, 0xd2, 0x92, 0xd5, 0x3c,
+    0x44, 0x10, 0xe5, 0xad, 0x55, 0x1a, 0x0b, 0x68, 0x2d, 0xe5, 0xd7, 0x50, 0x2b, 0x1d, 0xb4, 0x69,
+    0x54, 0x6b, 0x28, 0x3b, 0x8a, 0x63, 0x60, 0xa3, 0x22, 0x8d, 0x6e, 0xdb, 0x82, 0x55, 0xad, 0x0e,
+    0x7e, 0x79, 0x35, 0xde, 0x5f, 0x42, 0x35, 0x07, 0xf1, 0xf6, 0x3c, 0x64, 0xa1, 0x5f, 0x20, 0xdb,
+    0xa8, 0x44, 0xcf, 0x91, 0xa5, 0xcb, 0xb0, 0x85, 0x42, 0x64, 0x99, 0x7a, 0xd6, 0x6e, 0xd5, 0x27,
+    0x9f, 0x9b, 0x92, 0x06, 0x9b, 0xeb, 0x36, 0xe9, 0x48, 0x3b, 0xe8, 0x41, 0x07, 0x0a, 0xb0, 0x9d,
+    0x2f, 0x68, 0x96, 0xd8, 0x20, 0xe8, 0x34, 0xd3, 0x80, 0x14, 0xcf, 0xb2, 0xd7, 0xbc, 0x00, 0xe9,
+    0xce, 0xc4, 0x67, 0x75, 0x26, 0x8e, 0x8e, 0xaa, 0x23, 0x2c, 0xd7, 0x2c, 0x46, 0x5b, 0x27, 0x6b,
+    0x9a, 0x69, 0xb5, 0xda, 0x2d, 0x9a, 0x22, 0xfb, 0x58, 0x0f, 0x3c, 0x25, 0x68, 0x6e, 0x3b, 0x0e,
+    0x12, 0x44, 0x95, 0x82, 0x45, 0x47, 0xf7, 0xb0, 0x50, 0xa2, 0x24, 0x70, 0x66, 0x8d, 0xae, 0x77,
+    0x8b, 0xb3, 0xb2, 0xf6, 0xcd, 0x8a, 0x8e, 0x14, 0x04, 0x50, 0x0b, 0x90, 0x80, 0xf6, 0x65, 0x82,
+    0xf0, 0x12, 0x53, 0x85, 0x52, 0xa2, 0xe2, 0x85, 0x6d, 0x0d, 0x70, 0x41, 0x07, 0x4d, 0x0a, 0x7e,
+    0xae, 0x55, 0x4d, 0x34, 0x0e, 0x84, 0xc5, 0x3c, 0x21, 0x5f, 0xff, 0xfa, 0xf2, 0x1c, 0x78, 0x03,
+    0x15, 0x02, 0xf0, 0xab, 0x6d, 0xda, 0xde, 0x62, 0x82, 0xe1, 0x1d, 0xd0, 0xaa, 0x02, 0xb5, 0xde,
+    0x37, 0x92, 0x33, 0x1b, 0x96, 0x81, 0x64, 0x7a, 0x0c, 0x9b, 0x64, 0x6b, 0x81, 0xd9, 0x01, 0xa9,
+    0x1b, 0x80, 0x35, 0x90, 0x79, 0x8a, 0x7f, 0xae, 0x87, 0xe7, 0xd0, 0x5a, 0xe9, 0x4d, 0xda, 0xcf,
+    0x7a, 0x1d, 0x9a, 0x83, 0x38, 0x2b, 0x13, 0x22, 0x6d, 0xcb, 0x64, 0x11, 0xcb, 0x41, 0xdf, 0x7d,
+    0x87, 0xee, 0xae, 0x41, 0x77, 0x0f, 0x81, 0xbc, 0xbb, 0xf8, 0xc3, 0x5e, 0x6d, 0xf3, 0x90, 0xa7,
+    0x16, 0x84, 0xd9, 0x70, 0xf8, 0x14, 0x89, 0xc6, 0x50, 0x38, 0xb4, 0x63, 0xe5, 0xf5, 0x6b, 0x50,
+    0x48, 0x04, 0x64, 0x19, 0x41, 0x42, 0xf4, 0xc9, 0x46, 0x7a, 0x6a, 0x37, 0x01, 0xc6, 0xbe, 0xd4,
+    0x9d, 0x89, 0x1d, 0x38, 0xd5, 0x7f, 0xff, 0x7d, 0x7e, 0xc5, 0x5e, 0xc4, 0x31, 0xc9, 0x42, 0xf4,
+    0xbb, 0x89, 0x16, 0xc4, 0x7a, 0x40, 0xa0, 0x17, 0x84, 0xe0, 0x12, 0xde, 0x6a, 0x2b, 0x0c, 0x69,
+    0xbc, 0x8f, 0xde, 0x1c, 0x10, 0x59, 0xef, 0x8b, 0xfc, 0xfe, 0x80, 0xc8, 0xdb, 0xae, 0xc8, 0x35,
+    0x90, 0x04, 0x91, 0x0c, 0xec, 0x3c, 0x84, 0x52, 0x93, 0x22, 0x0f, 0xc3, 0x54, 0xe8, 0x71, 0x17,
+    0xa7, 0xd9, 0x41, 0x9c, 0xb6, 0x3a, 0x3e, 0x8c, 0x53, 0x93, 0x7a, 0x35, 0x46, 0x33, 0x0f, 0x00,
+    0xd2, 0xcf, 0x97, 0xea, 0x04, 0xd9, 0x7a, 0x78, 0xcb, 0x33, 0xa5, 0xfb, 0xbf, 0x8e, 0xed, 0xbf,
+    0x71, 0xae, 0x18, 0x3c, 0x1f, 0x75, 0x5f, 0x3a, 0x37, 0x7b, 0xa8, 0x6c, 0xc7, 0x3a, 0xc6, 0xde,
+    0x10, 0x59, 0x87, 0xd8, 0x97, 0xdc, 0xfa, 0x90, 0x9f, 0x75, 0xea, 0x3e, 0xc8, 0x05, 0xa0, 0xa7,
+    0xf1, 0xf1, 0x80, 0x67, 0xe5, 0xdb, 0xb7, 0x44, 0x3c, 0x4f, 0x05, 0xf9, 0x76, 0x02, 0x4f, 0x0a,
+    0xff, 0x67, 0x49, 0x29, 0xea, 0x06, 0x7f, 0x32, 0xf4, 0x7d, 0x6b, 0xdf, 0x37, 0x6b, 0x5b, 0x15,
+    0x8e, 0xad, 0x07, 0x4d, 0xd1, 0x25, 0xe0, 0xb0, 0x29, 0xa6, 0x2e, 0xec, 0xe0, 0x5e, 0x1e, 0x84,
+    0x5b, 0xef, 0x1f, 0x18, 0xd1, 0x0f, 0x03, 0xfe, 0x52, 0x37, 0x09, 0x80, 0xdc, 0xd2, 0x8b, 0xe1,
+    0x4b, 0x55, 0x88, 0x11, 0xb5, 0xe4, 0xe2, 0x46, 0x86, 0x57, 0xec, 0x1a, 0x02, 0x75, 0xe9, 0xb5,
+    0x13, 0x9e, 0x84, 0xe4, 0x4d, 0xa0, 0x95, 0x18, 0x39, 0x5e, 0x8e, 0x0b, 0x9b, 0x69, 0xad, 0xd7,
+    0xef, 0xfe, 0xf0, 0x4f, 0xd8, 0xcd, 0x3c, 0x29, 0x69, 0x52, 0xe9, 0x7b, 0x62, 0x9e, 0x80, 0xef,
+    0x2a, 0x39, 0xcb, 0x9d, 0x6b, 0xc7, 0xfb, 0x06, 0x5a, 0x14, 0xdb, 0xba, 0x62, 0x1a, 0x8b, 0x87,
+    0xd0, 0xaf, 0x93, 0xff, 0x47, 0x30, 0xa9, 0x96, 0xfb, 0xa8, 0x88, 0x3b, 0x33, 0xa2, 0x21, 0x7a,
+    0x31, 0xd1, 0xbc, 0x80, 0x5a, 0xfb, 0xe2, 0xb9, 0x55, 0x80, 0x84, 0x24, 0x89, 0x15, 0x42, 0x23,
+    0x91, 0xe9, 0x77, 0x57, 0x62, 0x41, 0x88, 0x9c, 0xb5, 0x12, 0x67, 0x87, 0x25, 0x76, 0xcc, 0xd9,
+    0xec, 0x1d, 0xf1, 0xa9, 0xc9, 0x6a, 0x24, 0x09, 0x51, 0xef, 0x93, 0x8d, 0xce, 0x58, 0x5e, 0xd2,
+    0x4e, 0x55, 0xbd, 0xeb, 0x3a, 0xf9, 0xee, 0xd2, 0x68, 0xbb, 0xb3, 0x0f, 0x0f, 0x3c, 0xd0, 0x55,
+    0x03, 0x12, 0x63, 0xf0, 0x0d, 0xd9, 0xa4, 0x66, 0xd7, 0x4e, 0xd4, 0xba, 0x10, 0x02, 0xfa, 0xbb,
+    0xba, 0x62, 0x90, 0xf6, 0xdd, 0xd3, 0xd9, 0x07, 0xff, 0xf6, 0xf2, 0xf9, 0xb6, 0x96, 0x82, 0x9a,
+    0x3a, 0xbf, 0x77, 0xb2, 0x74, 0x2d, 0x6f, 0xc6, 0x70, 0xc2, 0xc5, 0x2d, 0x04, 0xd4, 0xe7, 0x54,
+    0x42, 0x79, 0x21, 0xc2, 0xb6, 0xe0, 0xd1, 0x59, 0x3b, 0x6c, 0xf5, 0x11, 0xd1, 0x58, 0x9a, 0x8a,
+    0x40, 0x3c, 0x98, 0x47, 0x93, 0x09, 0x70, 0xf6, 0x42, 0x37, 0x98, 0x40, 0xc6, 0xbd, 0x53, 0x40,
+    0xa3, 0xb3, 0x57, 0x21, 0xac, 0xcf, 0x48, 0x96, 0xf1, 0x63, 0x74, 0x79, 0x65, 0xe5, 0x68, 0xcd,
+    0x4b, 0xd1, 0xb6, 0x7f, 0x08, 0xca, 0x20, 0x1c, 0x86, 0xa1, 0x58, 0xa2, 0xa6, 0x73, 0x80, 0xde,
+    0xb0, 0xdb, 0xc4, 0xf5, 0xa1, 0x68, 0x11, 0x10, 0x6c, 0x72, 0x44, 0x1f, 0xe9, 0x40, 0xec, 0x23,
+    0x2e, 0x50, 0x03, 0x25, 0x34, 0xd8, 0x90, 0xb4, 0x74, 0xaf, 0x71, 0x6c, 0x6d, 0x21, 0x80, 0x06,
+    0xd6, 0x34, 0x08, 0xd0, 0x37, 0xd4, 0xbd, 0xeb, 0xa0, 0xfe, 0x1b, 0xd3, 0xff, 0x00, 0x11, 0x46,
+    0xcb, 0x67, 0x79, 0x12, 0x00, 0x00,
+};
+#define WEB_CHAT_HTML_ETAG "W/\"afa86511\""
+
+// web/index.html: 2029 bytes, 1612 minified, 837 gzipped
+const char WEB_INDEX_HTML[] PROGMEM =
+    "<!DOCTYPE html><html><head><title>NANDA Device</title><meta name=\"viewport\" content=\"width=device"
+    "-width, initial-scale=1\"><style>body{font-family:system-ui;max-width:600px;margin:0 auto;padding:20"
+    "px;background:#1a1a2e;color:#eee}h1{color:#00d4ff}.card{background:#16213e;border-radius:8px;padding"
+    ":15px;margin:10px 0}.label{color:#888;font-size:12px}.value{font-size:24px;font-weight:bold}button{b"
+    "ackground:#00d4ff;border:none;padding:10px 20px;border-radius:5px;cursor:pointer;margin:5px}#sensors"
+    "{display:grid;grid-template-columns:repeat(3,1fr);gap:10px}</style></head><body><h1>NANDA M5Stick</h"
+    "1><div class=\"card\"><div class=\"label\">Status</div><div class=\"value\" style=\"color:#0f0\">Onl"
+    "ine</div></div><div class=\"card\" id=\"sensors\">Loading...</div><div class=\"card\"><button onclic"
+    "k=\"fetch('/api/buzzer?freq=1000&duration=100')\">Beep</button><button onclick=\"fetch('/api/display"
+    "?text=Hello!')\">Hello</button><button onclick=\"location.reload()\">Refresh</button></div><script>f"
+    "unction cell(label, value) {\n"
+    "return '<div><div class=label>' + label + '</div><div>' + value + '</div></div>';\n"
+    "}\n"
+    "async function update() {\n"
+    "const s = await fetch('/api/sensors').then(r => r.json());\n"
+    "const b = await fetch('/api/battery').then(r => r.json());\n"
+    "document.getElementById('sensors').innerHTML =\n"
+    "cell('Accel X', s.accelerometer.x.toFixed(2)) +\n"
+    "cell('Accel Y', s.accelerometer.y.toFixed(2)) +\n"
+    "cell('Accel Z', s.accelerometer.z.toFixed(2)) +\n"
+    "cell('Temp', s.temperature.toFixed(1) + 'C') +\n"
+    "cell('Battery', b.percent + '%') +\n"
+    "cell('Voltage', b.voltage.toFixed(2) + 'V');\n"
+    "}\n"
+    "update();\n"
+    "setInterval(update, 2000);</script></body></html>";
+const uint8_t WEB_INDEX_HTML_GZ[] PROGMEM = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x7d, 0x55, 0xdb, 0x6e, 0xdb, 0x38,
+    0x10, 0x7d, 0xf7, 0x57, 0xb0, 0x0a, 0x76, 0x25, 0xa1, 0xb6, 0x2c, 0xb9, 0x17, 0x04, 0xba, 0x15,
+    0x49, 0xd3, 0x45, 0x0b, 0xf4, 0xb2, 0x68, 0x83, 0x62, 0xbb, 0x6f, 0x14, 0x39, 0xb2, 0xb9, 0xa5,
+    0x49, 0x2d, 0x49, 0x39, 0x76, 0x0c, 0xff, 0xfb, 0x92, 0x94, 0x52, 0xc7, 0xdd, 0xa4, 0x2f, 0x12,
+    0x39, 0x73, 0xe6, 0x76, 0x66, 0x34, 0x2a, 0x9f, 0x5c, 0x7d, 0x7a, 0x7d, 0xfd, 0xed, 0xcf, 0x37,
+    0x68, 0x65, 0xd6, 0xbc, 0x2e, 0xc7, 0x27, 0x60, 0x5a, 0x97, 0x86, 0x19, 0x0e, 0xf5, 0xc7, 0x8b,
+    0x8f, 0x57, 0x17, 0xe8, 0x0a, 0x36, 0x8c, 0x40, 0x39, 0x1f, 0x64, 0xe5, 0x1a, 0x0c, 0x46, 0x02,
+    0xaf, 0xa1, 0x0a, 0x36, 0x0c, 0x6e, 0x3a, 0xa9, 0x4c, 0x80, 0x88, 0x14, 0x06, 0x84, 0xa9, 0x82,
+    0x1b, 0x46, 0xcd, 0xaa, 0xa2, 0xde, 0x64, 0xe6, 0x2f, 0x53, 0xc4, 0x04, 0x33, 0x0c, 0xf3, 0x99,
+    0x26, 0x98, 0x43, 0x95, 0x05, 0x75, 0xa9, 0xcd, 0xce, 0xba, 0x6a, 0x24, 0xdd, 0xed, 0x5b, 0x6b,
+    0x39, 0x6b, 0xf1, 0x9a, 0xf1, 0x5d, 0xae, 0x77, 0xda, 0xc0, 0x7a, 0xd6, 0xb3, 0x62, 0x8d, 0xb7,
+    0x83, 0x75, 0xfe, 0x32, 0x4d, 0xbb, 0xad, 0xbd, 0xab, 0x25, 0x13, 0x79, 0x8a, 0x70, 0x6f, 0x64,
+    0xd1, 0x61, 0x4a, 0x99, 0x58, 0xe6, 0x0b, 0xa7, 0x6a, 0x30, 0xf9, 0xbe, 0x54, 0xb2, 0x17, 0x34,
+    0x3f, 0xcb, 0x70, 0x86, 0x17, 0x50, 0x10, 0xc9, 0xa5, 0xca, 0xcf, 0x00, 0xe0, 0xb0, 0xca, 0xf6,
+    0xe3, 0x2d, 0x4d, 0xe9, 0xf3, 0xb6, 0x3d, 0x24, 0x04, 0x2b, 0xba, 0x3f, 0x31, 0x7a, 0xb9, 0xc8,
+    0x9e, 0x41, 0xd1, 0x48, 0x45, 0x41, 0xcd, 0x14, 0xa6, 0xac, 0xd7, 0xf9, 0xb9, 0xf5, 0x7c, 0x17,
+    0x26, 0x7b, 0x71, 0xcc, 0x20, 0xb3, 0x21, 0x51, 0x7a, 0x48, 0x38, 0x6e, 0x80, 0xdf, 0xb9, 0x3e,
+    0x3f, 0x3f, 0x2f, 0x7c, 0x1d, 0x9a, 0xdd, 0x42, 0x9e, 0x2d, 0xba, 0xed, 0x21, 0xd9, 0x60, 0xde,
+    0xc3, 0xfe, 0x28, 0x5d, 0x3c, 0xb7, 0x4e, 0xfc, 0xf5, 0x06, 0xd8, 0x72, 0x65, 0xf2, 0x46, 0x72,
+    0x7a, 0x68, 0x7a, 0x63, 0xa4, 0x38, 0x49, 0x67, 0xc8, 0x73, 0x4c, 0x27, 0x17, 0x52, 0xc0, 0x31,
+    0x11, 0x17, 0x7c, 0x28, 0xfa, 0x24, 0x59, 0x97, 0x1f, 0xe9, 0x95, 0xb6, 0xb9, 0x74, 0x92, 0xd9,
+    0x4e, 0xa8, 0xbb, 0x74, 0xad, 0xe6, 0x70, 0xa6, 0x41, 0x58, 0x95, 0xde, 0x53, 0xa6, 0x3b, 0x8e,
+    0x77, 0xf9, 0x52, 0x31, 0x5a, 0xb8, 0xc7, 0xcc, 0xb2, 0x6d, 0x25, 0x06, 0x66, 0xb6, 0x90, 0x7e,
+    0x2d, 0x74, 0xae, 0xa0, 0x03, 0x6c, 0xa2, 0x67, 0xd3, 0xac, 0x55, 0x71, 0xb1, 0xc4, 0x9d, 0x8f,
+    0x79, 0x28, 0xe7, 0x43, 0xc7, 0xca, 0xf9, 0x30, 0x1e, 0xae, 0x73, 0x76, 0x54, 0xb2, 0x71, 0x42,
+    0x3e, 0xbc, 0xf8, 0x62, 0x18, 0xf9, 0x6e, 0xb5, 0x59, 0x5d, 0x52, 0xb6, 0x41, 0x84, 0x63, 0xad,
+    0xab, 0xc0, 0x51, 0x1d, 0x9c, 0x48, 0x3c, 0x6d, 0x41, 0xfd, 0xc5, 0x60, 0xd3, 0xeb, 0x72, 0x6e,
+    0x35, 0x27, 0x6a, 0x4f, 0x5a, 0x80, 0x7c, 0x30, 0x6b, 0x3e, 0x36, 0xae, 0x4d, 0x83, 0xfa, 0x93,
+    0xe0, 0x4c, 0xc0, 0x68, 0xf1, 0x3f, 0x3b, 0x1f, 0x08, 0x31, 0x5a, 0x05, 0x63, 0xad, 0x41, 0xfd,
+    0x5e, 0x62, 0xc7, 0x59, 0x92, 0x24, 0x8f, 0xc0, 0x6d, 0x15, 0x9e, 0x7c, 0x24, 0x05, 0xe1, 0x36,
+    0xfb, 0x2a, 0x68, 0xc1, 0x90, 0x55, 0x14, 0xce, 0x71, 0xc7, 0xe6, 0x4d, 0x7f, 0x7b, 0x0b, 0xea,
+    0x55, 0xab, 0xe0, 0xdf, 0x2a, 0x4b, 0xd3, 0xf4, 0x77, 0xda, 0x2b, 0x6c, 0x98, 0x14, 0xee, 0x16,
+    0xc6, 0x41, 0x7d, 0x09, 0xd0, 0x95, 0xf3, 0xc1, 0xc5, 0xaf, 0x5d, 0x8d, 0xb4, 0xbf, 0x32, 0xb0,
+    0x35, 0xd5, 0x5b, 0xe0, 0x5c, 0x3e, 0x71, 0x0e, 0xfc, 0xe9, 0x71, 0x0f, 0x5c, 0x12, 0x1f, 0x2f,
+    0x51, 0xc0, 0x6d, 0x29, 0x91, 0xb5, 0xf8, 0x0c, 0x36, 0x1d, 0xbd, 0x3a, 0xda, 0x0c, 0x85, 0x69,
+    0xa2, 0x58, 0x67, 0xea, 0xb6, 0x17, 0xc4, 0x19, 0x20, 0x62, 0x1d, 0x47, 0x9e, 0xe8, 0x29, 0xf2,
+    0x84, 0xc6, 0x68, 0x3f, 0x51, 0x60, 0x7a, 0x25, 0x50, 0x58, 0xfe, 0xc4, 0x85, 0xc7, 0xd5, 0x21,
+    0x7a, 0x8a, 0xfc, 0xc9, 0xbe, 0xc3, 0x23, 0x5f, 0x5e, 0xee, 0x5d, 0xdc, 0x93, 0xfb, 0x67, 0x58,
+    0x4c, 0x0e, 0x13, 0xac, 0x77, 0x82, 0xa0, 0x1f, 0x71, 0xfb, 0x8e, 0xda, 0x51, 0x8a, 0x5c, 0x34,
+    0xbb, 0x0e, 0xb4, 0x41, 0x1a, 0x55, 0x08, 0xdf, 0x60, 0x66, 0xd0, 0x7d, 0x3a, 0xc6, 0x0e, 0x85,
+    0x71, 0x62, 0x56, 0x20, 0x22, 0x85, 0xaa, 0x1a, 0xa9, 0xe4, 0x1f, 0x2d, 0x45, 0x14, 0xc7, 0xc5,
+    0x68, 0xda, 0x3c, 0x68, 0xda, 0x60, 0x63, 0x67, 0x7b, 0xf7, 0x98, 0x29, 0x95, 0xa4, 0x5f, 0xdb,
+    0x2d, 0x94, 0x2c, 0xc1, 0xbc, 0xe1, 0xe0, 0x8e, 0x97, 0xbb, 0x77, 0x34, 0x0a, 0x8f, 0x21, 0x99,
+    0x10, 0xa0, 0xde, 0x5e, 0x7f, 0x78, 0x8f, 0xaa, 0x89, 0xe7, 0x29, 0xbc, 0x20, 0xf6, 0x8d, 0xfe,
+    0x0a, 0xa7, 0x48, 0x27, 0xd8, 0x9d, 0x41, 0x49, 0xbb, 0xe2, 0x40, 0x25, 0xdb, 0xc4, 0xc8, 0x3f,
+    0xd8, 0x16, 0x68, 0xb4, 0x88, 0x63, 0xf4, 0xf4, 0x04, 0xff, 0xed, 0x01, 0xfc, 0xee, 0x17, 0xf8,
+    0xbf, 0x1f, 0xc0, 0xdf, 0x3e, 0x88, 0xbf, 0xb6, 0x9f, 0xa4, 0x07, 0xbb, 0x6f, 0x13, 0xec, 0xcc,
+    0xf5, 0x0a, 0x7e, 0x00, 0xb3, 0xd8, 0x35, 0xe2, 0x75, 0x78, 0x84, 0x5f, 0x8e, 0x94, 0x4c, 0x51,
+    0x93, 0x58, 0x38, 0xb1, 0x35, 0x3b, 0xc8, 0x6f, 0xf7, 0x20, 0x5f, 0x25, 0x37, 0x78, 0x09, 0x1e,
+    0xb2, 0x19, 0xce, 0xf7, 0x22, 0x3b, 0xf4, 0xd7, 0x30, 0x76, 0xfd, 0xbc, 0x6b, 0x60, 0x31, 0xd1,
+    0x60, 0xde, 0xb9, 0x35, 0x62, 0x7b, 0x1f, 0x0d, 0xd2, 0xa9, 0xdd, 0x3b, 0x69, 0x1a, 0x17, 0x76,
+    0x13, 0x0c, 0xe3, 0x66, 0xa7, 0xd0, 0x2f, 0x81, 0xb9, 0xff, 0x6d, 0xfc, 0x07, 0x46, 0xc6, 0x0b,
+    0x34, 0x4c, 0x06, 0x00, 0x00,
+};
+#define WEB_INDEX_HTML_ETAG "W/\"5f5cc425\""
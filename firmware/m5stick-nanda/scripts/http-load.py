@@ -0,0 +1,226 @@
+#!/usr/bin/env python3
+"""
+Dashboard load on the device's HTTP server, to compare connection reuse.
+
+Each client does what an open dashboard tab does, GET /api/sensors then
+GET /api/battery every --interval seconds, and one more client checks
+/.well-known/agent.json as the registry's health check does. Every mode
+runs for --duration seconds:
+
+  close       a new connection per request (Connection: close)
+  keep-alive  one connection per client, reopened only when the server
+              closes it
+  pipeline    as keep-alive, with both dashboard requests in one write
+
+It reports requests served, TCP connections opened and the latency of
+each request (connection setup included when it needed one).
+
+  pio run -e native_device && .pio/build/native_device/program &
+  python3 scripts/http-load.py --clients 4 --interval 0.05 --duration 10
+  python3 scripts/http-load.py --host 192.168.1.100 --port 80 --interval 2
+"""
+
+import argparse
+import socket
+import threading
+import time
+
+DASHBOARD = ["/api/sensors", "/api/battery"]
+HEALTH = "/.well-known/agent.json"
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.latencies = []
+        self.connects = 0
+        self.errors = 0
+        self.statuses = {}
+
+    def add(self, status, latency):
+        with self.lock:
+            self.latencies.append(latency)
+            self.statuses[status] = self.statuses.get(status, 0) + 1
+
+    def connected(self):
+        with self.lock:
+            self.connects += 1
+
+    def failed(self):
+        with self.lock:
+            self.errors += 1
+
+
+class Connection:
+    def __init__(self, host, port, stats):
+        self.host = host
+        self.port = port
+        self.stats = stats
+        self.sock = None
+        self.buf = b""
+
+    def open(self):
+        self.close()
+        self.sock = socket.create_connection((self.host, self.port), timeout=10)
+        self.sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self.stats.connected()
+
+    def close(self):
+        if self.sock:
+            self.sock.close()
+        self.sock = None
+        self.buf = b""
+
+    def _fill(self):
+        data = self.sock.recv(65536)
+        if not data:
+            raise ConnectionError("closed by the server")
+        self.buf += data
+
+    # One response: (status, whether the server keeps the connection open)
+    def read_response(self):
+        while b"\r\n\r\n" not in self.buf:
+            self._fill()
+        head, self.buf = self.buf.split(b"\r\n\r\n", 1)
+        lines = head.decode("latin-1").split("\r\n")
+        status = int(lines[0].split(" ")[1])
+        headers = {}
+        for line in lines[1:]:
+            name, _, value = line.partition(":")
+            headers[name.strip().lower()] = value.strip().lower()
+        length = int(headers.get("content-length", "0"))
+        while len(self.buf) < length:
+            self._fill()
+        self.buf = self.buf[length:]
+        return status, headers.get("connection") != "close"
+
+
+def request_bytes(host, path, close):
+    return ("GET %s HTTP/1.1\r\nHost: %s\r\nAccept: */*\r\n%s\r\n"
+            % (path, host, "Connection: close\r\n" if close else "")).encode()
+
+
+# One request, opening a connection when there is none. A kept connection
+# the server has closed in the meantime is reopened and the request sent
+# again, as browsers do.
+def fetch_one(conn, path, close):
+    for attempt in range(2):
+        reused = conn.sock is not None
+        start = time.perf_counter()
+        try:
+            if not reused:
+                conn.open()
+            conn.sock.sendall(request_bytes(conn.host, path, close))
+            status, keep = conn.read_response()
+            if not keep:
+                conn.close()
+            return status, time.perf_counter() - start
+        except (ConnectionError, OSError):
+            conn.close()
+            if not reused:
+                break
+    return None
+
+
+# Pipelined: every request in one write, then the responses in order. What
+# did not come back before the server closed goes again one at a time.
+def fetch_pipelined(conn, paths):
+    results = []
+    start = time.perf_counter()
+    try:
+        if conn.sock is None:
+            conn.open()
+        conn.sock.sendall(b"".join(request_bytes(conn.host, path, False) for path in paths))
+        for _ in paths:
+            status, keep = conn.read_response()
+            now = time.perf_counter()
+            results.append((status, now - start))
+            start = now
+            if not keep:
+                conn.close()
+                break
+    except (ConnectionError, OSError):
+        conn.close()
+    for path in paths[len(results):]:
+        results.append(fetch_one(conn, path, False))
+    return results
+
+
+def fetch(conn, paths, mode):
+    if mode == "pipeline":
+        results = fetch_pipelined(conn, paths)
+    else:
+        results = [fetch_one(conn, path, mode == "close") for path in paths]
+    for result in results:
+        if result:
+            conn.stats.add(*result)
+        else:
+            conn.stats.failed()
+
+
+def client(host, port, paths, interval, mode, stats, stop):
+    conn = Connection(host, port, stats)
+    next_at = time.perf_counter()
+    while not stop.is_set():
+        fetch(conn, paths, mode)
+        next_at += interval
+        delay = next_at - time.perf_counter()
+        if delay > 0:
+            stop.wait(delay)
+        else:
+            next_at = time.perf_counter()
+    conn.close()
+
+
+def percentile(values, p):
+    if not values:
+        return 0.0
+    values = sorted(values)
+    return values[min(len(values) - 1, int(len(values) * p))]
+
+
+def run(args, mode):
+    stats = Stats()
+    stop = threading.Event()
+    threads = [threading.Thread(target=client, args=(args.host, args.port, DASHBOARD, args.interval, mode,
+                                                     stats, stop))
+               for _ in range(args.clients)]
+    threads.append(threading.Thread(target=client, args=(args.host, args.port, [HEALTH], args.interval * 10, mode,
+                                                         stats, stop)))
+    for t in threads:
+        t.start()
+    time.sleep(args.duration)
+    stop.set()
+    for t in threads:
+        t.join()
+    return stats
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--clients", type=int, default=4, help="dashboard tabs")
+    parser.add_argument("--interval", type=float, default=0.05, help="seconds between a tab's polls")
+    parser.add_argument("--duration", type=float, default=10)
+    parser.add_argument("--mode", choices=["close", "keep-alive", "pipeline", "all"], default="all")
+    args = parser.parse_args()
+
+    modes = ["close", "keep-alive", "pipeline"] if args.mode == "all" else [args.mode]
+    print("%d tabs every %gs + health check, %gs per mode, %s:%d"
+          % (args.clients, args.interval, args.duration, args.host, args.port))
+    print("%-11s %8s %8s %9s %8s %8s %8s %8s %7s"
+          % ("mode", "requests", "req/s", "connects", "conn/req", "p50 ms", "p99 ms", "max ms", "errors"))
+    for mode in modes:
+        stats = run(args, mode)
+        n = len(stats.latencies)
+        bad = sum(count for status, count in stats.statuses.items() if status != 200)
+        print("%-11s %8d %8.0f %9d %8.2f %8.2f %8.2f %8.2f %7d"
+              % (mode, n, n / args.duration, stats.connects, stats.connects / max(n, 1),
+                 percentile(stats.latencies, 0.5) * 1000, percentile(stats.latencies, 0.99) * 1000,
+                 max(stats.latencies or [0]) * 1000, stats.errors + bad))
+        time.sleep(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+"""
+Compile the pages in web/ into lib/WebAssets/WebAssets.h for flash.
+
+Each page is minified (comments and indentation dropped, whitespace
+between tags and inside <style> collapsed; scripts keep their line
+breaks), then gzipped at level 9 with no name or timestamp, so the same
+source always gives the same bytes. For web/index.html the header has
+
+  WEB_INDEX_HTML        the minified text, for clients that do not take
+                        gzip and for the tunnel
+  WEB_INDEX_HTML_GZ     the gzipped bytes, sent with Content-Encoding: gzip
+  WEB_INDEX_HTML_ETAG   W/"<FNV-1a of the minified text>", for If-None-Match
+
+The header is only rewritten when it changes. PlatformIO runs this before
+every build (extra_scripts in platformio.ini); run it by hand to see the
+sizes:
+
+  python3 scripts/web-assets.py
+"""
+
+import gzip
+import os
+import re
+import sys
+
+SOURCES = "web"
+OUTPUT = os.path.join("lib", "WebAssets", "WebAssets.h")
+EXTENSIONS = (".html", ".css", ".js")
+
+
+def minify_css(css):
+    css = re.sub(r"/\*.*?\*/", "", css, flags=re.S)
+    css = re.sub(r"\s+", " ", css)
+    css = re.sub(r"\s*([{};,>])\s*", r"\1", css)
+    css = re.sub(r":\s+", ":", css)
+    return css.replace(";}", "}").strip()
+
+
+# Line breaks stay: they end statements that have no semicolon
+def minify_js(js):
+    js = re.sub(r"/\*.*?\*/", "", js, flags=re.S)
+    lines = (line.strip() for line in js.split("\n"))
+    return "\n".join(line for line in lines if line and not line.startswith("//"))
+
+
+def minify_html(html):
+    parts = re.split(r"(<style[^>]*>.*?</style>|<script[^>]*>.*?</script>)", html, flags=re.S | re.I)
+    out = []
+    for i, part in enumerate(parts):
+        if i % 2:
+            open_tag, body, close_tag = re.match(r"(<[^>]*>)(.*)(</[^>]*>)$", part, re.S).groups()
+            body = minify_css(body) if open_tag.lower().startswith("<style") else minify_js(body)
+            out.append(open_tag + body + close_tag)
+        else:
+            part = re.sub(r"<!--.*?-->", "", part, flags=re.S)
+            part = re.sub(r">\s+<", "><", part)
+            part = re.sub(r"^\s+<", "<", re.sub(r">\s+$", ">", part))
+            out.append(re.sub(r"\s+", " ", part))
+    return "".join(out).strip()
+
+
+def minify(name, text):
+    if name.endswith(".css"):
+        return minify_css(text)
+    if name.endswith(".js"):
+        return minify_js(text)
+    return minify_html(text)
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h = ((h ^ b) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def c_name(name):
+    return "WEB_" + re.sub(r"[^A-Za-z0-9]", "_", name).upper()
+
+
+# Octal escapes are always three digits, so a digit after one is not read into it
+def c_string(data, width=100):
+    lines, line = [], ""
+    for b in data:
+        c = chr(b)
+        if c == "\\" or c == '"':
+            piece = "\\" + c
+        elif c == "\n":
+            piece = "\\n"
+        elif 32 <= b < 127 and not (c == "?" and line.endswith("?")):
+            piece = c
+        else:
+            piece = "\\%03o" % b
+        line += piece
+        if len(line) >= width or c == "\n":
+            lines.append(line)
+            line = ""
+    if line or not lines:
+        lines.append(line)
+    return "\n".join('    "%s"' % line for line in lines)
+
+
+def c_bytes(data, per_line=16):
+    rows = []
+    for i in range(0, len(data), per_line):
+        rows.append("    " + ", ".join("0x%02x" % b for b in data[i:i + per_line]) + ",")
+    return "\n".join(rows)
+
+
+def compile_asset(name, source):
+    text = minify(name, source.decode("utf-8")).encode("utf-8")
+    packed = gzip.compress(text, compresslevel=9, mtime=0)
+    if gzip.decompress(packed) != text:
+        raise RuntimeError("%s: gzip round trip failed" % name)
+    return text, packed
+
+
+def generate(project_dir, quiet=False):
+    source_dir = os.path.join(project_dir, SOURCES)
+    names = sorted(n for n in os.listdir(source_dir) if n.endswith(EXTENSIONS))
+    blocks = []
+    for name in names:
+        with open(os.path.join(source_dir, name), "rb") as f:
+            source = f.read()
+        text, packed = compile_asset(name, source)
+        symbol = c_name(name)
+        blocks.append(
+            "// %s%s: %d bytes, %d minified, %d gzipped\n"
+            "const char %s[] PROGMEM =\n%s;\n"
+            "const uint8_t %s_GZ[] PROGMEM = {\n%s\n};\n"
+            "#define %s_ETAG \"W/\\\"%08x\\\"\"\n"
+            % (SOURCES + "/", name, len(source), len(text), len(packed),
+               symbol, c_string(text), symbol, c_bytes(packed), symbol, fnv1a(text)))
+        if not quiet:
+            print("%-12s %6d bytes  %6d minified  %6d gzipped" % (name, len(source), len(text), len(packed)))
+
+    header = ("// Generated by scripts/web-assets.py from %s/; do not edit.\n\n"
+              "#pragma once\n\n"
+              "#include <stdint.h>\n\n"
+              "#ifndef PROGMEM\n#define PROGMEM\n#endif\n\n" % SOURCES) + "\n".join(blocks)
+
+    output = os.path.join(project_dir, OUTPUT)
+    try:
+        with open(output) as f:
+            if f.read() == header:
+                return
+    except OSError:
+        pass
+    os.makedirs(os.path.dirname(output), exist_ok=True)
+    with open(output, "w") as f:
+        f.write(header)
+    print("web-assets: wrote %s" % OUTPUT)
+
+
+try:
+    Import("env")   # noqa: F821 - PlatformIO's extra_scripts
+except NameError:
+    if __name__ == "__main__":
+        generate(os.path.join(os.path.dirname(os.path.abspath(sys.argv[0])), ".."))
+else:
+    generate(env.subst("$PROJECT_DIR"), quiet=True)   # noqa: F821
@@ -14,28 +14,62 @@
  */
 
 #include <M5Unified.h>
+#include <atomic>
 #include <WiFi.h>
 #include <WiFiClientSecure.h>
 #include <ESPmDNS.h>
-#include <ESPAsyncWebServer.h>
+#include <HttpServer.h>
+#include <WebSocketChannel.h>
 #include <ArduinoJson.h>
 #include <HTTPClient.h>
 #include <Preferences.h>
 #include <WebSocketsClient.h>
 #include <qrcode.h>
+#include <AgentCard.h>
+#include <Animations.h>
+#include <AgentDirectory.h>
+#include <AgentListParser.h>
+#include <AsyncTcpTransport.h>
+#include <Compositor.h>
+#include <JsonRpcDispatcher.h>
+#include <RegistryClient.h>
+#include <RegistryProbe.h>
+#include <RouteHandler.h>
+#include <TlsTransport.h>
+#include <FrameBuffer.h>
+#include <ScratchAllocator.h>
+#include <ImuFeatures.h>
+#include <ImuStream.h>
+#include <ScreenEncoder.h>
+#include <SensorSamples.h>
+#include <Screens.h>
+#include <TunnelCodec.h>
+#include <TunnelRouter.h>
+#include <TunnelScheduler.h>
+#include <WebAssets.h>
 
 // ============================================================================
 // Configuration
 // ============================================================================
 
 #define AGENT_VERSION "1.0.0"
-#define HTTP_PORT 80
+#ifndef HTTP_PORT
+#define HTTP_PORT 80   // The host build listens on 8080
+#endif
+#define A2A_MAX_BODY 4096   // Larger JSON-RPC bodies get 413
+#define TUNNEL_SCRATCH_BYTES 4096   // JsonDocuments of one tunnel request
 
 // Registry settings
 // Default registry - can be overridden via preferences or WiFi gateway detection
 #define DEFAULT_REGISTRY_PORT 3000
 #define HEARTBEAT_INTERVAL 30000  // 30 seconds
 
+// LAN registry probe: candidates are raced in parallel over AsyncTCP
+#define REGISTRY_PROBE_SLOTS 8       // Concurrent /health probes (lwIP has 16 PCBs)
+#define REGISTRY_PROBE_RX_SIZE 256   // Probes only read the status line
+#define REGISTRY_SWEEP_SUBNET 0      // 1 = sweep the whole /24 when no candidate answers
+#define REGISTRY_SWEEP_TIMEOUT 500   // ms per host during a sweep
+
 // Public registry discovery URL (fallback when no local registry found)
 // This URL returns a list of available public registries
 const char* PUBLIC_REGISTRY_LIST = "https://raw.githubusercontent.com/nanda-framework/registries/main/list.json";
@@ -48,18 +82,6 @@ const char* WIFI_PASS = "49392012";
 // Menu System
 // ============================================================================
 
-enum MenuScreen {
-    MENU_HOME = 0,
-    MENU_SENSORS,
-    MENU_NETWORK,
-    MENU_DISCOVERY,
-    MENU_BATTERY,
-    MENU_IR,
-    MENU_FX,
-    MENU_QR,
-    MENU_COUNT  // Keep last
-};
-
 const char* menuLabels[] = {
     "Home",
     "Sensors",
@@ -79,15 +101,18 @@ bool showingMessage = false;
 unsigned long messageDisplayTime = 0;
 const unsigned long MESSAGE_DISPLAY_DURATION = 5000;  // Show messages for 5 seconds
 
-// A minor diatonic arpeggio frequencies (A3, C4, E4, A4, E4, C4, A3)
-const int AMIN_ARPEGGIO[] = {220, 262, 330, 440, 330, 262, 220};
-const int ARPEGGIO_LEN = 7;
+// Animations play from loop() into the screen frame buffer. Messages from
+// the web server and tunnel tasks are handed over through pendingMessage.
+Timeline screenAnimation;
+bool animatingMessage = false;
+portMUX_TYPE messageMux = portMUX_INITIALIZER_UNLOCKED;
+char pendingMessage[TIMELINE_TEXT_MAX];
+bool messagePending = false;
 
 // ============================================================================
 // Global State
 // ============================================================================
 
-AsyncWebServer server(HTTP_PORT);
 Preferences preferences;
 bool wifiConnected = false;
 bool mdnsStarted = false;
@@ -99,22 +124,24 @@ String deviceHandle = "";
 String deviceHostname = "";
 String deviceName = "";
 
+// Agent card, rebuilt only when identity or network state changes
+AgentCard agentCard;
+volatile bool agentCardDirty = true;  // Also set from the WiFi event task
+
 // Registry state
 String registryUrl = "";
 bool registryConnected = false;
 unsigned long lastHeartbeat = 0;
 int heartbeatFailures = 0;
+AsyncTcpTransport registryTransport;
+TlsTransport registryTlsTransport;   // https:// registries, such as those on the public list
+RegistryClient registry(registryTransport, &registryTlsTransport);
 
-// Discovered agents
-struct DiscoveredAgent {
-    String handle;
-    String url;
-    String name;
-    bool healthy;
-};
-DiscoveredAgent discoveredAgents[10];
-int discoveredAgentCount = 0;
+// Discovered agents, updated in place by each /agents pass
+AgentDirectory agentDirectory;
 unsigned long lastDiscovery = 0;
+bool onDiscoveredAgent(JsonObjectConst agent);
+AgentListParser discoveryParser(onDiscoveredAgent);
 
 // Agent skills (for selected agent)
 struct AgentSkill {
@@ -122,7 +149,8 @@ struct AgentSkill {
     String name;
     String description;
 };
-AgentSkill agentSkills[10];
+#define MAX_AGENT_SKILLS 24
+AgentSkill agentSkills[MAX_AGENT_SKILLS];
 int agentSkillCount = 0;
 int selectedAgentIndex = -1;
 int selectedSkillIndex = 0;
@@ -132,82 +160,155 @@ String lastSkillResult = "";
 // WebSocket tunnel for external access
 WebSocketsClient webSocket;
 bool tunnelConnected = false;
+TunnelCodec tunnelCodec;   // JSON until the registry confirms MessagePack
+// Outgoing frames are encoded after room for the WebSocket header, so
+// sendTXT()/sendBIN() can send them without copying
+uint8_t tunnelFrame[WEBSOCKETS_MAX_HEADER_SIZE + TUNNEL_FRAME_MAX];
+uint8_t tunnelScratchBuf[TUNNEL_SCRATCH_BYTES];
+ScratchAllocator tunnelScratch(tunnelScratchBuf, sizeof(tunnelScratchBuf));
+// Responses of slow skills, finished by the tunnel worker task
+uint8_t tunnelJobFrame[WEBSOCKETS_MAX_HEADER_SIZE + TUNNEL_FRAME_MAX];
+TaskHandle_t tunnelWorker = nullptr;
 unsigned long lastTunnelReconnect = 0;
 #define TUNNEL_RECONNECT_INTERVAL 10000
 
-// Sensor data
-struct SensorData {
-    float accelX, accelY, accelZ;
-    float gyroX, gyroY, gyroZ;
-    float temperature;
-    float batteryVoltage;
-    int batteryPercent;
-    bool isCharging;
-    unsigned long lastUpdate;
-} sensors;
+// Sensor data: only the sampler task reads the IMU and battery; the UI and
+// request handlers take snapshots from its rings (readSensors())
+struct SensorData : SensorReadings {
+    unsigned long lastUpdate;    // millis() when the IMU was read
+};
+ImuRing imuSamples;
+StatusRing statusSamples;
+TaskHandle_t sensorSampler = nullptr;
+
+// Window features of the IMU samples, worked out in loop() and handed to
+// the skill through a ring like the samples themselves
+#ifndef IMU_FEATURE_INTERVAL_MS
+#define IMU_FEATURE_INTERVAL_MS 200
+#endif
+ImuFeatureExtractor imuFeatureExtractor;
+ImuFeatureRing imuFeatureSummaries;
+unsigned long lastImuFeatures = 0;
+
+// Menu screens are drawn off-screen and pushed once per frame; widget
+// screens push only the regions that changed since the last refresh
+FrameBuffer screenFrame(&M5.Display);
+Compositor screenCompositor(screenFrame);
+Widgets screenWidgets;
+
+// Screenshots, encoded from screenFrame's pixels as they are sent. One at a
+// time (PNG's deflate state is about 80 KB): screenEncodeOwner holds the
+// ticket of the transfer using the encoder, 0 when it is free.
+ScreenEncoder screenEncoder;
+std::atomic<uint32_t> screenEncodeOwner(0);
+std::atomic<uint32_t> screenEncodeTickets(0);
+
+// Binary IMU streams (ws://<ip>/ws/imu). Connect and disconnect events
+// arrive on the async_tcp task and only claim or give back a slot; loop()
+// owns the streams and sends their frames (pumpImuStreams()).
+#ifndef IMU_STREAM_CLIENTS
+#define IMU_STREAM_CLIENTS 2
+#endif
+enum ImuSlotState : uint8_t {
+    IMU_SLOT_FREE,
+    IMU_SLOT_CLAIMED,    // Being filled in by the connect event
+    IMU_SLOT_OPENING,    // Filled in, stream not started yet
+    IMU_SLOT_ACTIVE,
+    IMU_SLOT_CLOSING     // Client gone, loop() frees the slot
+};
+struct ImuStreamSlot {
+    std::atomic<uint8_t> state;
+    uint32_t client;
+    uint16_t rate;
+    uint8_t batch;
+    ImuStream stream;
+};
+WebSocketChannel imuSocket("/ws/imu");
+ImuStreamSlot imuStreams[IMU_STREAM_CLIENTS];
+uint8_t imuStreamFrame[IMU_STREAM_FRAME_MAX];
 
 // ============================================================================
-// Display Helpers
+// Sensor Functions
 // ============================================================================
 
-void drawHeader(const char* title) {
-    M5.Display.fillScreen(TFT_BLACK);
-    M5.Display.setTextColor(TFT_CYAN);
-    M5.Display.setTextSize(2);
-    M5.Display.setCursor(5, 5);
-    M5.Display.println(title);
-
-    // Draw separator line
-    M5.Display.drawLine(0, 25, 240, 25, TFT_DARKGREY);
-}
-
-void drawNavHint() {
-    M5.Display.setTextColor(TFT_DARKGREY);
-    M5.Display.setTextSize(1);
-    M5.Display.setCursor(5, 125);
-    M5.Display.print("A:Select  B:Next");
+// Temperature and battery, which change slowly
+void sampleStatus() {
+    StatusSample status;
+    float t = 0;
+    M5.Imu.getTemp(&t);
+    status.ms = millis();
+    status.temperature = t;
+    status.batteryVoltage = M5.Power.getBatteryVoltage() / 1000.0f;
+    status.batteryPercent = M5.Power.getBatteryLevel();
+    status.isCharging = M5.Power.isCharging() ? 1 : 0;
+    statusSamples.push(status);
 }
 
-void drawMenuItem(int y, const char* label, bool selected) {
-    if (selected) {
-        M5.Display.fillRect(0, y - 2, 240, 18, TFT_NAVY);
-        M5.Display.setTextColor(TFT_WHITE);
-    } else {
-        M5.Display.setTextColor(TFT_LIGHTGREY);
+// Reads the IMU every 1/IMU_SAMPLE_HZ s, whatever the UI and clients are doing
+void sensorSamplerTask(void*) {
+    TickType_t period = pdMS_TO_TICKS(1000 / IMU_SAMPLE_HZ);
+    if (period == 0) period = 1;
+    TickType_t wake = xTaskGetTickCount();
+    uint32_t lastStatus = millis();
+
+    for (;;) {
+        if (M5.Imu.update()) {
+            m5::imu_data_t data;
+            M5.Imu.getImuData(&data);
+            imuSamples.push({data.usec, data.accel.x, data.accel.y, data.accel.z,
+                             data.gyro.x, data.gyro.y, data.gyro.z});
+        }
+        if (millis() - lastStatus >= STATUS_SAMPLE_MS) {
+            sampleStatus();
+            lastStatus = millis();
+        }
+        vTaskDelayUntil(&wake, period);
     }
-    M5.Display.setTextSize(2);
-    M5.Display.setCursor(10, y);
-    M5.Display.print(label);
 }
 
-// ============================================================================
-// Sensor Functions
-// ============================================================================
-
-void updateSensors() {
-    float ax, ay, az, gx, gy, gz;
-
-    M5.Imu.getAccel(&ax, &ay, &az);
-    M5.Imu.getGyro(&gx, &gy, &gz);
+void startSensorSampler() {
+    // The first status right away, so screens never show an empty battery
+    sampleStatus();
+    xTaskCreatePinnedToCore(sensorSamplerTask, "sensors", 4096, nullptr, 2, &sensorSampler, ARDUINO_RUNNING_CORE);
+}
 
-    sensors.accelX = ax;
-    sensors.accelY = ay;
-    sensors.accelZ = az;
-    sensors.gyroX = gx;
-    sensors.gyroY = gy;
-    sensors.gyroZ = gz;
+// millis() of a sample's micros() timestamp
+unsigned long sampleMillis(uint32_t usec) {
+    return millis() - (micros() - usec) / 1000;
+}
 
-    // Temperature from IMU
-    float t;
-    M5.Imu.getTemp(&t);
-    sensors.temperature = t;
+// Newest samples; no I2C, safe from any task
+SensorData readSensors() {
+    SensorData data = {};
+
+    ImuSample imu;
+    if (imuSamples.latest(imu)) {
+        data.accelX = imu.accelX;
+        data.accelY = imu.accelY;
+        data.accelZ = imu.accelZ;
+        data.gyroX = imu.gyroX;
+        data.gyroY = imu.gyroY;
+        data.gyroZ = imu.gyroZ;
+        data.lastUpdate = sampleMillis(imu.usec);
+    }
 
-    // Battery
-    sensors.batteryVoltage = M5.Power.getBatteryVoltage() / 1000.0f;
-    sensors.batteryPercent = M5.Power.getBatteryLevel();
-    sensors.isCharging = M5.Power.isCharging();
+    StatusSample status;
+    if (statusSamples.latest(status)) {
+        data.temperature = status.temperature;
+        data.batteryVoltage = status.batteryVoltage;
+        data.batteryPercent = status.batteryPercent;
+        data.isCharging = status.isCharging != 0;
+    }
+    return data;
+}
 
-    sensors.lastUpdate = millis();
+// Take the new IMU samples through the detectors; publish a summary now and then
+void updateImuFeatures() {
+    imuFeatureExtractor.update(imuSamples);
+    if (millis() - lastImuFeatures < IMU_FEATURE_INTERVAL_MS) return;
+    lastImuFeatures = millis();
+    ImuFeatures features;
+    if (imuFeatureExtractor.summarize(features)) imuFeatureSummaries.push(features);
 }
 
 // ============================================================================
@@ -313,11 +414,52 @@ String discoverRegistryMDNS() {
     return "";
 }
 
+// Race /health on every candidate at once; the fastest 200 wins
+String probeForRegistry(const String candidates[], int count, bool sweepSubnet) {
+    HttpTransport* slots[REGISTRY_PROBE_SLOTS];
+    for (int i = 0; i < REGISTRY_PROBE_SLOTS; i++) {
+        slots[i] = new AsyncTcpTransport(REGISTRY_PROBE_RX_SIZE);
+    }
+    RegistryProbe* probe = new RegistryProbe(slots, REGISTRY_PROBE_SLOTS);
+
+    for (int i = 0; i < count; i++) {
+        probe->addUrl(candidates[i].c_str());
+    }
+    if (sweepSubnet) {
+        probe->setTimeout(REGISTRY_SWEEP_TIMEOUT);
+        uint32_t subnet = RegistryProbe::parseIp(WiFi.gatewayIP().toString().c_str());
+        probe->addSubnetSweep(subnet, DEFAULT_REGISTRY_PORT);
+    }
+
+    unsigned long start = millis();
+    probe->start(millis());
+    while (probe->poll(millis())) {
+        delay(1);
+    }
+
+    String url = "";
+    char winner[40];
+    if (probe->winnerUrl(winner, sizeof(winner))) {
+        url = winner;
+        Serial.printf("Registry %s answered in %u ms (probe took %lu ms)\n", winner,
+                      probe->candidate(probe->winner()).latencyMs, millis() - start);
+    } else {
+        Serial.printf("No registry among %u candidates (%lu ms)\n",
+                      (unsigned)probe->count(), millis() - start);
+    }
+
+    delete probe;
+    for (int i = 0; i < REGISTRY_PROBE_SLOTS; i++) {
+        delete slots[i];
+    }
+    return url;
+}
+
 void autoDetectRegistry() {
     // Priority:
     // 1. Saved preference
-    // 2. mDNS discovery
-    // 3. LAN IP scan (gateway, common IPs)
+    // 2. mDNS discovery and LAN candidates (gateway, common IPs), probed in parallel
+    // 3. Optional sweep of the whole /24
     // 4. Public registry list from internet
     // 5. Fallback to gateway:3000
 
@@ -328,31 +470,14 @@ void autoDetectRegistry() {
         return;
     }
 
-    // Try mDNS discovery first
-    String mdnsRegistry = discoverRegistryMDNS();
-    if (mdnsRegistry.length() > 0) {
-        // Verify it's actually a registry
-        HTTPClient http;
-        http.begin(mdnsRegistry + "/health");
-        http.setTimeout(2000);
-        int code = http.GET();
-        http.end();
-
-        if (code == 200) {
-            registryUrl = mdnsRegistry;
-            Serial.println("Using mDNS-discovered registry: " + registryUrl);
-            return;
-        }
-    }
-
     // Try gateway IP on registry port
     IPAddress gateway = WiFi.gatewayIP();
     String gatewayStr = gateway.toString();
 
-    // Try common registry locations on LAN
-    // Scan a range of common IPs where a registry might be running
+    // Try common registry locations on LAN, mDNS result first
     String subnet = gatewayStr.substring(0, gatewayStr.lastIndexOf('.'));
     String candidates[] = {
+        discoverRegistryMDNS(),
         "http://" + gatewayStr + ":" + String(DEFAULT_REGISTRY_PORT),  // Gateway
         "http://" + subnet + ".192:" + String(DEFAULT_REGISTRY_PORT),  // Jetson UGV
         "http://" + subnet + ".100:" + String(DEFAULT_REGISTRY_PORT),  // .100 convention
@@ -365,18 +490,14 @@ void autoDetectRegistry() {
         "http://" + subnet + ".50:" + String(DEFAULT_REGISTRY_PORT)
     };
 
-    HTTPClient http;
-    for (String candidate : candidates) {
-        http.begin(candidate + "/health");
-        http.setTimeout(2000);
-        int code = http.GET();
-        http.end();
-
-        if (code == 200) {
-            registryUrl = candidate;
-            Serial.println("Found local registry at: " + registryUrl);
-            return;
-        }
+    String found = probeForRegistry(candidates, sizeof(candidates) / sizeof(candidates[0]), false);
+    if (found.length() == 0 && REGISTRY_SWEEP_SUBNET) {
+        found = probeForRegistry(nullptr, 0, true);
+    }
+    if (found.length() > 0) {
+        registryUrl = found;
+        Serial.println("Found local registry at: " + registryUrl);
+        return;
     }
 
     // No local registry found - try to fetch from public list
@@ -392,112 +513,129 @@ void autoDetectRegistry() {
     Serial.println("Using fallback registry: " + registryUrl);
 }
 
-bool registerWithRegistry() {
-    if (!wifiConnected) return false;
-
-    HTTPClient http;
-    http.begin(registryUrl + "/agents");
-    http.addHeader("Content-Type", "application/json");
-
-    JsonDocument doc;
-    doc["handle"] = deviceHandle;
-    doc["url"] = "http://" + deviceIP;
-
-    String body;
-    serializeJson(doc, body);
-
-    int httpCode = http.POST(body);
-
-    if (httpCode == 200 || httpCode == 201) {
-        registryConnected = true;
-        heartbeatFailures = 0;
-        Serial.println("Registered with registry: " + deviceHandle);
-        http.end();
-        return true;
-    } else {
-        Serial.println("Registry registration failed: " + String(httpCode));
-        http.end();
-        return false;
-    }
+// Registry traffic runs through the non-blocking client: these only queue
+// work, and loop() advances it with registry.poll() every iteration.
+void registerWithRegistry() {
+    if (!wifiConnected) return;
+    registry.enqueue(REG_REGISTER);
 }
 
-bool sendHeartbeat() {
-    if (!wifiConnected || !registryConnected) return false;
-
-    HTTPClient http;
-    http.begin(registryUrl + "/heartbeat");
-    http.addHeader("Content-Type", "application/json");
-
-    JsonDocument doc;
-    doc["handle"] = deviceHandle;
-    doc["status"] = "healthy";
-
-    String body;
-    serializeJson(doc, body);
-
-    int httpCode = http.POST(body);
-    http.end();
-
-    if (httpCode == 200) {
-        lastHeartbeat = millis();
-        heartbeatFailures = 0;
-        return true;
-    } else {
-        heartbeatFailures++;
-        if (heartbeatFailures > 3) {
-            registryConnected = false;
-            // Try to re-register
-            registerWithRegistry();
-        }
-        return false;
-    }
+void sendHeartbeat() {
+    if (!wifiConnected || !registryConnected) return;
+    registry.enqueue(REG_HEARTBEAT);
 }
 
 void discoverAgents() {
     if (!wifiConnected) return;
+    registry.enqueue(REG_DISCOVER);
+}
 
-    HTTPClient http;
-    http.begin(registryUrl + "/agents");
-
-    int httpCode = http.GET();
-
-    if (httpCode == 200) {
-        String payload = http.getString();
-
-        JsonDocument doc;
-        DeserializationError error = deserializeJson(doc, payload);
-
-        if (!error) {
-            JsonArray agents = doc["agents"];
-            discoveredAgentCount = 0;
+// Called by the streaming /agents parser for each agent, one at a time
+bool onDiscoveredAgent(JsonObjectConst agent) {
+    const char* handle = agent["handle"] | "";
+    // Skip ourselves
+    if (deviceHandle == handle) return true;
+
+    // Stop reading once the directory is full, rather than evict agents
+    // this same listing just added; the pass is then partial and removes nothing
+    if (agentDirectory.full() && agentDirectory.find(handle) < 0) return false;
+    uint16_t evicted = agentDirectory.lastPass().evicted;
+    agentDirectory.upsert(handle, agent["url"] | "", agent["name"] | handle, agent["healthy"] | false);
+    return agentDirectory.lastPass().evicted == evicted;   // Out of string room evicts too
+}
 
-            for (JsonObject agent : agents) {
-                if (discoveredAgentCount >= 10) break;
+bool onRegistryBody(RegistryOp op, const uint8_t* data, size_t len) {
+    if (op == REG_DISCOVER) {
+        return discoveryParser.feed(data, len);
+    }
+    return true;
+}
 
-                String handle = agent["handle"] | "";
-                // Skip ourselves
-                if (handle == deviceHandle) continue;
+void onRegistryComplete(RegistryOp op, int status) {
+    switch (op) {
+        case REG_REGISTER:
+            if (status == 200 || status == 201) {
+                registryConnected = true;
+                heartbeatFailures = 0;
+                Serial.println("Registered with registry: " + deviceHandle);
+            } else {
+                Serial.println("Registry registration failed: " + String(status));
+            }
+            break;
 
-                discoveredAgents[discoveredAgentCount].handle = handle;
-                discoveredAgents[discoveredAgentCount].url = agent["url"] | "";
-                discoveredAgents[discoveredAgentCount].name = agent["name"] | handle;
-                discoveredAgents[discoveredAgentCount].healthy = agent["healthy"] | false;
-                discoveredAgentCount++;
+        case REG_HEARTBEAT:
+            if (status == 200) {
+                lastHeartbeat = millis();
+                heartbeatFailures = 0;
+            } else {
+                heartbeatFailures++;
+                if (heartbeatFailures > 3) {
+                    registryConnected = false;
+                    // Try to re-register
+                    registerWithRegistry();
+                }
             }
+            break;
 
-            lastDiscovery = millis();
-            Serial.println("Discovered " + String(discoveredAgentCount) + " agents");
+        case REG_DISCOVER:
+        {
+            // Only a complete listing may remove agents it did not mention
+            String selected = agentDirectory.handle(selectedAgentIndex);
+            const AgentDirectory::PassStats& pass = agentDirectory.endPass(status == 200 && discoveryParser.finished());
+            if (status == 200) {
+                lastDiscovery = millis();
+                Serial.printf("Discovered %d agents (+%u ~%u -%u, %u evicted, %u rejected)\n",
+                              (int)agentDirectory.size(), pass.added, pass.changed, pass.removed, pass.evicted,
+                              pass.rejected);
+            }
+            // Positions shift as agents come and go; follow the selected handle
+            int count = agentDirectory.size();
+            int found = agentDirectory.find(selected.c_str());
+            if (found >= 0) {
+                selectedAgentIndex = found;
+            } else if (selectedAgentIndex >= count) {
+                selectedAgentIndex = count - 1;
+            }
+            if (count > 0 && selectedAgentIndex < 0) {
+                selectedAgentIndex = 0;
+            }
+            if (currentScreen == MENU_DISCOVERY && (pass.added || pass.changed || pass.removed || pass.evicted ||
+                                                 pass.rejected)) {
+                needsRedraw = true;
+            }
+            discoveryParser.reset();
+            agentDirectory.beginPass();
+            break;
         }
     }
+    if (currentScreen == MENU_HOME) {
+        needsRedraw = true;
+    }
+}
 
-    http.end();
+void setupRegistryClient() {
+    registry.begin(registryUrl.c_str());
+    registry.setIdentity(deviceHandle.c_str(), ("http://" + deviceIP).c_str());
+    registry.onBody(onRegistryBody);
+    registry.onComplete(onRegistryComplete);
+    agentDirectory.beginPass();
+}
+
+// Drive queued registry requests to completion (boot sequence only)
+void waitForRegistry(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (registry.busy() && millis() - start < timeoutMs) {
+        registry.poll(millis());
+        delay(1);
+    }
 }
 
 // Fetch skills from an agent's agent card
 void fetchAgentSkills(int agentIndex) {
-    if (agentIndex < 0 || agentIndex >= discoveredAgentCount) return;
+    if (agentIndex < 0 || agentIndex >= (int)agentDirectory.size()) return;
 
-    String agentUrl = discoveredAgents[agentIndex].url;
+    agentDirectory.touch(agentIndex);
+    String agentUrl = agentDirectory.url(agentIndex);
     HTTPClient http;
     http.begin(agentUrl + "/.well-known/agent.json");
     http.setTimeout(5000);
@@ -513,13 +651,16 @@ void fetchAgentSkills(int agentIndex) {
         if (!error) {
             JsonArray skills = doc["skills"];
             for (JsonObject skill : skills) {
-                if (agentSkillCount >= 10) break;
+                if (agentSkillCount >= MAX_AGENT_SKILLS) {
+                    Serial.printf("Agent lists %d skills, showing the first %d\n", (int)skills.size(), MAX_AGENT_SKILLS);
+                    break;
+                }
                 agentSkills[agentSkillCount].id = skill["id"] | "";
                 agentSkills[agentSkillCount].name = skill["name"] | "";
                 agentSkills[agentSkillCount].description = skill["description"] | "";
                 agentSkillCount++;
             }
-            Serial.println("Fetched " + String(agentSkillCount) + " skills from " + discoveredAgents[agentIndex].handle);
+            Serial.println("Fetched " + String(agentSkillCount) + " skills from " + String(agentDirectory.handle(agentIndex)));
         }
     } else {
         Serial.println("Failed to fetch skills: " + String(httpCode));
@@ -530,10 +671,11 @@ void fetchAgentSkills(int agentIndex) {
 
 // Execute a skill on an agent
 String executeSkill(int agentIndex, int skillIndex) {
-    if (agentIndex < 0 || agentIndex >= discoveredAgentCount) return "Invalid agent";
+    if (agentIndex < 0 || agentIndex >= (int)agentDirectory.size()) return "Invalid agent";
     if (skillIndex < 0 || skillIndex >= agentSkillCount) return "Invalid skill";
 
-    String agentUrl = discoveredAgents[agentIndex].url;
+    agentDirectory.touch(agentIndex);
+    String agentUrl = agentDirectory.url(agentIndex);
     String skillId = agentSkills[skillIndex].id;
 
     // Build a natural language command from skill ID
@@ -578,17 +720,24 @@ String executeSkill(int agentIndex, int skillIndex) {
         DeserializationError error = deserializeJson(respDoc, response);
 
         if (!error) {
-            // Extract text from response
+            // Extract text from response: result is the agent message itself
+            // (A2A), or wraps it in "message" (older peers)
             JsonObject resultObj = respDoc["result"];
-            JsonObject respMessage = resultObj["message"];
-            JsonArray respParts = respMessage["parts"];
+            JsonArray respParts = resultObj["parts"];
+            if (respParts.isNull()) {
+                respParts = resultObj["message"]["parts"].as<JsonArray>();
+            }
 
             for (JsonObject p : respParts) {
-                if (p["type"] == "text") {
+                if (p["type"] == "text" || p["kind"] == "text") {
                     result = p["text"] | "";
                     break;
                 }
             }
+            // Data-only reply, e.g. from another M5Stick
+            if (result.length() == 0 && respParts.size() > 0 && !respParts[0]["data"].isNull()) {
+                serializeJson(respParts[0]["data"], result);
+            }
         }
 
         if (result.length() == 0) {
@@ -606,718 +755,488 @@ String executeSkill(int agentIndex, int skillIndex) {
 // Screen Renderers
 // ============================================================================
 
-void drawHomeScreen() {
-    drawHeader("NANDA");
-
-    M5.Display.setTextSize(1);
-
-    // Device identity
-    M5.Display.setTextColor(TFT_MAGENTA);
-    M5.Display.setCursor(10, 32);
-    M5.Display.println(deviceHandle);
-
-    // Network status
-    if (wifiConnected) {
-        M5.Display.setTextColor(TFT_GREEN);
-        M5.Display.setCursor(10, 45);
-        M5.Display.print("WiFi ");
-        M5.Display.setTextColor(TFT_CYAN);
-        M5.Display.println(deviceIP);
+const char* agentSkillName(int index) {
+    return agentSkills[index].name.c_str();
+}
 
-        // mDNS hostname
-        if (mdnsStarted) {
-            M5.Display.setTextColor(TFT_DARKGREY);
-            M5.Display.setCursor(10, 58);
-            M5.Display.println(deviceHostname + ".local");
-        }
-    } else {
-        M5.Display.setTextColor(TFT_RED);
-        M5.Display.setCursor(10, 45);
-        M5.Display.println("WiFi: Connecting...");
-    }
+// Snapshot of everything the screens show
+ScreenState screenState() {
+    ScreenState state = {};
+    state.handle = deviceHandle.c_str();
+    state.ip = deviceIP.c_str();
+    state.hostname = deviceHostname.c_str();
+    state.ssid = WIFI_SSID;
+    state.wifiConnected = wifiConnected;
+    state.mdnsStarted = mdnsStarted;
+    state.registryConnected = registryConnected;
+    state.tunnelConnected = tunnelConnected;
+    state.rssi = wifiConnected ? WiFi.RSSI() : 0;
+    state.sensors = readSensors();
+    state.agents = &agentDirectory;
+    state.selectedAgent = selectedAgentIndex;
+    state.viewingSkills = viewingAgentSkills;
+    state.skillCount = agentSkillCount;
+    state.selectedSkill = selectedSkillIndex;
+    state.skillName = agentSkillName;
+    state.lastSkillResult = lastSkillResult.c_str();
+    state.seed = esp_random();
+    return state;
+}
 
-    // Registry status
-    M5.Display.setCursor(10, 75);
-    if (registryConnected) {
-        M5.Display.setTextColor(TFT_GREEN);
-        M5.Display.print("Registry ");
-        M5.Display.setTextColor(TFT_WHITE);
-        int totalAgents = discoveredAgentCount + 1;  // +1 for ourselves
-        M5.Display.print(totalAgents);
-        M5.Display.println(totalAgents == 1 ? " agent (you)" : " agents");
+void drawCurrentScreen() {
+    ScreenState state = screenState();
+    screenWidgets.clear();
+    if (layoutScreen(screenWidgets, currentScreen, state)) {
+        screenCompositor.compose(currentScreen, screenWidgets);
     } else {
-        M5.Display.setTextColor(TFT_YELLOW);
-        M5.Display.println("Registry: Offline");
-    }
-
-    // Tunnel status
-    M5.Display.setCursor(10, 90);
-    if (tunnelConnected) {
-        M5.Display.setTextColor(TFT_GREEN);
-        M5.Display.print("Tunnel ");
-        M5.Display.setTextColor(TFT_WHITE);
-        M5.Display.println("connected");
-    } else if (registryConnected) {
-        M5.Display.setTextColor(TFT_YELLOW);
-        M5.Display.println("Tunnel: reconnecting...");
+        drawScreen(screenFrame.canvas(), currentScreen, state);
+        screenFrame.present();
+        screenCompositor.invalidate();
     }
-
-    // Quick stats
-    updateSensors();
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setCursor(10, 108);
-    M5.Display.printf("%.1fC  %d%%  ", sensors.temperature, sensors.batteryPercent);
-    M5.Display.setTextColor(TFT_GREEN);
-    M5.Display.print(":80");
-
-    drawNavHint();
 }
 
-void drawSensorsScreen() {
-    drawHeader("Sensors");
-    updateSensors();
+// ============================================================================
+// API Handlers
+// ============================================================================
 
-    M5.Display.setTextSize(1);
-    M5.Display.setTextColor(TFT_WHITE);
+// Skill handlers write their result straight into the response document
 
-    M5.Display.setCursor(10, 35);
-    M5.Display.printf("Accel X: %+.2f g", sensors.accelX);
-    M5.Display.setCursor(10, 50);
-    M5.Display.printf("Accel Y: %+.2f g", sensors.accelY);
-    M5.Display.setCursor(10, 65);
-    M5.Display.printf("Accel Z: %+.2f g", sensors.accelZ);
+bool skillSensorsRead(JsonVariantConst params, JsonObject out) {
+    SensorData sensors = readSensors();
 
-    M5.Display.setTextColor(TFT_CYAN);
-    M5.Display.setCursor(10, 85);
-    M5.Display.printf("Gyro: %+.0f %+.0f %+.0f", sensors.gyroX, sensors.gyroY, sensors.gyroZ);
+    JsonObject accel = out["accelerometer"].to<JsonObject>();
+    accel["x"] = sensors.accelX;
+    accel["y"] = sensors.accelY;
+    accel["z"] = sensors.accelZ;
 
-    M5.Display.setTextColor(TFT_ORANGE);
-    M5.Display.setCursor(10, 105);
-    M5.Display.printf("Temp: %.1f C", sensors.temperature);
+    JsonObject gyro = out["gyroscope"].to<JsonObject>();
+    gyro["x"] = sensors.gyroX;
+    gyro["y"] = sensors.gyroY;
+    gyro["z"] = sensors.gyroZ;
 
-    drawNavHint();
+    out["temperature"] = sensors.temperature;
+    out["timestamp"] = sensors.lastUpdate;
+    return true;
 }
 
-void drawNetworkScreen() {
-    drawHeader("Network");
-
-    M5.Display.setTextSize(1);
-
-    if (wifiConnected) {
-        M5.Display.setTextColor(TFT_GREEN);
-        M5.Display.setCursor(10, 35);
-        M5.Display.println("Status: Connected");
-
-        M5.Display.setTextColor(TFT_WHITE);
-        M5.Display.setCursor(10, 50);
-        M5.Display.print("SSID: ");
-        M5.Display.println(WIFI_SSID);
-
-        M5.Display.setCursor(10, 65);
-        M5.Display.print("IP: ");
-        M5.Display.println(deviceIP);
-
-        M5.Display.setTextColor(TFT_CYAN);
-        M5.Display.setCursor(10, 80);
-        M5.Display.print("mDNS: ");
-        M5.Display.println(deviceHostname + ".local");
+void writeAxes(JsonObject out, const char* key, const float* values) {
+    JsonObject axes = out[key].to<JsonObject>();
+    axes["x"] = values[0];
+    axes["y"] = values[1];
+    axes["z"] = values[2];
+}
 
-        M5.Display.setTextColor(TFT_YELLOW);
-        M5.Display.setCursor(10, 100);
-        M5.Display.printf("RSSI: %d dBm", WiFi.RSSI());
-    } else {
-        M5.Display.setTextColor(TFT_RED);
-        M5.Display.setCursor(10, 50);
-        M5.Display.println("Connecting...");
+bool skillSensorsFeatures(JsonVariantConst params, JsonObject out) {
+    ImuFeatures f;
+    if (!imuFeatureSummaries.latest(f)) {
+        out["samples"] = 0;
+        return true;
     }
+    out["samples"] = f.samples;
+    out["seconds"] = (float)f.samples / IMU_SAMPLE_HZ;
+
+    JsonObject accel = out["accelerometer"].to<JsonObject>();
+    writeAxes(accel, "mean", &f.mean[IMU_ACCEL_X]);
+    writeAxes(accel, "variance", &f.variance[IMU_ACCEL_X]);
+    writeAxes(accel, "rms", &f.rms[IMU_ACCEL_X]);
+    JsonObject gyro = out["gyroscope"].to<JsonObject>();
+    writeAxes(gyro, "mean", &f.mean[IMU_GYRO_X]);
+    writeAxes(gyro, "variance", &f.variance[IMU_GYRO_X]);
+    writeAxes(gyro, "rms", &f.rms[IMU_GYRO_X]);
+
+    JsonObject tilt = out["tilt"].to<JsonObject>();
+    tilt["pitch"] = f.pitch;
+    tilt["roll"] = f.roll;
+
+    JsonObject vibration = out["vibration"].to<JsonObject>();
+    vibration["peakHz"] = f.peakHz;
+    vibration["peakG"] = f.peakG;
+    vibration["bandHz"] = f.bandHz;
+    JsonArray bands = vibration["bands"].to<JsonArray>();
+    for (float band : f.bands) bands.add(band);
+
+    JsonObject shake = out["shake"].to<JsonObject>();
+    shake["active"] = f.shaking != 0;
+    shake["count"] = f.shakes;
+    shake["intensity"] = f.magnitudeStd;
+
+    JsonObject taps = out["taps"].to<JsonObject>();
+    taps["count"] = f.taps;
+    if (f.taps) taps["last"] = sampleMillis(f.lastTapUsec);
+
+    out["timestamp"] = sampleMillis(f.usec);
+    return true;
+}
 
-    drawNavHint();
+bool skillButtonStatus(JsonVariantConst params, JsonObject out) {
+    out["btnA"] = M5.BtnA.isPressed();
+    out["btnB"] = M5.BtnB.isPressed();
+    out["btnPwr"] = M5.BtnPWR.isPressed();
+    return true;
 }
 
-void drawBatteryScreen() {
-    drawHeader("Battery");
-    updateSensors();
+bool skillBatteryStatus(JsonVariantConst params, JsonObject out) {
+    SensorData sensors = readSensors();
 
-    M5.Display.setTextSize(2);
+    out["voltage"] = sensors.batteryVoltage;
+    out["percent"] = sensors.batteryPercent;
+    out["isCharging"] = sensors.isCharging;
+    return true;
+}
 
-    // Battery percentage with color
-    if (sensors.batteryPercent > 50) {
-        M5.Display.setTextColor(TFT_GREEN);
-    } else if (sensors.batteryPercent > 20) {
-        M5.Display.setTextColor(TFT_YELLOW);
-    } else {
-        M5.Display.setTextColor(TFT_RED);
-    }
+bool skillWifiScan(JsonVariantConst params, JsonObject out) {
+    int n = WiFi.scanNetworks();
 
-    M5.Display.setCursor(10, 40);
-    M5.Display.printf("%d%%", sensors.batteryPercent);
+    JsonArray networks = out["networks"].to<JsonArray>();
 
-    // Voltage
-    M5.Display.setTextSize(1);
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setCursor(10, 70);
-    M5.Display.printf("Voltage: %.2f V", sensors.batteryVoltage);
-
-    // Charging status
-    M5.Display.setCursor(10, 90);
-    if (sensors.isCharging) {
-        M5.Display.setTextColor(TFT_CYAN);
-        M5.Display.println("Charging...");
-    } else {
-        M5.Display.setTextColor(TFT_DARKGREY);
-        M5.Display.println("Not charging");
+    for (int i = 0; i < n && i < 10; i++) {
+        JsonObject net = networks.add<JsonObject>();
+        net["ssid"] = WiFi.SSID(i);
+        net["rssi"] = WiFi.RSSI(i);
+        net["channel"] = WiFi.channel(i);
     }
 
-    // Battery bar
-    int barWidth = map(sensors.batteryPercent, 0, 100, 0, 200);
-    M5.Display.drawRect(10, 105, 204, 14, TFT_WHITE);
-    M5.Display.fillRect(12, 107, barWidth, 10,
-        sensors.batteryPercent > 50 ? TFT_GREEN :
-        sensors.batteryPercent > 20 ? TFT_YELLOW : TFT_RED);
-
-    drawNavHint();
+    out["count"] = n;
+    return true;
 }
 
-void drawDiscoveryScreen() {
-    if (viewingAgentSkills && selectedAgentIndex >= 0) {
-        // Show skills for selected agent
-        drawHeader("Skills");
-
-        M5.Display.setTextSize(1);
-        M5.Display.setTextColor(TFT_CYAN);
-        M5.Display.setCursor(10, 32);
-        M5.Display.println(discoveredAgents[selectedAgentIndex].handle);
-
-        if (agentSkillCount == 0) {
-            M5.Display.setTextColor(TFT_YELLOW);
-            M5.Display.setCursor(10, 55);
-            M5.Display.println("No skills found");
-        } else {
-            int y = 48;
-            int startIdx = max(0, selectedSkillIndex - 2);
-            int endIdx = min(agentSkillCount, startIdx + 5);
-
-            for (int i = startIdx; i < endIdx; i++) {
-                bool selected = (i == selectedSkillIndex);
-                if (selected) {
-                    M5.Display.fillRect(0, y - 2, 240, 14, TFT_NAVY);
-                }
-                M5.Display.setCursor(10, y);
-                M5.Display.setTextColor(selected ? TFT_WHITE : TFT_LIGHTGREY);
-                M5.Display.print(selected ? "> " : "  ");
-
-                String skillName = agentSkills[i].name;
-                if (skillName.length() > 20) skillName = skillName.substring(0, 20);
-                M5.Display.println(skillName);
-                y += 14;
-            }
-        }
-
-        // Show last result if any
-        if (lastSkillResult.length() > 0) {
-            M5.Display.setTextColor(TFT_GREEN);
-            M5.Display.setCursor(10, 108);
-            String result = lastSkillResult.substring(0, 30);
-            M5.Display.println(result);
-        }
+// Queue text for the message animation; safe from any task, returns at once
+void showMessage(const char* text) {
+    portENTER_CRITICAL(&messageMux);
+    strlcpy(pendingMessage, text, sizeof(pendingMessage));
+    messagePending = true;
+    portEXIT_CRITICAL(&messageMux);
+}
 
-        M5.Display.setTextColor(TFT_YELLOW);
-        M5.Display.setCursor(5, 125);
-        M5.Display.print("A:Run B:Next PWR:Back");
-    } else {
-        // Show agent list
-        drawHeader("Agents");
+void playAnimationCue(uint16_t frequency, uint16_t durationMs) {
+    M5.Speaker.tone(frequency, durationMs);
+}
 
-        M5.Display.setTextSize(1);
+void startStartupAnimation() {
+    buildStartupAnimation(screenAnimation);
+    screenAnimation.start(millis(), esp_random());
+    animatingMessage = false;
+}
 
-        int totalAgents = discoveredAgentCount;
-        M5.Display.setTextColor(TFT_WHITE);
-        M5.Display.setCursor(10, 32);
-        M5.Display.print(totalAgents);
-        M5.Display.println(totalAgents == 1 ? " agent found" : " agents found");
+// Start a queued message and draw the next animation frame, if one is due
+void updateAnimation() {
+    if (messagePending) {
+        char text[TIMELINE_TEXT_MAX];
+        portENTER_CRITICAL(&messageMux);
+        memcpy(text, pendingMessage, sizeof(text));
+        messagePending = false;
+        portEXIT_CRITICAL(&messageMux);
+
+        buildMessageAnimation(screenAnimation, text);
+        screenAnimation.start(millis(), esp_random());
+        animatingMessage = true;
+        showingMessage = false;
+    }
 
-        if (totalAgents == 0) {
-            M5.Display.setTextColor(TFT_YELLOW);
-            M5.Display.setCursor(10, 55);
-            M5.Display.println("Press A to scan");
-        } else {
-            int y = 48;
-            int startIdx = max(0, selectedAgentIndex - 2);
-            int endIdx = min(discoveredAgentCount, startIdx + 5);
-
-            for (int i = startIdx; i < endIdx; i++) {
-                bool selected = (i == selectedAgentIndex);
-                if (selected) {
-                    M5.Display.fillRect(0, y - 2, 240, 14, TFT_NAVY);
-                }
-                M5.Display.setCursor(5, y);
-                M5.Display.setTextColor(discoveredAgents[i].healthy ? TFT_GREEN : TFT_RED);
-                M5.Display.print(selected ? "> " : "  ");
-                M5.Display.print(discoveredAgents[i].healthy ? "+ " : "- ");
-
-                M5.Display.setTextColor(selected ? TFT_WHITE : TFT_LIGHTGREY);
-                String handle = discoveredAgents[i].handle;
-                if (handle.length() > 18) handle = handle.substring(0, 18);
-                M5.Display.println(handle);
-                y += 14;
-            }
+    if (!screenAnimation.running()) return;
+    if (screenAnimation.advance(screenFrame.canvas(), millis())) {
+        screenFrame.present();
+    }
+    if (!screenAnimation.running()) {
+        if (animatingMessage) {
+            // Keep the message up for a while
+            showingMessage = true;
+            messageDisplayTime = millis();
+            animatingMessage = false;
         }
-
-        M5.Display.setTextColor(TFT_YELLOW);
-        M5.Display.setCursor(5, 125);
-        M5.Display.print("A:Select B:Next");
+        needsRedraw = true;
     }
 }
 
-void drawIRScreen() {
-    drawHeader("IR Control");
-
-    M5.Display.setTextSize(1);
-    M5.Display.setTextColor(TFT_WHITE);
-
-    M5.Display.setCursor(10, 40);
-    M5.Display.println("IR Transmitter Ready");
+bool skillDisplayShow(JsonVariantConst params, JsonObject out) {
+    const char* text = params["text"];
+    if (!text) return false;
 
-    M5.Display.setTextColor(TFT_YELLOW);
-    M5.Display.setCursor(10, 60);
-    M5.Display.println("Press A to send test");
-
-    M5.Display.setTextColor(TFT_DARKGREY);
-    M5.Display.setCursor(10, 85);
-    M5.Display.println("Use HTTP API for");
-    M5.Display.setCursor(10, 100);
-    M5.Display.println("custom IR commands");
+    showMessage(text);
 
-    drawNavHint();
+    out["success"] = true;
+    out["displayed"] = text;
+    return true;
 }
 
-void drawFXScreen() {
-    M5.Display.fillScreen(TFT_BLACK);
-    drawHeader("FX");
-
-    M5.Display.setTextColor(TFT_CYAN);
-    M5.Display.setTextSize(1);
-    M5.Display.setCursor(10, 40);
-    M5.Display.println("Visual Effects");
-
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setCursor(10, 60);
-    M5.Display.println("Press A to play");
-    M5.Display.setCursor(10, 75);
-    M5.Display.println("startup animation");
-
-    // Draw some voxel decorations
-    for (int i = 0; i < 20; i++) {
-        int x = random(10, 230);
-        int y = random(95, 125);
-        int size = random(2, 5);
-        uint16_t color = (random(0, 2) == 0) ? TFT_CYAN : TFT_MAGENTA;
-        M5.Display.fillRect(x, y, size, size, color);
-    }
+bool skillBuzzerTone(JsonVariantConst params, JsonObject out) {
+    int freq = params["frequency"] | (params["freq"] | 1000);
+    int duration = params["duration"] | 100;
+    M5.Speaker.tone(freq, duration);
 
-    drawNavHint();
+    out["success"] = true;
+    out["frequency"] = freq;
+    out["duration"] = duration;
+    return true;
 }
 
-void drawQRScreen() {
-    M5.Display.fillScreen(TFT_BLACK);
-
-    // Build the chat URL
-    String chatUrl = "http://" + deviceIP + "/chat";
-
-    // Create QR code
-    QRCode qrcode;
-    uint8_t qrcodeData[qrcode_getBufferSize(3)];
-    qrcode_initText(&qrcode, qrcodeData, 3, ECC_LOW, chatUrl.c_str());
-
-    // Calculate size and position (fit in screen)
-    int moduleSize = 3;  // Size of each QR module
-    int qrSize = qrcode.size * moduleSize;
-    int offsetX = (240 - qrSize) / 2;
-    int offsetY = 15;
-
-    // Draw white background for QR
-    M5.Display.fillRect(offsetX - 4, offsetY - 4, qrSize + 8, qrSize + 8, TFT_WHITE);
-
-    // Draw QR code
-    for (uint8_t y = 0; y < qrcode.size; y++) {
-        for (uint8_t x = 0; x < qrcode.size; x++) {
-            if (qrcode_getModule(&qrcode, x, y)) {
-                M5.Display.fillRect(offsetX + x * moduleSize, offsetY + y * moduleSize,
-                                   moduleSize, moduleSize, TFT_BLACK);
-            }
-        }
-    }
-
-    // Show URL text
-    M5.Display.setTextColor(TFT_CYAN);
-    M5.Display.setTextSize(1);
-    M5.Display.setCursor(10, 115);
-    M5.Display.print("Scan to chat: ");
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setCursor(10, 125);
-    M5.Display.print(chatUrl);
-}
+// ============================================================================
+// Skill Registry (shared by /a2a, the tunnel and the agent card)
+// ============================================================================
 
-void drawCurrentScreen() {
-    switch (currentScreen) {
-        case MENU_HOME:
-            drawHomeScreen();
-            break;
-        case MENU_SENSORS:
-            drawSensorsScreen();
-            break;
-        case MENU_NETWORK:
-            drawNetworkScreen();
-            break;
-        case MENU_DISCOVERY:
-            drawDiscoveryScreen();
-            break;
-        case MENU_BATTERY:
-            drawBatteryScreen();
-            break;
-        case MENU_IR:
-            drawIRScreen();
-            break;
-        case MENU_FX:
-            drawFXScreen();
-            break;
-        case MENU_QR:
-            drawQRScreen();
-            break;
-        default:
-            drawHomeScreen();
-            break;
-    }
-}
+const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", skillSensorsRead},
+    {"sensors/features", "Motion Features", "Window statistics, vibration spectrum, tilt, shake and taps", skillSensorsFeatures},
+    {"display/show", "Show on Display", "Display text on LCD", skillDisplayShow},
+    {"button/status", "Button Status", "Get current button states", skillButtonStatus},
+    {"buzzer/tone", "Play Tone", "Play a tone on the buzzer", skillBuzzerTone},
+    {"battery/status", "Battery Status", "Get battery voltage and percentage", skillBatteryStatus},
+    {"wifi/scan", "Scan WiFi", "Scan for nearby WiFi networks", skillWifiScan, true}
+};
+JsonRpcDispatcher rpc(SKILLS, SKILL_COUNT(SKILLS));
 
 // ============================================================================
-// API Handlers
+// Screenshots (GET /api/screen.png and /api/screen.qoi, HTTP and tunnel)
 // ============================================================================
 
-String getAgentCard() {
-    JsonDocument doc;
-
-    doc["name"] = deviceName;
-    doc["handle"] = deviceHandle;
-    doc["deviceId"] = deviceId;
-    doc["description"] = "M5StickC Plus 2 IoT device with sensors, display, IR, and controls";
-    if (mdnsStarted) {
-        doc["url"] = "http://" + deviceHostname + ".local";
-    } else {
-        doc["url"] = "http://" + deviceIP;
+// Start encoding the current frame; returns the transfer's ticket, 0 if busy
+uint32_t acquireScreenEncoder(ScreenFormat format) {
+    uint32_t ticket = ++screenEncodeTickets;
+    if (ticket == 0) ticket = ++screenEncodeTickets;
+    uint32_t idle = 0;
+    if (!screenEncodeOwner.compare_exchange_strong(idle, ticket)) return 0;
+    if (!screenEncoder.begin(screenFrame.surface(), format)) {
+        screenEncodeOwner = 0;
+        return 0;
     }
-    doc["version"] = AGENT_VERSION;
-
-    JsonArray inputModes = doc["defaultInputModes"].to<JsonArray>();
-    inputModes.add("application/json");
-
-    JsonArray outputModes = doc["defaultOutputModes"].to<JsonArray>();
-    outputModes.add("application/json");
-
-    JsonObject caps = doc["capabilities"].to<JsonObject>();
-    caps["streaming"] = false;
-    caps["pushNotifications"] = false;
-
-    JsonArray skills = doc["skills"].to<JsonArray>();
+    return ticket;
+}
 
-    // Define available skills
-    const char* skillDefs[][3] = {
-        {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature"},
-        {"display/show", "Show on Display", "Display text on LCD"},
-        {"button/status", "Button Status", "Get current button states"},
-        {"buzzer/tone", "Play Tone", "Play a tone on the buzzer"},
-        {"battery/status", "Battery Status", "Get battery voltage and percentage"},
-        {"wifi/scan", "Scan WiFi", "Scan for nearby WiFi networks"}
-    };
+// Safe to call more than once, and after another transfer took over
+void releaseScreenEncoder(uint32_t ticket) {
+    if (screenEncodeOwner.load() != ticket) return;
+    screenEncoder.end();
+    screenEncodeOwner = 0;
+}
 
-    for (int i = 0; i < 6; i++) {
-        JsonObject skill = skills.add<JsonObject>();
-        skill["id"] = skillDefs[i][0];
-        skill["name"] = skillDefs[i][1];
-        skill["description"] = skillDefs[i][2];
+// Chunked response pulling the file from the encoder as TCP has room
+void sendScreen(HttpRequest& request, ScreenFormat format) {
+    if (!screenFrame.buffered()) {
+        request.send(503, "application/json", "{\"error\":\"No frame buffer\"}");
+        return;
     }
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+    uint32_t ticket = acquireScreenEncoder(format);
+    if (!ticket) {
+        static const char BUSY[] = "{\"error\":\"Screenshot in progress\"}";
+        HttpResponse& busy = request.beginResponse(503, "application/json", BUSY, sizeof(BUSY) - 1);
+        busy.addHeader("Retry-After", "1");
+        request.send(busy);
+        return;
+    }
+    HttpResponse& response = request.beginChunkedResponse(ScreenEncoder::contentType(format),
+        [ticket](uint8_t* buffer, size_t maxLen) -> size_t {
+            if (screenEncodeOwner.load() != ticket) return 0;
+            size_t n = screenEncoder.read(buffer, maxLen);
+            if (n == 0) releaseScreenEncoder(ticket);
+            return n;
+        });
+    response.addHeader("Cache-Control", "no-store");
+    // A client that goes away mid-transfer must not keep the encoder
+    request.onEnd([ticket]() { releaseScreenEncoder(ticket); });
+    request.send(response);
 }
 
-String handleSensorsRead() {
-    updateSensors();
-
-    JsonDocument doc;
-
-    JsonObject accel = doc["accelerometer"].to<JsonObject>();
-    accel["x"] = sensors.accelX;
-    accel["y"] = sensors.accelY;
-    accel["z"] = sensors.accelZ;
-
-    JsonObject gyro = doc["gyroscope"].to<JsonObject>();
-    gyro["x"] = sensors.gyroX;
-    gyro["y"] = sensors.gyroY;
-    gyro["z"] = sensors.gyroZ;
-
-    doc["temperature"] = sensors.temperature;
-    doc["timestamp"] = sensors.lastUpdate;
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+// Through the tunnel the whole file has to fit in one frame
+int writeScreen(ScreenFormat format, uint8_t* out, size_t room, size_t& len) {
+    if (!screenFrame.buffered()) return 503;
+    uint32_t ticket = acquireScreenEncoder(format);
+    if (!ticket) return 503;
+    len = 0;
+    size_t n;
+    while ((n = screenEncoder.read(out + len, room - len)) > 0) {
+        len += n;
+    }
+    bool complete = screenEncoder.done();
+    releaseScreenEncoder(ticket);
+    return complete ? 200 : 413;
 }
 
-String handleButtonStatus() {
-    JsonDocument doc;
-    doc["btnA"] = M5.BtnA.isPressed();
-    doc["btnB"] = M5.BtnB.isPressed();
-    doc["btnPwr"] = M5.BtnPWR.isPressed();
-
-    String output;
-    serializeJson(doc, output);
-    return output;
+int writeScreenPng(uint8_t* out, size_t room, size_t& len) {
+    return writeScreen(SCREEN_PNG, out, room, len);
 }
 
-String handleBatteryStatus() {
-    updateSensors();
+int writeScreenQoi(uint8_t* out, size_t room, size_t& len) {
+    return writeScreen(SCREEN_QOI, out, room, len);
+}
 
-    JsonDocument doc;
-    doc["voltage"] = sensors.batteryVoltage;
-    doc["percent"] = sensors.batteryPercent;
-    doc["isCharging"] = sensors.isCharging;
+void sendScreenPng(HttpRequest& request) {
+    sendScreen(request, SCREEN_PNG);
+}
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+void sendScreenQoi(HttpRequest& request) {
+    sendScreen(request, SCREEN_QOI);
 }
 
-String handleWifiScan() {
-    int n = WiFi.scanNetworks();
+// ============================================================================
+// Routes (one table for HTTP and the tunnel, hashed at compile time)
+// ============================================================================
 
-    JsonDocument doc;
-    JsonArray networks = doc["networks"].to<JsonArray>();
+constexpr RouteQuery DISPLAY_QUERY[] = {
+    {"text", "text", false, 0}
+};
+constexpr RouteQuery BUZZER_QUERY[] = {
+    {"freq", "frequency", true, 1000},
+    {"duration", "duration", true, 100}
+};
 
-    for (int i = 0; i < n && i < 10; i++) {
-        JsonObject net = networks.add<JsonObject>();
-        net["ssid"] = WiFi.SSID(i);
-        net["rssi"] = WiFi.RSSI(i);
-        net["channel"] = WiFi.channel(i);
-    }
+constexpr RouteDef ROUTES[] = {
+    routeCard("/.well-known/agent.json"),
+    // A2A JSON-RPC endpoint (/rpc is what peers' executeSkill() calls)
+    routeRpc("/a2a"),
+    routeRpc("/rpc"),
+    routeSkill("/api/sensors", "sensors/read"),
+    routeSkill("/api/sensors/features", "sensors/features"),
+    routeSkill("/api/buttons", "button/status"),
+    routeSkill("/api/battery", "battery/status"),
+    routeSkill("/api/wifi/scan", "wifi/scan"),
+    routeSkill("/api/display", "display/show", DISPLAY_QUERY),
+    routeSkill("/api/buzzer", "buzzer/tone", BUZZER_QUERY),
+    // Encoding takes tens of milliseconds, so the tunnel runs them on its worker
+    routeRaw("/api/screen.png", "image/png", writeScreenPng, sendScreenPng, true),
+    routeRaw("/api/screen.qoi", "image/qoi", writeScreenQoi, sendScreenQoi, true),
+    // Dashboard and chat app, built from web/ by scripts/web-assets.py
+    routePage("/", "text/html", WEB_INDEX_HTML, WEB_INDEX_HTML_GZ, WEB_INDEX_HTML_ETAG),
+    routePage("/chat", "text/html", WEB_CHAT_HTML, WEB_CHAT_HTML_GZ, WEB_CHAT_HTML_ETAG)
+};
+constexpr RouteMatcher<ROUTE_COUNT(ROUTES)> routeTable(ROUTES);
+static_assert(routeTable.valid(), "Route paths must be unique");
 
-    doc["count"] = n;
+// Every path in ROUTES, found with one hash lookup
+RouteHandler routeHandler(routeTable, rpc, agentCard, A2A_MAX_BODY);
+HttpServer server(HTTP_PORT, routeHandler);
 
-    String output;
-    serializeJson(doc, output);
-    return output;
-}
+TunnelRouter tunnelRouter(routeTable, SKILLS, SKILL_COUNT(SKILLS), agentCard, &tunnelScratch);
+// Slow skills run on the worker task, with documents from the heap
+TunnelRouter tunnelJobRouter(routeTable, SKILLS, SKILL_COUNT(SKILLS), agentCard);
+TunnelScheduler tunnelScheduler(tunnelJobRouter, tunnelJobFrame + WEBSOCKETS_MAX_HEADER_SIZE, TUNNEL_FRAME_MAX);
 
-// Animated message display with voxel-style effects
-void drawVoxelEffect() {
-    // Draw animated voxel-style background
-    for (int i = 0; i < 20; i++) {
-        int x = random(0, 135);
-        int y = random(0, 240);
-        int size = random(2, 8);
-        uint16_t colors[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_GREEN, TFT_BLUE};
-        uint16_t color = colors[random(0, 5)];
-        M5.Display.fillRect(x, y, size, size, color);
-    }
-}
+// ============================================================================
+// IMU Streaming (ws://<ip>/ws/imu?rate=<Hz>&batch=<samples>)
+// ============================================================================
 
-void animateMessageIn(const String& text) {
-    // Play A minor arpeggio intro
-    M5.Speaker.tone(AMIN_ARPEGGIO[0], 40);
-
-    // Wild color particle burst
-    for (int wave = 0; wave < 2; wave++) {
-        for (int i = 0; i < 30; i++) {
-            int x = random(0, 240);
-            int y = random(0, 135);
-            int size = random(2, 8);
-            uint16_t wildColors[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_GREEN, TFT_WHITE};
-            M5.Display.fillRect(x, y, size, size, wildColors[random(0, 5)]);
+// On the async_tcp task: hand the client a slot, or turn it away
+void imuSocketEvent(WebSocketChannel& socket, uint32_t client, WebSocketEvent event, HttpRequest* request) {
+    if (event == WS_EVENT_CONNECT) {
+        for (ImuStreamSlot& slot : imuStreams) {
+            uint8_t free = IMU_SLOT_FREE;
+            if (!slot.state.compare_exchange_strong(free, IMU_SLOT_CLAIMED)) continue;
+            char value[12];
+            long rate = request->param("rate", value, sizeof(value)) ? atol(value) : IMU_SAMPLE_HZ;
+            long batch = request->param("batch", value, sizeof(value)) ? atol(value) : 0;
+            slot.client = client;
+            slot.rate = constrain(rate, 0, IMU_SAMPLE_HZ);
+            slot.batch = constrain(batch, 0, IMU_STREAM_BATCH_MAX);
+            slot.state = IMU_SLOT_OPENING;
+            return;
         }
-        if (wave < ARPEGGIO_LEN) {
-            M5.Speaker.tone(AMIN_ARPEGGIO[wave], 40);
+        socket.close(client, 1013, "Too many IMU streams");
+    } else if (event == WS_EVENT_DISCONNECT) {
+        for (ImuStreamSlot& slot : imuStreams) {
+            uint8_t state = slot.state.load();
+            // loop() may turn OPENING into ACTIVE meanwhile: try again with that
+            while ((state == IMU_SLOT_OPENING || state == IMU_SLOT_ACTIVE) && slot.client == client) {
+                if (slot.state.compare_exchange_weak(state, IMU_SLOT_CLOSING)) break;
+            }
         }
-        delay(50);
-    }
-
-    // Quick scanline wipe
-    for (int x = 0; x < 240; x += 8) {
-        M5.Display.fillRect(x, 0, 8, 135, TFT_BLACK);
-        delay(3);
     }
+}
 
-    // SuprPosition fly-in (quick version)
-    const char* brand = "SuprPosition";
-    for (int frame = -100; frame <= 55; frame += 15) {
-        // Trail
-        if (frame > -80) {
-            M5.Display.setTextColor(TFT_BLUE);
-            M5.Display.setTextSize(2);
-            M5.Display.setCursor(frame - 15, 55);
-            M5.Display.print(brand);
-        }
-        // Main
-        uint16_t flyColors[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_WHITE};
-        M5.Display.setTextColor(flyColors[(frame/15) % 4]);
-        M5.Display.setCursor(frame, 55);
-        M5.Display.print(brand);
-        // Clear trail
-        if (frame > -80) {
-            M5.Display.fillRect(frame - 30, 50, 15, 30, TFT_BLACK);
-        }
-        // Arpeggio notes
-        int noteIdx = (frame + 100) / 25;
-        if (noteIdx >= 0 && noteIdx < ARPEGGIO_LEN && (frame % 25 == 0)) {
-            M5.Speaker.tone(AMIN_ARPEGGIO[noteIdx], 50);
+// From loop(): start new streams, free closed ones, and send every frame that
+// is ready while the client's queue has room. A client that cannot keep up
+// stops being polled; its stream then drops the oldest samples.
+void pumpImuStreams() {
+    for (ImuStreamSlot& slot : imuStreams) {
+        uint8_t state = slot.state.load();
+        if (state == IMU_SLOT_OPENING) {
+            slot.stream.begin(imuSamples, IMU_SAMPLE_HZ, slot.rate, slot.batch);
+            slot.state.compare_exchange_strong(state, IMU_SLOT_ACTIVE);
+        } else if (state == IMU_SLOT_CLOSING) {
+            slot.state = IMU_SLOT_FREE;
+        } else if (state == IMU_SLOT_ACTIVE) {
+            size_t len;
+            while (imuSocket.availableForWrite(slot.client, IMU_STREAM_FRAME_MAX) &&
+                   (len = slot.stream.poll(imuStreamFrame)) > 0) {
+                imuSocket.binary(slot.client, imuStreamFrame, len);
+            }
         }
-        delay(15);
     }
-
-    // Final flash
-    M5.Display.fillScreen(TFT_WHITE);
-    M5.Speaker.tone(440, 60);
-    delay(30);
-    M5.Display.fillScreen(TFT_BLACK);
-
-    // Draw cyber border
-    M5.Display.drawRect(0, 0, 240, 135, TFT_CYAN);
-    M5.Display.drawRect(2, 2, 236, 131, TFT_MAGENTA);
-
-    // Animated header
-    M5.Display.setTextColor(TFT_BLACK);
-    M5.Display.fillRect(5, 5, 230, 18, TFT_CYAN);
-    M5.Display.setTextSize(1);
-    M5.Display.setCursor(60, 10);
-    M5.Display.print(">> INCOMING MSG <<");
-
-    M5.Speaker.tone(330, 50);
 }
 
-String handleDisplayShow(const String& text) {
-    // Animated cyber-punk style message display
-    animateMessageIn(text);
-
-    // Display message with glow effect
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setTextSize(2);
-
-    // Word wrap for small screen
-    String remaining = text;
-    int y = 40;
-    while (remaining.length() > 0 && y < 200) {
-        int lineLen = min((int)remaining.length(), 10);
-        // Glow effect - draw shadow first
-        M5.Display.setTextColor(TFT_BLUE);
-        M5.Display.setCursor(11, y + 1);
-        M5.Display.println(remaining.substring(0, lineLen));
-        // Main text
-        M5.Display.setTextColor(TFT_WHITE);
-        M5.Display.setCursor(10, y);
-        M5.Display.println(remaining.substring(0, lineLen));
-        remaining = remaining.substring(lineLen);
-        y += 22;
+// Re-serialize the agent card if identity or address changed
+void refreshAgentCard() {
+    agentCardDirty = false;
+    if (WiFi.status() == WL_CONNECTED) {
+        deviceIP = WiFi.localIP().toString();
     }
 
-    // Add some voxel decorations
-    for (int i = 0; i < 15; i++) {
-        int x = random(5, 130);
-        int py = random(y + 10, 230);
-        int size = random(2, 5);
-        uint16_t color = (random(0, 2) == 0) ? TFT_CYAN : TFT_MAGENTA;
-        M5.Display.fillRect(x, py, size, size, color);
+    String url = mdnsStarted ? "http://" + deviceHostname + ".local" : "http://" + deviceIP;
+
+    AgentCardInfo info;
+    info.name = deviceName.c_str();
+    info.handle = deviceHandle.c_str();
+    info.deviceId = deviceId.c_str();
+    info.description = "M5StickC Plus 2 IoT device with sensors, display, IR, and controls";
+    info.url = url.c_str();
+    info.version = AGENT_VERSION;
+    info.skills = SKILLS;
+    info.skillCount = SKILL_COUNT(SKILLS);
+
+    if (agentCard.update(info)) {
+        Serial.printf("Agent card rev %u: %u bytes, ETag %s\n",
+                      (unsigned)agentCard.revision(), (unsigned)agentCard.length(), agentCard.etag());
     }
-
-    // Confirmation sound
-    M5.Speaker.tone(1200, 50);
-    delay(60);
-    M5.Speaker.tone(1800, 50);
-
-    // Set flag to keep message displayed
-    showingMessage = true;
-    messageDisplayTime = millis();
-
-    JsonDocument doc;
-    doc["success"] = true;
-    doc["displayed"] = text;
-
-    String output;
-    serializeJson(doc, output);
-    return output;
 }
 
-String handleBuzzerTone(int freq, int duration) {
-    M5.Speaker.tone(freq, duration);
+// ============================================================================
+// WebSocket Tunnel (for external access via registry relay)
+// ============================================================================
 
-    JsonDocument doc;
-    doc["success"] = true;
-    doc["frequency"] = freq;
-    doc["duration"] = duration;
+// Start of the frame body in tunnelFrame
+uint8_t* tunnelPayload() {
+    return tunnelFrame + WEBSOCKETS_MAX_HEADER_SIZE;
+}
 
-    String output;
-    serializeJson(doc, output);
-    return output;
+// Send len bytes encoded after the header room at frame; the library
+// writes its header into that room
+bool sendTunnelFrame(uint8_t* frame, size_t len, bool binary) {
+    if (len == 0) return false;
+    return binary ? webSocket.sendBIN(frame, len, true) : webSocket.sendTXT(frame, len, true);
 }
 
-// ============================================================================
-// WebSocket Tunnel (for external access via registry relay)
-// ============================================================================
+// Send the len bytes at tunnelPayload() in the negotiated encoding
+bool sendTunnelFrame(size_t len) {
+    return sendTunnelFrame(tunnelFrame, len, tunnelCodec.binary());
+}
 
-// Process a request that came through the WebSocket tunnel
-String processTunnelRequest(const String& method, const String& path, const String& body) {
-    // Route the request to appropriate handler
-    if (path == "/.well-known/agent.json") {
-        return getAgentCard();
-    }
-    if (path == "/api/sensors") {
-        return handleSensorsRead();
+// Runs queued slow skills, one at a time, off the WebSocket callback
+void tunnelWorkerTask(void*) {
+    for (;;) {
+        // Woken by a new job or a sent response; the timeout covers a missed wake
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(50));
+        while (tunnelScheduler.runNext()) {}
     }
-    if (path == "/api/buttons") {
-        return handleButtonStatus();
-    }
-    if (path == "/api/battery") {
-        return handleBatteryStatus();
-    }
-    if (path.startsWith("/api/buzzer")) {
-        // Parse freq and duration from path query string
-        int freq = 1000, duration = 100;
-        int qPos = path.indexOf('?');
-        if (qPos > 0) {
-            String query = path.substring(qPos + 1);
-            int freqPos = query.indexOf("freq=");
-            if (freqPos >= 0) {
-                freq = query.substring(freqPos + 5).toInt();
-            }
-            int durPos = query.indexOf("duration=");
-            if (durPos >= 0) {
-                duration = query.substring(durPos + 9).toInt();
-            }
-        }
-        return handleBuzzerTone(freq, duration);
+}
+
+// Send a response the worker has finished, from the task owning the socket
+void sendTunnelJobResult() {
+    size_t len = tunnelScheduler.ready();
+    if (len == 0) return;
+    if (tunnelScheduler.failed()) {
+        Serial.println("[WS] Queued response did not fit a frame, answered 500");
     }
-    if (path.startsWith("/api/display")) {
-        int textPos = path.indexOf("text=");
-        if (textPos > 0) {
-            String text = path.substring(textPos + 5);
-            // URL decode basic chars
-            text.replace("%20", " ");
-            return handleDisplayShow(text);
-        }
+    // Responses for a dropped tunnel have nobody to go to
+    if (tunnelConnected) {
+        sendTunnelFrame(tunnelJobFrame, len, tunnelScheduler.binary());
     }
-
-    // Default 404
-    JsonDocument doc;
-    doc["error"] = "Not found";
-    doc["path"] = path;
-    String output;
-    serializeJson(doc, output);
-    return output;
+    tunnelScheduler.release();
+    xTaskNotifyGive(tunnelWorker);
 }
 
 void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
     switch (type) {
         case WStype_DISCONNECTED:
             tunnelConnected = false;
+            tunnelCodec.reset();
             Serial.println("[WS] Tunnel disconnected");
             break;
 
@@ -1326,52 +1245,47 @@ void webSocketEvent(WStype_t type, uint8_t * payload, size_t length) {
             Serial.println("[WS] Tunnel connected!");
             break;
 
-        case WStype_TEXT: {
-            String msg = String((char*)payload);
-            Serial.println("[WS] Received: " + msg.substring(0, 100));
-
-            JsonDocument doc;
-            DeserializationError error = deserializeJson(doc, msg);
-            if (error) {
-                Serial.println("[WS] JSON parse error");
+        case WStype_TEXT:
+        case WStype_BIN: {
+            // Parsed in place: msg points into payload, which is only valid
+            // for this callback. The length is used, never a terminator.
+            TunnelMessage msg;
+            if (!TunnelCodec::parse(payload, length, type == WStype_BIN, msg)) {
+                Serial.printf("[WS] Unparseable %u-byte frame\n", (unsigned)length);
                 break;
             }
 
-            String msgType = doc["type"] | "";
-
-            // Handle connection confirmation
-            if (msgType == "connected") {
-                Serial.println("[WS] Tunnel confirmed for: " + String(doc["handle"] | "unknown"));
+            // Handle connection confirmation, which also settles the framing
+            if (strcmp(msg.type, "connected") == 0) {
+                TunnelEncoding encoding = tunnelCodec.negotiate(msg.encoding);
+                Serial.printf("[WS] Tunnel confirmed for: %s (%s)\n", msg.handle[0] ? msg.handle : "unknown",
+                              encoding == TUNNEL_MSGPACK ? "MessagePack" : "JSON");
             }
 
             // Handle incoming request to relay
-            if (msgType == "request") {
-                String reqId = doc["id"] | "";
-                String method = doc["method"] | "GET";
-                String path = doc["path"] | "/";
-                String body = doc["body"] | "";
-
-                Serial.println("[WS] Request: " + method + " " + path);
-
-                // Process the request locally
-                String response = processTunnelRequest(method, path, body);
-
-                // Send response back through tunnel
-                JsonDocument respDoc;
-                respDoc["type"] = "response";
-                respDoc["id"] = reqId;
-                respDoc["status"] = 200;
-                respDoc["headers"]["Content-Type"] = "application/json";
-                respDoc["body"] = response;
-
-                String respStr;
-                serializeJson(respDoc, respStr);
-                webSocket.sendTXT(respStr);
-                Serial.println("[WS] Sent response for: " + reqId);
+            if (strcmp(msg.type, "request") == 0) {
+                Serial.printf("[WS] Request %s: %s %s\n", msg.id, msg.method, msg.path);
+                size_t len;
+                if (tunnelRouter.slow(msg)) {
+                    // Answered later under its id; fast requests go on meanwhile
+                    TunnelAdmission admission = tunnelScheduler.enqueue(msg, tunnelCodec.encoding());
+                    if (admission == TUNNEL_QUEUED) {
+                        xTaskNotifyGive(tunnelWorker);
+                        tunnelScratch.reset();
+                        break;
+                    }
+                    len = TunnelScheduler::reject(admission, msg, tunnelCodec, tunnelPayload(), TUNNEL_FRAME_MAX);
+                } else {
+                    len = tunnelRouter.handle(msg, tunnelCodec, tunnelPayload(), TUNNEL_FRAME_MAX);
+                }
+                tunnelScratch.reset();
+                if (!sendTunnelFrame(len)) {
+                    Serial.printf("[WS] No response sent for: %s\n", msg.id);
+                }
             }
 
             // Handle heartbeat ack
-            if (msgType == "heartbeat_ack") {
+            if (strcmp(msg.type, "heartbeat_ack") == 0) {
                 Serial.println("[WS] Heartbeat acknowledged");
             }
             break;
@@ -1407,7 +1321,13 @@ void connectTunnel() {
     String host = url.substring(0, colonPos > 0 ? colonPos : url.length());
     int port = colonPos > 0 ? url.substring(colonPos + 1).toInt() : 80;
 
-    String wsPath = "/tunnel?handle=" + deviceHandle;
+    // Slow skills relayed through the tunnel run here, next to loop() on its core
+    if (!tunnelWorker) {
+        xTaskCreatePinnedToCore(tunnelWorkerTask, "tunnel", 8192, nullptr, 1, &tunnelWorker, ARDUINO_RUNNING_CORE);
+    }
+
+    // Ask for MessagePack framing; registries that ignore it stay on JSON
+    String wsPath = "/tunnel?handle=" + deviceHandle + TUNNEL_ENCODING_QUERY;
 
     Serial.println("[WS] Connecting tunnel to " + host + ":" + String(port) + wsPath);
 
@@ -1426,9 +1346,7 @@ void sendTunnelHeartbeat() {
     doc["type"] = "heartbeat";
     doc["handle"] = deviceHandle;
 
-    String msg;
-    serializeJson(doc, msg);
-    webSocket.sendTXT(msg);
+    sendTunnelFrame(tunnelCodec.encodeMessage(doc.as<JsonVariantConst>(), tunnelPayload(), TUNNEL_FRAME_MAX));
 }
 
 // ============================================================================
@@ -1514,392 +1432,23 @@ void connectWiFi() {
 // ============================================================================
 
 void setupServer() {
-    // Agent Card endpoint (A2A discovery)
-    server.on("/.well-known/agent.json", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", getAgentCard());
-    });
-
-    // API endpoints
-    server.on("/api/sensors", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", handleSensorsRead());
-    });
-
-    server.on("/api/buttons", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", handleButtonStatus());
-    });
-
-    server.on("/api/battery", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", handleBatteryStatus());
-    });
-
-    server.on("/api/wifi/scan", HTTP_GET, [](AsyncWebServerRequest *request) {
-        request->send(200, "application/json", handleWifiScan());
-    });
-
-    server.on("/api/display", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String text = request->getParam("text")->value();
-        request->send(200, "application/json", handleDisplayShow(text));
-    });
-
-    server.on("/api/buzzer", HTTP_GET, [](AsyncWebServerRequest *request) {
-        int freq = request->hasParam("freq") ? request->getParam("freq")->value().toInt() : 1000;
-        int duration = request->hasParam("duration") ? request->getParam("duration")->value().toInt() : 100;
-        request->send(200, "application/json", handleBuzzerTone(freq, duration));
-    });
-
-    // Simple web dashboard
-    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String html = "<!DOCTYPE html><html><head><title>NANDA Device</title>"
-            "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">"
-            "<style>"
-            "body{font-family:system-ui;max-width:600px;margin:0 auto;padding:20px;background:#1a1a2e;color:#eee}"
-            "h1{color:#00d4ff}"
-            ".card{background:#16213e;border-radius:8px;padding:15px;margin:10px 0}"
-            ".label{color:#888;font-size:12px}"
-            ".value{font-size:24px;font-weight:bold}"
-            "button{background:#00d4ff;border:none;padding:10px 20px;border-radius:5px;cursor:pointer;margin:5px}"
-            "#sensors{display:grid;grid-template-columns:repeat(3,1fr);gap:10px}"
-            "</style></head><body>"
-            "<h1>NANDA M5Stick</h1>"
-            "<div class=\"card\"><div class=\"label\">Status</div><div class=\"value\" style=\"color:#0f0\">Online</div></div>"
-            "<div class=\"card\" id=\"sensors\">Loading...</div>"
-            "<div class=\"card\">"
-            "<button onclick=\"fetch('/api/buzzer?freq=1000&duration=100')\">Beep</button>"
-            "<button onclick=\"fetch('/api/display?text=Hello!')\">Hello</button>"
-            "<button onclick=\"location.reload()\">Refresh</button>"
-            "</div>"
-            "<script>"
-            "async function u(){"
-            "var s=await fetch('/api/sensors').then(r=>r.json());"
-            "var b=await fetch('/api/battery').then(r=>r.json());"
-            "document.getElementById('sensors').innerHTML="
-            "'<div><div class=label>Accel X</div><div>'+s.accelerometer.x.toFixed(2)+'</div></div>'"
-            "+'<div><div class=label>Accel Y</div><div>'+s.accelerometer.y.toFixed(2)+'</div></div>'"
-            "+'<div><div class=label>Accel Z</div><div>'+s.accelerometer.z.toFixed(2)+'</div></div>'"
-            "+'<div><div class=label>Temp</div><div>'+s.temperature.toFixed(1)+'C</div></div>'"
-            "+'<div><div class=label>Battery</div><div>'+b.percent+'%</div></div>'"
-            "+'<div><div class=label>Voltage</div><div>'+b.voltage.toFixed(2)+'V</div></div>';"
-            "}u();setInterval(u,2000);"
-            "</script></body></html>";
-        request->send(200, "text/html", html);
-    });
-
-    // Chat interface - mini app for talking to the device
-    server.on("/chat", HTTP_GET, [](AsyncWebServerRequest *request) {
-        String html = R"rawliteral(
-<!DOCTYPE html>
-<html>
-<head>
-    <title>SuprPosition Chat</title>
-    <meta name="viewport" content="width=device-width, initial-scale=1, maximum-scale=1">
-    <style>
-        * { box-sizing: border-box; margin: 0; padding: 0; }
-        body {
-            font-family: -apple-system, system-ui, sans-serif;
-            background: linear-gradient(135deg, #1a1a2e 0%, #16213e 100%);
-            min-height: 100vh;
-            color: #fff;
-        }
-        .header {
-            background: rgba(0,212,255,0.1);
-            padding: 15px;
-            text-align: center;
-            border-bottom: 1px solid rgba(0,212,255,0.3);
-        }
-        .header h1 {
-            font-size: 1.5em;
-            background: linear-gradient(90deg, #00d4ff, #ff00ff);
-            -webkit-background-clip: text;
-            -webkit-text-fill-color: transparent;
-        }
-        .header .status {
-            font-size: 0.8em;
-            color: #0f0;
-            margin-top: 5px;
-        }
-        .chat-container {
-            height: calc(100vh - 140px);
-            overflow-y: auto;
-            padding: 15px;
-        }
-        .message {
-            margin: 10px 0;
-            padding: 12px 16px;
-            border-radius: 18px;
-            max-width: 85%;
-            animation: fadeIn 0.3s ease;
-        }
-        @keyframes fadeIn {
-            from { opacity: 0; transform: translateY(10px); }
-            to { opacity: 1; transform: translateY(0); }
-        }
-        .message.user {
-            background: linear-gradient(135deg, #00d4ff, #0099cc);
-            margin-left: auto;
-            border-bottom-right-radius: 4px;
-        }
-        .message.device {
-            background: rgba(255,255,255,0.1);
-            border-bottom-left-radius: 4px;
-        }
-        .message.device::before {
-            content: '🤖 ';
-        }
-        .input-container {
-            position: fixed;
-            bottom: 0;
-            left: 0;
-            right: 0;
-            padding: 10px;
-            background: rgba(22,33,62,0.95);
-            border-top: 1px solid rgba(0,212,255,0.3);
-            display: flex;
-            gap: 10px;
-        }
-        #messageInput {
-            flex: 1;
-            padding: 12px 16px;
-            border: none;
-            border-radius: 25px;
-            background: rgba(255,255,255,0.1);
-            color: #fff;
-            font-size: 16px;
-            outline: none;
-        }
-        #messageInput::placeholder { color: rgba(255,255,255,0.5); }
-        #sendBtn {
-            width: 50px;
-            height: 50px;
-            border: none;
-            border-radius: 50%;
-            background: linear-gradient(135deg, #00d4ff, #ff00ff);
-            color: #fff;
-            font-size: 20px;
-            cursor: pointer;
-        }
-        .quick-actions {
-            display: flex;
-            gap: 8px;
-            padding: 10px 15px;
-            overflow-x: auto;
-        }
-        .quick-btn {
-            padding: 8px 16px;
-            border: 1px solid rgba(0,212,255,0.5);
-            border-radius: 20px;
-            background: transparent;
-            color: #00d4ff;
-            font-size: 14px;
-            white-space: nowrap;
-            cursor: pointer;
-        }
-        .quick-btn:active { background: rgba(0,212,255,0.2); }
-    </style>
-</head>
-<body>
-    <div class="header">
-        <h1>SuprPosition</h1>
-        <div class="status">● Connected to M5Stick</div>
-    </div>
-    <div class="quick-actions">
-        <button class="quick-btn" onclick="send('read sensors')">📊 Sensors</button>
-        <button class="quick-btn" onclick="send('battery status')">🔋 Battery</button>
-        <button class="quick-btn" onclick="send('beep')">🔔 Beep</button>
-        <button class="quick-btn" onclick="send('wifi scan')">📶 WiFi</button>
-    </div>
-    <div class="chat-container" id="chat"></div>
-    <div class="input-container">
-        <input type="text" id="messageInput" placeholder="Ask me anything..." autocomplete="off">
-        <button id="sendBtn" onclick="sendMessage()">→</button>
-    </div>
-    <script>
-        const chat = document.getElementById('chat');
-        const input = document.getElementById('messageInput');
-
-        function addMessage(text, isUser) {
-            const div = document.createElement('div');
-            div.className = 'message ' + (isUser ? 'user' : 'device');
-            div.textContent = text;
-            chat.appendChild(div);
-            chat.scrollTop = chat.scrollHeight;
-        }
-
-        async function send(text) {
-            if (!text.trim()) return;
-            addMessage(text, true);
-            input.value = '';
-
-            try {
-                const res = await fetch('/api/display?text=' + encodeURIComponent(text));
-                const data = await res.json();
-
-                // Also get a response based on the command
-                let response = '';
-                const lower = text.toLowerCase();
-
-                if (lower.includes('sensor') || lower.includes('temp')) {
-                    const s = await fetch('/api/sensors').then(r => r.json());
-                    response = `Temperature: ${s.temperature.toFixed(1)}°C\nAccel: X=${s.accelerometer.x.toFixed(2)}, Y=${s.accelerometer.y.toFixed(2)}, Z=${s.accelerometer.z.toFixed(2)}`;
-                } else if (lower.includes('battery') || lower.includes('power')) {
-                    const b = await fetch('/api/battery').then(r => r.json());
-                    response = `Battery: ${b.percent}% (${b.voltage.toFixed(2)}V)\nCharging: ${b.isCharging ? 'Yes' : 'No'}`;
-                } else if (lower.includes('beep') || lower.includes('tone')) {
-                    await fetch('/api/buzzer?freq=1000&duration=200');
-                    response = '🔔 Beep!';
-                } else if (lower.includes('wifi') || lower.includes('scan')) {
-                    const w = await fetch('/api/wifi/scan').then(r => r.json());
-                    response = `Found ${w.count} networks:\n` + w.networks.slice(0,5).map(n => `• ${n.ssid} (${n.rssi}dBm)`).join('\n');
-                } else if (lower.includes('button')) {
-                    const b = await fetch('/api/buttons').then(r => r.json());
-                    response = `Buttons: A=${b.btnA?'pressed':'released'}, B=${b.btnB?'pressed':'released'}`;
-                } else {
-                    response = `Displayed: "${data.displayed}"`;
-                }
-
-                addMessage(response, false);
-            } catch (e) {
-                addMessage('Error: ' + e.message, false);
-            }
-        }
-
-        function sendMessage() {
-            send(input.value);
-        }
-
-        input.addEventListener('keypress', e => {
-            if (e.key === 'Enter') sendMessage();
-        });
-
-        // Welcome message
-        addMessage('Hello! I\'m your M5Stick assistant. Ask me to read sensors, check battery, beep, or display something!', false);
-    </script>
-</body>
-</html>
-)rawliteral";
-        request->send(200, "text/html", html);
-    });
+    // Binary IMU samples, batched (see ImuStream.h for the frame format)
+    imuSocket.onEvent(imuSocketEvent);
+    server.addWebSocket(imuSocket);
 
     server.begin();
-    Serial.println("HTTP server started on port 80");
+    Serial.printf("HTTP server started on port %d\n", HTTP_PORT);
 }
 
 // ============================================================================
 // Main
 // ============================================================================
 
-// Epic startup animation with SuprPosition fly-in
-void playStartupAnimation() {
-    M5.Display.setRotation(1);
-    M5.Display.fillScreen(TFT_BLACK);
-
-    // Wild color particle explosion
-    for (int wave = 0; wave < 3; wave++) {
-        for (int i = 0; i < 50; i++) {
-            int x = random(0, 240);
-            int y = random(0, 135);
-            int size = random(3, 12);
-            uint16_t wildColors[] = {
-                TFT_RED, TFT_ORANGE, TFT_YELLOW, TFT_GREEN,
-                TFT_CYAN, TFT_BLUE, TFT_MAGENTA, TFT_WHITE
-            };
-            M5.Display.fillRect(x, y, size, size, wildColors[random(0, 8)]);
-        }
-        // Play arpeggio note with each wave
-        if (wave < ARPEGGIO_LEN) {
-            M5.Speaker.tone(AMIN_ARPEGGIO[wave], 80);
-        }
-        delay(100);
-    }
-
-    // Clear with scanline wipe
-    for (int x = 0; x < 240; x += 4) {
-        M5.Display.fillRect(x, 0, 4, 135, TFT_BLACK);
-        if (x % 20 == 0 && x/20 < ARPEGGIO_LEN) {
-            M5.Speaker.tone(AMIN_ARPEGGIO[x/20], 60);
-        }
-        delay(8);
-    }
-
-    // SuprPosition fly-in from left with trail effect
-    const char* brand = "SuprPosition";
-    int textLen = strlen(brand);
-
-    for (int frame = -120; frame <= 60; frame += 8) {
-        // Draw trailing ghost
-        if (frame > -100) {
-            M5.Display.setTextColor(TFT_BLUE);
-            M5.Display.setTextSize(2);
-            M5.Display.setCursor(frame - 20, 55);
-            M5.Display.print(brand);
-        }
-
-        // Draw main text
-        uint16_t flyColors[] = {TFT_CYAN, TFT_MAGENTA, TFT_YELLOW, TFT_WHITE};
-        M5.Display.setTextColor(flyColors[(frame/8) % 4]);
-        M5.Display.setTextSize(2);
-        M5.Display.setCursor(frame, 55);
-        M5.Display.print(brand);
-
-        // Clear trail
-        if (frame > -100) {
-            M5.Display.fillRect(frame - 40, 50, 20, 30, TFT_BLACK);
-        }
-
-        // Arpeggio during fly-in
-        int noteIdx = (frame + 120) / 30;
-        if (noteIdx >= 0 && noteIdx < ARPEGGIO_LEN && (frame % 30 == 0)) {
-            M5.Speaker.tone(AMIN_ARPEGGIO[noteIdx], 70);
-        }
-
-        delay(25);
-    }
-
-    // Final position with glow
-    M5.Display.fillScreen(TFT_BLACK);
-
-    // Draw voxel border
-    for (int i = 0; i < 30; i++) {
-        int x = random(0, 240);
-        int y = random(0, 135);
-        int size = random(2, 6);
-        uint16_t color = (random(0, 2) == 0) ? TFT_CYAN : TFT_MAGENTA;
-        M5.Display.fillRect(x, y, size, size, color);
-    }
-
-    // Glow effect
-    M5.Display.setTextColor(TFT_BLUE);
-    M5.Display.setTextSize(2);
-    M5.Display.setCursor(32, 56);
-    M5.Display.print(brand);
-    M5.Display.setCursor(28, 54);
-    M5.Display.print(brand);
-
-    // Main text
-    M5.Display.setTextColor(TFT_WHITE);
-    M5.Display.setCursor(30, 55);
-    M5.Display.print(brand);
-
-    // Final chord - A minor (A, C, E played together as sequence)
-    M5.Speaker.tone(220, 100);
-    delay(50);
-    M5.Speaker.tone(262, 100);
-    delay(50);
-    M5.Speaker.tone(330, 150);
-    delay(200);
-
-    // Tagline
-    M5.Display.setTextColor(TFT_GREEN);
-    M5.Display.setTextSize(1);
-    M5.Display.setCursor(70, 90);
-    M5.Display.print("NANDA IoT");
-
-    delay(1000);
-}
-
 void setup() {
     // Initialize M5Unified
     auto cfg = M5.config();
     M5.begin(cfg);
+    startSensorSampler();
 
     Serial.begin(115200);
     Serial.println("=== NANDA M5Stick Server ===");
@@ -1907,8 +1456,20 @@ void setup() {
     // Initialize preferences
     preferences.begin("nanda", false);
 
-    // Epic startup animation
-    playStartupAnimation();
+    // Back buffer for the menu screens and animations, sized for the rotated panel
+    M5.Display.setRotation(1);
+    if (!screenFrame.begin()) {
+        Serial.println("No room for a frame buffer, drawing screens directly");
+    }
+
+    // Epic startup animation (nothing else to serve yet, so play it out)
+    screenAnimation.onCue(playAnimationCue);
+    screenAnimation.setSurface(screenFrame.surface());
+    startStartupAnimation();
+    while (screenAnimation.running()) {
+        updateAnimation();
+        delay(1);
+    }
 
     // Generate device ID from MAC (before WiFi connect)
     WiFi.mode(WIFI_STA);
@@ -1922,6 +1483,10 @@ void setup() {
 
     // Connect to WiFi
     connectWiFi();
+    WiFi.onEvent([](WiFiEvent_t event, WiFiEventInfo_t info) {
+        agentCardDirty = true;  // New address: rebuild the card from loop()
+    }, ARDUINO_EVENT_WIFI_STA_GOT_IP);
+    refreshAgentCard();
 
     // Start HTTP server
     setupServer();
@@ -1942,7 +1507,12 @@ void setup() {
         M5.Display.setTextColor(TFT_YELLOW);
         M5.Display.println("Registering...");
 
-        if (registerWithRegistry()) {
+        setupRegistryClient();
+        registerWithRegistry();
+        bool tls = registryUrl.startsWith("https://");
+        waitForRegistry((tls ? REGISTRY_TLS_CONNECT_TIMEOUT : REGISTRY_CONNECT_TIMEOUT) + REGISTRY_IO_TIMEOUT);
+
+        if (registryConnected) {
             // Success! Show "INSTALLED" screen
             M5.Display.fillScreen(TFT_BLACK);
             M5.Display.setTextColor(TFT_GREEN);
@@ -2003,6 +1573,16 @@ void loop() {
 
     // Process WebSocket events (tunnel)
     webSocket.loop();
+    sendTunnelJobResult();
+    pumpImuStreams();
+    updateImuFeatures();
+
+    // Advance any in-flight registry request (never blocks)
+    registry.poll(millis());
+
+    if (agentCardDirty) {
+        refreshAgentCard();
+    }
 
     // Button B: Next item or next screen
     if (M5.BtnB.wasPressed()) {
@@ -2014,8 +1594,8 @@ void loop() {
                 selectedSkillIndex = (selectedSkillIndex + 1) % max(1, agentSkillCount);
             } else {
                 // Scroll through agents
-                if (discoveredAgentCount > 0) {
-                    selectedAgentIndex = (selectedAgentIndex + 1) % discoveredAgentCount;
+                if (agentDirectory.size() > 0) {
+                    selectedAgentIndex = (selectedAgentIndex + 1) % agentDirectory.size();
                 }
             }
             needsRedraw = true;
@@ -2055,10 +1635,10 @@ void loop() {
                         lastSkillResult = executeSkill(selectedAgentIndex, selectedSkillIndex);
 
                         // Show result briefly on device display too
-                        handleDisplayShow(lastSkillResult.substring(0, 50));
+                        showMessage(lastSkillResult.substring(0, 50).c_str());
                     }
                     needsRedraw = true;
-                } else if (discoveredAgentCount > 0 && selectedAgentIndex >= 0) {
+                } else if (agentDirectory.size() > 0 && selectedAgentIndex >= 0) {
                     // Select agent and fetch skills
                     M5.Display.fillScreen(TFT_BLACK);
                     M5.Display.setCursor(10, 50);
@@ -2078,10 +1658,8 @@ void loop() {
                     if (!registryConnected) {
                         registerWithRegistry();
                     }
+                    // Result arrives via onRegistryComplete()
                     discoverAgents();
-                    if (discoveredAgentCount > 0) {
-                        selectedAgentIndex = 0;
-                    }
                     needsRedraw = true;
                 }
                 break;
@@ -2094,9 +1672,8 @@ void loop() {
                 needsRedraw = true;
                 break;
             case MENU_FX:
-                // Play the startup animation
-                playStartupAnimation();
-                needsRedraw = true;
+                // Play the startup animation (redraws the menu when done)
+                startStartupAnimation();
                 break;
             case MENU_HOME:
                 // Refresh home screen and trigger heartbeat
@@ -2104,8 +1681,7 @@ void loop() {
                 needsRedraw = true;
                 break;
             default:
-                // Force sensor update and redraw
-                updateSensors();
+                // Redraw with the newest samples
                 needsRedraw = true;
                 break;
         }
@@ -2117,8 +1693,12 @@ void loop() {
         needsRedraw = true;  // Return to normal screen
     }
 
-    // Redraw screen if needed (but not while showing a message)
-    if (needsRedraw && !showingMessage) {
+    // Advance a running animation by at most one frame
+    updateAnimation();
+
+    // Redraw screen if needed (but not while an animation or message is up)
+    if (needsRedraw && !showingMessage && !screenAnimation.running()) {
+        screenCompositor.invalidate();  // Animations and status text drew over the last frame
         drawCurrentScreen();
         needsRedraw = false;
     }
@@ -2150,10 +1730,11 @@ void loop() {
         }
     }
 
-    // Auto-refresh for sensor/discovery screens
+    // Auto-refresh for sensor/discovery screens (only the changed fields are
+    // pushed, so leave a message or animation on the panel alone)
     static unsigned long lastAutoRefresh = 0;
-    if (currentScreen == MENU_SENSORS || currentScreen == MENU_BATTERY ||
-        currentScreen == MENU_DISCOVERY) {
+    if ((currentScreen == MENU_SENSORS || currentScreen == MENU_BATTERY ||
+         currentScreen == MENU_DISCOVERY) && !showingMessage && !screenAnimation.running()) {
         if (millis() - lastAutoRefresh > 500) {
             drawCurrentScreen();
             lastAutoRefresh = millis();
@@ -0,0 +1,13 @@
+/**
+ * Monotonic milliseconds for the host tests, in place of millis().
+ */
+
+#pragma once
+
+#include <chrono>
+#include <stdint.h>
+
+static uint32_t nowMs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
@@ -0,0 +1,64 @@
+/**
+ * ArduinoJson allocator that tracks live bytes, peak bytes and call
+ * counts, for heap benchmarks on the native host build.
+ */
+
+#pragma once
+
+#include <ArduinoJson.h>
+#include <stdlib.h>
+
+class CountingAllocator : public ArduinoJson::Allocator {
+public:
+    void* allocate(size_t size) override {
+        size_t* p = (size_t*)malloc(size + sizeof(size_t));
+        if (!p) return nullptr;
+        *p = size;
+        track(size);
+        allocations++;
+        return p + 1;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!ptr) return;
+        size_t* p = (size_t*)ptr - 1;
+        current -= *p;
+        free(p);
+    }
+
+    void* reallocate(void* ptr, size_t size) override {
+        if (!ptr) return allocate(size);
+        size_t* p = (size_t*)ptr - 1;
+        size_t old = *p;
+        // On failure the old block is still ArduinoJson's, and still counted
+        size_t* q = (size_t*)realloc(p, size + sizeof(size_t));
+        if (!q) return nullptr;
+        p = q;
+        current -= old;
+        *p = size;
+        track(size);
+        reallocations++;
+        return p + 1;
+    }
+
+    // Account for memory held outside ArduinoJson (e.g. a response String)
+    void hold(size_t size) { track(size); }
+    void release(size_t size) { current -= size; }
+
+    void resetCounters() {
+        peak = current;
+        allocations = 0;
+        reallocations = 0;
+    }
+
+    size_t current = 0;
+    size_t peak = 0;
+    size_t allocations = 0;
+    size_t reallocations = 0;
+
+private:
+    void track(size_t size) {
+        current += size;
+        if (current > peak) peak = current;
+    }
+};
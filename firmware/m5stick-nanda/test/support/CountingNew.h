@@ -0,0 +1,32 @@
+/**
+ * Global operator new and delete that count calls and bytes, for the
+ * host benchmarks that prove a path never touches the heap. They replace
+ * the program's own, so include this from one test's test_main.cpp only.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <new>
+#include <stdlib.h>
+
+static std::atomic<size_t> heapAllocs(0);
+static std::atomic<size_t> heapBytes(0);
+
+static void* countedAlloc(size_t size) {
+    heapAllocs++;
+    heapBytes += size;
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+// The array forms too, or GCC sees new[] memory reach free() through the
+// library's own operator delete[] (-Wmismatched-new-delete)
+void* operator new(size_t size) { return countedAlloc(size); }
+void* operator new[](size_t size) { return countedAlloc(size); }
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
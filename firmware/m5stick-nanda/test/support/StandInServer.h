@@ -0,0 +1,160 @@
+/**
+ * Loopback stand-in HTTP server for the native host tests.
+ *
+ * Listens on a loopback address (127.0.0.1 and an ephemeral port by
+ * default; any 127.x.y.z works on Linux), answers every request
+ * with a canned response after an optional injected delay, and records the
+ * requests it saw. Stall mode accepts connections and never answers, which
+ * is how a wedged registry looks from the device.
+ */
+
+#pragma once
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class StandInServer {
+public:
+    StandInServer() : _fd(-1), _port(0), _running(false), _delayMs(0), _stall(false) {
+        respondJson(200, "{\"status\":\"ok\"}");
+    }
+
+    ~StandInServer() { stop(); }
+
+    bool start(uint16_t port = 0, const char* addr = "127.0.0.1") {
+        _fd = socket(AF_INET, SOCK_STREAM, 0);
+        int one = 1;
+        setsockopt(_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        sockaddr_in sin = {};
+        sin.sin_family = AF_INET;
+        sin.sin_port = htons(port);
+        inet_pton(AF_INET, addr, &sin.sin_addr);
+        if (bind(_fd, (sockaddr*)&sin, sizeof(sin)) != 0 || listen(_fd, 64) != 0) {
+            ::close(_fd);
+            _fd = -1;
+            return false;
+        }
+
+        socklen_t len = sizeof(sin);
+        getsockname(_fd, (sockaddr*)&sin, &len);
+        _port = ntohs(sin.sin_port);
+        _addr = addr;
+        _running = true;
+        _acceptThread = std::thread([this] { acceptLoop(); });
+        return true;
+    }
+
+    void stop() {
+        if (!_running) return;
+        _running = false;
+        _acceptThread.join();
+        for (auto& t : _workers) t.join();
+        _workers.clear();
+        ::close(_fd);
+        _fd = -1;
+    }
+
+    void respond(const std::string& raw) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _response = raw;
+    }
+
+    void respondJson(int status, const std::string& body) {
+        respond("HTTP/1.1 " + std::to_string(status) + " X\r\n"
+                "Content-Type: application/json\r\n"
+                "Content-Length: " + std::to_string(body.size()) + "\r\n"
+                "Connection: close\r\n\r\n" + body);
+    }
+
+    void setDelay(int ms) { _delayMs = ms; }
+    void setStall(bool stall) { _stall = stall; }
+
+    uint16_t port() const { return _port; }
+    std::string url() const { return "http://" + _addr + ":" + std::to_string(_port); }
+
+    size_t requestCount() {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _requests.size();
+    }
+
+    std::string request(size_t i) {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return i < _requests.size() ? _requests[i] : std::string();
+    }
+
+private:
+    void acceptLoop() {
+        while (_running) {
+            pollfd pfd = {_fd, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            int client = accept(_fd, nullptr, nullptr);
+            if (client < 0) continue;
+            _workers.emplace_back([this, client] { serve(client); });
+        }
+    }
+
+    void serve(int client) {
+        std::string req;
+        char buf[1024];
+        while (_running && !requestComplete(req)) {
+            pollfd pfd = {client, POLLIN, 0};
+            if (poll(&pfd, 1, 20) <= 0) continue;
+            ssize_t n = recv(client, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            req.append(buf, n);
+        }
+
+        std::string response;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _requests.push_back(req);
+            response = _response;
+        }
+
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(_delayMs);
+        while (_running && (_stall || std::chrono::steady_clock::now() < until)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        if (_running) {
+            size_t sent = 0;
+            while (sent < response.size()) {
+                ssize_t n = send(client, response.data() + sent, response.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) break;
+                sent += n;
+            }
+        }
+        ::close(client);
+    }
+
+    static bool requestComplete(const std::string& req) {
+        size_t end = req.find("\r\n\r\n");
+        if (end == std::string::npos) return false;
+        size_t cl = req.find("Content-Length:");
+        if (cl == std::string::npos || cl > end) return true;
+        return req.size() >= end + 4 + (size_t)atoi(req.c_str() + cl + 15);
+    }
+
+    int _fd;
+    uint16_t _port;
+    std::string _addr;
+    std::atomic<bool> _running;
+    std::atomic<int> _delayMs;
+    std::atomic<bool> _stall;
+    std::thread _acceptThread;
+    std::vector<std::thread> _workers;
+    std::mutex _mutex;
+    std::string _response;
+    std::vector<std::string> _requests;
+};
@@ -0,0 +1,195 @@
+/**
+ * Host tests and allocation microbenchmark for the cached agent card.
+ *
+ * The benchmark serves the card many times, first the old way (build a
+ * JsonDocument and serialize it into a fresh string per request), then
+ * from AgentCard, counting ArduinoJson and operator new allocations.
+ *
+ *   pio test -e native -f test_agent_card
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include <AgentCard.h>
+
+#include "../support/CountingAllocator.h"
+#include "../support/CountingNew.h"
+
+static const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", nullptr},
+    {"display/show", "Show on Display", "Display text on LCD", nullptr},
+    {"button/status", "Button Status", "Get current button states", nullptr},
+    {"buzzer/tone", "Play Tone", "Play a tone on the buzzer", nullptr},
+    {"battery/status", "Battery Status", "Get battery voltage and percentage", nullptr},
+    {"wifi/scan", "Scan WiFi", "Scan for nearby WiFi networks", nullptr}
+};
+
+static AgentCardInfo makeInfo(const char* url) {
+    AgentCardInfo info;
+    info.name = "M5Stick a1b2c3";
+    info.handle = "m5stick-a1b2c3";
+    info.deviceId = "a1b2c3d4e5f6";
+    info.description = "M5StickC Plus 2 IoT device with sensors, display, IR, and controls";
+    info.url = url;
+    info.version = "1.0.0";
+    info.skills = SKILLS;
+    info.skillCount = sizeof(SKILLS) / sizeof(SKILLS[0]);
+    return info;
+}
+
+// The pre-cache getAgentCard(): a document and a new string per request
+static std::string buildCardPerRequest(const AgentCardInfo& info, ArduinoJson::Allocator* allocator) {
+    JsonDocument doc(allocator);
+    doc["name"] = info.name;
+    doc["handle"] = info.handle;
+    doc["deviceId"] = info.deviceId;
+    doc["description"] = info.description;
+    doc["url"] = std::string(info.url);   // Built with String concatenation
+    doc["version"] = info.version;
+    doc["defaultInputModes"].to<JsonArray>().add("application/json");
+    doc["defaultOutputModes"].to<JsonArray>().add("application/json");
+    JsonObject caps = doc["capabilities"].to<JsonObject>();
+    caps["streaming"] = false;
+    caps["pushNotifications"] = false;
+    JsonArray skills = doc["skills"].to<JsonArray>();
+    for (size_t i = 0; i < info.skillCount; i++) {
+        JsonObject skill = skills.add<JsonObject>();
+        skill["id"] = info.skills[i].id;
+        skill["name"] = info.skills[i].name;
+        skill["description"] = info.skills[i].description;
+    }
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_card_matches_inputs(void) {
+    AgentCard card;
+    TEST_ASSERT_FALSE(card.valid());
+    TEST_ASSERT_TRUE(card.update(makeInfo("http://m5stick-a1b2c3.local")));
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(deserializeJson(doc, card.json(), card.length()));
+    TEST_ASSERT_EQUAL_STRING("m5stick-a1b2c3", doc["handle"]);
+    TEST_ASSERT_EQUAL_STRING("http://m5stick-a1b2c3.local", doc["url"]);
+    TEST_ASSERT_EQUAL(6, (int)doc["skills"].size());
+    TEST_ASSERT_EQUAL_STRING("wifi/scan", doc["skills"][5]["id"]);
+    TEST_ASSERT_FALSE(doc["capabilities"]["streaming"].as<bool>());
+
+    // Byte-identical to what the per-request builder produced
+    std::string old = buildCardPerRequest(makeInfo("http://m5stick-a1b2c3.local"),
+                                          ArduinoJson::detail::DefaultAllocator::instance());
+    TEST_ASSERT_EQUAL_STRING(old.c_str(), card.json());
+}
+
+void test_rebuilds_only_when_inputs_change(void) {
+    AgentCard card;
+    TEST_ASSERT_TRUE(card.update(makeInfo("http://192.168.1.20")));
+    std::string etag = card.etag();
+    const char* previous = card.json();
+
+    // Same values from different buffers: nothing to do
+    char sameUrl[] = "http://192.168.1.20";
+    TEST_ASSERT_FALSE(card.update(makeInfo(sameUrl)));
+    TEST_ASSERT_EQUAL(1, (int)card.revision());
+
+    // New address after a DHCP renewal
+    TEST_ASSERT_TRUE(card.update(makeInfo("http://192.168.1.77")));
+    TEST_ASSERT_EQUAL(2, (int)card.revision());
+    TEST_ASSERT_FALSE(etag == card.etag());
+    // The previous buffer is left intact for responses still sending it
+    TEST_ASSERT_NOT_NULL(strstr(previous, "192.168.1.20"));
+    TEST_ASSERT_NOT_NULL(strstr(card.json(), "192.168.1.77"));
+}
+
+void test_if_none_match(void) {
+    AgentCard card;
+    TEST_ASSERT_FALSE(card.notModified("*"));   // Nothing to match yet
+    card.update(makeInfo("http://192.168.1.20"));
+
+    std::string etag = card.etag();
+    TEST_ASSERT_EQUAL('"', etag.front());
+    TEST_ASSERT_TRUE(card.notModified(etag.c_str()));
+    TEST_ASSERT_TRUE(card.notModified(("W/" + etag).c_str()));
+    TEST_ASSERT_TRUE(card.notModified(("\"deadbeef\", " + etag).c_str()));
+    TEST_ASSERT_TRUE(card.notModified("*"));
+    TEST_ASSERT_FALSE(card.notModified("\"deadbeef\""));
+    TEST_ASSERT_FALSE(card.notModified(etag.substr(0, etag.size() - 1).c_str()));
+    TEST_ASSERT_FALSE(card.notModified(""));
+    TEST_ASSERT_FALSE(card.notModified(nullptr));
+
+    card.update(makeInfo("http://192.168.1.77"));
+    TEST_ASSERT_FALSE(card.notModified(etag.c_str()));
+}
+
+void test_oversized_card_keeps_previous(void) {
+    AgentCard card;
+    card.update(makeInfo("http://192.168.1.20"));
+    std::string before = card.json();
+
+    std::string huge(AGENT_CARD_MAX, 'x');
+    huge = "http://" + huge;
+    TEST_ASSERT_FALSE(card.update(makeInfo(huge.c_str())));
+    TEST_ASSERT_EQUAL_STRING(before.c_str(), card.json());
+    TEST_ASSERT_EQUAL(1, (int)card.revision());
+}
+
+void test_benchmark_allocations_per_request(void) {
+    const int requests = 10000;
+    using clock = std::chrono::steady_clock;
+    std::string url = "http://m5stick-a1b2c3.local";
+    AgentCardInfo info = makeInfo(url.c_str());
+
+    CountingAllocator before;
+    size_t newsBefore = heapAllocs;
+    size_t bytes = 0;
+    auto t0 = clock::now();
+    for (int i = 0; i < requests; i++) {
+        std::string body = buildCardPerRequest(info, &before);
+        bytes += body.size();
+    }
+    double beforeUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / requests;
+    double beforeAllocs = (double)(before.allocations + before.reallocations + heapAllocs - newsBefore) / requests;
+
+    CountingAllocator after;
+    AgentCard card(&after);
+    card.update(info);
+    after.resetCounters();
+    size_t newsAfter = heapAllocs;
+    t0 = clock::now();
+    for (int i = 0; i < requests; i++) {
+        // Worst case: the inputs are revalidated on every request
+        card.update(info);
+        bytes += card.length();
+    }
+    double afterUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / requests;
+    double afterAllocs = (double)(after.allocations + after.reallocations + heapAllocs - newsAfter) / requests;
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%d requests, %u-byte card | before: %.1f allocs, %.2f us per request | after: %.1f allocs, %.2f us",
+             requests, (unsigned)card.length(), beforeAllocs, beforeUs, afterAllocs, afterUs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(bytes > 0);
+    TEST_ASSERT_TRUE(beforeAllocs >= 1.0);
+    TEST_ASSERT_EQUAL(0, (int)(after.allocations + after.reallocations));
+    TEST_ASSERT_EQUAL(0, (int)(heapAllocs - newsAfter));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_card_matches_inputs);
+    RUN_TEST(test_rebuilds_only_when_inputs_change);
+    RUN_TEST(test_if_none_match);
+    RUN_TEST(test_oversized_card_keeps_previous);
+    RUN_TEST(test_benchmark_allocations_per_request);
+    return UNITY_END();
+}
@@ -0,0 +1,237 @@
+/**
+ * Host tests and churn benchmark for AgentDirectory.
+ *
+ * The benchmark runs discovery passes over a registry of 1,000 agents
+ * whose membership drifts between passes, through a directory far smaller
+ * than the registry, and reports per-upsert latency and the fixed memory
+ * footprint. Heap allocations are counted to prove the directory never
+ * touches the heap.
+ *
+ *   pio test -e native -f test_agent_directory
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <set>
+#include <string>
+
+#include <AgentDirectory.h>
+
+#include "../support/CountingNew.h"
+
+static AgentDirectory dir;
+
+static std::string handleOf(int i) { return "agent-" + std::to_string(i); }
+static std::string urlOf(int i) {
+    return "http://10.0." + std::to_string(i / 250) + "." + std::to_string(i % 250) + ":3000";
+}
+
+static void upsertAgent(int i, bool healthy = true) {
+    std::string h = handleOf(i), u = urlOf(i);
+    dir.upsert(h.c_str(), u.c_str(), h.c_str(), healthy);
+}
+
+// Every listed agent is reachable by handle, and every position is unique
+static void assertConsistent() {
+    std::set<std::string> seen;
+    for (size_t i = 0; i < dir.size(); i++) {
+        TEST_ASSERT_EQUAL((int)i, dir.find(dir.handle(i)));
+        TEST_ASSERT_TRUE(seen.insert(dir.handle(i)).second);
+    }
+    TEST_ASSERT_TRUE(dir.arenaLive() <= dir.arenaUsed());
+    TEST_ASSERT_TRUE(dir.arenaUsed() <= AGENT_DIR_ARENA_BYTES);
+}
+
+void setUp(void) {
+    dir.clear();
+}
+
+void tearDown(void) {}
+
+void test_pass_reports_added_changed_removed(void) {
+    dir.beginPass();
+    TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert("alpha", "http://10.0.0.1:3000", "Alpha", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert("beta", "http://10.0.0.2:3000", "Beta", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert("gamma", "http://10.0.0.3:3000", "Gamma", false));
+    // Duplicate within the same pass
+    TEST_ASSERT_EQUAL(AgentDirectory::UNCHANGED, dir.upsert("beta", "http://10.0.0.2:3000", "Beta", true));
+    AgentDirectory::PassStats stats = dir.endPass(true);
+    TEST_ASSERT_EQUAL(3, stats.added);
+    TEST_ASSERT_EQUAL(3, (int)dir.size());
+
+    dir.beginPass();
+    TEST_ASSERT_EQUAL(AgentDirectory::UNCHANGED, dir.upsert("alpha", "http://10.0.0.1:3000", "Alpha", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::CHANGED, dir.upsert("gamma", "http://10.0.0.9:3000", "Gamma", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert("delta", "http://10.0.0.4:3000", "Delta", true));
+    stats = dir.endPass(true);
+    TEST_ASSERT_EQUAL(1, stats.added);
+    TEST_ASSERT_EQUAL(1, stats.changed);
+    TEST_ASSERT_EQUAL(1, stats.removed);
+
+    TEST_ASSERT_EQUAL(3, (int)dir.size());
+    TEST_ASSERT_EQUAL(-1, dir.find("beta"));
+    // Survivors keep their relative order, new agents go last
+    TEST_ASSERT_EQUAL_STRING("alpha", dir.handle(0));
+    TEST_ASSERT_EQUAL_STRING("gamma", dir.handle(1));
+    TEST_ASSERT_EQUAL_STRING("delta", dir.handle(2));
+    TEST_ASSERT_EQUAL_STRING("http://10.0.0.9:3000", dir.url(1));
+    TEST_ASSERT_TRUE(dir.healthy(1));
+    assertConsistent();
+}
+
+void test_partial_pass_keeps_unlisted_agents(void) {
+    dir.beginPass();
+    dir.upsert("alpha", "http://a", "Alpha", true);
+    dir.upsert("beta", "http://b", "Beta", true);
+    dir.endPass(true);
+
+    // Transfer failed after the first agent
+    dir.beginPass();
+    dir.upsert("alpha", "http://a", "Alpha", true);
+    TEST_ASSERT_EQUAL(0, dir.endPass(false).removed);
+    TEST_ASSERT_EQUAL(2, (int)dir.size());
+}
+
+void test_strings_are_interned(void) {
+    dir.upsert("shared", "http://same:3000", "shared", true);
+    dir.upsert("other", "http://same:3000", "shared", true);
+    // "shared", "http://same:3000" and "other"
+    TEST_ASSERT_EQUAL(3, (int)dir.stringCount());
+    TEST_ASSERT_EQUAL(strlen("shared") + strlen("http://same:3000") + strlen("other") + 3, dir.arenaLive());
+    // A name matching another agent's handle does not make it findable
+    TEST_ASSERT_EQUAL(0, dir.find("shared"));
+    TEST_ASSERT_EQUAL(1, dir.find("other"));
+
+    dir.beginPass();
+    dir.upsert("other", "http://same:3000", "shared", true);
+    dir.endPass(true);
+    TEST_ASSERT_EQUAL(-1, dir.find("shared"));
+    TEST_ASSERT_EQUAL(0, dir.find("other"));
+    TEST_ASSERT_EQUAL_STRING("shared", dir.name(0));
+    TEST_ASSERT_EQUAL(3, (int)dir.stringCount());
+}
+
+void test_rejects_bad_input(void) {
+    std::string longUrl(AGENT_DIR_STRING_MAX + 1, 'x');
+    TEST_ASSERT_EQUAL(AgentDirectory::REJECTED, dir.upsert("", "http://a", "A", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::REJECTED, dir.upsert(nullptr, "http://a", "A", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::REJECTED, dir.upsert("a", longUrl.c_str(), "A", true));
+    TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert("a", nullptr, nullptr, false));
+    TEST_ASSERT_EQUAL_STRING("", dir.url(0));
+    TEST_ASSERT_EQUAL_STRING("", dir.handle(5));
+    TEST_ASSERT_EQUAL(1, (int)dir.size());
+}
+
+void test_full_directory_evicts_least_recently_used(void) {
+    for (int i = 0; i < AGENT_DIR_CAPACITY - 1; i++) upsertAgent(i);
+    TEST_ASSERT_FALSE(dir.full());
+    upsertAgent(AGENT_DIR_CAPACITY - 1);
+    TEST_ASSERT_EQUAL(AGENT_DIR_CAPACITY, (int)dir.size());
+    TEST_ASSERT_TRUE(dir.full());
+
+    // The user has agent-0 selected, so agent-1 is now the oldest
+    dir.touch(dir.find("agent-0"));
+    dir.beginPass();
+    upsertAgent(AGENT_DIR_CAPACITY);
+    TEST_ASSERT_EQUAL(1, dir.lastPass().evicted);
+
+    TEST_ASSERT_EQUAL(AGENT_DIR_CAPACITY, (int)dir.size());
+    TEST_ASSERT_TRUE(dir.find("agent-0") >= 0);
+    TEST_ASSERT_EQUAL(-1, dir.find("agent-1"));
+    TEST_ASSERT_TRUE(dir.find(handleOf(AGENT_DIR_CAPACITY).c_str()) >= 0);
+    assertConsistent();
+}
+
+void test_arena_compacts_then_evicts(void) {
+    // Strings big enough that the arena, not the slot count, is the limit
+    std::string pad(200, 'p');
+    int added = 0;
+    for (int i = 0; i < 200; i++) {
+        std::string h = handleOf(i), u = "http://" + pad + std::to_string(i);
+        if (dir.upsert(h.c_str(), u.c_str(), h.c_str(), true) == AgentDirectory::ADDED) added++;
+        assertConsistent();
+    }
+    TEST_ASSERT_EQUAL(200, added);
+    TEST_ASSERT_TRUE(dir.size() < 200);
+    // The newest agents survive with intact strings
+    int pos = dir.find("agent-199");
+    TEST_ASSERT_TRUE(pos >= 0);
+    std::string expected = "http://" + pad + "199";
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), dir.url(pos));
+
+    // Dropping agents leaves holes that compaction reclaims
+    dir.beginPass();
+    for (size_t i = 0; i < dir.size(); i += 2) {
+        dir.upsert(dir.handle(i), dir.url(i), dir.name(i), true);
+    }
+    dir.endPass(true);
+    size_t before = dir.size();
+    for (int i = 1000; i < 1000 + (int)before / 2; i++) {
+        std::string h = handleOf(i), u = "http://" + pad + std::to_string(i);
+        TEST_ASSERT_EQUAL(AgentDirectory::ADDED, dir.upsert(h.c_str(), u.c_str(), h.c_str(), true));
+    }
+    TEST_ASSERT_EQUAL(0, dir.lastPass().evicted);
+    assertConsistent();
+}
+
+void test_benchmark_1000_agent_churn(void) {
+    const int REGISTRY = 1000;
+    const int PASSES = 50;
+    const int CHURN = 100;   // Agents replaced per pass
+
+    // Prebuild strings so only directory work is timed
+    std::string handles[REGISTRY + PASSES * CHURN];
+    std::string urls[REGISTRY + PASSES * CHURN];
+    for (int i = 0; i < REGISTRY + PASSES * CHURN; i++) {
+        handles[i] = handleOf(i);
+        urls[i] = urlOf(i);
+    }
+    size_t allocsBefore = heapAllocs;
+
+    double worstUs = 0;
+    size_t upserts = 0;
+    size_t evicted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int pass = 0; pass < PASSES; pass++) {
+        dir.beginPass();
+        int first = pass * CHURN;   // Registry window slides by CHURN agents
+        for (int i = first; i < first + REGISTRY; i++) {
+            auto t0 = std::chrono::steady_clock::now();
+            dir.upsert(handles[i].c_str(), urls[i].c_str(), handles[i].c_str(), (i + pass) % 7 != 0);
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+            if (us > worstUs) worstUs = us;
+            upserts++;
+        }
+        evicted += dir.endPass(true).evicted;
+    }
+    double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    size_t allocs = heapAllocs - allocsBefore;
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "%d passes x %d agents: %.2f us/upsert avg, %.1f us worst, %zu evictions, "
+             "footprint %zu bytes (capacity %d), heap allocs %zu",
+             PASSES, REGISTRY, totalMs * 1000.0 / upserts, worstUs, evicted,
+             AgentDirectory::footprint(), AGENT_DIR_CAPACITY, allocs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL(0, (int)allocs);
+    TEST_ASSERT_EQUAL(AGENT_DIR_CAPACITY, (int)dir.size());
+    // The tail of the last window is what a full directory keeps
+    TEST_ASSERT_TRUE(dir.find(handles[(PASSES - 1) * CHURN + REGISTRY - 1].c_str()) >= 0);
+    TEST_ASSERT_TRUE(totalMs * 1000.0 / upserts < 20.0);
+    assertConsistent();
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_pass_reports_added_changed_removed);
+    RUN_TEST(test_partial_pass_keeps_unlisted_agents);
+    RUN_TEST(test_strings_are_interned);
+    RUN_TEST(test_rejects_bad_input);
+    RUN_TEST(test_full_directory_evicts_least_recently_used);
+    RUN_TEST(test_arena_compacts_then_evicts);
+    RUN_TEST(test_benchmark_1000_agent_churn);
+    return UNITY_END();
+}
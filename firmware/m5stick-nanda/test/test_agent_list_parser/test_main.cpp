@@ -0,0 +1,182 @@
+/**
+ * Host tests and heap benchmark for the streaming /agents parser.
+ *
+ * The benchmark compares the old discoverAgents() approach (whole body in
+ * a String, then an unfiltered JsonDocument) with AgentListParser fed in
+ * TCP-sized chunks, on a synthetic 1,000-agent registry response.
+ *
+ *   pio test -e native -f test_agent_list_parser
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include <AgentListParser.h>
+
+#include "../support/CountingAllocator.h"
+
+struct Agent {
+    std::string handle, url, name;
+    bool healthy;
+};
+
+static std::vector<Agent> parsed;
+static size_t tableSize = 1000;
+
+static bool collect(JsonObjectConst agent) {
+    parsed.push_back({agent["handle"] | "", agent["url"] | "", agent["name"] | "", agent["healthy"] | false});
+    return parsed.size() < tableSize;
+}
+
+static bool feedAll(AgentListParser& parser, const std::string& body, size_t chunk) {
+    for (size_t i = 0; i < body.size(); i += chunk) {
+        size_t n = body.size() - i < chunk ? body.size() - i : chunk;
+        if (!parser.feed((const uint8_t*)body.data() + i, n)) return false;
+    }
+    return true;
+}
+
+// Shaped like the registry's /agents: agent facts, skills, timestamps
+static std::string syntheticRegistry(int count) {
+    std::string out = "{\"count\":" + std::to_string(count) + ",\"agents\":[";
+    for (int i = 0; i < count; i++) {
+        std::string id = std::to_string(i);
+        if (i) out += ",";
+        out += "{\"handle\":\"agent-" + id + "\",\"url\":\"http://10.0." + std::to_string(i / 250) + "." +
+               std::to_string(i % 250) + ":3000\",\"name\":\"Agent " + id + "\",\"healthy\":" +
+               (i % 3 ? "true" : "false") +
+               ",\"description\":\"Synthetic agent number " + id + " used for discovery benchmarks\""
+               ",\"skills\":[{\"id\":\"sensors/read\",\"name\":\"Read Sensors\"},"
+               "{\"id\":\"display/show\",\"name\":\"Show\",\"tags\":[\"ui\",\"lcd\"]}],"
+               "\"lastSeen\":1730000000" + id + ",\"registeredAt\":\"2025-01-01T00:00:00Z\"}";
+    }
+    out += "]}";
+    return out;
+}
+
+void setUp(void) {
+    parsed.clear();
+    tableSize = 1000;
+}
+
+void tearDown(void) {}
+
+void test_keeps_only_wanted_fields(void) {
+    const std::string body =
+        "{ \"agents\" : [ {\"meta\":{\"agents\":[1,2]},\"handle\":\"a\",\"url\":\"http://x\","
+        "\"name\":\"A \\\"quoted\\\" \\\\ name\",\"healthy\":true,\"skills\":[{\"id\":\"}]\"}]},"
+        "{\"handle\":\"b\",\"healthy\":false,\"extra\":\"{[\"},\n"
+        "{\"handle\":\"c\"} ], \"count\": 3 }";
+
+    AgentListParser parser(collect);
+    TEST_ASSERT_FALSE(feedAll(parser, body, body.size()));
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL(3, (int)parsed.size());
+
+    TEST_ASSERT_EQUAL_STRING("a", parsed[0].handle.c_str());
+    TEST_ASSERT_EQUAL_STRING("http://x", parsed[0].url.c_str());
+    TEST_ASSERT_EQUAL_STRING("A \"quoted\" \\ name", parsed[0].name.c_str());
+    TEST_ASSERT_TRUE(parsed[0].healthy);
+    TEST_ASSERT_FALSE(parsed[1].healthy);
+    TEST_ASSERT_EQUAL_STRING("", parsed[2].url.c_str());
+}
+
+void test_every_split_point_gives_same_result(void) {
+    const std::string body = syntheticRegistry(3);
+
+    for (size_t split = 0; split <= body.size(); split++) {
+        parsed.clear();
+        AgentListParser parser(collect);
+        parser.feed((const uint8_t*)body.data(), split);
+        parser.feed((const uint8_t*)body.data() + split, body.size() - split);
+        TEST_ASSERT_TRUE(parser.finished());
+        TEST_ASSERT_EQUAL(3, (int)parsed.size());
+        TEST_ASSERT_EQUAL_STRING("http://10.0.0.2:3000", parsed[2].url.c_str());
+    }
+}
+
+void test_stops_once_table_is_full(void) {
+    const std::string body = syntheticRegistry(200);
+    tableSize = 10;
+
+    AgentListParser parser(collect);
+    size_t consumed = 0;
+    while (consumed < body.size()) {
+        size_t n = body.size() - consumed < 536 ? body.size() - consumed : 536;
+        consumed += n;
+        if (!parser.feed((const uint8_t*)body.data() + consumed - n, n)) break;
+    }
+
+    TEST_ASSERT_TRUE(parser.stopped());
+    TEST_ASSERT_EQUAL(10, (int)parsed.size());
+    TEST_ASSERT_LESS_THAN(body.size() / 10, consumed);
+}
+
+void test_bare_array_and_oversized_element(void) {
+    const std::string longUrl(AGENT_OBJECT_MAX, 'u');
+    const std::string body = "[{\"handle\":\"big\",\"url\":\"" + longUrl + "\"},{\"handle\":\"ok\"}]";
+
+    AgentListParser parser(collect);
+    feedAll(parser, body, 7);
+    TEST_ASSERT_TRUE(parser.finished());
+    TEST_ASSERT_EQUAL(1, (int)parser.skipped());
+    TEST_ASSERT_EQUAL(1, (int)parsed.size());
+    TEST_ASSERT_EQUAL_STRING("ok", parsed[0].handle.c_str());
+}
+
+void test_benchmark_1000_agents(void) {
+    const std::string body = syntheticRegistry(1000);
+    const int rounds = 5;
+    using clock = std::chrono::steady_clock;
+
+    // Before: http.getString() + unbounded deserializeJson
+    CountingAllocator before;
+    auto t0 = clock::now();
+    for (int r = 0; r < rounds; r++) {
+        before.hold(body.size() + 1);  // The Arduino String holding the payload
+        {
+            JsonDocument doc(&before);
+            TEST_ASSERT_FALSE(deserializeJson(doc, body));
+            int kept = 0;
+            for (JsonObjectConst agent : doc["agents"].as<JsonArrayConst>()) {
+                if (kept++ >= 10) break;
+                (void)agent;
+            }
+        }
+        before.release(body.size() + 1);
+    }
+    double beforeUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / rounds;
+
+    // After: streamed in 536-byte segments through the filtering parser
+    CountingAllocator after;
+    t0 = clock::now();
+    for (int r = 0; r < rounds; r++) {
+        parsed.clear();
+        AgentListParser parser(collect, &after);
+        feedAll(parser, body, 536);
+        TEST_ASSERT_EQUAL(1000, (int)parser.agents());
+    }
+    double afterUs = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / rounds;
+    size_t afterPeak = after.peak + sizeof(AgentListParser);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "payload %u bytes | before: peak heap %u B, %.0f us | after: peak %u B (incl. parser), %.0f us",
+             (unsigned)body.size(), (unsigned)before.peak, beforeUs, (unsigned)afterPeak, afterUs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(8192, afterPeak);
+    TEST_ASSERT_LESS_THAN(before.peak / 50, afterPeak);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_keeps_only_wanted_fields);
+    RUN_TEST(test_every_split_point_gives_same_result);
+    RUN_TEST(test_stops_once_table_is_full);
+    RUN_TEST(test_bare_array_and_oversized_element);
+    RUN_TEST(test_benchmark_1000_agents);
+    return UNITY_END();
+}
@@ -0,0 +1,214 @@
+/**
+ * Host tests and frame-time benchmark for the animation timelines.
+ *
+ * Timelines are driven by a simulated clock into a FrameBuffer whose
+ * "panel" is a 240x135 sprite, as in test_screens, so the same seed gives
+ * the same frames on every run and frame times can be compared between
+ * builds.
+ *
+ *   pio test -e native_gfx -f test_animation
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <Animations.h>
+#include <FrameBuffer.h>
+#include <Timeline.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+#define PANEL_BYTES (PANEL_W * PANEL_H * 2)
+#define SEED 0x5eed
+
+struct CueLog {
+    uint16_t frequency[TIMELINE_MAX_CUES];
+    uint32_t playedAt[TIMELINE_MAX_CUES];
+    int count;
+};
+
+static LGFX_Sprite panel;
+static LGFX_Sprite other;
+static CueLog cues;
+static uint32_t clockMs;
+
+static void recordCue(uint16_t frequency, uint16_t durationMs) {
+    if (cues.count < TIMELINE_MAX_CUES) {
+        cues.frequency[cues.count] = frequency;
+        cues.playedAt[cues.count] = clockMs;
+        cues.count++;
+    }
+}
+
+static bool createPanel(LGFX_Sprite& sprite) {
+    sprite.setColorDepth(16);
+    return sprite.createSprite(PANEL_W, PANEL_H) != nullptr;
+}
+
+// Play `timeline` to the end, calling advance() every `tickMs` (plus
+// `jitter` on every third tick), as loop() does; returns frames presented
+static int playOut(Timeline& timeline, FrameBuffer& frame, uint32_t tickMs, uint32_t jitter = 0) {
+    cues.count = 0;
+    clockMs = 1000;
+    timeline.onCue(recordCue);
+    timeline.start(clockMs, SEED);
+    int presented = 0;
+    for (int tick = 0; timeline.running() && tick < 100000; tick++) {
+        if (timeline.advance(frame.canvas(), clockMs)) {
+            frame.present();
+            presented++;
+        }
+        clockMs += tickMs + (tick % 3 == 0 ? jitter : 0);
+    }
+    return presented;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_same_seed_same_frames(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Timeline timeline;
+
+    buildStartupAnimation(timeline);
+    playOut(timeline, frame, 10);
+    memcpy(other.getBuffer(), panel.getBuffer(), PANEL_BYTES);
+
+    buildStartupAnimation(timeline);
+    playOut(timeline, frame, 10);
+    TEST_ASSERT_EQUAL(0, memcmp(other.getBuffer(), panel.getBuffer(), PANEL_BYTES));
+
+    // The logo's voxel border comes from the seed
+    buildStartupAnimation(timeline);
+    timeline.onCue(recordCue);
+    timeline.start(0, SEED + 1);
+    while (timeline.running()) {
+        timeline.advance(frame.canvas(), clockMs += 10);
+    }
+    frame.present();
+    TEST_ASSERT_TRUE(memcmp(other.getBuffer(), panel.getBuffer(), PANEL_BYTES) != 0);
+}
+
+void test_final_frame_independent_of_frame_rate(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Timeline timeline;
+    CueLog smooth;
+
+    buildMessageAnimation(timeline, "Hello from the tunnel!");
+    int smoothFrames = playOut(timeline, frame, 1);
+    memcpy(other.getBuffer(), panel.getBuffer(), PANEL_BYTES);
+    smooth = cues;
+
+    // A busy loop: late, uneven ticks. Fewer frames, same picture and sound.
+    int choppyFrames = playOut(timeline, frame, 37, 29);
+    TEST_ASSERT_LESS_THAN(smoothFrames, choppyFrames);
+    TEST_ASSERT_EQUAL(0, memcmp(other.getBuffer(), panel.getBuffer(), PANEL_BYTES));
+    TEST_ASSERT_EQUAL(smooth.count, cues.count);
+    for (int i = 0; i < cues.count; i++) {
+        TEST_ASSERT_EQUAL(smooth.frequency[i], cues.frequency[i]);
+    }
+}
+
+void test_cues_follow_the_clock(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Timeline timeline(ANIMATION_FRAME_MS);
+
+    buildStartupAnimation(timeline);
+    playOut(timeline, frame, 1);
+    TEST_ASSERT_EQUAL(15, cues.count);
+
+    // First cue with the first frame, final chord 50 ms apart, none late by
+    // more than a frame
+    TEST_ASSERT_EQUAL(1000, (int)cues.playedAt[0]);
+    TEST_ASSERT_EQUAL(220, cues.frequency[0]);
+    TEST_ASSERT_EQUAL(330, cues.frequency[cues.count - 1]);
+    TEST_ASSERT_EQUAL(220, cues.frequency[cues.count - 3]);
+    int chordGap = (int)(cues.playedAt[cues.count - 2] - cues.playedAt[cues.count - 3]);
+    TEST_ASSERT_GREATER_OR_EQUAL(50 - ANIMATION_FRAME_MS, chordGap);
+    TEST_ASSERT_LESS_THAN(50 + ANIMATION_FRAME_MS, chordGap);
+    for (int i = 1; i < cues.count; i++) {
+        TEST_ASSERT_TRUE(cues.playedAt[i] >= cues.playedAt[i - 1]);
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(2600, (int)timeline.length());
+}
+
+void test_message_ends_on_the_text(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Timeline timeline;
+
+    buildMessageAnimation(timeline, "Hi");
+    playOut(timeline, frame, 5);
+    TEST_ASSERT_FALSE(timeline.running());
+    TEST_ASSERT_LESS_THAN(500, (int)timeline.length());
+
+    // Cyan header bar and borders, white text on black
+    TEST_ASSERT_EQUAL(TFT_CYAN, panel.readPixel(120, 7));
+    TEST_ASSERT_EQUAL(TFT_CYAN, panel.readPixel(0, 60));
+    TEST_ASSERT_EQUAL(TFT_MAGENTA, panel.readPixel(2, 60));
+    bool white = false;
+    for (int y = 40; y < 56 && !white; y++) {
+        for (int x = 10; x < 34 && !white; x++) {
+            white = panel.readPixel(x, y) == TFT_WHITE;
+        }
+    }
+    TEST_ASSERT_TRUE(white);
+
+    // A new message replaces the one playing
+    buildMessageAnimation(timeline, "Second");
+    TEST_ASSERT_EQUAL_STRING("Second", timeline.text());
+}
+
+void test_benchmark_frame_time(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Timeline timeline;
+    const char* names[] = {"startup", "message"};
+
+    for (int which = 0; which < 2; which++) {
+        if (which == 0) buildStartupAnimation(timeline);
+        else buildMessageAnimation(timeline, "Benchmark message text");
+
+        cues.count = 0;
+        clockMs = 0;
+        timeline.onCue(recordCue);
+        timeline.start(clockMs, SEED);
+        int frames = 0;
+        double total = 0, worst = 0;
+        while (timeline.running()) {
+            auto start = std::chrono::steady_clock::now();
+            if (timeline.advance(frame.canvas(), clockMs)) {
+                frame.present();
+                frames++;
+            }
+            double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+            total += us;
+            worst = us > worst ? us : worst;
+            clockMs += 1;
+        }
+
+        char msg[120];
+        snprintf(msg, sizeof(msg), "%-8s | %4u ms, %3d frames, %6.1f us per frame, worst %6.1f us, %d cues",
+                 names[which], (unsigned)timeline.length(), frames, total / frames, worst, cues.count);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int argc, char** argv) {
+    if (!createPanel(panel) || !createPanel(other)) return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_same_seed_same_frames);
+    RUN_TEST(test_final_frame_independent_of_frame_rate);
+    RUN_TEST(test_cues_follow_the_clock);
+    RUN_TEST(test_message_ends_on_the_text);
+    RUN_TEST(test_benchmark_frame_time);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+/**
+ * Host tests for BodyAssembler: JSON-RPC bodies fragmented at every byte
+ * offset must dispatch exactly once, to the same reply as the whole body.
+ *
+ *   pio test -e native -f test_body_assembler
+ */
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string>
+
+#include <BodyAssembler.h>
+#include <JsonRpcDispatcher.h>
+
+static int dispatches;
+
+static bool echo(JsonVariantConst params, JsonObject out) {
+    out["echo"] = params;
+    return true;
+}
+
+static const SkillDef SKILLS[] = {
+    {"test/echo", "Echo", "Returns its params", echo},
+};
+
+static JsonRpcDispatcher rpc(SKILLS, SKILL_COUNT(SKILLS));
+
+static const std::string BODY = R"([{"jsonrpc":"2.0","id":1,"method":"test/echo","params":{"text":"héllo, \"world\""}},)"
+                                R"({"jsonrpc":"2.0","id":2,"method":"test/echo","params":[1,2.5,true,null,{"deep":["x"]}]}])";
+
+static std::string reply(const char* body, size_t len) {
+    JsonDocument doc;
+    rpc.dispatch(body, len, doc);
+    dispatches++;
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+// Feed segments the way HttpServer does, dispatching on COMPLETE
+static std::string deliver(BodyAssembler& body, const std::string& payload, const size_t* cuts, size_t count) {
+    std::string out;
+    size_t index = 0;
+    for (size_t i = 0; i <= count; i++) {
+        size_t end = i < count ? cuts[i] : payload.size();
+        if (end == index && !payload.empty()) continue;   // The server never sends empty segments
+        BodyAssembler::Result r = body.feed((const uint8_t*)payload.data() + index, end - index, index, payload.size());
+        if (r == BodyAssembler::COMPLETE) {
+            TEST_ASSERT_EQUAL(payload.size(), end);
+            out = reply(body.data(), body.length());
+        } else {
+            TEST_ASSERT_EQUAL(BodyAssembler::PENDING, r);
+        }
+        index = end;
+    }
+    return out;
+}
+
+void setUp(void) {
+    dispatches = 0;
+}
+
+void tearDown(void) {}
+
+void test_split_at_every_offset(void) {
+    const std::string expected = reply(BODY.data(), BODY.size());
+    TEST_ASSERT_NOT_NULL(strstr(expected.c_str(), "\"deep\""));
+
+    BodyAssembler* body = BodyAssembler::create(BODY.size());
+    TEST_ASSERT_NOT_NULL(body);
+    dispatches = 0;
+    for (size_t cut = 0; cut <= BODY.size(); cut++) {
+        std::string got = deliver(*body, BODY, &cut, 1);
+        TEST_ASSERT_EQUAL_STRING(expected.c_str(), got.c_str());
+    }
+    TEST_ASSERT_EQUAL((int)BODY.size() + 1, dispatches);
+    free(body);
+}
+
+void test_three_segments_at_every_offset_pair(void) {
+    const std::string expected = reply(BODY.data(), BODY.size());
+    BodyAssembler* body = BodyAssembler::create(BODY.size());
+    dispatches = 0;
+    int runs = 0;
+    for (size_t a = 0; a <= BODY.size(); a++) {
+        for (size_t b = a; b <= BODY.size(); b++) {
+            size_t cuts[2] = {a, b};
+            std::string got = deliver(*body, BODY, cuts, 2);
+            TEST_ASSERT_EQUAL_STRING(expected.c_str(), got.c_str());
+            runs++;
+        }
+    }
+    TEST_ASSERT_EQUAL(runs, dispatches);
+    free(body);
+}
+
+void test_byte_at_a_time(void) {
+    BodyAssembler* body = BodyAssembler::create(BODY.size());
+    size_t cuts[1024];
+    for (size_t i = 0; i < BODY.size(); i++) cuts[i] = i + 1;
+    std::string got = deliver(*body, BODY, cuts, BODY.size() - 1);
+    std::string expected = reply(BODY.data(), BODY.size());
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), got.c_str());
+    TEST_ASSERT_EQUAL('\0', body->data()[body->length()]);
+    free(body);
+}
+
+void test_limit_gives_too_large(void) {
+    TEST_ASSERT_NULL(BodyAssembler::create(BODY_MAX_SIZE + 1));
+    TEST_ASSERT_NOT_NULL(BodyAssembler::create(0));
+
+    char storage[16];
+    BodyAssembler body(storage, sizeof(storage));
+    std::string big(16, 'x');   // Needs 17 bytes with the NUL
+    TEST_ASSERT_EQUAL(BodyAssembler::TOO_LARGE, body.feed((const uint8_t*)big.data(), 4, 0, big.size()));
+    // The rest of the rejected body is ignored
+    TEST_ASSERT_EQUAL(BodyAssembler::INVALID, body.feed((const uint8_t*)big.data() + 4, 12, 4, big.size()));
+    TEST_ASSERT_FALSE(body.complete());
+
+    std::string fits(15, 'y');
+    TEST_ASSERT_EQUAL(BodyAssembler::COMPLETE, body.feed((const uint8_t*)fits.data(), 15, 0, 15));
+}
+
+void test_rejects_gaps_and_overruns(void) {
+    char storage[64];
+    BodyAssembler body(storage, sizeof(storage));
+    const uint8_t* d = (const uint8_t*)"0123456789";
+
+    TEST_ASSERT_EQUAL(BodyAssembler::PENDING, body.feed(d, 4, 0, 10));
+    TEST_ASSERT_EQUAL(BodyAssembler::INVALID, body.feed(d + 5, 5, 5, 10));    // Gap
+
+    TEST_ASSERT_EQUAL(BodyAssembler::PENDING, body.feed(d, 4, 0, 10));
+    TEST_ASSERT_EQUAL(BodyAssembler::INVALID, body.feed(d + 4, 8, 4, 10));    // Past total
+
+    TEST_ASSERT_EQUAL(BodyAssembler::PENDING, body.feed(d, 4, 0, 10));
+    TEST_ASSERT_EQUAL(BodyAssembler::INVALID, body.feed(d + 4, 6, 4, 12));    // Total changed
+
+    TEST_ASSERT_EQUAL(BodyAssembler::COMPLETE, body.feed(d, 10, 0, 10));
+    TEST_ASSERT_EQUAL(BodyAssembler::INVALID, body.feed(d, 1, 10, 10));       // After completion
+    TEST_ASSERT_EQUAL_STRING("0123456789", body.data());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_split_at_every_offset);
+    RUN_TEST(test_three_segments_at_every_offset_pair);
+    RUN_TEST(test_byte_at_a_time);
+    RUN_TEST(test_limit_gives_too_large);
+    RUN_TEST(test_rejects_gaps_and_overruns);
+    return UNITY_END();
+}
@@ -0,0 +1,648 @@
+/**
+ * Host tests and benchmark for the incremental HTTP request parser.
+ *
+ * The benchmark parses what the device actually gets, a dashboard's
+ * fetches from Chrome (about 600 bytes of headers each), A2A POSTs from
+ * a Python agent and display calls with an encoded query, cut into random
+ * TCP segments. The baseline is ESPAsyncWebServer's request parsing as it
+ * was: _onData() gathering lines into a String, _parseReqHead() splitting
+ * with indexOf()/substring(), one new'd AsyncWebHeader per header and one
+ * AsyncWebParameter per query value (urlDecode()d), and the headers no
+ * handler asked for deleted once the head is in. std::string stands in
+ * for Arduino String and std::list for its LinkedList.
+ *
+ *   pio test -e native -f test_http_request_parser
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <list>
+#include <stdlib.h>
+#include <string>
+#include <strings.h>
+
+#include <HttpRequestParser.h>
+
+#include "../support/CountingNew.h"
+
+static const char* const KEEP[] = {"If-None-Match", "Upgrade", "Sec-WebSocket-Key", nullptr};
+
+static const char CHROME_GET[] =
+    "GET /api/sensors HTTP/1.1\r\n"
+    "Host: 192.168.1.42\r\n"
+    "Connection: keep-alive\r\n"
+    "sec-ch-ua-platform: \"macOS\"\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/129.0.0.0 Safari/537.36\r\n"
+    "sec-ch-ua: \"Google Chrome\";v=\"129\", \"Not=A?Brand\";v=\"8\", \"Chromium\";v=\"129\"\r\n"
+    "sec-ch-ua-mobile: ?0\r\n"
+    "Accept: */*\r\n"
+    "Sec-Fetch-Site: same-origin\r\n"
+    "Sec-Fetch-Mode: cors\r\n"
+    "Sec-Fetch-Dest: empty\r\n"
+    "Referer: http://192.168.1.42/\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+    "\r\n";
+
+static const char CHROME_CARD[] =
+    "GET /.well-known/agent.json HTTP/1.1\r\n"
+    "Host: 192.168.1.42\r\n"
+    "Connection: keep-alive\r\n"
+    "Cache-Control: max-age=0\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/129.0.0.0 Safari/537.36\r\n"
+    "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,image/avif,image/webp,*/*;q=0.8\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+    "If-None-Match: \"c9e4e285\"\r\n"
+    "\r\n";
+
+static const char DISPLAY_GET[] =
+    "GET /api/display?text=Hello%20from%20the%20dashboard%21&size=2 HTTP/1.1\r\n"
+    "Host: 192.168.1.42\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: Mozilla/5.0 (Macintosh; Intel Mac OS X 10_15_7) AppleWebKit/537.36 (KHTML, like Gecko) "
+    "Chrome/129.0.0.0 Safari/537.36\r\n"
+    "Accept: */*\r\n"
+    "Referer: http://192.168.1.42/\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Accept-Language: en-US,en;q=0.9,de;q=0.8\r\n"
+    "\r\n";
+
+static const char A2A_POST[] =
+    "POST /a2a HTTP/1.1\r\n"
+    "Host: 192.168.1.42\r\n"
+    "Accept: */*\r\n"
+    "Accept-Encoding: gzip, deflate\r\n"
+    "Connection: keep-alive\r\n"
+    "User-Agent: python-httpx/0.27.2\r\n"
+    "Content-Type: application/json\r\n"
+    "Content-Length: 144\r\n"
+    "\r\n"
+    "{\"jsonrpc\":\"2.0\",\"id\":\"7\",\"method\":\"tasks/send\",\"params\":{\"id\":\"t-7\","
+    "\"message\":{\"role\":\"user\",\"parts\":[{\"type\":\"text\",\"text\":\"read sensors\"}]}}}";
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Feed the whole request in pieces of the given sizes (the last repeats)
+static HttpRequestParser::Result feedPieces(HttpRequestParser& parser, const char* request, size_t len,
+                                            const size_t* sizes, size_t count, size_t& consumed) {
+    HttpRequestParser::Result result = HttpRequestParser::NEED_MORE;
+    consumed = 0;
+    size_t k = 0;
+    while (consumed < len && result == HttpRequestParser::NEED_MORE) {
+        size_t n = sizes[k < count ? k : count - 1];
+        if (k < count) k++;
+        if (n > len - consumed) n = len - consumed;
+        size_t used;
+        result = parser.feed((const uint8_t*)request + consumed, n, used);
+        consumed += used;
+    }
+    return result;
+}
+
+static HttpRequestParser::Result feedAll(HttpRequestParser& parser, const char* request, size_t& consumed) {
+    size_t whole = strlen(request);
+    return feedPieces(parser, request, whole, &whole, 1, consumed);
+}
+
+static int errorFor(const char* request, size_t arenaSize = 512) {
+    char arena[512];
+    HttpRequestParser parser(arena, arenaSize, KEEP);
+    size_t consumed;
+    return feedAll(parser, request, consumed) == HttpRequestParser::ERROR ? parser.error() : 0;
+}
+
+void test_request_line_and_kept_headers(void) {
+    char arena[256];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    size_t consumed;
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedAll(parser, CHROME_CARD, consumed));
+    TEST_ASSERT_EQUAL(strlen(CHROME_CARD), consumed);
+
+    TEST_ASSERT_EQUAL(HTTP_METHOD_GET, parser.method());
+    TEST_ASSERT_TRUE(parser.http11());
+    TEST_ASSERT_EQUAL_STRING("/.well-known/agent.json", parser.path());
+    TEST_ASSERT_EQUAL(23, parser.pathLength());
+    TEST_ASSERT_EQUAL_STRING("", parser.query());
+    TEST_ASSERT_EQUAL(1, parser.headerCount());
+    TEST_ASSERT_EQUAL_STRING("\"c9e4e285\"", parser.header("if-none-match"));
+    TEST_ASSERT_NULL(parser.header("User-Agent"));   // Skipped
+    TEST_ASSERT_EQUAL(HTTP_CONNECTION_KEEP_ALIVE, parser.connection());
+    TEST_ASSERT_EQUAL(0, parser.contentLength());
+    // The target and one header; the browser's other 400 bytes went past
+    TEST_ASSERT_TRUE(parser.used() < 64);
+
+    // With every header kept
+    char big[1024];
+    HttpRequestParser all(big, sizeof(big));
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedAll(all, DISPLAY_GET, consumed));
+    TEST_ASSERT_EQUAL(7, all.headerCount());
+    TEST_ASSERT_EQUAL_STRING("Host", all.headerName(0));
+    TEST_ASSERT_EQUAL_STRING("192.168.1.42", all.headerValue(0));
+    TEST_ASSERT_EQUAL_STRING("gzip, deflate", all.header("Accept-Encoding"));
+    TEST_ASSERT_EQUAL_STRING("/api/display", all.path());
+    TEST_ASSERT_EQUAL_STRING("text=Hello%20from%20the%20dashboard%21&size=2", all.query());
+
+    // And again after reset()
+    all.reset();
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedAll(all, CHROME_CARD, consumed));
+    TEST_ASSERT_EQUAL(8, all.headerCount());
+    TEST_ASSERT_EQUAL_STRING("/.well-known/agent.json", all.path());
+}
+
+// Whatever the segmentation, the same request comes out
+void test_every_split_point(void) {
+    const char* requests[] = {CHROME_GET, CHROME_CARD, DISPLAY_GET, A2A_POST};
+    for (const char* request : requests) {
+        size_t len = strlen(request);
+        char reference[512];
+        HttpRequestParser whole(reference, sizeof(reference), KEEP);
+        size_t headLen;
+        TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedAll(whole, request, headLen));
+
+        for (size_t cut = 1; cut < len; cut++) {
+            char arena[512];
+            HttpRequestParser parser(arena, sizeof(arena), KEEP);
+            size_t sizes[] = {cut, len};
+            size_t consumed;
+            TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedPieces(parser, request, len, sizes, 2, consumed));
+            TEST_ASSERT_EQUAL(headLen, consumed);
+            TEST_ASSERT_EQUAL_STRING(whole.path(), parser.path());
+            TEST_ASSERT_EQUAL_STRING(whole.query(), parser.query());
+            TEST_ASSERT_EQUAL(whole.headerCount(), parser.headerCount());
+            TEST_ASSERT_EQUAL(whole.contentLength(), parser.contentLength());
+            TEST_ASSERT_EQUAL(whole.connection(), parser.connection());
+            for (size_t h = 0; h < whole.headerCount(); h++) {
+                TEST_ASSERT_EQUAL_STRING(whole.headerValue(h), parser.headerValue(h));
+            }
+        }
+
+        // One byte at a time
+        char arena[512];
+        HttpRequestParser parser(arena, sizeof(arena), KEEP);
+        size_t one = 1;
+        size_t consumed;
+        TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, feedPieces(parser, request, len, &one, 1, consumed));
+        TEST_ASSERT_EQUAL(headLen, consumed);
+        TEST_ASSERT_EQUAL(whole.used(), parser.used());
+    }
+}
+
+// The body and a pipelined request are left to the caller
+void test_body_and_pipelined_request(void) {
+    std::string stream = std::string(A2A_POST) + CHROME_CARD;
+    char arena[256];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    size_t used;
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, parser.feed((const uint8_t*)stream.data(), stream.size(), used));
+    TEST_ASSERT_EQUAL(HTTP_METHOD_POST, parser.method());
+    TEST_ASSERT_EQUAL(144, parser.contentLength());
+    TEST_ASSERT_EQUAL('{', stream[used]);
+    TEST_ASSERT_EQUAL(strlen(A2A_POST) - 144, used);
+
+    // More bytes after the head are not taken
+    size_t again;
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD, parser.feed((const uint8_t*)stream.data() + used, 10, again));
+    TEST_ASSERT_EQUAL(0, again);
+
+    parser.reset();
+    size_t next = strlen(A2A_POST);
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD,
+                      parser.feed((const uint8_t*)stream.data() + next, stream.size() - next, used));
+    TEST_ASSERT_EQUAL(strlen(CHROME_CARD), used);
+    TEST_ASSERT_EQUAL_STRING("/.well-known/agent.json", parser.path());
+}
+
+void test_connection_expect_and_versions(void) {
+    char arena[256];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    size_t consumed;
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD,
+                      feedAll(parser,
+                              "\r\nGET /ws/imu?rate=50 HTTP/1.1\r\n"
+                              "connection:keep-alive,  Upgrade\r\n"
+                              "Upgrade: websocket \t\r\n"
+                              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n",
+                              consumed));
+    TEST_ASSERT_EQUAL(HTTP_CONNECTION_KEEP_ALIVE | HTTP_CONNECTION_UPGRADE, parser.connection());
+    TEST_ASSERT_EQUAL_STRING("websocket", parser.header("Upgrade"));
+    TEST_ASSERT_EQUAL_STRING("dGhlIHNhbXBsZSBub25jZQ==", parser.header("sec-websocket-key"));
+
+    parser.reset();
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD,
+                      feedAll(parser,
+                              "POST /rpc HTTP/1.0\nContent-Length: 12\nExpect: 100-continue\n"
+                              "Content-Length: 12\nConnection: close\nEmpty:\n\n",
+                              consumed));
+    TEST_ASSERT_FALSE(parser.http11());
+    TEST_ASSERT_TRUE(parser.expectContinue());
+    TEST_ASSERT_EQUAL(12, parser.contentLength());
+    TEST_ASSERT_EQUAL(HTTP_CONNECTION_CLOSE, parser.connection());
+    TEST_ASSERT_EQUAL(0, parser.headerCount());
+
+    TEST_ASSERT_EQUAL(HTTP_METHOD_OPTIONS, httpMethod("OPTIONS", 7));
+    TEST_ASSERT_EQUAL(0, httpMethod("get", 3));
+    TEST_ASSERT_EQUAL(0, httpMethod("GETS", 4));
+}
+
+void test_errors(void) {
+    TEST_ASSERT_EQUAL(501, errorFor("BREW /pot HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("get / HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor(" / HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET api HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET /a\x01 HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET /%zz HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET /a%00b HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET /a%2 HTTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(505, errorFor("GET / HTTP/2.0\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET / FTP/1.1\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET / HTTP/1.1\r\n folded\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET / HTTP/1.1\r\nBad Name: x\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("GET / HTTP/1.1\r\n: x\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("POST / HTTP/1.1\r\nContent-Length: 1x\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("POST / HTTP/1.1\r\nContent-Length: 99999999999\r\n\r\n"));
+    TEST_ASSERT_EQUAL(400, errorFor("POST / HTTP/1.1\r\nContent-Length: 5\r\nContent-Length: 6\r\n\r\n"));
+    TEST_ASSERT_EQUAL(501, errorFor("POST / HTTP/1.1\r\nTransfer-Encoding: chunked\r\n\r\n"));
+
+    // A target longer than the arena, kept headers that do not fit, too many of them
+    std::string longTarget = "GET /" + std::string(600, 'a') + " HTTP/1.1\r\n\r\n";
+    TEST_ASSERT_EQUAL(414, errorFor(longTarget.c_str()));
+    std::string bigHeader = "GET / HTTP/1.1\r\nIf-None-Match: " + std::string(600, 'e') + "\r\n\r\n";
+    TEST_ASSERT_EQUAL(431, errorFor(bigHeader.c_str()));
+    std::string many = "GET / HTTP/1.1\r\n";
+    for (int i = 0; i < HTTP_HEADERS_MAX + 1; i++) many += "Upgrade: x\r\n";
+    TEST_ASSERT_EQUAL(431, errorFor((many + "\r\n").c_str()));
+
+    // Skipped headers cost no arena, but the whole head is bounded
+    std::string skipped = "GET / HTTP/1.1\r\nCookie: " + std::string(4000, 'c') + "\r\n\r\n";
+    TEST_ASSERT_EQUAL(0, errorFor(skipped.c_str(), 64));
+    std::string huge = "GET / HTTP/1.1\r\nCookie: " + std::string(HTTP_HEAD_LIMIT, 'c') + "\r\n\r\n";
+    TEST_ASSERT_EQUAL(431, errorFor(huge.c_str()));
+
+    // Nothing more is taken after an error
+    char arena[64];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    size_t used;
+    TEST_ASSERT_EQUAL(HttpRequestParser::ERROR, parser.feed((const uint8_t*)"xx", 2, used));
+    TEST_ASSERT_EQUAL(HttpRequestParser::ERROR, parser.feed((const uint8_t*)"GET", 3, used));
+    TEST_ASSERT_EQUAL(0, used);
+}
+
+void test_path_and_params_decoding(void) {
+    char arena[256];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    size_t consumed;
+    TEST_ASSERT_EQUAL(HttpRequestParser::HEAD,
+                      feedAll(parser,
+                              "GET /api/a%2Fb%20c?text=hello%20world+x&empty=&flag&a%62c=1&bad=%zz%4&last=%F0%9F%91%8B "
+                              "HTTP/1.1\r\n\r\n",
+                              consumed));
+    TEST_ASSERT_EQUAL_STRING("/api/a/b c", parser.path());
+    TEST_ASSERT_EQUAL(10, parser.pathLength());
+
+    char value[16];
+    TEST_ASSERT_TRUE(parser.param("text", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("hello world x", value);
+    TEST_ASSERT_TRUE(parser.param("empty", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("", value);
+    TEST_ASSERT_TRUE(parser.param("flag", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("", value);
+    TEST_ASSERT_TRUE(parser.param("abc", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("1", value);
+    TEST_ASSERT_TRUE(parser.param("bad", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("%zz%4", value);   // Taken as sent
+    TEST_ASSERT_TRUE(parser.param("last", value, sizeof(value)));
+    TEST_ASSERT_EQUAL_STRING("\xF0\x9F\x91\x8B", value);
+    TEST_ASSERT_FALSE(parser.param("tex", value, sizeof(value)));
+    TEST_ASSERT_FALSE(parser.param("missing", value, sizeof(value)));
+
+    char small[6];
+    TEST_ASSERT_TRUE(parser.param("text", small, sizeof(small)));
+    TEST_ASSERT_EQUAL_STRING("hello", small);
+    TEST_ASSERT_TRUE(parser.param("text", nullptr, 0));
+}
+
+// ============================================================================
+// Baseline: ESPAsyncWebServer's request parsing, on std::string
+// ============================================================================
+
+struct BaselineHeader {
+    BaselineHeader(const std::string& n, const std::string& v) : name(n), value(v) {}
+    std::string name;
+    std::string value;
+};
+
+struct BaselineParam {
+    BaselineParam(const std::string& n, const std::string& v) : name(n), value(v) {}
+    std::string name;
+    std::string value;
+};
+
+static bool equalsIgnoreCase(const std::string& a, const char* b) {
+    return strcasecmp(a.c_str(), b) == 0;
+}
+
+static void trim(std::string& s) {
+    size_t start = s.find_first_not_of(" \t\r\n");
+    size_t end = s.find_last_not_of(" \t\r\n");
+    s = start == std::string::npos ? std::string() : s.substr(start, end - start + 1);
+}
+
+class BaselineRequest {
+public:
+    enum State { START, HEADERS, BODY, FAIL };
+
+    BaselineRequest() : state(START), method(0), version(0), contentLength(0), expectingContinue(false) {
+        interesting.push_back("If-None-Match");   // RouteHandler::canHandle()
+    }
+    ~BaselineRequest() {
+        for (BaselineHeader* h : headers) delete h;
+        for (BaselineParam* p : params) delete p;
+    }
+
+    // As AsyncWebServerRequest::_onData() up to the body
+    void onData(char* buf, size_t len) {
+        while (state < BODY) {
+            size_t i;
+            for (i = 0; i < len; i++) {
+                if (buf[i] == '\n') break;
+            }
+            if (i == len) {
+                char ch = buf[len - 1];
+                buf[len - 1] = 0;
+                temp.reserve(temp.length() + len);
+                temp += buf;
+                temp += ch;
+                buf[len - 1] = ch;
+                return;
+            }
+            buf[i] = 0;
+            temp += buf;
+            buf[i] = '\n';
+            trim(temp);
+            parseLine();
+            if (++i < len) {
+                buf += i;
+                len -= i;
+                continue;
+            }
+            return;
+        }
+    }
+
+    void parseLine() {
+        if (state == START) {
+            if (temp.empty()) {
+                state = FAIL;
+            } else {
+                parseReqHead();
+                state = HEADERS;
+            }
+            return;
+        }
+        if (temp.empty()) {
+            // End of the head: _attachHandler(), then _removeNotInterestingHeaders()
+            for (auto it = headers.begin(); it != headers.end();) {
+                bool keep = false;
+                for (const std::string& name : interesting) keep = keep || equalsIgnoreCase((*it)->name, name.c_str());
+                if (keep) {
+                    ++it;
+                } else {
+                    delete *it;
+                    it = headers.erase(it);
+                }
+            }
+            state = BODY;
+        } else {
+            parseReqHeader();
+        }
+    }
+
+    void parseReqHead() {
+        size_t index = temp.find(' ');
+        std::string m = temp.substr(0, index);
+        index = temp.find(' ', index + 1);
+        std::string u = temp.substr(m.length() + 1, index - m.length() - 1);
+        temp = temp.substr(index + 1);
+        method = httpMethod(m.c_str(), m.length());
+
+        std::string g;
+        index = u.find('?');
+        if (index != std::string::npos && index > 0) {
+            g = u.substr(index + 1);
+            u = u.substr(0, index);
+        }
+        url = urlDecode(u);
+        addGetParams(g);
+        if (temp.compare(0, 8, "HTTP/1.0") != 0) version = 1;
+        temp = std::string();
+    }
+
+    void parseReqHeader() {
+        size_t index = temp.find(':');
+        if (index != std::string::npos) {
+            std::string name = temp.substr(0, index);
+            std::string value = temp.substr(index + 2);
+            if (equalsIgnoreCase(name, "Host")) {
+                host = value;
+            } else if (equalsIgnoreCase(name, "Content-Type")) {
+                contentType = value.substr(0, value.find(';'));
+            } else if (equalsIgnoreCase(name, "Content-Length")) {
+                contentLength = atoi(value.c_str());
+            } else if (equalsIgnoreCase(name, "Expect") && value == "100-continue") {
+                expectingContinue = true;
+            }
+            headers.push_back(new BaselineHeader(name, value));
+        }
+        temp = std::string();
+    }
+
+    void addGetParams(const std::string& query) {
+        size_t start = 0;
+        while (start < query.length()) {
+            size_t end = query.find('&', start);
+            if (end == std::string::npos) end = query.length();
+            size_t equal = query.find('=', start);
+            if (equal == std::string::npos || equal > end) equal = end;
+            std::string name = query.substr(start, equal - start);
+            std::string value = equal + 1 < end ? query.substr(equal + 1, end - equal - 1) : std::string();
+            params.push_back(new BaselineParam(urlDecode(name), urlDecode(value)));
+            start = end + 1;
+        }
+    }
+
+    static std::string urlDecode(const std::string& text) {
+        char hex[] = "0x00";
+        size_t len = text.length();
+        size_t i = 0;
+        std::string decoded;
+        decoded.reserve(len);
+        while (i < len) {
+            char c = text[i++];
+            if (c == '%' && i + 1 < len) {
+                hex[2] = text[i++];
+                hex[3] = text[i++];
+                c = (char)strtol(hex, nullptr, 16);
+            } else if (c == '+') {
+                c = ' ';
+            }
+            decoded += c;
+        }
+        return decoded;
+    }
+
+    const BaselineHeader* header(const char* name) const {
+        for (const BaselineHeader* h : headers) {
+            if (equalsIgnoreCase(h->name, name)) return h;
+        }
+        return nullptr;
+    }
+
+    const BaselineParam* param(const char* name) const {
+        for (const BaselineParam* p : params) {
+            if (p->name == name) return p;
+        }
+        return nullptr;
+    }
+
+    State state;
+    std::string temp;
+    uint8_t method;
+    uint8_t version;
+    std::string url, host, contentType;
+    size_t contentLength;
+    bool expectingContinue;
+    std::list<std::string> interesting;
+    std::list<BaselineHeader*> headers;
+    std::list<BaselineParam*> params;
+};
+
+// Deterministic segment boundaries: most requests arrive whole, some in
+// two or three pieces, cut anywhere
+static uint32_t lcg(uint32_t& state) {
+    state = state * 1664525u + 1013904223u;
+    return state >> 8;
+}
+
+struct Segmented {
+    const char* data;
+    size_t len;
+    size_t cuts[4];
+    size_t cutCount;
+};
+
+void test_benchmark_request_parsing(void) {
+    const char* mix[] = {CHROME_GET, CHROME_GET, CHROME_GET, CHROME_CARD, DISPLAY_GET, A2A_POST};
+    const size_t mixCount = sizeof(mix) / sizeof(mix[0]);
+    const size_t count = 600;
+    static Segmented requests[count];
+    uint32_t seed = 42;
+    for (size_t i = 0; i < count; i++) {
+        Segmented& r = requests[i];
+        r.data = mix[i % mixCount];
+        r.len = strlen(r.data);
+        r.cutCount = lcg(seed) % 3;
+        for (size_t c = 0; c < r.cutCount; c++) r.cuts[c] = 1 + lcg(seed) % (r.len - 1);
+        for (size_t a = 0; a < r.cutCount; a++) {
+            for (size_t b = a + 1; b < r.cutCount; b++) {
+                if (r.cuts[b] < r.cuts[a]) std::swap(r.cuts[a], r.cuts[b]);
+            }
+        }
+    }
+    // The baseline writes into the segment it is given, as it does into lwIP's pbuf
+    static char copies[count][1024];
+    for (size_t i = 0; i < count; i++) memcpy(copies[i], requests[i].data, requests[i].len);
+
+    const int rounds = 40;
+    size_t checks[2] = {0, 0};
+
+    size_t allocsBefore = heapAllocs;
+    size_t bytesBefore = heapBytes;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            const Segmented& r = requests[i];
+            BaselineRequest* request = new BaselineRequest();
+            size_t from = 0;
+            for (size_t c = 0; c <= r.cutCount && request->state < BaselineRequest::BODY; c++) {
+                size_t to = c < r.cutCount ? r.cuts[c] : r.len;
+                if (to > from) request->onData(copies[i] + from, to - from);
+                from = to;
+            }
+            // What the handler then looks at
+            const BaselineParam* text = request->param("text");
+            const BaselineHeader* match = request->header("If-None-Match");
+            checks[0] += request->url.length() + (text ? text->value.length() : 0) +
+                         (match ? match->value.length() : 0) + request->contentLength;
+            delete request;
+        }
+    }
+    auto baselined = std::chrono::steady_clock::now();
+    size_t baselineAllocs = heapAllocs - allocsBefore;
+    size_t baselineBytes = heapBytes - bytesBefore;
+
+    static char arena[1024];
+    HttpRequestParser parser(arena, sizeof(arena), KEEP);
+    allocsBefore = heapAllocs;
+    auto parsedStart = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < count; i++) {
+            const Segmented& r = requests[i];
+            parser.reset();
+            HttpRequestParser::Result result = HttpRequestParser::NEED_MORE;
+            size_t from = 0;
+            for (size_t c = 0; c <= r.cutCount && result == HttpRequestParser::NEED_MORE; c++) {
+                size_t to = c < r.cutCount ? r.cuts[c] : r.len;
+                size_t used;
+                if (to > from) result = parser.feed((const uint8_t*)r.data + from, to - from, used);
+                from = to;
+            }
+            char text[128];
+            bool hasText = parser.param("text", text, sizeof(text));
+            const char* match = parser.header("If-None-Match");
+            checks[1] += parser.pathLength() + (hasText ? strlen(text) : 0) + (match ? strlen(match) : 0) +
+                         parser.contentLength();
+        }
+    }
+    auto parsed = std::chrono::steady_clock::now();
+    size_t parserAllocs = heapAllocs - allocsBefore;
+
+    // Both saw the same paths, values and lengths
+    TEST_ASSERT_EQUAL(checks[0], checks[1]);
+    TEST_ASSERT_EQUAL(0, (int)parserAllocs);
+
+    double requestsParsed = (double)rounds * count;
+    double baselineNs = std::chrono::duration<double, std::nano>(baselined - start).count() / requestsParsed;
+    double parserNs = std::chrono::duration<double, std::nano>(parsed - parsedStart).count() / requestsParsed;
+    size_t bytes = 0;
+    for (size_t i = 0; i < mixCount; i++) bytes += strlen(mix[i]);
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u requests x %d, %u B average, in 1-3 segments",
+             (unsigned)count, rounds, (unsigned)(bytes / mixCount));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "AsyncWebServer  %7.1f ns/request | %.1f heap allocs, %.0f B allocated/request",
+             baselineNs, baselineAllocs / requestsParsed, baselineBytes / requestsParsed);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "arena parser    %7.1f ns/request | 0 heap allocs, %u B arena | x%.1f",
+             parserNs, (unsigned)sizeof(arena), baselineNs / parserNs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(parserNs < baselineNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_request_line_and_kept_headers);
+    RUN_TEST(test_every_split_point);
+    RUN_TEST(test_body_and_pipelined_request);
+    RUN_TEST(test_connection_expect_and_versions);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_path_and_params_decoding);
+    RUN_TEST(test_benchmark_request_parsing);
+    return UNITY_END();
+}
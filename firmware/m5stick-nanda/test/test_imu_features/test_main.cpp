@@ -0,0 +1,429 @@
+/**
+ * Golden tests and benchmark for IMU feature extraction.
+ *
+ * Synthetic recordings with known answers (gravity at a set tilt, pure
+ * vibration lines, taps, shaking) go through the extractor, and its
+ * kernels are checked against a straightforward double-precision
+ * reference: two-pass statistics and a direct DFT with the same window
+ * and scaling. The benchmark times the kernels against that reference.
+ *
+ *   pio test -e native -f test_imu_features
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include <ImuFeatures.h>
+
+#define N IMU_FEATURE_WINDOW
+static const double PI = 3.14159265358979;
+
+static uint32_t seed = 12345;
+static float noise(float amplitude) {
+    seed = seed * 1664525u + 1013904223u;
+    return ((seed >> 8) / 16777216.0f * 2 - 1) * amplitude;
+}
+
+// ---------------------------------------------------------------------------
+// Reference implementation
+// ---------------------------------------------------------------------------
+
+static void referenceStats(const float* x, size_t n, double& mean, double& variance, double& rms) {
+    double sum = 0, squares = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += x[i];
+        squares += (double)x[i] * x[i];
+    }
+    mean = sum / n;
+    double spread = 0;
+    for (size_t i = 0; i < n; i++) spread += (x[i] - mean) * (x[i] - mean);
+    variance = spread / n;
+    rms = sqrt(squares / n);
+}
+
+// DFT / n, as fftQ15 scales it
+static void referenceDft(const std::vector<double>& x, std::vector<double>& re, std::vector<double>& im) {
+    size_t n = x.size();
+    re.assign(n, 0);
+    im.assign(n, 0);
+    for (size_t k = 0; k < n; k++) {
+        for (size_t t = 0; t < n; t++) {
+            re[k] += x[t] * cos(2 * PI * k * t / n);
+            im[k] -= x[t] * sin(2 * PI * k * t / n);
+        }
+        re[k] /= n;
+        im[k] /= n;
+    }
+}
+
+struct ReferenceSpectrum {
+    double peakHz, peakG;
+    double bands[IMU_FEATURE_BANDS];
+};
+
+// |accel| of the window around its mean, Hann-windowed, in g
+static ReferenceSpectrum referenceSpectrum(const std::vector<ImuSample>& window, double sampleHz) {
+    std::vector<double> m(window.size());
+    double mean = 0;
+    for (size_t i = 0; i < window.size(); i++) {
+        const ImuSample& s = window[i];
+        m[i] = sqrt((double)s.accelX * s.accelX + (double)s.accelY * s.accelY + (double)s.accelZ * s.accelZ);
+        mean += m[i];
+    }
+    mean /= m.size();
+    for (size_t i = 0; i < m.size(); i++) m[i] = (m[i] - mean) * 0.5 * (1 - cos(2 * PI * i / m.size()));
+
+    std::vector<double> re, im;
+    referenceDft(m, re, im);
+    ReferenceSpectrum r = {};
+    double peak = 0;
+    for (size_t k = 1; k < m.size() / 2; k++) {
+        double p = re[k] * re[k] + im[k] * im[k];
+        if (p > peak) {
+            peak = p;
+            r.peakHz = k * sampleHz / m.size();
+        }
+        r.bands[k * IMU_FEATURE_BANDS / (m.size() / 2)] += p;
+    }
+    r.peakG = 4 * sqrt(peak);
+    for (double& b : r.bands) b = sqrt(2 * b / 0.375);
+    return r;
+}
+
+// ---------------------------------------------------------------------------
+// Recordings
+// ---------------------------------------------------------------------------
+
+// Still at a tilt: gravity for this pitch and roll (degrees)
+static ImuSample tilted(uint32_t n, float pitch, float roll, float sampleHz) {
+    float p = pitch * (float)PI / 180;
+    float r = roll * (float)PI / 180;
+    return {(uint32_t)(n * 1e6f / sampleHz), -sinf(p), cosf(p) * sinf(r), cosf(p) * cosf(r), 0, 0, 0};
+}
+
+// Flat, vibrating along z: amplitude in g at Hz
+struct Line {
+    float hz;
+    float g;
+};
+static std::vector<ImuSample> vibrating(size_t count, float sampleHz, const std::vector<Line>& lines) {
+    std::vector<ImuSample> out;
+    for (size_t n = 0; n < count; n++) {
+        float z = 1;
+        for (const Line& l : lines) z += l.g * sinf(2 * (float)PI * l.hz * n / sampleHz);
+        out.push_back({(uint32_t)(n * 1e6f / sampleHz), 0, 0, z, noise(1), noise(1), noise(1)});
+    }
+    return out;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+// ---------------------------------------------------------------------------
+// Kernels against the reference
+// ---------------------------------------------------------------------------
+
+void test_axis_stats_match_reference(void) {
+    std::vector<float> x(301);
+    for (size_t n : {1, 2, 3, 5, 64, 127, 128, 301}) {
+        float offset = n % 2 ? 9.81f : -0.5f;   // A large mean over a small spread too
+        for (size_t i = 0; i < n; i++) x[i] = offset + noise(0.05f);
+        double mean, variance, rms;
+        referenceStats(x.data(), n, mean, variance, rms);
+        AxisStats s = axisStats(x.data(), n);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f * fabs(mean) + 1e-7f, mean, s.mean);
+        TEST_ASSERT_FLOAT_WITHIN(1e-4f * variance + 1e-8f, variance, s.variance);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f * rms, rms, s.rms);
+    }
+    AxisStats empty = axisStats(x.data(), 0);
+    TEST_ASSERT_EQUAL_FLOAT(0, empty.rms);
+}
+
+void test_fft_matches_reference_dft(void) {
+    int16_t cosTable[N / 2], sinTable[N / 2];
+    for (int k = 0; k < N / 2; k++) {
+        cosTable[k] = (int16_t)lround(32767 * cos(2 * PI * k / N));
+        sinTable[k] = (int16_t)lround(32767 * sin(2 * PI * k / N));
+    }
+    int16_t re[N], im[N];
+    std::vector<double> x(N), refRe, refIm;
+    for (int trial = 0; trial < 4; trial++) {
+        for (int i = 0; i < N; i++) {
+            // Full-scale noise, and a line that lands between bins
+            x[i] = trial < 2 ? (double)(int)noise(32000) : 20000 * sin(2 * PI * 10.3 * i / N);
+            re[i] = (int16_t)x[i];
+            im[i] = 0;
+        }
+        fftQ15(re, im, N, cosTable, sinTable);
+        referenceDft(x, refRe, refIm);
+        double worst = 0;
+        for (int k = 0; k < N; k++) {
+            worst = fmax(worst, fabs(re[k] - refRe[k]));
+            worst = fmax(worst, fabs(im[k] - refIm[k]));
+        }
+        // Rounding in each of the log2(N) stages, halved by the ones after it
+        TEST_ASSERT_TRUE(worst <= 2.5);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Golden recordings through the extractor
+// ---------------------------------------------------------------------------
+
+void test_vibration_spectrum(void) {
+    const float hz = 100;
+    ImuFeatureExtractor features;
+    features.begin(hz);
+    // Bin 24 (18.75 Hz, band 1) strong, bin 40 (31.25 Hz, band 2) weak
+    std::vector<ImuSample> window = vibrating(N, hz, {{18.75f, 0.3f}, {31.25f, 0.1f}});
+    features.add(window.data(), window.size());
+
+    ImuFeatures f;
+    TEST_ASSERT_TRUE(features.summarize(f));
+    ReferenceSpectrum ref = referenceSpectrum(window, hz);
+    TEST_ASSERT_EQUAL_FLOAT(ref.peakHz, f.peakHz);
+    TEST_ASSERT_EQUAL_FLOAT(18.75f, f.peakHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, ref.peakG, f.peakG);
+    TEST_ASSERT_FLOAT_WITHIN(0.006f, 0.3f, f.peakG);
+    TEST_ASSERT_EQUAL_FLOAT(12.5f, f.bandHz);
+    for (int b = 0; b < IMU_FEATURE_BANDS; b++) {
+        TEST_ASSERT_FLOAT_WITHIN(0.003f, ref.bands[b], f.bands[b]);
+    }
+    // Band RMS is the lines' RMS, amplitude / sqrt(2)
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.3f / sqrtf(2), f.bands[1]);
+    TEST_ASSERT_FLOAT_WITHIN(0.005f, 0.1f / sqrtf(2), f.bands[2]);
+    TEST_ASSERT_TRUE(f.bands[0] < 0.01f && f.bands[3] < 0.01f);
+
+    // The statistics, against the reference over the same window
+    std::vector<float> axis(N);
+    for (int a = 0; a < IMU_FEATURE_AXES; a++) {
+        for (int i = 0; i < N; i++) axis[i] = (&window[i].accelX)[a];
+        double mean, variance, rms;
+        referenceStats(axis.data(), N, mean, variance, rms);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, mean, f.mean[a]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, variance, f.variance[a]);
+        TEST_ASSERT_FLOAT_WITHIN(1e-5f, rms, f.rms[a]);
+    }
+    TEST_ASSERT_EQUAL(N, f.samples);
+    TEST_ASSERT_EQUAL(window.back().usec, f.usec);
+}
+
+void test_spectrum_only_for_a_full_window(void) {
+    ImuFeatureExtractor features;
+    ImuFeatures f;
+    TEST_ASSERT_FALSE(features.summarize(f));
+
+    std::vector<ImuSample> window = vibrating(N / 2, 100, {{18.75f, 0.3f}});
+    features.add(window.data(), window.size());
+    TEST_ASSERT_TRUE(features.summarize(f));
+    TEST_ASSERT_EQUAL(N / 2, f.samples);
+    TEST_ASSERT_EQUAL_FLOAT(0, f.peakHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.3f / sqrtf(2), sqrtf(f.variance[IMU_ACCEL_Z]));
+}
+
+void test_window_slides(void) {
+    ImuFeatureExtractor features;
+    features.begin(100);
+    // A loud line, then enough of a quiet one to push it out of the window
+    std::vector<ImuSample> loud = vibrating(N, 100, {{18.75f, 0.5f}});
+    std::vector<ImuSample> quiet = vibrating(N + 7, 100, {{31.25f, 0.05f}});
+    features.add(loud.data(), loud.size());
+    features.add(quiet.data(), quiet.size());
+
+    ImuFeatures f;
+    features.summarize(f);
+    std::vector<ImuSample> last(quiet.end() - N, quiet.end());
+    ReferenceSpectrum ref = referenceSpectrum(last, 100);
+    TEST_ASSERT_EQUAL_FLOAT(31.25f, f.peakHz);
+    TEST_ASSERT_FLOAT_WITHIN(0.003f, ref.peakG, f.peakG);
+}
+
+void test_tilt(void) {
+    const float angles[][2] = {{0, 0}, {30, -20}, {-60, 45}, {10, 170}};
+    for (const auto& a : angles) {
+        ImuFeatureExtractor features;
+        std::vector<ImuSample> still;
+        for (int n = 0; n < 50; n++) {
+            ImuSample s = tilted(n, a[0], a[1], 100);
+            s.accelX += noise(0.01f);
+            still.push_back(s);
+        }
+        features.add(still.data(), still.size());
+        ImuFeatures f;
+        features.summarize(f);
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, a[0], f.pitch);
+        TEST_ASSERT_FLOAT_WITHIN(0.5f, a[1], f.roll);
+        TEST_ASSERT_FALSE(f.shaking);
+        TEST_ASSERT_EQUAL(0, f.taps);
+    }
+}
+
+void test_taps_and_shakes(void) {
+    const float hz = 100;
+    ImuFeatureExtractor features;
+    features.begin(hz);
+    ImuFeatures f;
+    uint32_t n = 0;
+    auto still = [&](int count) {
+        for (int i = 0; i < count; i++, n++) {
+            ImuSample s = tilted(n, 0, 0, hz);
+            s.accelZ += noise(0.02f);
+            features.add(&s, 1);
+        }
+    };
+    auto tap = [&](float g) {
+        ImuSample s = tilted(n++, 0, 0, hz);
+        s.accelZ += g;
+        features.add(&s, 1);
+    };
+
+    still(50);
+    tap(1.5f);
+    still(100);
+    TEST_ASSERT_TRUE(features.summarize(f));
+    TEST_ASSERT_EQUAL(1, f.taps);
+    TEST_ASSERT_EQUAL(tilted(50, 0, 0, hz).usec, f.lastTapUsec);
+
+    // The ring-down of one knock within the refractory time counts once
+    tap(1.5f);
+    still(5);
+    tap(1.2f);
+    still(100);
+    // Too soft to be a tap
+    tap(0.4f);
+    still(100);
+    features.summarize(f);
+    TEST_ASSERT_EQUAL(2, f.taps);
+    TEST_ASSERT_FALSE(f.shaking);
+
+    // Shaking at 4 Hz: one shake, and no taps out of it
+    for (int i = 0; i < 200; i++, n++) {
+        ImuSample s = tilted(n, 0, 0, hz);
+        s.accelZ += 1.2f * sinf(2 * (float)PI * 4 * i / hz);
+        s.accelX += 0.8f * cosf(2 * (float)PI * 4 * i / hz);
+        features.add(&s, 1);
+        if (i % 20 == 19) features.summarize(f);
+    }
+    TEST_ASSERT_TRUE(f.shaking);
+    TEST_ASSERT_EQUAL(1, f.shakes);
+    TEST_ASSERT_EQUAL(2, f.taps);
+    TEST_ASSERT_FLOAT_WITHIN(0.5f, 4, f.peakHz);
+
+    still(N);
+    features.summarize(f);
+    TEST_ASSERT_FALSE(f.shaking);
+    TEST_ASSERT_EQUAL(1, f.shakes);
+}
+
+void test_follows_the_ring(void) {
+    static ImuRing ring;
+    ImuFeatureExtractor features;
+    for (uint32_t n = 0; n < 300; n++) ring.push(tilted(n, 0, 0, 100));
+
+    // The first update starts with the last window's worth of history
+    features.update(ring);
+    ImuFeatures f;
+    features.summarize(f);
+    TEST_ASSERT_EQUAL(N, f.samples);
+    TEST_ASSERT_EQUAL(tilted(299, 0, 0, 100).usec, f.usec);
+    TEST_ASSERT_EQUAL(0, features.dropped());
+
+    for (uint32_t n = 300; n < 310; n++) ring.push(tilted(n, 0, 0, 100));
+    features.update(ring);
+    features.summarize(f);
+    TEST_ASSERT_EQUAL(tilted(309, 0, 0, 100).usec, f.usec);
+
+    // Far behind: what the ring no longer has is counted
+    for (uint32_t n = 310; n < 1310; n++) ring.push(tilted(n, 0, 0, 100));
+    features.update(ring);
+    TEST_ASSERT_EQUAL(1000 - IMU_RING_SAMPLES, features.dropped());
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+typedef std::chrono::steady_clock Clock;
+
+static double usSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+}
+
+void test_benchmark(void) {
+    ImuFeatureExtractor features;
+    features.begin(100);
+    std::vector<ImuSample> recording = vibrating(4096, 100, {{18.75f, 0.3f}, {7, 0.2f}});
+    char msg[160];
+    volatile float sink = 0;
+
+    // Samples in: transpose, magnitude, tap detector, window
+    const int passes = 200;
+    Clock::time_point start = Clock::now();
+    for (int p = 0; p < passes; p++) features.add(recording.data(), recording.size());
+    double addUs = usSince(start) / (passes * recording.size());
+
+    // A summary: stats of 7 arrays, FFT, spectrum
+    const int summaries = 20000;
+    ImuFeatures f;
+    start = Clock::now();
+    for (int i = 0; i < summaries; i++) {
+        features.summarize(f);
+        sink = sink + f.peakG;
+    }
+    double summaryUs = usSince(start) / summaries;
+
+    // The reference for the same window: double statistics and a direct DFT
+    std::vector<ImuSample> window(recording.end() - N, recording.end());
+    const int refRuns = 200;
+    start = Clock::now();
+    for (int i = 0; i < refRuns; i++) {
+        std::vector<float> axis(N);
+        for (int a = 0; a < IMU_FEATURE_AXES; a++) {
+            for (int k = 0; k < N; k++) axis[k] = (&window[k].accelX)[a];
+            double mean, variance, rms;
+            referenceStats(axis.data(), N, mean, variance, rms);
+            sink = sink + (float)rms;
+        }
+        sink = sink + (float)referenceSpectrum(window, 100).peakG;
+    }
+    double referenceUs = usSince(start) / refRuns;
+
+    int16_t cosTable[N / 2] = {}, sinTable[N / 2] = {};
+    int16_t re[N] = {}, im[N] = {};
+    for (int k = 0; k < N / 2; k++) cosTable[k] = (int16_t)lround(32767 * cos(2 * PI * k / N));
+    const int ffts = 100000;
+    start = Clock::now();
+    for (int i = 0; i < ffts; i++) {
+        re[i % N] = (int16_t)i;
+        fftQ15(re, im, N, cosTable, sinTable);
+    }
+    double fftUs = usSince(start) / ffts;
+
+    snprintf(msg, sizeof(msg), "add       | %.3f us per sample (%.1f M samples/s)", addUs, 1 / addUs);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "summarize | %.2f us per %d-sample window (FFT alone %.2f us)", summaryUs, N, fftUs);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "reference | %.1f us per window (double stats + direct DFT): %.0fx slower", referenceUs,
+             referenceUs / summaryUs);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_TRUE(summaryUs < referenceUs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_axis_stats_match_reference);
+    RUN_TEST(test_fft_matches_reference_dft);
+    RUN_TEST(test_vibration_spectrum);
+    RUN_TEST(test_spectrum_only_for_a_full_window);
+    RUN_TEST(test_window_slides);
+    RUN_TEST(test_tilt);
+    RUN_TEST(test_taps_and_shakes);
+    RUN_TEST(test_follows_the_ring);
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
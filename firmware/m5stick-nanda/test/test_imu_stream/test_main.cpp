@@ -0,0 +1,295 @@
+/**
+ * Host tests and load test for the binary IMU stream.
+ *
+ * A fake IMU pushes samples into the sampler's ring on a simulated 1 ms
+ * clock, the way the sampler task does on the device. Each simulated
+ * client has a send queue of WS_MAX_QUEUED_MESSAGES-like depth and a link
+ * that drains it at a fixed bandwidth; streams are polled while the
+ * queue has room, as the firmware does with availableForWrite(). Frames
+ * are decoded back on arrival to measure delivered rate, bandwidth,
+ * sample-to-arrival latency and drops.
+ *
+ *   pio test -e native -f test_imu_stream
+ */
+
+#include <unity.h>
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include <ImuStream.h>
+
+struct Decoded {
+    uint8_t version;
+    uint16_t dropped;
+    uint16_t rate;
+    std::vector<uint32_t> usec;
+    std::vector<ImuSample> samples;
+};
+
+static uint16_t le16(const uint8_t* p) {
+    return p[0] | p[1] << 8;
+}
+
+static Decoded decode(const uint8_t* frame, size_t len) {
+    Decoded d;
+    d.version = frame[0];
+    int count = frame[1];
+    d.dropped = le16(frame + 2);
+    uint32_t usec = le16(frame + 4) | (uint32_t)le16(frame + 6) << 16;
+    d.rate = le16(frame + 8);
+    TEST_ASSERT_EQUAL(IMU_STREAM_HEADER_BYTES + count * IMU_STREAM_SAMPLE_BYTES, len);
+
+    const uint8_t* p = frame + IMU_STREAM_HEADER_BYTES;
+    for (int i = 0; i < count; i++, p += IMU_STREAM_SAMPLE_BYTES) {
+        usec += le16(p) * IMU_STREAM_DT_US;
+        ImuSample s;
+        s.usec = usec;
+        s.accelX = (int16_t)le16(p + 2) / (float)IMU_STREAM_ACCEL_LSB;
+        s.accelY = (int16_t)le16(p + 4) / (float)IMU_STREAM_ACCEL_LSB;
+        s.accelZ = (int16_t)le16(p + 6) / (float)IMU_STREAM_ACCEL_LSB;
+        s.gyroX = (int16_t)le16(p + 8) / (float)IMU_STREAM_GYRO_LSB;
+        s.gyroY = (int16_t)le16(p + 10) / (float)IMU_STREAM_GYRO_LSB;
+        s.gyroZ = (int16_t)le16(p + 12) / (float)IMU_STREAM_GYRO_LSB;
+        d.usec.push_back(usec);
+        d.samples.push_back(s);
+    }
+    return d;
+}
+
+// Sample n of the fake IMU: a slow wobble with the index in accelX
+static ImuSample fakeSample(uint32_t n, uint32_t periodUs) {
+    float t = n * periodUs / 1e6f;
+    return {n * periodUs + 1000000, n / 4096.0f, sinf(t * 6.28f) * 2, 1.0f, 100 * cosf(t), -5.5f, 0.25f};
+}
+
+static ImuRing ring;
+
+// Fresh ring for each test: push enough to lap any leftovers, then note the base
+static uint32_t fakeIndex;
+static void resetRing() {
+    fakeIndex = 0;
+    while (ring.written() % IMU_RING_SAMPLES) ring.push({});
+}
+
+static void pushFake(uint32_t count, uint32_t periodUs) {
+    for (uint32_t i = 0; i < count; i++) {
+        ring.push(fakeSample(fakeIndex++, periodUs));
+    }
+}
+
+void setUp(void) {
+    resetRing();
+}
+
+void tearDown(void) {}
+
+void test_frames_decode_back_to_the_samples(void) {
+    ImuStream stream;
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+    stream.begin(ring, 100, 100, 10);
+    TEST_ASSERT_EQUAL(0, stream.poll(frame));
+
+    pushFake(9, 10000);
+    TEST_ASSERT_EQUAL(0, stream.poll(frame));   // Not a full batch yet
+    pushFake(11, 10000);
+
+    for (int f = 0; f < 2; f++) {
+        size_t len = stream.poll(frame);
+        TEST_ASSERT_EQUAL(IMU_STREAM_HEADER_BYTES + 10 * IMU_STREAM_SAMPLE_BYTES, len);
+        Decoded d = decode(frame, len);
+        TEST_ASSERT_EQUAL(IMU_STREAM_VERSION, d.version);
+        TEST_ASSERT_EQUAL(0, d.dropped);
+        TEST_ASSERT_EQUAL(100, d.rate);
+        for (int i = 0; i < 10; i++) {
+            ImuSample want = fakeSample(f * 10 + i, 10000);
+            TEST_ASSERT_EQUAL(want.usec, d.usec[i]);
+            TEST_ASSERT_FLOAT_WITHIN(0.5f / IMU_STREAM_ACCEL_LSB, want.accelX, d.samples[i].accelX);
+            TEST_ASSERT_FLOAT_WITHIN(0.5f / IMU_STREAM_ACCEL_LSB, want.accelY, d.samples[i].accelY);
+            TEST_ASSERT_FLOAT_WITHIN(0.5f / IMU_STREAM_GYRO_LSB, want.gyroX, d.samples[i].gyroX);
+            TEST_ASSERT_FLOAT_WITHIN(0.5f / IMU_STREAM_GYRO_LSB, want.gyroY, d.samples[i].gyroY);
+        }
+    }
+    TEST_ASSERT_EQUAL(0, stream.poll(frame));
+    TEST_ASSERT_EQUAL(2, stream.frames());
+    TEST_ASSERT_EQUAL(20, stream.samples());
+}
+
+void test_rate_decimates_and_picks_batch(void) {
+    ImuStream stream;
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+
+    // 1 kHz down to 250 Hz: every 4th sample, about 50 ms per frame
+    stream.begin(ring, 1000, 250);
+    TEST_ASSERT_EQUAL(250, stream.rate());
+    TEST_ASSERT_EQUAL(12, stream.batch());
+    pushFake(100, 1000);
+    size_t len = stream.poll(frame);
+    Decoded d = decode(frame, len);
+    TEST_ASSERT_EQUAL(250, d.rate);
+    TEST_ASSERT_EQUAL(12, d.samples.size());
+    for (int i = 0; i < 12; i++) {
+        TEST_ASSERT_EQUAL(fakeSample(i * 4, 1000).usec, d.usec[i]);
+    }
+
+    // The full rate is capped at the batch limit; too low a rate is raised
+    stream.begin(ring, 1000, 5000);
+    TEST_ASSERT_EQUAL(1000, stream.rate());
+    TEST_ASSERT_EQUAL(IMU_STREAM_BATCH_MAX, stream.batch());
+    stream.begin(ring, 100, 0);
+    TEST_ASSERT_EQUAL(IMU_STREAM_RATE_MIN, stream.rate());
+    TEST_ASSERT_EQUAL(1, stream.batch());
+}
+
+void test_client_behind_loses_the_oldest_samples(void) {
+    ImuStream stream;
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+    stream.begin(ring, 1000, 1000, 16);
+
+    // Nobody polled for a second: only the newest IMU_STREAM_MAX_LAG are kept
+    pushFake(1000, 1000);
+    size_t len = stream.poll(frame);
+    Decoded d = decode(frame, len);
+    TEST_ASSERT_EQUAL(1000 - IMU_STREAM_MAX_LAG, d.dropped);
+    TEST_ASSERT_EQUAL(fakeSample(1000 - IMU_STREAM_MAX_LAG, 1000).usec, d.usec[0]);
+
+    // Then it carries on from there with nothing more lost
+    len = stream.poll(frame);
+    d = decode(frame, len);
+    TEST_ASSERT_EQUAL(0, d.dropped);
+    TEST_ASSERT_EQUAL(fakeSample(1000 - IMU_STREAM_MAX_LAG + 16, 1000).usec, d.usec[0]);
+    TEST_ASSERT_EQUAL(1000 - IMU_STREAM_MAX_LAG, stream.dropped());
+}
+
+void test_values_out_of_range_saturate(void) {
+    ImuStream stream;
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+    stream.begin(ring, 100, 100, 1);
+    ring.push({5, 20.0f, -20.0f, 0, 4000.0f, -4000.0f, 0});
+    Decoded d = decode(frame, stream.poll(frame));
+    TEST_ASSERT_EQUAL_FLOAT(32767.0f / IMU_STREAM_ACCEL_LSB, d.samples[0].accelX);
+    TEST_ASSERT_EQUAL_FLOAT(-32768.0f / IMU_STREAM_ACCEL_LSB, d.samples[0].accelY);
+    TEST_ASSERT_EQUAL_FLOAT(32767.0f / IMU_STREAM_GYRO_LSB, d.samples[0].gyroX);
+    TEST_ASSERT_EQUAL_FLOAT(-32768.0f / IMU_STREAM_GYRO_LSB, d.samples[0].gyroY);
+}
+
+// A client: its stream, a send queue and a link of fixed bandwidth
+struct FakeClient {
+    const char* name;
+    uint16_t rate;
+    uint32_t bytesPerMs;
+    ImuStream stream;
+    std::deque<std::vector<uint8_t>> queue;
+    size_t drainedOfHead = 0;
+    uint64_t bytes = 0;
+    uint64_t samples = 0;
+    uint64_t dropped = 0;
+    std::vector<double> latencyMs;
+};
+
+#define CLIENT_QUEUE 8
+
+void test_load_fake_imu_to_clients(void) {
+    const uint32_t sampleHz = 1000;
+    const uint32_t seconds = 10;
+    FakeClient clients[] = {
+        {"1 kHz, fast link", 1000, 1000},
+        {"1 kHz, 8 KB/s", 1000, 8},
+        {"100 Hz, 8 KB/s", 100, 8},
+    };
+    for (FakeClient& c : clients) c.stream.begin(ring, sampleHz, c.rate);
+
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+    for (uint32_t ms = 0; ms < seconds * 1000; ms++) {
+        pushFake(1, 1000);   // The IMU sample of this millisecond
+        uint32_t nowUs = fakeSample(fakeIndex - 1, 1000).usec;
+
+        for (FakeClient& c : clients) {
+            // Poll while the queue has room, as loop() does
+            while (c.queue.size() < CLIENT_QUEUE) {
+                size_t len = c.stream.poll(frame);
+                if (!len) break;
+                c.queue.emplace_back(frame, frame + len);
+            }
+            // The link carries bytesPerMs; a frame arrives once all of it has
+            uint32_t budget = c.bytesPerMs;
+            while (budget && !c.queue.empty()) {
+                std::vector<uint8_t>& head = c.queue.front();
+                size_t take = std::min<size_t>(budget, head.size() - c.drainedOfHead);
+                c.drainedOfHead += take;
+                budget -= take;
+                if (c.drainedOfHead < head.size()) break;
+
+                Decoded d = decode(head.data(), head.size());
+                for (uint32_t usec : d.usec) c.latencyMs.push_back((nowUs - usec) / 1000.0);
+                c.samples += d.samples.size();
+                c.dropped += d.dropped;
+                c.bytes += head.size();
+                c.queue.pop_front();
+                c.drainedOfHead = 0;
+            }
+        }
+    }
+
+    char msg[200];
+    for (FakeClient& c : clients) {
+        std::vector<double>& l = c.latencyMs;
+        std::sort(l.begin(), l.end());
+        double mean = 0;
+        for (double v : l) mean += v;
+        mean /= l.size();
+        snprintf(msg, sizeof(msg),
+                 "%-17s| %6.0f samples/s %6.0f B/s (%.1f B/sample) | latency mean %6.1f p99 %6.1f ms | dropped %llu",
+                 c.name, c.samples / (double)seconds, c.bytes / (double)seconds, c.bytes / (double)c.samples, mean,
+                 l[l.size() * 99 / 100], (unsigned long long)c.dropped);
+        TEST_MESSAGE(msg);
+    }
+
+    // A link that keeps up gets every sample, a frame's batch late at most
+    TEST_ASSERT_EQUAL(0, clients[0].dropped);
+    TEST_ASSERT_TRUE(clients[0].samples >= seconds * 1000 - IMU_STREAM_BATCH_MAX);
+    TEST_ASSERT_TRUE(clients[0].latencyMs.back() <= IMU_STREAM_BATCH_MAX + 1);
+    // One that cannot loses samples, yet stays within the lag bound plus its queue
+    uint32_t frameMs = IMU_STREAM_FRAME_MAX / clients[1].bytesPerMs + 1;
+    TEST_ASSERT_TRUE(clients[1].dropped > 0);
+    TEST_ASSERT_TRUE(clients[1].latencyMs.back() <= IMU_STREAM_MAX_LAG + (CLIENT_QUEUE + 1) * frameMs);
+    // A lower rate fits the same link
+    TEST_ASSERT_EQUAL(0, clients[2].dropped);
+}
+
+void test_benchmark_packing(void) {
+    ImuStream stream;
+    uint8_t frame[IMU_STREAM_FRAME_MAX];
+    stream.begin(ring, 1000, 1000, IMU_STREAM_BATCH_MAX);
+    const int frames = 200000;
+    size_t bytes = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; i++) {
+        pushFake(IMU_STREAM_BATCH_MAX, 1000);
+        bytes += stream.poll(frame);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "packing  | %.3f us per %d-sample frame (with the pushes), %.1f M samples/s, %u B/frame",
+             us / frames, IMU_STREAM_BATCH_MAX, frames * (double)IMU_STREAM_BATCH_MAX / us,
+             (unsigned)(bytes / frames));
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_EQUAL(frames, stream.frames());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_decode_back_to_the_samples);
+    RUN_TEST(test_rate_decimates_and_picks_batch);
+    RUN_TEST(test_client_behind_loses_the_oldest_samples);
+    RUN_TEST(test_values_out_of_range_saturate);
+    RUN_TEST(test_load_fake_imu_to_clients);
+    RUN_TEST(test_benchmark_packing);
+    return UNITY_END();
+}
@@ -0,0 +1,233 @@
+/**
+ * Host tests for the table-driven JSON-RPC dispatcher.
+ *
+ * Skills are stand-ins that record their calls. The last test compares
+ * the old dispatch path (skill output serialized to a string, then parsed
+ * into a second document) with handlers writing into the response.
+ *
+ *   pio test -e native -f test_json_rpc
+ */
+
+#include <unity.h>
+
+#include <string>
+
+#include <JsonRpcDispatcher.h>
+
+#include "../support/CountingAllocator.h"
+
+static int calls[4];
+static std::string lastText;
+
+static bool readSensors(JsonVariantConst, JsonObject out) {
+    calls[0]++;
+    JsonObject accel = out["accelerometer"].to<JsonObject>();
+    accel["x"] = 0.01;
+    accel["y"] = -0.02;
+    accel["z"] = 0.98;
+    out["temperature"] = 31.5;
+    return true;
+}
+
+static bool batteryStatus(JsonVariantConst, JsonObject out) {
+    calls[1]++;
+    out["voltage"] = 4.05;
+    out["percent"] = 87;
+    out["isCharging"] = false;
+    return true;
+}
+
+static bool buttonStatus(JsonVariantConst, JsonObject out) {
+    calls[2]++;
+    out["btnA"] = true;
+    out["btnB"] = false;
+    out["btnPwr"] = false;
+    return true;
+}
+
+static bool displayShow(JsonVariantConst params, JsonObject out) {
+    calls[3]++;
+    const char* text = params["text"];
+    if (!text) return false;
+    lastText = text;
+    out["success"] = true;
+    out["displayed"] = text;
+    return true;
+}
+
+static const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", readSensors},
+    {"battery/status", "Battery Status", "Get battery voltage and percentage", batteryStatus},
+    {"button/status", "Button Status", "Get current button states", buttonStatus},
+    {"display/show", "Show on Display", "Display text on LCD", displayShow},
+};
+
+static JsonRpcDispatcher rpc(SKILLS, SKILL_COUNT(SKILLS));
+static JsonDocument response;
+
+static bool call(const std::string& body) {
+    response.clear();
+    return rpc.dispatch(body.c_str(), body.size(), response);
+}
+
+void setUp(void) {
+    for (int& c : calls) c = 0;
+    lastText.clear();
+}
+
+void tearDown(void) {}
+
+void test_skill_id_as_method(void) {
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":7,"method":"battery/status"})"));
+    TEST_ASSERT_EQUAL_STRING("2.0", response["jsonrpc"]);
+    TEST_ASSERT_EQUAL(7, response["id"].as<int>());
+    TEST_ASSERT_EQUAL(87, response["result"]["percent"].as<int>());
+    TEST_ASSERT_TRUE(response["error"].isNull());
+    TEST_ASSERT_EQUAL(1, calls[1]);
+}
+
+void test_a2a_message_send(void) {
+    // Legacy part: {"skill", "parameters"}
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":"a","method":"tasks/send","params":{"message":{"parts":[
+        {"skill":"display/show","parameters":{"text":"hi"}}]}}})"));
+    TEST_ASSERT_EQUAL_STRING("a", response["id"]);
+    TEST_ASSERT_EQUAL_STRING("message", response["result"]["kind"]);
+    TEST_ASSERT_EQUAL_STRING("agent", response["result"]["role"]);
+    TEST_ASSERT_EQUAL_STRING("data", response["result"]["parts"][0]["kind"]);
+    TEST_ASSERT_EQUAL_STRING("hi", response["result"]["parts"][0]["data"]["displayed"]);
+    TEST_ASSERT_EQUAL_STRING("hi", lastText.c_str());
+
+    // Data part
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":2,"method":"message/send","params":{"message":{"role":"user",
+        "parts":[{"kind":"data","data":{"skill":"button/status"}}]}}})"));
+    TEST_ASSERT_TRUE(response["result"]["parts"][0]["data"]["btnA"].as<bool>());
+
+    // Text part, as sent by executeSkill() on peer devices
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":3,"method":"message/send","params":{"message":{"role":"user",
+        "parts":[{"type":"text","text":"Sensors Read"}]}}})"));
+    TEST_ASSERT_EQUAL_FLOAT(31.5, response["result"]["parts"][0]["data"]["temperature"].as<float>());
+
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":4,"method":"message/send","params":{"message":{
+        "parts":[{"type":"text","text":"sensors reader"}]}}})"));
+    TEST_ASSERT_EQUAL(RPC_METHOD_NOT_FOUND, response["error"]["code"].as<int>());
+}
+
+void test_batch_in_one_round_trip(void) {
+    TEST_ASSERT_TRUE(call(R"([
+        {"jsonrpc":"2.0","id":1,"method":"sensors/read"},
+        {"jsonrpc":"2.0","method":"display/show","params":{"text":"notified"}},
+        {"jsonrpc":"2.0","id":2,"method":"battery/status"},
+        {"jsonrpc":"2.0","id":3,"method":"button/status"}])"));
+
+    TEST_ASSERT_TRUE(response.is<JsonArray>());
+    TEST_ASSERT_EQUAL(3, (int)response.size());   // The notification gets no reply
+    TEST_ASSERT_EQUAL(1, response[0]["id"].as<int>());
+    TEST_ASSERT_EQUAL_FLOAT(0.98, response[0]["result"]["accelerometer"]["z"].as<float>());
+    TEST_ASSERT_EQUAL(2, response[1]["id"].as<int>());
+    TEST_ASSERT_EQUAL(87, response[1]["result"]["percent"].as<int>());
+    TEST_ASSERT_EQUAL(3, response[2]["id"].as<int>());
+    TEST_ASSERT_TRUE(response[2]["result"]["btnA"].as<bool>());
+
+    // ...but it still ran
+    TEST_ASSERT_EQUAL_STRING("notified", lastText.c_str());
+    TEST_ASSERT_EQUAL(1, calls[0]);
+    TEST_ASSERT_EQUAL(1, calls[1]);
+    TEST_ASSERT_EQUAL(1, calls[2]);
+}
+
+void test_notifications_only_send_nothing(void) {
+    TEST_ASSERT_FALSE(call(R"({"jsonrpc":"2.0","method":"battery/status"})"));
+    TEST_ASSERT_FALSE(call(R"([{"jsonrpc":"2.0","method":"battery/status"}])"));
+    TEST_ASSERT_EQUAL(2, calls[1]);
+}
+
+void test_errors(void) {
+    TEST_ASSERT_TRUE(call("{\"jsonrpc\":\"2.0\",\"method\""));
+    TEST_ASSERT_EQUAL(RPC_PARSE_ERROR, response["error"]["code"].as<int>());
+    TEST_ASSERT_TRUE(response["id"].isNull());
+
+    TEST_ASSERT_TRUE(call(R"({"id":1,"method":"battery/status"})"));
+    TEST_ASSERT_EQUAL(RPC_INVALID_REQUEST, response["error"]["code"].as<int>());
+    TEST_ASSERT_EQUAL(1, response["id"].as<int>());
+
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":1,"method":"ir/send"})"));
+    TEST_ASSERT_EQUAL(RPC_METHOD_NOT_FOUND, response["error"]["code"].as<int>());
+    TEST_ASSERT_TRUE(response["result"].isNull());
+
+    TEST_ASSERT_TRUE(call(R"({"jsonrpc":"2.0","id":1,"method":"display/show","params":{}})"));
+    TEST_ASSERT_EQUAL(RPC_INVALID_PARAMS, response["error"]["code"].as<int>());
+    TEST_ASSERT_TRUE(response["result"].isNull());
+
+    TEST_ASSERT_TRUE(call("[]"));
+    TEST_ASSERT_EQUAL(RPC_INVALID_REQUEST, response["error"]["code"].as<int>());
+
+    // Each bad element of a batch gets its own error
+    TEST_ASSERT_TRUE(call(R"([1,{"jsonrpc":"2.0","id":9,"method":"nope"}])"));
+    TEST_ASSERT_EQUAL(2, (int)response.size());
+    TEST_ASSERT_EQUAL(RPC_INVALID_REQUEST, response[0]["error"]["code"].as<int>());
+    TEST_ASSERT_EQUAL(RPC_METHOD_NOT_FOUND, response[1]["error"]["code"].as<int>());
+
+    std::string big = "[";
+    for (int i = 0; i <= JSON_RPC_MAX_BATCH; i++) {
+        big += (i ? "," : "") + std::string(R"({"jsonrpc":"2.0","id":1,"method":"battery/status"})");
+    }
+    TEST_ASSERT_TRUE(call(big + "]"));
+    TEST_ASSERT_EQUAL(RPC_INVALID_REQUEST, response["error"]["code"].as<int>());
+    TEST_ASSERT_EQUAL(0, calls[1]);
+}
+
+void test_benchmark_no_intermediate_string(void) {
+    const std::string body = R"([{"jsonrpc":"2.0","id":1,"method":"sensors/read"},
+        {"jsonrpc":"2.0","id":2,"method":"battery/status"},{"jsonrpc":"2.0","id":3,"method":"button/status"}])";
+    const int rounds = 1000;
+
+    // Before: each skill returned a serialized String that was parsed again
+    CountingAllocator before;
+    size_t beforeCopies = 0;
+    for (int r = 0; r < rounds; r++) {
+        JsonDocument request(&before);
+        deserializeJson(request, body);
+        JsonDocument out(&before);
+        for (JsonVariantConst req : request.as<JsonArrayConst>()) {
+            JsonDocument skillDoc(&before);
+            rpc.find(req["method"])->handler(JsonVariantConst(), skillDoc.to<JsonObject>());
+            std::string result;
+            serializeJson(skillDoc, result);
+            beforeCopies += result.size();
+            JsonDocument resultDoc(&before);
+            deserializeJson(resultDoc, result);
+            JsonObject reply = out.add<JsonObject>();
+            reply["jsonrpc"] = "2.0";
+            reply["id"] = req["id"];
+            reply["result"] = resultDoc;
+        }
+    }
+
+    CountingAllocator after;
+    JsonRpcDispatcher counted(SKILLS, SKILL_COUNT(SKILLS), &after);
+    for (int r = 0; r < rounds; r++) {
+        JsonDocument out(&after);
+        counted.dispatch(body.c_str(), body.size(), out);
+    }
+
+    char msg[200];
+    snprintf(msg, sizeof(msg),
+             "3-call batch | before: %.1f allocs, %u B peak, %u B of intermediate JSON | after: %.1f allocs, %u B peak",
+             (double)(before.allocations + before.reallocations) / rounds, (unsigned)before.peak,
+             (unsigned)(beforeCopies / rounds), (double)(after.allocations + after.reallocations) / rounds,
+             (unsigned)after.peak);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(before.allocations + before.reallocations, after.allocations + after.reallocations);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_skill_id_as_method);
+    RUN_TEST(test_a2a_message_send);
+    RUN_TEST(test_batch_in_one_round_trip);
+    RUN_TEST(test_notifications_only_send_nothing);
+    RUN_TEST(test_errors);
+    RUN_TEST(test_benchmark_no_intermediate_string);
+    return UNITY_END();
+}
@@ -0,0 +1,154 @@
+/**
+ * Host tests and benchmark for the particle kernel.
+ *
+ * The kernel must put exactly the pixels LovyanGFX's fillRect() would, at
+ * any alignment and partly off screen, so every case is drawn both ways
+ * into two 240x135 sprites and compared byte for byte.
+ *
+ *   pio test -e native_gfx -f test_particles
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <Particles.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+#define PANEL_BYTES (PANEL_W * PANEL_H * 2)
+
+static LGFX_Sprite kernel;
+static LGFX_Sprite reference;
+
+static bool createPanel(LGFX_Sprite& sprite) {
+    sprite.setColorDepth(16);
+    return sprite.createSprite(PANEL_W, PANEL_H) != nullptr;
+}
+
+static PixelSurface surfaceOf(LGFX_Sprite& sprite) {
+    return {(uint16_t*)sprite.getBuffer(), (int16_t)sprite.width(), (int16_t)sprite.height()};
+}
+
+static void clearBoth(uint16_t color) {
+    kernel.fillScreen(color);
+    reference.fillScreen(color);
+}
+
+static bool same() {
+    return memcmp(kernel.getBuffer(), reference.getBuffer(), PANEL_BYTES) == 0;
+}
+
+void setUp(void) {
+    clearBoth(TFT_BLACK);
+}
+
+void tearDown(void) {}
+
+void test_fill_matches_fill_rect(void) {
+    PixelSurface surface = surfaceOf(kernel);
+    // Odd and even x and widths, so spans start and end off a 4-byte boundary
+    for (int x = 0; x < 4; x++) {
+        for (int w = 1; w <= 7; w++) {
+            int y = x * 12 + w;
+            fillSurface(surface, 10 + x, y, w, 3, TFT_ORANGE);
+            reference.fillRect(10 + x, y, w, 3, TFT_ORANGE);
+        }
+    }
+    fillSurface(surface, 0, 0, PANEL_W, 1, 0x1234);
+    reference.fillRect(0, 0, PANEL_W, 1, 0x1234);
+    TEST_ASSERT_TRUE(same());
+}
+
+void test_fill_clips_to_the_surface(void) {
+    PixelSurface surface = surfaceOf(kernel);
+    const int rects[][4] = {
+        {-5, -5, 12, 12}, {PANEL_W - 3, 20, 10, 4}, {100, PANEL_H - 2, 6, 6},
+        {-20, 50, 10, 10}, {PANEL_W, 0, 5, 5}, {50, -8, 4, 4}, {-1, -1, PANEL_W + 2, PANEL_H + 2}
+    };
+    for (int i = 0; i < (int)(sizeof(rects) / sizeof(rects[0])); i++) {
+        const int* r = rects[i];
+        uint16_t color = i & 1 ? TFT_CYAN : TFT_MAGENTA;
+        fillSurface(surface, r[0], r[1], r[2], r[3], color);
+        reference.fillRect(r[0], r[1], r[2], r[3], color);
+        TEST_ASSERT_TRUE_MESSAGE(same(), "clipped fill differs from fillRect");
+    }
+}
+
+void test_particles_move_and_fade_with_age(void) {
+    PixelSurface surface = surfaceOf(kernel);
+    ParticleSystem particles;
+    particles.spawn(100, 60, 100, -50, 4, TFT_WHITE, 1000, 400);
+    particles.spawn(20, 20, 0, 0, 3, TFT_RED, 1000, 0);
+
+    // Not born yet: nothing drawn
+    particles.draw(kernel, surface, 999);
+    TEST_ASSERT_TRUE(same());
+
+    // 200 ms old: moved 20 px right and 10 px up, at half brightness
+    particles.draw(kernel, surface, 1200);
+    uint16_t half = kernel.readPixel(120, 50);
+    TEST_ASSERT_EQUAL(TFT_BLACK, kernel.readPixel(100, 60));
+    TEST_ASSERT_EQUAL(15, (half >> 11) & 0x1F);
+    TEST_ASSERT_EQUAL(31, (half >> 5) & 0x3F);
+    TEST_ASSERT_EQUAL(TFT_RED, kernel.readPixel(21, 21));
+
+    // Past its life it is gone; lifeMs 0 stays
+    clearBoth(TFT_BLACK);
+    particles.draw(kernel, surface, 1400);
+    reference.fillRect(20, 20, 3, 3, TFT_RED);
+    TEST_ASSERT_TRUE(same());
+}
+
+void test_particles_match_fill_rect_fallback(void) {
+    // Without a pixel buffer the same frame goes through fillRect()
+    ParticleSystem particles;
+    for (int i = 0; i < PARTICLE_MAX; i++) {
+        particles.spawn((i * 37) % 250 - 5, (i * 53) % 145 - 5, (i % 7) * 30 - 90, (i % 5) * 40 - 80,
+                        2 + i % 11, (uint16_t)(i * 2654435761u >> 16), 0, 300);
+    }
+    TEST_ASSERT_FALSE(particles.spawn(0, 0, 0, 0, 1, TFT_WHITE, 0, 0));
+
+    particles.draw(kernel, surfaceOf(kernel), 120);
+    particles.draw(reference, {nullptr, 0, 0}, 120);
+    TEST_ASSERT_TRUE(same());
+}
+
+void test_benchmark_particles(void) {
+    ParticleSystem particles;
+    for (int i = 0; i < PARTICLE_MAX; i++) {
+        particles.spawn((i * 37) % 240, (i * 53) % 135, 0, 0, 3 + i % 10, TFT_CYAN, 0, 0);
+    }
+    PixelSurface surface = surfaceOf(kernel);
+    const int frames = 2000;
+    const char* names[] = {"kernel", "fillRect"};
+
+    for (int which = 0; which < 2; which++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int f = 0; f < frames; f++) {
+            if (which == 0) particles.draw(kernel, surface, f);
+            else particles.draw(reference, {nullptr, 0, 0}, f);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        char msg[120];
+        snprintf(msg, sizeof(msg), "%-8s | %3d particles, %6.1f us per frame, %6.0f particles per ms",
+                 names[which], PARTICLE_MAX, us / frames, PARTICLE_MAX * frames / (us / 1000));
+        TEST_MESSAGE(msg);
+    }
+    TEST_ASSERT_TRUE(same());
+}
+
+int main(int argc, char** argv) {
+    if (!createPanel(kernel) || !createPanel(reference)) return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fill_matches_fill_rect);
+    RUN_TEST(test_fill_clips_to_the_surface);
+    RUN_TEST(test_particles_move_and_fade_with_age);
+    RUN_TEST(test_particles_match_fill_rect_fallback);
+    RUN_TEST(test_benchmark_particles);
+    return UNITY_END();
+}
@@ -0,0 +1,358 @@
+/**
+ * Host tests and benchmark for the cached QR image.
+ *
+ * The decode-back tests read the code from the rendered pixels alone: the
+ * module grid is found from the finder patterns, the format bits give the
+ * mask, and the data codewords are read back in the standard zigzag and
+ * de-interleaved (byte mode, ECC_LOW, versions 1-10, no error
+ * correction needed on a clean image).
+ *
+ *   pio test -e native_gfx -f test_qr_image
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <QrImage.h>
+#include <Screens.h>
+#include <qrcode.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+
+static LGFX_Sprite panel;
+
+// ----------------------------------------------------------------------------
+// Decoder
+// ----------------------------------------------------------------------------
+
+struct Grid {
+    int x0, y0;    // Top-left of the modules, in pixels
+    int scale;
+    int size;
+};
+
+static bool darkAt(const Grid& g, int mx, int my) {
+    int px = g.x0 + mx * g.scale + g.scale / 2;
+    int py = g.y0 + my * g.scale + g.scale / 2;
+    return panel.readPixel(px, py) == TFT_BLACK;
+}
+
+// The white area with its top-left corner at (x, y) holds the code
+static bool findGrid(int x, int y, Grid& g) {
+    int right = x;
+    while (right < PANEL_W && panel.readPixel(right, y) == TFT_WHITE) right++;
+    int width = right - x;
+
+    // First black pixel of the top-left finder, then its 7-module run
+    for (int py = y; py < y + width; py++) {
+        for (int px = x; px < x + width; px++) {
+            if (panel.readPixel(px, py) != TFT_BLACK) continue;
+            int run = 0;
+            while (panel.readPixel(px + run, py) == TFT_BLACK) run++;
+            g.x0 = px;
+            g.y0 = py;
+            g.scale = run / 7;
+            g.size = (width - 2 * (px - x)) / g.scale;
+            return g.scale > 0 && run % 7 == 0 && (g.size - 17) % 4 == 0;
+        }
+    }
+    return false;
+}
+
+static bool isFunction(int x, int y, int size, int version) {
+    if ((x < 9 && y < 9) || (x >= size - 8 && y < 9) || (x < 9 && y >= size - 8)) return true;
+    if (x == 6 || y == 6) return true;
+    if (version >= 7 && ((x >= size - 11 && x < size - 8 && y < 6) || (y >= size - 11 && y < size - 8 && x < 6))) {
+        return true;
+    }
+    if (version >= 2) {
+        int count = version / 7 + 2;
+        int step = (version * 4 + count * 2 + 1) / (count * 2 - 2) * 2;
+        int positions[7];
+        positions[0] = 6;
+        for (int i = count - 1, pos = size - 7; i >= 1; i--, pos -= step) {
+            positions[i] = pos;
+        }
+        for (int i = 0; i < count; i++) {
+            for (int j = 0; j < count; j++) {
+                if ((i == 0 && j == 0) || (i == 0 && j == count - 1) || (i == count - 1 && j == 0)) continue;
+                if (abs(x - positions[i]) <= 2 && abs(y - positions[j]) <= 2) return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool masked(int mask, int x, int y) {
+    switch (mask) {
+        case 0: return (x + y) % 2 == 0;
+        case 1: return y % 2 == 0;
+        case 2: return x % 3 == 0;
+        case 3: return (x + y) % 3 == 0;
+        case 4: return (x / 3 + y / 2) % 2 == 0;
+        case 5: return x * y % 2 + x * y % 3 == 0;
+        case 6: return (x * y % 2 + x * y % 3) % 2 == 0;
+        default: return ((x + y) % 2 + x * y % 3) % 2 == 0;
+    }
+}
+
+// Decode the byte-mode text of the code at `g` into `out`; false on any mismatch
+static bool decode(const Grid& g, char* out, size_t outSize) {
+    static const uint16_t TOTAL[] = {26, 44, 70, 100, 134, 172, 196, 242, 292, 346};
+    static const uint8_t BLOCKS[] = {1, 1, 1, 1, 1, 2, 2, 2, 2, 4};
+    static const uint8_t ECC_PER_BLOCK[] = {7, 10, 15, 20, 26, 18, 20, 24, 30, 18};
+    int size = g.size;
+    int version = (size - 17) / 4;
+    if (version < 1 || version > 10) return false;
+
+    // Format bits beside the top-left finder
+    uint32_t format = 0;
+    for (int i = 0; i <= 5; i++) format |= (uint32_t)darkAt(g, 8, i) << i;
+    format |= (uint32_t)darkAt(g, 8, 7) << 6;
+    format |= (uint32_t)darkAt(g, 8, 8) << 7;
+    format |= (uint32_t)darkAt(g, 7, 8) << 8;
+    for (int i = 9; i < 15; i++) format |= (uint32_t)darkAt(g, 14 - i, 8) << i;
+    format ^= 0x5412;
+    if ((format >> 13) != 1) return false;    // ECC_LOW
+    int mask = (format >> 10) & 7;
+
+    // Codewords in placement order
+    uint8_t raw[346] = {0};
+    int total = TOTAL[version - 1];
+    int bit = 0;
+    for (int right = size - 1; right >= 1; right -= 2) {
+        if (right == 6) right = 5;
+        for (int vert = 0; vert < size; vert++) {
+            for (int j = 0; j < 2; j++) {
+                int x = right - j;
+                bool upward = ((right + 1) & 2) == 0;
+                int y = upward ? size - 1 - vert : vert;
+                if (isFunction(x, y, size, version) || bit >= total * 8) continue;
+                if (darkAt(g, x, y) != masked(mask, x, y)) raw[bit >> 3] |= 0x80 >> (bit & 7);
+                bit++;
+            }
+        }
+    }
+
+    // De-interleave the data codewords of the blocks
+    int blocks = BLOCKS[version - 1];
+    int shortBlocks = blocks - total % blocks;
+    int shortData = total / blocks - ECC_PER_BLOCK[version - 1];
+    uint8_t data[346];
+    int dataLen = 0;
+    for (int b = 0; b < blocks; b++) {
+        int len = shortData + (b >= shortBlocks ? 1 : 0);
+        for (int i = 0; i < len; i++) {
+            // Codeword i of block b sits after i codewords of every block
+            int index = i * blocks + b;
+            if (i == shortData) index = shortData * blocks + (b - shortBlocks);
+            data[dataLen++] = raw[index];
+        }
+    }
+
+    // Byte mode header, count, then the bytes
+    uint32_t pos = 0;
+    auto read = [&](int bits) {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++, pos++) {
+            value = (value << 1) | ((data[pos >> 3] >> (7 - (pos & 7))) & 1);
+        }
+        return value;
+    };
+    if (read(4) != 4) return false;
+    uint32_t count = read(version < 10 ? 8 : 16);
+    if (count + 1 > outSize || (pos + count * 8) > (uint32_t)dataLen * 8) return false;
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = (char)read(8);
+    }
+    out[count] = '\0';
+    return true;
+}
+
+// Draw `qr` on black (as on the QR screen) and read it back
+static bool drawAndDecode(const QrImage& qr, char* out, size_t outSize) {
+    panel.fillScreen(TFT_BLACK);
+    qr.draw(panel, 10, 10);
+    Grid g;
+    return findGrid(10, 10, g) && g.size == qr.size() && g.scale == qr.scale() && decode(g, out, outSize);
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_version_follows_length(void) {
+    TEST_ASSERT_EQUAL(1, QrImage::versionFor(0));
+    TEST_ASSERT_EQUAL(1, QrImage::versionFor(17));
+    TEST_ASSERT_EQUAL(2, QrImage::versionFor(18));
+    TEST_ASSERT_EQUAL(3, QrImage::versionFor(53));
+    TEST_ASSERT_EQUAL(4, QrImage::versionFor(54));
+    TEST_ASSERT_EQUAL(9, QrImage::versionFor(230));
+    TEST_ASSERT_EQUAL(10, QrImage::versionFor(271));
+    TEST_ASSERT_EQUAL(0, QrImage::versionFor(272));
+}
+
+void test_rendered_image_decodes_back(void) {
+    QrImage qr;
+    char decoded[QR_TEXT_MAX];
+    const char* urls[] = {
+        "http://10.0.0.7/chat",
+        "http://192.168.100.200/chat",
+        "http://a-rather-long-device-hostname-for-the-lab-bench.local/chat",
+    };
+    for (const char* url : urls) {
+        TEST_ASSERT_TRUE(qr.render(url));
+        TEST_ASSERT_EQUAL(QrImage::versionFor(strlen(url)), qr.version());
+        TEST_ASSERT_LESS_OR_EQUAL(QR_IMAGE_MAX_PX, qr.width());
+        TEST_ASSERT_TRUE_MESSAGE(drawAndDecode(qr, decoded, sizeof(decoded)), url);
+        TEST_ASSERT_EQUAL_STRING(url, decoded);
+    }
+
+    // Every version up to the largest, including the multi-block ones
+    char text[QR_TEXT_MAX];
+    static const int lengths[] = {17, 32, 53, 78, 106, 134, 154, 192, 230, 271};
+    for (int v = 0; v < QR_MAX_VERSION; v++) {
+        for (int i = 0; i < lengths[v]; i++) {
+            text[i] = (char)('a' + (i * 7 + v) % 26);
+        }
+        text[lengths[v]] = '\0';
+        TEST_ASSERT_TRUE(qr.render(text));
+        TEST_ASSERT_EQUAL(v + 1, qr.version());
+        TEST_ASSERT_TRUE(drawAndDecode(qr, decoded, sizeof(decoded)));
+        TEST_ASSERT_EQUAL_STRING(text, decoded);
+    }
+}
+
+void test_modules_match_the_encoder(void) {
+    QrImage qr;
+    const char* url = "http://192.168.1.42/chat";
+    TEST_ASSERT_TRUE(qr.render(url));
+
+    QRCode reference;
+    uint8_t data[QR_MODULES_BYTES];
+    qrcode_initText(&reference, data, qr.version(), ECC_LOW, url);
+    for (int y = 0; y < qr.size(); y++) {
+        for (int x = 0; x < qr.size(); x++) {
+            TEST_ASSERT_EQUAL(qrcode_getModule(&reference, x, y), qr.module(x, y));
+        }
+    }
+}
+
+void test_encodes_only_when_text_changes(void) {
+    QrImage qr;
+    TEST_ASSERT_TRUE(qr.render("http://10.0.0.7/chat"));
+    TEST_ASSERT_TRUE(qr.render("http://10.0.0.7/chat"));
+    TEST_ASSERT_EQUAL(1, (int)qr.encodes());
+    TEST_ASSERT_TRUE(qr.render("http://10.0.0.8/chat"));
+    TEST_ASSERT_EQUAL(2, (int)qr.encodes());
+    TEST_ASSERT_EQUAL_STRING("http://10.0.0.8/chat", qr.text());
+
+    // Too long for any version: refused, nothing drawn
+    char text[400];
+    memset(text, 'x', sizeof(text) - 1);
+    text[sizeof(text) - 1] = '\0';
+    TEST_ASSERT_FALSE(qr.render(text));
+    TEST_ASSERT_FALSE(qr.valid());
+}
+
+void test_qr_screen_decodes_back(void) {
+    ScreenState state = {};
+    state.ip = "192.168.1.42";
+    drawQRScreen(panel, state);
+
+    // The white margin's top-left corner
+    int x = -1, y = -1;
+    for (int py = 0; py < PANEL_H && y < 0; py++) {
+        for (int px = 0; px < PANEL_W; px++) {
+            if (panel.readPixel(px, py) == TFT_WHITE) {
+                x = px;
+                y = py;
+                break;
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(y >= 0);
+    Grid g;
+    char decoded[QR_TEXT_MAX];
+    TEST_ASSERT_TRUE(findGrid(x, y, g));
+    TEST_ASSERT_TRUE(decode(g, decoded, sizeof(decoded)));
+    TEST_ASSERT_EQUAL_STRING("http://192.168.1.42/chat", decoded);
+}
+
+// The screen's old path: encode every time, one fillRect() per dark module
+static void drawUncached(LovyanGFX& gfx, const char* url) {
+    QRCode qrcode;
+    uint8_t data[QR_MODULES_BYTES];
+    qrcode_initText(&qrcode, data, 3, ECC_LOW, url);
+    int offsetX = (240 - qrcode.size * 3) / 2;
+    gfx.fillRect(offsetX - 4, 11, qrcode.size * 3 + 8, qrcode.size * 3 + 8, TFT_WHITE);
+    for (uint8_t y = 0; y < qrcode.size; y++) {
+        for (uint8_t x = 0; x < qrcode.size; x++) {
+            if (qrcode_getModule(&qrcode, x, y)) {
+                gfx.fillRect(offsetX + x * 3, 15 + y * 3, 3, 3, TFT_BLACK);
+            }
+        }
+    }
+}
+
+void test_benchmark_encode_and_draw(void) {
+    const char* url = "http://192.168.1.42/chat";
+    const int runs = 500;
+    QrImage qr;
+    double us[3];
+
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        drawUncached(panel, url);
+    }
+    us[0] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    char text[40];
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        snprintf(text, sizeof(text), "http://192.168.1.%d/chat", i % 200);
+        qr.render(text);
+    }
+    us[1] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    qr.render(url);
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < runs; i++) {
+        qr.render(url);
+        qr.draw(panel, 72, 11);
+    }
+    us[2] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+
+    char msg[120];
+    snprintf(msg, sizeof(msg), "uncached | %7.1f us per redraw (encode + per-module fillRect)", us[0]);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "encode   | %7.1f us per new URL (encode + render bitmap)", us[1]);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "cached   | %7.1f us per redraw (one pushImage), v%d, %d px",
+             us[2], qr.version(), qr.width());
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_THAN(us[0], us[2]);
+}
+
+int main(int argc, char** argv) {
+    panel.setColorDepth(16);
+    if (!panel.createSprite(PANEL_W, PANEL_H)) return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_version_follows_length);
+    RUN_TEST(test_rendered_image_decodes_back);
+    RUN_TEST(test_modules_match_the_encoder);
+    RUN_TEST(test_encodes_only_when_text_changes);
+    RUN_TEST(test_qr_screen_decodes_back);
+    RUN_TEST(test_benchmark_encode_and_draw);
+    return UNITY_END();
+}
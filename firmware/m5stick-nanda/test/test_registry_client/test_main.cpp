@@ -0,0 +1,310 @@
+/**
+ * Host tests for the non-blocking registry client.
+ *
+ * Runs RegistryClient over real loopback sockets against a stand-in
+ * registry and checks that a loop() iteration stays within a few
+ * milliseconds even when the registry is refused, stalled or unreachable.
+ *
+ *   pio test -e native -f test_registry_client
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <HttpResponseParser.h>
+#include <PosixTransport.h>
+#include <RegistryClient.h>
+
+#include "../support/Clock.h"
+#include "../support/StandInServer.h"
+
+#define MAX_LOOP_ITERATION_US 3000
+
+struct LoopStats {
+    int status = 0;
+    int completions = 0;
+    long maxIterationUs = 0;
+    std::string body;
+};
+
+// Stand-in for loop(): poll until the client goes idle, timing each call
+static void runLoop(RegistryClient& client, LoopStats& stats, uint32_t limitMs = 10000) {
+    client.onBody([&stats](RegistryOp, const uint8_t* data, size_t len) {
+        stats.body.append((const char*)data, len);
+        return true;
+    });
+    client.onComplete([&stats](RegistryOp, int status) {
+        stats.status = status;
+        stats.completions++;
+    });
+
+    uint32_t start = nowMs();
+    while (client.busy() && nowMs() - start < limitMs) {
+        auto t0 = std::chrono::steady_clock::now();
+        client.poll(nowMs());
+        long us = (long)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - t0).count();
+        if (us > stats.maxIterationUs) stats.maxIterationUs = us;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_register_posts_identity(void) {
+    StandInServer registry;
+    registry.respondJson(201, "{\"ok\":true}");
+    TEST_ASSERT_TRUE(registry.start());
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    TEST_ASSERT_TRUE(client.begin(registry.url().c_str()));
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    client.enqueue(REG_REGISTER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_EQUAL(201, stats.status);
+    TEST_ASSERT_EQUAL(1, stats.completions);
+    std::string req = registry.request(0);
+    TEST_ASSERT_EQUAL(0, (int)req.find("POST /agents HTTP/1.1"));
+    TEST_ASSERT_TRUE(req.find("{\"handle\":\"m5stick-a1b2c3\",\"url\":\"http://192.168.1.50\"}") != std::string::npos);
+}
+
+void test_registry_under_path_prefix(void) {
+    StandInServer registry;
+    TEST_ASSERT_TRUE(registry.start());
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    TEST_ASSERT_TRUE(client.begin((registry.url() + "/nanda/").c_str()));
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    client.enqueue(REG_REGISTER);
+    client.enqueue(REG_HEARTBEAT);
+    client.enqueue(REG_DISCOVER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_EQUAL(3, stats.completions);
+    TEST_ASSERT_EQUAL(0, (int)registry.request(0).find("POST /nanda/agents HTTP/1.1"));
+    TEST_ASSERT_EQUAL(0, (int)registry.request(1).find("POST /nanda/heartbeat HTTP/1.1"));
+    TEST_ASSERT_EQUAL(0, (int)registry.request(2).find("GET /nanda/agents HTTP/1.1"));
+
+    // A URL that is only scheme and host still asks at the root
+    TEST_ASSERT_TRUE(client.begin(registry.url().c_str()));
+    client.enqueue(REG_DISCOVER);
+    runLoop(client, stats);
+    TEST_ASSERT_EQUAL(0, (int)registry.request(3).find("GET /agents HTTP/1.1"));
+}
+
+void test_discover_streams_chunked_body(void) {
+    StandInServer registry;
+    registry.respond("HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n"
+                     "b\r\n{\"agents\":[\r\n"
+                     "2\r\n]}\r\n"
+                     "0\r\n\r\n");
+    TEST_ASSERT_TRUE(registry.start());
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin(registry.url().c_str());
+    client.enqueue(REG_DISCOVER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_EQUAL(200, stats.status);
+    TEST_ASSERT_EQUAL_STRING("{\"agents\":[]}", stats.body.c_str());
+    TEST_ASSERT_EQUAL(0, (int)registry.request(0).find("GET /agents HTTP/1.1"));
+}
+
+void test_queue_runs_in_order_and_merges_duplicates(void) {
+    StandInServer registry;
+    TEST_ASSERT_TRUE(registry.start());
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin(registry.url().c_str());
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    TEST_ASSERT_TRUE(client.enqueue(REG_REGISTER));
+    TEST_ASSERT_TRUE(client.enqueue(REG_HEARTBEAT));
+    TEST_ASSERT_TRUE(client.enqueue(REG_HEARTBEAT));
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_EQUAL(2, stats.completions);
+    TEST_ASSERT_EQUAL(2, (int)registry.requestCount());
+}
+
+void test_refused_registry_fails_fast(void) {
+    StandInServer registry;
+    TEST_ASSERT_TRUE(registry.start());
+    std::string url = registry.url();
+    registry.stop();  // Port now refuses connections
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin(url.c_str());
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    client.enqueue(REG_HEARTBEAT);
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_EQUAL(REG_ERR_CONNECT, stats.status);
+    TEST_ASSERT_LESS_THAN(MAX_LOOP_ITERATION_US, stats.maxIterationUs);
+}
+
+void test_stalled_registry_times_out_without_blocking(void) {
+    StandInServer registry;
+    registry.setStall(true);
+    TEST_ASSERT_TRUE(registry.start());
+
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin(registry.url().c_str());
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    client.enqueue(REG_HEARTBEAT);
+
+    uint32_t start = nowMs();
+    LoopStats stats;
+    runLoop(client, stats);
+    uint32_t elapsed = nowMs() - start;
+
+    TEST_ASSERT_EQUAL(REG_ERR_TIMEOUT, stats.status);
+    TEST_ASSERT_GREATER_OR_EQUAL(REGISTRY_IO_TIMEOUT, elapsed);
+    TEST_ASSERT_LESS_THAN(MAX_LOOP_ITERATION_US, stats.maxIterationUs);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "stalled registry: worst poll() %ld us over %u ms",
+             stats.maxIterationUs, (unsigned)elapsed);
+    TEST_MESSAGE(msg);
+}
+
+void test_unreachable_registry_never_blocks_loop(void) {
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin("http://10.255.255.1:3000");  // Non-routable: SYNs go nowhere
+    client.setIdentity("m5stick-a1b2c3", "http://192.168.1.50");
+    client.enqueue(REG_REGISTER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+
+    TEST_ASSERT_TRUE(stats.status == REG_ERR_TIMEOUT || stats.status == REG_ERR_CONNECT);
+    TEST_ASSERT_LESS_THAN(MAX_LOOP_ITERATION_US, stats.maxIterationUs);
+
+    char msg[80];
+    snprintf(msg, sizeof(msg), "unreachable registry: worst poll() %ld us", stats.maxIterationUs);
+    TEST_MESSAGE(msg);
+}
+
+void test_https_registry_is_reported_unsupported(void) {
+    PosixTransport transport;
+    RegistryClient client(transport);
+    TEST_ASSERT_FALSE(client.begin("https://registry.example.com"));
+    client.enqueue(REG_DISCOVER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+    TEST_ASSERT_EQUAL(REG_ERR_UNSUPPORTED, stats.status);
+}
+
+// Plain sockets standing in for TLS: counts the connections it is asked for
+struct CountingTransport : PosixTransport {
+    int connects = 0;
+    bool connect(const char* host, uint16_t port) override {
+        connects++;
+        return PosixTransport::connect(host, port);
+    }
+};
+
+void test_https_registry_goes_through_secure_transport(void) {
+    StandInServer registry;
+    registry.respondJson(200, "{\"agents\":[]}");
+    TEST_ASSERT_TRUE(registry.start());
+
+    CountingTransport plain;
+    CountingTransport secure;
+    RegistryClient client(plain, &secure);
+    std::string url = registry.url();
+    TEST_ASSERT_TRUE(client.begin(("https://" + url.substr(7)).c_str()));
+    client.enqueue(REG_DISCOVER);
+
+    LoopStats stats;
+    runLoop(client, stats);
+    TEST_ASSERT_EQUAL(200, stats.status);
+    TEST_ASSERT_EQUAL(1, secure.connects);
+    TEST_ASSERT_EQUAL(0, plain.connects);
+
+    // The same client back on an http:// registry uses the plain transport
+    TEST_ASSERT_TRUE(client.begin(url.c_str()));
+    client.enqueue(REG_DISCOVER);
+    runLoop(client, stats);
+    TEST_ASSERT_EQUAL(200, stats.status);
+    TEST_ASSERT_EQUAL(1, plain.connects);
+    TEST_ASSERT_EQUAL(1, secure.connects);
+}
+
+void test_parser_handles_every_split_point(void) {
+    const std::string raw =
+        "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\nTransfer-Encoding: chunked\r\n\r\n"
+        "5\r\nhello\r\n6\r\n world\r\n0\r\n\r\n";
+
+    for (size_t split = 0; split <= raw.size(); split++) {
+        std::string body;
+        HttpResponseParser parser;
+        parser.reset([&body](const uint8_t* data, size_t len) {
+            body.append((const char*)data, len);
+            return true;
+        });
+
+        HttpResponseParser::Result r = parser.feed((const uint8_t*)raw.data(), split);
+        if (r == HttpResponseParser::NEED_MORE) {
+            r = parser.feed((const uint8_t*)raw.data() + split, raw.size() - split);
+        }
+        TEST_ASSERT_EQUAL(HttpResponseParser::DONE, r);
+        TEST_ASSERT_EQUAL(200, parser.status());
+        TEST_ASSERT_EQUAL_STRING("hello world", body.c_str());
+    }
+}
+
+void test_parser_close_delimited_and_errors(void) {
+    HttpResponseParser parser;
+    std::string body;
+    parser.reset([&body](const uint8_t* data, size_t len) {
+        body.append((const char*)data, len);
+        return true;
+    });
+    const char* raw = "HTTP/1.0 200 OK\r\n\r\n{\"a\":1}";
+    TEST_ASSERT_EQUAL(HttpResponseParser::NEED_MORE, parser.feed((const uint8_t*)raw, strlen(raw)));
+    TEST_ASSERT_EQUAL(HttpResponseParser::DONE, parser.finish());
+    TEST_ASSERT_EQUAL_STRING("{\"a\":1}", body.c_str());
+
+    parser.reset();
+    const char* junk = "SSH-2.0-OpenSSH\r\n";
+    TEST_ASSERT_EQUAL(HttpResponseParser::ERROR, parser.feed((const uint8_t*)junk, strlen(junk)));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_register_posts_identity);
+    RUN_TEST(test_registry_under_path_prefix);
+    RUN_TEST(test_discover_streams_chunked_body);
+    RUN_TEST(test_queue_runs_in_order_and_merges_duplicates);
+    RUN_TEST(test_refused_registry_fails_fast);
+    RUN_TEST(test_stalled_registry_times_out_without_blocking);
+    RUN_TEST(test_unreachable_registry_never_blocks_loop);
+    RUN_TEST(test_https_registry_is_reported_unsupported);
+    RUN_TEST(test_https_registry_goes_through_secure_transport);
+    RUN_TEST(test_parser_handles_every_split_point);
+    RUN_TEST(test_parser_close_delimited_and_errors);
+    return UNITY_END();
+}
@@ -0,0 +1,230 @@
+/**
+ * Host tests for the parallel registry probe.
+ *
+ * Several stand-in registries with injected delays race on loopback
+ * addresses; the fastest 200 must win, the rest must be cancelled, and a
+ * LAN with no registry must cost one probe timeout instead of one per
+ * candidate. Also reports boot-to-registered time for probe + register.
+ *
+ *   pio test -e native -f test_registry_probe
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <PosixTransport.h>
+#include <RegistryClient.h>
+#include <RegistryProbe.h>
+
+#include "../support/Clock.h"
+#include "../support/StandInServer.h"
+
+static PosixTransport transports[PROBE_MAX_SLOTS];
+static HttpTransport* slots[PROBE_MAX_SLOTS];
+
+static uint32_t runProbe(RegistryProbe& probe) {
+    uint32_t start = nowMs();
+    probe.start(nowMs());
+    while (probe.poll(nowMs()) && nowMs() - start < 10000) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return nowMs() - start;
+}
+
+static uint16_t closedPort() {
+    StandInServer s;
+    s.start();
+    uint16_t port = s.port();
+    s.stop();
+    return port;
+}
+
+void setUp(void) {
+    for (int i = 0; i < PROBE_MAX_SLOTS; i++) slots[i] = &transports[i];
+}
+
+void tearDown(void) {}
+
+void test_ip_helpers(void) {
+    TEST_ASSERT_EQUAL_UINT32(0xC0A80164, RegistryProbe::parseIp("192.168.1.100"));
+    TEST_ASSERT_EQUAL_UINT32(0, RegistryProbe::parseIp("192.168.1"));
+    TEST_ASSERT_EQUAL_UINT32(0, RegistryProbe::parseIp("registry.local"));
+    TEST_ASSERT_EQUAL_UINT32(0, RegistryProbe::parseIp("10.0.0.256"));
+
+    char out[16];
+    RegistryProbe::formatIp(0x0A000132, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("10.0.1.50", out);
+
+    RegistryProbe probe(slots, 4);
+    TEST_ASSERT_TRUE(probe.addUrl("http://10.0.1.50:3000"));
+    TEST_ASSERT_TRUE(probe.addUrl("http://10.0.1.50:3000"));  // Deduplicated
+    TEST_ASSERT_FALSE(probe.addUrl("http://registry.local:3000"));
+    TEST_ASSERT_EQUAL(1, (int)probe.count());
+    TEST_ASSERT_EQUAL(3000, probe.candidate(0).port);
+}
+
+void test_fastest_registry_wins_not_first_listed(void) {
+    StandInServer slow, fast, medium, stalled;
+    slow.setDelay(400);
+    fast.setDelay(30);
+    medium.setDelay(150);
+    stalled.setStall(true);
+    TEST_ASSERT_TRUE(slow.start(0, "127.0.0.11"));
+    TEST_ASSERT_TRUE(fast.start(0, "127.0.0.12"));
+    TEST_ASSERT_TRUE(medium.start(0, "127.0.0.13"));
+    TEST_ASSERT_TRUE(stalled.start(0, "127.0.0.14"));
+
+    RegistryProbe probe(slots, 8);
+    probe.addCandidate("127.0.0.1", closedPort());  // Refused
+    probe.addUrl(stalled.url().c_str());
+    probe.addUrl(slow.url().c_str());
+    probe.addUrl(medium.url().c_str());
+    probe.addUrl(fast.url().c_str());
+
+    uint32_t elapsed = runProbe(probe);
+
+    char url[40];
+    TEST_ASSERT_TRUE(probe.winnerUrl(url, sizeof(url)));
+    std::string expected = fast.url();
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), url);
+    TEST_ASSERT_LESS_THAN(150, elapsed);
+
+    TEST_ASSERT_EQUAL(RegistryProbe::FAILED, probe.candidate(0).state);
+    TEST_ASSERT_EQUAL(RegistryProbe::CANCELLED, probe.candidate(1).state);
+    TEST_ASSERT_EQUAL(RegistryProbe::CANCELLED, probe.candidate(2).state);
+    TEST_ASSERT_EQUAL(RegistryProbe::CANCELLED, probe.candidate(3).state);
+    TEST_ASSERT_EQUAL(RegistryProbe::WON, probe.candidate(4).state);
+    TEST_ASSERT_GREATER_OR_EQUAL(30, probe.candidate(4).latencyMs);
+}
+
+void test_non_200_answer_does_not_win(void) {
+    StandInServer notRegistry, registry;
+    notRegistry.respondJson(404, "{}");
+    registry.setDelay(60);
+    TEST_ASSERT_TRUE(notRegistry.start(0, "127.0.0.21"));
+    TEST_ASSERT_TRUE(registry.start(0, "127.0.0.22"));
+
+    RegistryProbe probe(slots, 4);
+    probe.addUrl(notRegistry.url().c_str());
+    probe.addUrl(registry.url().c_str());
+    runProbe(probe);
+
+    TEST_ASSERT_EQUAL(1, probe.winner());
+    TEST_ASSERT_EQUAL(RegistryProbe::ANSWERED, probe.candidate(0).state);
+    TEST_ASSERT_EQUAL(404, probe.candidate(0).status);
+}
+
+void test_empty_lan_costs_one_timeout_not_ten(void) {
+    StandInServer stalled[5];
+    uint16_t refused = closedPort();
+
+    RegistryProbe probe(slots, 10);
+    probe.setTimeout(300);
+    for (int i = 0; i < 5; i++) {
+        char addr[16];
+        snprintf(addr, sizeof(addr), "127.0.0.%d", 31 + i);
+        TEST_ASSERT_TRUE(stalled[i].start(0, addr));
+        stalled[i].setStall(true);
+        probe.addUrl(stalled[i].url().c_str());
+        probe.addCandidate(RegistryProbe::parseIp(addr), refused);
+    }
+
+    uint32_t elapsed = runProbe(probe);
+
+    TEST_ASSERT_EQUAL(-1, probe.winner());
+    TEST_ASSERT_FALSE(probe.running());
+    TEST_ASSERT_LESS_THAN(2 * 300, elapsed);
+
+    char msg[96];
+    snprintf(msg, sizeof(msg), "10 dead candidates: %u ms (sequential would be %u ms)",
+             (unsigned)elapsed, 10u * 300u);
+    TEST_MESSAGE(msg);
+}
+
+void test_subnet_sweep_in_batches(void) {
+    StandInServer registry;
+    registry.setDelay(20);
+    TEST_ASSERT_TRUE(registry.start(0, "127.0.0.77"));
+
+    RegistryProbe probe(slots, PROBE_MAX_SLOTS);
+    probe.setBatchSize(12);
+    probe.setTimeout(300);
+    TEST_ASSERT_EQUAL(254, (int)probe.addSubnetSweep(RegistryProbe::parseIp("127.0.0.0"), registry.port()));
+
+    uint32_t elapsed = runProbe(probe);
+
+    char url[40];
+    TEST_ASSERT_TRUE(probe.winnerUrl(url, sizeof(url)));
+    std::string expected = registry.url();
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), url);
+    for (size_t i = 77; i < probe.count(); i++) {
+        TEST_ASSERT_TRUE(probe.candidate(i).state == RegistryProbe::CANCELLED ||
+                         probe.candidate(i).state == RegistryProbe::FAILED);
+    }
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "/24 sweep found .77 in %u ms", (unsigned)elapsed);
+    TEST_MESSAGE(msg);
+}
+
+void test_boot_to_registered_time(void) {
+    StandInServer lanRegistry, stalled;
+    lanRegistry.setDelay(80);
+    stalled.setStall(true);
+    TEST_ASSERT_TRUE(lanRegistry.start(0, "127.0.0.41"));
+    TEST_ASSERT_TRUE(stalled.start(0, "127.0.0.42"));
+    uint16_t refused = closedPort();
+
+    uint32_t boot = nowMs();
+
+    // Same candidate shape as autoDetectRegistry(): gateway, conventions, then the real one
+    RegistryProbe probe(slots, 10);
+    probe.addCandidate("127.0.0.1", refused);
+    probe.addUrl(stalled.url().c_str());
+    for (int host = 100; host < 107; host++) {
+        char addr[16];
+        snprintf(addr, sizeof(addr), "127.0.0.%d", host);
+        probe.addCandidate(addr, refused);
+    }
+    probe.addUrl(lanRegistry.url().c_str());
+    runProbe(probe);
+
+    char url[40];
+    TEST_ASSERT_TRUE(probe.winnerUrl(url, sizeof(url)));
+
+    lanRegistry.setDelay(0);
+    lanRegistry.respondJson(201, "{}");
+    PosixTransport transport;
+    RegistryClient client(transport);
+    client.begin(url);
+    client.setIdentity("m5stick-a1b2c3", "http://127.0.0.1");
+    int status = 0;
+    client.onComplete([&status](RegistryOp, int s) { status = s; });
+    client.enqueue(REG_REGISTER);
+    while (client.busy() && nowMs() - boot < 10000) {
+        client.poll(nowMs());
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    uint32_t registered = nowMs() - boot;
+
+    TEST_ASSERT_EQUAL(201, status);
+    TEST_ASSERT_LESS_THAN(PROBE_TIMEOUT, registered);
+
+    char msg[64];
+    snprintf(msg, sizeof(msg), "boot-to-registered: %u ms", (unsigned)registered);
+    TEST_MESSAGE(msg);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ip_helpers);
+    RUN_TEST(test_fastest_registry_wins_not_first_listed);
+    RUN_TEST(test_non_200_answer_does_not_win);
+    RUN_TEST(test_empty_lan_costs_one_timeout_not_ten);
+    RUN_TEST(test_subnet_sweep_in_batches);
+    RUN_TEST(test_boot_to_registered_time);
+    return UNITY_END();
+}
@@ -0,0 +1,324 @@
+/**
+ * Host tests and route-match benchmark for the shared route table.
+ *
+ * The benchmark matches requests against 56 routes three ways: the walk
+ * AsyncWebServer::_attachHandler() makes over one AsyncCallbackWebHandler
+ * per route (method check, uri compare, then startsWith(uri + "/")), the
+ * tunnel's old strlen/memcmp chain, and the perfect hash built by the
+ * compiler. std::string stands in for Arduino String; both allocate for
+ * the uri + "/" of every route a request passes.
+ *
+ *   pio test -e native -f test_route_table
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include <RouteTable.h>
+
+#include "../support/CountingNew.h"
+
+static int writeNothing(uint8_t* out, size_t room, size_t& len) {
+    len = 0;
+    return 200;
+}
+
+static const char PAGE[] = "<!DOCTYPE html><html><body>Hi</body></html>";
+static const uint8_t PAGE_GZ[] = {0x1f, 0x8b, 0x08, 0x00};   // Only its address and size matter here
+#define PAGE_ETAG "W/\"0badf00d\""
+
+constexpr RouteQuery BUZZER_QUERY[] = {
+    {"freq", "frequency", true, 1000},
+    {"duration", "duration", true, 100},
+    {"label", "label", false, 0}
+};
+
+// The firmware's routes, then as many again that a larger device might serve
+constexpr RouteDef ROUTES[] = {
+    routeCard("/.well-known/agent.json"),
+    routeRpc("/a2a"),
+    routeRpc("/rpc"),
+    routeSkill("/api/sensors", "sensors/read"),
+    routeSkill("/api/sensors/features", "sensors/features"),
+    routeSkill("/api/buttons", "button/status"),
+    routeSkill("/api/battery", "battery/status"),
+    routeSkill("/api/wifi/scan", "wifi/scan"),
+    routeSkill("/api/display", "display/show"),
+    routeSkill("/api/buzzer", "buzzer/tone", BUZZER_QUERY),
+    routeRaw("/api/screen.png", "image/png", writeNothing, nullptr, true),
+    routeRaw("/api/screen.qoi", "image/qoi", writeNothing, nullptr, true),
+    routePage("/", "text/html", PAGE),
+    routePage("/chat", "text/html", PAGE, PAGE_GZ, PAGE_ETAG),
+    routeSkill("/api/led", "led/set"),
+    routeSkill("/api/led/blink", "led/blink"),
+    routeSkill("/api/ir/send", "ir/send"),
+    routeSkill("/api/ir/learn", "ir/learn"),
+    routeSkill("/api/ir/codes", "ir/codes"),
+    routeSkill("/api/imu/calibrate", "imu/calibrate"),
+    routeSkill("/api/imu/orientation", "imu/orientation"),
+    routeSkill("/api/imu/steps", "imu/steps"),
+    routeSkill("/api/temperature", "sensors/temperature"),
+    routeSkill("/api/microphone/level", "mic/level"),
+    routeSkill("/api/microphone/peak", "mic/peak"),
+    routeSkill("/api/rtc", "rtc/read"),
+    routeSkill("/api/rtc/set", "rtc/set"),
+    routeSkill("/api/power/off", "power/off"),
+    routeSkill("/api/power/sleep", "power/sleep"),
+    routeSkill("/api/power/status", "power/status"),
+    routeSkill("/api/brightness", "display/brightness"),
+    routeSkill("/api/display/clear", "display/clear"),
+    routeSkill("/api/display/qr", "display/qr"),
+    routeSkill("/api/display/image", "display/image"),
+    routeSkill("/api/menu", "menu/state"),
+    routeSkill("/api/menu/select", "menu/select"),
+    routeSkill("/api/agents", "agents/list"),
+    routeSkill("/api/agents/refresh", "agents/refresh"),
+    routeSkill("/api/agents/skills", "agents/skills"),
+    routeSkill("/api/agents/execute", "agents/execute"),
+    routeSkill("/api/registry", "registry/status"),
+    routeSkill("/api/registry/register", "registry/register"),
+    routeSkill("/api/registry/unregister", "registry/unregister"),
+    routeSkill("/api/tunnel", "tunnel/status"),
+    routeSkill("/api/tunnel/reconnect", "tunnel/reconnect"),
+    routeSkill("/api/wifi", "wifi/status"),
+    routeSkill("/api/wifi/connect", "wifi/connect"),
+    routeSkill("/api/wifi/forget", "wifi/forget"),
+    routeSkill("/api/settings", "settings/read"),
+    routeSkill("/api/settings/save", "settings/save"),
+    routeSkill("/api/settings/reset", "settings/reset"),
+    routeSkill("/api/ota", "ota/status"),
+    routeSkill("/api/ota/update", "ota/update"),
+    routeSkill("/api/logs", "logs/read"),
+    routeSkill("/api/logs/clear", "logs/clear"),
+    routeSkill("/api/uptime", "system/uptime")
+};
+constexpr RouteMatcher<ROUTE_COUNT(ROUTES)> routes(ROUTES);
+static_assert(routes.valid(), "Route paths must be unique");
+static_assert(ROUTE_COUNT(ROUTES) >= 50, "The benchmark wants 50+ routes");
+
+void setUp(void) {}
+void tearDown(void) {}
+
+void test_every_route_found(void) {
+    TEST_ASSERT_EQUAL(ROUTE_COUNT(ROUTES), routes.size());
+    for (size_t i = 0; i < ROUTE_COUNT(ROUTES); i++) {
+        TEST_ASSERT_EQUAL_PTR(&ROUTES[i], routes.find(ROUTES[i].path));
+        std::string withQuery = std::string(ROUTES[i].path) + "?a=1&b=2";
+        TEST_ASSERT_EQUAL_PTR(&ROUTES[i], routes.find(withQuery.c_str()));
+    }
+}
+
+void test_near_misses(void) {
+    const char* misses[] = {"", "/api", "/api/", "/api/sensor", "/api/sensorsX", "/api/sensors/", "/API/sensors",
+                            "/api/sensors/features/x", "//", "/chat/", "/a2a2", "/rp", "/.well-known/agent.jso"};
+    for (const char* path : misses) {
+        TEST_ASSERT_NULL_MESSAGE(routes.find(path), path);
+    }
+    // Compared up to len only
+    TEST_ASSERT_EQUAL_PTR(&ROUTES[3], routes.find("/api/sensorsXYZ", 12));
+    TEST_ASSERT_EQUAL_STRING("/api/led", routes.find("/api/led?on=1")->path);
+}
+
+void test_duplicate_paths_do_not_build(void) {
+    const RouteDef twice[] = {
+        routeSkill("/api/sensors", "sensors/read"),
+        routeSkill("/api/battery", "battery/status"),
+        routeSkill("/api/sensors", "sensors/features")
+    };
+    RouteMatcher<3> matcher(twice);
+    TEST_ASSERT_FALSE(matcher.valid());
+    TEST_ASSERT_NULL(matcher.find("/api/battery"));
+
+    const RouteDef one[] = {routeRpc("/rpc")};
+    RouteMatcher<1> single(one);
+    TEST_ASSERT_TRUE(single.valid());
+    TEST_ASSERT_EQUAL_PTR(&one[0], single.find("/rpc"));
+    TEST_ASSERT_NULL(single.find("/a2a"));
+}
+
+void test_methods_and_cache(void) {
+    TEST_ASSERT_EQUAL(ROUTE_GET, routeMethod("GET"));
+    TEST_ASSERT_EQUAL(ROUTE_POST, routeMethod("POST"));
+    TEST_ASSERT_EQUAL(0, routeMethod("get"));
+    TEST_ASSERT_EQUAL(0, routeMethod(""));
+    TEST_ASSERT_EQUAL(0, routeMethod(nullptr));
+
+    const RouteDef* card = routes.find("/.well-known/agent.json");
+    TEST_ASSERT_EQUAL(ROUTE_GET, card->methods);
+    TEST_ASSERT_EQUAL_STRING("no-cache", routeCacheControl(card->cache));
+    TEST_ASSERT_EQUAL(ROUTE_POST, routes.find("/rpc")->methods);
+    TEST_ASSERT_EQUAL_STRING("no-store", routeCacheControl(routes.find("/api/sensors")->cache));
+
+    const RouteDef* page = routes.find("/");
+    TEST_ASSERT_EQUAL(ROUTE_PAGE, page->kind);
+    TEST_ASSERT_EQUAL(strlen(PAGE), page->bodyLen);
+    TEST_ASSERT_EQUAL_STRING(ROUTE_MAX_AGE, routeCacheControl(page->cache));
+    TEST_ASSERT_NULL(page->gzip);
+    TEST_ASSERT_NULL(page->etag);
+
+    const RouteDef* chat = routes.find("/chat");
+    TEST_ASSERT_EQUAL(strlen(PAGE), chat->bodyLen);
+    TEST_ASSERT_EQUAL_PTR(PAGE_GZ, chat->gzip);
+    TEST_ASSERT_EQUAL(sizeof(PAGE_GZ), chat->gzipLen);
+    TEST_ASSERT_EQUAL_STRING(PAGE_ETAG, chat->etag);
+    TEST_ASSERT_EQUAL_STRING(ROUTE_MAX_AGE, routeCacheControl(chat->cache));
+}
+
+void test_etag_matches(void) {
+    TEST_ASSERT_TRUE(routeEtagMatches("W/\"0badf00d\"", PAGE_ETAG));
+    // Weak comparison, either side
+    TEST_ASSERT_TRUE(routeEtagMatches("\"0badf00d\"", PAGE_ETAG));
+    TEST_ASSERT_TRUE(routeEtagMatches("W/\"0badf00d\"", "\"0badf00d\""));
+    TEST_ASSERT_TRUE(routeEtagMatches("\"1\", W/\"0badf00d\"", PAGE_ETAG));
+    TEST_ASSERT_TRUE(routeEtagMatches("\"1\",\t\"0badf00d\"", PAGE_ETAG));
+    TEST_ASSERT_TRUE(routeEtagMatches("*", PAGE_ETAG));
+
+    TEST_ASSERT_FALSE(routeEtagMatches("W/\"0badf00e\"", PAGE_ETAG));
+    TEST_ASSERT_FALSE(routeEtagMatches("\"0badf00d", PAGE_ETAG));
+    TEST_ASSERT_FALSE(routeEtagMatches("\"0badf00d\"x", PAGE_ETAG));
+    TEST_ASSERT_FALSE(routeEtagMatches("", PAGE_ETAG));
+    TEST_ASSERT_FALSE(routeEtagMatches(nullptr, PAGE_ETAG));
+    TEST_ASSERT_FALSE(routeEtagMatches("*", nullptr));
+}
+
+void test_accepts_gzip(void) {
+    TEST_ASSERT_TRUE(routeAcceptsGzip("gzip"));
+    TEST_ASSERT_TRUE(routeAcceptsGzip("gzip, deflate, br, zstd"));
+    TEST_ASSERT_TRUE(routeAcceptsGzip("br;q=1.0, GZIP;q=0.8, *;q=0.1"));
+    TEST_ASSERT_TRUE(routeAcceptsGzip("deflate,x-gzip"));
+    TEST_ASSERT_TRUE(routeAcceptsGzip("gzip ; q=0.5"));
+
+    TEST_ASSERT_FALSE(routeAcceptsGzip("gzip;q=0"));
+    TEST_ASSERT_FALSE(routeAcceptsGzip("gzip;q=0.000, identity"));
+    TEST_ASSERT_FALSE(routeAcceptsGzip("identity"));
+    TEST_ASSERT_FALSE(routeAcceptsGzip("br, gzipx, xgzip"));
+    TEST_ASSERT_FALSE(routeAcceptsGzip("deflate;q=0.5, br"));
+    TEST_ASSERT_FALSE(routeAcceptsGzip(""));
+    TEST_ASSERT_FALSE(routeAcceptsGzip(nullptr));
+}
+
+void test_query_params(void) {
+    const RouteDef* buzzer = routes.find("/api/buzzer");
+    JsonDocument params;
+    routeParams(*buzzer, params.to<JsonObject>(), [](const char* name, char* buf, size_t size) {
+        if (strcmp(name, "duration") != 0) return false;
+        snprintf(buf, size, "250");
+        return true;
+    });
+    TEST_ASSERT_EQUAL(1000, params["frequency"].as<int>());
+    TEST_ASSERT_EQUAL(250, params["duration"].as<int>());
+    TEST_ASSERT_FALSE(params["label"].is<const char*>());   // Absent text is left out
+
+    params.clear();
+    routeParams(*buzzer, params.to<JsonObject>(), [](const char* name, char* buf, size_t size) {
+        snprintf(buf, size, "%s", strcmp(name, "label") == 0 ? "door bell" : "7");
+        return true;
+    });
+    TEST_ASSERT_EQUAL(7, params["frequency"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("door bell", params["label"]);
+}
+
+// As AsyncCallbackWebHandler::canHandle() for a plain uri
+static bool callbackCanHandle(const RouteDef& route, const std::string& uri, uint8_t method, const std::string& url) {
+    if (!(route.methods & method)) return false;
+    if (uri != url && url.compare(0, uri.size() + 1, uri + "/") != 0) return false;
+    return true;
+}
+
+// As the tunnel's old chain of isPath() checks
+static const RouteDef* chainFind(const char* path) {
+    size_t len = strcspn(path, "?");
+    for (const RouteDef& route : ROUTES) {
+        if (strlen(route.path) == len && memcmp(path, route.path, len) == 0) return &route;
+    }
+    return nullptr;
+}
+
+void test_benchmark_route_match(void) {
+    // Every route once, some with a query, and a few 404s
+    std::string requests[ROUTE_COUNT(ROUTES) + 4];
+    for (size_t i = 0; i < ROUTE_COUNT(ROUTES); i++) {
+        requests[i] = ROUTES[i].path;
+        if (i % 5 == 0) requests[i] += "?x=1";
+    }
+    requests[ROUTE_COUNT(ROUTES)] = "/favicon.ico";
+    requests[ROUTE_COUNT(ROUTES) + 1] = "/api/sensors2";
+    requests[ROUTE_COUNT(ROUTES) + 2] = "/apple-touch-icon.png";
+    requests[ROUTE_COUNT(ROUTES) + 3] = "/api/logs/old";
+    const size_t count = sizeof(requests) / sizeof(requests[0]);
+    // The server hands handlers the url without its query string
+    std::string urls[count];
+    for (size_t i = 0; i < count; i++) urls[i] = requests[i].substr(0, requests[i].find('?'));
+    std::string uris[ROUTE_COUNT(ROUTES)];
+    for (size_t i = 0; i < ROUTE_COUNT(ROUTES); i++) uris[i] = ROUTES[i].path;
+
+    const int rounds = 2000;
+    size_t found[3] = {0, 0, 0};
+
+    size_t allocsBefore = heapAllocs;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            for (size_t k = 0; k < ROUTE_COUNT(ROUTES); k++) {
+                if (callbackCanHandle(ROUTES[k], uris[k], ROUTE_GET | ROUTE_POST, urls[i])) {
+                    found[0]++;
+                    break;
+                }
+            }
+        }
+    }
+    auto walked = std::chrono::steady_clock::now();
+    size_t walkAllocs = heapAllocs - allocsBefore;
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) found[1] += chainFind(requests[i].c_str()) != nullptr;
+    }
+    auto chained = std::chrono::steady_clock::now();
+    allocsBefore = heapAllocs;
+    for (int r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) found[2] += routes.find(requests[i].c_str()) != nullptr;
+    }
+    auto hashed = std::chrono::steady_clock::now();
+    size_t hashAllocs = heapAllocs - allocsBefore;
+
+    // The walk also takes /api/logs/old as /api/logs; exact matching does not
+    TEST_ASSERT_EQUAL((ROUTE_COUNT(ROUTES) + 1) * rounds, found[0]);
+    TEST_ASSERT_EQUAL(ROUTE_COUNT(ROUTES) * rounds, found[1]);
+    TEST_ASSERT_EQUAL(found[1], found[2]);
+    TEST_ASSERT_EQUAL(0, (int)hashAllocs);
+
+    double lookups = (double)rounds * count;
+    double walkNs = std::chrono::duration<double, std::nano>(walked - start).count() / lookups;
+    double chainNs = std::chrono::duration<double, std::nano>(chained - walked).count() / lookups;
+    double hashNs = std::chrono::duration<double, std::nano>(hashed - chained).count() / lookups;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%u routes | table %u slots, %u buckets, %u B of index",
+             (unsigned)ROUTE_COUNT(ROUTES), (unsigned)routes.SLOTS, (unsigned)routes.BUCKETS,
+             (unsigned)(routes.SLOTS + routes.BUCKETS));
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "handler walk   %7.1f ns/request | %.1f heap allocs/request",
+             walkNs, walkAllocs / lookups);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "strcmp chain   %7.1f ns/request", chainNs);
+    TEST_MESSAGE(msg);
+    snprintf(msg, sizeof(msg), "perfect hash   %7.1f ns/request | x%.1f vs walk, x%.1f vs chain",
+             hashNs, walkNs / hashNs, chainNs / hashNs);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(hashNs < chainNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_every_route_found);
+    RUN_TEST(test_near_misses);
+    RUN_TEST(test_duplicate_paths_do_not_build);
+    RUN_TEST(test_methods_and_cache);
+    RUN_TEST(test_etag_matches);
+    RUN_TEST(test_accepts_gzip);
+    RUN_TEST(test_query_params);
+    RUN_TEST(test_benchmark_route_match);
+    return UNITY_END();
+}
@@ -0,0 +1,227 @@
+/**
+ * Host tests and stress test for the sensor sample ring.
+ *
+ * The stress tests run one writer thread, flat out and then in bursts like
+ * the sampler task, against several reader threads: some only take the
+ * latest sample, some follow every sample through their own cursor, one
+ * of them too slowly to keep up. Every
+ * sample carries words derived from its index and a checksum, so a torn
+ * or stale copy would show, and the cursor readers check that samples
+ * arrive in order and that read plus dropped adds up to what was written.
+ *
+ *   pio test -e native -f test_sample_ring
+ */
+
+#include <unity.h>
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include <SensorSamples.h>
+
+typedef std::chrono::steady_clock Clock;
+
+struct Probe {
+    uint32_t index;
+    uint32_t words[6];
+    uint32_t check;
+};
+
+static Probe probe(uint32_t index) {
+    Probe p;
+    p.index = index;
+    p.check = index;
+    for (int i = 0; i < 6; i++) {
+        p.words[i] = index * 2654435761u + i;
+        p.check ^= p.words[i];
+    }
+    return p;
+}
+
+static bool intact(const Probe& p) {
+    uint32_t check = p.index;
+    for (int i = 0; i < 6; i++) {
+        if (p.words[i] != p.index * 2654435761u + i) return false;
+        check ^= p.words[i];
+    }
+    return check == p.check;
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_empty_ring_has_no_latest(void) {
+    SampleRing<Probe, 8> ring;
+    Probe p;
+    uint32_t cursor = 0;
+    TEST_ASSERT_FALSE(ring.latest(p));
+    TEST_ASSERT_EQUAL(0, ring.written());
+    TEST_ASSERT_EQUAL(0, ring.readFrom(cursor, &p, 1));
+}
+
+void test_latest_and_read_from_in_order(void) {
+    SampleRing<Probe, 8> ring;
+    Probe out[8];
+    uint32_t cursor = 0;
+
+    for (uint32_t i = 0; i < 5; i++) ring.push(probe(i));
+    TEST_ASSERT_TRUE(ring.latest(out[0]));
+    TEST_ASSERT_EQUAL(4, out[0].index);
+
+    TEST_ASSERT_EQUAL(3, ring.readFrom(cursor, out, 3));
+    TEST_ASSERT_EQUAL(0, out[0].index);
+    TEST_ASSERT_EQUAL(2, out[2].index);
+    TEST_ASSERT_EQUAL(2, ring.readFrom(cursor, out, 8));
+    TEST_ASSERT_EQUAL(3, out[0].index);
+    TEST_ASSERT_EQUAL(4, out[1].index);
+    TEST_ASSERT_EQUAL(0, ring.readFrom(cursor, out, 8));
+    TEST_ASSERT_EQUAL(5, cursor);
+}
+
+void test_lapped_reader_skips_to_oldest_kept_and_counts_drops(void) {
+    SampleRing<Probe, 8> ring;
+    Probe out[8];
+    uint32_t cursor = 0;
+    uint32_t dropped = 0;
+
+    for (uint32_t i = 0; i < 20; i++) ring.push(probe(i));
+    TEST_ASSERT_EQUAL(8, ring.readFrom(cursor, out, 8, &dropped));
+    TEST_ASSERT_EQUAL(12, dropped);
+    TEST_ASSERT_EQUAL(12, out[0].index);
+    TEST_ASSERT_EQUAL(19, out[7].index);
+
+    // An old index is no longer readable on its own either
+    TEST_ASSERT_FALSE(ring.read(3, out[0]));
+    TEST_ASSERT_TRUE(ring.read(19, out[0]));
+
+    // A cursor ahead of the writer restarts at the newest
+    cursor = 1000;
+    TEST_ASSERT_EQUAL(0, ring.readFrom(cursor, out, 8, &dropped));
+    TEST_ASSERT_EQUAL(20, cursor);
+}
+
+void test_imu_samples_round_trip(void) {
+    static ImuRing ring;
+    ImuSample in = {123456, 0.01f, -0.04f, 0.99f, 1.2f, -0.6f, 0.1f};
+    ImuSample out;
+    ring.push(in);
+    TEST_ASSERT_TRUE(ring.latest(out));
+    TEST_ASSERT_EQUAL(123456, out.usec);
+    TEST_ASSERT_EQUAL_FLOAT(0.99f, out.accelZ);
+    TEST_ASSERT_EQUAL_FLOAT(-0.6f, out.gyroY);
+}
+
+struct ReaderResult {
+    uint64_t reads = 0;
+    uint64_t dropped = 0;
+    uint64_t torn = 0;
+    uint64_t outOfOrder = 0;
+};
+
+static SampleRing<Probe, 256> stressRing;
+
+// Two latest() readers and three cursor readers (the last one slow) against
+// a writer that pushes `total` samples in bursts of `burst`, pausing
+// `pauseUs` between bursts (0: flat out). Checks every sample read.
+static void runStress(const char* name, uint32_t total, uint32_t burst, int pauseUs) {
+    std::atomic<bool> done(false);
+    uint32_t base = stressRing.written();
+    ReaderResult latestResults[2];
+    ReaderResult cursorResults[3];
+    std::vector<std::thread> readers;
+
+    // Latest-sample readers, like the UI and REST handlers
+    for (ReaderResult& r : latestResults) {
+        readers.emplace_back([&done, &r]() {
+            uint32_t last = 0;
+            Probe p;
+            while (!done.load(std::memory_order_acquire)) {
+                if (!stressRing.latest(p)) continue;
+                r.reads++;
+                if (!intact(p)) r.torn++;
+                if (p.index < last) r.outOfOrder++;
+                last = p.index;
+            }
+        });
+    }
+
+    // Cursor readers, like streams
+    for (int i = 0; i < 3; i++) {
+        ReaderResult& r = cursorResults[i];
+        bool slow = i == 2;
+        readers.emplace_back([&done, &r, slow, base]() {
+            uint32_t cursor = base;
+            uint32_t dropped = 0;
+            int64_t next = 0;
+            Probe batch[32];
+            for (;;) {
+                bool finished = done.load(std::memory_order_acquire);
+                size_t n = stressRing.readFrom(cursor, batch, slow ? 4 : 32, &dropped);
+                for (size_t k = 0; k < n; k++) {
+                    if (!intact(batch[k])) r.torn++;
+                    if ((int64_t)batch[k].index < next) r.outOfOrder++;
+                    next = batch[k].index + 1;
+                }
+                r.reads += n;
+                if (finished && cursor == stressRing.written()) break;
+                if (slow) std::this_thread::sleep_for(std::chrono::microseconds(50));
+            }
+            r.dropped = dropped;
+        });
+    }
+
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < total; i++) {
+        stressRing.push(probe(base + i));
+        if (pauseUs && (i + 1) % burst == 0) std::this_thread::sleep_for(std::chrono::microseconds(pauseUs));
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    done.store(true, std::memory_order_release);
+    for (std::thread& t : readers) t.join();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "%-9s| writer: %u samples in %.1f ms (%.2f M/s)", name, total, seconds * 1000,
+             total / seconds / 1e6);
+    TEST_MESSAGE(msg);
+    for (const ReaderResult& r : latestResults) {
+        snprintf(msg, sizeof(msg), "%-9s| latest: %llu reads, %llu torn, %llu backwards", name,
+                 (unsigned long long)r.reads, (unsigned long long)r.torn, (unsigned long long)r.outOfOrder);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL(0, r.torn);
+        TEST_ASSERT_EQUAL(0, r.outOfOrder);
+    }
+    for (int i = 0; i < 3; i++) {
+        const ReaderResult& r = cursorResults[i];
+        snprintf(msg, sizeof(msg), "%-9s| cursor%s: %llu read + %llu dropped, %llu torn, %llu out of order", name,
+                 i == 2 ? " (slow)" : "", (unsigned long long)r.reads, (unsigned long long)r.dropped,
+                 (unsigned long long)r.torn, (unsigned long long)r.outOfOrder);
+        TEST_MESSAGE(msg);
+        TEST_ASSERT_EQUAL(0, r.torn);
+        TEST_ASSERT_EQUAL(0, r.outOfOrder);
+        TEST_ASSERT_EQUAL(total, r.reads + r.dropped);
+    }
+}
+
+void test_stress_writer_flat_out(void) {
+    runStress("flat out", 2000000, 1, 0);
+}
+
+// Bursts, as when the sampler task wakes, with time for readers in between
+void test_stress_writer_in_bursts(void) {
+    runStress("bursts", 200000, 64, 200);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_ring_has_no_latest);
+    RUN_TEST(test_latest_and_read_from_in_order);
+    RUN_TEST(test_lapped_reader_skips_to_oldest_kept_and_counts_drops);
+    RUN_TEST(test_imu_samples_round_trip);
+    RUN_TEST(test_stress_writer_flat_out);
+    RUN_TEST(test_stress_writer_in_bursts);
+    return UNITY_END();
+}
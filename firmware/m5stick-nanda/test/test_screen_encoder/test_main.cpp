@@ -0,0 +1,201 @@
+/**
+ * Host tests and benchmark for the streaming PNG/QOI screenshot encoder.
+ *
+ * Known frames (every menu screen, a gradient and noise) are encoded from
+ * a 240x135 sprite, decoded again with M5GFX's own PNG and QOI decoders
+ * into a second sprite, and compared pixel for pixel. The benchmark
+ * reports encode time, file size and the encoder's memory next to the
+ * 64 KB frame.
+ *
+ *   pio test -e native_gfx -f test_screen_encoder
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <AgentDirectory.h>
+#include <ScreenEncoder.h>
+#include <Screens.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+#define PANEL_BYTES (PANEL_W * PANEL_H * 2)
+#define FILE_MAX (PANEL_W * PANEL_H * 4 + 4096)
+
+static AgentDirectory agents;
+static LGFX_Sprite frame;      // The frame buffer being captured
+static LGFX_Sprite decoded;
+static ScreenEncoder encoder;
+static uint8_t file[FILE_MAX];
+
+static const char* skillName(int index) {
+    static const char* names[] = {"Read Sensors", "Show on Display", "Play Tone"};
+    return names[index];
+}
+
+static ScreenState fixture() {
+    ScreenState state = {};
+    state.handle = "m5stick-a1b2c3";
+    state.ip = "192.168.1.42";
+    state.hostname = "nanda-a1b2c3";
+    state.ssid = "TestNet";
+    state.wifiConnected = true;
+    state.mdnsStarted = true;
+    state.registryConnected = true;
+    state.rssi = -58;
+    state.sensors = {0.01f, -0.04f, 0.99f, 1.2f, -0.6f, 0.1f, 31.4f, 4.02f, 87, false};
+    state.agents = &agents;
+    state.selectedAgent = -1;
+    state.skillName = skillName;
+    state.lastSkillResult = "";
+    state.seed = 12345;
+    return state;
+}
+
+static PixelSurface surfaceOf(LGFX_Sprite& sprite) {
+    return {(uint16_t*)sprite.getBuffer(), (int16_t)sprite.width(), (int16_t)sprite.height()};
+}
+
+// The whole file, read `piece` bytes at a time
+static size_t encode(ScreenFormat format, size_t piece) {
+    TEST_ASSERT_TRUE(encoder.begin(surfaceOf(frame), format));
+    size_t len = 0;
+    size_t n;
+    while ((n = encoder.read(file + len, piece < FILE_MAX - len ? piece : FILE_MAX - len)) > 0) {
+        len += n;
+    }
+    TEST_ASSERT_TRUE(encoder.done());
+    return len;
+}
+
+static bool decodesBack(ScreenFormat format, size_t len) {
+    decoded.fillScreen(TFT_MAGENTA);
+    bool ok = format == SCREEN_PNG ? decoded.drawPng(file, len, 0, 0) : decoded.drawQoi(file, len, 0, 0);
+    return ok && memcmp(frame.getBuffer(), decoded.getBuffer(), PANEL_BYTES) == 0;
+}
+
+static void drawGradient() {
+    for (int y = 0; y < PANEL_H; y++) {
+        for (int x = 0; x < PANEL_W; x++) {
+            frame.drawPixel(x, y, frame.color565(x, y * 255 / PANEL_H, (x + y) & 0xFF));
+        }
+    }
+}
+
+static void drawNoise() {
+    uint32_t state = 1;
+    uint16_t* p = (uint16_t*)frame.getBuffer();
+    for (int i = 0; i < PANEL_W * PANEL_H; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        p[i] = (uint16_t)state;
+    }
+}
+
+// Frames 0..MENU_COUNT-1 are the menu screens, then a gradient and noise
+#define FRAME_COUNT (MENU_COUNT + 2)
+
+static const char* drawFrame(int which) {
+    static const char* names[] = {"home", "sensors", "network", "discovery", "battery", "ir", "fx", "qr",
+                                  "gradient", "noise"};
+    if (which < MENU_COUNT) {
+        drawScreen(frame, (MenuScreen)which, fixture());
+    } else if (which == MENU_COUNT) {
+        drawGradient();
+    } else {
+        drawNoise();
+    }
+    return names[which];
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_png_decodes_identically(void) {
+    for (int which = 0; which < FRAME_COUNT; which++) {
+        const char* name = drawFrame(which);
+        size_t len = encode(SCREEN_PNG, 1460);
+        TEST_ASSERT_EQUAL_MEMORY("\x89PNG", file, 4);
+        TEST_ASSERT_TRUE_MESSAGE(decodesBack(SCREEN_PNG, len), name);
+    }
+}
+
+void test_qoi_decodes_identically(void) {
+    for (int which = 0; which < FRAME_COUNT; which++) {
+        const char* name = drawFrame(which);
+        size_t len = encode(SCREEN_QOI, 1460);
+        TEST_ASSERT_EQUAL_MEMORY("qoif", file, 4);
+        TEST_ASSERT_EQUAL_MEMORY("\0\0\0\0\0\0\0\1", file + len - 8, 8);
+        TEST_ASSERT_TRUE_MESSAGE(decodesBack(SCREEN_QOI, len), name);
+    }
+}
+
+void test_any_read_size_gives_the_same_file(void) {
+    static uint8_t whole[FILE_MAX];
+    drawFrame(MENU_QR);
+    for (int format = SCREEN_PNG; format <= SCREEN_QOI; format++) {
+        size_t len = encode((ScreenFormat)format, FILE_MAX);
+        memcpy(whole, file, len);
+        const size_t pieces[] = {1, 7, 64, 1023, 1036};
+        for (size_t piece : pieces) {
+            TEST_ASSERT_EQUAL(len, encode((ScreenFormat)format, piece));
+            TEST_ASSERT_EQUAL_MEMORY(whole, file, len);
+        }
+    }
+}
+
+void test_stopping_early_releases_the_encoder(void) {
+    drawFrame(MENU_HOME);
+    TEST_ASSERT_TRUE(encoder.begin(surfaceOf(frame), SCREEN_PNG));
+    TEST_ASSERT_EQUAL(100, encoder.read(file, 100));
+    encoder.end();
+    TEST_ASSERT_EQUAL(0, encoder.read(file, 100));
+    TEST_ASSERT_TRUE(encoder.done());
+
+    // Nothing to encode without a frame buffer
+    TEST_ASSERT_FALSE(encoder.begin({nullptr, 0, 0}, SCREEN_QOI));
+    TEST_ASSERT_EQUAL(0, encoder.read(file, 100));
+}
+
+void test_benchmark_encode(void) {
+    const int runs = 20;
+    char msg[160];
+    snprintf(msg, sizeof(msg), "memory   | frame %d B; encoder %u B + PNG deflate state %u B (QOI none)",
+             PANEL_BYTES, (unsigned)sizeof(ScreenEncoder), (unsigned)ScreenEncoder::stateBytes(SCREEN_PNG));
+    TEST_MESSAGE(msg);
+
+    for (int which = 0; which < FRAME_COUNT; which++) {
+        const char* name = drawFrame(which);
+        double us[2];
+        size_t len[2];
+        for (int format = SCREEN_PNG; format <= SCREEN_QOI; format++) {
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < runs; i++) {
+                len[format] = encode((ScreenFormat)format, 1460);
+            }
+            us[format] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / runs;
+        }
+        snprintf(msg, sizeof(msg), "%-9s| png %6u B %7.1f us | qoi %6u B %7.1f us",
+                 name, (unsigned)len[0], us[0], (unsigned)len[1], us[1]);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int argc, char** argv) {
+    frame.setColorDepth(16);
+    decoded.setColorDepth(16);
+    if (!frame.createSprite(PANEL_W, PANEL_H) || !decoded.createSprite(PANEL_W, PANEL_H)) return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_png_decodes_identically);
+    RUN_TEST(test_qoi_decodes_identically);
+    RUN_TEST(test_any_read_size_gives_the_same_file);
+    RUN_TEST(test_stopping_early_releases_the_encoder);
+    RUN_TEST(test_benchmark_encode);
+    return UNITY_END();
+}
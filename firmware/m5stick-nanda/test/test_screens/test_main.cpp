@@ -0,0 +1,302 @@
+/**
+ * Host tests and frame-time benchmark for the menu screens.
+ *
+ * The screens draw through M5GFX exactly as on the device. A 240x135
+ * RGB565 sprite stands in for the ST7789 so the test runs headless; the
+ * FrameBuffer pushes into it the way it pushes to the panel, and the
+ * Compositor's partial pushes are checked against full repaints.
+ *
+ * Set SCREENSHOT_DIR to write every screen as <dir>/<name>.ppm, e.g. to
+ * diff against screenshots of an earlier build.
+ *
+ *   pio test -e native_gfx -f test_screens
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <AgentDirectory.h>
+#include <Compositor.h>
+#include <FrameBuffer.h>
+#include <Screens.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+#define PANEL_BYTES (PANEL_W * PANEL_H * 2)
+
+static const MenuScreen WIDGET_SCREENS[] = {MENU_HOME, MENU_SENSORS, MENU_DISCOVERY, MENU_BATTERY};
+static const char* SCREEN_NAMES[] = {"home", "sensors", "network", "discovery", "battery", "ir", "fx", "qr"};
+
+static AgentDirectory agents;
+static LGFX_Sprite panel;     // The "display"
+static LGFX_Sprite direct;    // Screens drawn straight onto a target, the old way
+
+static const char* skillName(int index) {
+    static const char* names[] = {"Read Sensors", "Show on Display", "Play Tone"};
+    return names[index];
+}
+
+static ScreenState fixture() {
+    ScreenState state = {};
+    state.handle = "m5stick-a1b2c3";
+    state.ip = "192.168.1.42";
+    state.hostname = "nanda-a1b2c3";
+    state.ssid = "TestNet";
+    state.wifiConnected = true;
+    state.mdnsStarted = true;
+    state.registryConnected = true;
+    state.tunnelConnected = true;
+    state.rssi = -58;
+    state.sensors = {0.01f, -0.04f, 0.99f, 1.2f, -0.6f, 0.1f, 31.4f, 4.02f, 87, false};
+    state.agents = &agents;
+    state.selectedAgent = 1;
+    state.skillCount = 3;
+    state.skillName = skillName;
+    state.lastSkillResult = "";
+    state.seed = 12345;
+    return state;
+}
+
+static bool createPanel(LGFX_Sprite& sprite) {
+    sprite.setColorDepth(16);
+    return sprite.createSprite(PANEL_W, PANEL_H) != nullptr;
+}
+
+static const uint16_t* pixels(const LGFX_Sprite& sprite) {
+    return (const uint16_t*)sprite.getBuffer();
+}
+
+static bool samePixels(const LGFX_Sprite& a, const LGFX_Sprite& b) {
+    return memcmp(a.getBuffer(), b.getBuffer(), PANEL_BYTES) == 0;
+}
+
+// Lay out and compose one frame, as drawCurrentScreen() does on the device
+static void compose(Compositor& compositor, MenuScreen screen, const ScreenState& state) {
+    static Widgets ui;
+    ui.clear();
+    TEST_ASSERT_TRUE(layoutScreen(ui, screen, state));
+    compositor.compose(screen, ui);
+}
+
+// Binary PPM: no encoder needed, and any image diff tool reads it
+static void writeScreenshot(LGFX_Sprite& sprite, const char* name) {
+    const char* dir = getenv("SCREENSHOT_DIR");
+    if (!dir) return;
+    char path[256];
+    snprintf(path, sizeof(path), "%s/%s.ppm", dir, name);
+    FILE* f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    fprintf(f, "P6\n%d %d\n255\n", PANEL_W, PANEL_H);
+    for (int y = 0; y < PANEL_H; y++) {
+        for (int x = 0; x < PANEL_W; x++) {
+            RGBColor c = sprite.readPixelRGB(x, y);
+            uint8_t rgb[3] = {c.r, c.g, c.b};
+            fwrite(rgb, 1, 3, f);
+        }
+    }
+    fclose(f);
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_buffered_frames_match_direct_drawing(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    TEST_ASSERT_TRUE(frame.buffered());
+
+    ScreenState state = fixture();
+    for (int screen = 0; screen < MENU_COUNT; screen++) {
+        drawScreen(direct, (MenuScreen)screen, state);
+        drawScreen(frame.canvas(), (MenuScreen)screen, state);
+        frame.present();
+        TEST_ASSERT_TRUE_MESSAGE(samePixels(direct, panel), SCREEN_NAMES[screen]);
+        writeScreenshot(panel, SCREEN_NAMES[screen]);
+    }
+    TEST_ASSERT_EQUAL(MENU_COUNT, (int)frame.frames());
+
+    // The skills view of the discovery screen, with a result line
+    state.viewingSkills = true;
+    state.selectedSkill = 2;
+    state.lastSkillResult = "{\"success\":true,\"frequency\":880}";
+    drawScreen(direct, MENU_DISCOVERY, state);
+    drawScreen(frame.canvas(), MENU_DISCOVERY, state);
+    frame.present();
+    TEST_ASSERT_TRUE(samePixels(direct, panel));
+    writeScreenshot(panel, "skills");
+}
+
+void test_panel_only_changes_on_present(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    ScreenState state = fixture();
+
+    drawScreen(frame.canvas(), MENU_SENSORS, state);
+    frame.present();
+    LGFX_Sprite before;
+    TEST_ASSERT_TRUE(createPanel(before));
+    memcpy(before.getBuffer(), panel.getBuffer(), PANEL_BYTES);
+
+    // Drawing the next frame, black background first, is not visible...
+    state.sensors.temperature = 32.6f;
+    drawScreen(frame.canvas(), MENU_SENSORS, state);
+    TEST_ASSERT_TRUE(samePixels(before, panel));
+
+    // ...until it is presented, and then only the temperature line differs
+    frame.present();
+    int minY = PANEL_H, maxY = -1;
+    for (int y = 0; y < PANEL_H; y++) {
+        if (memcmp(pixels(before) + y * PANEL_W, pixels(panel) + y * PANEL_W, PANEL_W * 2) != 0) {
+            minY = y < minY ? y : minY;
+            maxY = y;
+        }
+    }
+    TEST_ASSERT_TRUE(maxY >= 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(105, minY);
+    TEST_ASSERT_LESS_THAN(105 + 8, maxY);
+}
+
+void test_composed_frames_match_full_repaints(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Compositor compositor(frame);
+    ScreenState state = fixture();
+
+    // Every change a refresh can bring, each checked against a full repaint
+    for (MenuScreen screen : WIDGET_SCREENS) {
+        for (int step = 0; step < 10; step++) {
+            state.sensors.temperature = 31.4f + step * 0.7f;
+            state.sensors.accelX = step * 0.13f - 0.5f;
+            state.sensors.batteryPercent = 100 - step * 11;  // Colour and bar width change
+            state.sensors.isCharging = step % 3 == 0;
+            state.sensors.batteryVoltage = 4.2f - step * 0.05f;
+            state.selectedAgent = step % 3;
+            state.tunnelConnected = step % 4 != 1;           // Widgets come and go
+            state.wifiConnected = step != 5;
+            state.viewingSkills = step >= 6;
+            state.selectedSkill = step % 3;
+            state.lastSkillResult = step == 8 ? "{\"success\":true}" : "";
+
+            compose(compositor, screen, state);
+            drawScreen(direct, screen, state);
+            char msg[40];
+            snprintf(msg, sizeof(msg), "%s step %d", SCREEN_NAMES[screen], step);
+            TEST_ASSERT_TRUE_MESSAGE(samePixels(direct, panel), msg);
+        }
+    }
+}
+
+void test_temperature_change_pushes_little(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    Compositor compositor(frame);
+    ScreenState state = fixture();
+
+    compose(compositor, MENU_SENSORS, state);
+    TEST_ASSERT_EQUAL(PANEL_BYTES, (int)frame.lastFrameBytes());  // New screen: full push
+
+    // Nothing changed: nothing pushed
+    compose(compositor, MENU_SENSORS, state);
+    TEST_ASSERT_EQUAL(0, (int)frame.lastFrameBytes());
+    TEST_ASSERT_EQUAL(0, compositor.dirtyCount());
+
+    // Only the temperature: one small region, under 2% of the panel
+    state.sensors.temperature = 32.6f;
+    compose(compositor, MENU_SENSORS, state);
+    TEST_ASSERT_EQUAL(1, compositor.dirtyCount());
+    TEST_ASSERT_GREATER_OR_EQUAL(105, (int)compositor.dirty(0).y);
+    TEST_ASSERT_LESS_THAN(PANEL_BYTES / 50, (int)frame.lastFrameBytes());
+    drawScreen(direct, MENU_SENSORS, state);
+    TEST_ASSERT_TRUE(samePixels(direct, panel));
+
+    // Same on the home screen's quick stats line
+    compose(compositor, MENU_HOME, state);
+    state.sensors.temperature = 29.9f;
+    compose(compositor, MENU_HOME, state);
+    TEST_ASSERT_LESS_THAN(PANEL_BYTES / 50, (int)frame.lastFrameBytes());
+    drawScreen(direct, MENU_HOME, state);
+    TEST_ASSERT_TRUE(samePixels(direct, panel));
+
+    // After something else drew on the panel, everything goes out again
+    compositor.invalidate();
+    compose(compositor, MENU_HOME, state);
+    TEST_ASSERT_EQUAL(PANEL_BYTES, (int)frame.lastFrameBytes());
+}
+
+void test_fx_decorations_follow_seed(void) {
+    LGFX_Sprite again;
+    TEST_ASSERT_TRUE(createPanel(again));
+    ScreenState state = fixture();
+
+    drawScreen(direct, MENU_FX, state);
+    drawScreen(again, MENU_FX, state);
+    TEST_ASSERT_TRUE(samePixels(direct, again));
+
+    state.seed = 54321;
+    drawScreen(again, MENU_FX, state);
+    TEST_ASSERT_FALSE(samePixels(direct, again));
+}
+
+void test_benchmark_frame_time(void) {
+    FrameBuffer frame(&panel);
+    TEST_ASSERT_TRUE(frame.begin());
+    ScreenState state = fixture();
+    const int rounds = 200;
+
+    for (int screen = 0; screen < MENU_COUNT; screen++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            state.sensors.temperature = 30.0f + (i % 20) * 0.1f;
+            drawScreen(frame.canvas(), (MenuScreen)screen, state);
+            frame.present();
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        char msg[120];
+        snprintf(msg, sizeof(msg), "%-9s | %7.1f us per frame (draw + present), %u bytes pushed",
+                 SCREEN_NAMES[screen], us / rounds, (unsigned)frame.lastFrameBytes());
+        TEST_MESSAGE(msg);
+    }
+
+    // The same refreshes through the compositor: only the changed fields go out
+    for (MenuScreen screen : WIDGET_SCREENS) {
+        Compositor compositor(frame);
+        compose(compositor, screen, state);
+        uint64_t startBytes = frame.bytesPushed();
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < rounds; i++) {
+            state.sensors.temperature = 30.0f + (i % 20) * 0.1f;
+            compose(compositor, screen, state);
+        }
+        double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+
+        char msg[120];
+        snprintf(msg, sizeof(msg), "%-9s | %7.1f us per frame (composed), %u bytes pushed on average",
+                 SCREEN_NAMES[screen], us / rounds, (unsigned)((frame.bytesPushed() - startBytes) / rounds));
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int argc, char** argv) {
+    agents.beginPass();
+    agents.upsert("weather-bot", "http://10.0.0.7", "Weather Bot", true);
+    agents.upsert("m5stick-d4e5f6", "http://10.0.0.9", "M5Stick d4e5f6", true);
+    agents.upsert("printer-agent", "http://10.0.0.12", "Printer", false);
+    agents.endPass(true);
+
+    if (!createPanel(panel) || !createPanel(direct)) return 1;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_buffered_frames_match_direct_drawing);
+    RUN_TEST(test_panel_only_changes_on_present);
+    RUN_TEST(test_composed_frames_match_full_repaints);
+    RUN_TEST(test_temperature_change_pushes_little);
+    RUN_TEST(test_fx_decorations_follow_seed);
+    RUN_TEST(test_benchmark_frame_time);
+    return UNITY_END();
+}
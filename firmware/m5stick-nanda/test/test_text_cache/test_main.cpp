@@ -0,0 +1,280 @@
+/**
+ * Host tests and benchmark for the widget text glyph cache.
+ *
+ * Text drawn from the cache is compared pixel for pixel with the same
+ * text printed through M5GFX, over a noisy background so that any pixel
+ * the cache wrongly paints (or misses) shows. Runs that print() would
+ * clip, wrap or shift must come out the same too, by falling back. The
+ * benchmark times the widget screens drawn both ways, as on the device's
+ * frame buffer.
+ *
+ *   pio test -e native_gfx -f test_text_cache
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <AgentDirectory.h>
+#include <Screens.h>
+#include <TextCache.h>
+
+#define PANEL_W 240
+#define PANEL_H 135
+#define PANEL_BYTES (PANEL_W * PANEL_H * 2)
+
+static const MenuScreen WIDGET_SCREENS[] = {MENU_HOME, MENU_SENSORS, MENU_DISCOVERY, MENU_BATTERY};
+static const char* WIDGET_SCREEN_NAMES[] = {"home", "sensors", "discovery", "battery"};
+
+static AgentDirectory agents;
+static LGFX_Sprite printed;   // Drawn through print()
+static LGFX_Sprite cached;    // Drawn through the cache
+
+static const char* skillName(int index) {
+    static const char* names[] = {"Read Sensors", "Show on Display", "Play Tone"};
+    return names[index];
+}
+
+static ScreenState fixture() {
+    ScreenState state = {};
+    state.handle = "m5stick-a1b2c3";
+    state.ip = "192.168.1.42";
+    state.hostname = "nanda-a1b2c3";
+    state.ssid = "TestNet";
+    state.wifiConnected = true;
+    state.mdnsStarted = true;
+    state.registryConnected = true;
+    state.tunnelConnected = true;
+    state.rssi = -58;
+    state.sensors = {0.01f, -0.04f, 0.99f, 1.2f, -0.6f, 0.1f, 31.4f, 4.02f, 87, false};
+    state.agents = &agents;
+    state.selectedAgent = 1;
+    state.skillCount = 3;
+    state.skillName = skillName;
+    state.lastSkillResult = "";
+    state.seed = 12345;
+    return state;
+}
+
+static PixelSurface surfaceOf(LGFX_Sprite& sprite) {
+    return {(uint16_t*)sprite.getBuffer(), (int16_t)sprite.width(), (int16_t)sprite.height()};
+}
+
+// The same noise on both sprites, so transparent text shows every pixel it touches
+static void fillNoise() {
+    uint32_t state = 7;
+    uint16_t* a = (uint16_t*)printed.getBuffer();
+    uint16_t* b = (uint16_t*)cached.getBuffer();
+    for (int i = 0; i < PANEL_W * PANEL_H; i++) {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        a[i] = b[i] = (uint16_t)state;
+    }
+}
+
+static void printText(int x, int y, const char* text, uint8_t size, uint16_t color) {
+    printed.setTextSize(size);
+    printed.setTextColor(color);
+    printed.setCursor(x, y);
+    printed.print(text);
+}
+
+static bool same() {
+    return memcmp(printed.getBuffer(), cached.getBuffer(), PANEL_BYTES) == 0;
+}
+
+void setUp(void) {
+    printed.clearClipRect();
+    cached.clearClipRect();
+}
+
+void tearDown(void) {}
+
+void test_every_glyph_matches_print(void) {
+    TextCache cache;
+    const uint16_t colors[] = {TFT_WHITE, TFT_CYAN, TFT_DARKGREY, 0x1234};
+    char line[40];
+
+    char msg[16];
+
+    for (uint8_t size = 1; size <= 4; size++) {
+        snprintf(msg, sizeof(msg), "size %d", size);
+        fillNoise();
+        // Full-width lines, as many pages as it takes
+        int perLine = PANEL_W / (6 * size);
+        int y = 0;
+        int used = 0;
+        for (int c = 0x20; c <= 0x7E; c++) {
+            line[used++] = (char)c;
+            if (used == perLine || c == 0x7E) {
+                if (y + 8 * size > PANEL_H) {
+                    TEST_ASSERT_TRUE_MESSAGE(same(), msg);
+                    fillNoise();
+                    y = 0;
+                }
+                line[used] = '\0';
+                uint16_t color = colors[(c + size) % 4];
+                printText(0, y, line, size, color);
+                cache.draw(cached, surfaceOf(cached), 0, y, line, size, color);
+                y += 8 * size;
+                used = 0;
+            }
+        }
+        TEST_ASSERT_TRUE_MESSAGE(same(), msg);
+    }
+    TEST_ASSERT_EQUAL(0, cache.fallbacks());
+}
+
+void test_runs_print_would_move_or_clip_fall_back(void) {
+    TextCache cache;
+    struct Case {
+        int x, y;
+        uint8_t size;
+        const char* text;
+    };
+    const Case cases[] = {
+        {200, 40, 1, "Wraps past the right edge"},
+        {-9, 10, 2, "Left of the panel"},
+        {10, 130, 1, "Below the bottom"},
+        {10, 50, 1, "Tab\tand \xC3\xA9"},
+    };
+
+    fillNoise();
+    for (const Case& c : cases) {
+        printText(c.x, c.y, c.text, c.size, TFT_YELLOW);
+        cache.draw(cached, surfaceOf(cached), c.x, c.y, c.text, c.size, TFT_YELLOW);
+    }
+    TEST_ASSERT_TRUE(same());
+    TEST_ASSERT_EQUAL(4, cache.fallbacks());
+
+    // Partly inside a clip rectangle, as the Compositor redraws: print() shifts it
+    printed.setClipRect(40, 60, 80, 30);
+    cached.setClipRect(40, 60, 80, 30);
+    printText(30, 70, "Registry 3 agents", 1, TFT_WHITE);
+    cache.draw(cached, surfaceOf(cached), 30, 70, "Registry 3 agents", 1, TFT_WHITE);
+    TEST_ASSERT_TRUE(same());
+    TEST_ASSERT_EQUAL(5, cache.fallbacks());
+
+    // Wholly inside it is cached
+    printText(45, 62, "Accel", 1, TFT_WHITE);
+    cache.draw(cached, surfaceOf(cached), 45, 62, "Accel", 1, TFT_WHITE);
+    TEST_ASSERT_TRUE(same());
+    TEST_ASSERT_EQUAL(5, cache.fallbacks());
+
+    // No pixel buffer: always print()
+    cache.draw(printed, PixelSurface(), 45, 62, "Accel", 1, TFT_WHITE);
+    TEST_ASSERT_EQUAL(6, cache.fallbacks());
+}
+
+void test_counts_hits_and_misses(void) {
+    TextCache cache;
+    fillNoise();
+    cache.draw(cached, surfaceOf(cached), 10, 35, "Accel X:", 1, TFT_WHITE);
+    TEST_ASSERT_EQUAL(7, cache.misses());   // "c" twice
+    TEST_ASSERT_EQUAL(1, cache.hits());
+    TEST_ASSERT_EQUAL(7, cache.glyphs());
+    TEST_ASSERT_EQUAL(7 * 8, cache.rowsUsed());
+
+    // Another colour and place uses the same glyphs; another size does not
+    cache.draw(cached, surfaceOf(cached), 10, 50, "Accel X:", 1, TFT_CYAN);
+    TEST_ASSERT_EQUAL(7, cache.misses());
+    TEST_ASSERT_EQUAL(9, cache.hits());
+    cache.draw(cached, surfaceOf(cached), 10, 70, "X", 2, TFT_CYAN);
+    TEST_ASSERT_EQUAL(8, cache.misses());
+    TEST_ASSERT_EQUAL(7 * 8 + 16, cache.rowsUsed());
+}
+
+void test_fills_up_empties_and_stays_exact(void) {
+    TextCache cache;
+    char line[2] = {0, 0};
+    fillNoise();
+    // Every glyph at sizes 1-4 needs 95 * (8 + 16 + 24 + 32) rows, far over the arena
+    for (int round = 0; round < 2; round++) {
+        for (uint8_t size = 1; size <= 4; size++) {
+            for (int c = 0x20; c <= 0x7E; c++) {
+                line[0] = (char)c;
+                int x = (c - 0x20) * 17 % (PANEL_W - 24);
+                int y = (c * 7 + size * 29) % (PANEL_H - 32);
+                uint16_t color = (uint16_t)(c * 977 + size);
+                printText(x, y, line, size, color);
+                cache.draw(cached, surfaceOf(cached), x, y, line, size, color);
+            }
+        }
+    }
+    TEST_ASSERT_TRUE(same());
+    TEST_ASSERT_TRUE(cache.flushes() > 0);
+    TEST_ASSERT_TRUE(cache.rowsUsed() <= TEXT_CACHE_ROWS);
+    TEST_ASSERT_TRUE(cache.glyphs() <= TEXT_CACHE_SLOTS * 3 / 4);
+}
+
+void test_widget_screens_match_print(void) {
+    ScreenState state = fixture();
+    for (size_t i = 0; i < sizeof(WIDGET_SCREENS) / sizeof(WIDGET_SCREENS[0]); i++) {
+        Widgets ui;
+        TEST_ASSERT_TRUE(layoutScreen(ui, WIDGET_SCREENS[i], state));
+        ui.draw(printed);
+        ui.draw(cached, TFT_BLACK, surfaceOf(cached));
+        TEST_ASSERT_TRUE_MESSAGE(same(), WIDGET_SCREEN_NAMES[i]);
+    }
+}
+
+void test_benchmark_widget_screens(void) {
+    const int runs = 2000;
+    ScreenState state = fixture();
+    char msg[160];
+    snprintf(msg, sizeof(msg), "memory    | cache %u B (%d slots, %d mask rows)", (unsigned)sizeof(TextCache),
+             TEXT_CACHE_SLOTS, TEXT_CACHE_ROWS);
+    TEST_MESSAGE(msg);
+
+    TextCache& cache = widgetTextCache();
+    for (size_t i = 0; i < sizeof(WIDGET_SCREENS) / sizeof(WIDGET_SCREENS[0]); i++) {
+        Widgets ui;
+        layoutScreen(ui, WIDGET_SCREENS[i], state);
+        PixelSurface surface = surfaceOf(cached);
+        ui.draw(cached, TFT_BLACK, surface);    // Warm the cache
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < runs; r++) {
+            ui.draw(printed);
+        }
+        auto middle = std::chrono::steady_clock::now();
+        uint32_t hits = cache.hits();
+        uint32_t misses = cache.misses();
+        for (int r = 0; r < runs; r++) {
+            ui.draw(cached, TFT_BLACK, surface);
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        double printUs = std::chrono::duration<double, std::micro>(middle - start).count() / runs;
+        double cachedUs = std::chrono::duration<double, std::micro>(end - middle).count() / runs;
+        uint32_t lookups = (cache.hits() - hits) + (cache.misses() - misses);
+        snprintf(msg, sizeof(msg), "%-10s| print %6.2f us | cached %6.2f us | x%.2f | hit rate %.1f%%",
+                 WIDGET_SCREEN_NAMES[i], printUs, cachedUs, printUs / cachedUs,
+                 lookups ? 100.0 * (cache.hits() - hits) / lookups : 0.0);
+        TEST_MESSAGE(msg);
+    }
+}
+
+int main(int argc, char** argv) {
+    printed.setColorDepth(16);
+    cached.setColorDepth(16);
+    if (!printed.createSprite(PANEL_W, PANEL_H) || !cached.createSprite(PANEL_W, PANEL_H)) return 1;
+
+    agents.beginPass();
+    agents.upsert("weather-bot", "http://10.0.0.7", "Weather Bot", true);
+    agents.upsert("m5stick-d4e5f6", "http://10.0.0.9", "M5Stick d4e5f6", true);
+    agents.upsert("printer-agent", "http://10.0.0.12", "Printer", false);
+    agents.endPass(true);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_every_glyph_matches_print);
+    RUN_TEST(test_runs_print_would_move_or_clip_fall_back);
+    RUN_TEST(test_counts_hits_and_misses);
+    RUN_TEST(test_fills_up_empties_and_stays_exact);
+    RUN_TEST(test_widget_screens_match_print);
+    RUN_TEST(test_benchmark_widget_screens);
+    return UNITY_END();
+}
@@ -0,0 +1,403 @@
+/**
+ * Host tests and wire benchmark for the tunnel envelope codec.
+ *
+ * The benchmark relays the sensor and agent-card responses the old way
+ * (body escaped into a JSON envelope built per request) and with both
+ * TunnelCodec framings, and reports bytes on the wire plus time per
+ * round trip: the device decodes the request frame and encodes the
+ * response, the relay decodes the response and extracts the body.
+ *
+ *   pio test -e native -f test_tunnel_codec
+ */
+
+#include <unity.h>
+
+#include <chrono>
+#include <string>
+
+#include <AgentCard.h>
+#include <TunnelCodec.h>
+
+static uint8_t frame[TUNNEL_FRAME_MAX];
+
+static const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", nullptr},
+    {"display/show", "Show on Display", "Display text on LCD", nullptr},
+    {"button/status", "Button Status", "Get current button states", nullptr},
+    {"buzzer/tone", "Play Tone", "Play a tone on the buzzer", nullptr},
+    {"battery/status", "Battery Status", "Get battery voltage and percentage", nullptr},
+    {"wifi/scan", "Scan WiFi", "Scan for nearby WiFi networks", nullptr}
+};
+
+static TunnelResponse makeResponse(const char* id, const std::string& body) {
+    TunnelResponse r = {id, 200, nullptr, nullptr, body.data(), body.size(), 0};
+    return r;
+}
+
+// skillSensorsRead() output for a device lying still
+static std::string sensorsBody() {
+    JsonDocument doc;
+    JsonObject accel = doc["accelerometer"].to<JsonObject>();
+    accel["x"] = 0.0123f;
+    accel["y"] = -0.0456f;
+    accel["z"] = 0.9981f;
+    JsonObject gyro = doc["gyroscope"].to<JsonObject>();
+    gyro["x"] = 1.25f;
+    gyro["y"] = -0.61f;
+    gyro["z"] = 0.07f;
+    doc["temperature"] = 31.4f;
+    doc["timestamp"] = 123456789;
+    std::string out;
+    serializeJson(doc, out);
+    return out;
+}
+
+static std::string cardBody() {
+    AgentCardInfo info;
+    info.name = "M5Stick a1b2c3";
+    info.handle = "m5stick-a1b2c3";
+    info.deviceId = "a1b2c3d4e5f6";
+    info.description = "M5StickC Plus 2 IoT device with sensors, display, IR, and controls";
+    info.url = "http://m5stick-a1b2c3.local";
+    info.version = "1.0.0";
+    info.skills = SKILLS;
+    info.skillCount = SKILL_COUNT(SKILLS);
+    AgentCard card;
+    card.update(info);
+    return std::string(card.json(), card.length());
+}
+
+// The envelope webSocketEvent() used to build: body copied into the document
+static size_t encodeLegacy(const char* id, const std::string& body, std::string& out) {
+    JsonDocument doc;
+    doc["type"] = "response";
+    doc["id"] = id;
+    doc["headers"]["Content-Type"] = "application/json";
+    doc["status"] = 200;
+    doc["body"] = body;
+    out.clear();
+    serializeJson(doc, out);
+    return out.size();
+}
+
+void setUp(void) {}
+
+void tearDown(void) {}
+
+void test_negotiation_defaults_to_json(void) {
+    TunnelCodec codec;
+    TEST_ASSERT_EQUAL(TUNNEL_JSON, codec.encoding());
+
+    // An older registry confirms without naming an encoding
+    JsonDocument connected;
+    deserializeJson(connected, "{\"type\":\"connected\",\"handle\":\"m5stick-a1b2c3\"}");
+    TEST_ASSERT_EQUAL(TUNNEL_JSON, codec.negotiate(connected.as<JsonVariantConst>()));
+
+    deserializeJson(connected, "{\"type\":\"connected\",\"encoding\":\"cbor\"}");
+    TEST_ASSERT_EQUAL(TUNNEL_JSON, codec.negotiate(connected.as<JsonVariantConst>()));
+
+    deserializeJson(connected, "{\"type\":\"connected\",\"encoding\":\"msgpack\"}");
+    TEST_ASSERT_EQUAL(TUNNEL_MSGPACK, codec.negotiate(connected.as<JsonVariantConst>()));
+    TEST_ASSERT_TRUE(codec.binary());
+
+    codec.reset();
+    TEST_ASSERT_FALSE(codec.binary());
+}
+
+void test_json_envelope_escapes_body(void) {
+    TunnelCodec codec;
+    std::string body = "{\"text\":\"a \\\"b\\\"\"}\n\t\x01 caf\xc3\xa9";
+    TunnelResponse r = makeResponse("req-1", body);
+    r.etag = "\"1a2b3c4d\"";
+
+    size_t n = codec.encodeResponse(r, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(n > 0);
+    TEST_ASSERT_EQUAL(n, strlen((const char*)frame));
+
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, n, false, doc));
+    TEST_ASSERT_EQUAL_STRING("response", doc["type"]);
+    TEST_ASSERT_EQUAL_STRING("req-1", doc["id"]);
+    TEST_ASSERT_EQUAL(200, doc["status"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("application/json", doc["headers"]["Content-Type"]);
+    TEST_ASSERT_EQUAL_STRING("\"1a2b3c4d\"", doc["headers"]["ETag"]);
+    TEST_ASSERT_EQUAL_STRING(body.c_str(), doc["body"]);
+
+    // Control characters become \u escapes, which ArduinoJson leaves raw
+    TEST_ASSERT_NOT_NULL(strstr((const char*)frame, "\\n\\t\\u0001 caf"));
+
+    // Otherwise the same bytes ArduinoJson would have produced for the body
+    body = "{\"text\":\"a \\\"b\\\"\"}\n\t caf\xc3\xa9";
+    std::string legacy;
+    encodeLegacy("req-1", body, legacy);
+    std::string escaped = legacy.substr(legacy.find("\"body\":"));
+    n = codec.encodeResponse(makeResponse("req-1", body), frame, sizeof(frame));
+    TEST_ASSERT_EQUAL_STRING(escaped.c_str(), strstr((const char*)frame, "\"body\":"));
+}
+
+void test_msgpack_envelope_carries_raw_body(void) {
+    TunnelCodec codec;
+    JsonDocument connected;
+    connected["encoding"] = "msgpack";
+    codec.negotiate(connected.as<JsonVariantConst>());
+
+    // bin 8 and bin 16 length headers
+    static uint8_t big[4096];
+    const size_t sizes[] = {0, 5, 255, 256, 3000};
+    for (size_t s : sizes) {
+        std::string body(s, '\0');
+        for (size_t i = 0; i < s; i++) body[i] = (char)(i * 7);
+        TunnelResponse r = makeResponse("req-2", body);
+        r.status = 304;
+        r.contentType = "text/plain";
+
+        size_t n = codec.encodeResponse(r, big, sizeof(big));
+        TEST_ASSERT_TRUE(n > s);
+
+        JsonDocument doc;
+        TEST_ASSERT_FALSE(TunnelCodec::decode(big, n, true, doc));
+        TEST_ASSERT_EQUAL_STRING("req-2", doc["id"]);
+        TEST_ASSERT_EQUAL(304, doc["status"].as<int>());
+        TEST_ASSERT_EQUAL_STRING("text/plain", doc["headers"]["Content-Type"]);
+        TEST_ASSERT_TRUE(doc["headers"]["ETag"].isNull());
+
+        size_t len = 0;
+        const char* got = TunnelCodec::body(doc.as<JsonVariantConst>(), len);
+        TEST_ASSERT_EQUAL(s, len);
+        TEST_ASSERT_TRUE(s == 0 || memcmp(got, body.data(), s) == 0);
+    }
+}
+
+void test_decodes_requests_in_either_framing(void) {
+    // Text frame from a JSON registry
+    const char* text = "{\"type\":\"request\",\"id\":\"7\",\"method\":\"POST\",\"path\":\"/a2a\","
+                       "\"body\":\"{\\\"jsonrpc\\\":\\\"2.0\\\"}\"}";
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(TunnelCodec::decode((const uint8_t*)text, strlen(text), false, doc));
+    size_t len = 0;
+    const char* body = TunnelCodec::body(doc.as<JsonVariantConst>(), len);
+    std::string got(body, len);
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\"}", got.c_str());
+
+    // Binary frame with the body as bin
+    JsonDocument req;
+    req["type"] = "request";
+    req["id"] = "8";
+    req["path"] = "/a2a";
+    req["body"] = MsgPackBinary("{\"id\":1}", 8);
+    uint8_t buf[128];
+    size_t n = serializeMsgPack(req, buf, sizeof(buf));
+    TEST_ASSERT_FALSE(TunnelCodec::decode(buf, n, true, doc));
+    TEST_ASSERT_EQUAL_STRING("/a2a", doc["path"]);
+    body = TunnelCodec::body(doc.as<JsonVariantConst>(), len);
+    got.assign(body, len);
+    TEST_ASSERT_EQUAL_STRING("{\"id\":1}", got.c_str());
+
+    // GET without a body
+    TEST_ASSERT_FALSE(TunnelCodec::decode((const uint8_t*)"{\"path\":\"/\"}", 12, false, doc));
+    TunnelCodec::body(doc.as<JsonVariantConst>(), len);
+    TEST_ASSERT_EQUAL(0, (int)len);
+
+    TEST_ASSERT_TRUE(TunnelCodec::decode((const uint8_t*)"\xc1", 1, true, doc));
+}
+
+void test_parse_json_in_place(void) {
+    char text[] =
+        "{ \"type\" : \"request\", \"meta\": {\"hops\": [1, 2.5e3, {\"x\": null}], \"ok\": true},"
+        "\"id\":\"r\\u00e9q-\\ud83d\\ude00\",\"method\":\"POST\",\"path\":\"/a2a?x=1\","
+        "\"headers\":{\"if-none-match\":\"\\\"abc\\\"\",\"Accept\":\"*/*\"},"
+        "\"body\":\"{\\\"jsonrpc\\\":\\\"2.0\\\"}\\n\"}";
+    TunnelMessage msg;
+    TEST_ASSERT_TRUE(TunnelCodec::parse((uint8_t*)text, strlen(text), false, msg));
+    TEST_ASSERT_EQUAL_STRING("request", msg.type);
+    TEST_ASSERT_EQUAL_STRING("r\xc3\xa9q-\xf0\x9f\x98\x80", msg.id);
+    TEST_ASSERT_EQUAL_STRING("POST", msg.method);
+    TEST_ASSERT_EQUAL_STRING("/a2a?x=1", msg.path);
+    TEST_ASSERT_EQUAL_STRING("\"abc\"", msg.ifNoneMatch);
+    TEST_ASSERT_EQUAL_STRING("{\"jsonrpc\":\"2.0\"}\n", msg.body);
+    TEST_ASSERT_EQUAL(strlen(msg.body), msg.bodyLen);
+    // Views point into the frame itself
+    TEST_ASSERT_TRUE(msg.path > text && msg.path < text + sizeof(text));
+
+    // Defaults for what the registry left out; non-string values are ignored
+    char bare[] = "{\"type\":\"connected\",\"encoding\":\"msgpack\",\"id\":7,\"body\":null}";
+    TEST_ASSERT_TRUE(TunnelCodec::parse((uint8_t*)bare, strlen(bare), false, msg));
+    TEST_ASSERT_EQUAL_STRING("msgpack", msg.encoding);
+    TEST_ASSERT_EQUAL_STRING("", msg.id);
+    TEST_ASSERT_EQUAL_STRING("GET", msg.method);
+    TEST_ASSERT_EQUAL_STRING("/", msg.path);
+    TEST_ASSERT_NULL(msg.ifNoneMatch);
+    TEST_ASSERT_EQUAL(0, (int)msg.bodyLen);
+}
+
+void test_parse_msgpack_in_place(void) {
+    std::string longPath = "/api/display?text=" + std::string(100, 'x');   // str 8
+    JsonDocument req;
+    req["type"] = "request";
+    req["id"] = "9";
+    req["status"] = 12345;
+    req["extra"]["list"].add(1.5);
+    req["extra"]["list"].add("s");
+    req["method"] = "POST";
+    req["path"] = longPath;
+    req["headers"]["If-None-Match"] = "\"e\"";
+    req["body"] = MsgPackBinary("{\"id\":1}", 8);
+    uint8_t buf[512];
+    size_t n = serializeMsgPack(req, buf, sizeof(buf));
+
+    TunnelMessage msg;
+    TEST_ASSERT_TRUE(TunnelCodec::parse(buf, n, true, msg));
+    TEST_ASSERT_EQUAL_STRING("request", msg.type);
+    TEST_ASSERT_EQUAL_STRING("9", msg.id);
+    TEST_ASSERT_EQUAL_STRING("POST", msg.method);
+    TEST_ASSERT_EQUAL_STRING(longPath.c_str(), msg.path);
+    TEST_ASSERT_EQUAL_STRING("\"e\"", msg.ifNoneMatch);
+    TEST_ASSERT_EQUAL(8, (int)msg.bodyLen);
+    TEST_ASSERT_EQUAL_STRING("{\"id\":1}", msg.body);
+}
+
+void test_parse_rejects_malformed_frames(void) {
+    const char* text = "{\"type\":\"request\",\"id\":\"1\",\"headers\":{\"a\":[1,{\"b\":\"}\"}]},\"body\":\"x\"}";
+    JsonDocument req;
+    deserializeJson(req, text);
+    uint8_t packed[128];
+    size_t packedLen = serializeMsgPack(req, packed, sizeof(packed));
+
+    // Every truncation fails cleanly, without reading past the end
+    TunnelMessage msg;
+    for (size_t cut = 0; cut < strlen(text); cut++) {
+        std::string copy(text, cut);
+        TEST_ASSERT_FALSE(TunnelCodec::parse((uint8_t*)&copy[0], cut, false, msg));
+    }
+    for (size_t cut = 0; cut < packedLen; cut++) {
+        std::string copy((const char*)packed, cut);
+        TEST_ASSERT_FALSE(TunnelCodec::parse((uint8_t*)&copy[0], cut, true, msg));
+    }
+
+    const char* bad[] = {"[]", "{\"id\" 1}", "{\"id\":\"\\q\"}", "{,}", "\"x\""};
+    for (const char* b : bad) {
+        std::string copy(b);
+        TEST_ASSERT_FALSE(TunnelCodec::parse((uint8_t*)&copy[0], copy.size(), false, msg));
+    }
+    // Unknown values are skipped leniently, but never past the frame
+    uint8_t nul[] = {'{', '"', 'a', '"', ':', 0};
+    TEST_ASSERT_FALSE(TunnelCodec::parse(nul, sizeof(nul), false, msg));
+    uint8_t notMap[] = {0x92, 0xa1, 'x', 0xc1};
+    TEST_ASSERT_FALSE(TunnelCodec::parse(notMap, sizeof(notMap), true, msg));
+    TEST_ASSERT_FALSE(TunnelCodec::parse(nullptr, 0, false, msg));
+}
+
+void test_frame_overflow_returns_zero(void) {
+    TunnelCodec codec;
+    std::string body(200, '"');   // Doubles when escaped
+    uint8_t small[300];
+    TEST_ASSERT_EQUAL(0, (int)codec.encodeResponse(makeResponse("x", body), small, sizeof(small)));
+
+    JsonDocument connected;
+    connected["encoding"] = "msgpack";
+    codec.negotiate(connected.as<JsonVariantConst>());
+    TEST_ASSERT_TRUE(codec.encodeResponse(makeResponse("x", body), small, sizeof(small)) > 0);
+    TEST_ASSERT_EQUAL(0, (int)codec.encodeResponse(makeResponse("x", body), small, 210));
+
+    JsonDocument heartbeat;
+    heartbeat["type"] = "heartbeat";
+    heartbeat["handle"] = "m5stick-a1b2c3";
+    size_t n = codec.encodeMessage(heartbeat.as<JsonVariantConst>(), small, sizeof(small));
+    JsonDocument back;
+    TEST_ASSERT_FALSE(TunnelCodec::decode(small, n, true, back));
+    TEST_ASSERT_EQUAL_STRING("heartbeat", back["type"]);
+    TEST_ASSERT_EQUAL(0, (int)codec.encodeMessage(heartbeat.as<JsonVariantConst>(), small, 8));
+}
+
+struct Measured {
+    size_t bytes;
+    double us;
+};
+
+// Request in, response out, response decoded by the relay
+static Measured roundTrip(int mode, const std::string& body, int rounds) {
+    using clock = std::chrono::steady_clock;
+    TunnelCodec codec;
+    if (mode == 2) {
+        JsonDocument connected;
+        connected["encoding"] = "msgpack";
+        codec.negotiate(connected.as<JsonVariantConst>());
+    }
+
+    JsonDocument reqDoc;
+    reqDoc["type"] = "request";
+    reqDoc["id"] = "c0ffee42";
+    reqDoc["method"] = "GET";
+    reqDoc["path"] = "/api/sensors";
+    uint8_t request[128];
+    size_t reqLen = codec.encodeMessage(reqDoc.as<JsonVariantConst>(), request, sizeof(request));
+
+    std::string legacy;
+    Measured m = {0, 0};
+    size_t checksum = 0;
+    auto t0 = clock::now();
+    for (int i = 0; i < rounds; i++) {
+        JsonDocument out;
+        size_t len = 0;
+        if (mode == 0) {
+            JsonDocument in;
+            TunnelCodec::decode(request, reqLen, false, in);
+            m.bytes = encodeLegacy(in["id"], body, legacy);
+            deserializeJson(out, legacy);
+        } else {
+            // parse() works in place, on a fresh copy as the WebSocket library provides
+            uint8_t payload[128];
+            memcpy(payload, request, reqLen);
+            TunnelMessage in;
+            TunnelCodec::parse(payload, reqLen, mode == 2, in);
+            m.bytes = codec.encodeResponse(makeResponse(in.id, body), frame, sizeof(frame));
+            TunnelCodec::decode(frame, m.bytes, mode == 2, out);
+        }
+        TunnelCodec::body(out.as<JsonVariantConst>(), len);
+        checksum += len;
+    }
+    m.us = std::chrono::duration<double, std::micro>(clock::now() - t0).count() / rounds;
+    TEST_ASSERT_EQUAL(body.size() * rounds, checksum);
+    return m;
+}
+
+void test_benchmark_wire_bytes_and_time(void) {
+    const int rounds = 20000;
+    const char* names[] = {"sensors", "agent card"};
+    std::string bodies[] = {sensorsBody(), cardBody()};
+
+    for (int b = 0; b < 2; b++) {
+        Measured legacy = roundTrip(0, bodies[b], rounds);
+        Measured json = roundTrip(1, bodies[b], rounds);
+        Measured msgpack = roundTrip(2, bodies[b], rounds);
+
+        char msg[220];
+        snprintf(msg, sizeof(msg),
+                 "%s (%u-byte body) | legacy JSON: %u B, %.2f us | JSON: %u B, %.2f us | "
+                 "MessagePack: %u B, %.2f us per round trip",
+                 names[b], (unsigned)bodies[b].size(), (unsigned)legacy.bytes, legacy.us,
+                 (unsigned)json.bytes, json.us, (unsigned)msgpack.bytes, msgpack.us);
+        TEST_MESSAGE(msg);
+
+        // The JSON framing is unchanged on the wire
+        TEST_ASSERT_EQUAL(legacy.bytes, json.bytes);
+        // Raw body plus a compact envelope: smaller than the escaped body alone
+        TEST_ASSERT_TRUE(msgpack.bytes < legacy.bytes);
+        TEST_ASSERT_TRUE(msgpack.bytes < bodies[b].size() + 96);
+        TEST_ASSERT_TRUE(msgpack.us < legacy.us);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_negotiation_defaults_to_json);
+    RUN_TEST(test_json_envelope_escapes_body);
+    RUN_TEST(test_msgpack_envelope_carries_raw_body);
+    RUN_TEST(test_decodes_requests_in_either_framing);
+    RUN_TEST(test_parse_json_in_place);
+    RUN_TEST(test_parse_msgpack_in_place);
+    RUN_TEST(test_parse_rejects_malformed_frames);
+    RUN_TEST(test_frame_overflow_returns_zero);
+    RUN_TEST(test_benchmark_wire_bytes_and_time);
+    return UNITY_END();
+}
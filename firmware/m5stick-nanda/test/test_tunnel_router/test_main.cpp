@@ -0,0 +1,529 @@
+/**
+ * Host tests and allocation benchmark for tunnel request routing.
+ *
+ * The benchmark relays the same requests through a replica of the old
+ * webSocketEvent()/processTunnelRequest() path (payload copied into a
+ * String, a parsed JsonDocument, four field Strings, path substrings, the
+ * handler's output String and a serialized envelope String) and through
+ * TunnelCodec::parse() + TunnelRouter over a ScratchAllocator, counting
+ * heap allocations per request. std::string stands in for Arduino String;
+ * both keep short strings inline, so "before" if anything undercounts.
+ *
+ *   pio test -e native -f test_tunnel_router
+ */
+
+#include <unity.h>
+
+#include <stdlib.h>
+#include <string>
+
+#include <AgentCard.h>
+#include <ScratchAllocator.h>
+#include <RouteTable.h>
+#include <TunnelCodec.h>
+#include <TunnelRouter.h>
+
+#include "../support/CountingAllocator.h"
+#include "../support/CountingNew.h"
+
+static std::string lastDisplayed;
+
+static bool skillSensors(JsonVariantConst params, JsonObject out) {
+    JsonObject accel = out["accelerometer"].to<JsonObject>();
+    accel["x"] = 0.0123f;
+    accel["y"] = -0.0456f;
+    accel["z"] = 0.9981f;
+    JsonObject gyro = out["gyroscope"].to<JsonObject>();
+    gyro["x"] = 1.25f;
+    gyro["y"] = -0.61f;
+    gyro["z"] = 0.07f;
+    out["temperature"] = 31.4f;
+    out["timestamp"] = 123456789;
+    return true;
+}
+
+static bool skillButtons(JsonVariantConst params, JsonObject out) {
+    out["btnA"] = false;
+    out["btnB"] = true;
+    out["btnPwr"] = false;
+    return true;
+}
+
+static bool skillBattery(JsonVariantConst params, JsonObject out) {
+    out["voltage"] = 4.02f;
+    out["percent"] = 87;
+    out["isCharging"] = false;
+    return true;
+}
+
+static bool skillBuzzer(JsonVariantConst params, JsonObject out) {
+    out["success"] = true;
+    out["frequency"] = params["frequency"] | (params["freq"] | 1000);
+    out["duration"] = params["duration"] | 100;
+    return true;
+}
+
+static bool skillDisplay(JsonVariantConst params, JsonObject out) {
+    const char* text = params["text"];
+    if (!text) return false;
+    lastDisplayed = text;
+    out["success"] = true;
+    out["displayed"] = text;
+    return true;
+}
+
+static const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", skillSensors},
+    {"display/show", "Show on Display", "Display text on LCD", skillDisplay},
+    {"button/status", "Button Status", "Get current button states", skillButtons},
+    {"buzzer/tone", "Play Tone", "Play a tone on the buzzer", skillBuzzer},
+    {"battery/status", "Battery Status", "Get battery voltage and percentage", skillBattery}
+};
+
+// Stands in for a screenshot: 300 bytes that are not valid UTF-8
+static int writeImage(uint8_t* out, size_t room, size_t& len) {
+    if (room < 300) return 413;
+    for (len = 0; len < 300; len++) out[len] = (uint8_t)(0x80 + len);
+    return 200;
+}
+
+static int writeUnavailable(uint8_t* out, size_t room, size_t& len) {
+    return 503;
+}
+
+static const char PAGE[] = "<!DOCTYPE html><html><body>Hi</body></html>";
+static char bigPage[5000];
+
+constexpr RouteQuery DISPLAY_QUERY[] = {
+    {"text", "text", false, 0}
+};
+constexpr RouteQuery BUZZER_QUERY[] = {
+    {"freq", "frequency", true, 1000},
+    {"duration", "duration", true, 100}
+};
+
+// As the firmware's, with stand-in bodies
+constexpr RouteDef ROUTES[] = {
+    routeCard("/.well-known/agent.json"),
+    routeRpc("/a2a"),
+    routeRpc("/rpc"),
+    routeSkill("/api/sensors", "sensors/read"),
+    routeSkill("/api/buttons", "button/status"),
+    routeSkill("/api/battery", "battery/status"),
+    routeSkill("/api/display", "display/show", DISPLAY_QUERY),
+    routeSkill("/api/buzzer", "buzzer/tone", BUZZER_QUERY),
+    routeRaw("/api/screen.png", "image/png", writeImage, nullptr, true),
+    routeRaw("/api/screen.qoi", "image/qoi", writeUnavailable, nullptr, false),
+    routePage("/", "text/html", PAGE),
+    routePage("/big", "text/html", bigPage)
+};
+constexpr RouteMatcher<ROUTE_COUNT(ROUTES)> routes(ROUTES);
+static_assert(routes.valid(), "Route paths must be unique");
+
+static AgentCard card;
+static uint8_t scratch[16384];
+static uint8_t frame[TUNNEL_FRAME_MAX];
+static uint8_t payload[1024];
+
+static void loadCard() {
+    AgentCardInfo info;
+    info.name = "M5Stick a1b2c3";
+    info.handle = "m5stick-a1b2c3";
+    info.deviceId = "a1b2c3d4e5f6";
+    info.description = "M5StickC Plus 2 IoT device with sensors, display, IR, and controls";
+    info.url = "http://m5stick-a1b2c3.local";
+    info.version = "1.0.0";
+    info.skills = SKILLS;
+    info.skillCount = SKILL_COUNT(SKILLS);
+    card.update(info);
+}
+
+// Relay one JSON request through the router and decode the response frame
+static int relay(TunnelRouter& router, const std::string& request, JsonDocument& response) {
+    memcpy(payload, request.data(), request.size());
+    TunnelMessage msg;
+    TEST_ASSERT_TRUE(TunnelCodec::parse(payload, request.size(), false, msg));
+    TunnelCodec codec;
+    size_t len = router.handle(msg, codec, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, false, response));
+    TEST_ASSERT_EQUAL_STRING(msg.id, response["id"]);
+    size_t bodyLen;
+    const char* body = TunnelCodec::body(response.as<JsonVariantConst>(), bodyLen);
+    std::string copy(body, bodyLen);
+    int status = response["status"];
+    response.clear();
+    if (bodyLen) TEST_ASSERT_FALSE(deserializeJson(response, copy));
+    return status;
+}
+
+static std::string get(const char* path, const char* extra = "") {
+    return std::string("{\"type\":\"request\",\"id\":\"r1\",\"method\":\"GET\",\"path\":\"") + path + "\"" + extra + "}";
+}
+
+void setUp(void) {
+    lastDisplayed.clear();
+}
+
+void tearDown(void) {}
+
+void test_query_params(void) {
+    char v[16];
+    TEST_ASSERT_TRUE(TunnelRouter::queryParam("/api/buzzer?freq=440&duration=50", "duration", v, sizeof(v)));
+    TEST_ASSERT_EQUAL_STRING("50", v);
+    TEST_ASSERT_TRUE(TunnelRouter::queryParam("/x?a=1&text=Hi%20there+you%2", "text", v, sizeof(v)));
+    TEST_ASSERT_EQUAL_STRING("Hi there you%2", v);
+    TEST_ASSERT_FALSE(TunnelRouter::queryParam("/x?xtext=1", "text", v, sizeof(v)));
+    TEST_ASSERT_FALSE(TunnelRouter::queryParam("/x?text", "text", v, sizeof(v)));
+    TEST_ASSERT_FALSE(TunnelRouter::queryParam("/x", "text", v, sizeof(v)));
+    TEST_ASSERT_TRUE(TunnelRouter::queryParam("/x?text=", "text", v, sizeof(v)));
+    TEST_ASSERT_EQUAL_STRING("", v);
+    // Truncated to the buffer
+    TEST_ASSERT_TRUE(TunnelRouter::queryParam("/x?text=abcdefghijklmnopqrstuvwxyz", "text", v, sizeof(v)));
+    TEST_ASSERT_EQUAL(15, (int)strlen(v));
+}
+
+void test_routes(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    JsonDocument r;
+
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/sensors?verbose=1"), r));
+    TEST_ASSERT_EQUAL_FLOAT(31.4f, r["temperature"].as<float>());
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/buttons"), r));
+    TEST_ASSERT_TRUE(r["btnB"].as<bool>());
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/battery"), r));
+    TEST_ASSERT_EQUAL(87, r["percent"].as<int>());
+
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/buzzer?freq=440&duration=50"), r));
+    TEST_ASSERT_EQUAL(440, r["frequency"].as<int>());
+    TEST_ASSERT_EQUAL(50, r["duration"].as<int>());
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/buzzer"), r));
+    TEST_ASSERT_EQUAL(1000, r["frequency"].as<int>());
+
+    TEST_ASSERT_EQUAL(200, relay(router, get("/api/display?text=Hello%2C+world%21"), r));
+    TEST_ASSERT_EQUAL_STRING("Hello, world!", lastDisplayed.c_str());
+
+    // Both transports: a skill that rejects its params is a 400
+    TEST_ASSERT_EQUAL(400, relay(router, get("/api/display"), r));
+    TEST_ASSERT_EQUAL(404, relay(router, get("/api/sensorsX"), r));
+    TEST_ASSERT_EQUAL_STRING("/api/sensorsX", r["path"]);
+    TEST_ASSERT_EQUAL(404, relay(router, get("/api/sensor"), r));
+    arena.reset();
+}
+
+void test_methods(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    JsonDocument r;
+
+    std::string post = "{\"type\":\"request\",\"id\":\"r1\",\"method\":\"POST\",\"path\":\"/api/sensors\"}";
+    TEST_ASSERT_EQUAL(405, relay(router, post, r));
+    TEST_ASSERT_EQUAL(405, relay(router, get("/rpc"), r));
+    // Relays that send no method get the route
+    std::string bare = "{\"type\":\"request\",\"id\":\"r1\",\"path\":\"/api/battery\"}";
+    TEST_ASSERT_EQUAL(200, relay(router, bare, r));
+    arena.reset();
+}
+
+void test_pages(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    TunnelCodec codec;
+    TunnelMessage msg;
+    JsonDocument r;
+
+    // Text, so either encoding carries it
+    for (int binary = 0; binary < 2; binary++) {
+        if (binary) codec.negotiate("msgpack");
+        std::string req = get("/?lang=en");
+        memcpy(payload, req.data(), req.size());
+        TunnelCodec::parse(payload, req.size(), false, msg);
+        size_t len = router.handle(msg, codec, frame, sizeof(frame));
+        TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, binary, r));
+        TEST_ASSERT_EQUAL(200, r["status"].as<int>());
+        TEST_ASSERT_EQUAL_STRING("text/html", r["headers"]["Content-Type"]);
+        size_t bodyLen;
+        const char* body = TunnelCodec::body(r.as<JsonVariantConst>(), bodyLen);
+        TEST_ASSERT_EQUAL(strlen(PAGE), bodyLen);
+        TEST_ASSERT_EQUAL(0, memcmp(PAGE, body, bodyLen));
+    }
+
+    // Larger than a frame
+    std::string req = get("/big");
+    memcpy(payload, req.data(), req.size());
+    TunnelCodec::parse(payload, req.size(), false, msg);
+    size_t len = router.handle(msg, codec, frame, sizeof(frame));
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_EQUAL(413, r["status"].as<int>());
+}
+
+void test_agent_card_and_revalidation(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    AgentCard empty;
+    TunnelRouter notReady(routes, SKILLS, SKILL_COUNT(SKILLS), empty, &arena);
+    JsonDocument r;
+    TEST_ASSERT_EQUAL(503, relay(notReady, get("/.well-known/agent.json"), r));
+
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    TEST_ASSERT_EQUAL(200, relay(router, get("/.well-known/agent.json"), r));
+    TEST_ASSERT_EQUAL_STRING("m5stick-a1b2c3", r["handle"]);
+
+    std::string etag = card.etag();
+    std::string escaped = "\\\"" + etag.substr(1, etag.size() - 2) + "\\\"";
+    std::string conditional = get("/.well-known/agent.json", (",\"headers\":{\"If-None-Match\":\"" + escaped + "\"}").c_str());
+    TEST_ASSERT_EQUAL(304, relay(router, conditional, r));
+    TEST_ASSERT_TRUE(r.isNull());
+}
+
+void test_json_rpc_over_tunnel(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    JsonDocument r;
+
+    std::string call = "{\"type\":\"request\",\"id\":\"r1\",\"method\":\"POST\",\"path\":\"/a2a\","
+                       "\"body\":\"{\\\"jsonrpc\\\":\\\"2.0\\\",\\\"id\\\":5,\\\"method\\\":\\\"battery/status\\\"}\"}";
+    TEST_ASSERT_EQUAL(200, relay(router, call, r));
+    TEST_ASSERT_EQUAL(5, r["id"].as<int>());
+    TEST_ASSERT_EQUAL(87, r["result"]["percent"].as<int>());
+
+    std::string notification = "{\"type\":\"request\",\"id\":\"r1\",\"method\":\"POST\",\"path\":\"/rpc\","
+                               "\"body\":\"{\\\"jsonrpc\\\":\\\"2.0\\\",\\\"method\\\":\\\"battery/status\\\"}\"}";
+    TEST_ASSERT_EQUAL(204, relay(router, notification, r));
+}
+
+void test_msgpack_response_and_oversize(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    TunnelCodec codec;
+    codec.negotiate("msgpack");
+
+    std::string req = get("/api/sensors");
+    memcpy(payload, req.data(), req.size());
+    TunnelMessage msg;
+    TunnelCodec::parse(payload, req.size(), false, msg);
+    size_t len = router.handle(msg, codec, frame, sizeof(frame));
+    JsonDocument r;
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_TRUE(r["body"].is<MsgPackBinary>());
+    TEST_ASSERT_EQUAL(200, r["status"].as<int>());
+
+    // A card larger than the frame becomes a 500, which still fits
+    req = get("/.well-known/agent.json");
+    memcpy(payload, req.data(), req.size());
+    TunnelCodec::parse(payload, req.size(), false, msg);
+    len = router.handle(msg, codec, frame, 300);
+    TEST_ASSERT_TRUE(len > 0);
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_EQUAL(500, r["status"].as<int>());
+    TEST_ASSERT_EQUAL(0, (int)router.handle(msg, codec, frame, 40));
+}
+
+void test_raw_routes(void) {
+    ScratchAllocator arena(scratch, sizeof(scratch));
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    TunnelCodec codec;
+    codec.negotiate("msgpack");
+    TunnelMessage msg;
+    JsonDocument r;
+
+    std::string req = get("/api/screen.png?t=1");
+    memcpy(payload, req.data(), req.size());
+    TunnelCodec::parse(payload, req.size(), false, msg);
+    TEST_ASSERT_TRUE(router.slow(msg));
+    size_t len = router.handle(msg, codec, frame, sizeof(frame));
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_EQUAL(200, r["status"].as<int>());
+    TEST_ASSERT_EQUAL_STRING("image/png", r["headers"]["Content-Type"]);
+    size_t bodyLen;
+    const uint8_t* body = (const uint8_t*)TunnelCodec::body(r.as<JsonVariantConst>(), bodyLen);
+    TEST_ASSERT_EQUAL(300, (int)bodyLen);
+    TEST_ASSERT_EQUAL(0x80, body[0]);
+    TEST_ASSERT_EQUAL(0x80 + 299 - 256, body[299]);
+
+    // Too big for the frame, or not available: JSON errors
+    len = router.handle(msg, codec, frame, 200);
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_EQUAL(413, r["status"].as<int>());
+    req = get("/api/screen.qoi");
+    memcpy(payload, req.data(), req.size());
+    TunnelCodec::parse(payload, req.size(), false, msg);
+    TEST_ASSERT_FALSE(router.slow(msg));
+    len = router.handle(msg, codec, frame, sizeof(frame));
+    TEST_ASSERT_FALSE(TunnelCodec::decode(frame, len, true, r));
+    TEST_ASSERT_EQUAL(503, r["status"].as<int>());
+
+    // A JSON tunnel cannot carry the bytes
+    TEST_ASSERT_EQUAL(406, relay(router, get("/api/screen.png"), r));
+}
+
+void test_scratch_allocator(void) {
+    CountingAllocator parent;
+    uint8_t storage[256];
+    ScratchAllocator arena(storage, sizeof(storage), &parent);
+
+    void* a = arena.allocate(40);
+    void* b = arena.allocate(40);
+    TEST_ASSERT_TRUE((uintptr_t)a % 8 == 0 && (uintptr_t)b % 8 == 0);
+    size_t used = arena.used();
+    // The newest block grows and shrinks in place
+    TEST_ASSERT_TRUE(b == arena.reallocate(b, 100));
+    TEST_ASSERT_TRUE(b == arena.reallocate(b, 10));
+    TEST_ASSERT_TRUE(arena.used() < used);
+    // An older block moves, keeping its contents
+    memset(a, 0x5a, 40);
+    void* moved = arena.reallocate(a, 60);
+    TEST_ASSERT_TRUE(moved != a);
+    TEST_ASSERT_EQUAL(0x5a, ((uint8_t*)moved)[39]);
+
+    // Past the end, the parent takes over
+    void* big = arena.allocate(1000);
+    TEST_ASSERT_NOT_NULL(big);
+    TEST_ASSERT_EQUAL(1, (int)arena.fallbacks());
+    TEST_ASSERT_EQUAL(1, (int)parent.allocations);
+    arena.deallocate(big);
+    TEST_ASSERT_EQUAL(0, (int)parent.current);
+
+    arena.reset();
+    TEST_ASSERT_EQUAL(0, (int)arena.used());
+    TEST_ASSERT_TRUE(a == arena.allocate(8));
+}
+
+// ---------------------------------------------------------------------------
+// Benchmark
+// ---------------------------------------------------------------------------
+
+// The handler chain as it was: everything through Strings
+static std::string legacyRunSkill(const SkillDef* skill, JsonVariantConst params, ArduinoJson::Allocator* a) {
+    JsonDocument doc(a);
+    skill->handler(params, doc.to<JsonObject>());
+    std::string output;
+    serializeJson(doc, output);
+    return output;
+}
+
+static std::string legacyProcess(const std::string& method, const std::string& path, const std::string& body,
+                                 ArduinoJson::Allocator* a) {
+    (void)method;
+    if (path == "/api/sensors") return legacyRunSkill(&SKILLS[0], JsonVariantConst(), a);
+    if (path.compare(0, 11, "/api/buzzer") == 0) {
+        int freq = 1000, duration = 100;
+        size_t q = path.find('?');
+        if (q != std::string::npos) {
+            std::string query = path.substr(q + 1);
+            size_t f = query.find("freq=");
+            if (f != std::string::npos) freq = atoi(query.substr(f + 5).c_str());
+            size_t d = query.find("duration=");
+            if (d != std::string::npos) duration = atoi(query.substr(d + 9).c_str());
+        }
+        JsonDocument params(a);
+        params["frequency"] = freq;
+        params["duration"] = duration;
+        return legacyRunSkill(&SKILLS[3], params.as<JsonVariantConst>(), a);
+    }
+    if (path == "/a2a") {
+        JsonDocument reply(a);
+        std::string output;
+        JsonRpcDispatcher rpc(SKILLS, SKILL_COUNT(SKILLS), a);
+        if (rpc.dispatch(body.c_str(), body.size(), reply)) serializeJson(reply, output);
+        return output;
+    }
+    return std::string();
+}
+
+static size_t legacyRelay(const uint8_t* data, size_t length, CountingAllocator& a) {
+    std::string msg((const char*)data, length);
+    JsonDocument doc(&a);
+    deserializeJson(doc, msg);
+    std::string reqId = doc["id"] | "";
+    std::string method = doc["method"] | "GET";
+    std::string path = doc["path"] | "/";
+    std::string body = doc["body"] | "";
+
+    JsonDocument respDoc(&a);
+    respDoc["type"] = "response";
+    respDoc["id"] = reqId;
+    respDoc["headers"]["Content-Type"] = "application/json";
+    if (path == "/.well-known/agent.json") {
+        respDoc["headers"]["ETag"] = JsonString(card.etag(), true);
+        respDoc["status"] = 200;
+        respDoc["body"] = JsonString(card.json(), card.length(), true);
+    } else {
+        std::string response = legacyProcess(method, path, body, &a);
+        respDoc["status"] = 200;
+        respDoc["body"] = response;
+    }
+    std::string respStr;
+    serializeJson(respDoc, respStr);
+    return respStr.size();
+}
+
+void test_benchmark_allocations_per_request(void) {
+    const char* names[] = {"sensors", "buzzer", "agent card", "a2a"};
+    const std::string requests[] = {
+        get("/api/sensors"),
+        get("/api/buzzer?freq=880&duration=200"),
+        get("/.well-known/agent.json"),
+        "{\"type\":\"request\",\"id\":\"5f1c2a\",\"method\":\"POST\",\"path\":\"/a2a\",\"body\":"
+        "\"{\\\"jsonrpc\\\":\\\"2.0\\\",\\\"id\\\":1,\\\"method\\\":\\\"message/send\\\",\\\"params\\\":"
+        "{\\\"message\\\":{\\\"parts\\\":[{\\\"kind\\\":\\\"text\\\",\\\"text\\\":\\\"sensors read\\\"}]}}}\"}"
+    };
+    const int rounds = 1000;
+
+    CountingAllocator parent;
+    ScratchAllocator arena(scratch, sizeof(scratch), &parent);
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card, &arena);
+    TunnelCodec codec;
+
+    for (int k = 0; k < 4; k++) {
+        CountingAllocator before;
+        size_t newsBefore = heapAllocs;
+        size_t sendCopies = 0;
+        for (int i = 0; i < rounds; i++) {
+            memcpy(payload, requests[k].data(), requests[k].size());
+            size_t sent = legacyRelay(payload, requests[k].size(), before);
+            // sendTXT() without header room copies frames under 1400 bytes into a malloc'd buffer
+            if (sent < 1400) sendCopies++;
+        }
+        double beforeAllocs =
+            (double)(before.allocations + before.reallocations + heapAllocs - newsBefore + sendCopies) / rounds;
+
+        parent.resetCounters();
+        size_t newsAfter = heapAllocs;
+        for (int i = 0; i < rounds; i++) {
+            memcpy(payload, requests[k].data(), requests[k].size());
+            TunnelMessage msg;
+            TunnelCodec::parse(payload, requests[k].size(), false, msg);
+            TEST_ASSERT_TRUE(router.handle(msg, codec, frame, sizeof(frame)) > 0);
+            arena.reset();
+        }
+        double afterAllocs = (double)(parent.allocations + parent.reallocations + heapAllocs - newsAfter) / rounds;
+
+        char msg[160];
+        snprintf(msg, sizeof(msg), "%-10s | before: %.1f heap allocs/request | after: %.1f (scratch peak %u B)",
+                 names[k], beforeAllocs, afterAllocs, (unsigned)arena.peak());
+        TEST_MESSAGE(msg);
+
+        TEST_ASSERT_TRUE(beforeAllocs >= 2.0);
+        TEST_ASSERT_EQUAL(0, (int)(parent.allocations + parent.reallocations));
+        TEST_ASSERT_EQUAL(0, (int)(heapAllocs - newsAfter));
+    }
+    TEST_ASSERT_EQUAL(0, (int)arena.fallbacks());
+}
+
+int main(int argc, char** argv) {
+    memset(bigPage, 'x', sizeof(bigPage) - 1);
+    loadCard();
+    UNITY_BEGIN();
+    RUN_TEST(test_query_params);
+    RUN_TEST(test_routes);
+    RUN_TEST(test_methods);
+    RUN_TEST(test_pages);
+    RUN_TEST(test_agent_card_and_revalidation);
+    RUN_TEST(test_json_rpc_over_tunnel);
+    RUN_TEST(test_msgpack_response_and_oversize);
+    RUN_TEST(test_raw_routes);
+    RUN_TEST(test_scratch_allocator);
+    RUN_TEST(test_benchmark_allocations_per_request);
+    return UNITY_END();
+}
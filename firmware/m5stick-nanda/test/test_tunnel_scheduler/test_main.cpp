@@ -0,0 +1,375 @@
+/**
+ * Host tests and relay latency load test for the tunnel request scheduler.
+ *
+ * The load test replays a stream of mixed requests (mostly sensor reads,
+ * every 16th a wifi/scan that blocks like the real radio scan) arriving
+ * every 3 ms, first the old way, each answered inline in arrival order,
+ * then through TunnelScheduler with a worker thread running the slow ones.
+ * Latency is measured from a request's arrival to its response being
+ * sent. The slow skill sleeps 40 ms instead of the device's seconds so the
+ * test stays short; the ratio to the arrival rate is what matters.
+ *
+ *   pio test -e native -f test_tunnel_scheduler
+ */
+
+#include <unity.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+#include <vector>
+
+#include <AgentCard.h>
+#include <RouteTable.h>
+#include <TunnelCodec.h>
+#include <TunnelRouter.h>
+#include <TunnelScheduler.h>
+
+typedef std::chrono::steady_clock Clock;
+
+#define SLOW_MS 40
+
+static std::atomic<int> slowRuns(0);
+static bool sleepInSlow = false;
+
+static bool skillSensors(JsonVariantConst params, JsonObject out) {
+    out["temperature"] = 31.4f;
+    out["timestamp"] = 123456789;
+    return true;
+}
+
+// Draws on the device, so it stays on the task that owns the display
+static bool skillDisplay(JsonVariantConst params, JsonObject out) {
+    const char* text = params["text"];
+    if (!text) return false;
+    out["success"] = true;
+    out["displayed"] = text;
+    return true;
+}
+
+static bool skillScan(JsonVariantConst params, JsonObject out) {
+    if (sleepInSlow) std::this_thread::sleep_for(std::chrono::milliseconds(SLOW_MS));
+    slowRuns++;
+    out["count"] = 0;
+    return true;
+}
+
+static const SkillDef SKILLS[] = {
+    {"sensors/read", "Read Sensors", "Read accelerometer, gyroscope, and temperature", skillSensors},
+    {"display/show", "Show on Display", "Display text on LCD", skillDisplay},
+    {"wifi/scan", "Scan WiFi", "Scan for nearby WiFi networks", skillScan, true}
+};
+
+constexpr RouteQuery DISPLAY_QUERY[] = {
+    {"text", "text", false, 0}
+};
+
+constexpr RouteDef ROUTES[] = {
+    routeCard("/.well-known/agent.json"),
+    routeRpc("/a2a"),
+    routeRpc("/rpc"),
+    routeSkill("/api/sensors", "sensors/read"),
+    routeSkill("/api/display", "display/show", DISPLAY_QUERY),
+    routeSkill("/api/wifi/scan", "wifi/scan")
+};
+constexpr RouteMatcher<ROUTE_COUNT(ROUTES)> routes(ROUTES);
+static_assert(routes.valid(), "Route paths must be unique");
+
+static AgentCard card;
+static uint8_t frame[TUNNEL_FRAME_MAX];
+static uint8_t jobFrame[TUNNEL_FRAME_MAX];
+
+static TunnelMessage request(const char* id, const char* path, const char* body = "") {
+    TunnelMessage msg = {"request", id, "GET", path, "", "", nullptr, body, strlen(body)};
+    if (body[0]) msg.method = "POST";
+    return msg;
+}
+
+// Status of a response frame; its id is copied to id
+static int decodeStatus(const uint8_t* data, size_t len, bool binary, char* id, size_t idSize,
+                        JsonDocument* envelope = nullptr) {
+    JsonDocument doc;
+    TEST_ASSERT_FALSE(TunnelCodec::decode(data, len, binary, doc));
+    snprintf(id, idSize, "%s", doc["id"].as<const char*>());
+    if (envelope) *envelope = doc;
+    return doc["status"];
+}
+
+void setUp(void) {
+    slowRuns = 0;
+    sleepInSlow = false;
+}
+
+void tearDown(void) {}
+
+void test_slow_classification(void) {
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+
+    TEST_ASSERT_FALSE(router.slow(request("1", "/api/sensors")));
+    TEST_ASSERT_TRUE(router.slow(request("2", "/api/wifi/scan")));
+    TEST_ASSERT_FALSE(router.slow(request("2", "/api/display?text=hi")));
+    TEST_ASSERT_FALSE(router.slow(request("3", "/.well-known/agent.json")));
+    TEST_ASSERT_FALSE(router.slow(request("4", "/nope")));
+
+    TEST_ASSERT_TRUE(router.slow(request("5", "/rpc", "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"wifi/scan\"}")));
+    TEST_ASSERT_FALSE(router.slow(request("6", "/rpc", "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"sensors/read\"}")));
+    TEST_ASSERT_TRUE(router.slow(request("7", "/a2a",
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"message/send\",\"params\":"
+        "{\"message\":{\"parts\":[{\"kind\":\"text\",\"text\":\"wifi scan\"}]}}}")));
+    TEST_ASSERT_FALSE(router.slow(request("7", "/a2a",
+        "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"message/send\",\"params\":"
+        "{\"message\":{\"parts\":[{\"kind\":\"text\",\"text\":\"display show\"}]}}}")));
+    // One slow request makes the whole batch slow
+    TEST_ASSERT_TRUE(router.slow(request("8", "/rpc",
+        "[{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"sensors/read\"},"
+        "{\"jsonrpc\":\"2.0\",\"id\":2,\"method\":\"wifi/scan\"}]")));
+    // Malformed bodies are answered inline with a parse error
+    TEST_ASSERT_FALSE(router.slow(request("9", "/rpc", "{\"jsonrpc\"")));
+}
+
+void test_queue_out_of_order_and_backpressure(void) {
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    TunnelScheduler scheduler(router, jobFrame, sizeof(jobFrame));
+    TunnelCodec codec;
+    char id[16];
+
+    const char* ids[] = {"s1", "s2", "s3", "s4"};
+    for (int i = 0; i < TUNNEL_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_EQUAL(TUNNEL_QUEUED, scheduler.enqueue(request(ids[i], "/api/wifi/scan"), TUNNEL_JSON));
+    }
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUE_DEPTH, (int)scheduler.pending());
+    // A retry of a queued id is not queued again, even with the queue full
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUED, scheduler.enqueue(request("s2", "/api/wifi/scan"), TUNNEL_JSON));
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUE_DEPTH, (int)scheduler.pending());
+
+    TunnelMessage extra = request("s5", "/api/wifi/scan");
+    TunnelAdmission why = scheduler.enqueue(extra, TUNNEL_JSON);
+    TEST_ASSERT_EQUAL(TUNNEL_BUSY, why);
+    TEST_ASSERT_EQUAL(1, (int)scheduler.rejected());
+    JsonDocument envelope;
+    size_t len = TunnelScheduler::reject(why, extra, codec, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(503, decodeStatus(frame, len, false, id, sizeof(id), &envelope));
+    TEST_ASSERT_EQUAL_STRING("s5", id);
+    TEST_ASSERT_EQUAL_STRING("2", envelope["headers"]["Retry-After"]);
+
+    // A fast request meanwhile is answered inline by its own router
+    TunnelRouter inline_(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    len = inline_.handle(request("f1", "/api/sensors"), codec, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(200, decodeStatus(frame, len, false, id, sizeof(id)));
+    TEST_ASSERT_EQUAL_STRING("f1", id);
+    TEST_ASSERT_EQUAL(0, slowRuns.load());
+
+    // Jobs finish one result at a time, each under its own id
+    TEST_ASSERT_TRUE(scheduler.runNext());
+    TEST_ASSERT_FALSE(scheduler.runNext());   // s1 not sent yet
+    TEST_ASSERT_TRUE(scheduler.ready() > 0);
+    TEST_ASSERT_EQUAL(200, decodeStatus(jobFrame, scheduler.ready(), false, id, sizeof(id)));
+    TEST_ASSERT_EQUAL_STRING("s1", id);
+    scheduler.release();
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUE_DEPTH - 1, (int)scheduler.pending());
+
+    // The freed slot takes a new request
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUED, scheduler.enqueue(request("s5", "/api/wifi/scan"), TUNNEL_JSON));
+    for (int i = 1; i <= TUNNEL_QUEUE_DEPTH; i++) {
+        TEST_ASSERT_TRUE(scheduler.runNext());
+        decodeStatus(jobFrame, scheduler.ready(), false, id, sizeof(id));
+        char expected[4];
+        snprintf(expected, sizeof(expected), "s%d", i + 1);
+        TEST_ASSERT_EQUAL_STRING(expected, id);
+        scheduler.release();
+    }
+    TEST_ASSERT_FALSE(scheduler.runNext());
+    TEST_ASSERT_EQUAL(0, (int)scheduler.pending());
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUE_DEPTH + 1, slowRuns.load());
+}
+
+void test_job_copies_request(void) {
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    TunnelScheduler scheduler(router, jobFrame, sizeof(jobFrame));
+    char id[16];
+
+    // The queued copy must not depend on the frame it was parsed from
+    char body[] = "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"wifi/scan\",\"params\":{\"note\":\"queued\"}}";
+    char path[] = "/rpc";
+    char reqId[] = "m1";
+    TEST_ASSERT_EQUAL(TUNNEL_QUEUED, scheduler.enqueue(request(reqId, path, body), TUNNEL_MSGPACK));
+    memset(body, 'x', sizeof(body) - 1);
+    memset(path, 'x', sizeof(path) - 1);
+    memset(reqId, 'x', sizeof(reqId) - 1);
+
+    TEST_ASSERT_TRUE(scheduler.runNext());
+    TEST_ASSERT_TRUE(scheduler.binary());
+    JsonDocument envelope;
+    TEST_ASSERT_EQUAL(200, decodeStatus(jobFrame, scheduler.ready(), true, id, sizeof(id), &envelope));
+    TEST_ASSERT_EQUAL_STRING("m1", id);
+    size_t bodyLen;
+    const char* out = TunnelCodec::body(envelope.as<JsonVariantConst>(), bodyLen);
+    JsonDocument reply;
+    TEST_ASSERT_FALSE(deserializeJson(reply, out, bodyLen));
+    TEST_ASSERT_EQUAL(7, reply["id"].as<int>());
+    TEST_ASSERT_EQUAL(0, reply["result"]["count"].as<int>());
+    scheduler.release();
+
+    // Bodies that do not fit a slot are turned away with 413
+    std::vector<char> big(TUNNEL_JOB_BYTES + 1, ' ');
+    big.back() = '\0';
+    TunnelMessage large = request("m2", "/rpc", big.data());
+    TunnelAdmission why = scheduler.enqueue(large, TUNNEL_JSON);
+    TEST_ASSERT_EQUAL(TUNNEL_TOO_LARGE, why);
+    TEST_ASSERT_EQUAL(0, (int)scheduler.pending());
+    TunnelCodec codec;
+    size_t len = TunnelScheduler::reject(why, large, codec, frame, sizeof(frame));
+    TEST_ASSERT_EQUAL(413, decodeStatus(frame, len, false, id, sizeof(id), &envelope));
+    TEST_ASSERT_TRUE(envelope["headers"]["Retry-After"].isNull());
+}
+
+// A response that does not fit the frame still answers the job, down to
+// a frame that holds only a bare 500
+void test_job_answered_when_response_does_not_fit(void) {
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    TunnelCodec codec;
+    TunnelResponse bare = {"big", 500, nullptr, nullptr, "", 0, 0};
+    size_t smallest = codec.encodeResponse(bare, frame, sizeof(frame));
+    TEST_ASSERT_TRUE(smallest > 0);
+
+    char id[16];
+    bool sawFailure = false;
+    for (size_t capacity = smallest + 1; capacity <= 200; capacity++) {   // + the NUL
+        TunnelScheduler scheduler(router, jobFrame, capacity);
+        TEST_ASSERT_EQUAL(TUNNEL_QUEUED, scheduler.enqueue(request("big", "/api/wifi/scan"), TUNNEL_JSON));
+        TEST_ASSERT_TRUE(scheduler.runNext());
+        TEST_ASSERT_TRUE(scheduler.ready() > 0);
+        int status = decodeStatus(jobFrame, scheduler.ready(), false, id, sizeof(id));
+        TEST_ASSERT_EQUAL_STRING("big", id);
+        if (scheduler.failed()) {
+            TEST_ASSERT_EQUAL(500, status);
+            sawFailure = true;
+        } else {
+            TEST_ASSERT_TRUE(status == 200 || status == 500);
+        }
+        scheduler.release();
+    }
+    TEST_ASSERT_TRUE(sawFailure);
+}
+
+struct LoadResult {
+    std::vector<double> fast, slow;   // Latencies in ms
+    int busy = 0;
+};
+
+static double percentile(std::vector<double> v, int p) {
+    if (v.empty()) return 0;
+    std::sort(v.begin(), v.end());
+    return v[std::min(v.size() - 1, v.size() * p / 100)];
+}
+
+static double msSince(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+static LoadResult runLoad(bool scheduled) {
+    const int count = 200;
+    const auto interval = std::chrono::milliseconds(3);
+    TunnelRouter router(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    TunnelRouter workerRouter(routes, SKILLS, SKILL_COUNT(SKILLS), card);
+    TunnelScheduler scheduler(workerRouter, jobFrame, sizeof(jobFrame));
+    TunnelCodec codec;
+
+    std::vector<Clock::time_point> arrival(count);
+    std::vector<bool> answered(count, false);
+    std::vector<char[8]> ids(count);
+    LoadResult result;
+
+    auto sent = [&](const uint8_t* data, size_t len, bool binary) {
+        char id[16];
+        int status = decodeStatus(data, len, binary, id, sizeof(id));
+        int i = atoi(id + 1);
+        TEST_ASSERT_FALSE(answered[i]);
+        answered[i] = true;
+        if (status == 503) {
+            result.busy++;
+        } else {
+            (i % 16 == 0 ? result.slow : result.fast).push_back(msSince(arrival[i]));
+        }
+    };
+    auto poll = [&]() {
+        if (size_t len = scheduler.ready()) {
+            sent(jobFrame, len, scheduler.binary());
+            scheduler.release();
+        }
+    };
+
+    std::atomic<bool> stop(false);
+    std::thread worker([&]() {
+        while (!stop) {
+            if (!scheduler.runNext()) std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    });
+
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < count; i++) {
+        arrival[i] = start + interval * i;
+        while (Clock::now() < arrival[i]) {
+            poll();
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        snprintf(ids[i], sizeof(ids[i]), "r%d", i);
+        TunnelMessage msg = request(ids[i], i % 16 == 0 ? "/api/wifi/scan" : "/api/sensors");
+
+        size_t len;
+        if (scheduled && router.slow(msg)) {
+            TunnelAdmission why = scheduler.enqueue(msg, TUNNEL_JSON);
+            if (why == TUNNEL_QUEUED) continue;
+            len = TunnelScheduler::reject(why, msg, codec, frame, sizeof(frame));
+        } else {
+            len = router.handle(msg, codec, frame, sizeof(frame));
+        }
+        sent(frame, len, false);
+    }
+    while (scheduler.pending() || scheduler.ready()) {
+        poll();
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    stop = true;
+    worker.join();
+
+    for (int i = 0; i < count; i++) TEST_ASSERT_TRUE(answered[i]);
+    return result;
+}
+
+void test_load_relay_latency(void) {
+    sleepInSlow = true;
+    LoadResult before = runLoad(false);
+    LoadResult after = runLoad(true);
+
+    const char* names[] = {"inline", "scheduled"};
+    LoadResult* results[] = {&before, &after};
+    for (int k = 0; k < 2; k++) {
+        char msg[200];
+        snprintf(msg, sizeof(msg),
+                 "%-9s | fast p50 %6.2f ms p99 %6.2f ms | slow p50 %6.2f ms p99 %6.2f ms | 503: %d",
+                 names[k], percentile(results[k]->fast, 50), percentile(results[k]->fast, 99),
+                 percentile(results[k]->slow, 50), percentile(results[k]->slow, 99), results[k]->busy);
+        TEST_MESSAGE(msg);
+    }
+
+    // Inline, fast requests queue up behind every slow one
+    TEST_ASSERT_TRUE(percentile(before.fast, 99) > SLOW_MS / 2);
+    // Scheduled, they no longer wait for the scan
+    TEST_ASSERT_TRUE(percentile(after.fast, 99) < SLOW_MS / 2);
+    TEST_ASSERT_TRUE(percentile(after.fast, 99) < percentile(before.fast, 99));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_classification);
+    RUN_TEST(test_queue_out_of_order_and_backpressure);
+    RUN_TEST(test_job_copies_request);
+    RUN_TEST(test_job_answered_when_response_does_not_fit);
+    RUN_TEST(test_load_relay_latency);
+    return UNITY_END();
+}
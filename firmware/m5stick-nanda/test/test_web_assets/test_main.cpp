@@ -0,0 +1,100 @@
+/**
+ * Host tests for the pages scripts/web-assets.py compiles from web/: each
+ * gzipped copy is a gzip member whose trailer (CRC-32 and length) matches
+ * the minified text served to other clients, and each ETag is that text's
+ * FNV-1a. Run scripts/web-assets.py after editing web/ if these fail.
+ *
+ *   pio test -e native -f test_web_assets
+ */
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+#include <WebAssets.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+struct Asset {
+    const char* name;
+    const char* text;
+    size_t textLen;
+    const uint8_t* gzip;
+    size_t gzipLen;
+    const char* etag;
+};
+
+#define ASSET(name, symbol) {name, symbol, sizeof(symbol) - 1, symbol##_GZ, sizeof(symbol##_GZ), symbol##_ETAG}
+
+static const Asset ASSETS[] = {
+    ASSET("index.html", WEB_INDEX_HTML),
+    ASSET("chat.html", WEB_CHAT_HTML)
+};
+
+static uint32_t crc32(const uint8_t* data, size_t len) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1)));
+    }
+    return ~crc;
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+void test_gzip_matches_text(void) {
+    for (const Asset& a : ASSETS) {
+        TEST_ASSERT_TRUE_MESSAGE(a.gzipLen > 18, a.name);
+        // Deflate, no name or comment, no timestamp: the same source gives the same bytes
+        const uint8_t head[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00};
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE(head, a.gzip, sizeof(head), a.name);
+        const uint8_t* trailer = a.gzip + a.gzipLen - 8;
+        TEST_ASSERT_EQUAL_MESSAGE(crc32((const uint8_t*)a.text, a.textLen), le32(trailer), a.name);
+        TEST_ASSERT_EQUAL_MESSAGE(a.textLen, le32(trailer + 4), a.name);
+    }
+}
+
+void test_etag_is_text_hash(void) {
+    for (const Asset& a : ASSETS) {
+        uint32_t h = 2166136261u;
+        for (size_t i = 0; i < a.textLen; i++) h = (h ^ (uint8_t)a.text[i]) * 16777619u;
+        char etag[16];
+        snprintf(etag, sizeof(etag), "W/\"%08x\"", (unsigned)h);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(etag, a.etag, a.name);
+    }
+    TEST_ASSERT_TRUE(strcmp(ASSETS[0].etag, ASSETS[1].etag) != 0);
+}
+
+void test_text_is_minified(void) {
+    for (const Asset& a : ASSETS) {
+        TEST_ASSERT_EQUAL_MESSAGE(a.textLen, strlen(a.text), a.name);
+        TEST_ASSERT_EQUAL_MEMORY_MESSAGE("<!DOCTYPE html><html><head>", a.text, 27, a.name);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE("</script></body></html>", a.text + a.textLen - 23, a.name);
+        // No indentation, no blank lines, no whitespace between tags
+        TEST_ASSERT_NULL_MESSAGE(strstr(a.text, "\n "), a.name);
+        TEST_ASSERT_NULL_MESSAGE(strstr(a.text, "\n\n"), a.name);
+        TEST_ASSERT_NULL_MESSAGE(strstr(a.text, "> <"), a.name);
+        TEST_ASSERT_NULL_MESSAGE(strstr(a.text, "<!--"), a.name);
+    }
+}
+
+void test_report_sizes(void) {
+    for (const Asset& a : ASSETS) {
+        TEST_ASSERT_TRUE_MESSAGE(a.gzipLen < a.textLen / 2 + a.textLen / 4, a.name);
+        printf("  %-10s %5u B minified, %5u B gzipped (%u%%)\n", a.name, (unsigned)a.textLen,
+               (unsigned)a.gzipLen, (unsigned)(a.gzipLen * 100 / a.textLen));
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_gzip_matches_text);
+    RUN_TEST(test_etag_is_text_hash);
+    RUN_TEST(test_text_is_minified);
+    RUN_TEST(test_report_sizes);
+    return UNITY_END();
+}
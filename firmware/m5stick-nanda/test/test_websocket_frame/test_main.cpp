@@ -0,0 +1,209 @@
+/**
+ * Host tests for the server's WebSocket framing: the handshake accept
+ * value, frame headers, and reading a client's masked frames however TCP
+ * splits them.
+ *
+ *   pio test -e native -f test_websocket_frame
+ */
+
+#include <unity.h>
+
+#include <string.h>
+#include <vector>
+
+#include <WebSocketFrame.h>
+
+void setUp(void) {}
+void tearDown(void) {}
+
+static const uint8_t MASK[4] = {0x37, 0xFA, 0x21, 0x3D};
+
+// A client frame: masked, FIN unless fragmented
+static std::vector<uint8_t> clientFrame(uint8_t opcode, const uint8_t* payload, size_t len, bool fin = true,
+                                        uint8_t rsv = 0, bool masked = true) {
+    std::vector<uint8_t> f;
+    f.push_back((fin ? 0x80 : 0) | rsv | opcode);
+    uint8_t maskBit = masked ? 0x80 : 0;
+    if (len < 126) {
+        f.push_back(maskBit | (uint8_t)len);
+    } else if (len <= 0xFFFF) {
+        f.push_back(maskBit | 126);
+        f.push_back(len >> 8);
+        f.push_back(len & 0xFF);
+    } else {
+        f.push_back(maskBit | 127);
+        for (int i = 7; i >= 0; i--) f.push_back((uint8_t)((uint64_t)len >> (8 * i)));
+    }
+    if (masked) f.insert(f.end(), MASK, MASK + 4);
+    for (size_t i = 0; i < len; i++) f.push_back(payload[i] ^ (masked ? MASK[i & 3] : 0));
+    return f;
+}
+
+void test_accept_value(void) {
+    char accept[WEBSOCKET_ACCEPT_SIZE];
+    // RFC 6455, section 1.3
+    TEST_ASSERT_TRUE(webSocketAccept("dGhlIHNhbXBsZSBub25jZQ==", accept));
+    TEST_ASSERT_EQUAL_STRING("s3pPLMBiTxaQ9kYGzzhZRbK+xOo=", accept);
+    TEST_ASSERT_TRUE(webSocketAccept("x3JJHMbDL1EzLkh9GBhXDw==", accept));
+    TEST_ASSERT_EQUAL_STRING("HSmrc0sMlYUkAGmm5OPpG2HaGWk=", accept);
+
+    char longKey[WEBSOCKET_KEY_MAX + 2];
+    memset(longKey, 'k', sizeof(longKey) - 1);
+    longKey[sizeof(longKey) - 1] = '\0';
+    TEST_ASSERT_FALSE(webSocketAccept(longKey, accept));
+    longKey[WEBSOCKET_KEY_MAX] = '\0';
+    TEST_ASSERT_TRUE(webSocketAccept(longKey, accept));   // Two SHA-1 blocks of padding
+    TEST_ASSERT_EQUAL(28, strlen(accept));
+}
+
+void test_base64(void) {
+    char out[16];
+    TEST_ASSERT_EQUAL(0, base64Encode((const uint8_t*)"", 0, out));
+    TEST_ASSERT_EQUAL_STRING("", out);
+    TEST_ASSERT_EQUAL(4, base64Encode((const uint8_t*)"f", 1, out));
+    TEST_ASSERT_EQUAL_STRING("Zg==", out);
+    base64Encode((const uint8_t*)"fo", 2, out);
+    TEST_ASSERT_EQUAL_STRING("Zm8=", out);
+    base64Encode((const uint8_t*)"foo", 3, out);
+    TEST_ASSERT_EQUAL_STRING("Zm9v", out);
+    TEST_ASSERT_EQUAL(8, base64Encode((const uint8_t*)"foobar", 6, out));
+    TEST_ASSERT_EQUAL_STRING("Zm9vYmFy", out);
+    const uint8_t high[] = {0xFB, 0xFF, 0xBF};
+    base64Encode(high, 3, out);
+    TEST_ASSERT_EQUAL_STRING("+/+/", out);
+}
+
+void test_header_sizes(void) {
+    uint8_t h[WEBSOCKET_HEADER_MAX];
+    TEST_ASSERT_EQUAL(2, webSocketHeader(WS_BINARY, 82, h));
+    TEST_ASSERT_EQUAL(0x82, h[0]);
+    TEST_ASSERT_EQUAL(82, h[1]);
+
+    TEST_ASSERT_EQUAL(2, webSocketHeader(WS_PONG, 125, h));
+    TEST_ASSERT_EQUAL(0x8A, h[0]);
+    TEST_ASSERT_EQUAL(125, h[1]);
+
+    TEST_ASSERT_EQUAL(4, webSocketHeader(WS_BINARY, 126, h));
+    TEST_ASSERT_EQUAL(126, h[1]);
+    TEST_ASSERT_EQUAL(0, h[2]);
+    TEST_ASSERT_EQUAL(126, h[3]);
+    TEST_ASSERT_EQUAL(4, webSocketHeader(WS_BINARY, 0xFFFF, h));
+    TEST_ASSERT_EQUAL(0xFF, h[2]);
+    TEST_ASSERT_EQUAL(0xFF, h[3]);
+
+    TEST_ASSERT_EQUAL(10, webSocketHeader(WS_BINARY, 0x10000, h));
+    TEST_ASSERT_EQUAL(127, h[1]);
+    const uint8_t big[8] = {0, 0, 0, 0, 0, 1, 0, 0};
+    TEST_ASSERT_EQUAL_MEMORY(big, h + 2, 8);
+}
+
+// A data frame, then a ping, then a close, split at every byte
+void test_frames_split_anywhere(void) {
+    uint8_t data[300];
+    for (size_t i = 0; i < sizeof(data); i++) data[i] = (uint8_t)i;
+    const uint8_t ping[] = "are you there";
+    const uint8_t close[] = {0x03, 0xE8, 'b', 'y', 'e'};
+    std::vector<uint8_t> stream = clientFrame(WS_BINARY, data, sizeof(data));
+    std::vector<uint8_t> p = clientFrame(WS_PING, ping, sizeof(ping) - 1);
+    std::vector<uint8_t> c = clientFrame(WS_CLOSE, close, sizeof(close));
+    stream.insert(stream.end(), p.begin(), p.end());
+    stream.insert(stream.end(), c.begin(), c.end());
+
+    for (size_t cut = 0; cut <= stream.size(); cut++) {
+        WebSocketReader reader;
+        size_t pieces[2] = {cut, stream.size() - cut};
+        size_t at = 0;
+        int controls = 0;
+        for (size_t piece : pieces) {
+            size_t end = at + piece;
+            while (at < end) {
+                size_t used;
+                WebSocketReader::Result r = reader.feed(stream.data() + at, end - at, used);
+                TEST_ASSERT_TRUE(r != WebSocketReader::ERROR);
+                at += used;
+                if (r != WebSocketReader::CONTROL) continue;
+                if (controls++ == 0) {
+                    TEST_ASSERT_EQUAL(WS_PING, reader.opcode());
+                    TEST_ASSERT_EQUAL(sizeof(ping) - 1, reader.length());
+                    TEST_ASSERT_EQUAL_MEMORY(ping, reader.payload(), reader.length());
+                } else {
+                    TEST_ASSERT_EQUAL(WS_CLOSE, reader.opcode());
+                    TEST_ASSERT_EQUAL_MEMORY(close, reader.payload(), sizeof(close));
+                }
+            }
+        }
+        TEST_ASSERT_EQUAL(2, controls);
+        TEST_ASSERT_EQUAL(stream.size(), at);
+    }
+}
+
+// Data frames of every length form are read past, one byte at a time
+void test_data_frames_skipped(void) {
+    static uint8_t payload[70000];
+    const size_t lengths[] = {0, 1, 125, 126, 0xFFFF, 0x10000, sizeof(payload)};
+    for (size_t len : lengths) {
+        std::vector<uint8_t> stream = clientFrame(WS_TEXT, payload, len, false);
+        std::vector<uint8_t> more = clientFrame(WS_CONTINUATION, payload, 3);
+        std::vector<uint8_t> ping = clientFrame(WS_PING, nullptr, 0);
+        stream.insert(stream.end(), more.begin(), more.end());
+        stream.insert(stream.end(), ping.begin(), ping.end());
+
+        WebSocketReader reader;
+        size_t at = 0;
+        WebSocketReader::Result r = WebSocketReader::NEED_MORE;
+        while (at < stream.size() && r == WebSocketReader::NEED_MORE) {
+            size_t used;
+            r = reader.feed(stream.data() + at, len < 1000 ? 1 : stream.size() - at, used);
+            at += used;
+        }
+        TEST_ASSERT_EQUAL(WebSocketReader::CONTROL, r);
+        TEST_ASSERT_EQUAL(WS_PING, reader.opcode());
+        TEST_ASSERT_EQUAL(0, reader.length());
+        TEST_ASSERT_EQUAL(stream.size(), at);
+    }
+}
+
+static WebSocketReader::Result readAll(const std::vector<uint8_t>& stream) {
+    WebSocketReader reader;
+    size_t used;
+    return reader.feed(stream.data(), stream.size(), used);
+}
+
+void test_invalid_frames(void) {
+    const uint8_t payload[126] = {0};
+    // Unmasked, an extension bit, reserved opcodes
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(WS_BINARY, payload, 4, true, 0, false)));
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(WS_BINARY, payload, 4, true, 0x40)));
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(0x3, payload, 4)));
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(0xB, payload, 4)));
+    // Control frames are never fragmented and carry at most 125 bytes
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(WS_PING, payload, 4, false)));
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, readAll(clientFrame(WS_CLOSE, payload, 126)));
+    TEST_ASSERT_EQUAL(WebSocketReader::CONTROL, readAll(clientFrame(WS_PING, payload, 125)));
+
+    // The frame before the bad one still comes out, and nothing after
+    std::vector<uint8_t> stream = clientFrame(WS_PING, payload, 2);
+    std::vector<uint8_t> bad = clientFrame(WS_BINARY, payload, 2, true, 0, false);
+    stream.insert(stream.end(), bad.begin(), bad.end());
+    WebSocketReader reader;
+    size_t used;
+    TEST_ASSERT_EQUAL(WebSocketReader::CONTROL, reader.feed(stream.data(), stream.size(), used));
+    TEST_ASSERT_EQUAL(8, used);
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, reader.feed(stream.data() + used, stream.size() - used, used));
+    TEST_ASSERT_EQUAL(WebSocketReader::ERROR, reader.feed(stream.data(), stream.size(), used));
+    TEST_ASSERT_EQUAL(0, used);
+
+    reader.reset();
+    TEST_ASSERT_EQUAL(WebSocketReader::CONTROL, reader.feed(stream.data(), stream.size(), used));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_accept_value);
+    RUN_TEST(test_base64);
+    RUN_TEST(test_header_sizes);
+    RUN_TEST(test_frames_split_anywhere);
+    RUN_TEST(test_data_frames_skipped);
+    RUN_TEST(test_invalid_frames);
+    return UNITY_END();
+}